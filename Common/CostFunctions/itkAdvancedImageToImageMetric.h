@@ -21,6 +21,7 @@
 #include "itkImageToImageMetric.h"
 
 #include "itkImageSamplerBase.h"
+#include "itkImageSampleSoAContainer.h"
 #include "itkGradientImageFilter.h"
 #include "itkBSplineInterpolateImageFunction.h"
 #include "itkReducedDimensionBSplineInterpolateImageFunction.h"
@@ -37,6 +38,11 @@
 #include "itkAdvancedCombinationTransform.h"
 
 #include "itkPlatformMultiThreader.h"
+#include "itkWorkStealingThreadPool.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <memory>
+#include <mutex>
 
 namespace itk
 {
@@ -140,6 +146,11 @@ public:
   typedef typename ImageSamplerType::Pointer                      ImageSamplerPointer;
   typedef typename ImageSamplerType::OutputVectorContainerType    ImageSampleContainerType;
   typedef typename ImageSamplerType::OutputVectorContainerPointer ImageSampleContainerPointer;
+  typedef ImageSampleSoAContainer<FixedImageType>                 ImageSampleSoAContainerType;
+  typedef typename ImageSampleSoAContainerType::Pointer           ImageSampleSoAContainerPointer;
+
+  /** Typedef for the random number generator. */
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
 
   /** Typedefs for Limiter support. */
   typedef LimiterFunctionBase<RealType, FixedImageDimension>  FixedImageLimiterType;
@@ -213,6 +224,12 @@ public:
   itkSetMacro(RequiredRatioOfValidSamples, double);
   itkGetConstMacro(RequiredRatioOfValidSamples, double);
 
+  /** Set/Get the random number generator of the metrics that draw random numbers.
+   * Default: the global instance.
+   */
+  itkSetObjectMacro(RandomGenerator, RandomGeneratorType);
+  itkGetModifiableObjectMacro(RandomGenerator, RandomGeneratorType);
+
   /** Set/Get the Moving/Fixed limiter. Its thresholds and bounds are set by the metric.
    * Setting a limiter is only mandatory if GetUse{Fixed,Moving}Limiter() returns true. */
   itkSetObjectMacro(MovingImageLimiter, MovingImageLimiterType);
@@ -284,6 +301,25 @@ public:
   itkGetConstReferenceMacro(UseMultiThread, bool);
   itkBooleanMacro(UseMultiThread);
 
+  /** Select the persistent work-stealing thread pool, instead of the PlatformMultiThreader,
+   * for the multi-threaded GetValue() and GetValueAndDerivative(). The samples are then
+   * scheduled dynamically in chunks, and the derivatives of the threads are summed in the
+   * same launch. Only used by metrics that implement the Threaded*Range() functions.
+   */
+  itkSetMacro(UseThreadPool, bool);
+  itkGetConstReferenceMacro(UseThreadPool, bool);
+  itkBooleanMacro(UseThreadPool);
+
+  /** Set a mutex that guards the update of the image sampler in
+   * BeforeThreadedGetValueAndDerivative(). Metrics that share their image sampler,
+   * and that are evaluated concurrently, should share this mutex as well.
+   */
+  void
+  SetImageSamplerMutex(const std::shared_ptr<std::mutex> & imageSamplerMutex)
+  {
+    this->m_ImageSamplerMutex = imageSamplerMutex;
+  }
+
   /** Contains calls from GetValueAndDerivative that are thread-unsafe,
    * together with preparation for multi-threading.
    * Note that the only reason why this function is not protected, is
@@ -410,10 +446,54 @@ protected:
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   AccumulateDerivativesThreaderCallback(void * arg);
 
+  /** Multi-threaded version of GetValue() for the samples [begin, end),
+   * as used by the thread pool. Adds to the per-thread variables with index threadID,
+   * which the thread pool sets to the index of the chunk of samples.
+   */
+  virtual inline void
+  ThreadedGetValueRange(ThreadIdType  itkNotUsed(threadID),
+                        unsigned long itkNotUsed(begin),
+                        unsigned long itkNotUsed(end))
+  {}
+
+  /** Multi-threaded version of GetValueAndDerivative() for the samples [begin, end),
+   * as used by the thread pool. Adds to the per-thread variables with index threadID,
+   * which the thread pool sets to the index of the chunk of samples.
+   */
+  virtual inline void
+  ThreadedGetValueAndDerivativeRange(ThreadIdType  itkNotUsed(threadID),
+                                     unsigned long itkNotUsed(begin),
+                                     unsigned long itkNotUsed(end))
+  {}
+
+  /** Launch GetValue on the thread pool, calling ThreadedGetValueRange() for chunks of samples.
+   * Each chunk adds to its own per-thread variables, which are summed in the order of the chunks
+   * into those of the first thread, so that the value does not depend on the scheduling.
+   */
+  void
+  LaunchGetValueThreadPool(void) const;
+
+  /** Launch GetValueAndDerivative on the thread pool, calling ThreadedGetValueAndDerivativeRange()
+   * for chunks of samples. In the same launch, the derivatives of all chunks are summed in the order
+   * of the chunks into derivative, without normalization, and reset for the next iteration.
+   */
+  void
+  LaunchGetValueAndDerivativeThreadPool(DerivativeType & derivative) const;
+
   /** Variables for multi-threading. */
   bool m_UseMetricSingleThreaded;
   bool m_UseMultiThread;
   bool m_UseOpenMP;
+  bool m_UseThreadPool{ false };
+
+  /** The thread pool, created on first use and kept for the lifetime of the metric. */
+  mutable WorkStealingThreadPool::Pointer m_ThreadPool;
+
+  /** The mutex that guards the update of a shared image sampler, see SetImageSamplerMutex(). */
+  std::shared_ptr<std::mutex> m_ImageSamplerMutex;
+
+  /** The random number generator, see SetRandomGenerator(). */
+  RandomGeneratorType::Pointer m_RandomGenerator;
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -448,12 +528,45 @@ protected:
   mutable AlignedGetValuePerThreadStruct * m_GetValuePerThreadVariables;
   mutable ThreadIdType                     m_GetValuePerThreadVariablesSize;
 
+  /** Buffers for the batched evaluation of a block of samples, see EvaluateSampleBlock().
+   * Each thread owns one, which is reused in every iteration. After EvaluateSampleBlock()
+   * the first m_NumberOfValidSamples entries contain the valid samples of the block.
+   * The image Jacobian and the nonzero Jacobian indices of valid sample i start at
+   * i * GetNumberOfNonZeroJacobianIndices().
+   * m_FixedSamples holds the fixed image samples of the block as a structure of arrays.
+   */
+  typedef typename AdvancedTransformType::MovingImageGradientType  TransformMovingImageGradientType;
+  typedef typename AdvancedTransformType::NonZeroJacobianIndexType NonZeroJacobianIndexType;
+  struct SampleBlockType
+  {
+    ImageSampleSoAContainerPointer                m_FixedSamples;
+    std::vector<FixedImagePointType>              m_FixedPoints;
+    std::vector<MovingImagePointType>             m_MappedPoints;
+    std::vector<RealType>                         m_FixedImageValues;
+    std::vector<RealType>                         m_MovingImageValues;
+    std::vector<MovingImageDerivativeType>        m_MovingImageDerivatives;
+    std::vector<TransformMovingImageGradientType> m_TransformMovingImageGradients;
+    std::vector<DerivativeValueType>              m_ImageJacobians;
+    std::vector<NonZeroJacobianIndexType>         m_NonZeroJacobianIndices;
+    unsigned long                                 m_NumberOfValidSamples;
+  };
+
+  /** The maximum number of samples in a SampleBlockType. */
+  itkStaticConstMacro(SampleBlockSize, unsigned int, 64);
+
+  /** The maximum number of chunks of samples per thread of the thread pool. Each chunk
+   * has its own per-thread variables, including a derivative, so that the sums do not
+   * depend on which thread takes which chunk.
+   */
+  itkStaticConstMacro(ChunksPerWorkUnit, unsigned int, 4);
+
   // test per thread struct with padding and alignment
   struct GetValueAndDerivativePerThreadStruct
   {
-    SizeValueType  st_NumberOfPixelsCounted;
-    MeasureType    st_Value;
-    DerivativeType st_Derivative;
+    SizeValueType   st_NumberOfPixelsCounted;
+    MeasureType     st_Value;
+    DerivativeType  st_Derivative;
+    SampleBlockType st_SampleBlock;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                GetValueAndDerivativePerThreadStruct,
@@ -468,6 +581,19 @@ protected:
   virtual void
   InitializeThreadingParameters(void) const;
 
+  /** Reset the values and the numbers of pixels of all threads. Called before each
+   * threaded pass, because the threads add to them, and a previous pass that threw an
+   * exception in CheckNumberOfSamples() leaves them unreset.
+   */
+  void
+  ResetPerThreadValues(void) const;
+
+  /** Add the values and the numbers of pixels of the chunks of the thread pool, in the order
+   * of the chunks, to those of the first chunk, and reset them.
+   */
+  void
+  AccumulateChunkValues(const unsigned long numberOfChunks) const;
+
   /** Protected methods ************** */
 
   /** Methods for image sampler support **********/
@@ -545,6 +671,28 @@ protected:
                             TransformJacobianType &      jacobian,
                             NonZeroJacobianIndicesType & nzji) const;
 
+  /** Batched evaluation of the samples [begin, end) of the sample container, with at most
+   * SampleBlockSize samples. The samples are copied to the aligned coordinate arrays of
+   * the block, and the fixed points are mapped with a single call to
+   * AdvancedTransform::TransformCoordinateArrays(), after which the moving mask and
+   * the moving image value and derivative are evaluated. The valid samples are compacted to
+   * the front of the block.
+   * Limiters that modify the moving image derivative can be applied after this function, on
+   * block.m_MovingImageDerivatives, before calling EvaluateSampleBlockImageJacobians().
+   */
+  virtual void
+  EvaluateSampleBlock(const ImageSampleContainerType & sampleContainer,
+                      unsigned long                    begin,
+                      unsigned long                    end,
+                      SampleBlockType &                block) const;
+
+  /** Compute the inner products of the transform Jacobian and the moving image derivative
+   * for all valid samples of the block, with a single call to
+   * AdvancedTransform::EvaluateJacobianWithImageGradientProducts().
+   */
+  virtual void
+  EvaluateSampleBlockImageJacobians(SampleBlockType & block) const;
+
   /** Convenience method: check if point is inside the moving mask. *****************/
   virtual bool
   IsInsideMovingMask(const MovingImagePointType & point) const;
@@ -29,6 +29,8 @@
 
 #include "itkTimeProbe.h"
 
+#include <algorithm> // std::min, std::max
+
 namespace itk
 {
 
@@ -50,6 +52,7 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AdvancedImageToImageMetri
   this->m_ImageSampler = nullptr;
   this->m_UseImageSampler = false;
   this->m_RequiredRatioOfValidSamples = 0.25;
+  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
 
   this->m_LinearInterpolator = nullptr;
   this->m_BSplineInterpolator = nullptr;
@@ -203,12 +206,16 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeThreadingParame
     this->m_GetValuePerThreadVariablesSize = numberOfThreads;
   }
 
-  /** Only resize the array of structs when needed. */
-  if (this->m_GetValueAndDerivativePerThreadVariablesSize != numberOfThreads)
+  /** Only resize the array of structs when needed. The thread pool uses the structs
+   * for its chunks of samples, of which there are at most ChunksPerWorkUnit per thread.
+   */
+  const ThreadIdType numberOfSlots =
+    this->m_UseThreadPool ? Self::ChunksPerWorkUnit * numberOfThreads : numberOfThreads;
+  if (this->m_GetValueAndDerivativePerThreadVariablesSize != numberOfSlots)
   {
     delete[] this->m_GetValueAndDerivativePerThreadVariables;
-    this->m_GetValueAndDerivativePerThreadVariables = new AlignedGetValueAndDerivativePerThreadStruct[numberOfThreads];
-    this->m_GetValueAndDerivativePerThreadVariablesSize = numberOfThreads;
+    this->m_GetValueAndDerivativePerThreadVariables = new AlignedGetValueAndDerivativePerThreadStruct[numberOfSlots];
+    this->m_GetValueAndDerivativePerThreadVariablesSize = numberOfSlots;
   }
 
   /** Some initialization. */
@@ -216,7 +223,9 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeThreadingParame
   {
     this->m_GetValuePerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
     this->m_GetValuePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
-
+  }
+  for (ThreadIdType i = 0; i < numberOfSlots; ++i)
+  {
     this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
@@ -227,6 +236,46 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeThreadingParame
 } // end InitializeThreadingParameters()
 
 
+/**
+ * ********************* ResetPerThreadValues ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::ResetPerThreadValues(void) const
+{
+  for (ThreadIdType i = 0; i < this->m_GetValueAndDerivativePerThreadVariablesSize; ++i)
+  {
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+
+} // end ResetPerThreadValues()
+
+
+/**
+ * ********************* AccumulateChunkValues ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateChunkValues(const unsigned long numberOfChunks) const
+{
+  for (unsigned long i = 1; i < numberOfChunks; ++i)
+  {
+    this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted +=
+      this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
+    this->m_GetValueAndDerivativePerThreadVariables[0].st_Value +=
+      this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+
+    /** Reset these variables for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+
+} // end AccumulateChunkValues()
+
+
 /**
  * ****************** InitializeLimiters *****************************
  */
@@ -768,6 +817,113 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateTransformJacobian
 } // end EvaluateTransformJacobian()
 
 
+/**
+ * *************** EvaluateSampleBlock ****************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateSampleBlock(
+  const ImageSampleContainerType & sampleContainer,
+  unsigned long                    begin,
+  unsigned long                    end,
+  SampleBlockType &                block) const
+{
+  /** Allocate the buffers; this only happens in the first iteration. */
+  const unsigned long blockSize = Self::SampleBlockSize;
+  const unsigned long nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  if (block.m_FixedSamples.IsNull())
+  {
+    block.m_FixedSamples = ImageSampleSoAContainerType::New();
+  }
+  block.m_FixedSamples->Reserve(blockSize);
+  block.m_FixedPoints.resize(blockSize);
+  block.m_MappedPoints.resize(blockSize);
+  block.m_FixedImageValues.resize(blockSize);
+  block.m_MovingImageValues.resize(blockSize);
+  block.m_MovingImageDerivatives.resize(blockSize);
+  block.m_TransformMovingImageGradients.resize(blockSize);
+  block.m_ImageJacobians.resize(blockSize * nnzji);
+  block.m_NonZeroJacobianIndices.resize(blockSize * nnzji);
+
+  /** Copy the fixed image samples to the coordinate arrays of the block, and map them all
+   * at once. The transform reads the contiguous coordinate arrays, and the fixed points are
+   * only gathered for the valid samples.
+   */
+  const unsigned long numberOfSamples = end - begin;
+  block.m_FixedSamples->Resize(numberOfSamples);
+  for (unsigned long i = 0; i < numberOfSamples; ++i)
+  {
+    const typename ImageSampleContainerType::Element & sample = sampleContainer.ElementAt(begin + i);
+    block.m_FixedSamples->SetSample(i, sample);
+    block.m_FixedImageValues[i] = static_cast<RealType>(sample.m_ImageValue);
+  }
+  const double * coordinates[FixedImageDimension];
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    coordinates[d] = block.m_FixedSamples->GetCoordinates(d);
+  }
+  this->m_AdvancedTransform->TransformCoordinateArrays(coordinates, block.m_MappedPoints.data(), numberOfSamples);
+
+  /** Evaluate the moving image and compact the valid samples. */
+  unsigned long numberOfValidSamples = 0;
+  for (unsigned long i = 0; i < numberOfSamples; ++i)
+  {
+    const MovingImagePointType mappedPoint = block.m_MappedPoints[i];
+    RealType                   movingImageValue;
+    MovingImageDerivativeType  movingImageDerivative;
+
+    /** Check if point is inside mask. */
+    bool sampleOk = this->IsInsideMovingMask(mappedPoint);
+
+    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
+     * the point is inside the moving image buffer.
+     */
+    if (sampleOk)
+    {
+      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+    }
+
+    if (sampleOk)
+    {
+      block.m_FixedPoints[numberOfValidSamples] = block.m_FixedSamples->GetPoint(i);
+      block.m_MappedPoints[numberOfValidSamples] = mappedPoint;
+      block.m_FixedImageValues[numberOfValidSamples] = block.m_FixedImageValues[i];
+      block.m_MovingImageValues[numberOfValidSamples] = movingImageValue;
+      block.m_MovingImageDerivatives[numberOfValidSamples] = movingImageDerivative;
+      ++numberOfValidSamples;
+    }
+  }
+  block.m_NumberOfValidSamples = numberOfValidSamples;
+
+} // end EvaluateSampleBlock()
+
+
+/**
+ * *************** EvaluateSampleBlockImageJacobians ****************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateSampleBlockImageJacobians(SampleBlockType & block) const
+{
+  for (unsigned long i = 0; i < block.m_NumberOfValidSamples; ++i)
+  {
+    for (unsigned int d = 0; d < MovingImageDimension; ++d)
+    {
+      block.m_TransformMovingImageGradients[i][d] = block.m_MovingImageDerivatives[i][d];
+    }
+  }
+
+  this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProducts(block.m_FixedPoints.data(),
+                                                                       block.m_TransformMovingImageGradients.data(),
+                                                                       block.m_NumberOfValidSamples,
+                                                                       block.m_ImageJacobians.data(),
+                                                                       block.m_NonZeroJacobianIndices.data());
+
+} // end EvaluateSampleBlockImageJacobians()
+
+
 /**
  * ************************** IsInsideMovingMask *************************
  */
@@ -827,7 +983,15 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::BeforeThreadedGetValueAnd
     this->SetTransformParameters(parameters);
     if (this->m_UseImageSampler)
     {
-      this->GetImageSampler()->Update();
+      if (this->m_ImageSamplerMutex)
+      {
+        const std::lock_guard<std::mutex> lock(*this->m_ImageSamplerMutex);
+        this->GetImageSampler()->Update();
+      }
+      else
+      {
+        this->GetImageSampler()->Update();
+      }
     }
   }
 
@@ -862,6 +1026,8 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchGetValueThreaderCallback(void) const
 {
+  this->ResetPerThreadValues();
+
   /** Setup threader. */
   this->m_Threader->SetSingleMethod(this->GetValueThreaderCallback,
                                     const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
@@ -900,6 +1066,8 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchGetValueAndDerivativeThreaderCallback(void) const
 {
+  this->ResetPerThreadValues();
+
   /** Setup threader. */
   this->m_Threader->SetSingleMethod(this->GetValueAndDerivativeThreaderCallback,
                                     const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
@@ -954,6 +1122,149 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateDerivativesThre
 } // end AccumulateDerivativesThreaderCallback()
 
 
+/**
+ * *********************** LaunchGetValueThreadPool ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchGetValueThreadPool(void) const
+{
+  /** Create the pool on first use; its threads are kept for the next calls. */
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  if (this->m_ThreadPool.IsNull())
+  {
+    this->m_ThreadPool = WorkStealingThreadPool::New();
+  }
+  this->m_ThreadPool->SetNumberOfWorkers(numberOfThreads);
+  this->ResetPerThreadValues();
+
+  /** Divide the samples in chunks of at least SampleBlockSize samples,
+   * several per thread, such that there is something to steal.
+   */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const unsigned long maximumNumberOfChunks = Self::ChunksPerWorkUnit * numberOfThreads;
+  const unsigned long chunkSize = std::max<unsigned long>(
+    Self::SampleBlockSize, (sampleContainerSize + maximumNumberOfChunks - 1) / maximumNumberOfChunks);
+  const unsigned long numberOfChunks = (sampleContainerSize + chunkSize - 1) / chunkSize;
+
+  /** Allocate the per-thread variables of the chunks, if the thread pool was switched on after Initialize(). */
+  if (this->m_GetValueAndDerivativePerThreadVariablesSize < maximumNumberOfChunks)
+  {
+    this->InitializeThreadingParameters();
+  }
+
+  WorkStealingThreadPool::ChunkQueue sampleChunks;
+  sampleChunks.Initialize(numberOfChunks, numberOfThreads);
+
+  /** Each chunk adds to its own per-thread variables. */
+  Self * self = const_cast<Self *>(this);
+  const WorkStealingThreadPool::JobType job = [self, &sampleChunks, chunkSize, sampleContainerSize](
+                                                ThreadIdType threadId) {
+    SizeValueType chunk = 0;
+    while (sampleChunks.Pop(threadId, chunk))
+    {
+      const unsigned long begin = chunk * chunkSize;
+      self->ThreadedGetValueRange(chunk, begin, std::min(begin + chunkSize, sampleContainerSize));
+    }
+  };
+  this->m_ThreadPool->Execute(job);
+
+  /** Sum the values of the chunks in their order, into those of the first thread. */
+  this->AccumulateChunkValues(numberOfChunks);
+
+} // end LaunchGetValueThreadPool()
+
+
+/**
+ * *********************** LaunchGetValueAndDerivativeThreadPool ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchGetValueAndDerivativeThreadPool(
+  DerivativeType & derivative) const
+{
+  /** Create the pool on first use; its threads are kept for the next calls. */
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  if (this->m_ThreadPool.IsNull())
+  {
+    this->m_ThreadPool = WorkStealingThreadPool::New();
+  }
+  this->m_ThreadPool->SetNumberOfWorkers(numberOfThreads);
+  this->ResetPerThreadValues();
+
+  /** Divide the samples in chunks of at least SampleBlockSize samples,
+   * several per thread, such that there is something to steal.
+   */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const unsigned long maximumNumberOfChunks = Self::ChunksPerWorkUnit * numberOfThreads;
+  const unsigned long chunkSize = std::max<unsigned long>(
+    Self::SampleBlockSize, (sampleContainerSize + maximumNumberOfChunks - 1) / maximumNumberOfChunks);
+  const unsigned long numberOfChunks = (sampleContainerSize + chunkSize - 1) / chunkSize;
+
+  /** Allocate the per-thread variables of the chunks, if the thread pool was switched on after Initialize(). */
+  if (this->m_GetValueAndDerivativePerThreadVariablesSize < maximumNumberOfChunks)
+  {
+    this->InitializeThreadingParameters();
+  }
+
+  /** Divide the parameters in slices for the summation of the derivatives. */
+  const unsigned long numberOfParameters = this->GetNumberOfParameters();
+  const unsigned long numberOfSlices = std::min<unsigned long>(4 * numberOfThreads, numberOfParameters);
+  const unsigned long sliceSize = numberOfSlices > 0 ? (numberOfParameters + numberOfSlices - 1) / numberOfSlices : 0;
+
+  WorkStealingThreadPool::ChunkQueue sampleChunks;
+  WorkStealingThreadPool::ChunkQueue parameterSlices;
+  sampleChunks.Initialize(numberOfChunks, numberOfThreads);
+  parameterSlices.Initialize(numberOfSlices, numberOfThreads);
+
+  Self *                                self = const_cast<Self *>(this);
+  WorkStealingThreadPool *              pool = this->m_ThreadPool.GetPointer();
+  DerivativeValueType *                 derivativePointer = derivative.data_block();
+  const WorkStealingThreadPool::JobType job = [=, &sampleChunks, &parameterSlices](ThreadIdType threadId) {
+    /** Phase 1: compute the value and derivative terms of chunks of samples.
+     * Each chunk adds to its own per-thread variables.
+     */
+    SizeValueType chunk = 0;
+    while (sampleChunks.Pop(threadId, chunk))
+    {
+      const unsigned long begin = chunk * chunkSize;
+      self->ThreadedGetValueAndDerivativeRange(chunk, begin, std::min(begin + chunkSize, sampleContainerSize));
+    }
+
+    /** Wait until the derivatives of all chunks are complete. */
+    pool->Barrier();
+
+    /** Phase 2: sum the derivatives of all chunks in their order, for slices of the
+     * parameters, and reset them for the next iteration.
+     */
+    const DerivativeValueType zero = NumericTraits<DerivativeValueType>::Zero;
+    while (parameterSlices.Pop(threadId, chunk))
+    {
+      const unsigned long jmin = chunk * sliceSize;
+      const unsigned long jmax = std::min(jmin + sliceSize, numberOfParameters);
+      for (unsigned long j = jmin; j < jmax; ++j)
+      {
+        DerivativeValueType tmp = zero;
+        for (unsigned long i = 0; i < numberOfChunks; ++i)
+        {
+          DerivativeValueType & chunkDerivative = self->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative[j];
+          tmp += chunkDerivative;
+          chunkDerivative = zero;
+        }
+        derivativePointer[j] = tmp;
+      }
+    }
+  };
+  this->m_ThreadPool->Execute(job);
+
+  /** Sum the values of the chunks in their order, into those of the first thread. */
+  this->AccumulateChunkValues(numberOfChunks);
+
+} // end LaunchGetValueAndDerivativeThreadPool()
+
+
 /**
  * *********************** CheckNumberOfSamples ***********************
  */
@@ -0,0 +1,315 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBlockLanczosEigenSolver_h
+#define itkBlockLanczosEigenSolver_h
+
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_vector.h"
+#include "vnl/algo/vnl_symmetric_eigensystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+/** \class BlockLanczosEigenSolver
+ *
+ * \brief Computes the largest eigenvalues and eigenvectors of a symmetric matrix,
+ * warm-started with the eigenvectors of the previous call.
+ *
+ * Metrics like the PCAMetric need the few largest eigenpairs of a small symmetric matrix
+ * that changes only slightly between successive iterations of the optimizer. This class
+ * caches the eigenvectors of the previous call, and uses them as the start of a restarted
+ * block Lanczos iteration: each iteration builds an orthonormal basis of the block Krylov
+ * subspace [ V, K V, ..., K^(b-1) V ], with b the number of blocks, and restarts with the
+ * Ritz vectors of the Rayleigh-Ritz projection on that subspace. In contrast to plain
+ * subspace iteration, this also converges quickly when the eigenvalues following the wanted
+ * ones are clustered, as is typical for the correlation matrices of the PCA metrics. In the
+ * common case one or two iterations suffice, which costs O(n^2 m) instead of the O(n^3)
+ * of a full decomposition.
+ *
+ * The blocks have m + oversampling vectors, so that eigenvalues that cross the m-th
+ * eigenvalue between calls are still picked up. The iteration is accepted when
+ * the residual norms || K v - lambda v || of the m wanted Ritz pairs are below the
+ * tolerance, relative to the largest eigenvalue. Otherwise, and on the first call, the
+ * full vnl_symmetric_eigensystem is used, and its eigenvectors are cached for the next call.
+ *
+ * The eigenvalues are sorted in descending order. The sign of the eigenvectors is arbitrary.
+ *
+ * \ingroup Metrics
+ */
+
+template <class TReal>
+class BlockLanczosEigenSolver
+{
+public:
+  typedef TReal             RealType;
+  typedef vnl_vector<TReal> VectorType;
+  typedef vnl_matrix<TReal> MatrixType;
+
+  /** The maximum number of iterations before falling back to the full decomposition. */
+  void
+  SetMaximumNumberOfIterations(unsigned int maximumNumberOfIterations)
+  {
+    this->m_MaximumNumberOfIterations = maximumNumberOfIterations;
+  }
+
+
+  unsigned int
+  GetMaximumNumberOfIterations(void) const
+  {
+    return this->m_MaximumNumberOfIterations;
+  }
+
+
+  /** The relative tolerance on the residual norms of the wanted eigenpairs. */
+  void
+  SetTolerance(RealType tolerance)
+  {
+    this->m_Tolerance = tolerance;
+  }
+
+
+  RealType
+  GetTolerance(void) const
+  {
+    return this->m_Tolerance;
+  }
+
+
+  /** The number of extra vectors in each block. */
+  void
+  SetOversampling(unsigned int oversampling)
+  {
+    this->m_Oversampling = oversampling;
+  }
+
+
+  unsigned int
+  GetOversampling(void) const
+  {
+    return this->m_Oversampling;
+  }
+
+
+  /** The number of blocks of the Krylov subspace of each iteration. */
+  void
+  SetNumberOfBlocks(unsigned int numberOfBlocks)
+  {
+    this->m_NumberOfBlocks = std::max(numberOfBlocks, 1u);
+  }
+
+
+  unsigned int
+  GetNumberOfBlocks(void) const
+  {
+    return this->m_NumberOfBlocks;
+  }
+
+
+  /** Forget the cached eigenvectors, so that the next call does a full decomposition. */
+  void
+  Reset(void)
+  {
+    this->m_Basis.set_size(0, 0);
+  }
+
+
+  /** Compute the numberOfEigenValues largest eigenpairs of the symmetric matrix K.
+   * Returns true if the warm-started iteration converged, and false if the
+   * full decomposition was used.
+   */
+  bool
+  Compute(const MatrixType & K, unsigned int numberOfEigenValues)
+  {
+    const unsigned int n = K.rows();
+    const unsigned int m = std::min(numberOfEigenValues, n);
+    const unsigned int blockSize = std::min(m + this->m_Oversampling, n);
+    this->m_NumberOfIterations = 0;
+
+    if (blockSize == n || this->m_Basis.rows() != n || this->m_Basis.cols() != blockSize)
+    {
+      this->ComputeFull(K, m, blockSize);
+      return false;
+    }
+
+    const unsigned int krylovDimension = std::min(blockSize * this->m_NumberOfBlocks, n);
+    MatrixType         V(this->m_Basis);
+    while (this->m_NumberOfIterations < this->m_MaximumNumberOfIterations)
+    {
+      ++this->m_NumberOfIterations;
+
+      /** Orthonormal basis Q of the block Krylov subspace [ V, K V, K^2 V, ... ].
+       * Directions that are already in the subspace, for example because an eigenvector
+       * has converged, are dropped, so the final dimension may be smaller.
+       */
+      MatrixType   Q(n, krylovDimension);
+      unsigned int dimension = 0;
+      unsigned int blockBegin = 0;
+      MatrixType   candidates(V);
+      while (true)
+      {
+        for (unsigned int j = 0; j < candidates.cols() && dimension < krylovDimension; ++j)
+        {
+          if (AppendOrthonormalized(Q, dimension, candidates.get_column(j)))
+          {
+            ++dimension;
+          }
+        }
+        if (dimension == blockBegin || dimension == krylovDimension)
+        {
+          break;
+        }
+        candidates = K * Q.extract(n, dimension - blockBegin, 0, blockBegin);
+        blockBegin = dimension;
+      }
+      if (dimension < blockSize)
+      {
+        break;
+      }
+      Q = Q.extract(n, dimension);
+
+      /** Rayleigh-Ritz projection of K on the subspace spanned by Q. */
+      MatrixType       KQ(K * Q);
+      MatrixType       H(Q.transpose() * KQ);
+      const MatrixType Ht(H.transpose());
+      H += Ht;
+      H *= 0.5;
+      const vnl_symmetric_eigensystem<RealType> projected(H);
+
+      /** Keep the blockSize largest Ritz pairs, in descending order. */
+      MatrixType Y(dimension, blockSize);
+      VectorType ritzValues(blockSize);
+      for (unsigned int i = 0; i < blockSize; ++i)
+      {
+        ritzValues[i] = projected.get_eigenvalue(dimension - 1 - i);
+        Y.set_column(i, projected.get_eigenvector(dimension - 1 - i));
+      }
+      V = Q * Y;
+      const MatrixType KV(KQ * Y);
+
+      /** Check the residuals of the wanted Ritz pairs. */
+      const RealType scale = std::max(std::abs(ritzValues[0]), RealType(1e-30));
+      RealType       maxResidual = 0.0;
+      for (unsigned int i = 0; i < m; ++i)
+      {
+        const RealType residual = (KV.get_column(i) - V.get_column(i) * ritzValues[i]).two_norm();
+        maxResidual = std::max(maxResidual, residual);
+      }
+
+      if (maxResidual <= this->m_Tolerance * scale)
+      {
+        this->m_EigenValues = ritzValues.extract(m);
+        this->m_EigenVectors = V.extract(n, m);
+        this->m_Basis = V;
+        return true;
+      }
+    }
+
+    this->ComputeFull(K, m, blockSize);
+    return false;
+  }
+
+
+  /** The m largest eigenvalues, in descending order. */
+  const VectorType &
+  GetEigenValues(void) const
+  {
+    return this->m_EigenValues;
+  }
+
+
+  /** The corresponding normalized eigenvectors, stored as columns. */
+  const MatrixType &
+  GetEigenVectors(void) const
+  {
+    return this->m_EigenVectors;
+  }
+
+
+  /** The number of iterations of the last call to Compute(). */
+  unsigned int
+  GetNumberOfIterations(void) const
+  {
+    return this->m_NumberOfIterations;
+  }
+
+private:
+  /** Full decomposition, which also refreshes the cached basis. */
+  void
+  ComputeFull(const MatrixType & K, unsigned int m, unsigned int blockSize)
+  {
+    const unsigned int                        n = K.rows();
+    const vnl_symmetric_eigensystem<RealType> eig(K);
+
+    this->m_EigenValues.set_size(m);
+    this->m_EigenVectors.set_size(n, m);
+    this->m_Basis.set_size(n, blockSize);
+    for (unsigned int i = 0; i < blockSize; ++i)
+    {
+      const VectorType eigenVector = eig.get_eigenvector(n - 1 - i).normalize();
+      this->m_Basis.set_column(i, eigenVector);
+      if (i < m)
+      {
+        this->m_EigenValues[i] = eig.get_eigenvalue(n - 1 - i);
+        this->m_EigenVectors.set_column(i, eigenVector);
+      }
+    }
+  }
+
+
+  /** Orthogonalize v against the first numberOfColumns columns of Q, with modified
+   * Gram-Schmidt and one reorthogonalization pass, and store it normalized in the next
+   * column. Returns false, and leaves Q unchanged, if v is (numerically) in their span.
+   */
+  static bool
+  AppendOrthonormalized(MatrixType & Q, unsigned int numberOfColumns, VectorType v)
+  {
+    const RealType originalNorm = v.two_norm();
+    for (unsigned int pass = 0; pass < 2; ++pass)
+    {
+      for (unsigned int k = 0; k < numberOfColumns; ++k)
+      {
+        const VectorType q = Q.get_column(k);
+        v -= q * dot_product(q, v);
+      }
+    }
+    const RealType norm = v.two_norm();
+    if (!(norm > 1e-8 * originalNorm) || !(norm > 0.0))
+    {
+      return false;
+    }
+    Q.set_column(numberOfColumns, v / norm);
+    return true;
+  }
+
+
+  unsigned int m_MaximumNumberOfIterations{ 20 };
+  RealType     m_Tolerance{ 1e-8 };
+  unsigned int m_Oversampling{ 2 };
+  unsigned int m_NumberOfBlocks{ 3 };
+  unsigned int m_NumberOfIterations{ 0 };
+  VectorType   m_EigenValues;
+  MatrixType   m_EigenVectors;
+  MatrixType   m_Basis;
+};
+
+} // end namespace itk
+
+#endif /* itkBlockLanczosEigenSolver_h */
@@ -0,0 +1,186 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCovarianceAccumulator_h
+#define itkCovarianceAccumulator_h
+
+#include "itkIntTypes.h"
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_vector.h"
+
+namespace itk
+{
+
+/** \class CovarianceAccumulator
+ *
+ * \brief Accumulates the column mean and the centered scatter matrix of a set of observations.
+ *
+ * Each row of a samples matrix is one observation. Partial results, for example
+ * computed by different threads over disjoint sets of rows, are combined with Merge(),
+ * using the pairwise update of Chan et al.:
+ *
+ *   M2 = M2_a + M2_b + n_a n_b / n (m_b - m_a)(m_b - m_a)^T.
+ *
+ * This avoids forming the centered samples matrix before the covariance can be computed,
+ * and is numerically more stable than accumulating raw sums of products.
+ *
+ * \ingroup Metrics
+ */
+
+template <class TReal>
+class CovarianceAccumulator
+{
+public:
+  typedef TReal             RealType;
+  typedef vnl_vector<TReal> VectorType;
+  typedef vnl_matrix<TReal> MatrixType;
+
+  /** Clear the accumulator, for observations of the given dimension. */
+  void
+  Initialize(unsigned int dimension)
+  {
+    this->m_NumberOfSamples = 0;
+    this->m_Mean.set_size(dimension);
+    this->m_Mean.fill(0.0);
+    this->m_Scatter.set_size(dimension, dimension);
+    this->m_Scatter.fill(0.0);
+  }
+
+
+  /** Add the rows [rowBegin, rowEnd) of the samples matrix as observations. */
+  void
+  AddRows(const MatrixType & samples, unsigned int rowBegin, unsigned int rowEnd)
+  {
+    if (rowEnd <= rowBegin)
+    {
+      return;
+    }
+
+    const unsigned int dimension = samples.cols();
+    CovarianceAccumulator block;
+    block.Initialize(dimension);
+    block.m_NumberOfSamples = rowEnd - rowBegin;
+
+    /** Mean of the block. */
+    RealType * mean = block.m_Mean.data_block();
+    for (unsigned int i = rowBegin; i < rowEnd; ++i)
+    {
+      const RealType * row = samples[i];
+      for (unsigned int j = 0; j < dimension; ++j)
+      {
+        mean[j] += row[j];
+      }
+    }
+    block.m_Mean /= static_cast<RealType>(block.m_NumberOfSamples);
+
+    /** Upper triangle of the centered scatter matrix of the block. */
+    VectorType centered(dimension);
+    for (unsigned int i = rowBegin; i < rowEnd; ++i)
+    {
+      const RealType * row = samples[i];
+      for (unsigned int j = 0; j < dimension; ++j)
+      {
+        centered[j] = row[j] - mean[j];
+      }
+      for (unsigned int j = 0; j < dimension; ++j)
+      {
+        RealType *     scatterRow = block.m_Scatter[j];
+        const RealType cj = centered[j];
+        for (unsigned int k = j; k < dimension; ++k)
+        {
+          scatterRow[k] += cj * centered[k];
+        }
+      }
+    }
+    for (unsigned int j = 0; j < dimension; ++j)
+    {
+      for (unsigned int k = j + 1; k < dimension; ++k)
+      {
+        block.m_Scatter(k, j) = block.m_Scatter(j, k);
+      }
+    }
+
+    this->Merge(block);
+  }
+
+
+  /** Combine the observations of another accumulator with the observations of this one. */
+  void
+  Merge(const CovarianceAccumulator & other)
+  {
+    if (other.m_NumberOfSamples == 0)
+    {
+      return;
+    }
+    if (this->m_NumberOfSamples == 0)
+    {
+      *this = other;
+      return;
+    }
+
+    const RealType   na = static_cast<RealType>(this->m_NumberOfSamples);
+    const RealType   nb = static_cast<RealType>(other.m_NumberOfSamples);
+    const RealType   n = na + nb;
+    const VectorType delta = other.m_Mean - this->m_Mean;
+
+    this->m_Scatter += other.m_Scatter;
+    this->m_Scatter += outer_product(delta, delta) * (na * nb / n);
+    this->m_Mean += delta * (nb / n);
+    this->m_NumberOfSamples += other.m_NumberOfSamples;
+  }
+
+
+  /** The number of observations that were added. */
+  SizeValueType
+  GetNumberOfSamples(void) const
+  {
+    return this->m_NumberOfSamples;
+  }
+
+
+  /** The mean of the observations. */
+  const VectorType &
+  GetMean(void) const
+  {
+    return this->m_Mean;
+  }
+
+
+  /** The centered scatter matrix, i.e. the sum of (x - mean)(x - mean)^T. */
+  const MatrixType &
+  GetScatterMatrix(void) const
+  {
+    return this->m_Scatter;
+  }
+
+
+  /** The unbiased covariance matrix, i.e. the scatter matrix divided by N - 1. */
+  MatrixType
+  GetCovarianceMatrix(void) const
+  {
+    return this->m_Scatter / (static_cast<RealType>(this->m_NumberOfSamples) - 1.0);
+  }
+
+private:
+  SizeValueType m_NumberOfSamples{ 0 };
+  VectorType    m_Mean;
+  MatrixType    m_Scatter;
+};
+
+} // end namespace itk
+
+#endif /* itkCovarianceAccumulator_h */
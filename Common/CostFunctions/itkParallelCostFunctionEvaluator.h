@@ -0,0 +1,224 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkParallelCostFunctionEvaluator_h
+#define itkParallelCostFunctionEvaluator_h
+
+#include "itkSingleValuedCostFunction.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ParallelCostFunctionEvaluator
+ *
+ * \brief Evaluates a cost function at many parameter vectors concurrently,
+ * using one independent copy of the cost function per worker.
+ *
+ * Derivative-free optimizers evaluate the cost function at a number of parameter
+ * vectors that only depend on the current position, such as the perturbed positions
+ * of a finite difference gradient. This class hands these evaluations out to the
+ * workers of a WorkStealingThreadPool. Each worker uses its own cost function, so the
+ * cost functions should not share a transform, and are best configured to use a
+ * single thread each.
+ *
+ * The parameter vectors are created by the workers themselves, with a generator
+ * function, so that they do not all need to be in memory at the same time. The
+ * values are stored by evaluation number, so the result does not depend on the
+ * number of workers or on the order of the evaluations.
+ *
+ * All optimizers that evaluate their cost function concurrently use this class, so
+ * they share the threading mechanism of the thread pool option of the metrics.
+ *
+ * \ingroup CostFunctions
+ */
+
+class ParallelCostFunctionEvaluator : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef ParallelCostFunctionEvaluator Self;
+  typedef Object                        Superclass;
+  typedef SmartPointer<Self>            Pointer;
+  typedef SmartPointer<const Self>      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ParallelCostFunctionEvaluator, Object);
+
+  typedef SingleValuedCostFunction         CostFunctionType;
+  typedef CostFunctionType::Pointer        CostFunctionPointer;
+  typedef CostFunctionType::MeasureType    MeasureType;
+  typedef CostFunctionType::ParametersType ParametersType;
+  typedef std::vector<CostFunctionPointer> CostFunctionContainerType;
+  typedef std::vector<MeasureType>         MeasureContainerType;
+  typedef std::vector<std::exception_ptr>  ExceptionContainerType;
+
+  /** Fills the parameter vector of the evaluation with the given number. It is called
+   * concurrently by the workers, and should overwrite all elements that it depends on.
+   */
+  typedef std::function<void(SizeValueType, ParametersType &)> ParametersGeneratorType;
+
+  /** Set the cost functions, one for each worker. */
+  void
+  SetCostFunctions(const CostFunctionContainerType & costFunctions)
+  {
+    for (const auto & costFunction : costFunctions)
+    {
+      if (costFunction.IsNull())
+      {
+        itkExceptionMacro(<< "One of the cost functions has not been set.");
+      }
+    }
+    this->m_CostFunctions = costFunctions;
+    this->Modified();
+  }
+
+
+  /** Get the cost functions. */
+  const CostFunctionContainerType &
+  GetCostFunctions(void) const
+  {
+    return this->m_CostFunctions;
+  }
+
+
+  /** Get the number of workers, which is the number of cost functions. */
+  ThreadIdType
+  GetNumberOfWorkers(void) const
+  {
+    return static_cast<ThreadIdType>(this->m_CostFunctions.size());
+  }
+
+
+  /** Compute values[ i ] = C( x_i ), for i < numberOfEvaluations, where x_i is filled
+   * by the generator. The parameter vectors start as a copy of initialParameters.
+   * An exception of one of the cost functions is rethrown, after all workers stopped.
+   */
+  void
+  Evaluate(SizeValueType                   numberOfEvaluations,
+           const ParametersType &          initialParameters,
+           const ParametersGeneratorType & generator,
+           MeasureContainerType &          values)
+  {
+    this->EvaluateImplementation(numberOfEvaluations, initialParameters, generator, values, nullptr);
+  }
+
+
+  /** Like Evaluate(), but an exception of a cost function only fails its own evaluation.
+   * It is stored in exceptions[ i ], and the workers continue with the other evaluations.
+   * The exceptions of the successful evaluations are null.
+   */
+  void
+  Evaluate(SizeValueType                   numberOfEvaluations,
+           const ParametersType &          initialParameters,
+           const ParametersGeneratorType & generator,
+           MeasureContainerType &          values,
+           ExceptionContainerType &        exceptions)
+  {
+    exceptions.assign(numberOfEvaluations, nullptr);
+    this->EvaluateImplementation(numberOfEvaluations, initialParameters, generator, values, &exceptions);
+  }
+
+
+protected:
+  /** The constructor. */
+  ParallelCostFunctionEvaluator()
+  {
+    this->m_ThreadPool = WorkStealingThreadPool::New();
+  }
+
+  /** The destructor. */
+  ~ParallelCostFunctionEvaluator() override = default;
+
+private:
+  /** The deleted copy constructor. */
+  ParallelCostFunctionEvaluator(const Self &) = delete;
+  /** The deleted assignment operator. */
+  void
+  operator=(const Self &) = delete;
+
+  /** Evaluates the cost functions. Without exception container, the first exception
+   * stops all workers and is rethrown.
+   */
+  void
+  EvaluateImplementation(SizeValueType                   numberOfEvaluations,
+                         const ParametersType &          initialParameters,
+                         const ParametersGeneratorType & generator,
+                         MeasureContainerType &          values,
+                         ExceptionContainerType *        exceptions)
+  {
+    values.assign(numberOfEvaluations, NumericTraits<MeasureType>::Zero);
+    if (numberOfEvaluations == 0)
+    {
+      return;
+    }
+    if (this->m_CostFunctions.empty())
+    {
+      itkExceptionMacro(<< "No cost functions have been set.");
+    }
+
+    const ThreadIdType numberOfWorkers =
+      static_cast<ThreadIdType>(std::min<SizeValueType>(this->m_CostFunctions.size(), numberOfEvaluations));
+    this->m_ThreadPool->SetNumberOfWorkers(numberOfWorkers);
+    this->m_Queue.Initialize(numberOfEvaluations, numberOfWorkers);
+
+    std::atomic<bool> failed(false);
+    this->m_ThreadPool->Execute([&](const ThreadIdType workerId) {
+      const CostFunctionType * costFunction = this->m_CostFunctions[workerId];
+      ParametersType           parameters(initialParameters);
+      SizeValueType            evaluation = 0;
+      while (!failed && this->m_Queue.Pop(workerId, evaluation))
+      {
+        generator(evaluation, parameters);
+        try
+        {
+          values[evaluation] = costFunction->GetValue(parameters);
+        }
+        catch (...)
+        {
+          if (exceptions != nullptr)
+          {
+            (*exceptions)[evaluation] = std::current_exception();
+            continue;
+          }
+
+          /** Let the other workers stop early. */
+          failed = true;
+          throw;
+        }
+      }
+    });
+  }
+
+
+  CostFunctionContainerType          m_CostFunctions;
+  WorkStealingThreadPool::Pointer    m_ThreadPool;
+  WorkStealingThreadPool::ChunkQueue m_Queue;
+};
+
+} // end namespace itk
+
+#endif /* itkParallelCostFunctionEvaluator_h */
@@ -20,6 +20,7 @@
 
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkKernelFunctionBase2.h"
+#include "itkArray2D.h"
 
 
 namespace itk
@@ -192,6 +193,17 @@ public:
   itkGetConstReferenceMacro(UseExplicitPDFDerivatives, bool);
   itkBooleanMacro(UseExplicitPDFDerivatives);
 
+  /** Option to store the explicit PDF derivatives sparsely, per sample,
+   * instead of in a dense image of size #parameters * #bins * #bins.
+   * For each sample only the nonzero Jacobian indices and the affected
+   * histogram bins are stored, so memory scales with the number of samples.
+   * Only used when UseExplicitPDFDerivatives is true.
+   * This option should be set before calling Initialize(); Default: false.
+   */
+  itkSetMacro(UseSparsePDFDerivatives, bool);
+  itkGetConstReferenceMacro(UseSparsePDFDerivatives, bool);
+  itkBooleanMacro(UseSparsePDFDerivatives);
+
   /** Whether you plan to call the GetDerivative/GetValueAndDerivative method or not.
    * This option should be set before calling Initialize(); Default: false.
    */
@@ -236,6 +248,7 @@ protected:
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::SampleBlockType                     SampleBlockType;
 
   /** Typedefs for the PDFs and PDF derivatives. */
   typedef double                                       PDFValueType;
@@ -296,6 +309,37 @@ protected:
   /** Threading related parameters. */
   mutable std::vector<JointPDFPointer> m_ThreaderJointPDFs;
 
+  /** Compact storage of the joint PDF derivatives, used when UseSparsePDFDerivatives is true.
+   * For each valid sample the following is appended:
+   * - the lowest joint histogram bin affected by the sample,
+   * - the Parzen weights fv(f) * dmv(m) / et for all bins of the Parzen window,
+   * - the nonzero Jacobian indices and the corresponding image Jacobian values.
+   * The dense derivative dh/dmu(m,f) is the sum over the samples of
+   * -imageJacobian(mu) * weight(m,f). The vectors keep their capacity between
+   * iterations, so no reallocation is needed after the first iteration.
+   */
+  struct SparseJointPDFDerivativesType
+  {
+    std::vector<JointPDFIndexType>      m_WindowIndices;
+    std::vector<PDFValueType>           m_ParzenWeights;
+    std::vector<unsigned int>           m_NonZeroJacobianIndices;
+    std::vector<PDFDerivativeValueType> m_ImageJacobians;
+
+    void
+    Clear(void)
+    {
+      this->m_WindowIndices.clear();
+      this->m_ParzenWeights.clear();
+      this->m_NonZeroJacobianIndices.clear();
+      this->m_ImageJacobians.clear();
+    }
+  };
+  mutable SparseJointPDFDerivativesType m_SparseJointPDFDerivatives;
+
+  /** The bin weights used by ComputeDerivativeFromSparsePDFDerivatives(). */
+  typedef Array2D<double> SparsePDFDerivativesBinWeightsType;
+  mutable const SparsePDFDerivativesBinWeightsType * m_SparsePDFDerivativesBinWeights;
+
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
    */
@@ -307,8 +351,9 @@ protected:
 
   struct ParzenWindowHistogramGetValueAndDerivativePerThreadStruct
   {
-    SizeValueType   st_NumberOfPixelsCounted;
-    JointPDFPointer st_JointPDF;
+    SizeValueType                 st_NumberOfPixelsCounted;
+    JointPDFPointer               st_JointPDF;
+    SparseJointPDFDerivativesType st_SparseJointPDFDerivatives;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                ParzenWindowHistogramGetValueAndDerivativePerThreadStruct,
@@ -340,6 +385,22 @@ protected:
   void
   LaunchComputePDFsThreaderCallback(void) const;
 
+  /** Multi-threaded version of ComputePDFsAndPDFDerivatives, using sparse PDF derivatives. */
+  inline void
+  ThreadedComputePDFsAndSparsePDFDerivatives(ThreadIdType threadId);
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputePDFsAndSparsePDFDerivativesThreaderCallback(void * arg);
+
+  /** Multi-threaded contraction of the sparse PDF derivatives with the bin weights. */
+  inline void
+  ThreadedComputeDerivativeFromSparsePDFDerivatives(ThreadIdType threadId);
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeFromSparsePDFDerivativesThreaderCallback(void * arg);
+
   /** Compute the Parzen values given an image value and a starting histogram index
    * Compute the values at (parzenWindowIndex - parzenWindowTerm + k) for
    * k = 0 ... kernelsize-1
@@ -382,6 +443,17 @@ protected:
                                    const DerivativeType &             movingMaskValuesLeft,
                                    const NonZeroJacobianIndicesType & nzji) const;
 
+  /** Update the joint PDF with a pixel pair, and append the sample's
+   * contribution to the joint PDF derivatives to the sparse storage.
+   */
+  virtual void
+  UpdateJointPDFAndSparseDerivatives(const RealType &                   fixedImageValue,
+                                     const RealType &                   movingImageValue,
+                                     const DerivativeType &             imageJacobian,
+                                     const NonZeroJacobianIndicesType & nzji,
+                                     JointPDFType *                     jointPDF,
+                                     SparseJointPDFDerivativesType &    sparsePDFDerivatives) const;
+
   /** Update the pdf derivatives
    * adds -image_jac[mu]*factor to the bin
    * with index [ mu, pdfIndex[0], pdfIndex[1] ] for all mu.
@@ -430,6 +502,31 @@ protected:
   virtual void
   ComputePDFsAndPDFDerivatives(const ParametersType & parameters) const;
 
+  /** Compute PDFs and sparse pdf derivatives; used when UseSparsePDFDerivatives is true.
+   * Constructs m_JointPDF, m_Alpha and the sparse storage of the joint PDF derivatives.
+   * Executes multi-threadedly when m_UseMultiThread == true, in which case
+   * each thread keeps its own sparse storage.
+   */
+  virtual void
+  ComputePDFsAndSparsePDFDerivatives(const ParametersType & parameters) const;
+
+  /** Compute the derivative from the sparse pdf derivatives:
+   * derivative(mu) = - sum_f sum_m dh/dmu(m,f) * binWeights[f][m],
+   * with binWeights indexed as [fixed bin][moving bin]. This is a reduction
+   * over the stored samples, which executes multi-threadedly when
+   * m_UseMultiThread == true, followed by the accumulation of the per-thread
+   * derivatives.
+   */
+  virtual void
+  ComputeDerivativeFromSparsePDFDerivatives(const SparsePDFDerivativesBinWeightsType & binWeights,
+                                            DerivativeType &                           derivative) const;
+
+  /** Helper function that adds the contraction of one sparse storage with the bin weights to the derivative. */
+  void
+  AccumulateSparsePDFDerivatives(const SparseJointPDFDerivativesType &      sparsePDFDerivatives,
+                                 const SparsePDFDerivativesBinWeightsType & binWeights,
+                                 DerivativeType &                           derivative) const;
+
   /** Compute PDFs and incremental pdfs (which you can use to compute finite
    * difference estimate of the derivative).
    * Loops over the fixed image samples and constructs the m_JointPDF,
@@ -511,6 +608,7 @@ private:
   unsigned int  m_MovingKernelBSplineOrder;
   bool          m_UseDerivative;
   bool          m_UseExplicitPDFDerivatives;
+  bool          m_UseSparsePDFDerivatives;
   bool          m_UseFiniteDifferenceDerivative;
   double        m_FiniteDifferencePerturbation;
 };
@@ -26,6 +26,8 @@
 #include "itkImageScanlineIterator.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm> // std::min, std::copy_n
+
 namespace itk
 {
 
@@ -67,6 +69,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ParzenWindow
   this->SetUseMovingImageLimiter(true);
 
   this->m_UseExplicitPDFDerivatives = true;
+  this->m_UseSparsePDFDerivatives = false;
+  this->m_SparsePDFDerivativesBinWeights = nullptr;
 
   /** Initialize the m_ParzenWindowHistogramThreaderParameters */
   this->m_ParzenWindowHistogramThreaderParameters.m_Metric = this;
@@ -314,7 +318,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeHi
     } // end if this->GetUseFiniteDifferenceDerivative()
     else
     {
-      if (this->m_UseExplicitPDFDerivatives)
+      if (this->m_UseExplicitPDFDerivatives && !this->m_UseSparsePDFDerivatives)
       {
         this->m_IncrementalJointPDFRight = nullptr;
         this->m_IncrementalJointPDFLeft = nullptr;
@@ -325,6 +329,9 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeHi
       }
       else
       {
+        this->m_IncrementalJointPDFRight = nullptr;
+        this->m_IncrementalJointPDFLeft = nullptr;
+
         /** De-allocate large amount of memory for the m_JointPDFDerivatives. */
         // \todo Should not be allocated in the first place
         if (!this->m_JointPDFDerivatives.IsNull())
@@ -678,6 +685,87 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointP
 } // end UpdateJointPDFDerivatives()
 
 
+/**
+ * ********************** UpdateJointPDFAndSparseDerivatives ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointPDFAndSparseDerivatives(
+  const RealType &                   fixedImageValue,
+  const RealType &                   movingImageValue,
+  const DerivativeType &             imageJacobian,
+  const NonZeroJacobianIndicesType & nzji,
+  JointPDFType *                     jointPDF,
+  SparseJointPDFDerivativesType &    sparsePDFDerivatives) const
+{
+  typedef ImageScanlineIterator<JointPDFType> PDFIteratorType;
+
+  /** Determine Parzen window arguments (see eq. 6 of Mattes paper [2]). */
+  const double fixedImageParzenWindowTerm =
+    fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+  const double movingImageParzenWindowTerm =
+    movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+
+  /** The lowest bin numbers affected by this pixel: */
+  const OffsetValueType fixedImageParzenWindowIndex =
+    static_cast<OffsetValueType>(std::floor(fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset));
+  const OffsetValueType movingImageParzenWindowIndex =
+    static_cast<OffsetValueType>(std::floor(movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset));
+
+  /** The Parzen values and the derivatives of the moving Parzen window. */
+  ParzenValueContainerType fixedParzenValues(this->m_JointPDFWindow.GetSize()[1]);
+  ParzenValueContainerType movingParzenValues(this->m_JointPDFWindow.GetSize()[0]);
+  ParzenValueContainerType derivativeMovingParzenValues(this->m_JointPDFWindow.GetSize()[0]);
+  this->EvaluateParzenValues(
+    fixedImageParzenWindowTerm, fixedImageParzenWindowIndex, this->m_FixedKernel, fixedParzenValues);
+  this->EvaluateParzenValues(
+    movingImageParzenWindowTerm, movingImageParzenWindowIndex, this->m_MovingKernel, movingParzenValues);
+  this->EvaluateParzenValues(movingImageParzenWindowTerm,
+                             movingImageParzenWindowIndex,
+                             this->m_DerivativeMovingKernel,
+                             derivativeMovingParzenValues);
+
+  /** Position the JointPDFWindow. */
+  JointPDFIndexType pdfWindowIndex;
+  pdfWindowIndex[0] = movingImageParzenWindowIndex;
+  pdfWindowIndex[1] = fixedImageParzenWindowIndex;
+  sparsePDFDerivatives.m_WindowIndices.push_back(pdfWindowIndex);
+
+  /** For thread-safety, make a local copy of the support region. */
+  JointPDFRegionType jointPDFWindow = this->m_JointPDFWindow;
+  jointPDFWindow.SetIndex(pdfWindowIndex);
+  PDFIteratorType it(jointPDF, jointPDFWindow);
+
+  const double et = static_cast<double>(this->m_MovingImageBinSize);
+
+  /** Loop over the Parzen window region and increment the values.
+   * Also store the Parzen weights of the pdf derivatives, in the
+   * same order as the window is traversed.
+   */
+  for (unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f)
+  {
+    const double fv = fixedParzenValues[f];
+    const double fv_et = fv / et;
+    for (unsigned int m = 0; m < movingParzenValues.GetSize(); ++m)
+    {
+      it.Value() += static_cast<PDFValueType>(fv * movingParzenValues[m]);
+      sparsePDFDerivatives.m_ParzenWeights.push_back(fv_et * derivativeMovingParzenValues[m]);
+      ++it;
+    }
+    it.NextLine();
+  }
+
+  /** Store the sparse image Jacobian. */
+  for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
+  {
+    sparsePDFDerivatives.m_NonZeroJacobianIndices.push_back(nzji[i]);
+    sparsePDFDerivatives.m_ImageJacobians.push_back(static_cast<PDFDerivativeValueType>(imageJacobian[i]));
+  }
+
+} // end UpdateJointPDFAndSparseDerivatives()
+
+
 /**
  * *********************** NormalizeJointPDF ***********************
  */
@@ -1318,7 +1406,14 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
 {
   /** Initialize some variables. */
   this->m_JointPDF->FillBuffer(0.0);
-  this->m_JointPDFDerivatives->FillBuffer(0.0);
+  if (this->m_UseSparsePDFDerivatives)
+  {
+    this->m_SparseJointPDFDerivatives.Clear();
+  }
+  else
+  {
+    this->m_JointPDFDerivatives->FillBuffer(0.0);
+  }
   this->m_Alpha = 0.0;
   this->m_NumberOfPixelsCounted = 0;
 
@@ -1394,8 +1489,20 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
       this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
 
       /** Update the joint pdf and the joint pdf derivatives. */
-      this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, &imageJacobian, &nzji, this->m_JointPDF.GetPointer());
+      if (this->m_UseSparsePDFDerivatives)
+      {
+        this->UpdateJointPDFAndSparseDerivatives(fixedImageValue,
+                                                 movingImageValue,
+                                                 imageJacobian,
+                                                 nzji,
+                                                 this->m_JointPDF.GetPointer(),
+                                                 this->m_SparseJointPDFDerivatives);
+      }
+      else
+      {
+        this->UpdateJointPDFAndDerivatives(
+          fixedImageValue, movingImageValue, &imageJacobian, &nzji, this->m_JointPDF.GetPointer());
+      }
 
     } // end if-block check sampleOk
   }   // end iterating over fixed image spatial sample container for loop
@@ -1413,6 +1520,292 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
 } // end ComputePDFsAndPDFDerivatives()
 
 
+/**
+ * ************************ ComputePDFsAndSparsePDFDerivatives *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsAndSparsePDFDerivatives(
+  const ParametersType & parameters) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->ComputePDFsAndPDFDerivatives(parameters);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * See ComputePDFs() for more information.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  /** Launch multi-threading JointPDF and sparse JointPDFDerivatives computation. */
+  this->m_Threader->SetSingleMethod(
+    this->ComputePDFsAndSparsePDFDerivativesThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
+  this->m_Threader->SingleMethodExecute();
+
+  /** Gather the joint histograms from all threads.
+   * The sparse pdf derivatives are kept per thread.
+   */
+  this->AfterThreadedComputePDFs();
+
+} // end ComputePDFsAndSparsePDFDerivatives()
+
+
+/**
+ * ******************* ThreadedComputePDFsAndSparsePDFDerivatives *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComputePDFsAndSparsePDFDerivatives(
+  ThreadIdType threadId)
+{
+  /** Get a handle to the pre-allocated joint PDF and the sparse
+   * pdf derivatives for the current thread. The sparse storage is cleared,
+   * but keeps its capacity from the previous iteration.
+   */
+  JointPDFPointer & jointPDF =
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_JointPDF;
+  jointPDF->FillBuffer(NumericTraits<PDFValueType>::ZeroValue());
+  SparseJointPDFDerivativesType & sparsePDFDerivatives =
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_SparseJointPDFDerivatives;
+  sparsePDFDerivatives.Clear();
+
+  /** Array that stores dM(x)/dmu, and the sparse Jacobian + indices.
+   * The image Jacobian is a view on the memory of the sample block of this thread.
+   */
+  const SizeValueType        nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  NonZeroJacobianIndicesType nzji(nnzji);
+  DerivativeType             imageJacobian;
+  SampleBlockType &          block = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_SampleBlock;
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long numberOfPixelsCounted = 0;
+
+  /** Loop over the samples in blocks and compute the contribution of each sample to the pdfs.
+   * For each block the transform is evaluated with a single (virtual) call.
+   */
+  for (unsigned long block_begin = pos_begin; block_begin < pos_end; block_begin += Self::SampleBlockSize)
+  {
+    const unsigned long block_end = std::min<unsigned long>(block_begin + Self::SampleBlockSize, pos_end);
+
+    /** Transform the points, check the moving mask, and compute the moving image
+     * values and derivatives. Only the valid samples are kept.
+     */
+    this->EvaluateSampleBlock(*sampleContainer, block_begin, block_end, block);
+
+    /** Make sure the values fall within the histogram range. The moving image limiter
+     * also modifies the moving image derivative, so this is done before the image Jacobians.
+     */
+    for (unsigned long i = 0; i < block.m_NumberOfValidSamples; ++i)
+    {
+      block.m_FixedImageValues[i] = this->GetFixedImageLimiter()->Evaluate(block.m_FixedImageValues[i]);
+      block.m_MovingImageValues[i] =
+        this->GetMovingImageLimiter()->Evaluate(block.m_MovingImageValues[i], block.m_MovingImageDerivatives[i]);
+    }
+
+    /** Compute the inner products of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+    this->EvaluateSampleBlockImageJacobians(block);
+
+    for (unsigned long i = 0; i < block.m_NumberOfValidSamples; ++i)
+    {
+      numberOfPixelsCounted++;
+
+      imageJacobian.SetData(&block.m_ImageJacobians[i * nnzji], nnzji, false);
+      std::copy_n(&block.m_NonZeroJacobianIndices[i * nnzji], nnzji, nzji.begin());
+
+      /** Update the joint pdf and store the sparse joint pdf derivatives. */
+      this->UpdateJointPDFAndSparseDerivatives(block.m_FixedImageValues[i],
+                                               block.m_MovingImageValues[i],
+                                               imageJacobian,
+                                               nzji,
+                                               jointPDF.GetPointer(),
+                                               sparsePDFDerivatives);
+    }
+  } // end iterating over fixed image spatial sample container for loop
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted =
+    numberOfPixelsCounted;
+
+} // end ThreadedComputePDFsAndSparsePDFDerivatives()
+
+
+/**
+ * **************** ComputePDFsAndSparsePDFDerivativesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsAndSparsePDFDerivativesThreaderCallback(
+  void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp =
+    static_cast<ParzenWindowHistogramMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputePDFsAndSparsePDFDerivatives(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputePDFsAndSparsePDFDerivativesThreaderCallback()
+
+
+/**
+ * ******************* AccumulateSparsePDFDerivatives *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AccumulateSparsePDFDerivatives(
+  const SparseJointPDFDerivativesType &      sparsePDFDerivatives,
+  const SparsePDFDerivativesBinWeightsType & binWeights,
+  DerivativeType &                           derivative) const
+{
+  const std::size_t numberOfSamples = sparsePDFDerivatives.m_WindowIndices.size();
+  if (numberOfSamples == 0)
+  {
+    return;
+  }
+
+  /** The number of stored weights and Jacobian entries per sample is constant. */
+  const unsigned int windowSizeMoving = this->m_JointPDFWindow.GetSize()[0];
+  const unsigned int windowSizeFixed = this->m_JointPDFWindow.GetSize()[1];
+  const std::size_t  nnzji = sparsePDFDerivatives.m_ImageJacobians.size() / numberOfSamples;
+
+  const PDFValueType *           weightIt = &(sparsePDFDerivatives.m_ParzenWeights[0]);
+  const unsigned int *           nzjiIt = nnzji > 0 ? &(sparsePDFDerivatives.m_NonZeroJacobianIndices[0]) : nullptr;
+  const PDFDerivativeValueType * imjacIt = nnzji > 0 ? &(sparsePDFDerivatives.m_ImageJacobians[0]) : nullptr;
+
+  for (std::size_t s = 0; s < numberOfSamples; ++s)
+  {
+    /** Contract the Parzen weights of this sample with the bin weights:
+     * sum_f sum_m weight(m,f) * binWeights[f][m].
+     */
+    const JointPDFIndexType & windowIndex = sparsePDFDerivatives.m_WindowIndices[s];
+    double                    sum = 0.0;
+    for (unsigned int f = 0; f < windowSizeFixed; ++f)
+    {
+      const double * binWeightsRow = binWeights[windowIndex[1] + f] + windowIndex[0];
+      for (unsigned int m = 0; m < windowSizeMoving; ++m)
+      {
+        sum += (*weightIt) * binWeightsRow[m];
+        ++weightIt;
+      }
+    }
+
+    /** Now compute derivative += sum * imageJacobian, with
+     * the minus sign of the pdf derivatives cancelling the one of the contraction.
+     */
+    for (std::size_t i = 0; i < nnzji; ++i)
+    {
+      derivative[*nzjiIt] += static_cast<DerivativeValueType>((*imjacIt) * sum);
+      ++nzjiIt;
+      ++imjacIt;
+    }
+  }
+
+} // end AccumulateSparsePDFDerivatives()
+
+
+/**
+ * ******************* ComputeDerivativeFromSparsePDFDerivatives *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputeDerivativeFromSparsePDFDerivatives(
+  const SparsePDFDerivativesBinWeightsType & binWeights,
+  DerivativeType &                           derivative) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    this->AccumulateSparsePDFDerivatives(this->m_SparseJointPDFDerivatives, binWeights, derivative);
+    return;
+  }
+
+  /** Launch multi-threading contraction; each thread handles its own samples. */
+  this->m_SparsePDFDerivativesBinWeights = &binWeights;
+  this->m_Threader->SetSingleMethod(
+    this->ComputeDerivativeFromSparsePDFDerivativesThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
+  this->m_Threader->SingleMethodExecute();
+  this->m_SparsePDFDerivativesBinWeights = nullptr;
+
+  /** Accumulate the per-thread derivatives, which also resets them. */
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0;
+  this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
+                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+  this->m_Threader->SingleMethodExecute();
+
+} // end ComputeDerivativeFromSparsePDFDerivatives()
+
+
+/**
+ * ******************* ThreadedComputeDerivativeFromSparsePDFDerivatives *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComputeDerivativeFromSparsePDFDerivatives(
+  ThreadIdType threadId)
+{
+  /** The per-thread derivative is zero on entry, because it is reset
+   * by AccumulateDerivativesThreaderCallback at the end of each iteration.
+   */
+  this->AccumulateSparsePDFDerivatives(
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_SparseJointPDFDerivatives,
+    *this->m_SparsePDFDerivativesBinWeights,
+    this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative);
+
+} // end ThreadedComputeDerivativeFromSparsePDFDerivatives()
+
+
+/**
+ * **************** ComputeDerivativeFromSparsePDFDerivativesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::
+  ComputeDerivativeFromSparsePDFDerivativesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp =
+    static_cast<ParzenWindowHistogramMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputeDerivativeFromSparsePDFDerivatives(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeDerivativeFromSparsePDFDerivativesThreaderCallback()
+
+
 /**
  * ************************ ComputePDFsAndIncrementalPDFs *******************
  */
@@ -0,0 +1,362 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkWorkStealingThreadPool_h
+#define itkWorkStealingThreadPool_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace itk
+{
+
+/** \class WorkStealingThreadPool
+ *
+ * \brief A persistent pool of threads that run a job together, with work stealing.
+ *
+ * The threads are created once, when the number of workers is set, and are reused
+ * by every call of Execute(). Execute() runs the job on all workers, with the calling
+ * thread as worker 0, and returns when all workers are done. Within a job the workers
+ * can synchronize with Barrier(), which allows several phases in one launch.
+ *
+ * The work within a phase is divided with a ChunkQueue. Each worker starts with an
+ * equal, contiguous range of chunks, and takes chunks from the front of its own range.
+ * When its range is empty, it steals chunks from the back of the ranges of the other
+ * workers. So workers that get cheap chunks help the others, while most chunks are
+ * still processed in order, by the worker that owns them.
+ *
+ * An exception thrown by the job is rethrown by Execute(). A worker that leaves the
+ * job, normally or by an exception, no longer takes part in the barriers.
+ *
+ * \ingroup CostFunctions
+ */
+
+class WorkStealingThreadPool : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef WorkStealingThreadPool   Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(WorkStealingThreadPool, Object);
+
+  /** The job that is run by every worker. The argument is the worker id. */
+  typedef std::function<void(ThreadIdType)> JobType;
+
+  /** \class ChunkQueue
+   * \brief Hands out the chunks [0, numberOfChunks) to the workers, with work stealing.
+   */
+  class ChunkQueue
+  {
+  public:
+    /** Divide the chunks over the workers. Not thread-safe: call it before
+     * Execute(), or from one worker between two barriers.
+     */
+    void
+    Initialize(SizeValueType numberOfChunks, ThreadIdType numberOfWorkers)
+    {
+      if (numberOfWorkers != this->m_NumberOfWorkers)
+      {
+        this->m_Ranges.reset(new PaddedRangeType[numberOfWorkers]);
+        this->m_NumberOfWorkers = numberOfWorkers;
+      }
+      for (ThreadIdType w = 0; w < numberOfWorkers; ++w)
+      {
+        const std::uint64_t begin = (numberOfChunks * w) / numberOfWorkers;
+        const std::uint64_t end = (numberOfChunks * (w + 1)) / numberOfWorkers;
+        this->m_Ranges[w].m_Range.store(Pack(begin, end), std::memory_order_relaxed);
+      }
+    }
+
+
+    /** Get the next chunk for this worker: the first one of its own range, or else
+     * the last one of the range of another worker. Returns false when all chunks
+     * have been handed out.
+     */
+    bool
+    Pop(ThreadIdType workerId, SizeValueType & chunk)
+    {
+      /** Take from the front of the own range. */
+      std::atomic<std::uint64_t> & own = this->m_Ranges[workerId].m_Range;
+      std::uint64_t                range = own.load(std::memory_order_relaxed);
+      while (GetBegin(range) < GetEnd(range))
+      {
+        if (own.compare_exchange_weak(range, Pack(GetBegin(range) + 1, GetEnd(range)), std::memory_order_acquire))
+        {
+          chunk = GetBegin(range);
+          return true;
+        }
+      }
+
+      /** Steal from the back of the range of another worker. */
+      for (ThreadIdType i = 1; i < this->m_NumberOfWorkers; ++i)
+      {
+        std::atomic<std::uint64_t> & other = this->m_Ranges[(workerId + i) % this->m_NumberOfWorkers].m_Range;
+        range = other.load(std::memory_order_relaxed);
+        while (GetBegin(range) < GetEnd(range))
+        {
+          if (other.compare_exchange_weak(range, Pack(GetBegin(range), GetEnd(range) - 1), std::memory_order_acquire))
+          {
+            chunk = GetEnd(range) - 1;
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+
+  private:
+    /** The range [begin, end) of a worker, packed in one atomic, on its own cache line. */
+    struct PaddedRangeType
+    {
+      std::atomic<std::uint64_t> m_Range;
+      char                       m_Padding[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    static std::uint64_t
+    Pack(std::uint64_t begin, std::uint64_t end)
+    {
+      return (begin << 32) | end;
+    }
+
+    static std::uint64_t
+    GetBegin(std::uint64_t range)
+    {
+      return range >> 32;
+    }
+
+    static std::uint64_t
+    GetEnd(std::uint64_t range)
+    {
+      return range & 0xffffffffu;
+    }
+
+    std::unique_ptr<PaddedRangeType[]> m_Ranges;
+    ThreadIdType                       m_NumberOfWorkers{ 0 };
+  };
+
+
+  /** Set the number of workers, including the calling thread. Threads are only
+   * created or stopped when the number changes.
+   */
+  void
+  SetNumberOfWorkers(ThreadIdType numberOfWorkers)
+  {
+    numberOfWorkers = numberOfWorkers > 0 ? numberOfWorkers : 1;
+    if (numberOfWorkers == this->m_NumberOfWorkers)
+    {
+      return;
+    }
+    this->StopThreads();
+    this->m_NumberOfWorkers = numberOfWorkers;
+    for (ThreadIdType w = 1; w < numberOfWorkers; ++w)
+    {
+      this->m_Threads.emplace_back(&Self::WorkerLoop, this, w, this->m_JobGeneration);
+    }
+  }
+
+
+  /** Get the number of workers, including the calling thread. */
+  ThreadIdType
+  GetNumberOfWorkers(void) const
+  {
+    return this->m_NumberOfWorkers;
+  }
+
+
+  /** Run the job on all workers, and wait until all are done. */
+  void
+  Execute(const JobType & job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->m_Mutex);
+      this->m_Job = &job;
+      this->m_Exception = nullptr;
+      this->m_NumberOfActiveWorkers = this->m_NumberOfWorkers;
+      this->m_NumberOfWaitingWorkers = 0;
+      ++this->m_JobGeneration;
+    }
+    this->m_StartCondition.notify_all();
+
+    /** The calling thread is worker 0. */
+    this->RunJob(0);
+
+    std::unique_lock<std::mutex> lock(this->m_Mutex);
+    this->m_DoneCondition.wait(lock, [this] { return this->m_NumberOfActiveWorkers == 0; });
+    this->m_Job = nullptr;
+    if (this->m_Exception)
+    {
+      std::rethrow_exception(this->m_Exception);
+    }
+  }
+
+
+  /** Wait until all workers that are still running the job have arrived here.
+   * Only to be called from within a job.
+   */
+  void
+  Barrier(void)
+  {
+    std::unique_lock<std::mutex> lock(this->m_Mutex);
+    const SizeValueType          generation = this->m_BarrierGeneration;
+    if (++this->m_NumberOfWaitingWorkers == this->m_NumberOfActiveWorkers)
+    {
+      this->ReleaseBarrier();
+      return;
+    }
+    this->m_BarrierCondition.wait(lock, [this, generation] { return generation != this->m_BarrierGeneration; });
+  }
+
+
+protected:
+  /** The constructor. */
+  WorkStealingThreadPool() = default;
+
+  /** The destructor stops the threads. */
+  ~WorkStealingThreadPool() override
+  {
+    this->StopThreads();
+  }
+
+
+private:
+  /** The deleted copy constructor. */
+  WorkStealingThreadPool(const Self &) = delete;
+  /** The deleted assignment operator. */
+  void
+  operator=(const Self &) = delete;
+
+  /** The loop of the threads, which waits for jobs newer than lastGeneration. */
+  void
+  WorkerLoop(ThreadIdType workerId, SizeValueType lastGeneration)
+  {
+    for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(this->m_Mutex);
+        this->m_StartCondition.wait(
+          lock, [this, lastGeneration] { return this->m_Stop || this->m_JobGeneration != lastGeneration; });
+        if (this->m_Stop)
+        {
+          return;
+        }
+        lastGeneration = this->m_JobGeneration;
+      }
+      this->RunJob(workerId);
+    }
+  }
+
+
+  /** Run the job, and sign off. */
+  void
+  RunJob(ThreadIdType workerId)
+  {
+    std::exception_ptr exception;
+    try
+    {
+      (*this->m_Job)(workerId);
+    }
+    catch (...)
+    {
+      exception = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(this->m_Mutex);
+    if (exception && !this->m_Exception)
+    {
+      this->m_Exception = exception;
+    }
+
+    /** The workers that wait at a barrier should not wait for this one. */
+    --this->m_NumberOfActiveWorkers;
+    if (this->m_NumberOfWaitingWorkers > 0 && this->m_NumberOfWaitingWorkers == this->m_NumberOfActiveWorkers)
+    {
+      this->ReleaseBarrier();
+    }
+    if (this->m_NumberOfActiveWorkers == 0)
+    {
+      this->m_DoneCondition.notify_one();
+    }
+  }
+
+
+  /** Let the waiting workers pass the barrier. The mutex must be locked. */
+  void
+  ReleaseBarrier(void)
+  {
+    this->m_NumberOfWaitingWorkers = 0;
+    ++this->m_BarrierGeneration;
+    this->m_BarrierCondition.notify_all();
+  }
+
+
+  /** Stop and join the threads. */
+  void
+  StopThreads(void)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->m_Mutex);
+      this->m_Stop = true;
+    }
+    this->m_StartCondition.notify_all();
+    for (std::thread & thread : this->m_Threads)
+    {
+      thread.join();
+    }
+    this->m_Threads.clear();
+    this->m_Stop = false;
+    this->m_NumberOfWorkers = 1;
+  }
+
+
+  /** Member variables. */
+  std::vector<std::thread> m_Threads;
+  ThreadIdType             m_NumberOfWorkers{ 1 };
+  std::mutex               m_Mutex;
+  std::condition_variable  m_StartCondition;
+  std::condition_variable  m_DoneCondition;
+  std::condition_variable  m_BarrierCondition;
+  const JobType *          m_Job{ nullptr };
+  std::exception_ptr       m_Exception;
+  SizeValueType            m_JobGeneration{ 0 };
+  SizeValueType            m_BarrierGeneration{ 0 };
+  ThreadIdType             m_NumberOfActiveWorkers{ 0 };
+  ThreadIdType             m_NumberOfWaitingWorkers{ 0 };
+  bool                     m_Stop{ false };
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkWorkStealingThreadPool_h
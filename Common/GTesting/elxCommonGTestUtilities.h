@@ -0,0 +1,228 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxCommonGTestUtilities_h
+#define elxCommonGTestUtilities_h
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageFullSampler.h"
+#include "itkSingleValuedCostFunction.h"
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <cmath>
+#include <random>
+
+namespace elastix
+{
+namespace CommonGTestUtilities
+{
+
+/** The type of the images of the metric tests. */
+constexpr unsigned int MetricTestImageDimension = 2;
+typedef itk::Image<float, MetricTestImageDimension> MetricTestImageType;
+
+/** The B-spline transform of the metric tests. */
+typedef itk::AdvancedBSplineDeformableTransform<double, MetricTestImageDimension, 3> MetricTestBSplineTransformType;
+
+/** The type of the image groups of the groupwise metric tests, of which the last
+ * dimension is the image index, and of their B-spline transform.
+ */
+typedef itk::Image<float, MetricTestImageDimension + 1> MetricTestGroupImageType;
+typedef itk::AdvancedBSplineDeformableTransform<double, MetricTestImageDimension + 1, 3>
+  MetricTestGroupBSplineTransformType;
+
+
+/** Creates a (40x30) image of a smooth pattern, shifted along the x-axis, so that
+ * registering two of these images gives nonzero metric derivatives everywhere.
+ */
+inline MetricTestImageType::Pointer
+CreateSmoothImage(const double shift)
+{
+  const auto image = MetricTestImageType::New();
+  image->SetRegions(MetricTestImageType::SizeType{ { 40, 30 } });
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<MetricTestImageType> it(image, image->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0] - shift;
+    const double y = it.GetIndex()[1];
+    it.Set(static_cast<float>(100.0 + 50.0 * std::sin(0.3 * x) * std::cos(0.2 * y) + 0.5 * x + 0.25 * y));
+  }
+  return image;
+}
+
+
+/** Creates a B-spline transform with random coefficients, of which the grid covers
+ * the images of CreateSmoothImage().
+ */
+inline MetricTestBSplineTransformType::Pointer
+CreateBSplineTransform(const double maximumCoefficient)
+{
+  MetricTestBSplineTransformType::RegionType region;
+  region.SetSize(0, 8);
+  region.SetSize(1, 7);
+  MetricTestBSplineTransformType::SpacingType spacing;
+  spacing.Fill(8.0);
+  MetricTestBSplineTransformType::OriginType origin;
+  origin.Fill(-12.0);
+  MetricTestBSplineTransformType::DirectionType direction;
+  direction.SetIdentity();
+
+  const auto transform = MetricTestBSplineTransformType::New();
+  transform->SetGridRegion(region);
+  transform->SetGridSpacing(spacing);
+  transform->SetGridOrigin(origin);
+  transform->SetGridDirection(direction);
+
+  std::mt19937                                   randomNumberEngine;
+  std::uniform_real_distribution<double>         distribution(-maximumCoefficient, maximumCoefficient);
+  MetricTestBSplineTransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+/** Creates a group of (20x16) images of a smooth pattern, stacked along the last
+ * dimension, in which each image is shifted along the x-axis with respect to the
+ * previous one.
+ */
+inline MetricTestGroupImageType::Pointer
+CreateSmoothImageGroup(const unsigned int numberOfImages)
+{
+  const auto image = MetricTestGroupImageType::New();
+  image->SetRegions(MetricTestGroupImageType::SizeType{ { 20, 16, numberOfImages } });
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<MetricTestGroupImageType> it(image, image->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0] - 0.7 * it.GetIndex()[2];
+    const double y = it.GetIndex()[1];
+    it.Set(static_cast<float>(100.0 + 50.0 * std::sin(0.3 * x) * std::cos(0.2 * y) + 0.5 * x + 0.25 * y));
+  }
+  return image;
+}
+
+
+/** Creates a B-spline transform with random coefficients, of which the grid covers
+ * a group of at most eight images of CreateSmoothImageGroup(), including the last
+ * dimension.
+ */
+inline MetricTestGroupBSplineTransformType::Pointer
+CreateGroupBSplineTransform(const double maximumCoefficient)
+{
+  MetricTestGroupBSplineTransformType::RegionType region;
+  region.SetSize(MetricTestGroupBSplineTransformType::SizeType::Filled(7));
+  MetricTestGroupBSplineTransformType::SpacingType spacing;
+  spacing[0] = 8.0;
+  spacing[1] = 8.0;
+  spacing[2] = 4.0;
+  MetricTestGroupBSplineTransformType::OriginType origin;
+  origin[0] = -12.0;
+  origin[1] = -12.0;
+  origin[2] = -6.0;
+  MetricTestGroupBSplineTransformType::DirectionType direction;
+  direction.SetIdentity();
+
+  const auto transform = MetricTestGroupBSplineTransformType::New();
+  transform->SetGridRegion(region);
+  transform->SetGridSpacing(spacing);
+  transform->SetGridOrigin(origin);
+  transform->SetGridDirection(direction);
+
+  std::mt19937                                        randomNumberEngine;
+  std::uniform_real_distribution<double>              distribution(-maximumCoefficient, maximumCoefficient);
+  MetricTestGroupBSplineTransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+/** Connects the images, the transform, a cubic B-spline interpolator and a full
+ * sampler to an advanced metric, and initializes the metric. The threading options
+ * of the metric should be set before.
+ */
+template <class TMetric, class TImage>
+void
+InitializeMetric(TMetric &                                 metric,
+                 const TImage &                            fixedImage,
+                 const TImage &                            movingImage,
+                 typename TMetric::AdvancedTransformType & transform)
+{
+  typedef itk::BSplineInterpolateImageFunction<TImage, double, double> InterpolatorType;
+  typedef itk::ImageFullSampler<TImage>                                ImageSamplerType;
+
+  const auto interpolator = InterpolatorType::New();
+  interpolator->SetSplineOrder(3);
+
+  metric.SetFixedImage(&fixedImage);
+  metric.SetMovingImage(&movingImage);
+  metric.SetFixedImageRegion(fixedImage.GetBufferedRegion());
+  metric.SetTransform(&transform);
+  metric.SetInterpolator(interpolator);
+  metric.SetImageSampler(ImageSamplerType::New());
+  metric.Initialize();
+}
+
+
+/** A quadratic cost function of three parameters, with its minimum at (1, -0.5, 2), for
+ * the optimizer tests. It has no derivative.
+ */
+class QuadraticCostFunction : public itk::SingleValuedCostFunction
+{
+public:
+  typedef QuadraticCostFunction         Self;
+  typedef itk::SingleValuedCostFunction Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+
+  itkNewMacro(Self);
+
+  MeasureType
+  GetValue(const ParametersType & parameters) const override
+  {
+    const double x = parameters[0] - 1.0;
+    const double y = parameters[1] + 0.5;
+    const double z = parameters[2] - 2.0;
+    return x * x + 2.0 * y * y + 3.0 * z * z + 0.5 * x * y;
+  }
+
+  void
+  GetDerivative(const ParametersType &, DerivativeType &) const override
+  {}
+
+  unsigned int
+  GetNumberOfParameters(void) const override
+  {
+    return 3;
+  }
+};
+
+} // end namespace CommonGTestUtilities
+} // end namespace elastix
+
+#endif // end #ifndef elxCommonGTestUtilities_h
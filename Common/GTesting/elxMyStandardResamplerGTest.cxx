@@ -0,0 +1,204 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "MyStandardResampler/elxMyStandardResampler.h"
+
+#include "elxElastixTemplate.h"
+
+#include "DeformationFieldTransform/itkDeformationFieldInterpolatingTransform.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+#include <itkImage.h>
+#include <itkResampleImageFilter.h>
+
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+typedef itk::Image<float, 2>                                           ImageType;
+typedef elastix::ElastixTemplate<ImageType, ImageType>                 ElastixType;
+typedef elastix::MyStandardResampler<ElastixType>                      ResamplerType;
+typedef ResamplerType::Superclass1                                     ResampleImageFilterType;
+typedef ResamplerType::TransformType                                   TransformType;
+typedef itk::AdvancedBSplineDeformableTransform<double, 2, 3>          BSplineTransformType;
+typedef itk::DeformationFieldInterpolatingTransform<double, 2, double> DeformationFieldTransformType;
+typedef DeformationFieldTransformType::DeformationFieldType            DeformationFieldType;
+
+/** A smooth input image of 32 x 24 pixels, with unit spacing. */
+ImageType::Pointer
+CreateInputImage(void)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 32, 24 } });
+  image->Allocate();
+
+  for (itk::ImageRegionIterator<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set(static_cast<float>(100.0 + 50.0 * std::sin(0.3 * index[0]) * std::cos(0.2 * index[1])));
+  }
+  return image;
+}
+
+
+/** A B-spline transform with random coefficients, of which the grid covers the output image. */
+BSplineTransformType::Pointer
+CreateBSplineTransform(void)
+{
+  BSplineTransformType::RegionType region;
+  region.SetSize(BSplineTransformType::RegionType::SizeType{ { 12, 10 } });
+  BSplineTransformType::SpacingType spacing;
+  spacing.Fill(4.0);
+  BSplineTransformType::OriginType origin;
+  origin.Fill(-8.0);
+  BSplineTransformType::DirectionType direction;
+  direction.SetIdentity();
+
+  const auto bsplineTransform = BSplineTransformType::New();
+  bsplineTransform->SetGridRegion(region);
+  bsplineTransform->SetGridSpacing(spacing);
+  bsplineTransform->SetGridOrigin(origin);
+  bsplineTransform->SetGridDirection(direction);
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-2.0, 2.0);
+  BSplineTransformType::ParametersType   parameters(bsplineTransform->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+  bsplineTransform->SetParametersByValue(parameters);
+  return bsplineTransform;
+}
+
+
+/** A transform with a random deformation field, which is linearly interpolated. The field covers
+ * only part of the output image, so that some of the points are not displaced.
+ */
+DeformationFieldTransformType::Pointer
+CreateDeformationFieldTransform(void)
+{
+  DeformationFieldType::SpacingType spacing;
+  spacing.Fill(2.0);
+  DeformationFieldType::PointType origin;
+  origin.Fill(-3.0);
+
+  const auto field = DeformationFieldType::New();
+  field->SetRegions(DeformationFieldType::SizeType{ { 14, 10 } });
+  field->SetSpacing(spacing);
+  field->SetOrigin(origin);
+  field->Allocate();
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-1.5, 1.5);
+  for (itk::ImageRegionIterator<DeformationFieldType> it(field, field->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    DeformationFieldType::PixelType displacement;
+    displacement[0] = distribution(randomNumberEngine);
+    displacement[1] = distribution(randomNumberEngine);
+    it.Set(displacement);
+  }
+
+  typedef DeformationFieldTransformType::LinearDeformationFieldInterpolatorType InterpolatorType;
+
+  const auto transform = DeformationFieldTransformType::New();
+  transform->SetDeformationField(field);
+  transform->SetDeformationFieldInterpolator(InterpolatorType::New());
+  return transform;
+}
+
+
+/** Resamples the input image by the transform, onto an output image that extends beyond the
+ * input image, so that some of the output pixels get the default value. The output spacing and
+ * origin are exactly representable, so that the points along a scanline are computed exactly.
+ */
+ImageType::Pointer
+Resample(ResampleImageFilterType & filter, TransformType * const transform)
+{
+  ResampleImageFilterType::SpacingType spacing;
+  spacing[0] = 0.75;
+  spacing[1] = 0.875;
+  ResampleImageFilterType::OriginPointType origin;
+  origin[0] = -2.5;
+  origin[1] = -1.75;
+
+  filter.SetInput(CreateInputImage());
+  filter.SetTransform(transform);
+  filter.SetSize(ResampleImageFilterType::SizeType{ { 40, 30 } });
+  filter.SetOutputSpacing(spacing);
+  filter.SetOutputOrigin(origin);
+  filter.SetDefaultPixelValue(-1.0f);
+  filter.SetNumberOfWorkUnits(3);
+  filter.Update();
+  return filter.GetOutput();
+}
+
+
+/** Expects the scanline resampling of the MyStandardResampler to equal the point by point
+ * resampling of the ResampleImageFilter.
+ */
+void
+ExpectResamplerEqualsResampleImageFilter(TransformType * const transform)
+{
+  const auto resampler = ResamplerType::New();
+  const auto resampleImageFilter = ResampleImageFilterType::New();
+
+  const ImageType::Pointer output = Resample(*resampler, transform);
+  const ImageType::Pointer expectedOutput = Resample(*resampleImageFilter, transform);
+  ASSERT_EQ(output->GetBufferedRegion(), expectedOutput->GetBufferedRegion());
+
+  unsigned int numberOfDefaultPixels = 0;
+  unsigned int numberOfPixels = 0;
+  for (itk::ImageRegionConstIterator<ImageType> it(output, output->GetBufferedRegion()),
+       expectedIt(expectedOutput, expectedOutput->GetBufferedRegion());
+       !it.IsAtEnd();
+       ++it, ++expectedIt)
+  {
+    EXPECT_NEAR(it.Get(), expectedIt.Get(), 1e-3) << "index " << it.GetIndex();
+    if (expectedIt.Get() == -1.0f)
+    {
+      ++numberOfDefaultPixels;
+    }
+    ++numberOfPixels;
+  }
+
+  /** Both the pixels inside and outside the input image are tested. */
+  EXPECT_GT(numberOfDefaultPixels, 0u);
+  EXPECT_LT(numberOfDefaultPixels, numberOfPixels);
+}
+
+} // namespace
+
+
+GTEST_TEST(MyStandardResampler, EqualsResampleImageFilterForBSplineTransform)
+{
+  ExpectResamplerEqualsResampleImageFilter(CreateBSplineTransform());
+}
+
+
+GTEST_TEST(MyStandardResampler, EqualsResampleImageFilterForDeformationFieldTransform)
+{
+  ExpectResamplerEqualsResampleImageFilter(CreateDeformationFieldTransform());
+}
@@ -0,0 +1,258 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkAdvancedCombinationTransform.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkAdvancedTranslationTransform.h"
+#include "itkImage.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+typedef itk::AdvancedCombinationTransform<double, 2>          CombinationTransformType;
+typedef itk::AdvancedMatrixOffsetTransformBase<double, 2, 2>  AffineTransformType;
+typedef itk::AdvancedTranslationTransform<double, 2>          TranslationTransformType;
+typedef itk::AdvancedBSplineDeformableTransform<double, 2, 3> BSplineTransformType;
+typedef itk::Image<float, 2>                                  GridType;
+typedef CombinationTransformType::InputPointType              PointType;
+
+AffineTransformType::Pointer
+CreateAffineTransform(void)
+{
+  AffineTransformType::MatrixType matrix;
+  matrix(0, 0) = 1.1;
+  matrix(0, 1) = 0.2;
+  matrix(1, 0) = -0.15;
+  matrix(1, 1) = 0.95;
+  AffineTransformType::OutputVectorType offset;
+  offset[0] = 3.0;
+  offset[1] = -4.5;
+
+  const auto affineTransform = AffineTransformType::New();
+  affineTransform->SetMatrix(matrix);
+  affineTransform->SetOffset(offset);
+  return affineTransform;
+}
+
+
+TranslationTransformType::Pointer
+CreateTranslationTransform(void)
+{
+  TranslationTransformType::OutputVectorType offset;
+  offset[0] = -1.25;
+  offset[1] = 2.0;
+
+  const auto translationTransform = TranslationTransformType::New();
+  translationTransform->SetOffset(offset);
+  return translationTransform;
+}
+
+
+BSplineTransformType::Pointer
+CreateBSplineTransform(void)
+{
+  BSplineTransformType::RegionType region;
+  region.SetSize(0, 10);
+  region.SetSize(1, 9);
+  BSplineTransformType::SpacingType spacing;
+  spacing.Fill(12.0);
+  BSplineTransformType::OriginType origin;
+  origin.Fill(-30.0);
+  BSplineTransformType::DirectionType direction;
+  direction.SetIdentity();
+
+  const auto bsplineTransform = BSplineTransformType::New();
+  bsplineTransform->SetGridRegion(region);
+  bsplineTransform->SetGridSpacing(spacing);
+  bsplineTransform->SetGridOrigin(origin);
+  bsplineTransform->SetGridDirection(direction);
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-2.0, 2.0);
+  BSplineTransformType::ParametersType   parameters(bsplineTransform->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+  bsplineTransform->SetParametersByValue(parameters);
+  return bsplineTransform;
+}
+
+} // namespace
+
+
+GTEST_TEST(AdvancedCombinationTransform, CacheOfLinearInitialTransformIsExact)
+{
+  /** The initial transform is itself a chain of two linear transforms. */
+  const auto initialTransform = CombinationTransformType::New();
+  initialTransform->SetInitialTransform(CreateAffineTransform());
+  initialTransform->SetCurrentTransform(CreateTranslationTransform());
+
+  const auto transform = CombinationTransformType::New();
+  transform->SetInitialTransform(initialTransform);
+  transform->SetCurrentTransform(CreateBSplineTransform());
+
+  /** A linear initial transform does not need a grid. */
+  transform->CacheInitialTransform(nullptr);
+  ASSERT_TRUE(transform->GetInitialTransformIsCached());
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-40.0, 60.0);
+  for (unsigned int i = 0; i < 100; ++i)
+  {
+    PointType point;
+    point[0] = distribution(randomNumberEngine);
+    point[1] = distribution(randomNumberEngine);
+
+    const PointType expectedPoint = initialTransform->TransformPoint(point);
+    const PointType mappedPoint = transform->GetCurrentTransform()->TransformPoint(expectedPoint);
+    const PointType cachedPoint = transform->TransformPoint(point);
+    EXPECT_NEAR(cachedPoint[0], mappedPoint[0], 1e-10);
+    EXPECT_NEAR(cachedPoint[1], mappedPoint[1], 1e-10);
+  }
+
+  transform->ClearInitialTransformCache();
+  EXPECT_FALSE(transform->GetInitialTransformIsCached());
+}
+
+
+GTEST_TEST(AdvancedCombinationTransform, CacheOfNonlinearInitialTransformIsExactAtGridPoints)
+{
+  /** The initial transform is a chain of an affine and a B-spline transform. */
+  const auto initialTransform = CombinationTransformType::New();
+  initialTransform->SetInitialTransform(CreateAffineTransform());
+  initialTransform->SetCurrentTransform(CreateBSplineTransform());
+
+  const auto transform = CombinationTransformType::New();
+  transform->SetInitialTransform(initialTransform);
+  transform->SetCurrentTransform(CreateTranslationTransform());
+
+  /** A rotated grid. */
+  GridType::DirectionType direction;
+  direction(0, 0) = std::cos(0.2);
+  direction(0, 1) = -std::sin(0.2);
+  direction(1, 0) = std::sin(0.2);
+  direction(1, 1) = std::cos(0.2);
+  GridType::SpacingType spacing;
+  spacing[0] = 2.5;
+  spacing[1] = 3.0;
+  GridType::PointType origin;
+  origin[0] = -5.0;
+  origin[1] = 1.0;
+  GridType::IndexType start;
+  start[0] = 2;
+  start[1] = -1;
+  GridType::SizeType size;
+  size[0] = 20;
+  size[1] = 15;
+
+  const auto grid = GridType::New();
+  grid->SetRegions(GridType::RegionType(start, size));
+  grid->SetSpacing(spacing);
+  grid->SetOrigin(origin);
+  grid->SetDirection(direction);
+
+  EXPECT_THROW(transform->CacheInitialTransform(nullptr), itk::ExceptionObject);
+  transform->CacheInitialTransform(grid);
+  ASSERT_TRUE(transform->GetInitialTransformIsCached());
+
+  /** At the grid points, the cache equals the initial transform itself. */
+  for (itk::IndexValueType y = start[1]; y < start[1] + static_cast<itk::IndexValueType>(size[1]); ++y)
+  {
+    for (itk::IndexValueType x = start[0]; x < start[0] + static_cast<itk::IndexValueType>(size[0]); ++x)
+    {
+      GridType::IndexType index;
+      index[0] = x;
+      index[1] = y;
+      PointType point;
+      grid->TransformIndexToPhysicalPoint(index, point);
+
+      const PointType expectedPoint =
+        transform->GetCurrentTransform()->TransformPoint(initialTransform->TransformPoint(point));
+      const PointType cachedPoint = transform->TransformPoint(point);
+      EXPECT_NEAR(cachedPoint[0], expectedPoint[0], 1e-10);
+      EXPECT_NEAR(cachedPoint[1], expectedPoint[1], 1e-10);
+    }
+  }
+
+  /** Outside the grid, the initial transform itself is evaluated. */
+  GridType::IndexType outsideIndex;
+  outsideIndex[0] = start[0] - 1;
+  outsideIndex[1] = start[1] + 3;
+  PointType outsidePoint;
+  grid->TransformIndexToPhysicalPoint(outsideIndex, outsidePoint);
+  const PointType expectedPoint =
+    transform->GetCurrentTransform()->TransformPoint(initialTransform->TransformPoint(outsidePoint));
+  EXPECT_EQ(transform->TransformPoint(outsidePoint), expectedPoint);
+
+  /** Setting another initial transform removes the cache. */
+  transform->SetInitialTransform(CreateAffineTransform());
+  EXPECT_FALSE(transform->GetInitialTransformIsCached());
+}
+
+
+GTEST_TEST(AdvancedCombinationTransform, TransformCoordinateArraysEqualsTransformPoint)
+{
+  /** An affine transform (with its own override), a B-spline transform (default
+   * implementation), and a composition of both.
+   */
+  const auto affineTransform = CombinationTransformType::New();
+  affineTransform->SetCurrentTransform(CreateAffineTransform());
+  const auto bsplineTransform = CombinationTransformType::New();
+  bsplineTransform->SetCurrentTransform(CreateBSplineTransform());
+  const auto composedTransform = CombinationTransformType::New();
+  composedTransform->SetInitialTransform(CreateAffineTransform());
+  composedTransform->SetCurrentTransform(CreateBSplineTransform());
+
+  /** More points than the chunk size of the default implementation. */
+  const unsigned int                     numberOfPoints = 150;
+  std::vector<double>                    coordinates(2 * numberOfPoints);
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-20.0, 50.0);
+  for (auto & coordinate : coordinates)
+  {
+    coordinate = distribution(randomNumberEngine);
+  }
+  const double * const coordinateArrays[] = { coordinates.data(), coordinates.data() + numberOfPoints };
+
+  for (const CombinationTransformType * const transform :
+       { affineTransform.GetPointer(), bsplineTransform.GetPointer(), composedTransform.GetPointer() })
+  {
+    std::vector<PointType> mappedPoints(numberOfPoints);
+    transform->TransformCoordinateArrays(coordinateArrays, mappedPoints.data(), numberOfPoints);
+
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
+    {
+      PointType point;
+      point[0] = coordinates[i];
+      point[1] = coordinates[numberOfPoints + i];
+      const PointType expectedPoint = transform->TransformPoint(point);
+      EXPECT_NEAR(mappedPoints[i][0], expectedPoint[0], 1e-10);
+      EXPECT_NEAR(mappedPoints[i][1], expectedPoint[1], 1e-10);
+    }
+  }
+}
@@ -0,0 +1,157 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+
+#include "itkAdvancedEuler3DTransform.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+/** Checks that the batched Jacobian image gradient products of a transform equal the
+ * products of the Jacobian of each individual point, for points that are near to the
+ * center of rotation and for points that are far away from it.
+ */
+template <class TTransform>
+void
+ExpectBatchedProductsEqualProductsPerPoint(const TTransform & transform)
+{
+  typedef typename TTransform::InputPointType             InputPointType;
+  typedef typename TTransform::MovingImageGradientType    MovingImageGradientType;
+  typedef typename TTransform::DerivativeType             DerivativeType;
+  typedef typename TTransform::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+  typedef typename TTransform::NonZeroJacobianIndexType   NonZeroJacobianIndexType;
+  typedef typename TTransform::ParametersValueType        ParametersValueType;
+
+  const unsigned int Dimension = TTransform::InputSpaceDimension;
+
+  const InputPointType center = transform.GetCenter();
+  const unsigned int   nnzji = transform.GetNumberOfNonZeroJacobianIndices();
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> gradientDistribution(-100.0, 100.0);
+  for (const double distance : { 1.0, 50.0, 1e4 })
+  {
+    SCOPED_TRACE(distance);
+
+    std::uniform_real_distribution<double> offsetDistribution(-distance, distance);
+    const unsigned int                     numberOfPoints = 100;
+    std::vector<InputPointType>            points(numberOfPoints);
+    std::vector<MovingImageGradientType>   movingImageGradients(numberOfPoints);
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
+    {
+      for (unsigned int d = 0; d < Dimension; ++d)
+      {
+        points[i][d] = center[d] + offsetDistribution(randomNumberEngine);
+        movingImageGradients[i][d] = gradientDistribution(randomNumberEngine);
+      }
+    }
+
+    std::vector<ParametersValueType>      imageJacobians(numberOfPoints * nnzji);
+    std::vector<NonZeroJacobianIndexType> nonZeroJacobianIndices(numberOfPoints * nnzji);
+    transform.EvaluateJacobianWithImageGradientProducts(
+      points.data(), movingImageGradients.data(), numberOfPoints, imageJacobians.data(), nonZeroJacobianIndices.data());
+
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
+    {
+      DerivativeType             expectedImageJacobian(nnzji);
+      NonZeroJacobianIndicesType expectedNonZeroJacobianIndices;
+      transform.EvaluateJacobianWithImageGradientProduct(
+        points[i], movingImageGradients[i], expectedImageJacobian, expectedNonZeroJacobianIndices);
+      ASSERT_EQ(expectedNonZeroJacobianIndices.size(), nnzji);
+
+      /** The batched version sums the terms of J(c) and of (p-c)_d * ( J(c + e_d) - J(c) ) instead,
+       * so it may differ by a few units of rounding of the largest term.
+       */
+      double gradientNorm = 0.0;
+      double distanceToCenter = 0.0;
+      for (unsigned int d = 0; d < Dimension; ++d)
+      {
+        gradientNorm += std::abs(movingImageGradients[i][d]);
+        distanceToCenter += std::abs(points[i][d] - center[d]);
+      }
+      const double tolerance = 1e-13 * (1.0 + distanceToCenter) * gradientNorm;
+
+      for (unsigned int k = 0; k < nnzji; ++k)
+      {
+        EXPECT_EQ(nonZeroJacobianIndices[i * nnzji + k], expectedNonZeroJacobianIndices[k]);
+        EXPECT_NEAR(imageJacobians[i * nnzji + k], expectedImageJacobian[k], tolerance);
+      }
+    }
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(AdvancedMatrixOffsetTransformBase, BatchedJacobianImageGradientProductsOfAffine)
+{
+  typedef itk::AdvancedMatrixOffsetTransformBase<double, 2, 2> TransformType;
+
+  TransformType::MatrixType matrix;
+  matrix(0, 0) = 1.1;
+  matrix(0, 1) = 0.2;
+  matrix(1, 0) = -0.15;
+  matrix(1, 1) = 0.95;
+  TransformType::OutputVectorType translation;
+  translation[0] = 3.0;
+  translation[1] = -4.5;
+  TransformType::InputPointType center;
+  center[0] = 12.3;
+  center[1] = -7.7;
+
+  const auto transform = TransformType::New();
+  transform->SetCenter(center);
+  transform->SetMatrix(matrix);
+  transform->SetTranslation(translation);
+  ExpectBatchedProductsEqualProductsPerPoint(*transform);
+}
+
+
+GTEST_TEST(AdvancedMatrixOffsetTransformBase, BatchedJacobianImageGradientProductsOfEuler3D)
+{
+  /** The Jacobian of the Euler transform depends nonlinearly on its parameters, but
+   * still linearly on the point.
+   */
+  typedef itk::AdvancedEuler3DTransform<double> TransformType;
+
+  TransformType::InputPointType center;
+  center[0] = 40.1;
+  center[1] = -22.6;
+  center[2] = 5.3;
+  TransformType::ParametersType parameters(6);
+  parameters[0] = 0.1;
+  parameters[1] = -0.25;
+  parameters[2] = 0.4;
+  parameters[3] = 2.0;
+  parameters[4] = -1.5;
+  parameters[5] = 7.0;
+
+  const auto transform = TransformType::New();
+  transform->SetCenter(center);
+  transform->SetParameters(parameters);
+  ExpectBatchedProductsEqualProductsPerPoint(*transform);
+}
@@ -0,0 +1,148 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+
+#include "elxCommonGTestUtilities.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using namespace elastix::CommonGTestUtilities;
+
+typedef itk::AdvancedMeanSquaresImageToImageMetric<MetricTestImageType, MetricTestImageType> MetricType;
+
+
+/** Creates mean squares of the test images, multi-threaded with the given number of work
+ * units, either with the PlatformMultiThreader or with the work-stealing thread pool.
+ */
+MetricType::Pointer
+CreateMetric(const bool                       useThreadPool,
+             const itk::ThreadIdType          numberOfWorkUnits,
+             MetricTestBSplineTransformType & transform)
+{
+  const auto metric = MetricType::New();
+  metric->SetUseMultiThread(true);
+  metric->SetUseThreadPool(useThreadPool);
+  metric->SetNumberOfWorkUnits(numberOfWorkUnits);
+  InitializeMetric(*metric, *CreateSmoothImage(0.0), *CreateSmoothImage(1.5), transform);
+  return metric;
+}
+
+} // namespace
+
+
+GTEST_TEST(AdvancedMeanSquaresImageToImageMetric, ThreadPoolEqualsPlatformMultiThreader)
+{
+  const auto transform = CreateBSplineTransform(1.5);
+
+  for (const itk::ThreadIdType numberOfWorkUnits : { 1, 3, 4 })
+  {
+    SCOPED_TRACE(numberOfWorkUnits);
+
+    MetricType::MeasureType    expectedValue;
+    MetricType::DerivativeType expectedDerivative;
+    const auto                 expectedMetric = CreateMetric(false, numberOfWorkUnits, *transform);
+    expectedMetric->GetValueAndDerivative(transform->GetParameters(), expectedValue, expectedDerivative);
+    ASSERT_GT(expectedDerivative.inf_norm(), 0.0);
+
+    /** The pool divides the samples in other chunks, so the terms are summed in another order.
+     * A second evaluation reuses the threads and the per-thread variables of the first one.
+     */
+    const auto metric = CreateMetric(true, numberOfWorkUnits, *transform);
+    for (unsigned int evaluation = 0; evaluation < 2; ++evaluation)
+    {
+      MetricType::MeasureType    value;
+      MetricType::DerivativeType derivative;
+      metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+
+      EXPECT_NEAR(value, expectedValue, 1e-12 * std::abs(expectedValue));
+      ASSERT_EQ(derivative.GetSize(), expectedDerivative.GetSize());
+      for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+      {
+        EXPECT_NEAR(derivative[i], expectedDerivative[i], 1e-12 * expectedDerivative.inf_norm());
+      }
+
+      EXPECT_NEAR(metric->GetValue(transform->GetParameters()), expectedValue, 1e-12 * std::abs(expectedValue));
+    }
+  }
+}
+
+
+GTEST_TEST(AdvancedMeanSquaresImageToImageMetric, ThreadPoolGivesTheSameResultEachTime)
+{
+  const auto transform = CreateBSplineTransform(1.5);
+  const auto metric = CreateMetric(true, 4, *transform);
+
+  MetricType::MeasureType    expectedValue;
+  MetricType::DerivativeType expectedDerivative;
+  metric->GetValueAndDerivative(transform->GetParameters(), expectedValue, expectedDerivative);
+  const MetricType::MeasureType expectedGetValue = metric->GetValue(transform->GetParameters());
+
+  /** Which thread takes which chunk of samples differs between the evaluations,
+   * but the terms are summed in the order of the chunks.
+   */
+  for (unsigned int evaluation = 0; evaluation < 10; ++evaluation)
+  {
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+    EXPECT_EQ(value, expectedValue);
+    EXPECT_EQ(derivative, expectedDerivative);
+    EXPECT_EQ(metric->GetValue(transform->GetParameters()), expectedGetValue);
+  }
+}
+
+
+GTEST_TEST(AdvancedMeanSquaresImageToImageMetric, EvaluationAfterTooFewValidSamplesEqualsFirstEvaluation)
+{
+  const auto transform = CreateBSplineTransform(1.5);
+
+  for (const bool useThreadPool : { false, true })
+  {
+    SCOPED_TRACE(useThreadPool);
+
+    const auto                 metric = CreateMetric(useThreadPool, 3, *transform);
+    const double               requiredRatioOfValidSamples = metric->GetRequiredRatioOfValidSamples();
+    MetricType::MeasureType    expectedValue;
+    MetricType::DerivativeType expectedDerivative;
+    metric->GetValueAndDerivative(transform->GetParameters(), expectedValue, expectedDerivative);
+
+    /** With a required ratio above one, each evaluation throws after the threads have
+     * summed their terms. The next evaluation should not include these sums.
+     */
+    metric->SetRequiredRatioOfValidSamples(1.5);
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    EXPECT_THROW(metric->GetValue(transform->GetParameters()), itk::ExceptionObject);
+    EXPECT_THROW(metric->GetValueAndDerivative(transform->GetParameters(), value, derivative), itk::ExceptionObject);
+    metric->SetRequiredRatioOfValidSamples(requiredRatioOfValidSamples);
+
+    metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+    EXPECT_NEAR(value, expectedValue, 1e-12 * std::abs(expectedValue));
+    ASSERT_EQ(derivative.GetSize(), expectedDerivative.GetSize());
+    for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+    {
+      EXPECT_NEAR(derivative[i], expectedDerivative[i], 1e-12 * expectedDerivative.inf_norm());
+    }
+    EXPECT_NEAR(metric->GetValue(transform->GetParameters()), expectedValue, 1e-12 * std::abs(expectedValue));
+  }
+}
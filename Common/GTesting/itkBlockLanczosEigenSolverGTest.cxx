@@ -0,0 +1,124 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+// First include the header file to be tested:
+#include "itkBlockLanczosEigenSolver.h"
+
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+typedef itk::BlockLanczosEigenSolver<double> SolverType;
+typedef SolverType::MatrixType                    MatrixType;
+
+/** A random correlation-like matrix: a few strong components plus noise, like the PCAMetric's K. */
+MatrixType
+Create_random_symmetric_matrix(const unsigned int dimension, const unsigned int seed)
+{
+  std::mt19937                     generator(seed);
+  std::normal_distribution<double> distribution(0.0, 1.0);
+
+  MatrixType A(3 * dimension, dimension);
+  for (unsigned int i = 0; i < A.rows(); ++i)
+  {
+    const double common = distribution(generator);
+    for (unsigned int j = 0; j < dimension; ++j)
+    {
+      A(i, j) = (4.0 - 0.3 * (j % 5)) * common + distribution(generator) + 0.5 * (j < 3 ? A(i, 0) : 0.0);
+    }
+  }
+  return A.transpose() * A / static_cast<double>(A.rows());
+}
+
+
+void
+Expect_equal_to_full_decomposition(const SolverType & solver, const MatrixType & K, const unsigned int m)
+{
+  const unsigned int                      n = K.rows();
+  const vnl_symmetric_eigensystem<double> eig(K);
+
+  ASSERT_EQ(solver.GetEigenValues().size(), m);
+  ASSERT_EQ(solver.GetEigenVectors().cols(), m);
+  for (unsigned int i = 0; i < m; ++i)
+  {
+    EXPECT_NEAR(solver.GetEigenValues()[i], eig.get_eigenvalue(n - 1 - i), 1e-8 * eig.get_eigenvalue(n - 1));
+
+    /** Eigenvectors are equal up to their sign. */
+    const double inner = dot_product(solver.GetEigenVectors().get_column(i), eig.get_eigenvector(n - 1 - i));
+    EXPECT_NEAR(std::abs(inner), 1.0, 1e-6);
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(BlockLanczosEigenSolver, FirstCallUsesFullDecomposition)
+{
+  const MatrixType K = Create_random_symmetric_matrix(40, 1);
+  SolverType       solver;
+
+  EXPECT_FALSE(solver.Compute(K, 6));
+  Expect_equal_to_full_decomposition(solver, K, 6);
+}
+
+
+GTEST_TEST(BlockLanczosEigenSolver, WarmStartConvergesForSlowlyChangingMatrix)
+{
+  const unsigned int n = 60;
+  const unsigned int m = 6;
+  const MatrixType   K0 = Create_random_symmetric_matrix(n, 2);
+  const MatrixType   perturbation = Create_random_symmetric_matrix(n, 3);
+
+  SolverType solver;
+  solver.Compute(K0, m);
+
+  /** Mimic small optimizer steps. */
+  for (unsigned int step = 1; step <= 5; ++step)
+  {
+    const MatrixType K = K0 + perturbation * (1e-3 * step);
+    EXPECT_TRUE(solver.Compute(K, m));
+    EXPECT_LE(solver.GetNumberOfIterations(), solver.GetMaximumNumberOfIterations());
+    Expect_equal_to_full_decomposition(solver, K, m);
+  }
+}
+
+
+GTEST_TEST(BlockLanczosEigenSolver, FallsBackWhenWarmStartDoesNotConverge)
+{
+  const MatrixType K0 = Create_random_symmetric_matrix(30, 4);
+  const MatrixType K1 = Create_random_symmetric_matrix(30, 5);
+
+  SolverType solver;
+  solver.SetMaximumNumberOfIterations(1);
+  solver.Compute(K0, 4);
+
+  /** An unrelated matrix cannot converge in a single iteration. */
+  EXPECT_FALSE(solver.Compute(K1, 4));
+  Expect_equal_to_full_decomposition(solver, K1, 4);
+
+  /** A changed number of eigenvalues, or a reset, also triggers the full decomposition. */
+  EXPECT_FALSE(solver.Compute(K1, 5));
+  Expect_equal_to_full_decomposition(solver, K1, 5);
+  solver.Reset();
+  EXPECT_FALSE(solver.Compute(K1, 5));
+}
@@ -0,0 +1,86 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "CMAEvolutionStrategy/itkCMAEvolutionStrategyOptimizer.h"
+
+#include "elxCommonGTestUtilities.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <gtest/gtest.h>
+
+using itk::CMAEvolutionStrategyOptimizer;
+using elastix::CommonGTestUtilities::QuadraticCostFunction;
+
+namespace
+{
+/** The result of an optimization. */
+struct Result
+{
+  CMAEvolutionStrategyOptimizer::ParametersType position;
+  CMAEvolutionStrategyOptimizer::MeasureType    value;
+  unsigned long                                 numberOfIterations;
+};
+
+
+/** Runs the optimizer with the given number of worker cost functions; zero means a serial evaluation. */
+Result
+Optimize(const unsigned int numberOfWorkers)
+{
+  itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()->SetSeed(1234);
+
+  CMAEvolutionStrategyOptimizer::ParametersType initialPosition(3);
+  initialPosition.Fill(0.0);
+
+  const auto optimizer = CMAEvolutionStrategyOptimizer::New();
+  optimizer->SetCostFunction(QuadraticCostFunction::New());
+  optimizer->SetInitialPosition(initialPosition);
+  optimizer->SetMaximumNumberOfIterations(40);
+  optimizer->SetPopulationSize(10);
+  optimizer->SetInitialSigma(1.0);
+
+  CMAEvolutionStrategyOptimizer::CostFunctionContainerType workerCostFunctions;
+  for (unsigned int i = 0; i < numberOfWorkers; ++i)
+  {
+    workerCostFunctions.push_back(QuadraticCostFunction::New().GetPointer());
+  }
+  optimizer->SetWorkerCostFunctions(workerCostFunctions);
+  optimizer->SetEvaluatePopulationInParallel(numberOfWorkers > 0);
+  optimizer->StartOptimization();
+
+  return { optimizer->GetCurrentPosition(), optimizer->GetCurrentValue(), optimizer->GetCurrentIteration() };
+}
+
+} // namespace
+
+
+GTEST_TEST(CMAEvolutionStrategyOptimizer, ParallelEqualsSerial)
+{
+  const Result serial = Optimize(0);
+  EXPECT_LT(serial.value, 0.1);
+
+  /** The offspring is drawn before it is evaluated, so the number of workers does not matter. */
+  for (const unsigned int numberOfWorkers : { 1u, 3u, 10u, 16u })
+  {
+    const Result parallel = Optimize(numberOfWorkers);
+    EXPECT_EQ(parallel.position, serial.position);
+    EXPECT_EQ(parallel.value, serial.value);
+    EXPECT_EQ(parallel.numberOfIterations, serial.numberOfIterations);
+  }
+}
@@ -0,0 +1,246 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkComputeJacobianTerms.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImage.h"
+
+#include <atomic>
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+/** The four terms of ComputeJacobianTerms::Compute(). */
+struct JacobianTerms
+{
+  double TrC;
+  double TrCC;
+  double maxJJ;
+  double maxJCJ;
+};
+
+
+/** A B-spline transform with random coefficients, of which the grid covers an image of the given size. */
+template <unsigned int VDimension,
+          class TBSplineTransform = itk::AdvancedBSplineDeformableTransform<double, VDimension, 3>>
+typename TBSplineTransform::Pointer
+CreateBSplineTransform(const typename itk::Image<float, VDimension>::SizeType & imageSize)
+{
+  typedef TBSplineTransform BSplineTransformType;
+
+  typename BSplineTransformType::RegionType region;
+  for (unsigned int d = 0; d < VDimension; ++d)
+  {
+    region.SetSize(d, imageSize[d] / 8 + 5);
+  }
+  typename BSplineTransformType::SpacingType spacing;
+  spacing.Fill(8.0);
+  typename BSplineTransformType::OriginType origin;
+  origin.Fill(-12.0);
+  typename BSplineTransformType::DirectionType direction;
+  direction.SetIdentity();
+
+  const auto bsplineTransform = BSplineTransformType::New();
+  bsplineTransform->SetGridRegion(region);
+  bsplineTransform->SetGridSpacing(spacing);
+  bsplineTransform->SetGridOrigin(origin);
+  bsplineTransform->SetGridDirection(direction);
+
+  std::mt19937                                  randomNumberEngine;
+  std::uniform_real_distribution<double>        distribution(-2.0, 2.0);
+  typename BSplineTransformType::ParametersType parameters(bsplineTransform->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+  bsplineTransform->SetParametersByValue(parameters);
+  return bsplineTransform;
+}
+
+
+/** A 2D B-spline transform of which GetJacobian() throws an exception from the given call on. */
+class ThrowingBSplineTransform : public itk::AdvancedBSplineDeformableTransform<double, 2, 3>
+{
+public:
+  typedef ThrowingBSplineTransform                              Self;
+  typedef itk::AdvancedBSplineDeformableTransform<double, 2, 3> Superclass;
+  typedef itk::SmartPointer<Self>                               Pointer;
+
+  itkNewMacro(Self);
+
+  void
+  GetJacobian(const InputPointType & ipp, JacobianType & j, NonZeroJacobianIndicesType & nzji) const override
+  {
+    if (++m_NumberOfCalls > m_NumberOfCallsBeforeThrowing)
+    {
+      itkExceptionMacro("GetJacobian() throws, as requested by the test.");
+    }
+    Superclass::GetJacobian(ipp, j, nzji);
+  }
+
+  unsigned int m_NumberOfCallsBeforeThrowing{ 0 };
+
+private:
+  mutable std::atomic<unsigned int> m_NumberOfCalls{ 0 };
+};
+
+
+/** Computes the Jacobian terms of a B-spline transform on an image of the given size, with
+ * the given threading, and with a small band, so that both the band and the sparse part of
+ * the covariance matrix are used.
+ */
+template <unsigned int VDimension>
+JacobianTerms
+Compute(const typename itk::Image<float, VDimension>::SizeType & imageSize,
+        const itk::SizeValueType                                 numberOfJacobianMeasurements,
+        const bool                                               useMultiThread,
+        const itk::ThreadIdType                                  numberOfWorkUnits)
+{
+  typedef itk::Image<float, VDimension>                                  ImageType;
+  typedef itk::AdvancedBSplineDeformableTransform<double, VDimension, 3> BSplineTransformType;
+  typedef itk::ComputeJacobianTerms<ImageType, BSplineTransformType>     ComputeJacobianTermsType;
+
+  const auto image = ImageType::New();
+  image->SetRegions(imageSize);
+  image->Allocate(true);
+
+  const auto computeJacobianTerms = ComputeJacobianTermsType::New();
+  computeJacobianTerms->SetFixedImage(image);
+  computeJacobianTerms->SetFixedImageRegion(image->GetBufferedRegion());
+  computeJacobianTerms->SetTransform(CreateBSplineTransform<VDimension>(imageSize));
+  computeJacobianTerms->SetMaxBandCovSize(20);
+  computeJacobianTerms->SetNumberOfBandStructureSamples(10);
+  computeJacobianTerms->SetNumberOfJacobianMeasurements(numberOfJacobianMeasurements);
+  computeJacobianTerms->SetUseScales(false);
+  computeJacobianTerms->SetUseMultiThread(useMultiThread);
+  computeJacobianTerms->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+  JacobianTerms terms;
+  computeJacobianTerms->Compute(terms.TrC, terms.TrCC, terms.maxJJ, terms.maxJCJ);
+  return terms;
+}
+
+
+/** Checks that the multi-threaded computation gives exactly the terms of the serial one,
+ * for several numbers of threads.
+ */
+template <unsigned int VDimension>
+void
+ExpectMultiThreadedEqualsSerial(const typename itk::Image<float, VDimension>::SizeType & imageSize,
+                                const itk::SizeValueType                                 numberOfJacobianMeasurements)
+{
+  const JacobianTerms serial = Compute<VDimension>(imageSize, numberOfJacobianMeasurements, false, 1);
+  EXPECT_GT(serial.TrC, 0.0);
+  EXPECT_GT(serial.TrCC, 0.0);
+  EXPECT_GT(serial.maxJJ, 0.0);
+  EXPECT_GT(serial.maxJCJ, 0.0);
+
+  /** The chunks of samples are added to the covariance matrix in the same order, whatever the
+   * number of threads, and the maxima do not depend on the order of the samples.
+   */
+  for (const itk::ThreadIdType numberOfWorkUnits : { 1u, 3u, 8u })
+  {
+    SCOPED_TRACE(numberOfWorkUnits);
+
+    const JacobianTerms multiThreaded =
+      Compute<VDimension>(imageSize, numberOfJacobianMeasurements, true, numberOfWorkUnits);
+    EXPECT_EQ(multiThreaded.TrC, serial.TrC);
+    EXPECT_EQ(multiThreaded.TrCC, serial.TrCC);
+    EXPECT_EQ(multiThreaded.maxJJ, serial.maxJJ);
+    EXPECT_EQ(multiThreaded.maxJCJ, serial.maxJCJ);
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(ComputeJacobianTerms, MultiThreadedEqualsSerial2D)
+{
+  /** The chunks of the 2D transform have the maximum number of samples, so there are only a few. */
+  ExpectMultiThreadedEqualsSerial<2>(itk::Size<2>{ { 60, 50 } }, 1000);
+}
+
+
+GTEST_TEST(ComputeJacobianTerms, MultiThreadedEqualsSerial3D)
+{
+  /** The sums of J^T J of the 3D transform are much larger, so there are many small chunks. */
+  ExpectMultiThreadedEqualsSerial<3>(itk::Size<3>{ { 30, 26, 20 } }, 800);
+}
+
+
+GTEST_TEST(ComputeJacobianTerms, MultiThreadedIsReproducible)
+{
+  /** The chunks are added in a fixed order, so repeated computations give exactly the same terms. */
+  const itk::Size<2>  imageSize{ { 60, 50 } };
+  const JacobianTerms first = Compute<2>(imageSize, 1000, true, 8);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    const JacobianTerms next = Compute<2>(imageSize, 1000, true, 8);
+    EXPECT_EQ(next.TrC, first.TrC);
+    EXPECT_EQ(next.TrCC, first.TrCC);
+    EXPECT_EQ(next.maxJJ, first.maxJJ);
+    EXPECT_EQ(next.maxJCJ, first.maxJCJ);
+  }
+}
+
+
+GTEST_TEST(ComputeJacobianTerms, MultiThreadedRethrowsExceptionOfChunk)
+{
+  /** The threads of the next chunks wait for the chunk that throws, so the exception must not
+   * keep them waiting, and it is rethrown when all threads are done.
+   */
+  typedef itk::Image<float, 2>                                           ImageType;
+  typedef itk::ComputeJacobianTerms<ImageType, ThrowingBSplineTransform> ComputeJacobianTermsType;
+
+  const itk::Size<2> imageSize{ { 60, 50 } };
+  const auto         image = ImageType::New();
+  image->SetRegions(imageSize);
+  image->Allocate(true);
+
+  for (const bool useMultiThread : { false, true })
+  {
+    SCOPED_TRACE(useMultiThread);
+
+    /** The covariance computation asks for the Jacobian of the 1000 samples, after the few
+     * samples of the band structure, so it throws halfway.
+     */
+    const auto bsplineTransform = CreateBSplineTransform<2, ThrowingBSplineTransform>(imageSize);
+    bsplineTransform->m_NumberOfCallsBeforeThrowing = 500;
+
+    const auto computeJacobianTerms = ComputeJacobianTermsType::New();
+    computeJacobianTerms->SetFixedImage(image);
+    computeJacobianTerms->SetFixedImageRegion(image->GetBufferedRegion());
+    computeJacobianTerms->SetTransform(bsplineTransform);
+    computeJacobianTerms->SetMaxBandCovSize(20);
+    computeJacobianTerms->SetNumberOfBandStructureSamples(10);
+    computeJacobianTerms->SetNumberOfJacobianMeasurements(1000);
+    computeJacobianTerms->SetUseScales(false);
+    computeJacobianTerms->SetUseMultiThread(useMultiThread);
+    computeJacobianTerms->SetNumberOfWorkUnits(8);
+
+    JacobianTerms terms;
+    EXPECT_THROW(computeJacobianTerms->Compute(terms.TrC, terms.TrCC, terms.maxJJ, terms.maxJCJ),
+                 itk::ExceptionObject);
+  }
+}
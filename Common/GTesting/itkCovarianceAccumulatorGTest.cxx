@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+// First include the header file to be tested:
+#include "itkCovarianceAccumulator.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+typedef itk::CovarianceAccumulator<double> AccumulatorType;
+typedef AccumulatorType::MatrixType        MatrixType;
+
+MatrixType
+Create_random_samples(const unsigned int numberOfSamples, const unsigned int dimension)
+{
+  std::mt19937                     generator(1);
+  std::normal_distribution<double> distribution(100.0, 3.0);
+
+  MatrixType samples(numberOfSamples, dimension);
+  for (unsigned int i = 0; i < numberOfSamples; ++i)
+  {
+    for (unsigned int j = 0; j < dimension; ++j)
+    {
+      samples(i, j) = distribution(generator) + 0.5 * j * samples(i, 0);
+    }
+  }
+  return samples;
+}
+
+} // namespace
+
+
+GTEST_TEST(CovarianceAccumulator, MergedPartsEqualDirectComputation)
+{
+  const unsigned int numberOfSamples = 1000;
+  const unsigned int dimension = 7;
+  const MatrixType   samples = Create_random_samples(numberOfSamples, dimension);
+
+  /** Direct two-pass computation. */
+  AccumulatorType::VectorType mean(dimension);
+  mean.fill(0.0);
+  for (unsigned int i = 0; i < numberOfSamples; ++i)
+  {
+    for (unsigned int j = 0; j < dimension; ++j)
+    {
+      mean[j] += samples(i, j) / numberOfSamples;
+    }
+  }
+  MatrixType covariance(dimension, dimension);
+  covariance.fill(0.0);
+  for (unsigned int i = 0; i < numberOfSamples; ++i)
+  {
+    for (unsigned int j = 0; j < dimension; ++j)
+    {
+      for (unsigned int k = 0; k < dimension; ++k)
+      {
+        covariance(j, k) += (samples(i, j) - mean[j]) * (samples(i, k) - mean[k]) / (numberOfSamples - 1.0);
+      }
+    }
+  }
+
+  /** Uneven, and empty, parts as produced by the threads of a metric. */
+  const unsigned int           bounds[] = { 0, 1, 1, 333, 800, 1000 };
+  std::vector<AccumulatorType> parts(5);
+  for (unsigned int p = 0; p < parts.size(); ++p)
+  {
+    parts[p].Initialize(dimension);
+    parts[p].AddRows(samples, bounds[p], bounds[p + 1]);
+  }
+  AccumulatorType total;
+  total.Initialize(dimension);
+  for (const auto & part : parts)
+  {
+    total.Merge(part);
+  }
+
+  ASSERT_EQ(total.GetNumberOfSamples(), numberOfSamples);
+  const MatrixType result = total.GetCovarianceMatrix();
+  for (unsigned int j = 0; j < dimension; ++j)
+  {
+    EXPECT_NEAR(total.GetMean()[j], mean[j], 1e-9 * std::abs(mean[j]));
+    for (unsigned int k = 0; k < dimension; ++k)
+    {
+      EXPECT_NEAR(result(j, k), covariance(j, k), 1e-9 * std::abs(covariance(j, j)));
+      EXPECT_EQ(result(j, k), result(k, j));
+    }
+  }
+}
@@ -0,0 +1,134 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "DeformationFieldTransform/itkDeformationFieldInterpolatingTransform.h"
+
+#include "itkImageRegionIterator.h"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+typedef itk::DeformationFieldInterpolatingTransform<double, 2, double> TransformType;
+typedef TransformType::DeformationFieldType                            DeformationFieldType;
+typedef TransformType::InputPointType                                  InputPointType;
+typedef TransformType::OutputPointType                                 OutputPointType;
+
+/** A deformation field with 10 x 8 pixels at x = 1, 1.5, ..., 5.5 and y = -2, -1.5, ..., 1.5.
+ * The displacements are multiples of 1/8, so that all computations below are exact.
+ */
+DeformationFieldType::Pointer
+CreateDeformationField(void)
+{
+  DeformationFieldType::SpacingType spacing;
+  spacing.Fill(0.5);
+  DeformationFieldType::PointType origin;
+  origin[0] = 1.0;
+  origin[1] = -2.0;
+
+  const auto field = DeformationFieldType::New();
+  field->SetRegions(DeformationFieldType::SizeType{ { 10, 8 } });
+  field->SetSpacing(spacing);
+  field->SetOrigin(origin);
+  field->Allocate();
+
+  std::mt19937                       randomNumberEngine;
+  std::uniform_int_distribution<int> distribution(-16, 16);
+  for (itk::ImageRegionIterator<DeformationFieldType> it(field, field->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    DeformationFieldType::PixelType displacement;
+    displacement[0] = distribution(randomNumberEngine) / 8.0;
+    displacement[1] = distribution(randomNumberEngine) / 8.0;
+    it.Set(displacement);
+  }
+  return field;
+}
+
+
+/** Points on a grid with a step of 1/16, which covers the deformation field and a margin around
+ * it. So there are points at the border of the field, points at half-integer continuous indices,
+ * and points outside the buffer. The number of points is not a multiple of the chunk size.
+ */
+std::vector<InputPointType>
+CreatePoints(void)
+{
+  std::vector<InputPointType> points;
+  for (int y = -40; y <= 32; ++y)
+  {
+    for (int x = 8; x <= 96; ++x)
+    {
+      InputPointType point;
+      point[0] = x / 16.0;
+      point[1] = y / 16.0;
+      points.push_back(point);
+    }
+  }
+  return points;
+}
+
+
+void
+ExpectTransformPointsEqualsTransformPoint(TransformType::DeformationFieldInterpolatorType * const interpolator)
+{
+  const auto transform = TransformType::New();
+  transform->SetDeformationField(CreateDeformationField());
+  transform->SetDeformationFieldInterpolator(interpolator);
+
+  const std::vector<InputPointType> points = CreatePoints();
+  std::vector<OutputPointType>      outputPoints(points.size());
+  transform->TransformPoints(points.data(), outputPoints.data(), points.size());
+
+  unsigned int numberOfMovedPoints = 0;
+  for (std::size_t k = 0; k < points.size(); ++k)
+  {
+    const OutputPointType expectedPoint = transform->TransformPoint(points[k]);
+    EXPECT_EQ(outputPoints[k], expectedPoint) << "point " << points[k];
+    if (expectedPoint != points[k])
+    {
+      ++numberOfMovedPoints;
+    }
+  }
+
+  /** Both the points inside and outside the buffer are tested. */
+  EXPECT_GT(numberOfMovedPoints, 0u);
+  EXPECT_LT(numberOfMovedPoints, points.size());
+
+  /** The output may overwrite the input. */
+  std::vector<OutputPointType> inPlacePoints(points.begin(), points.end());
+  transform->TransformPoints(inPlacePoints.data(), inPlacePoints.data(), inPlacePoints.size());
+  EXPECT_EQ(inPlacePoints, outputPoints);
+}
+
+} // namespace
+
+
+GTEST_TEST(DeformationFieldInterpolatingTransform, TransformPointsEqualsTransformPointForNearestNeighbor)
+{
+  ExpectTransformPointsEqualsTransformPoint(TransformType::DefaultDeformationFieldInterpolatorType::New());
+}
+
+
+GTEST_TEST(DeformationFieldInterpolatingTransform, TransformPointsEqualsTransformPointForLinear)
+{
+  ExpectTransformPointsEqualsTransformPoint(TransformType::LinearDeformationFieldInterpolatorType::New());
+}
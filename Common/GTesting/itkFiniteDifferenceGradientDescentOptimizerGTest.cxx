@@ -0,0 +1,106 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "FiniteDifferenceGradientDescent/itkFiniteDifferenceGradientDescentOptimizer.h"
+
+#include "elxCommonGTestUtilities.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using itk::FiniteDifferenceGradientDescentOptimizer;
+using elastix::CommonGTestUtilities::QuadraticCostFunction;
+
+namespace
+{
+/** The gradients and positions of all iterations of an optimization. */
+struct Path
+{
+  std::vector<FiniteDifferenceGradientDescentOptimizer::DerivativeType> gradients;
+  std::vector<FiniteDifferenceGradientDescentOptimizer::ParametersType> positions;
+};
+
+
+/** Runs the optimizer with the given number of worker cost functions; zero means a serial evaluation. */
+Path
+Optimize(const unsigned int numberOfWorkers, const bool useScales)
+{
+  FiniteDifferenceGradientDescentOptimizer::ParametersType initialPosition(3);
+  initialPosition.Fill(0.0);
+
+  FiniteDifferenceGradientDescentOptimizer::ScalesType scales(3);
+  scales[0] = 1.0;
+  scales[1] = 4.0;
+  scales[2] = 0.5;
+
+  const auto optimizer = FiniteDifferenceGradientDescentOptimizer::New();
+  optimizer->SetCostFunction(QuadraticCostFunction::New());
+  optimizer->SetInitialPosition(initialPosition);
+  optimizer->SetScales(scales);
+  optimizer->SetUseScales(useScales);
+  optimizer->SetNumberOfIterations(20);
+  optimizer->SetParam_a(0.2);
+  optimizer->SetParam_c(0.1);
+  optimizer->SetParam_A(5.0);
+
+  FiniteDifferenceGradientDescentOptimizer::CostFunctionContainerType workerCostFunctions;
+  for (unsigned int i = 0; i < numberOfWorkers; ++i)
+  {
+    workerCostFunctions.push_back(QuadraticCostFunction::New().GetPointer());
+  }
+  optimizer->SetWorkerCostFunctions(workerCostFunctions);
+  optimizer->SetEvaluateInParallel(numberOfWorkers > 0);
+
+  Path path;
+  optimizer->AddObserver(itk::IterationEvent(), [&optimizer, &path](const itk::EventObject &) {
+    path.gradients.push_back(optimizer->GetGradient());
+    path.positions.push_back(optimizer->GetCurrentPosition());
+  });
+  optimizer->StartOptimization();
+  return path;
+}
+
+} // namespace
+
+
+GTEST_TEST(FiniteDifferenceGradientDescentOptimizer, ParallelEqualsSerial)
+{
+  for (const bool useScales : { false, true })
+  {
+    SCOPED_TRACE(useScales);
+
+    const Path serial = Optimize(0, useScales);
+    ASSERT_EQ(serial.positions.size(), 20u);
+    ASSERT_GT(serial.gradients.front().inf_norm(), 0.0);
+
+    /** Each perturbed position is computed as in the serial loop, and the differences are
+     * taken in the same order, so the gradient of each iteration is exactly the same.
+     */
+    for (const unsigned int numberOfWorkers : { 1u, 2u, 4u })
+    {
+      SCOPED_TRACE(numberOfWorkers);
+
+      const Path parallel = Optimize(numberOfWorkers, useScales);
+      EXPECT_EQ(parallel.gradients, serial.gradients);
+      EXPECT_EQ(parallel.positions, serial.positions);
+    }
+  }
+}
@@ -0,0 +1,106 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "FullSearch/itkFullSearchOptimizer.h"
+
+#include "elxCommonGTestUtilities.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using itk::FullSearchOptimizer;
+using elastix::CommonGTestUtilities::QuadraticCostFunction;
+
+namespace
+{
+/** The result of a search, including the values in the order of the iteration events. */
+struct Result
+{
+  FullSearchOptimizer::SearchSpacePointType bestPoint;
+  double                                    bestValue;
+  std::vector<double>                       values;
+};
+
+
+/** Searches the first two parameters with the given number of worker cost functions;
+ * zero means a serial search. */
+Result
+Search(const unsigned int numberOfWorkers, const unsigned int coarseToFineStep)
+{
+  FullSearchOptimizer::ParametersType initialPosition(3);
+  initialPosition.Fill(2.0);
+
+  const auto optimizer = FullSearchOptimizer::New();
+  optimizer->SetCostFunction(QuadraticCostFunction::New());
+  optimizer->SetInitialPosition(initialPosition);
+  optimizer->SetMinimize(true);
+  optimizer->AddSearchDimension(0, -2.0, 3.0, 0.25);
+  optimizer->AddSearchDimension(1, -2.0, 2.0, 0.5);
+  optimizer->SetCoarseToFineStep(coarseToFineStep);
+
+  FullSearchOptimizer::CostFunctionContainerType workerCostFunctions;
+  for (unsigned int i = 0; i < numberOfWorkers; ++i)
+  {
+    workerCostFunctions.push_back(QuadraticCostFunction::New().GetPointer());
+  }
+  optimizer->SetWorkerCostFunctions(workerCostFunctions);
+  optimizer->SetEvaluateInParallel(numberOfWorkers > 0);
+
+  Result result;
+  optimizer->AddObserver(itk::IterationEvent(), [&result, &optimizer](const itk::EventObject &) {
+    result.values.push_back(optimizer->GetValue());
+  });
+  optimizer->StartOptimization();
+
+  result.bestPoint = optimizer->GetBestPointInSearchSpace();
+  result.bestValue = optimizer->GetBestValue();
+  return result;
+}
+
+} // namespace
+
+
+GTEST_TEST(FullSearchOptimizer, ParallelEqualsSerial)
+{
+  for (const unsigned int coarseToFineStep : { 1u, 4u })
+  {
+    SCOPED_TRACE("CoarseToFineStep " + std::to_string(coarseToFineStep));
+
+    const Result serial = Search(0, coarseToFineStep);
+    ASSERT_FALSE(serial.values.empty());
+    ASSERT_EQ(serial.bestPoint.GetSize(), 2u);
+    if (coarseToFineStep == 1)
+    {
+      /** The full search finds the minimum, which is on the grid. */
+      EXPECT_EQ(serial.bestPoint[0], 1.0);
+      EXPECT_EQ(serial.bestPoint[1], -0.5);
+    }
+
+    for (const unsigned int numberOfWorkers : { 1u, 3u, 8u })
+    {
+      const Result parallel = Search(numberOfWorkers, coarseToFineStep);
+      EXPECT_EQ(parallel.bestPoint, serial.bestPoint);
+      EXPECT_EQ(parallel.bestValue, serial.bestValue);
+      EXPECT_EQ(parallel.values, serial.values);
+    }
+  }
+}
@@ -0,0 +1,113 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkImageSampleSoAContainer.h"
+
+#include <itkImage.h>
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+typedef itk::Image<float, 2>                    ImageType;
+typedef itk::ImageSampleSoAContainer<ImageType> SoAContainerType;
+typedef SoAContainerType::ImageSampleType       ImageSampleType;
+typedef SoAContainerType::PointType             PointType;
+
+} // namespace
+
+
+GTEST_TEST(ImageSampleSoAContainer, PushBackAndReserveKeepTheSamples)
+{
+  const auto container = SoAContainerType::New();
+  EXPECT_EQ(container->Size(), 0);
+
+  for (unsigned int i = 0; i < 3000; ++i)
+  {
+    PointType point;
+    point[0] = i;
+    point[1] = -2.0 * i;
+    container->PushBack(point, 0.5 * i);
+  }
+  container->Reserve(10000);
+  ASSERT_EQ(container->Size(), 3000);
+  EXPECT_GE(container->Capacity(), 10000);
+
+  for (unsigned int i = 0; i < 3000; ++i)
+  {
+    EXPECT_EQ(container->GetPoint(i)[0], i);
+    EXPECT_EQ(container->GetPoint(i)[1], -2.0 * i);
+    EXPECT_EQ(container->GetValue(i), 0.5 * i);
+  }
+
+  /** All arrays start at a 64 byte boundary. */
+  for (unsigned int d = 0; d < 2; ++d)
+  {
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(container->GetCoordinates(d)) % 64, 0);
+  }
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(container->GetValues()) % 64, 0);
+
+  /** Clear keeps the memory. */
+  const itk::SizeValueType capacity = container->Capacity();
+  container->Clear();
+  EXPECT_EQ(container->Size(), 0);
+  EXPECT_EQ(container->Capacity(), capacity);
+}
+
+
+GTEST_TEST(ImageSampleSoAContainer, ResizeWithinTheCapacityDoesNotReallocate)
+{
+  /** The metrics copy each block of samples into a container like this one, so refilling
+   * it with at most the reserved number of samples must keep the same arrays.
+   */
+  const auto container = SoAContainerType::New();
+  container->Reserve(64);
+  const itk::SizeValueType capacity = container->Capacity();
+  const double * const     coordinates = container->GetCoordinates(1);
+  const auto * const       values = container->GetValues();
+
+  for (const unsigned int numberOfSamples : { 64u, 17u, 1u, 64u })
+  {
+    SCOPED_TRACE(numberOfSamples);
+
+    container->Resize(numberOfSamples);
+    ASSERT_EQ(container->Size(), numberOfSamples);
+    for (unsigned int i = 0; i < numberOfSamples; ++i)
+    {
+      ImageSampleType sample;
+      sample.m_ImageCoordinates[0] = numberOfSamples + i;
+      sample.m_ImageCoordinates[1] = -0.5 * i;
+      sample.m_ImageValue = 3.0 * i;
+      container->SetSample(i, sample);
+    }
+    for (unsigned int i = 0; i < numberOfSamples; ++i)
+    {
+      EXPECT_EQ(container->GetCoordinates(0)[i], numberOfSamples + i);
+      EXPECT_EQ(container->GetCoordinates(1)[i], -0.5 * i);
+      EXPECT_EQ(container->GetPoint(i)[1], -0.5 * i);
+      EXPECT_EQ(container->GetValue(i), 3.0 * i);
+    }
+    EXPECT_EQ(container->Capacity(), capacity);
+    EXPECT_EQ(container->GetCoordinates(1), coordinates);
+    EXPECT_EQ(container->GetValues(), values);
+  }
+}
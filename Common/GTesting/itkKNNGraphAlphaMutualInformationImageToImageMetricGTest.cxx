@@ -0,0 +1,153 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "KNNGraphAlphaMutualInformation/itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
+
+#include "elxCommonGTestUtilities.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using namespace elastix::CommonGTestUtilities;
+
+typedef itk::KNNGraphAlphaMutualInformationImageToImageMetric<MetricTestImageType, MetricTestImageType> MetricType;
+
+
+/** Creates alpha-MI of the test images, with a kd tree and either a standard or a
+ * priority tree search, single- or multi-threaded.
+ */
+MetricType::Pointer
+CreateMetric(const bool                       useMultiThread,
+             const bool                       usePrioritySearch,
+             MetricTestBSplineTransformType & transform)
+{
+  const auto metric = MetricType::New();
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetNumberOfWorkUnits(4);
+  metric->SetAlpha(0.99);
+  metric->SetANNkDTree(50, "ANN_KD_SL_MIDPT");
+  if (usePrioritySearch)
+  {
+    metric->SetANNPriorityTreeSearch(20, 0.0);
+  }
+  else
+  {
+    metric->SetANNStandardTreeSearch(20, 0.0);
+  }
+  InitializeMetric(*metric, *CreateSmoothImage(0.0), *CreateSmoothImage(1.5), transform);
+  return metric;
+}
+
+
+/** The value and derivative of one evaluation of the metric. */
+struct ResultType
+{
+  MetricType::MeasureType    value{};
+  MetricType::DerivativeType derivative;
+};
+
+
+ResultType
+GetValueAndDerivative(const MetricType & metric, const MetricTestBSplineTransformType & transform)
+{
+  ResultType result;
+  metric.GetValueAndDerivative(transform.GetParameters(), result.value, result.derivative);
+  return result;
+}
+
+} // namespace
+
+
+GTEST_TEST(KNNGraphAlphaMutualInformationImageToImageMetric, MultiThreadedEqualsSingleThreaded)
+{
+  const auto transform = CreateBSplineTransform(1.5);
+
+  const ResultType expected = GetValueAndDerivative(*CreateMetric(false, false, *transform), *transform);
+  ASSERT_GT(expected.derivative.inf_norm(), 0.0);
+
+  /** The threads sum the contributions of their own query points, so the order of the summation differs. */
+  const auto       metric = CreateMetric(true, false, *transform);
+  const ResultType result = GetValueAndDerivative(*metric, *transform);
+  EXPECT_NEAR(result.value, expected.value, 1e-10 * std::abs(expected.value));
+  ASSERT_EQ(result.derivative.GetSize(), expected.derivative.GetSize());
+  for (unsigned int i = 0; i < result.derivative.GetSize(); ++i)
+  {
+    EXPECT_NEAR(result.derivative[i], expected.derivative[i], 1e-10 * expected.derivative.inf_norm());
+  }
+
+  EXPECT_NEAR(metric->GetValue(transform->GetParameters()), expected.value, 1e-10 * std::abs(expected.value));
+}
+
+
+GTEST_TEST(KNNGraphAlphaMutualInformationImageToImageMetric, ConcurrentMetricsEqualSerial)
+{
+  /** Each metric builds its own trees and searches them with its own threads, while the
+   * other metrics do the same, half of them with the standard and half with the priority
+   * search. The search state of ANN is per thread, so the results must be exactly equal
+   * to those of the same metric on its own.
+   */
+  const unsigned int numberOfMetrics = 4;
+  const unsigned int numberOfEvaluations = 3;
+
+  std::vector<MetricTestBSplineTransformType::Pointer> transforms;
+  std::vector<MetricType::Pointer>                     metrics;
+  for (unsigned int i = 0; i < numberOfMetrics; ++i)
+  {
+    transforms.push_back(CreateBSplineTransform(0.5 + i));
+    metrics.push_back(CreateMetric(true, i % 2 == 1, *transforms[i]));
+  }
+
+  std::vector<ResultType> expected;
+  for (unsigned int i = 0; i < numberOfMetrics; ++i)
+  {
+    expected.push_back(GetValueAndDerivative(*metrics[i], *transforms[i]));
+  }
+
+  std::vector<std::vector<ResultType>> results(numberOfMetrics);
+  std::vector<std::thread>             threads;
+  for (unsigned int i = 0; i < numberOfMetrics; ++i)
+  {
+    threads.emplace_back([&, i] {
+      for (unsigned int evaluation = 0; evaluation < numberOfEvaluations; ++evaluation)
+      {
+        results[i].push_back(GetValueAndDerivative(*metrics[i], *transforms[i]));
+      }
+    });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  for (unsigned int i = 0; i < numberOfMetrics; ++i)
+  {
+    ASSERT_EQ(results[i].size(), numberOfEvaluations);
+    for (const ResultType & result : results[i])
+    {
+      EXPECT_EQ(result.value, expected[i].value);
+      EXPECT_EQ(result.derivative, expected[i].derivative);
+    }
+  }
+}
@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkParallelCostFunctionEvaluator.h"
+
+#include <gtest/gtest.h>
+
+using itk::ParallelCostFunctionEvaluator;
+
+namespace
+{
+/** A cost function that is the sum of squares of the parameters, and that
+ * throws for parameter vectors of which the first element is negative. */
+class SumOfSquaresCostFunction : public itk::SingleValuedCostFunction
+{
+public:
+  typedef SumOfSquaresCostFunction      Self;
+  typedef itk::SingleValuedCostFunction Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+
+  itkNewMacro(Self);
+
+  MeasureType
+  GetValue(const ParametersType & parameters) const override
+  {
+    if (parameters[0] < 0.0)
+    {
+      itkExceptionMacro(<< "Negative first parameter.");
+    }
+    return parameters.squared_magnitude();
+  }
+
+  void
+  GetDerivative(const ParametersType &, DerivativeType &) const override
+  {}
+
+  unsigned int
+  GetNumberOfParameters(void) const override
+  {
+    return 3;
+  }
+};
+
+
+ParallelCostFunctionEvaluator::CostFunctionContainerType
+CreateCostFunctions(const unsigned int numberOfCostFunctions)
+{
+  ParallelCostFunctionEvaluator::CostFunctionContainerType costFunctions;
+  for (unsigned int i = 0; i < numberOfCostFunctions; ++i)
+  {
+    costFunctions.push_back(SumOfSquaresCostFunction::New().GetPointer());
+  }
+  return costFunctions;
+}
+
+
+void
+Generate(const itk::SizeValueType evaluation, ParallelCostFunctionEvaluator::ParametersType & parameters)
+{
+  parameters[0] = static_cast<double>(evaluation);
+  parameters[1] = 0.5 * static_cast<double>(evaluation);
+}
+
+} // namespace
+
+
+GTEST_TEST(ParallelCostFunctionEvaluator, ValuesDoNotDependOnNumberOfWorkers)
+{
+  ParallelCostFunctionEvaluator::ParametersType initialParameters(3);
+  initialParameters.Fill(2.0);
+
+  for (const unsigned int numberOfWorkers : { 1u, 2u, 5u, 16u })
+  {
+    const auto evaluator = ParallelCostFunctionEvaluator::New();
+    evaluator->SetCostFunctions(CreateCostFunctions(numberOfWorkers));
+    ASSERT_EQ(evaluator->GetNumberOfWorkers(), numberOfWorkers);
+
+    ParallelCostFunctionEvaluator::MeasureContainerType values;
+    evaluator->Evaluate(10, initialParameters, Generate, values);
+
+    ASSERT_EQ(values.size(), 10u);
+    for (unsigned int i = 0; i < 10; ++i)
+    {
+      EXPECT_EQ(values[i], 1.25 * i * i + 4.0);
+    }
+  }
+}
+
+
+GTEST_TEST(ParallelCostFunctionEvaluator, ExceptionIsRethrown)
+{
+  const auto evaluator = ParallelCostFunctionEvaluator::New();
+  evaluator->SetCostFunctions(CreateCostFunctions(3));
+
+  ParallelCostFunctionEvaluator::ParametersType initialParameters(3);
+  initialParameters.Fill(0.0);
+
+  ParallelCostFunctionEvaluator::MeasureContainerType values;
+  EXPECT_THROW(evaluator->Evaluate(
+                 20,
+                 initialParameters,
+                 [](const itk::SizeValueType evaluation, ParallelCostFunctionEvaluator::ParametersType & parameters) {
+                   parameters[0] = (evaluation == 7) ? -1.0 : 1.0;
+                 },
+                 values),
+               itk::ExceptionObject);
+
+  /** The evaluator must remain usable after an exception. */
+  evaluator->Evaluate(4, initialParameters, Generate, values);
+  EXPECT_EQ(values[3], 1.25 * 9);
+}
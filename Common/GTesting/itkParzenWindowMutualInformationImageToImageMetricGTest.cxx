@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+
+#include "elxCommonGTestUtilities.h"
+#include "itkExponentialLimiterFunction.h"
+#include "itkHardLimiterFunction.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using namespace elastix::CommonGTestUtilities;
+
+typedef itk::ParzenWindowMutualInformationImageToImageMetric<MetricTestImageType, MetricTestImageType> MetricType;
+
+
+/** Creates Mattes MI of the test images, with the explicit joint histogram derivative,
+ * stored either densely or sparsely, single- or multi-threaded.
+ */
+MetricType::Pointer
+CreateMetric(const bool useSparsePDFDerivatives, const bool useMultiThread, MetricTestBSplineTransformType & transform)
+{
+  const auto metric = MetricType::New();
+  metric->SetUseDerivative(true);
+  metric->SetUseExplicitPDFDerivatives(true);
+  metric->SetUseSparsePDFDerivatives(useSparsePDFDerivatives);
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetNumberOfWorkUnits(4);
+  metric->SetFixedImageLimiter(itk::HardLimiterFunction<MetricType::RealType, MetricTestImageDimension>::New());
+  metric->SetMovingImageLimiter(
+    itk::ExponentialLimiterFunction<MetricType::RealType, MetricTestImageDimension>::New());
+  InitializeMetric(*metric, *CreateSmoothImage(0.0), *CreateSmoothImage(1.5), transform);
+  return metric;
+}
+
+} // namespace
+
+
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, SparsePDFDerivativesEqualDensePDFDerivatives)
+{
+  const auto transform = CreateBSplineTransform(1.5);
+
+  /** The dense joint histogram derivative is the previous code path. */
+  MetricType::MeasureType    denseValue;
+  MetricType::DerivativeType denseDerivative;
+  const auto                 denseMetric = CreateMetric(false, false, *transform);
+  denseMetric->GetValueAndDerivative(transform->GetParameters(), denseValue, denseDerivative);
+  ASSERT_GT(denseDerivative.inf_norm(), 0.0);
+
+  /** The dense version sums the contributions of the samples into a float image,
+   * whereas the sparse version keeps them apart, and contracts them in double precision.
+   */
+  const double tolerance = 1e-5 * denseDerivative.inf_norm();
+  for (const bool useMultiThread : { false, true })
+  {
+    SCOPED_TRACE(useMultiThread ? "multi-threaded" : "single-threaded");
+
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    const auto                 metric = CreateMetric(true, useMultiThread, *transform);
+    metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+
+    EXPECT_NEAR(value, denseValue, 1e-12 * std::abs(denseValue));
+    ASSERT_EQ(derivative.GetSize(), denseDerivative.GetSize());
+    for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+    {
+      EXPECT_NEAR(derivative[i], denseDerivative[i], tolerance);
+    }
+  }
+}
+
+
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, SparsePDFDerivativesAreReusedBetweenIterations)
+{
+  /** The sparse storage of each thread keeps its capacity between iterations, so a
+   * second evaluation with the same parameters must give exactly the same result.
+   */
+  const auto transform = CreateBSplineTransform(1.5);
+  const auto metric = CreateMetric(true, true, *transform);
+
+  MetricType::MeasureType    firstValue;
+  MetricType::DerivativeType firstDerivative;
+  metric->GetValueAndDerivative(transform->GetParameters(), firstValue, firstDerivative);
+
+  MetricType::MeasureType    secondValue;
+  MetricType::DerivativeType secondDerivative;
+  metric->GetValueAndDerivative(transform->GetParameters(), secondValue, secondDerivative);
+
+  EXPECT_EQ(secondValue, firstValue);
+  EXPECT_EQ(secondDerivative, firstDerivative);
+}
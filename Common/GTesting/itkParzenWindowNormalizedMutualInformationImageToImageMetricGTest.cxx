@@ -0,0 +1,91 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "NormalizedMutualInformation/itkParzenWindowNormalizedMutualInformationImageToImageMetric.h"
+
+#include "elxCommonGTestUtilities.h"
+#include "itkExponentialLimiterFunction.h"
+#include "itkHardLimiterFunction.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using namespace elastix::CommonGTestUtilities;
+
+typedef itk::ParzenWindowNormalizedMutualInformationImageToImageMetric<MetricTestImageType, MetricTestImageType>
+  MetricType;
+
+
+/** Computes the value and derivative of NMI with the explicit joint histogram derivative,
+ * or with the low-memory version, single- or multi-threaded.
+ */
+void
+GetValueAndDerivative(const bool                   useExplicitPDFDerivatives,
+                      const bool                   useMultiThread,
+                      MetricType::MeasureType &    value,
+                      MetricType::DerivativeType & derivative)
+{
+  const auto transform = CreateBSplineTransform(1.5);
+
+  const auto metric = MetricType::New();
+  metric->SetUseDerivative(true);
+  metric->SetUseExplicitPDFDerivatives(useExplicitPDFDerivatives);
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetNumberOfWorkUnits(4);
+  metric->SetFixedImageLimiter(itk::HardLimiterFunction<MetricType::RealType, MetricTestImageDimension>::New());
+  metric->SetMovingImageLimiter(
+    itk::ExponentialLimiterFunction<MetricType::RealType, MetricTestImageDimension>::New());
+  InitializeMetric(*metric, *CreateSmoothImage(0.0), *CreateSmoothImage(1.5), *transform);
+
+  metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+}
+
+} // namespace
+
+
+GTEST_TEST(ParzenWindowNormalizedMutualInformationImageToImageMetric, LowMemoryDerivativeEqualsExplicitDerivative)
+{
+  MetricType::MeasureType    explicitValue;
+  MetricType::DerivativeType explicitDerivative;
+  GetValueAndDerivative(true, false, explicitValue, explicitDerivative);
+  ASSERT_GT(explicitDerivative.inf_norm(), 0.0);
+
+  /** The low-memory version contracts the sample contributions with the ratio array,
+   * instead of summing them into the joint histogram derivative first, so it
+   * differs by rounding only.
+   */
+  const double tolerance = 1e-10 * explicitDerivative.inf_norm();
+  for (const bool useMultiThread : { false, true })
+  {
+    SCOPED_TRACE(useMultiThread ? "multi-threaded" : "single-threaded");
+
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    GetValueAndDerivative(false, useMultiThread, value, derivative);
+
+    EXPECT_NEAR(value, explicitValue, 1e-12 * std::abs(explicitValue));
+    ASSERT_EQ(derivative.GetSize(), explicitDerivative.GetSize());
+    for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+    {
+      EXPECT_NEAR(derivative[i], explicitDerivative[i], tolerance);
+    }
+  }
+}
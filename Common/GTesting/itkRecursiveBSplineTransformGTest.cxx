@@ -0,0 +1,302 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkRecursiveBSplineTransform.h"
+
+#include "itkVectorizedBSplineKernels.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+typedef itk::VectorizedBSplineKernels KernelsType;
+
+
+/** Returns the instruction sets that are supported by the CPU, from scalar up to the widest one. */
+std::vector<KernelsType::InstructionSetType>
+GetSupportedInstructionSets()
+{
+  std::vector<KernelsType::InstructionSetType> instructionSets;
+  for (int i = KernelsType::Scalar; i <= KernelsType::GetSupportedInstructionSet(); ++i)
+  {
+    instructionSets.push_back(static_cast<KernelsType::InstructionSetType>(i));
+  }
+  return instructionSets;
+}
+
+
+/** Restores the widest supported instruction set, when the test is finished. */
+class InstructionSetGuard
+{
+public:
+  ~InstructionSetGuard() { KernelsType::SetInstructionSet(KernelsType::GetSupportedInstructionSet()); }
+};
+
+
+/** Creates a cubic B-spline transform with random coefficients, of which the grid
+ * has six control points along each axis.
+ */
+template <unsigned int VDimension>
+typename itk::RecursiveBSplineTransform<double, VDimension, 3>::Pointer
+CreateTransform(std::mt19937 & randomNumberEngine)
+{
+  typedef itk::RecursiveBSplineTransform<double, VDimension, 3> TransformType;
+
+  typename TransformType::RegionType region;
+  region.SetSize(TransformType::SizeType::Filled(6));
+  typename TransformType::SpacingType spacing;
+  spacing.Fill(4.0);
+  typename TransformType::OriginType origin;
+  origin.Fill(-6.0);
+  typename TransformType::DirectionType direction;
+  direction.SetIdentity();
+
+  const auto transform = TransformType::New();
+  transform->SetGridRegion(region);
+  transform->SetGridSpacing(spacing);
+  transform->SetGridOrigin(origin);
+  transform->SetGridDirection(direction);
+
+  std::uniform_real_distribution<double> distribution(-2.0, 2.0);
+  typename TransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+/** Checks that the vectorized implementation of the transform gives the same Jacobian,
+ * nonzero Jacobian indices, and Jacobian image gradient products as the recursive one,
+ * at random points, including points outside the valid region of the grid.
+ */
+template <unsigned int VDimension>
+void
+ExpectVectorizedEqualsRecursive()
+{
+  typedef itk::RecursiveBSplineTransform<double, VDimension, 3> TransformType;
+  typedef typename TransformType::InputPointType                InputPointType;
+  typedef typename TransformType::JacobianType                  JacobianType;
+  typedef typename TransformType::DerivativeType                DerivativeType;
+  typedef typename TransformType::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename TransformType::MovingImageGradientType       MovingImageGradientType;
+
+  std::mt19937 randomNumberEngine;
+  const auto   transform = CreateTransform<VDimension>(randomNumberEngine);
+
+  const unsigned int                     nnzji = transform->GetNumberOfNonZeroJacobianIndices();
+  std::uniform_real_distribution<double> pointDistribution(-8.0, 18.0);
+  std::uniform_real_distribution<double> gradientDistribution(-10.0, 10.0);
+
+  const InstructionSetGuard guard;
+  for (const auto instructionSet : GetSupportedInstructionSets())
+  {
+    SCOPED_TRACE(KernelsType::GetInstructionSetName(instructionSet));
+    KernelsType::SetInstructionSet(instructionSet);
+
+    for (unsigned int n = 0; n < 200; ++n)
+    {
+      InputPointType          point;
+      MovingImageGradientType movingImageGradient;
+      for (unsigned int d = 0; d < VDimension; ++d)
+      {
+        point[d] = pointDistribution(randomNumberEngine);
+        movingImageGradient[d] = gradientDistribution(randomNumberEngine);
+      }
+
+      JacobianType               jacobian[2];
+      DerivativeType             imageJacobian[2];
+      NonZeroJacobianIndicesType nzjiOfJacobian[2];
+      NonZeroJacobianIndicesType nzjiOfImageJacobian[2];
+      for (unsigned int i = 0; i < 2; ++i)
+      {
+        transform->SetUseVectorizedImplementation(i == 1);
+        jacobian[i].set_size(VDimension, nnzji);
+        jacobian[i].fill(0.0);
+        imageJacobian[i].SetSize(nnzji);
+        imageJacobian[i].Fill(0.0);
+        transform->GetJacobian(point, jacobian[i], nzjiOfJacobian[i]);
+        transform->EvaluateJacobianWithImageGradientProduct(
+          point, movingImageGradient, imageJacobian[i], nzjiOfImageJacobian[i]);
+      }
+
+      /** The vectorized version multiplies the one-dimensional weights in another order. */
+      EXPECT_EQ(nzjiOfJacobian[1], nzjiOfJacobian[0]);
+      EXPECT_EQ(nzjiOfImageJacobian[1], nzjiOfImageJacobian[0]);
+      for (unsigned int k = 0; k < nnzji; ++k)
+      {
+        for (unsigned int d = 0; d < VDimension; ++d)
+        {
+          EXPECT_NEAR(jacobian[1][d][k], jacobian[0][d][k], 1e-14);
+        }
+        EXPECT_NEAR(imageJacobian[1][k], imageJacobian[0][k], 1e-12);
+      }
+
+      /** The vectorized implementation does not change the transformed points. */
+      transform->SetUseVectorizedImplementation(false);
+      const auto expectedPoint = transform->TransformPoint(point);
+      transform->SetUseVectorizedImplementation(true);
+      EXPECT_EQ(transform->TransformPoint(point), expectedPoint);
+    }
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(RecursiveBSplineTransform, VectorizedScaledCopyEqualsScalarScaledCopy)
+{
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-10.0, 10.0);
+
+  /** The lengths cover the vector widths and their remainders. */
+  const unsigned int maximumLength = 21;
+  const unsigned int maximumNumberOfScales = 4;
+  const unsigned int outputStride = 24;
+
+  std::vector<double> input(maximumLength);
+  std::vector<double> scales(maximumNumberOfScales);
+  for (auto & value : input)
+  {
+    value = distribution(randomNumberEngine);
+  }
+  for (auto & value : scales)
+  {
+    value = distribution(randomNumberEngine);
+  }
+
+  const InstructionSetGuard guard;
+  for (const auto instructionSet : GetSupportedInstructionSets())
+  {
+    SCOPED_TRACE(KernelsType::GetInstructionSetName(instructionSet));
+    KernelsType::SetInstructionSet(instructionSet);
+    ASSERT_EQ(KernelsType::GetInstructionSet(), instructionSet);
+
+    for (unsigned int length = 1; length <= maximumLength; ++length)
+    {
+      for (unsigned int numberOfScales = 1; numberOfScales <= maximumNumberOfScales; ++numberOfScales)
+      {
+        /** Fill the output with a marker, to check that nothing is written beyond the requested range. */
+        std::vector<double> expectedOutput(maximumNumberOfScales * outputStride, -1.0);
+        std::vector<double> output(expectedOutput);
+        KernelsType::ScaledCopyScalar(
+          input.data(), length, scales.data(), numberOfScales, expectedOutput.data(), outputStride);
+        KernelsType::ScaledCopy(input.data(), length, scales.data(), numberOfScales, output.data(), outputStride);
+        EXPECT_EQ(output, expectedOutput);
+      }
+    }
+  }
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, VectorizedScaledTensorProductEqualsScalarScaledTensorProduct)
+{
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-2.0, 2.0);
+
+  const unsigned int maximumNumberOfScales = 4;
+
+  const InstructionSetGuard guard;
+  for (const auto instructionSet : GetSupportedInstructionSets())
+  {
+    SCOPED_TRACE(KernelsType::GetInstructionSetName(instructionSet));
+    KernelsType::SetInstructionSet(instructionSet);
+
+    /** The numbers of weights are those of the linear, quadratic and cubic B-splines. */
+    for (unsigned int numberOfWeights1D = 2; numberOfWeights1D <= 4; ++numberOfWeights1D)
+    {
+      unsigned int numberOfWeights = 1;
+      for (unsigned int dimension = 1; dimension <= 4; ++dimension)
+      {
+        numberOfWeights *= numberOfWeights1D;
+        const unsigned int outputStride = numberOfWeights + 3;
+
+        std::vector<double> weights1D(dimension * numberOfWeights1D);
+        std::vector<double> scales(maximumNumberOfScales);
+        for (auto & value : weights1D)
+        {
+          value = distribution(randomNumberEngine);
+        }
+        for (auto & value : scales)
+        {
+          value = distribution(randomNumberEngine);
+        }
+
+        for (unsigned int numberOfScales = 1; numberOfScales <= maximumNumberOfScales; ++numberOfScales)
+        {
+          /** Fill the output with a marker, to check that nothing is written beyond the requested range. */
+          std::vector<double> expectedOutput(maximumNumberOfScales * outputStride, -1.0);
+          std::vector<double> output(expectedOutput);
+          std::vector<double> workspace(numberOfWeights);
+          KernelsType::ScaledTensorProductScalar(weights1D.data(),
+                                                 numberOfWeights1D,
+                                                 dimension,
+                                                 scales.data(),
+                                                 numberOfScales,
+                                                 expectedOutput.data(),
+                                                 outputStride,
+                                                 workspace.data());
+          KernelsType::ScaledTensorProduct(weights1D.data(),
+                                           numberOfWeights1D,
+                                           dimension,
+                                           scales.data(),
+                                           numberOfScales,
+                                           output.data(),
+                                           outputStride,
+                                           workspace.data());
+          EXPECT_EQ(output, expectedOutput);
+
+          /** Each output value is the product of its scale and one weight per dimension. */
+          for (unsigned int j = 0; j < numberOfScales; ++j)
+          {
+            for (unsigned int m = 0; m < numberOfWeights; ++m)
+            {
+              double       expectedValue = scales[j];
+              unsigned int digits = m;
+              for (unsigned int d = 0; d < dimension; ++d)
+              {
+                expectedValue *= weights1D[d * numberOfWeights1D + digits % numberOfWeights1D];
+                digits /= numberOfWeights1D;
+              }
+              EXPECT_NEAR(expectedOutput[j * outputStride + m], expectedValue, 1e-14);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, VectorizedImplementationEqualsRecursiveImplementation2D)
+{
+  ExpectVectorizedEqualsRecursive<2>();
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, VectorizedImplementationEqualsRecursiveImplementation3D)
+{
+  ExpectVectorizedEqualsRecursive<3>();
+}
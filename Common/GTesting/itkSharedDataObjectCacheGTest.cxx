@@ -0,0 +1,100 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkSharedDataObjectCache.h"
+
+#include <itkImage.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using itk::SharedDataObjectCache;
+
+namespace
+{
+typedef itk::Image<float, 2> ImageType;
+
+SharedDataObjectCache::DataObjectsType
+CreateDataObjects(void)
+{
+  return { ImageType::New().GetPointer(), ImageType::New().GetPointer() };
+}
+
+} // namespace
+
+
+GTEST_TEST(SharedDataObjectCache, ComputesOncePerKeyForConcurrentThreads)
+{
+  const auto cache = SharedDataObjectCache::New();
+
+  const unsigned int                                  numberOfThreads = 8;
+  std::atomic<unsigned int>                           numberOfComputations(0);
+  std::vector<SharedDataObjectCache::DataObjectsType> results(numberOfThreads);
+  std::vector<std::thread>                            threads;
+
+  for (unsigned int t = 0; t < numberOfThreads; ++t)
+  {
+    threads.emplace_back([&, t] {
+      results[t] = cache->GetDataObjects("key", [&numberOfComputations] {
+        ++numberOfComputations;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return CreateDataObjects();
+      });
+    });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(numberOfComputations, 1u);
+  EXPECT_EQ(cache->GetNumberOfKeys(), 1u);
+  for (const auto & result : results)
+  {
+    ASSERT_EQ(result.size(), 2u);
+    EXPECT_EQ(result, results.front());
+  }
+
+  /** Another key gives other data objects. */
+  const auto otherResult = cache->GetDataObjects("other key", CreateDataObjects);
+  EXPECT_EQ(cache->GetNumberOfKeys(), 2u);
+  EXPECT_NE(otherResult, results.front());
+
+  cache->Clear();
+  EXPECT_EQ(cache->GetNumberOfKeys(), 0u);
+}
+
+
+GTEST_TEST(SharedDataObjectCache, RethrowsTheExceptionOfTheComputation)
+{
+  const auto cache = SharedDataObjectCache::New();
+  const auto throwing = []() -> SharedDataObjectCache::DataObjectsType { throw std::runtime_error("failed"); };
+
+  EXPECT_THROW(cache->GetDataObjects("key", throwing), std::runtime_error);
+
+  /** The failure is remembered for the key: the data objects are not computed again. */
+  EXPECT_THROW(cache->GetDataObjects("key", CreateDataObjects), std::runtime_error);
+}
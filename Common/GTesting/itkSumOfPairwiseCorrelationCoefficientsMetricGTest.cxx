@@ -0,0 +1,89 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "SumOfPairwiseCorrelationsMetric/itkSumOfPairwiseCorrelationCoefficientsMetric.h"
+
+#include "elxCommonGTestUtilities.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace
+{
+using namespace elastix::CommonGTestUtilities;
+
+typedef itk::SumOfPairwiseCorrelationCoefficientsMetric<MetricTestGroupImageType, MetricTestGroupImageType> MetricType;
+
+
+/** Creates the metric of a group of five test images, with a B-spline transform that
+ * is not a stack transform, single- or multi-threaded with the given number of work units.
+ */
+MetricType::Pointer
+CreateMetric(const bool                            useMultiThread,
+             const itk::ThreadIdType               numberOfWorkUnits,
+             MetricTestGroupBSplineTransformType & transform)
+{
+  const auto image = CreateSmoothImageGroup(5);
+  const auto metric = MetricType::New();
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetNumberOfWorkUnits(numberOfWorkUnits);
+  metric->SetTransformIsStackTransform(false);
+  metric->SetSubtractMean(true);
+  metric->SetGridSize(transform.GetGridRegion().GetSize());
+  InitializeMetric(*metric, *image, *image, transform);
+  return metric;
+}
+
+} // namespace
+
+
+GTEST_TEST(SumOfPairwiseCorrelationCoefficientsMetric, MultiThreadedEqualsSingleThreaded)
+{
+  const auto transform = CreateGroupBSplineTransform(1.5);
+
+  MetricType::MeasureType    expectedValue;
+  MetricType::DerivativeType expectedDerivative;
+  const auto                 expectedMetric = CreateMetric(false, 1, *transform);
+  expectedMetric->GetValueAndDerivative(transform->GetParameters(), expectedValue, expectedDerivative);
+  ASSERT_GT(expectedDerivative.inf_norm(), 0.0);
+
+  for (const itk::ThreadIdType numberOfWorkUnits : { 1, 3, 4 })
+  {
+    SCOPED_TRACE(numberOfWorkUnits);
+
+    /** The threads accumulate the means and scatter matrices of their own samples,
+     * which are merged afterwards, so the terms are summed in another order.
+     */
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    const auto                 metric = CreateMetric(true, numberOfWorkUnits, *transform);
+    metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+
+    EXPECT_NEAR(value, expectedValue, 1e-10 * std::abs(expectedValue));
+    ASSERT_EQ(derivative.GetSize(), expectedDerivative.GetSize());
+    for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+    {
+      EXPECT_NEAR(derivative[i], expectedDerivative[i], 1e-10 * expectedDerivative.inf_norm());
+    }
+
+    EXPECT_NEAR(metric->GetValue(transform->GetParameters()), expectedValue, 1e-10 * std::abs(expectedValue));
+  }
+}
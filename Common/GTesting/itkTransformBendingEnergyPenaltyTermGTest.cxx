@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "BendingEnergyPenalty/itkTransformBendingEnergyPenaltyTerm.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkImage.h"
+#include "itkImageFullSampler.h"
+#include "itkLinearInterpolateImageFunction.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+typedef itk::Image<float, 2>                                      ImageType;
+typedef itk::TransformBendingEnergyPenaltyTerm<ImageType, double> PenaltyTermType;
+typedef itk::AdvancedCombinationTransform<double, 2>              CombinationTransformType;
+typedef itk::AdvancedMatrixOffsetTransformBase<double, 2, 2>      AffineTransformType;
+typedef itk::AdvancedBSplineDeformableTransform<double, 2, 3>     BSplineTransformType;
+typedef itk::ImageFullSampler<ImageType>                          ImageSamplerType;
+typedef itk::LinearInterpolateImageFunction<ImageType, double>    InterpolatorType;
+typedef PenaltyTermType::ParametersType                           ParametersType;
+typedef PenaltyTermType::DerivativeType                           DerivativeType;
+
+/** The value and derivative of the bending energy. */
+struct BendingEnergy
+{
+  double         value;
+  DerivativeType derivative;
+};
+
+
+/** An image of which the pixels exactly cover the valid region [0, 12] x [0, 12] of the
+ * B-spline grid of CreateBSplineTransform(), with 16 pixels per grid interval.
+ */
+ImageType::Pointer
+CreateImage(void)
+{
+  ImageType::SpacingType spacing;
+  spacing.Fill(0.125);
+  ImageType::PointType origin;
+  origin.Fill(0.0625);
+
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 96, 96 } });
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+  image->Allocate(true);
+  return image;
+}
+
+
+/** A B-spline transform with 8 x 8 grid points at -2, 0, 2, ..., 12. */
+BSplineTransformType::Pointer
+CreateBSplineTransform(void)
+{
+  BSplineTransformType::RegionType region;
+  region.SetSize(BSplineTransformType::RegionType::SizeType{ { 8, 8 } });
+  BSplineTransformType::SpacingType spacing;
+  spacing.Fill(2.0);
+  BSplineTransformType::OriginType origin;
+  origin.Fill(-2.0);
+  BSplineTransformType::DirectionType direction;
+  direction.SetIdentity();
+
+  const auto bsplineTransform = BSplineTransformType::New();
+  bsplineTransform->SetGridRegion(region);
+  bsplineTransform->SetGridSpacing(spacing);
+  bsplineTransform->SetGridOrigin(origin);
+  bsplineTransform->SetGridDirection(direction);
+  return bsplineTransform;
+}
+
+
+AffineTransformType::Pointer
+CreateAffineTransform(const double m00, const double m01, const double m10, const double m11, const double offset0)
+{
+  AffineTransformType::MatrixType matrix;
+  matrix(0, 0) = m00;
+  matrix(0, 1) = m01;
+  matrix(1, 0) = m10;
+  matrix(1, 1) = m11;
+  AffineTransformType::OutputVectorType offset;
+  offset[0] = offset0;
+  offset[1] = 0.0;
+
+  const auto affineTransform = AffineTransformType::New();
+  affineTransform->SetMatrix(matrix);
+  affineTransform->SetOffset(offset);
+  return affineTransform;
+}
+
+
+/** Computes the bending energy of the B-spline with random coefficients, combined with the
+ * initial transform, either analytically or from all pixels of the image.
+ */
+BendingEnergy
+ComputeBendingEnergy(AffineTransformType * const initialTransform,
+                     const bool                  useAddition,
+                     const bool                  useAnalyticBendingEnergy,
+                     const bool                  useMultiThread)
+{
+  const auto image = CreateImage();
+
+  const auto transform = CombinationTransformType::New();
+  transform->SetCurrentTransform(CreateBSplineTransform());
+  transform->SetInitialTransform(initialTransform);
+  transform->SetUseAddition(useAddition);
+
+  const auto penaltyTerm = PenaltyTermType::New();
+  penaltyTerm->SetFixedImage(image);
+  penaltyTerm->SetMovingImage(image);
+  penaltyTerm->SetFixedImageRegion(image->GetBufferedRegion());
+  penaltyTerm->SetInterpolator(InterpolatorType::New());
+  penaltyTerm->SetImageSampler(ImageSamplerType::New());
+  penaltyTerm->SetTransform(transform);
+  penaltyTerm->SetUseAnalyticBendingEnergy(useAnalyticBendingEnergy);
+  penaltyTerm->SetUseMultiThread(useMultiThread);
+  penaltyTerm->SetNumberOfWorkUnits(useMultiThread ? 4 : 1);
+  penaltyTerm->Initialize();
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  ParametersType                         parameters(penaltyTerm->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+
+  BendingEnergy bendingEnergy;
+  penaltyTerm->GetValueAndDerivative(parameters, bendingEnergy.value, bendingEnergy.derivative);
+  EXPECT_NEAR(penaltyTerm->GetValue(parameters), bendingEnergy.value, 1e-12 * bendingEnergy.value);
+  return bendingEnergy;
+}
+
+
+/** Expects the analytic bending energy to equal the one of the pixels, up to the error of the
+ * midpoint rule by which the pixels integrate over the valid region.
+ */
+void
+ExpectAnalyticEqualsSampled(AffineTransformType * const initialTransform, const bool useAddition)
+{
+  const BendingEnergy sampled = ComputeBendingEnergy(initialTransform, useAddition, false, false);
+  ASSERT_GT(sampled.value, 0.0);
+
+  double maxAbsDerivative = 0.0;
+  for (const double element : sampled.derivative)
+  {
+    maxAbsDerivative = std::max(maxAbsDerivative, std::abs(element));
+  }
+  ASSERT_GT(maxAbsDerivative, 0.0);
+
+  for (const bool useMultiThread : { false, true })
+  {
+    const BendingEnergy analytic = ComputeBendingEnergy(initialTransform, useAddition, true, useMultiThread);
+    EXPECT_NEAR(analytic.value, sampled.value, 1e-3 * sampled.value);
+    ASSERT_EQ(analytic.derivative.GetSize(), sampled.derivative.GetSize());
+    for (unsigned int p = 0; p < sampled.derivative.GetSize(); ++p)
+    {
+      EXPECT_NEAR(analytic.derivative[p], sampled.derivative[p], 1e-3 * maxAbsDerivative) << "parameter " << p;
+    }
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, AnalyticEqualsSampled)
+{
+  /** Without an initial transform. */
+  ExpectAnalyticEqualsSampled(nullptr, false);
+
+  /** Composed with a rotation by 90 degrees, which maps the image onto itself. */
+  ExpectAnalyticEqualsSampled(CreateAffineTransform(0.0, -1.0, 1.0, 0.0, 12.0), false);
+
+  /** Added to an affine transform, which does not change the spatial Hessian. */
+  ExpectAnalyticEqualsSampled(CreateAffineTransform(1.1, 0.2, -0.15, 0.95, 0.5), true);
+}
+
+
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, UsesSamplesForComposedNonOrthonormalAffine)
+{
+  /** Composed with an affine transform that is not orthonormal, the spatial Hessian depends on its
+   * matrix, so the bending energy is computed from the samples, even when the analytic one is asked for.
+   */
+  const auto          initialTransform = CreateAffineTransform(1.1, 0.2, -0.15, 0.95, 0.5);
+  const BendingEnergy sampled = ComputeBendingEnergy(initialTransform, false, false, false);
+  const BendingEnergy analytic = ComputeBendingEnergy(initialTransform, false, true, false);
+
+  EXPECT_GT(sampled.value, 0.0);
+  EXPECT_EQ(analytic.value, sampled.value);
+  EXPECT_EQ(analytic.derivative, sampled.derivative);
+}
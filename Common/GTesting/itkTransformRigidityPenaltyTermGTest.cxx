@@ -0,0 +1,884 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "RigidityPenalty/itkTransformRigidityPenaltyTerm.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkConstNeighborhoodIterator.h"
+#include "itkImage.h"
+#include "itkImageRegionIterator.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkNeighborhoodOperatorImageFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+/** Evaluates the rigidity penalty term of a random B-spline transform in VDimension dimensions. */
+template <unsigned int VDimension>
+struct RigidityPenaltyTermTester
+{
+  typedef itk::Image<float, VDimension>                                  ImageType;
+  typedef itk::TransformRigidityPenaltyTerm<ImageType, double>           PenaltyTermType;
+  typedef itk::AdvancedBSplineDeformableTransform<double, VDimension, 3> BSplineTransformType;
+  typedef typename PenaltyTermType::RigidityImageType                    RigidityImageType;
+  typedef typename PenaltyTermType::CoefficientImageType                 CoefficientImageType;
+  typedef typename PenaltyTermType::CoefficientImageSpacingType          SpacingType;
+  typedef typename PenaltyTermType::NeighborhoodType                     NeighborhoodType;
+  typedef typename PenaltyTermType::NOIFType                             NOIFType;
+  typedef typename PenaltyTermType::ParametersType                       ParametersType;
+  typedef typename PenaltyTermType::DerivativeType                       DerivativeType;
+  typedef itk::LinearInterpolateImageFunction<ImageType, double>         InterpolatorType;
+
+  /** The number of B-spline grid points in each dimension. */
+  static const unsigned int GridSize = VDimension == 2 ? 8 : 6;
+
+  /** The weights of the linearity, orthonormality and properness conditions. */
+  static constexpr double LinearityConditionWeight = 0.5;
+  static constexpr double OrthonormalityConditionWeight = 2.0;
+  static constexpr double PropernessConditionWeight = 3.0;
+
+
+  /** A grid spacing that differs per dimension, so that the spacing of each filter is checked. */
+  static SpacingType
+  CreateAnisotropicGridSpacing()
+  {
+    SpacingType spacing;
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      spacing[d] = 3.0 + d;
+    }
+    return spacing;
+  }
+
+
+  /** Creates a rigidity image with random values. The grid points are at -s, 0, s, ..., with s
+   * the grid spacing, so that they are all inside the rigidity image, and exactly at a pixel.
+   */
+  static typename RigidityImageType::Pointer
+  CreateRigidityImage()
+  {
+    typename RigidityImageType::SizeType rigidityImageSize;
+    rigidityImageSize.Fill(6 * GridSize);
+    typename RigidityImageType::PointType rigidityImageOrigin;
+    rigidityImageOrigin.Fill(-6.0);
+    const auto rigidityImage = RigidityImageType::New();
+    rigidityImage->SetRegions(rigidityImageSize);
+    rigidityImage->SetOrigin(rigidityImageOrigin);
+    rigidityImage->Allocate();
+
+    std::mt19937                           randomNumberEngine;
+    std::uniform_real_distribution<double> distribution(0.1, 1.0);
+    for (itk::ImageRegionIterator<RigidityImageType> it(rigidityImage, rigidityImage->GetBufferedRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      it.Set(distribution(randomNumberEngine));
+    }
+    return rigidityImage;
+  }
+
+
+  /** Creates the penalty term, with a rigidity coefficient that varies over the grid. */
+  static typename PenaltyTermType::Pointer
+  CreatePenaltyTerm(const bool              useMultiThread,
+                    const itk::ThreadIdType numberOfWorkUnits,
+                    const SpacingType &     spacing,
+                    RigidityImageType &     rigidityImage)
+  {
+    typename ImageType::SizeType imageSize;
+    imageSize.Fill(16);
+    const auto image = ImageType::New();
+    image->SetRegions(imageSize);
+    image->Allocate(true);
+
+    typename BSplineTransformType::RegionType::SizeType gridSize;
+    gridSize.Fill(GridSize);
+    typename BSplineTransformType::RegionType region;
+    region.SetSize(gridSize);
+    typename BSplineTransformType::OriginType origin;
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      origin[d] = -spacing[d];
+    }
+    typename BSplineTransformType::DirectionType direction;
+    direction.SetIdentity();
+
+    const auto bsplineTransform = BSplineTransformType::New();
+    bsplineTransform->SetGridRegion(region);
+    bsplineTransform->SetGridSpacing(spacing);
+    bsplineTransform->SetGridOrigin(origin);
+    bsplineTransform->SetGridDirection(direction);
+
+    const auto penaltyTerm = PenaltyTermType::New();
+    penaltyTerm->SetFixedImage(image);
+    penaltyTerm->SetMovingImage(image);
+    penaltyTerm->SetFixedImageRegion(image->GetBufferedRegion());
+    penaltyTerm->SetInterpolator(InterpolatorType::New());
+    penaltyTerm->SetTransform(bsplineTransform);
+    penaltyTerm->SetLinearityConditionWeight(LinearityConditionWeight);
+    penaltyTerm->SetOrthonormalityConditionWeight(OrthonormalityConditionWeight);
+    penaltyTerm->SetPropernessConditionWeight(PropernessConditionWeight);
+    penaltyTerm->SetFixedRigidityImage(&rigidityImage);
+    penaltyTerm->SetUseFixedRigidityImage(true);
+    penaltyTerm->SetUseMovingRigidityImage(false);
+    penaltyTerm->SetDilateRigidityImages(false);
+    penaltyTerm->SetUseMultiThread(useMultiThread);
+    penaltyTerm->SetNumberOfWorkUnits(numberOfWorkUnits);
+    penaltyTerm->Initialize();
+    return penaltyTerm;
+  }
+
+
+  /** Creates random B-spline coefficients, with which all three conditions are far from zero. */
+  static ParametersType
+  CreateParameters(const unsigned int numberOfParameters)
+  {
+    std::mt19937                           randomNumberEngine;
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    ParametersType                         parameters(numberOfParameters);
+    for (auto & parameter : parameters)
+    {
+      parameter = distribution(randomNumberEngine);
+    }
+    return parameters;
+  }
+
+
+  /** Checks if the grid point is not at the border of the grid. At the border,
+   * the derivative is not exact, because the stencils are clamped there.
+   */
+  static bool
+  IsInteriorGridPoint(const unsigned int gridPointIndex)
+  {
+    unsigned int remainder = gridPointIndex;
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      const unsigned int gridIndex = remainder % GridSize;
+      if (gridIndex == 0 || gridIndex == GridSize - 1)
+      {
+        return false;
+      }
+      remainder /= GridSize;
+    }
+    return true;
+  }
+
+
+  /** The filters FA up to FI. FA, FB and FC are the first derivatives in the three dimensions,
+   * FD, FE and FF the second derivatives, and FG, FH and FI the mixed second derivatives.
+   */
+  static bool
+  FilterExists(const unsigned int f)
+  {
+    return VDimension == 3 || (f != 2 && f != 5 && f != 7 && f != 8);
+  }
+
+
+  /** The 1D operator of filter f in the given dimension, as created by Create1DOperator(). */
+  static void
+  Get1DWeights(const unsigned int f, const unsigned int dimension, const SpacingType & s, double weights[3])
+  {
+    const unsigned int firstDimension[9] = { 0, 1, 2, 0, 1, 2, 0, 0, 1 };
+    const unsigned int secondDimension[9] = { 0, 1, 2, 0, 1, 2, 1, 2, 2 };
+    const unsigned int d = dimension;
+    if (f < 3 && d == firstDimension[f])
+    {
+      weights[0] = -0.5 / s[d];
+      weights[1] = 0.0;
+      weights[2] = 0.5 / s[d];
+    }
+    else if (f < 6 && d == firstDimension[f])
+    {
+      weights[0] = 0.5 / (s[d] * s[d]);
+      weights[1] = -1.0 / (s[d] * s[d]);
+      weights[2] = 0.5 / (s[d] * s[d]);
+    }
+    else if (f >= 6 && (d == firstDimension[f] || d == secondDimension[f]))
+    {
+      /** Both 1D operators of a mixed derivative divide by the product of the two spacings. */
+      const double sp = s[firstDimension[f]] * s[secondDimension[f]];
+      weights[0] = -0.5 / sp;
+      weights[1] = 0.0;
+      weights[2] = 0.5 / sp;
+    }
+    else
+    {
+      weights[0] = 1.0 / 6.0;
+      weights[1] = 4.0 / 6.0;
+      weights[2] = 1.0 / 6.0;
+    }
+  }
+
+
+  /** The ND operator of filter f, as created by CreateNDOperator(): the product of the mirrored
+   * 1D operators. Like there, the operators of the mixed derivatives divide by the product of the
+   * two spacings only once, and FF has -1/39 instead of -1/36 at the start of its middle slice.
+   */
+  static std::vector<double>
+  GetNDWeights(const unsigned int f, const SpacingType & s)
+  {
+    double weights1D[VDimension][3];
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      Get1DWeights(f, d, s, weights1D[d]);
+    }
+
+    const unsigned int  stencilSize = VDimension == 2 ? 9 : 27;
+    std::vector<double> weights(stencilSize);
+    for (unsigned int k = 0; k < stencilSize; ++k)
+    {
+      weights[k] = 1.0;
+      unsigned int remainder = k;
+      for (unsigned int d = 0; d < VDimension; ++d)
+      {
+        weights[k] *= weights1D[d][2 - remainder % 3];
+        remainder /= 3;
+      }
+    }
+    if (f == 6 || f == 7 || f == 8)
+    {
+      const double sp = f == 6 ? s[0] * s[1] : (f == 7 ? s[0] * s[2] : s[1] * s[2]);
+      for (auto & weight : weights)
+      {
+        weight *= sp;
+      }
+    }
+    if (f == 5)
+    {
+      weights[9] = -1.0 / 39.0 / (s[2] * s[2]);
+    }
+    return weights;
+  }
+
+
+  /** Filters the image with the 1D operators of filter f, one dimension after the other. */
+  static typename CoefficientImageType::Pointer
+  FilterSeparable(const CoefficientImageType & image, const unsigned int f, const SpacingType & spacing)
+  {
+    std::vector<typename NOIFType::Pointer> filters(VDimension);
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      double weights[3];
+      Get1DWeights(f, d, spacing, weights);
+      typename NeighborhoodType::SizeType radius;
+      radius.Fill(0);
+      radius[d] = 1;
+      NeighborhoodType op;
+      op.SetRadius(radius);
+      std::copy_n(weights, 3, op.Begin());
+
+      filters[d] = NOIFType::New();
+      filters[d]->SetOperator(op);
+      if (d == 0)
+      {
+        filters[d]->SetInput(&image);
+      }
+      else
+      {
+        filters[d]->SetInput(filters[d - 1]->GetOutput());
+      }
+    }
+    filters[VDimension - 1]->Update();
+    return filters[VDimension - 1]->GetOutput();
+  }
+
+
+  /** The value and derivative of the penalty term, and the values and gradient magnitudes
+   * of the linearity, orthonormality and properness conditions.
+   */
+  struct ResultType
+  {
+    double         value{};
+    double         conditionValues[3]{};
+    double         gradientMagnitudes[3]{};
+    DerivativeType derivative;
+  };
+
+
+  /** Computes the penalty term as it was computed before the filters were fused into 3^D
+   * stencils, as reference. The coefficient images are filtered with a pipeline of
+   * NeighborhoodOperatorImageFilter's, and the derivative parts with the ND operators, both
+   * with the zero flux Neumann boundary condition of ITK. The formulas of the conditions and
+   * their derivative parts are copied from that implementation.
+   */
+  static ResultType
+  ComputeReference(const ParametersType &    parameters,
+                   const SpacingType &       spacing,
+                   const RigidityImageType & rigidityImage)
+  {
+    const unsigned int numberOfGridPoints = parameters.GetSize() / VDimension;
+
+    /** The B-spline coefficient images. */
+    typename CoefficientImageType::SizeType gridSize;
+    gridSize.Fill(GridSize);
+    typename CoefficientImageType::PointType origin;
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      origin[d] = -spacing[d];
+    }
+    typename CoefficientImageType::Pointer coefficientImages[VDimension];
+    for (unsigned int i = 0; i < VDimension; i++)
+    {
+      coefficientImages[i] = CoefficientImageType::New();
+      coefficientImages[i]->SetRegions(gridSize);
+      coefficientImages[i]->SetSpacing(spacing);
+      coefficientImages[i]->SetOrigin(origin);
+      coefficientImages[i]->Allocate();
+      std::copy_n(parameters.data_block() + i * numberOfGridPoints,
+                  numberOfGridPoints,
+                  coefficientImages[i]->GetBufferPointer());
+    }
+
+    /** The rigidity coefficients at the grid points. */
+    std::vector<double> c(numberOfGridPoints);
+    double              rigidityCoefficientSum = 0.0;
+    for (unsigned int x = 0; x < numberOfGridPoints; ++x)
+    {
+      typename RigidityImageType::PointType point;
+      typename RigidityImageType::IndexType index;
+      coefficientImages[0]->TransformIndexToPhysicalPoint(coefficientImages[0]->ComputeIndex(x), point);
+      c[x] = rigidityImage.TransformPhysicalPointToIndex(point, index) ? rigidityImage.GetPixel(index) : 0.0;
+      rigidityCoefficientSum += c[x];
+    }
+
+    /** Filter the coefficient images. */
+    typename CoefficientImageType::Pointer filteredImages[9][3];
+    const double *                         filtered[9][3] = {};
+    for (unsigned int f = 0; f < 9; ++f)
+    {
+      for (unsigned int i = 0; i < VDimension && FilterExists(f); i++)
+      {
+        filteredImages[f][i] = FilterSeparable(*coefficientImages[i], f, spacing);
+        filtered[f][i] = filteredImages[f][i]->GetBufferPointer();
+      }
+    }
+
+    /** The filters of the linearity parts: FD, FE and FG, and in 3D FF, FH and FI. */
+    const unsigned int numberOfLinearityParts = 3 * VDimension - 3;
+    const unsigned int linearityFilters[6] = { 3, 4, 6, 5, 7, 8 };
+
+    /** Compute the values of the conditions and their derivative parts at each grid point. */
+    double              linearityConditionValue = 0.0;
+    double              orthonormalityConditionValue = 0.0;
+    double              propernessConditionValue = 0.0;
+    std::vector<double> orthonormalityParts[3][3];
+    std::vector<double> propernessParts[3][3];
+    std::vector<double> linearityParts[3][6];
+    for (unsigned int i = 0; i < VDimension; i++)
+    {
+      for (unsigned int j = 0; j < VDimension; j++)
+      {
+        orthonormalityParts[i][j].resize(numberOfGridPoints);
+        propernessParts[i][j].resize(numberOfGridPoints);
+      }
+      for (unsigned int l = 0; l < numberOfLinearityParts; ++l)
+      {
+        linearityParts[i][l].resize(numberOfGridPoints);
+      }
+    }
+
+    for (unsigned int x = 0; x < numberOfGridPoints; ++x)
+    {
+      const double mu1_A = filtered[0][0][x];
+      const double mu2_A = filtered[0][1][x];
+      const double mu1_B = filtered[1][0][x];
+      const double mu2_B = filtered[1][1][x];
+      const double mu3_A = VDimension == 3 ? filtered[0][2][x] : 0.0;
+      const double mu3_B = VDimension == 3 ? filtered[1][2][x] : 0.0;
+      const double mu1_C = VDimension == 3 ? filtered[2][0][x] : 0.0;
+      const double mu2_C = VDimension == 3 ? filtered[2][1][x] : 0.0;
+      const double mu3_C = VDimension == 3 ? filtered[2][2][x] : 0.0;
+      double       valueOC = 0.0;
+      double       valuePC = 0.0;
+
+      if (VDimension == 2)
+      {
+        /** Calculate the value of the orthonormality condition. */
+        orthonormalityConditionValue +=
+          c[x] * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A - 1.0, 2.0) +
+                  std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) - 1.0, 2.0) +
+                  std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B), 2.0));
+        /** Calculate the derivative of the orthonormality condition. */
+        /** mu1, part 1 */
+        valueOC = +2.0 * (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu1_A) + 2.0 * mu2_A * mu2_A * (1.0 + mu1_A) -
+                  2.0 * (1.0 + mu1_A) + mu1_B * mu1_B * (1.0 + mu1_A) + mu2_A * (1.0 + mu2_B) * mu1_B;
+        orthonormalityParts[0][0][x] = 2.0 * valueOC;
+        /** mu1, part2*/
+        valueOC = +mu1_B * (1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * (1.0 + mu2_B) * (1.0 + mu1_A) +
+                  2.0 * mu1_B * mu1_B * mu1_B + 2.0 * mu1_B * (1.0 + mu2_B) * (1.0 + mu2_B) - 2.0 * mu1_B;
+        orthonormalityParts[0][1][x] = 2.0 * valueOC;
+        /** mu2, part 1 */
+        valueOC = +2.0 * mu2_A * mu2_A * mu2_A + 2.0 * mu2_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu2_A +
+                  mu2_A * (1.0 + mu2_B) * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B);
+        orthonormalityParts[1][0][x] = 2.0 * valueOC;
+        /** mu2, part2*/
+        valueOC = +mu2_A * mu2_A * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * mu2_A +
+                  2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu2_B) + 2.0 * mu1_B * mu1_B * (1.0 + mu2_B) -
+                  2.0 * (1.0 + mu2_B);
+        orthonormalityParts[1][1][x] = 2.0 * valueOC;
+      }
+      else
+      {
+        /** Calculate the value of the orthonormality condition. */
+        orthonormalityConditionValue +=
+          c[x] * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A + mu3_A * mu3_A - 1.0, 2.0) +
+                  std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B) + mu3_A * mu3_B, 2.0) +
+                  std::pow(+(1.0 + mu1_A) * mu1_C + mu2_A * mu2_C + mu3_A * (1.0 + mu3_C), 2.0) +
+                  std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) + mu3_B * mu3_B - 1.0, 2.0) +
+                  std::pow(+mu1_B * mu1_C + (1.0 + mu2_B) * mu2_C + mu3_B * (1.0 + mu3_C), 2.0) +
+                  std::pow(+mu1_C * mu1_C + mu2_C * mu2_C + (1.0 + mu3_C) * (1.0 + mu3_C) - 1.0, 2.0));
+        /** Calculate the derivative of the orthonormality condition. */
+        /** mu1, part 1 */
+        valueOC = +2.0 * (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu1_A) + 2.0 * mu2_A * mu2_A * (1.0 + mu1_A) +
+                  2.0 * (1.0 + mu1_A) * mu3_A * mu3_A - 2.0 * (1.0 + mu1_A) + mu1_B * mu1_B * (1.0 + mu1_A) +
+                  mu2_A * (1.0 + mu2_B) * mu1_B + mu1_B * mu3_A * mu3_B + (1.0 + mu1_A) * mu1_C * mu1_C +
+                  mu1_C * mu2_A * mu2_C + mu1_C * mu3_A * (1.0 + mu3_C);
+        orthonormalityParts[0][0][x] = 2.0 * valueOC;
+        /** mu1, part2 */
+        valueOC = +(1.0 + mu1_A) * (1.0 + mu1_A) * mu1_B + (1.0 + mu1_A) * mu2_A * mu3_B +
+                  (1.0 + mu1_A) * mu3_A * mu3_B + mu1_B * mu1_B * mu1_B + mu1_B * (1.0 + mu2_B) * (1.0 + mu2_B) +
+                  mu1_B * mu3_B * mu3_B - mu1_B + mu1_B * mu1_C * mu1_C + mu1_C * (1.0 + mu2_B) * mu2_C +
+                  mu1_C * mu3_B * (1.0 + mu3_C);
+        orthonormalityParts[0][1][x] = 2.0 * valueOC;
+        /** mu1, part3 */
+        valueOC = +(1.0 + mu1_A) * (1.0 + mu1_A) * mu1_C + (1.0 + mu1_A) * mu2_A * mu2_C +
+                  (1.0 + mu1_A) * mu3_A * (1.0 + mu3_C) + mu1_B * mu1_B * mu1_C + mu1_B * (1.0 + mu2_B) * mu2_C +
+                  mu1_B * mu3_B * (1.0 + mu3_C) + 2.0 * mu1_C * mu1_C * mu1_C + 2.0 * mu1_C * mu2_C * mu2_C +
+                  2.0 * mu1_C * (1.0 + mu3_C) * (1.0 + mu3_C) - 2.0 * mu1_C;
+        orthonormalityParts[0][2][x] = 2.0 * valueOC;
+        /** mu2, part 1 */
+        valueOC = +2.0 * mu2_A * mu2_A * mu2_A + 2.0 * mu2_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu2_A +
+                  2.0 * mu2_A * mu3_A * mu3_A + mu2_A * (1.0 + mu2_B) * (1.0 + mu2_B) +
+                  mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B) + (1.0 + mu2_B) * mu3_A * mu3_B + mu2_A * mu2_C * mu2_C +
+                  (1.0 + mu1_A) * mu1_C * mu2_C + mu2_C * mu3_A * (1.0 + mu3_C);
+        orthonormalityParts[1][0][x] = 2.0 * valueOC;
+        /** mu2, part2 */
+        valueOC = +mu2_A * mu2_A * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * mu2_A + mu2_A * mu3_A * mu3_B +
+                  2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu2_B) + 2.0 * mu1_B * mu1_B * (1.0 + mu2_B) -
+                  2.0 * (1.0 + mu2_B) + 2.0 * (1.0 + mu2_B) * mu3_B * mu3_B + (1.0 + mu2_B) * mu2_C * mu2_C +
+                  mu1_B * mu1_C * mu2_C + mu2_C * mu3_B * (1.0 + mu3_C);
+        orthonormalityParts[1][1][x] = 2.0 * valueOC;
+        /** mu2, part 3 */
+        valueOC = +mu2_A * mu2_A * mu2_C + (1.0 + mu1_A) * mu1_C * mu2_A + mu2_A * mu3_A * (1.0 + mu3_C) +
+                  (1.0 + mu2_B) * (1.0 + mu2_B) * mu2_C + mu1_B * mu1_C * mu2_B +
+                  (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) + 2.0 * mu2_C * mu2_C * mu2_C + 2.0 * mu1_C * mu1_C * mu2_C +
+                  2.0 * mu2_C * (1.0 + mu3_C) * (1.0 + mu3_C) - 2.0 * mu2_C;
+        orthonormalityParts[1][2][x] = 2.0 * valueOC;
+        /** mu3, part 1 */
+        valueOC = +2.0 * mu3_A * mu3_A * mu3_A + 2.0 * mu3_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu3_A +
+                  2.0 * mu2_A * mu2_A * mu3_A + mu3_A * mu3_B * mu3_B + mu1_B * (1.0 + mu1_A) * mu3_B +
+                  (1.0 + mu2_B) * mu2_A * mu3_B + mu3_A * (1.0 + mu3_C) * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * mu1_C * (1.0 + mu3_C) + mu2_C * mu2_A * (1.0 + mu3_C);
+        orthonormalityParts[2][0][x] = 2.0 * valueOC;
+        /** mu3, part2 */
+        valueOC = +mu3_A * mu3_A * mu3_B + mu1_B * (1.0 + mu1_A) * mu3_A + mu2_A * mu3_A * (1.0 + mu2_B) +
+                  2.0 * mu3_B * mu3_B * mu3_B + 2.0 * mu1_B * mu1_B * mu3_B - 2.0 * mu3_B +
+                  2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_B + mu3_B * (1.0 + mu3_C) * (1.0 + mu3_C) +
+                  mu1_B * mu1_C * (1.0 + mu3_C) + mu2_C * (1.0 + mu2_B) * (1.0 + mu3_C);
+        orthonormalityParts[2][1][x] = 2.0 * valueOC;
+        /** mu3, part 3 */
+        valueOC = +mu3_A * mu3_A * (1.0 + mu3_C) + (1.0 + mu1_A) * mu1_C * mu3_A + mu2_A * mu3_A * mu2_C +
+                  mu3_B * mu3_B * (1.0 + mu3_C) + mu1_B * mu1_C * mu3_B + (1.0 + mu2_B) * mu3_B * mu2_C +
+                  2.0 * (1.0 + mu3_C) * (1.0 + mu3_C) * (1.0 + mu3_C) + 2.0 * mu1_C * mu1_C * (1.0 + mu3_C) +
+                  2.0 * mu2_C * mu2_C * (1.0 + mu3_C) - 2.0 * (1.0 + mu3_C);
+        orthonormalityParts[2][2][x] = 2.0 * valueOC;
+      }
+
+      if (VDimension == 2)
+      {
+        /** Calculate the value of the properness condition. */
+        propernessConditionValue +=
+          c[x] * (std::pow(+(1.0 + mu1_A) * (1.0 + mu2_B) - mu2_A * mu1_B - 1.0, 2.0));
+        /** Calculate the derivative of the properness condition. */
+        /** mu1, part 1 */
+        valuePC = +(1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu1_A) - mu2_A * (1.0 + mu2_B) * mu1_B - (1.0 + mu2_B);
+        propernessParts[0][0][x] = 2.0 * valuePC;
+        /** mu1, part 2 */
+        valuePC = +mu2_A + mu2_A * mu2_A * mu1_B - mu2_A * (1.0 + mu2_B) * (1.0 + mu1_A);
+        propernessParts[0][1][x] = 2.0 * valuePC;
+        /** mu2, part 1 */
+        valuePC = +mu1_B * mu1_B * mu2_A - mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B) + mu1_B;
+        propernessParts[1][0][x] = 2.0 * valuePC;
+        /** mu2, part 2 */
+        valuePC = -(1.0 + mu1_A) + (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) - mu1_B * (1.0 + mu1_A) * mu2_A;
+        propernessParts[1][1][x] = 2.0 * valuePC;
+      }
+      else
+      {
+        /** Calculate the value of the properness condition. */
+        propernessConditionValue +=
+          c[x] * (std::pow(-mu1_C * (1.0 + mu2_B) * mu3_A + mu1_B * mu2_C * mu3_A + mu1_C * mu2_A * mu3_B -
+                             (1.0 + mu1_A) * mu2_C * mu3_B - mu1_B * mu2_A * (1.0 + mu3_C) +
+                             (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) - 1.0,
+                           2.0));
+        /** Calculate the derivative of the properness condition. */
+        /** mu1, part 1 */
+        valuePC = +(1.0 + mu1_A) * mu2_C * mu2_C * mu3_B * mu3_B +
+                  (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) +
+                  mu1_C * (1.0 + mu2_B) * mu2_C * mu3_A * mu3_B -
+                  mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A * (1.0 + mu3_C) -
+                  mu1_B * mu2_C * mu2_C * mu3_A * mu3_B + mu1_B * (1.0 + mu2_B) * mu2_C * mu3_A * (1.0 + mu3_C) -
+                  mu1_C * mu2_A * mu2_C * mu3_B * mu3_B + mu1_C * mu2_A * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) +
+                  mu1_B * mu2_A * mu2_C * mu3_B * (1.0 + mu3_C) -
+                  2.0 * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * mu3_B * (1.0 + mu3_C) + mu2_C * mu3_B -
+                  mu1_B * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) - (1.0 + mu2_B) * (1.0 + mu3_C);
+        propernessParts[0][0][x] = 2.0 * valuePC;
+        /** mu1, part 2 */
+        valuePC = +mu1_B * mu2_C * mu2_C * mu3_A * mu3_A + mu1_B * mu2_A * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) -
+                  mu1_C * (1.0 + mu2_B) * mu2_C * mu3_A * mu3_A +
+                  mu1_C * mu2_A * (1.0 + mu2_B) * mu3_A * (1.0 + mu3_C) + mu1_C * mu2_A * mu2_C * mu3_A * mu3_B -
+                  (1.0 + mu1_A) * mu2_C * mu2_C * mu3_A * mu3_B - 2.0 * mu1_B * mu2_A * mu2_C * mu3_A * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * mu3_A * (1.0 + mu3_C) - mu2_C * mu3_A -
+                  mu1_C * mu2_A * mu2_A * mu3_B * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * mu2_A * mu2_C * mu3_B * (1.0 + mu3_C) -
+                  (1.0 + mu1_A) * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) + mu2_A * (1.0 + mu3_C);
+        propernessParts[0][1][x] = 2.0 * valuePC;
+        /** mu1, part 3 */
+        valuePC = +mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A * mu3_A + mu1_C * mu2_A * mu2_A * mu3_B * mu3_B -
+                  mu1_B * (1.0 + mu2_B) * mu2_C * mu3_A * mu3_A - 2.0 * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_A * mu3_B +
+                  (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * mu3_A * mu3_B +
+                  mu1_B * mu2_A * (1.0 + mu2_B) * mu3_A * (1.0 + mu3_C) -
+                  (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A * (1.0 + mu3_C) + (1.0 + mu2_B) * mu3_A +
+                  mu1_B * mu2_A * mu2_C * mu3_A * mu3_B - (1.0 + mu1_A) * mu2_A * mu2_C * mu3_B * mu3_B -
+                  mu1_B * mu2_A * mu2_A * mu3_B * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * mu2_A * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) - mu2_A * mu3_B;
+        propernessParts[0][2][x] = 2.0 * valuePC;
+        /** mu2, part 1 */
+        valuePC = +mu1_C * mu1_C * mu2_A * mu3_B * mu3_B + mu1_B * mu1_B * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) -
+                  mu1_C * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_B +
+                  mu1_B * mu1_C * (1.0 + mu2_B) * mu3_A * (1.0 + mu3_C) + mu1_B * mu1_C * mu2_C * mu3_A * mu3_B -
+                  mu1_B * mu1_B * mu2_C * mu3_A * (1.0 + mu3_C) - (1.0 + mu1_A) * mu1_C * mu2_C * mu3_B * mu3_B -
+                  2.0 * mu1_B * mu1_C * mu2_A * mu3_B * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) - mu1_C * mu3_B +
+                  (1.0 + mu1_A) * mu1_B * mu2_C * mu3_B * (1.0 + mu3_C) -
+                  (1.0 + mu1_A) * mu1_B * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) + mu1_B * (1.0 + mu3_C);
+        propernessParts[1][0][x] = 2.0 * valuePC;
+        /** mu2, part 2 */
+        valuePC = +mu1_C * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_A +
+                  (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) -
+                  mu1_B * mu1_C * mu2_C * mu3_A * mu3_A - mu1_C * mu1_C * mu2_A * mu3_A * mu3_B +
+                  (1.0 + mu1_A) * mu1_C * mu2_C * mu3_A * mu3_B + mu1_B * mu1_C * mu2_A * mu3_A * (1.0 + mu3_C) -
+                  2.0 * (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * mu3_A * (1.0 + mu3_C) + mu1_C * mu3_A +
+                  (1.0 + mu1_A) * mu1_B * mu2_C * mu3_A * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * mu1_C * mu2_A * mu3_B * (1.0 + mu3_C) -
+                  (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu3_B * (1.0 + mu3_C) -
+                  (1.0 + mu1_A) * mu1_B * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) - (1.0 + mu1_A) * (1.0 + mu3_C);
+        propernessParts[1][1][x] = 2.0 * valuePC;
+        /** mu2, part 3 */
+        valuePC = +mu1_B * mu1_B * mu2_C * mu3_A * mu3_A + (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu3_B * mu3_B -
+                  mu1_B * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_A +
+                  (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_B + mu1_B * mu1_C * mu2_A * mu3_A * mu3_B -
+                  2.0 * (1.0 + mu1_A) * mu1_B * mu2_C * mu3_A * mu3_B - mu1_B * mu1_B * mu2_A * mu3_A * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * mu1_B * (1.0 + mu2_B) * mu3_A * (1.0 + mu3_C) - mu1_B * mu3_A -
+                  (1.0 + mu1_A) * mu1_C * mu2_A * mu3_B * mu3_B +
+                  (1.0 + mu1_A) * mu1_B * mu2_A * mu3_B * (1.0 + mu3_C) -
+                  (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) + (1.0 + mu1_A) * mu3_B;
+        propernessParts[1][2][x] = 2.0 * valuePC;
+        /** mu3, part 1 */
+        valuePC = +mu1_C * mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A + mu1_B * mu1_B * mu2_C * mu2_C * mu3_A -
+                  2.0 * mu1_B * mu1_C * (1.0 + mu2_B) * mu2_C * mu3_A - mu1_C * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_B +
+                  (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * mu2_C * mu3_B +
+                  mu1_B * mu1_C * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) -
+                  (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu3_C) + mu1_C * (1.0 + mu2_B) +
+                  mu1_B * mu1_C * mu2_A * mu2_C * mu3_B - (1.0 + mu1_A) * mu1_B * mu2_C * mu2_C * mu3_B -
+                  mu1_B * mu1_B * mu2_A * mu2_C * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * mu1_B * (1.0 + mu2_B) * mu2_C * (1.0 + mu3_C) + mu1_B * mu2_C;
+        propernessParts[2][0][x] = 2.0 * valuePC;
+        /** mu3, part 2 */
+        valuePC = +mu1_C * mu1_C * mu2_A * mu2_A * mu3_B + (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu2_C * mu3_B -
+                  mu1_C * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_A +
+                  (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * mu2_C * mu3_A + mu1_B * mu1_C * mu2_A * mu2_C * mu3_A -
+                  (1.0 + mu1_A) * mu1_B * mu2_C * mu2_C * mu3_A - 2.0 * (1.0 + mu1_A) * mu1_C * mu2_A * mu2_C * mu3_B -
+                  mu1_B * mu1_C * mu2_A * mu2_A * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * mu1_C * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) - mu1_C * mu2_A +
+                  (1.0 + mu1_A) * mu1_B * mu2_A * mu2_C * (1.0 + mu3_C) -
+                  (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * (1.0 + mu3_C) + (1.0 + mu1_A) * mu2_C;
+        propernessParts[2][1][x] = 2.0 * valuePC;
+        /** mu3, part 3 */
+        valuePC = +mu1_B * mu1_B * mu2_A * mu2_A * (1.0 + mu3_C) +
+                  (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu3_C) +
+                  mu1_B * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_A -
+                  (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A -
+                  mu1_B * mu1_B * mu2_A * mu2_C * mu3_A + (1.0 + mu1_A) * mu1_B * (1.0 + mu2_B) * mu2_C * mu3_A -
+                  mu1_B * mu1_C * mu2_A * mu2_A * mu3_B + (1.0 + mu1_A) * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_B +
+                  (1.0 + mu1_A) * mu1_B * mu2_A * mu2_C * mu3_B +
+                  (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * mu3_B -
+                  2.0 * (1.0 + mu1_A) * mu1_B * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) + mu1_B * mu2_A -
+                  (1.0 + mu1_A) * (1.0 + mu2_B);
+        propernessParts[2][2][x] = 2.0 * valuePC;
+      }
+
+      for (unsigned int i = 0; i < VDimension; i++)
+      {
+        for (unsigned int l = 0; l < numberOfLinearityParts; ++l)
+        {
+          const double filteredValue = filtered[linearityFilters[l]][i][x];
+          linearityConditionValue += c[x] * filteredValue * filteredValue;
+          linearityParts[i][l][x] = 2.0 * filteredValue;
+        }
+      }
+    }
+
+    ResultType result;
+    result.conditionValues[0] = linearityConditionValue / rigidityCoefficientSum;
+    result.conditionValues[1] = orthonormalityConditionValue / rigidityCoefficientSum;
+    result.conditionValues[2] = propernessConditionValue / rigidityCoefficientSum;
+    result.value = LinearityConditionWeight * result.conditionValues[0] +
+                   OrthonormalityConditionWeight * result.conditionValues[1] +
+                   PropernessConditionWeight * result.conditionValues[2];
+
+    /** Filter the derivative parts, multiplied by the rigidity coefficients, with the ND operators.
+     * An image of the buffer offsets gives the offsets of the neighbors, with the boundary condition.
+     */
+    std::vector<double> ndWeights[9];
+    for (unsigned int f = 0; f < 9; ++f)
+    {
+      if (FilterExists(f))
+      {
+        ndWeights[f] = GetNDWeights(f, spacing);
+      }
+    }
+
+    typedef itk::Image<itk::SizeValueType, VDimension> OffsetImageType;
+    const auto                                         offsetImage = OffsetImageType::New();
+    offsetImage->SetRegions(gridSize);
+    offsetImage->Allocate();
+    for (unsigned int x = 0; x < numberOfGridPoints; ++x)
+    {
+      offsetImage->GetBufferPointer()[x] = x;
+    }
+    typename itk::ConstNeighborhoodIterator<OffsetImageType>::RadiusType radius;
+    radius.Fill(1);
+    itk::ConstNeighborhoodIterator<OffsetImageType> nit(radius, offsetImage, offsetImage->GetBufferedRegion());
+
+    result.derivative.SetSize(parameters.GetSize());
+    const double rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
+    double       gradientMagnitudeSums[3] = {};
+    for (unsigned int x = 0; x < numberOfGridPoints; ++x, ++nit)
+    {
+      for (unsigned int i = 0; i < VDimension; i++)
+      {
+        double filteredLC = 0.0;
+        double filteredOC = 0.0;
+        double filteredPC = 0.0;
+        for (unsigned int k = 0; k < nit.Size(); ++k)
+        {
+          const itk::SizeValueType y = nit.GetPixel(k);
+          for (unsigned int j = 0; j < VDimension; j++)
+          {
+            filteredOC += ndWeights[j][k] * orthonormalityParts[i][j][y] * c[y];
+            filteredPC += ndWeights[j][k] * propernessParts[i][j][y] * c[y];
+          }
+          for (unsigned int l = 0; l < numberOfLinearityParts; ++l)
+          {
+            filteredLC += ndWeights[linearityFilters[l]][k] * linearityParts[i][l][y] * c[y];
+          }
+        }
+
+        const double tmpLC = LinearityConditionWeight * filteredLC;
+        const double tmpOC = OrthonormalityConditionWeight * filteredOC;
+        const double tmpPC = PropernessConditionWeight * filteredPC;
+        gradientMagnitudeSums[0] += tmpLC * tmpLC / rigidityCoefficientSumSqr;
+        gradientMagnitudeSums[1] += tmpOC * tmpOC / rigidityCoefficientSumSqr;
+        gradientMagnitudeSums[2] += tmpPC * tmpPC / rigidityCoefficientSumSqr;
+        result.derivative[i * numberOfGridPoints + x] = (tmpLC + tmpOC + tmpPC) / rigidityCoefficientSum;
+      }
+    }
+    for (unsigned int n = 0; n < 3; ++n)
+    {
+      result.gradientMagnitudes[n] = std::sqrt(gradientMagnitudeSums[n]);
+    }
+    return result;
+  }
+
+
+  /** Compares the value and the derivative with those of the reference, at all grid points,
+   * including the grid points at and near the border, where the stencils are clamped.
+   */
+  static void
+  ExpectEqualsReference(const bool useMultiThread, const itk::ThreadIdType numberOfWorkUnits)
+  {
+    const SpacingType    spacing = CreateAnisotropicGridSpacing();
+    const auto           rigidityImage = CreateRigidityImage();
+    const auto           penaltyTerm = CreatePenaltyTerm(useMultiThread, numberOfWorkUnits, spacing, *rigidityImage);
+    const ParametersType parameters = CreateParameters(penaltyTerm->GetNumberOfParameters());
+
+    const ResultType expected = ComputeReference(parameters, spacing, *rigidityImage);
+    ASSERT_GT(expected.value, 0.0);
+    const double derivativeNorm = expected.derivative.inf_norm();
+    ASSERT_GT(derivativeNorm, 0.0);
+
+    double         value = 0.0;
+    DerivativeType derivative;
+    penaltyTerm->GetValueAndDerivative(parameters, value, derivative);
+
+    /** The filters are applied in another order, and the values are summed in another order. */
+    EXPECT_NEAR(value, expected.value, 1e-12 * expected.value);
+    EXPECT_NEAR(penaltyTerm->GetLinearityConditionValue(), expected.conditionValues[0], 1e-12 * expected.value);
+    EXPECT_NEAR(penaltyTerm->GetOrthonormalityConditionValue(), expected.conditionValues[1], 1e-12 * expected.value);
+    EXPECT_NEAR(penaltyTerm->GetPropernessConditionValue(), expected.conditionValues[2], 1e-12 * expected.value);
+    EXPECT_NEAR(penaltyTerm->GetLinearityConditionGradientMagnitude(),
+                expected.gradientMagnitudes[0],
+                1e-10 * expected.gradientMagnitudes[0]);
+    EXPECT_NEAR(penaltyTerm->GetOrthonormalityConditionGradientMagnitude(),
+                expected.gradientMagnitudes[1],
+                1e-10 * expected.gradientMagnitudes[1]);
+    EXPECT_NEAR(penaltyTerm->GetPropernessConditionGradientMagnitude(),
+                expected.gradientMagnitudes[2],
+                1e-10 * expected.gradientMagnitudes[2]);
+
+    ASSERT_EQ(derivative.GetSize(), expected.derivative.GetSize());
+    for (unsigned int p = 0; p < derivative.GetSize(); ++p)
+    {
+      EXPECT_NEAR(derivative[p], expected.derivative[p], 1e-10 * derivativeNorm) << "parameter " << p;
+    }
+
+    EXPECT_NEAR(penaltyTerm->GetValue(parameters), expected.value, 1e-12 * expected.value);
+  }
+
+
+  /** Compares the derivative with central finite differences of the value. The grid spacing is
+   * one, because the ND operators of the mixed derivatives divide by the product of the spacings
+   * only once, so that their part of the derivative is only exact for a unit spacing.
+   */
+  static void
+  ExpectDerivativeEqualsFiniteDifferences(const bool useMultiThread, const itk::ThreadIdType numberOfWorkUnits)
+  {
+    SpacingType spacing;
+    spacing.Fill(1.0);
+    const auto     rigidityImage = CreateRigidityImage();
+    const auto     penaltyTerm = CreatePenaltyTerm(useMultiThread, numberOfWorkUnits, spacing, *rigidityImage);
+    ParametersType parameters = CreateParameters(penaltyTerm->GetNumberOfParameters());
+
+    double         value = 0.0;
+    DerivativeType derivative;
+    penaltyTerm->GetValueAndDerivative(parameters, value, derivative);
+    ASSERT_EQ(derivative.GetSize(), parameters.GetSize());
+    EXPECT_GT(value, 0.0);
+    EXPECT_GT(penaltyTerm->GetLinearityConditionValue(), 0.0);
+    EXPECT_GT(penaltyTerm->GetOrthonormalityConditionValue(), 0.0);
+    EXPECT_GT(penaltyTerm->GetPropernessConditionValue(), 0.0);
+    EXPECT_DOUBLE_EQ(penaltyTerm->GetValue(parameters), value);
+
+    double maxAbsDerivative = 0.0;
+    for (const double element : derivative)
+    {
+      maxAbsDerivative = std::max(maxAbsDerivative, std::abs(element));
+    }
+    ASSERT_GT(maxAbsDerivative, 0.0);
+
+    /** The parameters are modified in place: the transform refers to them. */
+    const ParametersType originalParameters = parameters;
+    const unsigned int   numberOfGridPoints = parameters.GetSize() / VDimension;
+    const double         step = 1e-6;
+    unsigned int         numberOfComparedParameters = 0;
+    for (unsigned int p = 0; p < parameters.GetSize(); ++p)
+    {
+      if (!IsInteriorGridPoint(p % numberOfGridPoints))
+      {
+        continue;
+      }
+      parameters[p] = originalParameters[p] + step;
+      const double valuePlus = penaltyTerm->GetValue(parameters);
+      parameters[p] = originalParameters[p] - step;
+      const double valueMinus = penaltyTerm->GetValue(parameters);
+      parameters[p] = originalParameters[p];
+
+      EXPECT_NEAR((valuePlus - valueMinus) / (2.0 * step), derivative[p], 1e-6 * maxAbsDerivative)
+        << "parameter " << p;
+      ++numberOfComparedParameters;
+    }
+    EXPECT_GT(numberOfComparedParameters, 0u);
+  }
+
+
+  /** Compares the multi-threaded value and derivative with the single-threaded ones. */
+  static void
+  ExpectMultiThreadedEqualsSingleThreaded(const itk::ThreadIdType numberOfWorkUnits)
+  {
+    const SpacingType spacing = CreateAnisotropicGridSpacing();
+    const auto        rigidityImage = CreateRigidityImage();
+    const auto        singleThreaded = CreatePenaltyTerm(false, 1, spacing, *rigidityImage);
+    const auto        multiThreaded = CreatePenaltyTerm(true, numberOfWorkUnits, spacing, *rigidityImage);
+    ParametersType    parameters = CreateParameters(singleThreaded->GetNumberOfParameters());
+
+    double         expectedValue = 0.0;
+    DerivativeType expectedDerivative;
+    singleThreaded->GetValueAndDerivative(parameters, expectedValue, expectedDerivative);
+
+    double         value = 0.0;
+    DerivativeType derivative;
+    multiThreaded->GetValueAndDerivative(parameters, value, derivative);
+
+    /** The values of the threads are added in another order. The derivative is computed per grid point. */
+    EXPECT_NEAR(value, expectedValue, 1e-12 * expectedValue);
+    EXPECT_EQ(derivative, expectedDerivative);
+  }
+};
+
+} // namespace
+
+
+GTEST_TEST(TransformRigidityPenaltyTerm, EqualsSeparableFilterReference)
+{
+  for (const itk::ThreadIdType numberOfWorkUnits : { 1u, 3u, 8u })
+  {
+    const bool useMultiThread = numberOfWorkUnits > 1;
+    SCOPED_TRACE("Number of work units: " + std::to_string(numberOfWorkUnits));
+
+    RigidityPenaltyTermTester<2>::ExpectEqualsReference(useMultiThread, numberOfWorkUnits);
+    RigidityPenaltyTermTester<3>::ExpectEqualsReference(useMultiThread, numberOfWorkUnits);
+  }
+}
+
+
+GTEST_TEST(TransformRigidityPenaltyTerm, DerivativeEqualsFiniteDifferences)
+{
+  /** Only in 2D: in 3D, a few terms of the derivative parts of the orthonormality and properness
+   * conditions differ from the exact derivative. The reference test covers them.
+   */
+  for (const itk::ThreadIdType numberOfWorkUnits : { 1u, 3u, 8u })
+  {
+    const bool useMultiThread = numberOfWorkUnits > 1;
+    SCOPED_TRACE("Number of work units: " + std::to_string(numberOfWorkUnits));
+
+    RigidityPenaltyTermTester<2>::ExpectDerivativeEqualsFiniteDifferences(useMultiThread, numberOfWorkUnits);
+  }
+}
+
+
+GTEST_TEST(TransformRigidityPenaltyTerm, MultiThreadedEqualsSingleThreaded)
+{
+  for (const itk::ThreadIdType numberOfWorkUnits : { 2u, 3u, 8u })
+  {
+    SCOPED_TRACE("Number of work units: " + std::to_string(numberOfWorkUnits));
+
+    RigidityPenaltyTermTester<2>::ExpectMultiThreadedEqualsSingleThreaded(numberOfWorkUnits);
+    RigidityPenaltyTermTester<3>::ExpectMultiThreadedEqualsSingleThreaded(numberOfWorkUnits);
+  }
+}
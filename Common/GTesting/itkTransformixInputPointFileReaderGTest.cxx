@@ -0,0 +1,157 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkTransformixInputPointFileReader.h"
+
+#include "itkPointSet.h"
+
+#include <cstdint>
+#include <cstdio> // For remove.
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using itk::TransformixBinaryPointFile;
+
+namespace
+{
+typedef itk::DefaultStaticMeshTraits<unsigned char, 2, 2, double> MeshTraitsType;
+typedef itk::PointSet<unsigned char, 2, MeshTraitsType>           PointSetType;
+typedef itk::TransformixInputPointFileReader<PointSetType>        ReaderType;
+
+} // namespace
+
+
+GTEST_TEST(TransformixBinaryPointFile, HeaderRoundTrip)
+{
+  TransformixBinaryPointFile::HeaderType header;
+  header.m_Dimension = 3;
+  header.m_ComponentSize = sizeof(double);
+  header.m_PointsAreIndices = true;
+  header.m_NumberOfPoints = 123456789012ULL;
+
+  std::stringstream stream;
+  TransformixBinaryPointFile::WriteHeader(stream, header);
+  EXPECT_EQ(stream.str().size(), TransformixBinaryPointFile::HeaderSize);
+
+  TransformixBinaryPointFile::HeaderType readHeader;
+  ASSERT_TRUE(TransformixBinaryPointFile::ReadHeader(stream, readHeader));
+  EXPECT_EQ(readHeader.m_Dimension, header.m_Dimension);
+  EXPECT_EQ(readHeader.m_ComponentSize, header.m_ComponentSize);
+  EXPECT_EQ(readHeader.m_PointsAreIndices, header.m_PointsAreIndices);
+  EXPECT_EQ(readHeader.m_NumberOfPoints, header.m_NumberOfPoints);
+
+  /** A text point file is not recognized as binary point file. */
+  std::stringstream textStream("point\n2\n1.0 2.0\n3.0 4.0\n");
+  EXPECT_FALSE(TransformixBinaryPointFile::ReadHeader(textStream, readHeader));
+}
+
+
+GTEST_TEST(TransformixInputPointFileReader, ReadsBinaryAndTextPointFiles)
+{
+  const std::vector<double> components = { 1.5, -2.25, 3.0, 4.125, -5.0, 6.5 };
+
+  const std::string binaryFileName = "TransformixInputPointFileReaderGTest.bin";
+  {
+    TransformixBinaryPointFile::HeaderType header;
+    header.m_Dimension = 2;
+    header.m_ComponentSize = sizeof(double);
+    header.m_PointsAreIndices = false;
+    header.m_NumberOfPoints = components.size() / 2;
+
+    std::ofstream file(binaryFileName, std::ios::binary);
+    TransformixBinaryPointFile::WriteHeader(file, header);
+    TransformixBinaryPointFile::WriteComponents(file, components.data(), components.size());
+  }
+
+  const std::string textFileName = "TransformixInputPointFileReaderGTest.txt";
+  {
+    std::ofstream file(textFileName);
+    file << "index\n3\n";
+    for (std::size_t i = 0; i < components.size(); i += 2)
+    {
+      file << components[i] << ' ' << components[i + 1] << '\n';
+    }
+  }
+
+  for (const auto & fileName : { binaryFileName, textFileName })
+  {
+    const auto reader = ReaderType::New();
+    reader->SetFileName(fileName);
+    reader->Update();
+
+    EXPECT_EQ(reader->GetPointsAreBinary(), fileName == binaryFileName);
+    EXPECT_EQ(reader->GetPointsAreIndices(), fileName == textFileName);
+    ASSERT_EQ(reader->GetNumberOfPoints(), 3u);
+
+    const PointSetType * const pointSet = reader->GetOutput();
+    ASSERT_EQ(pointSet->GetNumberOfPoints(), 3u);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      const auto point = pointSet->GetPoint(i);
+      EXPECT_EQ(point[0], components[2 * i]);
+      EXPECT_EQ(point[1], components[2 * i + 1]);
+    }
+  }
+
+  std::remove(binaryFileName.c_str());
+  std::remove(textFileName.c_str());
+}
+
+
+GTEST_TEST(TransformixInputPointFileReader, ThrowsOnTruncatedBinaryPointFile)
+{
+  /** The last point of the file is incomplete, so the file holds only two whole points. */
+  const std::vector<double> components = { 1.5, -2.25, 3.0, 4.125, -5.0 };
+
+  const std::string fileName = "TransformixInputPointFileReaderGTest.bin";
+
+  /** The second number of points is so large that the size of the points would overflow. */
+  for (const std::uint64_t numberOfPoints : { std::uint64_t{ 3 }, std::uint64_t{ 1 } << 62 })
+  {
+    SCOPED_TRACE(numberOfPoints);
+
+    TransformixBinaryPointFile::HeaderType header;
+    header.m_Dimension = 2;
+    header.m_ComponentSize = sizeof(double);
+    header.m_PointsAreIndices = false;
+    header.m_NumberOfPoints = numberOfPoints;
+    {
+      std::ofstream file(fileName, std::ios::binary);
+      TransformixBinaryPointFile::WriteHeader(file, header);
+      TransformixBinaryPointFile::WriteComponents(file, components.data(), components.size());
+    }
+
+    {
+      std::ifstream file(fileName, std::ios::binary);
+      TransformixBinaryPointFile::HeaderType readHeader;
+      ASSERT_TRUE(TransformixBinaryPointFile::ReadHeader(file, readHeader));
+      EXPECT_EQ(TransformixBinaryPointFile::GetNumberOfPointsInStream(file, readHeader), 2u);
+    }
+
+    const auto reader = ReaderType::New();
+    reader->SetFileName(fileName);
+    EXPECT_THROW(reader->Update(), itk::ExceptionObject);
+  }
+
+  std::remove(fileName.c_str());
+}
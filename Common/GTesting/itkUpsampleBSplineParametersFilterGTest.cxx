@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkUpsampleBSplineParametersFilter.h"
+
+#include "itkBSplineDecompositionImageFilter.h"
+#include "itkBSplineResampleImageFunction.h"
+#include "itkImage.h"
+#include "itkOptimizerParameters.h"
+#include "itkResampleImageFilter.h"
+
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+typedef itk::OptimizerParameters<double>                                 ParametersType;
+typedef itk::Image<double, 3>                                            ImageType;
+typedef itk::UpsampleBSplineParametersFilter<ParametersType, ImageType> UpsamplerType;
+
+/** The upsampling with the ITK filters, as done by the UpsampleBSplineParametersFilter
+ * when the separable upsampling cannot be used. The coefficients are evaluated with
+ * the kernel of kernelOrder, and decomposed with splineOrder.
+ */
+ParametersType
+UpsampleWithResampling(const ParametersType &          parameters,
+                       const ImageType::RegionType &   currentRegion,
+                       const ImageType::SpacingType &  currentSpacing,
+                       const ImageType::PointType &    currentOrigin,
+                       const ImageType::RegionType &   requiredRegion,
+                       const ImageType::SpacingType &  requiredSpacing,
+                       const ImageType::PointType &    requiredOrigin,
+                       const ImageType::DirectionType & direction,
+                       unsigned int                    splineOrder,
+                       unsigned int                    kernelOrder)
+{
+  const itk::SizeValueType currentNumberOfPixels = currentRegion.GetNumberOfPixels();
+  const itk::SizeValueType requiredNumberOfPixels = requiredRegion.GetNumberOfPixels();
+  ParametersType           result(requiredNumberOfPixels * 3);
+
+  for (unsigned int j = 0; j < 3; ++j)
+  {
+    const auto coefficients = ImageType::New();
+    coefficients->SetRegions(currentRegion);
+    coefficients->SetSpacing(currentSpacing);
+    coefficients->SetOrigin(currentOrigin);
+    coefficients->SetDirection(direction);
+    coefficients->Allocate();
+    std::copy_n(parameters.data_block() + j * currentNumberOfPixels,
+                currentNumberOfPixels,
+                coefficients->GetBufferPointer());
+
+    const auto upsampler = itk::ResampleImageFilter<ImageType, ImageType>::New();
+    const auto resampleFunction = itk::BSplineResampleImageFunction<ImageType, double>::New();
+    resampleFunction->SetSplineOrder(kernelOrder);
+    upsampler->SetInterpolator(resampleFunction);
+    upsampler->SetSize(requiredRegion.GetSize());
+    upsampler->SetOutputStartIndex(requiredRegion.GetIndex());
+    upsampler->SetOutputSpacing(requiredSpacing);
+    upsampler->SetOutputOrigin(requiredOrigin);
+    upsampler->SetOutputDirection(direction);
+    upsampler->SetInput(coefficients);
+
+    const auto decomposition = itk::BSplineDecompositionImageFilter<ImageType, ImageType>::New();
+    decomposition->SetSplineOrder(splineOrder);
+    decomposition->SetInput(upsampler->GetOutput());
+    decomposition->Update();
+
+    std::copy_n(decomposition->GetOutput()->GetBufferPointer(),
+                requiredNumberOfPixels,
+                result.data_block() + j * requiredNumberOfPixels);
+  }
+  return result;
+}
+
+} // namespace
+
+
+GTEST_TEST(UpsampleBSplineParametersFilter, SeparableUpsamplingEqualsResampling)
+{
+  /** A rotated grid, with the required grid half the spacing of the current grid,
+   * and partly outside the current grid.
+   */
+  ImageType::DirectionType direction;
+  direction.SetIdentity();
+  const double angle = 0.3;
+  direction(0, 0) = std::cos(angle);
+  direction(0, 1) = -std::sin(angle);
+  direction(1, 0) = std::sin(angle);
+  direction(1, 1) = std::cos(angle);
+
+  ImageType::RegionType  currentRegion;
+  ImageType::SpacingType currentSpacing;
+  ImageType::PointType   currentOrigin;
+  ImageType::RegionType  requiredRegion;
+  ImageType::SpacingType requiredSpacing;
+  for (unsigned int d = 0; d < 3; ++d)
+  {
+    currentRegion.SetIndex(d, d);
+    currentRegion.SetSize(d, 5 + d);
+    currentSpacing[d] = 8.0 + d;
+    currentOrigin[d] = -10.0 - 3.0 * d;
+    requiredRegion.SetIndex(d, 0);
+    requiredRegion.SetSize(d, 8 + 2 * d);
+    requiredSpacing[d] = 0.5 * currentSpacing[d];
+  }
+  ImageType::PointType requiredOrigin = currentOrigin + direction * ImageType::PointType::VectorType(1.5);
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  ParametersType                         parameters(currentRegion.GetNumberOfPixels() * 3);
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+
+  /** By default the cubic kernel is used for all orders, as before. */
+  for (const bool useBSplineOrderKernel : { false, true })
+  {
+    for (unsigned int splineOrder = 1; splineOrder <= 3; ++splineOrder)
+    {
+      SCOPED_TRACE(useBSplineOrderKernel);
+      SCOPED_TRACE(splineOrder);
+
+      const auto filter = UpsamplerType::New();
+      filter->SetBSplineOrder(splineOrder);
+      filter->SetUseBSplineOrderKernel(useBSplineOrderKernel);
+      filter->SetCurrentGridRegion(currentRegion);
+      filter->SetCurrentGridSpacing(currentSpacing);
+      filter->SetCurrentGridOrigin(currentOrigin);
+      filter->SetCurrentGridDirection(direction);
+      filter->SetRequiredGridRegion(requiredRegion);
+      filter->SetRequiredGridSpacing(requiredSpacing);
+      filter->SetRequiredGridOrigin(requiredOrigin);
+      filter->SetRequiredGridDirection(direction);
+
+      ParametersType upsampledParameters;
+      filter->UpsampleParameters(parameters, upsampledParameters);
+
+      const ParametersType expectedParameters = UpsampleWithResampling(parameters,
+                                                                       currentRegion,
+                                                                       currentSpacing,
+                                                                       currentOrigin,
+                                                                       requiredRegion,
+                                                                       requiredSpacing,
+                                                                       requiredOrigin,
+                                                                       direction,
+                                                                       splineOrder,
+                                                                       useBSplineOrderKernel ? splineOrder : 3);
+
+      ASSERT_EQ(upsampledParameters.GetSize(), expectedParameters.GetSize());
+      for (unsigned int i = 0; i < expectedParameters.GetSize(); ++i)
+      {
+        EXPECT_NEAR(upsampledParameters[i], expectedParameters[i], 1e-10);
+      }
+    }
+  }
+}
@@ -0,0 +1,169 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "VarianceOverLastDimension/itkVarianceOverLastDimensionImageMetric.h"
+
+#include "elxCommonGTestUtilities.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace
+{
+using namespace elastix::CommonGTestUtilities;
+
+typedef itk::VarianceOverLastDimensionImageMetric<MetricTestGroupImageType, MetricTestGroupImageType> MetricType;
+
+
+/** Creates the metric of a group of six test images, with a B-spline transform that
+ * is not a stack transform, either single-threaded, or multi-threaded with the given
+ * number of work units, with the PlatformMultiThreader or with the thread pool.
+ */
+MetricType::Pointer
+CreateMetric(const bool                            useMultiThread,
+             const bool                            useThreadPool,
+             const itk::ThreadIdType               numberOfWorkUnits,
+             const bool                            sampleLastDimensionRandomly,
+             MetricTestGroupBSplineTransformType & transform)
+{
+  const auto image = CreateSmoothImageGroup(6);
+  const auto metric = MetricType::New();
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetUseThreadPool(useThreadPool);
+  metric->SetNumberOfWorkUnits(numberOfWorkUnits);
+  metric->SetSampleLastDimensionRandomly(sampleLastDimensionRandomly);
+  metric->SetNumSamplesLastDimension(4);
+  metric->SetTransformIsStackTransform(false);
+  metric->SetSubtractMean(true);
+  metric->SetGridSize(transform.GetGridRegion().GetSize());
+  InitializeMetric(*metric, *image, *image, transform);
+  return metric;
+}
+
+
+/** Evaluates the metric, after reseeding the random generator of the last dimension positions. */
+void
+GetValueAndDerivative(const MetricType &                          metric,
+                      const MetricTestGroupBSplineTransformType & transform,
+                      MetricType::MeasureType &                   value,
+                      MetricType::DerivativeType &                derivative)
+{
+  itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()->Initialize(121212);
+  metric.GetValueAndDerivative(transform.GetParameters(), value, derivative);
+}
+
+} // namespace
+
+
+GTEST_TEST(VarianceOverLastDimensionImageMetric, MultiThreadedEqualsSingleThreaded)
+{
+  const auto transform = CreateGroupBSplineTransform(1.5);
+
+  for (const bool sampleLastDimensionRandomly : { false, true })
+  {
+    SCOPED_TRACE(sampleLastDimensionRandomly ? "random last dimension" : "full last dimension");
+
+    MetricType::MeasureType    expectedValue;
+    MetricType::DerivativeType expectedDerivative;
+    const auto                 expectedMetric = CreateMetric(false, false, 1, sampleLastDimensionRandomly, *transform);
+    GetValueAndDerivative(*expectedMetric, *transform, expectedValue, expectedDerivative);
+    ASSERT_GT(expectedDerivative.inf_norm(), 0.0);
+
+    for (const bool useThreadPool : { false, true })
+    {
+      for (const itk::ThreadIdType numberOfWorkUnits : { 1, 3, 4 })
+      {
+        SCOPED_TRACE(numberOfWorkUnits);
+        SCOPED_TRACE(useThreadPool ? "thread pool" : "PlatformMultiThreader");
+
+        /** The positions along the last dimension are drawn before the threads are launched,
+         * in the order of the samples, so only the order of the summation differs.
+         */
+        MetricType::MeasureType    value;
+        MetricType::DerivativeType derivative;
+        const auto                 metric =
+          CreateMetric(true, useThreadPool, numberOfWorkUnits, sampleLastDimensionRandomly, *transform);
+        GetValueAndDerivative(*metric, *transform, value, derivative);
+
+        EXPECT_NEAR(value, expectedValue, 1e-10 * std::abs(expectedValue));
+        ASSERT_EQ(derivative.GetSize(), expectedDerivative.GetSize());
+        for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+        {
+          EXPECT_NEAR(derivative[i], expectedDerivative[i], 1e-10 * expectedDerivative.inf_norm());
+        }
+      }
+    }
+  }
+}
+
+
+GTEST_TEST(VarianceOverLastDimensionImageMetric, MultiThreadedGetValueEqualsSingleThreaded)
+{
+  const auto transform = CreateGroupBSplineTransform(1.5);
+
+  const auto expectedMetric = CreateMetric(false, false, 1, false, *transform);
+  const auto expectedValue = expectedMetric->GetValue(transform->GetParameters());
+
+  for (const bool useThreadPool : { false, true })
+  {
+    SCOPED_TRACE(useThreadPool ? "thread pool" : "PlatformMultiThreader");
+
+    const auto metric = CreateMetric(true, useThreadPool, 4, false, *transform);
+    EXPECT_NEAR(metric->GetValue(transform->GetParameters()), expectedValue, 1e-10 * std::abs(expectedValue));
+  }
+}
+
+
+GTEST_TEST(VarianceOverLastDimensionImageMetric, EvaluationAfterTooFewValidSamplesEqualsFirstEvaluation)
+{
+  const auto transform = CreateGroupBSplineTransform(1.5);
+
+  for (const bool useThreadPool : { false, true })
+  {
+    SCOPED_TRACE(useThreadPool ? "thread pool" : "PlatformMultiThreader");
+
+    const auto                 metric = CreateMetric(true, useThreadPool, 3, false, *transform);
+    const double               requiredRatioOfValidSamples = metric->GetRequiredRatioOfValidSamples();
+    MetricType::MeasureType    expectedValue;
+    MetricType::DerivativeType expectedDerivative;
+    GetValueAndDerivative(*metric, *transform, expectedValue, expectedDerivative);
+
+    /** With a required ratio above one, each evaluation throws after the threads have
+     * summed their terms. The next evaluation should not include these sums.
+     */
+    metric->SetRequiredRatioOfValidSamples(1.5);
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    EXPECT_THROW(metric->GetValue(transform->GetParameters()), itk::ExceptionObject);
+    EXPECT_THROW(GetValueAndDerivative(*metric, *transform, value, derivative), itk::ExceptionObject);
+    metric->SetRequiredRatioOfValidSamples(requiredRatioOfValidSamples);
+
+    GetValueAndDerivative(*metric, *transform, value, derivative);
+    EXPECT_NEAR(value, expectedValue, 1e-10 * std::abs(expectedValue));
+    ASSERT_EQ(derivative.GetSize(), expectedDerivative.GetSize());
+    for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+    {
+      EXPECT_NEAR(derivative[i], expectedDerivative[i], 1e-10 * expectedDerivative.inf_norm());
+    }
+    EXPECT_NEAR(metric->GetValue(transform->GetParameters()), expectedValue, 1e-10 * std::abs(expectedValue));
+  }
+}
@@ -0,0 +1,120 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkWorkStealingThreadPool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using itk::WorkStealingThreadPool;
+
+namespace
+{
+void
+Expect_each_chunk_popped_once(const itk::ThreadIdType numberOfWorkers, const itk::SizeValueType numberOfChunks)
+{
+  const auto pool = WorkStealingThreadPool::New();
+  pool->SetNumberOfWorkers(numberOfWorkers);
+  ASSERT_EQ(pool->GetNumberOfWorkers(), numberOfWorkers);
+
+  std::vector<std::atomic<unsigned int>> counts(numberOfChunks);
+  for (auto & count : counts)
+  {
+    count = 0;
+  }
+
+  WorkStealingThreadPool::ChunkQueue queue;
+  queue.Initialize(numberOfChunks, numberOfWorkers);
+  pool->Execute([&queue, &counts](const itk::ThreadIdType workerId) {
+    itk::SizeValueType chunk = 0;
+    while (queue.Pop(workerId, chunk))
+    {
+      ++counts[chunk];
+    }
+  });
+
+  for (const auto & count : counts)
+  {
+    EXPECT_EQ(count, 1u);
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(WorkStealingThreadPool, EachChunkIsPoppedOnce)
+{
+  Expect_each_chunk_popped_once(1, 100);
+  Expect_each_chunk_popped_once(3, 1000);
+  Expect_each_chunk_popped_once(8, 5);
+  Expect_each_chunk_popped_once(4, 0);
+}
+
+
+GTEST_TEST(WorkStealingThreadPool, BarrierSeparatesPhases)
+{
+  const itk::ThreadIdType numberOfWorkers = 4;
+  const auto              pool = WorkStealingThreadPool::New();
+  pool->SetNumberOfWorkers(numberOfWorkers);
+
+  std::vector<unsigned int> phase1(numberOfWorkers, 0);
+  std::atomic<unsigned int> errors(0);
+
+  for (unsigned int repetition = 0; repetition < 20; ++repetition)
+  {
+    pool->Execute([&](const itk::ThreadIdType workerId) {
+      phase1[workerId] = repetition + 1;
+      pool->Barrier();
+
+      /** After the barrier all workers must see the results of the first phase. */
+      for (const auto value : phase1)
+      {
+        if (value != repetition + 1)
+        {
+          ++errors;
+        }
+      }
+    });
+  }
+  EXPECT_EQ(errors, 0u);
+}
+
+
+GTEST_TEST(WorkStealingThreadPool, ExceptionIsRethrown)
+{
+  const auto pool = WorkStealingThreadPool::New();
+  pool->SetNumberOfWorkers(3);
+
+  EXPECT_THROW(pool->Execute([](const itk::ThreadIdType workerId) {
+    if (workerId == 2)
+    {
+      throw std::runtime_error("worker failure");
+    }
+  }),
+               std::runtime_error);
+
+  /** The pool must remain usable after an exception. */
+  std::atomic<unsigned int> numberOfCalls(0);
+  pool->Execute([&numberOfCalls](itk::ThreadIdType) { ++numberOfCalls; });
+  EXPECT_EQ(numberOfCalls, 3u);
+}
@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "xoutsynchronizedbuf.h"
+
+#include "xoutmain.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+
+GTEST_TEST(xoutsynchronizedbuf, LinesOfConcurrentStreamsDoNotInterleave)
+{
+  const unsigned int numberOfThreads = 4;
+  const unsigned int numberOfLines = 500;
+  const std::string  line = "The quick brown fox jumps over the lazy dog.";
+
+  std::ostringstream       target;
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < numberOfThreads; ++t)
+  {
+    threads.emplace_back([&target, &line] {
+      xl::xoutsynchronizedbuf_type buffer(target);
+      std::ostream                 stream(&buffer);
+      for (unsigned int i = 0; i < numberOfLines; ++i)
+      {
+        stream << line.substr(0, 10) << line.substr(10) << '\n';
+      }
+    });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  std::istringstream input(target.str());
+  std::string        inputLine;
+  unsigned int       count = 0;
+  while (std::getline(input, inputLine))
+  {
+    EXPECT_EQ(inputLine, line);
+    ++count;
+  }
+  EXPECT_EQ(count, numberOfThreads * numberOfLines);
+}
+
+
+GTEST_TEST(xoutsynchronizedbuf, IncompleteLineIsWrittenOnFlush)
+{
+  std::ostringstream target;
+  {
+    xl::xoutsynchronizedbuf_type buffer(target);
+    std::ostream                 stream(&buffer);
+    stream << "incomplete";
+    EXPECT_EQ(target.str(), "");
+    stream << std::flush;
+    EXPECT_EQ(target.str(), "incomplete");
+    stream << " line";
+  }
+  EXPECT_EQ(target.str(), "incomplete line");
+}
+
+
+GTEST_TEST(xoutmain, EachThreadHasItsOwnXout)
+{
+  std::ostringstream       outputs[2];
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < 2; ++t)
+  {
+    threads.emplace_back([&outputs, t] {
+      EXPECT_FALSE(xl::xout_valid());
+
+      xl::xoutsimple_type threadXout;
+      threadXout.AddOutput("output", &outputs[t]);
+      xl::set_xout(&threadXout);
+      for (unsigned int i = 0; i < 100; ++i)
+      {
+        xl::xout << t;
+      }
+      xl::set_xout(nullptr);
+    });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(outputs[0].str(), std::string(100, '0'));
+  EXPECT_EQ(outputs[1].str(), std::string(100, '1'));
+}
@@ -21,7 +21,6 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkInterpolateImageFunction.h"
 #include "itkBSplineInterpolateImageFunction.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 namespace itk
 {
@@ -82,10 +81,6 @@ public:
   typedef typename InterpolatorType::Pointer                                    InterpolatorPointer;
   typedef BSplineInterpolateImageFunction<InputImageType, CoordRepType, double> DefaultInterpolatorType;
 
-  /** The random number generator used to generate random coordinates. */
-  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
-  typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
-
   /** Set/Get the interpolator. A 3rd order B-spline interpolator is used by default. */
   itkSetObjectMacro(Interpolator, InterpolatorType);
   itkGetModifiableObjectMacro(Interpolator, InterpolatorType);
@@ -129,9 +124,8 @@ protected:
                            const InputImageContinuousIndexType & largestContIndex,
                            InputImageContinuousIndexType &       randomContIndex);
 
-  InterpolatorPointer    m_Interpolator;
-  RandomGeneratorPointer m_RandomGenerator;
-  InputImageSpacingType  m_SampleRegionSize;
+  InterpolatorPointer   m_Interpolator;
+  InputImageSpacingType m_SampleRegionSize;
 
   /** Generate the two corners of a sampling region, given the two corners
    * of an image. If UseRandomSampleRegion=false, the smallesPoint and largestPoint
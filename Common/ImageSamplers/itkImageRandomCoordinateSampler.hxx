@@ -36,9 +36,6 @@ ImageRandomCoordinateSampler<TInputImage>::ImageRandomCoordinateSampler()
   bsplineInterpolator->SetSplineOrder(3);
   this->m_Interpolator = bsplineInterpolator;
 
-  /** Setup random generator. */
-  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
-
   this->m_UseRandomSampleRegion = false;
   this->m_SampleRegionSize.Fill(1.0);
 
@@ -196,12 +193,7 @@ ImageRandomCoordinateSampler<TInputImage>::BeforeThreadedGenerateData(void)
   }
 
   /** Initialize variables needed for threads. */
-  this->m_ThreaderSampleContainer.clear();
-  this->m_ThreaderSampleContainer.resize(this->GetNumberOfWorkUnits());
-  for (std::size_t i = 0; i < this->GetNumberOfWorkUnits(); i++)
-  {
-    this->m_ThreaderSampleContainer[i] = ImageSampleContainerType::New();
-  }
+  this->InitializeThreaderSampleContainers();
 
 } // end BeforeThreadedGenerateData()
 
@@ -224,27 +216,15 @@ ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateData(const InputImage
   /** Get handle to the input image. */
   InputImageConstPointer inputImage = this->GetInput();
 
-  /** Figure out which samples to process. */
-  unsigned long chunkSize = this->GetNumberOfSamples() / this->GetNumberOfWorkUnits();
-  unsigned long sampleStart = threadId * chunkSize * InputImageDimension;
-  if (threadId == this->GetNumberOfWorkUnits() - 1)
-  {
-    chunkSize = this->GetNumberOfSamples() - ((this->GetNumberOfWorkUnits() - 1) * chunkSize);
-  }
-
-  /** Get a reference to the output and reserve memory for it. */
-  ImageSampleContainerPointer & sampleContainerThisThread // & ???
-    = this->m_ThreaderSampleContainer[threadId];
-  sampleContainerThisThread->Reserve(chunkSize);
-
-  /** Setup an iterator over the sampleContainerThisThread. */
-  typename ImageSampleContainerType::Iterator      iter;
-  typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
+  /** Figure out which samples to process, and get a pointer to where they are stored. */
+  unsigned long     sampleStart = 0;
+  unsigned long     chunkSize = 0;
+  ImageSampleType * samples = this->GetThreaderSamples(threadId, sampleStart, chunkSize);
 
   /** Fill the local sample container. */
   InputImageContinuousIndexType sampleCIndex;
-  unsigned long                 sampleId = sampleStart;
-  for (iter = sampleContainerThisThread->Begin(); iter != end; ++iter)
+  unsigned long                 sampleId = sampleStart * InputImageDimension;
+  for (unsigned long i = 0; i < chunkSize; ++i)
   {
     /** Create a random point out of InputImageDimension random numbers. */
     for (unsigned int j = 0; j < InputImageDimension; ++j, sampleId++)
@@ -253,8 +233,8 @@ ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateData(const InputImage
     }
 
     /** Make a reference to the current sample in the container. */
-    InputImagePointType &  samplePoint = (*iter).Value().m_ImageCoordinates;
-    ImageSampleValueType & sampleValue = (*iter).Value().m_ImageValue;
+    InputImagePointType &  samplePoint = samples[i].m_ImageCoordinates;
+    ImageSampleValueType & sampleValue = samples[i].m_ImageValue;
 
     /** Convert to point */
     inputImage->TransformContinuousIndexToPhysicalPoint(sampleCIndex, samplePoint);
@@ -339,7 +319,6 @@ ImageRandomCoordinateSampler<TInputImage>::PrintSelf(std::ostream & os, Indent i
   Superclass::PrintSelf(os, indent);
 
   os << indent << "Interpolator: " << this->m_Interpolator.GetPointer() << std::endl;
-  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
@@ -20,7 +20,6 @@
 
 #include "itkImageRandomSampler.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkImageRandomConstIteratorWithIndex.h"
 
 namespace itk
@@ -148,28 +147,17 @@ ImageRandomSampler<TInputImage>::ThreadedGenerateData(const InputImageRegionType
   /** Get handle to the input image. */
   InputImageConstPointer inputImage = this->GetInput();
 
-  /** Figure out which samples to process. */
-  unsigned long chunkSize = this->GetNumberOfSamples() / this->GetNumberOfWorkUnits();
-  unsigned long sampleStart = threadId * chunkSize;
-  if (threadId == this->GetNumberOfWorkUnits() - 1)
-  {
-    chunkSize = this->GetNumberOfSamples() - ((this->GetNumberOfWorkUnits() - 1) * chunkSize);
-  }
-
-  /** Get a reference to the output and reserve memory for it. */
-  ImageSampleContainerPointer & sampleContainerThisThread = this->m_ThreaderSampleContainer[threadId];
-  sampleContainerThisThread->Reserve(chunkSize);
-
-  /** Setup an iterator over the sampleContainerThisThread. */
-  typename ImageSampleContainerType::Iterator      iter;
-  typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
+  /** Figure out which samples to process, and get a pointer to where they are stored. */
+  unsigned long     sampleStart = 0;
+  unsigned long     chunkSize = 0;
+  ImageSampleType * samples = this->GetThreaderSamples(threadId, sampleStart, chunkSize);
 
   /** Fill the local sample container. */
-  unsigned long       sampleId = sampleStart;
   InputImageSizeType  regionSize = this->GetCroppedInputImageRegion().GetSize();
   InputImageIndexType regionIndex = this->GetCroppedInputImageRegion().GetIndex();
-  for (iter = sampleContainerThisThread->Begin(); iter != end; ++iter, sampleId++)
+  for (unsigned long i = 0; i < chunkSize; ++i)
   {
+    const unsigned long sampleId = sampleStart + i;
     unsigned long randomPosition = static_cast<unsigned long>(this->m_RandomNumberList[sampleId]);
 
     /** Translate randomPosition to an index, copied from ImageRandomConstIteratorWithIndex. */
@@ -185,10 +173,10 @@ ImageRandomSampler<TInputImage>::ThreadedGenerateData(const InputImageRegionType
     }
 
     /** Transform index to the physical coordinates and put it in the sample. */
-    inputImage->TransformIndexToPhysicalPoint(positionIndex, (*iter).Value().m_ImageCoordinates);
+    inputImage->TransformIndexToPhysicalPoint(positionIndex, samples[i].m_ImageCoordinates);
 
     /** Get the value and put it in the sample. */
-    (*iter).Value().m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(positionIndex));
+    samples[i].m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(positionIndex));
 
   } // end for loop
 
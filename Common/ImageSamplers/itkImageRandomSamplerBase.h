@@ -19,6 +19,7 @@
 #define itkImageRandomSamplerBase_h
 
 #include "itkImageSamplerBase.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 namespace itk
 {
@@ -29,6 +30,19 @@ namespace itk
  *
  * It adds the Set/GetNumberOfSamples function.
  *
+ * When ReuseSampleBuffers is set, the multi-threaded samplers write their samples
+ * directly in the output container, which keeps its memory between updates. This
+ * avoids the allocation of per-thread containers and the final merge copy in every
+ * update, which matters when new samples are selected every iteration. The
+ * single-threaded samplers (UseMultiThread false, or with a mask) always write
+ * directly in the output container, so for them this option has no effect.
+ *
+ * The samplers draw from the global random number generator of ITK, unless another
+ * generator is set with SetRandomGenerator(). elastix sets the random generator of the
+ * registration, so samplers in registrations that run concurrently do not share a
+ * random sequence. The random iterator of the single-threaded ImageRandomSampler
+ * still seeds its own generator from the global one.
+ *
  * \ingroup ImageSamplers
  */
 
@@ -65,6 +79,19 @@ public:
   /** The input image dimension. */
   itkStaticConstMacro(InputImageDimension, unsigned int, Superclass::InputImageDimension);
 
+  /** The random number generator of the sampler. */
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+  typedef typename RandomGeneratorType::Pointer             RandomGeneratorPointer;
+
+  /** Set/Get whether the sample buffers are reused between updates, see above. Default: false. */
+  itkSetMacro(ReuseSampleBuffers, bool);
+  itkGetConstMacro(ReuseSampleBuffers, bool);
+  itkBooleanMacro(ReuseSampleBuffers);
+
+  /** Set/Get the random number generator of this sampler. Default: the global instance. */
+  itkSetObjectMacro(RandomGenerator, RandomGeneratorType);
+  itkGetModifiableObjectMacro(RandomGenerator, RandomGeneratorType);
+
 protected:
   /** The constructor. */
   ImageRandomSamplerBase();
@@ -76,6 +103,24 @@ protected:
   void
   BeforeThreadedGenerateData(void) override;
 
+  /** Combines the results of the threads, if needed. */
+  void
+  AfterThreadedGenerateData(void) override;
+
+  /** Prepares the containers that the threads write to. When ReuseSampleBuffers
+   * is set, the output container is resized to the number of samples. Otherwise
+   * new per-thread containers are created, as in the superclass.
+   */
+  void
+  InitializeThreaderSampleContainers(void);
+
+  /** Returns a pointer to the samples that are written by this thread, and their
+   * position and number. Points to the output container when ReuseSampleBuffers is
+   * set, and to the container of this thread otherwise.
+   */
+  ImageSampleType *
+  GetThreaderSamples(ThreadIdType threadId, unsigned long & sampleStart, unsigned long & chunkSize);
+
   /** PrintSelf. */
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
@@ -83,6 +128,9 @@ protected:
   /** Member variable used when threading. */
   std::vector<double> m_RandomNumberList;
 
+  bool                   m_ReuseSampleBuffers{ false };
+  RandomGeneratorPointer m_RandomGenerator;
+
 private:
   /** The deleted copy constructor. */
   ImageRandomSamplerBase(const Self &) = delete;
@@ -20,7 +20,6 @@
 
 #include "itkImageRandomSamplerBase.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkImageRandomConstIteratorWithIndex.h"
 
 namespace itk
@@ -35,6 +34,9 @@ ImageRandomSamplerBase<TInputImage>::ImageRandomSamplerBase()
 {
   this->m_NumberOfSamples = 1000;
 
+  /** Setup the random generator. */
+  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
+
 } // end Constructor
 
 
@@ -46,31 +48,103 @@ template <class TInputImage>
 void
 ImageRandomSamplerBase<TInputImage>::BeforeThreadedGenerateData(void)
 {
-  /** Create a random number generator. Also used in the ImageRandomConstIteratorWithIndex. */
-  typedef typename Statistics::MersenneTwisterRandomVariateGenerator::Pointer GeneratorPointer;
-  GeneratorPointer localGenerator = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
-  // \todo: should probably be global?
-
   /** Clear the random number list. */
   this->m_RandomNumberList.resize(0);
   this->m_RandomNumberList.reserve(this->m_NumberOfSamples);
 
   /** Fill the list with random numbers. */
   const double numPixels = static_cast<double>(this->GetCroppedInputImageRegion().GetNumberOfPixels());
-  localGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
+  this->m_RandomGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
   for (unsigned long i = 0; i < this->m_NumberOfSamples; i++)
   {
-    const double randomPosition = localGenerator->GetVariateWithOpenRange(numPixels - 0.5);
+    const double randomPosition = this->m_RandomGenerator->GetVariateWithOpenRange(numPixels - 0.5);
     this->m_RandomNumberList.push_back(randomPosition);
   }
-  localGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
+  this->m_RandomGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
 
   /** Initialize variables needed for threads. */
-  Superclass::BeforeThreadedGenerateData();
+  this->InitializeThreaderSampleContainers();
 
 } // end BeforeThreadedGenerateData()
 
 
+/**
+ * ******************* AfterThreadedGenerateData *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomSamplerBase<TInputImage>::AfterThreadedGenerateData(void)
+{
+  /** Merge the per-thread containers into the output. */
+  if (!this->m_ReuseSampleBuffers)
+  {
+    return Superclass::AfterThreadedGenerateData();
+  }
+
+  /** The threads have written directly in the output, so there is nothing to merge. */
+
+} // end AfterThreadedGenerateData()
+
+
+/**
+ * ******************* InitializeThreaderSampleContainers *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomSamplerBase<TInputImage>::InitializeThreaderSampleContainers(void)
+{
+  if (!this->m_ReuseSampleBuffers)
+  {
+    return Superclass::BeforeThreadedGenerateData();
+  }
+
+  /** Size the output, which only allocates when the number of samples has grown.
+   * Note that resize() of the underlying std::vector keeps its capacity.
+   */
+  this->m_ThreaderSampleContainer.clear();
+  this->GetOutput()->resize(this->m_NumberOfSamples);
+
+} // end InitializeThreaderSampleContainers()
+
+
+/**
+ * ******************* GetThreaderSamples *******************
+ */
+
+template <class TInputImage>
+auto
+ImageRandomSamplerBase<TInputImage>::GetThreaderSamples(ThreadIdType    threadId,
+                                                        unsigned long & sampleStart,
+                                                        unsigned long & chunkSize) -> ImageSampleType *
+{
+  /** Figure out which samples to process. */
+  chunkSize = this->GetNumberOfSamples() / this->GetNumberOfWorkUnits();
+  sampleStart = threadId * chunkSize;
+  if (threadId == this->GetNumberOfWorkUnits() - 1)
+  {
+    chunkSize = this->GetNumberOfSamples() - ((this->GetNumberOfWorkUnits() - 1) * chunkSize);
+  }
+  if (chunkSize == 0)
+  {
+    return nullptr;
+  }
+
+  /** Write directly in the output container. */
+  if (this->m_ReuseSampleBuffers)
+  {
+    return &(*this->GetOutput())[sampleStart];
+  }
+
+  /** Get a reference to the output of this thread and reserve memory for it. */
+  ImageSampleContainerPointer & sampleContainerThisThread = this->m_ThreaderSampleContainer[threadId];
+  sampleContainerThisThread->Reserve(chunkSize);
+  return &(*sampleContainerThisThread)[0];
+
+} // end GetThreaderSamples()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -82,6 +156,8 @@ ImageRandomSamplerBase<TInputImage>::PrintSelf(std::ostream & os, Indent indent)
   Superclass::PrintSelf(os, indent);
 
   os << indent << "NumberOfSamples: " << this->m_NumberOfSamples << std::endl;
+  os << indent << "ReuseSampleBuffers: " << this->m_ReuseSampleBuffers << std::endl;
+  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
@@ -30,9 +30,6 @@ namespace itk
 template <class TInputImage>
 ImageRandomSamplerSparseMask<TInputImage>::ImageRandomSamplerSparseMask()
 {
-  /** Setup random generator. */
-  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
-
   this->m_InternalFullSampler = InternalFullSamplerType::New();
 
 } // end Constructor
@@ -137,12 +134,7 @@ ImageRandomSamplerSparseMask<TInputImage>::BeforeThreadedGenerateData(void)
   }
 
   /** Initialize variables needed for threads. */
-  this->m_ThreaderSampleContainer.clear();
-  this->m_ThreaderSampleContainer.resize(this->GetNumberOfWorkUnits());
-  for (std::size_t i = 0; i < this->GetNumberOfWorkUnits(); i++)
-  {
-    this->m_ThreaderSampleContainer[i] = ImageSampleContainerType::New();
-  }
+  this->InitializeThreaderSampleContainers();
 
 } // end BeforeThreadedGenerateData()
 
@@ -158,28 +150,16 @@ ImageRandomSamplerSparseMask<TInputImage>::ThreadedGenerateData(const InputImage
   /** Get a handle to the full sampler output. */
   typename ImageSampleContainerType::Pointer allValidSamples = this->m_InternalFullSampler->GetOutput();
 
-  /** Figure out which samples to process. */
-  unsigned long chunkSize = this->GetNumberOfSamples() / this->GetNumberOfWorkUnits();
-  unsigned long sampleStart = threadId * chunkSize;
-  if (threadId == this->GetNumberOfWorkUnits() - 1)
-  {
-    chunkSize = this->GetNumberOfSamples() - ((this->GetNumberOfWorkUnits() - 1) * chunkSize);
-  }
-
-  /** Get a reference to the output and reserve memory for it. */
-  ImageSampleContainerPointer & sampleContainerThisThread = this->m_ThreaderSampleContainer[threadId];
-  sampleContainerThisThread->Reserve(chunkSize);
-
-  /** Setup an iterator over the sampleContainerThisThread. */
-  typename ImageSampleContainerType::Iterator      iter;
-  typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
+  /** Figure out which samples to process, and get a pointer to where they are stored. */
+  unsigned long     sampleStart = 0;
+  unsigned long     chunkSize = 0;
+  ImageSampleType * samples = this->GetThreaderSamples(threadId, sampleStart, chunkSize);
 
   /** Take random samples from the allValidSamples-container. */
-  unsigned long sampleId = sampleStart;
-  for (iter = sampleContainerThisThread->Begin(); iter != end; ++iter, sampleId++)
+  for (unsigned long i = 0; i < chunkSize; ++i)
   {
-    unsigned long randomIndex = static_cast<unsigned long>(this->m_RandomNumberList[sampleId]);
-    (*iter).Value() = allValidSamples->ElementAt(randomIndex);
+    unsigned long randomIndex = static_cast<unsigned long>(this->m_RandomNumberList[sampleStart + i]);
+    samples[i] = allValidSamples->ElementAt(randomIndex);
   }
 
 } // end ThreadedGenerateData()
@@ -196,7 +176,6 @@ ImageRandomSamplerSparseMask<TInputImage>::PrintSelf(std::ostream & os, Indent i
   Superclass::PrintSelf(os, indent);
 
   os << indent << "InternalFullSampler: " << this->m_InternalFullSampler.GetPointer() << std::endl;
-  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
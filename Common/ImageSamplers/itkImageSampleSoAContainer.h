@@ -0,0 +1,295 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageSampleSoAContainer_h
+#define itkImageSampleSoAContainer_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageSample.h"
+
+#include <algorithm> // For copy_n and max.
+#include <cstdint>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ImageSampleSoAContainer
+ *
+ * \brief A container that stores image samples as a structure of arrays.
+ *
+ * The ImageSample stores the coordinates and the value of a sample together,
+ * and the samplers store the samples in a VectorDataContainer (an array of
+ * structs). This container stores the same samples as a structure of arrays:
+ * one contiguous coordinate array per dimension, and one array with the image
+ * values. Each array starts at a 64 byte boundary, so loops over the samples
+ * read consecutive cache lines and can be vectorized.
+ *
+ * The AdvancedImageToImageMetric copies each block of samples that it evaluates
+ * into such a container, and maps the coordinate arrays with
+ * AdvancedTransform::TransformCoordinateArrays(). The memory is kept when the
+ * number of samples is reduced, so refilling the container does not allocate.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template <class TImage>
+class ImageSampleSoAContainer : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef ImageSampleSoAContainer  Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageSampleSoAContainer, Object);
+
+  /** Typedefs. */
+  typedef ImageSample<TImage>                   ImageSampleType;
+  typedef typename ImageSampleType::PointType   PointType;
+  typedef typename PointType::ValueType         CoordinateValueType;
+  typedef typename ImageSampleType::RealType    ValueType;
+  typedef std::vector<CoordinateValueType>      CoordinateBufferType;
+  typedef std::vector<ValueType>                ValueBufferType;
+
+  /** The dimension of the coordinates. */
+  itkStaticConstMacro(Dimension, unsigned int, PointType::PointDimension);
+
+  /** The alignment of the arrays, in bytes. */
+  itkStaticConstMacro(Alignment, unsigned int, 64);
+
+  /** Make room for numberOfSamples samples, keeping the current samples. */
+  void
+  Reserve(SizeValueType numberOfSamples)
+  {
+    if (numberOfSamples <= this->m_Capacity)
+    {
+      return;
+    }
+
+    /** Round the capacity up, such that each coordinate array starts aligned. */
+    const SizeValueType   elementsPerLine = Alignment / sizeof(CoordinateValueType);
+    const SizeValueType   capacity = ((numberOfSamples + elementsPerLine - 1) / elementsPerLine) * elementsPerLine;
+    CoordinateBufferType  coordinateBuffer(Dimension * capacity + elementsPerLine);
+    ValueBufferType       valueBuffer(capacity + Alignment / sizeof(ValueType));
+    CoordinateValueType * coordinates = AlignPointer(coordinateBuffer.data());
+    ValueType *           values = AlignPointer(valueBuffer.data());
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      std::copy_n(this->GetCoordinates(d), this->m_Size, coordinates + d * capacity);
+    }
+    std::copy_n(this->m_Values, this->m_Size, values);
+
+    this->m_CoordinateBuffer.swap(coordinateBuffer);
+    this->m_ValueBuffer.swap(valueBuffer);
+    this->m_Coordinates = coordinates;
+    this->m_Values = values;
+    this->m_Capacity = capacity;
+  }
+
+
+  /** Set the number of samples. The first samples are kept, new samples are undefined. */
+  void
+  Resize(SizeValueType numberOfSamples)
+  {
+    this->Reserve(numberOfSamples);
+    this->m_Size = numberOfSamples;
+  }
+
+
+  /** Add a sample at the end, reallocating when the capacity is exceeded. */
+  void
+  PushBack(const PointType & point, ValueType value)
+  {
+    if (this->m_Size == this->m_Capacity)
+    {
+      this->Reserve(std::max<SizeValueType>(2 * this->m_Capacity, 1024));
+    }
+    ++this->m_Size;
+    this->SetSample(this->m_Size - 1, point, value);
+  }
+
+
+  /** Add a sample at the end. */
+  void
+  PushBack(const ImageSampleType & sample)
+  {
+    this->PushBack(sample.m_ImageCoordinates, sample.m_ImageValue);
+  }
+
+
+  /** Remove all samples, keeping the memory. */
+  void
+  Clear(void)
+  {
+    this->m_Size = 0;
+  }
+
+
+  /** Release the memory. */
+  void
+  Squeeze(void)
+  {
+    CoordinateBufferType().swap(this->m_CoordinateBuffer);
+    ValueBufferType().swap(this->m_ValueBuffer);
+    this->m_Coordinates = nullptr;
+    this->m_Values = nullptr;
+    this->m_Capacity = 0;
+    this->m_Size = 0;
+  }
+
+
+  /** The number of samples. */
+  SizeValueType
+  Size(void) const
+  {
+    return this->m_Size;
+  }
+
+
+  /** The number of samples that fit without reallocation. */
+  SizeValueType
+  Capacity(void) const
+  {
+    return this->m_Capacity;
+  }
+
+
+  /** Store a sample at position i, with i < Size(). */
+  void
+  SetSample(SizeValueType i, const PointType & point, ValueType value)
+  {
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      this->m_Coordinates[d * this->m_Capacity + i] = point[d];
+    }
+    this->m_Values[i] = value;
+  }
+
+
+  /** Store a sample at position i, with i < Size(). */
+  void
+  SetSample(SizeValueType i, const ImageSampleType & sample)
+  {
+    this->SetSample(i, sample.m_ImageCoordinates, sample.m_ImageValue);
+  }
+
+
+  /** Get the coordinates of the sample at position i. */
+  PointType
+  GetPoint(SizeValueType i) const
+  {
+    PointType point;
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      point[d] = this->m_Coordinates[d * this->m_Capacity + i];
+    }
+    return point;
+  }
+
+
+  /** Get the image value of the sample at position i. */
+  ValueType
+  GetValue(SizeValueType i) const
+  {
+    return this->m_Values[i];
+  }
+
+
+  /** Get the (aligned) array with coordinate d of all samples. */
+  const CoordinateValueType *
+  GetCoordinates(unsigned int d) const
+  {
+    return this->m_Coordinates + d * this->m_Capacity;
+  }
+
+
+  CoordinateValueType *
+  GetCoordinates(unsigned int d)
+  {
+    return this->m_Coordinates + d * this->m_Capacity;
+  }
+
+
+  /** Get the (aligned) array with the image values of all samples. */
+  const ValueType *
+  GetValues(void) const
+  {
+    return this->m_Values;
+  }
+
+
+  ValueType *
+  GetValues(void)
+  {
+    return this->m_Values;
+  }
+
+
+protected:
+  /** The constructor. */
+  ImageSampleSoAContainer() = default;
+
+  /** The destructor. */
+  ~ImageSampleSoAContainer() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override
+  {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Size: " << this->m_Size << std::endl;
+    os << indent << "Capacity: " << this->m_Capacity << std::endl;
+  }
+
+
+private:
+  /** The deleted copy constructor. */
+  ImageSampleSoAContainer(const Self &) = delete;
+  /** The deleted assignment operator. */
+  void
+  operator=(const Self &) = delete;
+
+  /** Returns the first address in the buffer that is aligned. */
+  template <class T>
+  static T *
+  AlignPointer(T * buffer)
+  {
+    const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(buffer);
+    const std::uintptr_t aligned = (address + Alignment - 1) & ~static_cast<std::uintptr_t>(Alignment - 1);
+    return reinterpret_cast<T *>(aligned);
+  }
+
+
+  /** Member variables. */
+  CoordinateBufferType  m_CoordinateBuffer;
+  ValueBufferType       m_ValueBuffer;
+  CoordinateValueType * m_Coordinates{ nullptr };
+  ValueType *           m_Values{ nullptr };
+  SizeValueType         m_Size{ 0 };
+  SizeValueType         m_Capacity{ 0 };
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkImageSampleSoAContainer_h
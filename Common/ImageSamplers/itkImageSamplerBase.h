@@ -179,6 +179,13 @@ public:
   /** \todo: Temporary, should think about interface. */
   itkSetMacro(UseMultiThread, bool);
 
+  /** Get the time (in seconds) that the last generation of the samples took. */
+  itkGetConstMacro(SamplingTime, double);
+
+  /** Generates the samples, and records how long that took. */
+  void
+  UpdateOutputData(DataObject * output) override;
+
 protected:
   /** The constructor. */
   ImageSamplerBase();
@@ -226,6 +233,8 @@ protected:
   // tmp?
   bool m_UseMultiThread;
 
+  double m_SamplingTime{ 0.0 };
+
 private:
   /** The deleted copy constructor. */
   ImageSamplerBase(const Self &) = delete;
@@ -20,6 +20,8 @@
 
 #include "itkImageSamplerBase.h"
 
+#include "itkTimeProbe.h"
+
 namespace itk
 {
 
@@ -168,6 +170,24 @@ ImageSamplerBase<TInputImage>::SetNumberOfInputImageRegions(const unsigned int _
 } // end SetNumberOfInputImageRegions()
 
 
+/**
+ * ******************* UpdateOutputData *******************
+ */
+
+template <class TInputImage>
+void
+ImageSamplerBase<TInputImage>::UpdateOutputData(DataObject * output)
+{
+  /** The samples are generated in this call, if the output is out of date. */
+  TimeProbe timer;
+  timer.Start();
+  Superclass::UpdateOutputData(output);
+  timer.Stop();
+  this->m_SamplingTime = timer.GetTotal();
+
+} // end UpdateOutputData()
+
+
 /**
  * ******************* GenerateInputRequestedRegion *******************
  */
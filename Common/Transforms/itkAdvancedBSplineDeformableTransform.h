@@ -168,6 +168,7 @@ public:
   typedef typename Superclass::OutputCovariantVectorType OutputCovariantVectorType;
 
   typedef typename Superclass ::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndexType       NonZeroJacobianIndexType;
   typedef typename Superclass::SpatialJacobianType            SpatialJacobianType;
   typedef typename Superclass ::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType             SpatialHessianType;
@@ -235,6 +236,12 @@ public:
                  ParameterIndexArrayType & indices,
                  bool &                    inside) const;
 
+  /** Transform a block of points at once. The weights and indices are allocated once per block. */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  SizeValueType          numberOfPoints) const override;
+
   /** Get number of weights. */
   unsigned long
   GetNumberOfWeights(void) const
@@ -262,6 +269,14 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient for a block of points. */
+  void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            SizeValueType                   numberOfPoints,
+                                            ParametersValueType *           imageJacobians,
+                                            NonZeroJacobianIndexType *      nonZeroJacobianIndices) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
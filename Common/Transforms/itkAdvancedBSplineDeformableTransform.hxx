@@ -325,6 +325,30 @@ AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::Tran
 }
 
 
+// Transform a block of points
+template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
+  /** Allocate memory on the stack, once for all points. */
+  const unsigned long                         numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType             weightsArray[numberOfWeights];
+  typename ParameterIndexArrayType::ValueType indicesArray[numberOfWeights];
+  WeightsType                                 weights(weightsArray, numberOfWeights, false);
+  ParameterIndexArrayType                     indices(indicesArray, numberOfWeights, false);
+
+  bool inside;
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    const InputPointType inputPoint = inputPoints[i]; // may be in-place
+    this->TransformPoint(inputPoint, outputPoints[i], weights, indices, inside);
+  }
+}
+
+
 /**
  * ********************* GetNumberOfAffectedWeights ****************************
  */
@@ -502,6 +526,36 @@ AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::Eval
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  SizeValueType                   numberOfPoints,
+  ParametersValueType *           imageJacobians,
+  NonZeroJacobianIndexType *      nonZeroJacobianIndices) const
+{
+  /** The image Jacobian is a view on the output memory, the indices are copied.
+   * The call is not virtual, subclasses with a different product override this function.
+   */
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  DerivativeType               imageJacobian;
+  NonZeroJacobianIndicesType   nzji(nnzji);
+
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    imageJacobian.SetData(imageJacobians + i * nnzji, nnzji, false);
+    this->Self::EvaluateJacobianWithImageGradientProduct(ipps[i], movingImageGradients[i], imageJacobian, nzji);
+    std::copy(nzji.begin(), nzji.end(), nonZeroJacobianIndices + i * nnzji);
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
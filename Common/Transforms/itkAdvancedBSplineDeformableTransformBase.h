@@ -72,6 +72,7 @@ public:
   typedef typename Superclass::TransformCategoryEnum     TransformCategoryEnum;
 
   typedef typename Superclass ::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndexType       NonZeroJacobianIndexType;
   typedef typename Superclass::SpatialJacobianType            SpatialJacobianType;
   typedef typename Superclass ::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType             SpatialHessianType;
@@ -19,7 +19,9 @@
 #define itkAdvancedCombinationTransform_h
 
 #include "itkAdvancedTransform.h"
+#include "itkImage.h"
 #include "itkMacro.h"
+#include "itkVectorLinearInterpolateImageFunction.h"
 
 namespace itk
 {
@@ -49,6 +51,10 @@ namespace itk
  * Note: It is mandatory to set a current transform. An initial transform
  * is not mandatory.
  *
+ * The initial transform may be cached with CacheInitialTransform(), so that
+ * a long chain of initial transforms is evaluated only once per grid point,
+ * instead of at every call of TransformPoint().
+ *
  * \ingroup Transforms
  */
 
@@ -88,6 +94,7 @@ public:
   typedef typename Superclass::InputPointType                InputPointType;
   typedef typename Superclass::OutputPointType               OutputPointType;
   typedef typename Superclass::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndexType      NonZeroJacobianIndexType;
   typedef typename Superclass::SpatialJacobianType           SpatialJacobianType;
   typedef typename Superclass::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType            SpatialHessianType;
@@ -124,6 +131,35 @@ public:
 
   itkGetModifiableObjectMacro(InitialTransform, InitialTransformType);
 
+  /** Typedefs for the cache of the initial transform. */
+  typedef ImageBase<NDimensions>                              InitialTransformCacheGridType;
+  typedef Vector<ScalarType, NDimensions>                     InitialTransformCacheVectorType;
+  typedef Image<InitialTransformCacheVectorType, NDimensions> InitialTransformCacheImageType;
+  typedef typename InitialTransformCacheImageType::Pointer    InitialTransformCacheImagePointer;
+
+  /** Precompute the initial transform, and use the precomputed values instead
+   * of the initial transform itself to map the points in TransformPoint(),
+   * GetJacobian() and EvaluateJacobianWithImageGradientProduct(). A linear
+   * initial transform is merged into a single matrix and offset. Otherwise its
+   * displacements are stored at the points of the given grid, and linearly
+   * interpolated in between, so the cache is exact at the grid points. Points
+   * outside the grid are mapped by the initial transform itself. The spatial
+   * derivatives of the initial transform are never taken from the cache.
+   * The cache is cleared when another initial transform is set, but not when
+   * the initial transform is modified.
+   */
+  void
+  CacheInitialTransform(const InitialTransformCacheGridType * grid);
+
+  /** Remove the cache of the initial transform, so that the initial transform
+   * itself is evaluated again.
+   */
+  void
+  ClearInitialTransformCache(void);
+
+  /** Whether the initial transform is cached. */
+  itkGetConstMacro(InitialTransformIsCached, bool);
+
   /** Set/Get a pointer to the CurrentTransform.
    * Make sure to set the CurrentTransform before calling functions like
    * TransformPoint(), GetJacobian(), SetParameters() etc.
@@ -160,6 +196,20 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
 
+  /** Method to transform a block of points. */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  SizeValueType          numberOfPoints) const override;
+
+  /** Method to transform a block of points stored as a structure of arrays. Forwards to
+   * the current transform when there is no initial transform.
+   */
+  void
+  TransformCoordinateArrays(const double * const * inputCoordinates,
+                            OutputPointType *      outputPoints,
+                            SizeValueType          numberOfPoints) const override;
+
   /** ITK4 change:
    * The following pure virtual functions must be overloaded.
    * For now just throw an exception, since these are not used in elastix.
@@ -263,6 +313,14 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient for a block of points. */
+  void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            SizeValueType                   numberOfPoints,
+                                            ParametersValueType *           imageJacobians,
+                                            NonZeroJacobianIndexType *      nonZeroJacobianIndices) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
@@ -348,6 +406,16 @@ protected:
    * Methods to transform a point.
    */
 
+  /** INITIAL: \f$T_0(x)\f$, possibly taken from the cache. */
+  inline OutputPointType
+  TransformPointWithInitialTransform(const InputPointType & point) const;
+
+  /** INITIAL: \f$T_0(x)\f$ for a block of points, possibly taken from the cache. */
+  void
+  TransformPointsWithInitialTransform(const InputPointType * inputPoints,
+                                      OutputPointType *      outputPoints,
+                                      SizeValueType          numberOfPoints) const;
+
   /** ADDITION: \f$T(x) = T_0(x) + T_1(x) - x\f$ */
   inline OutputPointType
   TransformPointUseAddition(const InputPointType & point) const;
@@ -575,6 +643,10 @@ protected:
                                                 NonZeroJacobianIndicesType &   nonZeroJacobianIndices) const;
 
 private:
+  /** Typedefs for the interpolation of the cached displacements. */
+  typedef VectorLinearInterpolateImageFunction<InitialTransformCacheImageType, ScalarType> CacheInterpolatorType;
+  typedef typename CacheInterpolatorType::Pointer                                         CacheInterpolatorPointer;
+
   /** Declaration of members. */
   InitialTransformPointer m_InitialTransform;
   CurrentTransformPointer m_CurrentTransform;
@@ -609,6 +681,15 @@ private:
   bool m_UseAddition;
   bool m_UseComposition;
 
+  /** The cache of the initial transform: either a matrix and offset, or,
+   * if the image is set, the interpolated displacements.
+   */
+  bool                              m_InitialTransformIsCached;
+  SpatialJacobianType               m_InitialTransformCacheMatrix;
+  OutputVectorType                  m_InitialTransformCacheOffset;
+  InitialTransformCacheImagePointer m_InitialTransformCacheImage;
+  CacheInterpolatorPointer          m_InitialTransformCacheInterpolator;
+
 private:
   AdvancedCombinationTransform(const Self &) = delete;
   void
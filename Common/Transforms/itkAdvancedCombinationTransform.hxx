@@ -19,6 +19,9 @@
 #define itkAdvancedCombinationTransform_hxx
 
 #include "itkAdvancedCombinationTransform.h"
+#include "itkTransformToDisplacementFieldFilter.h"
+
+#include <algorithm> // std::min
 
 namespace itk
 {
@@ -39,6 +42,11 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::AdvancedCombinationTrans
   this->m_UseAddition = false;
   this->m_UseComposition = true;
 
+  /** No cache of the initial transform by default. */
+  this->m_InitialTransformIsCached = false;
+  this->m_InitialTransformCacheMatrix.SetIdentity();
+  this->m_InitialTransformCacheOffset.Fill(0.0);
+
   /** Set everything to have no current transform. */
   this->m_SelectedTransformPointFunction = &Self::TransformPointNoCurrentTransform;
   //   this->m_SelectedGetJacobianFunction
@@ -520,6 +528,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::SetInitialTransform(Init
   if (this->m_InitialTransform != _arg)
   {
     this->m_InitialTransform = _arg;
+    this->ClearInitialTransformCache();
     this->Modified();
     this->UpdateCombinationMethod();
   }
@@ -527,6 +536,75 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::SetInitialTransform(Init
 } // end SetInitialTransform()
 
 
+/**
+ * ******************* CacheInitialTransform **********************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::CacheInitialTransform(
+  const InitialTransformCacheGridType * grid)
+{
+  this->ClearInitialTransformCache();
+  if (this->m_InitialTransform.IsNull())
+  {
+    return;
+  }
+
+  if (this->m_InitialTransform->IsLinear())
+  {
+    /** Merge the linear initial transform(s) into T_0(x) = A x + t. */
+    InputPointType zeroPoint;
+    zeroPoint.Fill(0.0);
+    this->m_InitialTransform->GetSpatialJacobian(zeroPoint, this->m_InitialTransformCacheMatrix);
+    this->m_InitialTransformCacheOffset = this->m_InitialTransform->TransformPoint(zeroPoint) - zeroPoint;
+  }
+  else
+  {
+    if (grid == nullptr)
+    {
+      itkExceptionMacro(<< "A grid is needed to cache a nonlinear initial transform.");
+    }
+
+    /** Compute the displacements of the initial transform at the grid points, multi-threaded. */
+    typedef TransformToDisplacementFieldFilter<InitialTransformCacheImageType, ScalarType> DisplacementFilterType;
+    const auto displacementFilter = DisplacementFilterType::New();
+    displacementFilter->SetTransform(this->m_InitialTransform.GetPointer());
+    displacementFilter->SetReferenceImage(grid);
+    displacementFilter->UseReferenceImageOn();
+    displacementFilter->Update();
+
+    this->m_InitialTransformCacheImage = displacementFilter->GetOutput();
+    this->m_InitialTransformCacheImage->DisconnectPipeline();
+    this->m_InitialTransformCacheInterpolator = CacheInterpolatorType::New();
+    this->m_InitialTransformCacheInterpolator->SetInputImage(this->m_InitialTransformCacheImage);
+  }
+
+  this->m_InitialTransformIsCached = true;
+  this->Modified();
+
+} // end CacheInitialTransform()
+
+
+/**
+ * ******************* ClearInitialTransformCache **********************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::ClearInitialTransformCache(void)
+{
+  if (this->m_InitialTransformIsCached)
+  {
+    this->m_InitialTransformIsCached = false;
+    this->m_InitialTransformCacheImage = nullptr;
+    this->m_InitialTransformCacheInterpolator = nullptr;
+    this->Modified();
+  }
+
+} // end ClearInitialTransformCache()
+
+
 /**
  * ******************* SetCurrentTransform **********************
  */
@@ -695,6 +773,77 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::NoCurrentTransformSet(vo
  *
  */
 
+/**
+ * ************* TransformPointWithInitialTransform **********************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+typename AdvancedCombinationTransform<TScalarType, NDimensions>::OutputPointType
+AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPointWithInitialTransform(
+  const InputPointType & point) const
+{
+  if (!this->m_InitialTransformIsCached)
+  {
+    return this->m_InitialTransform->TransformPoint(point);
+  }
+
+  if (this->m_InitialTransformCacheImage.IsNull())
+  {
+    return this->m_InitialTransformCacheMatrix * point + this->m_InitialTransformCacheOffset;
+  }
+
+  /** Interpolate the cached displacements, if the point is inside the grid. */
+  typename CacheInterpolatorType::ContinuousIndexType cindex;
+  this->m_InitialTransformCacheImage->TransformPhysicalPointToContinuousIndex(point, cindex);
+  const typename InitialTransformCacheImageType::RegionType & region =
+    this->m_InitialTransformCacheImage->GetBufferedRegion();
+  for (unsigned int i = 0; i < SpaceDimension; ++i)
+  {
+    const IndexValueType start = region.GetIndex(i);
+    const IndexValueType end = start + static_cast<IndexValueType>(region.GetSize(i)) - 1;
+    if (!(cindex[i] >= start && cindex[i] <= end))
+    {
+      return this->m_InitialTransform->TransformPoint(point);
+    }
+  }
+
+  const typename CacheInterpolatorType::OutputType displacement =
+    this->m_InitialTransformCacheInterpolator->EvaluateAtContinuousIndex(cindex);
+  OutputPointType outputPoint;
+  for (unsigned int i = 0; i < SpaceDimension; ++i)
+  {
+    outputPoint[i] = point[i] + displacement[i];
+  }
+  return outputPoint;
+
+} // end TransformPointWithInitialTransform()
+
+
+/**
+ * ************* TransformPointsWithInitialTransform **********************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPointsWithInitialTransform(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
+  if (!this->m_InitialTransformIsCached)
+  {
+    this->m_InitialTransform->TransformPoints(inputPoints, outputPoints, numberOfPoints);
+    return;
+  }
+
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    outputPoints[i] = this->TransformPointWithInitialTransform(inputPoints[i]);
+  }
+
+} // end TransformPointsWithInitialTransform()
+
+
 /**
  * ************* TransformPointUseAddition **********************
  */
@@ -704,7 +853,7 @@ typename AdvancedCombinationTransform<TScalarType, NDimensions>::OutputPointType
 AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPointUseAddition(const InputPointType & point) const
 {
   /** The Initial transform. */
-  OutputPointType out0 = this->m_InitialTransform->TransformPoint(point);
+  OutputPointType out0 = this->TransformPointWithInitialTransform(point);
 
   /** The Current transform. */
   OutputPointType out = this->m_CurrentTransform->TransformPoint(point);
@@ -728,7 +877,7 @@ template <typename TScalarType, unsigned int NDimensions>
 typename AdvancedCombinationTransform<TScalarType, NDimensions>::OutputPointType
 AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPointUseComposition(const InputPointType & point) const
 {
-  return this->m_CurrentTransform->TransformPoint(this->m_InitialTransform->TransformPoint(point));
+  return this->m_CurrentTransform->TransformPoint(this->TransformPointWithInitialTransform(point));
 
 } // end TransformPointUseComposition()
 
@@ -792,7 +941,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetJacobianUseCompositio
   JacobianType &               j,
   NonZeroJacobianIndicesType & nonZeroJacobianIndices) const
 {
-  this->m_CurrentTransform->GetJacobian(this->m_InitialTransform->TransformPoint(ipp), j, nonZeroJacobianIndices);
+  this->m_CurrentTransform->GetJacobian(this->TransformPointWithInitialTransform(ipp), j, nonZeroJacobianIndices);
 
 } // end GetJacobianUseComposition()
 
@@ -861,7 +1010,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImag
   NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const
 {
   this->m_CurrentTransform->EvaluateJacobianWithImageGradientProduct(
-    this->m_InitialTransform->TransformPoint(ipp), movingImageGradient, imageJacobian, nonZeroJacobianIndices);
+    this->TransformPointWithInitialTransform(ipp), movingImageGradient, imageJacobian, nonZeroJacobianIndices);
 
 } // end EvaluateJacobianWithImageGradientProductUseComposition()
 
@@ -931,7 +1080,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetSpatialJacobianUseCom
 {
   SpatialJacobianType sj0, sj1;
   this->m_InitialTransform->GetSpatialJacobian(ipp, sj0);
-  this->m_CurrentTransform->GetSpatialJacobian(this->m_InitialTransform->TransformPoint(ipp), sj1);
+  this->m_CurrentTransform->GetSpatialJacobian(this->TransformPointWithInitialTransform(ipp), sj1);
 
   sj = sj1 * sj0;
 
@@ -1005,7 +1154,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetSpatialHessianUseComp
 
   /** Transform the input point. */
   // \todo this has already been computed and it is expensive.
-  InputPointType transformedPoint = this->m_InitialTransform->TransformPoint(ipp);
+  InputPointType transformedPoint = this->TransformPointWithInitialTransform(ipp);
 
   /** Compute the (Jacobian of the) spatial Jacobian / Hessian of the
    * internal transforms.
@@ -1111,7 +1260,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetJacobianOfSpatialJaco
   JacobianOfSpatialJacobianType jsj1;
   this->m_InitialTransform->GetSpatialJacobian(ipp, sj0);
   this->m_CurrentTransform->GetJacobianOfSpatialJacobian(
-    this->m_InitialTransform->TransformPoint(ipp), jsj1, nonZeroJacobianIndices);
+    this->TransformPointWithInitialTransform(ipp), jsj1, nonZeroJacobianIndices);
 
   jsj.resize(nonZeroJacobianIndices.size());
   for (unsigned int mu = 0; mu < nonZeroJacobianIndices.size(); ++mu)
@@ -1138,7 +1287,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetJacobianOfSpatialJaco
   JacobianOfSpatialJacobianType jsj1;
   this->m_InitialTransform->GetSpatialJacobian(ipp, sj0);
   this->m_CurrentTransform->GetJacobianOfSpatialJacobian(
-    this->m_InitialTransform->TransformPoint(ipp), sj1, jsj1, nonZeroJacobianIndices);
+    this->TransformPointWithInitialTransform(ipp), sj1, jsj1, nonZeroJacobianIndices);
 
   sj = sj1 * sj0;
   jsj.resize(nonZeroJacobianIndices.size());
@@ -1270,7 +1419,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetJacobianOfSpatialHess
 
   /** Transform the input point. */
   // \todo: this has already been computed and it is expensive.
-  InputPointType transformedPoint = this->m_InitialTransform->TransformPoint(ipp);
+  InputPointType transformedPoint = this->TransformPointWithInitialTransform(ipp);
 
   /** Compute the (Jacobian of the) spatial Jacobian / Hessian of the
    * internal transforms. */
@@ -1333,7 +1482,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetJacobianOfSpatialHess
 
   /** Transform the input point. */
   // \todo this has already been computed and it is expensive.
-  InputPointType transformedPoint = this->m_InitialTransform->TransformPoint(ipp);
+  InputPointType transformedPoint = this->TransformPointWithInitialTransform(ipp);
 
   /** Compute the (Jacobian of the) spatial Jacobian / Hessian of the
    * internal transforms.
@@ -1485,6 +1634,64 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPoint(const Inp
 } // end TransformPoint()
 
 
+/**
+ * ****************** TransformPoints ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPoints(const InputPointType * inputPoints,
+                                                                        OutputPointType *      outputPoints,
+                                                                        SizeValueType          numberOfPoints) const
+{
+  if (this->m_CurrentTransform.IsNull())
+  {
+    this->NoCurrentTransformSet();
+  }
+  else if (this->m_InitialTransform.IsNull())
+  {
+    this->m_CurrentTransform->TransformPoints(inputPoints, outputPoints, numberOfPoints);
+  }
+  else if (this->m_UseAddition)
+  {
+    for (SizeValueType i = 0; i < numberOfPoints; ++i)
+    {
+      outputPoints[i] = this->TransformPointUseAddition(inputPoints[i]);
+    }
+  }
+  else
+  {
+    /** Composition: the current transform is applied in-place. */
+    this->TransformPointsWithInitialTransform(inputPoints, outputPoints, numberOfPoints);
+    this->m_CurrentTransform->TransformPoints(outputPoints, outputPoints, numberOfPoints);
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ****************** TransformCoordinateArrays ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::TransformCoordinateArrays(
+  const double * const * inputCoordinates,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
+  if (this->m_CurrentTransform.IsNotNull() && this->m_InitialTransform.IsNull())
+  {
+    this->m_CurrentTransform->TransformCoordinateArrays(inputCoordinates, outputPoints, numberOfPoints);
+  }
+  else
+  {
+    Superclass::TransformCoordinateArrays(inputCoordinates, outputPoints, numberOfPoints);
+  }
+
+} // end TransformCoordinateArrays()
+
+
 /**
  * ****************** GetJacobian ****************************
  */
@@ -1521,6 +1728,51 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImag
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ****************** EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  SizeValueType                   numberOfPoints,
+  ParametersValueType *           imageJacobians,
+  NonZeroJacobianIndexType *      nonZeroJacobianIndices) const
+{
+  if (this->m_CurrentTransform.IsNull())
+  {
+    this->NoCurrentTransformSet();
+  }
+  else if (this->m_InitialTransform.IsNull() || this->m_UseAddition)
+  {
+    this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(
+      ipps, movingImageGradients, numberOfPoints, imageJacobians, nonZeroJacobianIndices);
+  }
+  else
+  {
+    /** Composition: the Jacobian of the current transform is evaluated at the
+     * points mapped by the initial transform. Map them in chunks on the stack.
+     */
+    const unsigned int           chunkSize = 64;
+    const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+    InputPointType               mappedPoints[chunkSize];
+    for (SizeValueType begin = 0; begin < numberOfPoints; begin += chunkSize)
+    {
+      const SizeValueType size = std::min<SizeValueType>(chunkSize, numberOfPoints - begin);
+      this->TransformPointsWithInitialTransform(ipps + begin, mappedPoints, size);
+      this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(mappedPoints,
+                                                                          movingImageGradients + begin,
+                                                                          size,
+                                                                          imageJacobians + begin * nnzji,
+                                                                          nonZeroJacobianIndices + begin * nnzji);
+    }
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ****************** GetSpatialJacobian ****************************
  */
@@ -131,11 +131,14 @@ public:
   typedef typename Superclass::TransformCategoryEnum      TransformCategoryEnum;
 
   typedef typename Superclass ::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndexType       NonZeroJacobianIndexType;
   typedef typename Superclass::SpatialJacobianType            SpatialJacobianType;
   typedef typename Superclass ::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType             SpatialHessianType;
   typedef typename Superclass ::JacobianOfSpatialHessianType  JacobianOfSpatialHessianType;
   typedef typename Superclass::InternalMatrixType             InternalMatrixType;
+  typedef typename Superclass::ParametersValueType            ParametersValueType;
+  typedef typename Superclass::MovingImageGradientType        MovingImageGradientType;
 
   /** Standard matrix type for this class. */
   typedef Matrix<TScalarType, itkGetStaticConstMacro(OutputSpaceDimension), itkGetStaticConstMacro(InputSpaceDimension)>
@@ -346,6 +349,20 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
 
+  /** Transform a block of points at once, without virtual calls per point. */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  SizeValueType          numberOfPoints) const override;
+
+  /** Transform a block of points stored as a structure of arrays, one output
+   * coordinate at a time, with loops over the contiguous input arrays.
+   */
+  void
+  TransformCoordinateArrays(const double * const * inputCoordinates,
+                            OutputPointType *      outputPoints,
+                            SizeValueType          numberOfPoints) const override;
+
   OutputVectorType
   TransformVector(const InputVectorType & vector) const override;
 
@@ -407,6 +424,18 @@ public:
   void
   GetJacobian(const InputPointType &, JacobianType &, NonZeroJacobianIndicesType &) const override;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient for a block of points.
+   * The Jacobian of a matrix-offset transform is an affine function of the input point, so
+   * GetJacobian() is only evaluated at InputSpaceDimension + 1 points per block. This also
+   * holds for the subclasses, which only differ in the parameterization of the matrix and offset.
+   */
+  void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            SizeValueType                   numberOfPoints,
+                                            ParametersValueType *           imageJacobians,
+                                            NonZeroJacobianIndexType *      nonZeroJacobianIndices) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType &, SpatialJacobianType &) const override;
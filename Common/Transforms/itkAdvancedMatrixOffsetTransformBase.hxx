@@ -39,6 +39,9 @@
 #include "itkAdvancedMatrixOffsetTransformBase.h"
 #include "vnl/algo/vnl_matrix_inverse.h"
 
+#include <algorithm> // std::copy
+#include <vector>
+
 namespace itk
 {
 
@@ -252,6 +255,50 @@ AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensio
 }
 
 
+// Transform a block of points
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    outputPoints[i] = m_Matrix * inputPoints[i] + m_Offset;
+  }
+}
+
+
+// Transform a block of points stored as a structure of arrays
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>::TransformCoordinateArrays(
+  const double * const * inputCoordinates,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
+  for (unsigned int d = 0; d < NOutputDimensions; ++d)
+  {
+    const ScalarType offset = m_Offset[d];
+    ScalarType       row[NInputDimensions];
+    for (unsigned int j = 0; j < NInputDimensions; ++j)
+    {
+      row[j] = m_Matrix[d][j];
+    }
+    for (SizeValueType i = 0; i < numberOfPoints; ++i)
+    {
+      ScalarType value = offset;
+      for (unsigned int j = 0; j < NInputDimensions; ++j)
+      {
+        value += row[j] * inputCoordinates[j][i];
+      }
+      outputPoints[i][d] = value;
+    }
+  }
+}
+
+
 // Transform a vector
 template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
 typename AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>::OutputVectorType
@@ -556,6 +603,96 @@ AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensio
 } // end GetJacobian()
 
 
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>::
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            SizeValueType                   numberOfPoints,
+                                            ParametersValueType *           imageJacobians,
+                                            NonZeroJacobianIndexType *      nonZeroJacobianIndices) const
+{
+  if (numberOfPoints == 0)
+  {
+    return;
+  }
+
+  /** Write the Jacobian as J(p) = J(c) + sum_d (p-c)_d * ( J(c + e_d) - J(c) ), with c the center.
+   * Store it per parameter k as the (InputSpaceDimension + 1) x OutputSpaceDimension
+   * coefficients of the constant term and the terms linear in (p-c)_d.
+   * The virtual GetJacobian() is used, to support the parameterization of the subclasses.
+   */
+  const unsigned int         numberOfTerms = (InputSpaceDimension + 1) * OutputSpaceDimension;
+  const InputPointType       center = this->GetCenter();
+  JacobianType               jacobian;
+  NonZeroJacobianIndicesType nzji;
+  this->GetJacobian(center, jacobian, nzji);
+  const NumberOfParametersType nnzji = jacobian.cols();
+
+  std::vector<ParametersValueType> coefficients(nnzji * numberOfTerms);
+  for (NumberOfParametersType k = 0; k < nnzji; ++k)
+  {
+    for (unsigned int o = 0; o < OutputSpaceDimension; ++o)
+    {
+      coefficients[k * numberOfTerms + o] = jacobian(o, k);
+    }
+  }
+  for (unsigned int d = 0; d < InputSpaceDimension; ++d)
+  {
+    InputPointType point = center;
+    point[d] += 1.0;
+    JacobianType jacobianD;
+    this->GetJacobian(point, jacobianD, nzji);
+    for (NumberOfParametersType k = 0; k < nnzji; ++k)
+    {
+      for (unsigned int o = 0; o < OutputSpaceDimension; ++o)
+      {
+        coefficients[k * numberOfTerms + (d + 1) * OutputSpaceDimension + o] = jacobianD(o, k) - jacobian(o, k);
+      }
+    }
+  }
+
+  /** Loop over the points. The nonzero Jacobian indices are the same for all points. */
+  ParametersValueType terms[numberOfTerms];
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    const MovingImageGradientType & movingImageGradient = movingImageGradients[i];
+    for (unsigned int o = 0; o < OutputSpaceDimension; ++o)
+    {
+      terms[o] = movingImageGradient[o];
+    }
+    for (unsigned int d = 0; d < InputSpaceDimension; ++d)
+    {
+      const ParametersValueType v = ipps[i][d] - center[d];
+      for (unsigned int o = 0; o < OutputSpaceDimension; ++o)
+      {
+        terms[(d + 1) * OutputSpaceDimension + o] = v * movingImageGradient[o];
+      }
+    }
+
+    ParametersValueType *       imageJacobian = imageJacobians + i * nnzji;
+    const ParametersValueType * coefficient = coefficients.data();
+    for (NumberOfParametersType k = 0; k < nnzji; ++k)
+    {
+      ParametersValueType sum = 0.0;
+      for (unsigned int t = 0; t < numberOfTerms; ++t)
+      {
+        sum += terms[t] * coefficient[t];
+      }
+      imageJacobian[k] = sum;
+      coefficient += numberOfTerms;
+    }
+
+    std::copy(nzji.begin(), nzji.end(), nonZeroJacobianIndices + i * nnzji);
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
@@ -129,6 +129,7 @@ public:
    * gain for the SpatialHessianType.
    */
   typedef std::vector<unsigned long>                                    NonZeroJacobianIndicesType;
+  typedef typename NonZeroJacobianIndicesType::value_type               NonZeroJacobianIndexType;
   typedef Matrix<ScalarType, OutputSpaceDimension, InputSpaceDimension> SpatialJacobianType;
   typedef std::vector<SpatialJacobianType>                              JacobianOfSpatialJacobianType;
   // \todo: think about the SpatialHessian type, should be a 3D native type
@@ -193,6 +194,42 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const;
 
+  /** Transform a block of numberOfPoints points at once.
+   * The default implementation calls TransformPoint() for each point. Transforms
+   * that can do better, by avoiding the virtual call and the setup per point,
+   * override this function. The outputPoints may not overlap the inputPoints,
+   * unless they are identical (in-place).
+   */
+  virtual void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  SizeValueType          numberOfPoints) const;
+
+  /** Transform a block of numberOfPoints points that are stored as a structure of arrays:
+   * inputCoordinates[d][i] is coordinate d of point i. The coordinates are doubles, like
+   * those of image points. The default implementation gathers the points in chunks and
+   * calls TransformPoints(). Transforms that can use the contiguous arrays directly
+   * override this function.
+   */
+  virtual void
+  TransformCoordinateArrays(const double * const * inputCoordinates,
+                            OutputPointType *      outputPoints,
+                            SizeValueType          numberOfPoints) const;
+
+  /** Compute EvaluateJacobianWithImageGradientProduct() for a block of numberOfPoints
+   * points at once. The results of point i are written contiguously at
+   * imageJacobians + i * n and nonZeroJacobianIndices + i * n,
+   * with n = GetNumberOfNonZeroJacobianIndices().
+   * The default implementation calls EvaluateJacobianWithImageGradientProduct()
+   * for each point.
+   */
+  virtual void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            SizeValueType                   numberOfPoints,
+                                            ParametersValueType *           imageJacobians,
+                                            NonZeroJacobianIndexType *      nonZeroJacobianIndices) const;
+
   /** Compute the spatial Jacobian of the transformation.
    *
    * The spatial Jacobian is expressed as a vector of partial derivatives of the
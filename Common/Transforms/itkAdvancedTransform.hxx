@@ -36,6 +36,8 @@
 
 #include "itkAdvancedTransform.h"
 
+#include <algorithm> // std::copy, std::min
+
 namespace itk
 {
 
@@ -106,6 +108,83 @@ AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::EvaluateJac
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    outputPoints[i] = this->TransformPoint(inputPoints[i]);
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* TransformCoordinateArrays ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::TransformCoordinateArrays(
+  const double * const * inputCoordinates,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
+  /** Gather the points in chunks on the stack, and map each chunk at once. */
+  const SizeValueType chunkSize = 64;
+  InputPointType      inputPoints[chunkSize];
+  for (SizeValueType begin = 0; begin < numberOfPoints; begin += chunkSize)
+  {
+    const SizeValueType n = std::min(chunkSize, numberOfPoints - begin);
+    for (SizeValueType i = 0; i < n; ++i)
+    {
+      for (unsigned int d = 0; d < NInputDimensions; ++d)
+      {
+        inputPoints[i][d] = static_cast<TScalarType>(inputCoordinates[d][begin + i]);
+      }
+    }
+    this->TransformPoints(inputPoints, outputPoints + begin, n);
+  }
+
+} // end TransformCoordinateArrays()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  SizeValueType                   numberOfPoints,
+  ParametersValueType *           imageJacobians,
+  NonZeroJacobianIndexType *      nonZeroJacobianIndices) const
+{
+  /** The image Jacobian is a view on the output memory, the indices are copied. */
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  DerivativeType               imageJacobian;
+  NonZeroJacobianIndicesType   nzji(nnzji);
+
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    imageJacobian.SetData(imageJacobians + i * nnzji, nnzji, false);
+    this->EvaluateJacobianWithImageGradientProduct(ipps[i], movingImageGradients[i], imageJacobian, nzji);
+    std::copy(nzji.begin(), nzji.end(), nonZeroJacobianIndices + i * nnzji);
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetNumberOfNonZeroJacobianIndices ****************************
  */
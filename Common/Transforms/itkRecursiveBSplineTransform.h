@@ -88,6 +88,7 @@ public:
   typedef typename GridOffsetType::OffsetValueType OffsetValueType;
 
   typedef typename Superclass::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndexType      NonZeroJacobianIndexType;
   typedef typename Superclass::SpatialJacobianType           SpatialJacobianType;
   typedef typename Superclass::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType            SpatialHessianType;
@@ -123,6 +124,14 @@ public:
   typename DerivativeKernelType::Pointer            m_DerivativeKernel;
   typename SecondOrderDerivativeKernelType::Pointer m_SecondOrderDerivativeKernel;
 
+  /** Use the explicitly vectorized (AVX-512, AVX2 or scalar, selected at run-time)
+   * implementation of GetJacobian() and EvaluateJacobianWithImageGradientProduct(),
+   * see VectorizedRecursiveBSplineTransformImplementation. Default: false.
+   */
+  itkSetMacro(UseVectorizedImplementation, bool);
+  itkGetConstMacro(UseVectorizedImplementation, bool);
+  itkBooleanMacro(UseVectorizedImplementation);
+
   /** Compute point transformation. This one is commonly used.
    * It calls RecursiveBSplineTransformImplementation2::InterpolateTransformPoint
    * for a recursive implementation.
@@ -130,6 +139,12 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
 
+  /** Transform a block of points at once. */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  SizeValueType          numberOfPoints) const override;
+
   /** Compute the Jacobian of the transformation. */
   void
   GetJacobian(const InputPointType &       ipp,
@@ -145,6 +160,16 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient for a block of points.
+   * The results and the nonzero Jacobian indices are directly written in the output memory.
+   */
+  void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            SizeValueType                   numberOfPoints,
+                                            ParametersValueType *           imageJacobians,
+                                            NonZeroJacobianIndexType *      nonZeroJacobianIndices) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
@@ -201,6 +226,8 @@ private:
   RecursiveBSplineTransform(const Self &) = delete;
   void
   operator=(const Self &) = delete;
+
+  bool m_UseVectorizedImplementation;
 };
 
 } // end namespace itk
@@ -21,6 +21,7 @@
 #include "itkRecursiveBSplineTransform.h"
 
 #include "itkRecursiveBSplineTransformImplementation.h"
+#include "itkVectorizedRecursiveBSplineTransformImplementation.h"
 
 
 namespace itk
@@ -34,6 +35,7 @@ template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
 RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::RecursiveBSplineTransform()
   : Superclass()
 {
+  this->m_UseVectorizedImplementation = false;
   this->m_RecursiveBSplineWeightFunction = RecursiveBSplineWeightFunctionType::New();
   this->m_Kernel = KernelType::New();
   this->m_DerivativeKernel = DerivativeKernelType::New();
@@ -113,6 +115,84 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoint(co
 } // end TransformPoint()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoints(const InputPointType * inputPoints,
+                                                                              OutputPointType *      outputPoints,
+                                                                              SizeValueType numberOfPoints) const
+{
+  /** Check if the coefficient image has been set. */
+  if (!this->m_CoefficientImages[0])
+  {
+    itkWarningMacro(<< "B-spline coefficients have not been set");
+    for (SizeValueType i = 0; i < numberOfPoints; ++i)
+    {
+      outputPoints[i] = inputPoints[i];
+    }
+    return;
+  }
+
+  /** Initialize (helper) variables, once for all points. */
+  const unsigned int              numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray1D[numberOfWeights];
+  WeightsType                     weights1D(weightsArray1D, numberOfWeights, false);
+  const OffsetValueType *         bsplineOffsetTable = this->m_CoefficientImages[0]->GetOffsetTable();
+  ScalarType *                    basePointers[SpaceDimension];
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    basePointers[j] = this->m_CoefficientImages[j]->GetBufferPointer();
+  }
+
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    const InputPointType point = inputPoints[i]; // may be in-place
+
+    /** Convert to continuous index. */
+    ContinuousIndexType cindex;
+    this->TransformPointToContinuousGridIndex(point, cindex);
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and return the input point
+    if (!this->InsideValidRegion(cindex))
+    {
+      outputPoints[i] = point;
+      continue;
+    }
+
+    // Compute interpolation weighs and store them in weights1D
+    IndexType supportIndex;
+    this->m_RecursiveBSplineWeightFunction->Evaluate(cindex, weights1D, supportIndex);
+
+    OffsetValueType totalOffsetToSupportIndex = 0;
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      totalOffsetToSupportIndex += supportIndex[j] * bsplineOffsetTable[j];
+    }
+
+    ScalarType * mu[SpaceDimension];
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      mu[j] = basePointers[j] + totalOffsetToSupportIndex;
+    }
+
+    /** Call the recursive TransformPoint function. */
+    ScalarType displacement[SpaceDimension];
+    RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::TransformPoint(
+      displacement, mu, bsplineOffsetTable, weightsArray1D);
+
+    // The output point is the start point + displacement.
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      outputPoints[i][j] = displacement[j] + point[j];
+    }
+  }
+} // end TransformPoints()
+
+
 /**
  * ********************* GetJacobian ****************************
  */
@@ -166,8 +246,16 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::GetJacobian(
    * The pointer has changed after this function call.
    */
   ParametersValueType * jacobianPointer = jacobian.data_block();
-  RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::GetJacobian(
-    jacobianPointer, weightsArray1D, 1.0);
+  if (this->m_UseVectorizedImplementation)
+  {
+    VectorizedRecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+      GetJacobian(jacobianPointer, weightsArray1D, 1.0);
+  }
+  else
+  {
+    RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::GetJacobian(
+      jacobianPointer, weightsArray1D, 1.0);
+  }
 
   /** Compute the nonzero Jacobian indices.
    * Takes a significant portion of the computation time of this function.
@@ -232,8 +320,16 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianW
     migArray[j] = movingImageGradient[j];
   }
   ParametersValueType * imageJacobianPointer = imageJacobian.data_block();
-  RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
-    EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
+  if (this->m_UseVectorizedImplementation)
+  {
+    VectorizedRecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+      EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
+  }
+  else
+  {
+    RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+      EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
+  }
 
   /** Setup support region needed for the nonZeroJacobianIndices. */
   RegionType supportRegion;
@@ -248,6 +344,84 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianW
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  SizeValueType                   numberOfPoints,
+  ParametersValueType *           imageJacobians,
+  NonZeroJacobianIndexType *      nonZeroJacobianIndices) const
+{
+  /** Initialize (helper) variables, once for all points. */
+  const NumberOfParametersType    nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  const unsigned long             parametersPerDim = this->GetNumberOfParametersPerDimension();
+  const OffsetValueType *         gridOffsetTable = this->m_CoefficientImages[0]->GetOffsetTable();
+  const unsigned int              numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray1D[numberOfWeights];
+  WeightsType                     weights1D(weightsArray1D, numberOfWeights, false);
+
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    ParametersValueType *      imageJacobianPointer = imageJacobians + i * nnzji;
+    NonZeroJacobianIndexType * nzjiPointer = nonZeroJacobianIndices + i * nnzji;
+
+    /** Convert the physical point to a continuous index. */
+    ContinuousIndexType cindex;
+    this->TransformPointToContinuousGridIndex(ipps[i], cindex);
+
+    /** NOTE: if the support region does not lie totally within the grid
+     * we assume zero displacement and zero Jacobian.
+     */
+    if (!this->InsideValidRegion(cindex))
+    {
+      for (NumberOfParametersType k = 0; k < nnzji; ++k)
+      {
+        imageJacobianPointer[k] = 0.0;
+        nzjiPointer[k] = k;
+      }
+      continue;
+    }
+
+    /** Compute the interpolation weights. */
+    IndexType supportIndex;
+    this->m_RecursiveBSplineWeightFunction->Evaluate(cindex, weights1D, supportIndex);
+
+    /** Recursively compute the inner product of the Jacobian and the moving image gradient. */
+    double migArray[SpaceDimension];
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      migArray[j] = movingImageGradients[i][j];
+    }
+    if (this->m_UseVectorizedImplementation)
+    {
+      VectorizedRecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+        EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
+    }
+    else
+    {
+      RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+        EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
+    }
+
+    /** Compute the nonzero Jacobian indices, directly in the output memory. */
+    OffsetValueType totalOffsetToSupportIndex = 0;
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      totalOffsetToSupportIndex += supportIndex[j] * gridOffsetTable[j];
+    }
+    unsigned long currentIndex = totalOffsetToSupportIndex;
+    RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+      ComputeNonZeroJacobianIndices(nzjiPointer, parametersPerDim, currentIndex, gridOffsetTable);
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
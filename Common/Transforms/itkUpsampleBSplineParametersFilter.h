@@ -20,6 +20,9 @@
 
 #include "itkObject.h"
 #include "itkArray.h"
+#include "itkPlatformMultiThreader.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -33,6 +36,21 @@ namespace itk
  * on a denser grid. Therefore, the user needs to supply the old B-spline grid
  * (region, spacing, origin, direction), and the required B-spline grid.
  *
+ * When both grids have the same direction, the B-spline order is at most 3,
+ * and the current grid has more points than the order of the kernel (see below)
+ * along each dimension, the upsampling is done separably: the B-spline is
+ * evaluated at the required grid points along one dimension at a time, and each
+ * resulting grid line is immediately decomposed into B-spline coefficients
+ * again. The grid lines are divided over the threads, and no intermediate
+ * images are created. Otherwise the coefficient images are resampled and
+ * decomposed with the ITK filters. Both give the same result, up to rounding.
+ *
+ * By default the current B-spline is evaluated with the cubic kernel, whatever
+ * BSplineOrder, as the ITK filters have always done. For first and second order
+ * B-splines this changes the deformation when upsampling. With
+ * UseBSplineOrderKernel, the kernel of BSplineOrder is used instead, which
+ * preserves the deformation, but gives other results than before.
+ *
  */
 
 template <class TArray, class TImage>
@@ -92,10 +110,24 @@ public:
   /** Set the B-spline order. */
   itkSetMacro(BSplineOrder, unsigned int);
 
+  /** Set/Get whether the current B-spline is evaluated with the kernel of BSplineOrder,
+   * instead of the cubic kernel, see above. Default: false.
+   */
+  itkSetMacro(UseBSplineOrderKernel, bool);
+  itkGetConstMacro(UseBSplineOrderKernel, bool);
+  itkBooleanMacro(UseBSplineOrderKernel);
+
   /** Compute the output parameter array. */
   virtual void
   UpsampleParameters(const ArrayType & param_in, ArrayType & param_out);
 
+  /** Set the number of threads of the separable upsampling. */
+  void
+  SetNumberOfWorkUnits(ThreadIdType numberOfThreads)
+  {
+    this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+
 protected:
   /** Constructor. */
   UpsampleBSplineParametersFilter();
@@ -111,6 +143,18 @@ protected:
   virtual bool
   DoUpsampling(void);
 
+  /** Function that checks if the separable upsampling can be used. */
+  virtual bool
+  CanUpsampleSeparably(void) const;
+
+  /** Upsample the parameters separably, along one dimension after the other. */
+  virtual void
+  UpsampleParametersSeparably(const ArrayType & param_in, ArrayType & param_out);
+
+  /** Typedefs for multi-threading. */
+  typedef PlatformMultiThreader      ThreaderType;
+  typedef ThreaderType::WorkUnitInfo ThreadInfoType;
+
 private:
   UpsampleBSplineParametersFilter(const Self &) = delete;
   void
@@ -126,6 +170,59 @@ private:
   DirectionType m_RequiredGridDirection;
   RegionType    m_RequiredGridRegion;
   unsigned int  m_BSplineOrder;
+  bool          m_UseBSplineOrderKernel;
+
+  /** The order of the kernel with which the current B-spline is evaluated. */
+  unsigned int
+  GetKernelOrder(void) const
+  {
+    return this->m_UseBSplineOrderKernel ? this->m_BSplineOrder : 3;
+  }
+
+  /** The B-spline weights of the current grid at the required grid points, along
+   * one dimension. For each required grid point, the m_NumberOfWeights indices of the
+   * current grid line, after the mirror boundary condition, and their weights are
+   * stored. The weights of a point outside the current grid are zero.
+   */
+  struct RefinementKernelType
+  {
+    unsigned int               m_NumberOfWeights;
+    std::vector<SizeValueType> m_Indices;
+    std::vector<double>        m_Weights;
+  };
+
+  /** Compute the refinement kernel of a dimension. */
+  void
+  ComputeRefinementKernel(unsigned int dimension, RefinementKernelType & kernel) const;
+
+  /** Evaluate and decompose the grid lines of this thread, along one dimension. */
+  void
+  ThreadedUpsampleLines(ThreadIdType threadId, ThreadIdType numberOfThreads) const;
+
+  /** Compute the B-spline coefficients of a line of data, as in the BSplineDecompositionImageFilter. */
+  void
+  DecomposeLine(double * line, SizeValueType length) const;
+
+  /** The threader callback of ThreadedUpsampleLines(). */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  UpsampleLinesThreaderCallback(void * arg);
+
+  /** The variables that are shared by the threads of ThreadedUpsampleLines(). The grid lines
+   * along the dimension are separated by the stride, in both the input and the output.
+   */
+  struct MultiThreaderParameterType
+  {
+    const Self *                 st_Self;
+    const ValueType *            st_Input;
+    ValueType *                  st_Output;
+    const RefinementKernelType * st_Kernel;
+    SizeValueType                st_InputLength;
+    SizeValueType                st_OutputLength;
+    SizeValueType                st_Stride;
+    SizeValueType                st_NumberOfLines;
+  };
+  MultiThreaderParameterType m_ThreaderParameters;
+  ThreaderType::Pointer      m_Threader;
 };
 
 } // end namespace itk
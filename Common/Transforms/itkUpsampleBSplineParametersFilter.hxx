@@ -23,6 +23,11 @@
 #include "itkBSplineResampleImageFunction.h"
 #include "itkBSplineDecompositionImageFilter.h"
 #include "itkResampleImageFilter.h"
+#include "itkBSplineKernelFunction2.h"
+#include "itkMath.h"
+
+#include <algorithm> // For min.
+#include <cmath>
 
 namespace itk
 {
@@ -35,6 +40,7 @@ template <class TArray, class TImage>
 UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleBSplineParametersFilter()
 {
   this->m_BSplineOrder = 3;
+  this->m_UseBSplineOrderKernel = false;
 
   // Initialize grid settings.
   this->m_CurrentGridOrigin.Fill(0.0);
@@ -43,6 +49,10 @@ UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleBSplineParametersFilter
   this->m_RequiredGridOrigin.Fill(0.0);
   this->m_RequiredGridSpacing.Fill(0.0);
   this->m_RequiredGridDirection.Fill(0.0);
+
+  /** Threading related variables. */
+  this->m_Threader = ThreaderType::New();
+  this->m_ThreaderParameters.st_Self = this;
 } // end Constructor()
 
 
@@ -62,6 +72,13 @@ UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParameters(const ArrayT
     return;
   }
 
+  /** Use the separable upsampling, if possible. */
+  if (this->CanUpsampleSeparably())
+  {
+    this->UpsampleParametersSeparably(parameters_in, parameters_out);
+    return;
+  }
+
   /** Typedefs. */
   typedef itk::ResampleImageFilter<ImageType, ImageType>             UpsampleFilterType;
   typedef itk::BSplineResampleImageFunction<ImageType, ValueType>    CoefficientUpsampleFunctionType;
@@ -106,7 +123,10 @@ UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParameters(const ArrayT
     typename CoefficientUpsampleFunctionType::Pointer coeffUpsampleFunction = CoefficientUpsampleFunctionType::New();
     typename DecompositionFilterType::Pointer         decompositionFilter = DecompositionFilterType::New();
 
-    /** Setup the upsampler. */
+    /** Setup the upsampler. The coefficients are evaluated with the cubic kernel, unless
+     * the kernel of their own order is requested.
+     */
+    coeffUpsampleFunction->SetSplineOrder(this->GetKernelOrder());
     upsampler->SetInterpolator(coeffUpsampleFunction);
     upsampler->SetSize(this->m_RequiredGridRegion.GetSize());
     upsampler->SetOutputStartIndex(this->m_RequiredGridRegion.GetIndex());
@@ -168,6 +188,319 @@ UpsampleBSplineParametersFilter<TArray, TImage>::DoUpsampling(void)
 } // end DoUpsampling()
 
 
+/**
+ * ******************* CanUpsampleSeparably *******************
+ */
+
+template <class TArray, class TImage>
+bool
+UpsampleBSplineParametersFilter<TArray, TImage>::CanUpsampleSeparably(void) const
+{
+  /** The continuous indices of the required grid points in the current grid are only
+   * separable if the grids have the same direction. The mirror boundary condition of
+   * the B-spline evaluation needs more points in the current grid than the order of
+   * the kernel, and the decomposition needs at least two points in the required grid.
+   */
+  if (this->m_BSplineOrder < 1 || this->m_BSplineOrder > 3 ||
+      this->m_CurrentGridDirection != this->m_RequiredGridDirection)
+  {
+    return false;
+  }
+
+  for (unsigned int j = 0; j < Dimension; ++j)
+  {
+    if (this->m_CurrentGridRegion.GetSize()[j] <= this->GetKernelOrder() || this->m_RequiredGridRegion.GetSize()[j] < 2)
+    {
+      return false;
+    }
+  }
+
+  return true;
+
+} // end CanUpsampleSeparably()
+
+
+/**
+ * ******************* UpsampleParametersSeparably *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParametersSeparably(const ArrayType & parameters_in,
+                                                                             ArrayType &       parameters_out)
+{
+  /** Get the number of parameters. */
+  const SizeValueType currentNumberOfPixels = this->m_CurrentGridRegion.GetNumberOfPixels();
+  const SizeValueType requiredNumberOfPixels = this->m_RequiredGridRegion.GetNumberOfPixels();
+
+  /** Create the new vector of output parameters, with the correct size. */
+  parameters_out.SetSize(requiredNumberOfPixels * Dimension);
+
+  /** The grid is refined along one dimension after the other, for all coefficient images
+   * at once. Along the dimensions that are done, the intermediate grid has the size of the
+   * required grid, and along the other dimensions the size of the current grid.
+   */
+  std::vector<ValueType> buffers[2];
+  const ValueType *      input = parameters_in.data_block();
+  SizeValueType          numberOfPixels = currentNumberOfPixels;
+  SizeValueType          stride = 1;
+  for (unsigned int j = 0; j < Dimension; ++j)
+  {
+    RefinementKernelType kernel;
+    this->ComputeRefinementKernel(j, kernel);
+
+    const SizeValueType inputLength = this->m_CurrentGridRegion.GetSize()[j];
+    const SizeValueType outputLength = this->m_RequiredGridRegion.GetSize()[j];
+    const SizeValueType numberOfLines = numberOfPixels / inputLength * Dimension;
+    numberOfPixels = numberOfPixels / inputLength * outputLength;
+
+    ValueType * output = parameters_out.data_block();
+    if (j + 1 < Dimension)
+    {
+      buffers[j % 2].resize(numberOfPixels * Dimension);
+      output = buffers[j % 2].data();
+    }
+
+    this->m_ThreaderParameters.st_Input = input;
+    this->m_ThreaderParameters.st_Output = output;
+    this->m_ThreaderParameters.st_Kernel = &kernel;
+    this->m_ThreaderParameters.st_InputLength = inputLength;
+    this->m_ThreaderParameters.st_OutputLength = outputLength;
+    this->m_ThreaderParameters.st_Stride = stride;
+    this->m_ThreaderParameters.st_NumberOfLines = numberOfLines;
+
+    this->m_Threader->SetSingleMethod(this->UpsampleLinesThreaderCallback, &this->m_ThreaderParameters);
+    this->m_Threader->SingleMethodExecute();
+
+    input = output;
+    stride *= outputLength;
+  }
+
+} // end UpsampleParametersSeparably()
+
+
+/**
+ * ******************* ComputeRefinementKernel *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::ComputeRefinementKernel(const unsigned int     dimension,
+                                                                         RefinementKernelType & kernel) const
+{
+  /** Because both grids have the same direction, the continuous index in the current
+   * grid of required grid point i is offset + scale * i, along each dimension.
+   */
+  const vnl_matrix_fixed<double, Dimension, Dimension> inverseDirection = this->m_CurrentGridDirection.GetInverse();
+  double                                               offset = 0.0;
+  for (unsigned int j = 0; j < Dimension; ++j)
+  {
+    offset += inverseDirection(dimension, j) * (this->m_RequiredGridOrigin[j] - this->m_CurrentGridOrigin[j]);
+  }
+  offset /= this->m_CurrentGridSpacing[dimension];
+  const double scale = this->m_RequiredGridSpacing[dimension] / this->m_CurrentGridSpacing[dimension];
+
+  /** The B-spline kernel with which the current grid is evaluated. */
+  const unsigned int                   kernelOrder = this->GetKernelOrder();
+  KernelFunctionBase2<double>::Pointer kernelFunction;
+  if (kernelOrder == 1)
+  {
+    kernelFunction = BSplineKernelFunction2<1>::New();
+  }
+  else if (kernelOrder == 2)
+  {
+    kernelFunction = BSplineKernelFunction2<2>::New();
+  }
+  else
+  {
+    kernelFunction = BSplineKernelFunction2<3>::New();
+  }
+
+  const IndexValueType currentStart = this->m_CurrentGridRegion.GetIndex()[dimension];
+  const IndexValueType currentEnd =
+    currentStart + static_cast<IndexValueType>(this->m_CurrentGridRegion.GetSize()[dimension]) - 1;
+  const IndexValueType requiredStart = this->m_RequiredGridRegion.GetIndex()[dimension];
+  const SizeValueType  requiredLength = this->m_RequiredGridRegion.GetSize()[dimension];
+  const unsigned int   numberOfWeights = kernelOrder + 1;
+  const double         halfOffset = (kernelOrder & 1) ? 0.0 : 0.5;
+
+  kernel.m_NumberOfWeights = numberOfWeights;
+  kernel.m_Indices.assign(requiredLength * numberOfWeights, 0);
+  kernel.m_Weights.assign(requiredLength * numberOfWeights, 0.0);
+  for (SizeValueType i = 0; i < requiredLength; ++i)
+  {
+    /** Points outside the current grid get the value zero, as in the ResampleImageFilter. */
+    const double cindex = offset + scale * static_cast<double>(requiredStart + static_cast<IndexValueType>(i));
+    if (!(cindex >= currentStart - 0.5 && cindex < currentEnd + 0.5))
+    {
+      continue;
+    }
+
+    /** The support region and the mirror boundary condition of the BSplineInterpolateImageFunction. */
+    const IndexValueType first =
+      Math::Floor<IndexValueType>(cindex + halfOffset) - static_cast<IndexValueType>(kernelOrder / 2);
+    for (unsigned int k = 0; k < numberOfWeights; ++k)
+    {
+      IndexValueType index = first + static_cast<IndexValueType>(k);
+      kernel.m_Weights[i * numberOfWeights + k] = kernelFunction->Evaluate(cindex - static_cast<double>(index));
+      if (index < currentStart)
+      {
+        index = 2 * currentStart - index;
+      }
+      if (index > currentEnd)
+      {
+        index = 2 * currentEnd - index;
+      }
+      kernel.m_Indices[i * numberOfWeights + k] = static_cast<SizeValueType>(index - currentStart);
+    }
+  }
+
+} // end ComputeRefinementKernel()
+
+
+/**
+ * ******************* ThreadedUpsampleLines *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::ThreadedUpsampleLines(ThreadIdType threadId,
+                                                                       ThreadIdType numberOfThreads) const
+{
+  const MultiThreaderParameterType & parameters = this->m_ThreaderParameters;
+  const RefinementKernelType &       kernel = *parameters.st_Kernel;
+  const unsigned int                 numberOfWeights = kernel.m_NumberOfWeights;
+  const SizeValueType                stride = parameters.st_Stride;
+
+  /** The grid lines are divided over the threads. */
+  const SizeValueType linesPerThread = (parameters.st_NumberOfLines + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType lineBegin = std::min(parameters.st_NumberOfLines, threadId * linesPerThread);
+  const SizeValueType lineEnd = std::min(parameters.st_NumberOfLines, lineBegin + linesPerThread);
+
+  std::vector<double> line(parameters.st_OutputLength);
+  for (SizeValueType l = lineBegin; l < lineEnd; ++l)
+  {
+    const SizeValueType outer = l / stride;
+    const SizeValueType inner = l % stride;
+    const ValueType *   input = parameters.st_Input + outer * stride * parameters.st_InputLength + inner;
+    ValueType *         output = parameters.st_Output + outer * stride * parameters.st_OutputLength + inner;
+
+    /** Evaluate the B-spline at the required grid points of this line. */
+    for (SizeValueType i = 0; i < parameters.st_OutputLength; ++i)
+    {
+      const SizeValueType * indices = &kernel.m_Indices[i * numberOfWeights];
+      const double *        weights = &kernel.m_Weights[i * numberOfWeights];
+      double                value = 0.0;
+      for (unsigned int k = 0; k < numberOfWeights; ++k)
+      {
+        value += weights[k] * input[indices[k] * stride];
+      }
+      line[i] = value;
+    }
+
+    /** Compute the B-spline coefficients that interpolate these values. */
+    this->DecomposeLine(line.data(), parameters.st_OutputLength);
+    for (SizeValueType i = 0; i < parameters.st_OutputLength; ++i)
+    {
+      output[i * stride] = static_cast<ValueType>(line[i]);
+    }
+  }
+
+} // end ThreadedUpsampleLines()
+
+
+/**
+ * ******************* DecomposeLine *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::DecomposeLine(double * line, const SizeValueType length) const
+{
+  /** First order B-splines interpolate their coefficients. */
+  if (this->m_BSplineOrder < 2)
+  {
+    return;
+  }
+
+  /** The recursive filter of the BSplineDecompositionImageFilter, with its mirror boundary
+   * conditions and its default tolerance, see Unser, 1999, Box 2.
+   */
+  const double z = this->m_BSplineOrder == 2 ? std::sqrt(8.0) - 3.0 : std::sqrt(3.0) - 2.0;
+  const double tolerance = 1e-10;
+
+  /** Apply the gain. */
+  const double gain = (1.0 - z) * (1.0 - 1.0 / z);
+  for (SizeValueType n = 0; n < length; ++n)
+  {
+    line[n] *= gain;
+  }
+
+  /** Causal initialization. */
+  const SizeValueType horizon = static_cast<SizeValueType>(std::ceil(std::log(tolerance) / std::log(std::fabs(z))));
+  double              zn = z;
+  if (horizon < length)
+  {
+    double sum = line[0];
+    for (SizeValueType n = 1; n < horizon; ++n)
+    {
+      sum += zn * line[n];
+      zn *= z;
+    }
+    line[0] = sum;
+  }
+  else
+  {
+    const double iz = 1.0 / z;
+    double       z2n = std::pow(z, static_cast<double>(length - 1));
+    double       sum = line[0] + z2n * line[length - 1];
+    z2n *= z2n * iz;
+    for (SizeValueType n = 1; n + 1 < length; ++n)
+    {
+      sum += (zn + z2n) * line[n];
+      zn *= z;
+      z2n *= iz;
+    }
+    line[0] = sum / (1.0 - zn * zn);
+  }
+
+  /** Causal recursion. */
+  for (SizeValueType n = 1; n < length; ++n)
+  {
+    line[n] += z * line[n - 1];
+  }
+
+  /** Anticausal initialization and recursion. */
+  line[length - 1] = (z / (z * z - 1.0)) * (z * line[length - 2] + line[length - 1]);
+  for (SizeValueType n = length - 1; n > 0; --n)
+  {
+    line[n - 1] = z * (line[n] - line[n - 1]);
+  }
+
+} // end DecomposeLine()
+
+
+/**
+ * ******************* UpsampleLinesThreaderCallback *******************
+ */
+
+template <class TArray, class TImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleLinesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->st_Self->ThreadedUpsampleLines(threadID, nrOfThreads);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end UpsampleLinesThreaderCallback()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -189,6 +522,7 @@ UpsampleBSplineParametersFilter<TArray, TImage>::PrintSelf(std::ostream & os, In
   os << indent << "RequiredGridRegion: " << this->m_RequiredGridRegion << std::endl;
 
   os << indent << "BSplineOrder: " << this->m_BSplineOrder << std::endl;
+  os << indent << "UseBSplineOrderKernel: " << this->m_UseBSplineOrderKernel << std::endl;
 
 } // end PrintSelf()
 
@@ -0,0 +1,446 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkVectorizedBSplineKernels_h
+#define itkVectorizedBSplineKernels_h
+
+#include "itkIntTypes.h"
+
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define ELX_VECTORIZED_BSPLINE_X86
+#  define ELX_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#  define ELX_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <immintrin.h>
+#  include <intrin.h>
+#  define ELX_VECTORIZED_BSPLINE_X86
+#  define ELX_TARGET_AVX2
+#  define ELX_TARGET_AVX512
+#endif
+
+namespace itk
+{
+
+/** \class VectorizedBSplineKernels
+ *
+ * \brief Explicitly vectorized kernels for the B-spline transform.
+ *
+ * This class provides the flat, vectorizable building blocks that are used by the
+ * VectorizedRecursiveBSplineTransformImplementation. Each kernel has an AVX-512,
+ * an AVX2 and a scalar version. The version that is used is selected at run-time,
+ * based on the instruction sets that are supported by the CPU and the operating system,
+ * once per kernel call. The vector versions handle the remainder of each row with
+ * masked loads and stores, so that also rows shorter than the vector width are vectorized.
+ * The selection can be restricted with SetInstructionSet(), which is mainly useful
+ * for benchmarking and testing.
+ *
+ * All kernels work on double precision values.
+ *
+ * \ingroup ITKTransform
+ */
+
+class VectorizedBSplineKernels
+{
+public:
+  /** The instruction sets, in increasing order of vector width. */
+  enum InstructionSetType
+  {
+    Scalar = 0,
+    AVX2 = 1,
+    AVX512 = 2
+  };
+
+  /** Returns the widest instruction set that is supported by the CPU. Detected only once. */
+  static InstructionSetType
+  GetSupportedInstructionSet(void)
+  {
+    static const InstructionSetType supported = DetectInstructionSet();
+    return supported;
+  }
+
+
+  /** Returns the instruction set that is currently used by the kernels. */
+  static InstructionSetType
+  GetInstructionSet(void)
+  {
+    return static_cast<InstructionSetType>(GetSelectedInstructionSet().load(std::memory_order_relaxed));
+  }
+
+
+  /** Restrict the instruction set that is used by the kernels.
+   * Requests for unsupported instruction sets are clamped to the supported one.
+   */
+  static void
+  SetInstructionSet(InstructionSetType instructionSet)
+  {
+    const InstructionSetType supported = GetSupportedInstructionSet();
+    GetSelectedInstructionSet().store(instructionSet > supported ? supported : instructionSet,
+                                      std::memory_order_relaxed);
+  }
+
+
+  /** Returns a human readable name of the instruction set. */
+  static const char *
+  GetInstructionSetName(InstructionSetType instructionSet)
+  {
+    switch (instructionSet)
+    {
+      case AVX512:
+        return "AVX-512";
+      case AVX2:
+        return "AVX2";
+      default:
+        return "scalar";
+    }
+  }
+
+
+  /** Computes output[ j * outputStride + i ] = input[ i ] * scales[ j ],
+   * for i < length and j < numberOfScales. The output may alias the input
+   * only when outputStride == 0 or numberOfScales == 1.
+   */
+  static void
+  ScaledCopy(const double *  input,
+             unsigned int    length,
+             const double *  scales,
+             unsigned int    numberOfScales,
+             double *        output,
+             OffsetValueType outputStride)
+  {
+#ifdef ELX_VECTORIZED_BSPLINE_X86
+    switch (GetInstructionSet())
+    {
+      case AVX512:
+        return ScaledCopyAVX512(input, length, scales, numberOfScales, output, outputStride);
+      case AVX2:
+        return ScaledCopyAVX2(input, length, scales, numberOfScales, output, outputStride);
+      default:
+        break;
+    }
+#endif
+    ScaledCopyScalar(input, length, scales, numberOfScales, output, outputStride);
+  }
+
+
+  /** Computes the tensor product of the 1D weights, scaled once for each output row:
+   * output[ j * outputStride + m ] = scales[ j ] * w_0[ m_0 ] * ... * w_{D-1}[ m_{D-1} ],
+   * for m < numberOfWeights1D^dimension and j < numberOfScales, where w_d = weights1D + d * numberOfWeights1D,
+   * and m_d is digit d of m in base numberOfWeights1D, the first dimension running fastest.
+   * The weights of all but the last dimension are expanded in the workspace, which must hold
+   * numberOfWeights1D^(dimension-1) values, and at least one. The last dimension is merged with the scales,
+   * so that each output row is written in a single pass.
+   */
+  static void
+  ScaledTensorProduct(const double *  weights1D,
+                      unsigned int    numberOfWeights1D,
+                      unsigned int    dimension,
+                      const double *  scales,
+                      unsigned int    numberOfScales,
+                      double *        output,
+                      OffsetValueType outputStride,
+                      double *        workspace)
+  {
+#ifdef ELX_VECTORIZED_BSPLINE_X86
+    switch (GetInstructionSet())
+    {
+      case AVX512:
+        return ScaledTensorProductAVX512(
+          weights1D, numberOfWeights1D, dimension, scales, numberOfScales, output, outputStride, workspace);
+      case AVX2:
+        return ScaledTensorProductAVX2(
+          weights1D, numberOfWeights1D, dimension, scales, numberOfScales, output, outputStride, workspace);
+      default:
+        break;
+    }
+#endif
+    ScaledTensorProductScalar(
+      weights1D, numberOfWeights1D, dimension, scales, numberOfScales, output, outputStride, workspace);
+  }
+
+
+  /** Scalar version of the ScaledCopy kernel. */
+  static void
+  ScaledCopyScalar(const double *  input,
+                   unsigned int    length,
+                   const double *  scales,
+                   unsigned int    numberOfScales,
+                   double *        output,
+                   OffsetValueType outputStride)
+  {
+    for (unsigned int j = 0; j < numberOfScales; ++j)
+    {
+      const double scale = scales[j];
+      double *     out = output + j * outputStride;
+      for (unsigned int i = 0; i < length; ++i)
+      {
+        out[i] = input[i] * scale;
+      }
+    }
+  }
+
+  /** Scalar version of the ScaledTensorProduct kernel. */
+  static void
+  ScaledTensorProductScalar(const double *  weights1D,
+                            unsigned int    numberOfWeights1D,
+                            unsigned int    dimension,
+                            const double *  scales,
+                            unsigned int    numberOfScales,
+                            double *        output,
+                            OffsetValueType outputStride,
+                            double *        workspace)
+  {
+    unsigned int length = 1;
+    workspace[0] = 1.0;
+    if (dimension > 1)
+    {
+      for (unsigned int k = 0; k < numberOfWeights1D; ++k)
+      {
+        workspace[k] = weights1D[k];
+      }
+      length = numberOfWeights1D;
+    }
+
+    /** Blocks k > 0 are scaled copies of block 0; block 0 is scaled last, in-place. */
+    for (unsigned int d = 1; d + 1 < dimension; ++d)
+    {
+      const double * w = weights1D + d * numberOfWeights1D;
+      ScaledCopyScalar(workspace, length, w + 1, numberOfWeights1D - 1, workspace + length, length);
+      ScaledCopyScalar(workspace, length, w, 1, workspace, 0);
+      length *= numberOfWeights1D;
+    }
+
+    const double * lastWeights = weights1D + (dimension - 1) * numberOfWeights1D;
+    for (unsigned int j = 0; j < numberOfScales; ++j)
+    {
+      double * out = output + j * outputStride;
+      for (unsigned int k = 0; k < numberOfWeights1D; ++k)
+      {
+        const double scale = scales[j] * lastWeights[k];
+        ScaledCopyScalar(workspace, length, &scale, 1, out + k * length, 0);
+      }
+    }
+  }
+
+#ifdef ELX_VECTORIZED_BSPLINE_X86
+
+  /** AVX2 version of the ScaledCopy kernel, processing 4 doubles per instruction. */
+  ELX_TARGET_AVX2 static void
+  ScaledCopyAVX2(const double *  input,
+                 unsigned int    length,
+                 const double *  scales,
+                 unsigned int    numberOfScales,
+                 double *        output,
+                 OffsetValueType outputStride)
+  {
+    const unsigned int vectorLength = length & ~3u;
+    const __m256i      tailMask =
+      _mm256_cmpgt_epi64(_mm256_set1_epi64x(length - vectorLength), _mm256_set_epi64x(3, 2, 1, 0));
+    for (unsigned int j = 0; j < numberOfScales; ++j)
+    {
+      const __m256d scale = _mm256_set1_pd(scales[j]);
+      double *      out = output + j * outputStride;
+      for (unsigned int i = 0; i < vectorLength; i += 4)
+      {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(input + i), scale));
+      }
+      if (vectorLength < length)
+      {
+        _mm256_maskstore_pd(
+          out + vectorLength, tailMask, _mm256_mul_pd(_mm256_maskload_pd(input + vectorLength, tailMask), scale));
+      }
+    }
+  }
+
+
+  /** AVX2 version of the ScaledTensorProduct kernel. */
+  ELX_TARGET_AVX2 static void
+  ScaledTensorProductAVX2(const double *  weights1D,
+                          unsigned int    numberOfWeights1D,
+                          unsigned int    dimension,
+                          const double *  scales,
+                          unsigned int    numberOfScales,
+                          double *        output,
+                          OffsetValueType outputStride,
+                          double *        workspace)
+  {
+    unsigned int length = 1;
+    workspace[0] = 1.0;
+    if (dimension > 1)
+    {
+      for (unsigned int k = 0; k < numberOfWeights1D; ++k)
+      {
+        workspace[k] = weights1D[k];
+      }
+      length = numberOfWeights1D;
+    }
+
+    /** Blocks k > 0 are scaled copies of block 0; block 0 is scaled last, in-place. */
+    for (unsigned int d = 1; d + 1 < dimension; ++d)
+    {
+      const double * w = weights1D + d * numberOfWeights1D;
+      ScaledCopyAVX2(workspace, length, w + 1, numberOfWeights1D - 1, workspace + length, length);
+      ScaledCopyAVX2(workspace, length, w, 1, workspace, 0);
+      length *= numberOfWeights1D;
+    }
+
+    const double * lastWeights = weights1D + (dimension - 1) * numberOfWeights1D;
+    for (unsigned int j = 0; j < numberOfScales; ++j)
+    {
+      double * out = output + j * outputStride;
+      for (unsigned int k = 0; k < numberOfWeights1D; ++k)
+      {
+        const double scale = scales[j] * lastWeights[k];
+        ScaledCopyAVX2(workspace, length, &scale, 1, out + k * length, 0);
+      }
+    }
+  }
+
+
+  /** AVX-512 version of the kernel, processing 8 doubles per instruction. */
+  ELX_TARGET_AVX512 static void
+  ScaledCopyAVX512(const double *  input,
+                   unsigned int    length,
+                   const double *  scales,
+                   unsigned int    numberOfScales,
+                   double *        output,
+                   OffsetValueType outputStride)
+  {
+    const unsigned int vectorLength = length & ~7u;
+    const __mmask8     tailMask = static_cast<__mmask8>((1u << (length - vectorLength)) - 1u);
+    for (unsigned int j = 0; j < numberOfScales; ++j)
+    {
+      const __m512d scale = _mm512_set1_pd(scales[j]);
+      double *      out = output + j * outputStride;
+      for (unsigned int i = 0; i < vectorLength; i += 8)
+      {
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_loadu_pd(input + i), scale));
+      }
+      if (vectorLength < length)
+      {
+        _mm512_mask_storeu_pd(out + vectorLength,
+                              tailMask,
+                              _mm512_mul_pd(_mm512_maskz_loadu_pd(tailMask, input + vectorLength), scale));
+      }
+    }
+  }
+
+
+  /** AVX-512 version of the ScaledTensorProduct kernel. */
+  ELX_TARGET_AVX512 static void
+  ScaledTensorProductAVX512(const double *  weights1D,
+                            unsigned int    numberOfWeights1D,
+                            unsigned int    dimension,
+                            const double *  scales,
+                            unsigned int    numberOfScales,
+                            double *        output,
+                            OffsetValueType outputStride,
+                            double *        workspace)
+  {
+    unsigned int length = 1;
+    workspace[0] = 1.0;
+    if (dimension > 1)
+    {
+      for (unsigned int k = 0; k < numberOfWeights1D; ++k)
+      {
+        workspace[k] = weights1D[k];
+      }
+      length = numberOfWeights1D;
+    }
+
+    /** Blocks k > 0 are scaled copies of block 0; block 0 is scaled last, in-place. */
+    for (unsigned int d = 1; d + 1 < dimension; ++d)
+    {
+      const double * w = weights1D + d * numberOfWeights1D;
+      ScaledCopyAVX512(workspace, length, w + 1, numberOfWeights1D - 1, workspace + length, length);
+      ScaledCopyAVX512(workspace, length, w, 1, workspace, 0);
+      length *= numberOfWeights1D;
+    }
+
+    const double * lastWeights = weights1D + (dimension - 1) * numberOfWeights1D;
+    for (unsigned int j = 0; j < numberOfScales; ++j)
+    {
+      double * out = output + j * outputStride;
+      for (unsigned int k = 0; k < numberOfWeights1D; ++k)
+      {
+        const double scale = scales[j] * lastWeights[k];
+        ScaledCopyAVX512(workspace, length, &scale, 1, out + k * length, 0);
+      }
+    }
+  }
+
+#endif // ELX_VECTORIZED_BSPLINE_X86
+
+private:
+  /** The currently selected instruction set, initialized to the supported one. */
+  static std::atomic<int> &
+  GetSelectedInstructionSet(void)
+  {
+    static std::atomic<int> selected(static_cast<int>(GetSupportedInstructionSet()));
+    return selected;
+  }
+
+
+  /** Query the CPU (and the operating system) for AVX2 and AVX-512 support. */
+  static InstructionSetType
+  DetectInstructionSet(void)
+  {
+#if defined(ELX_VECTORIZED_BSPLINE_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+      return AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+      return AVX2;
+    }
+#elif defined(ELX_VECTORIZED_BSPLINE_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maximumLeaf = info[0];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (maximumLeaf >= 7 && osxsave)
+    {
+      /** Check that the OS saves the YMM (and ZMM) registers. */
+      const unsigned long long xcr0 = _xgetbv(0);
+      const bool               ymmEnabled = (xcr0 & 0x6) == 0x6;
+      const bool               zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+      __cpuidex(info, 7, 0);
+      const bool avx2 = (info[1] & (1 << 5)) != 0;
+      const bool avx512f = (info[1] & (1 << 16)) != 0;
+      if (avx512f && zmmEnabled)
+      {
+        return AVX512;
+      }
+      if (avx2 && fma && ymmEnabled)
+      {
+        return AVX2;
+      }
+    }
+#endif
+    return Scalar;
+  }
+};
+
+} // end namespace itk
+
+#endif /* itkVectorizedBSplineKernels_h */
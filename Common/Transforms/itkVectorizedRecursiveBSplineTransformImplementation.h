@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkVectorizedRecursiveBSplineTransformImplementation_h
+#define itkVectorizedRecursiveBSplineTransformImplementation_h
+
+#include "itkRecursiveBSplineTransformImplementation.h"
+#include "itkVectorizedBSplineKernels.h"
+
+namespace itk
+{
+
+/** \class VectorizedRecursiveBSplineTransformImplementation
+ *
+ * \brief This helper class contains an explicitly vectorized implementation
+ * of the recursive B-spline transform.
+ *
+ * Instead of recursing over the dimensions one scalar at a time, this class
+ * evaluates GetJacobian() and EvaluateJacobianWithImageGradientProduct() as the
+ * (SplineOrder+1)^SpaceDimension tensor product of the 1D weights, scaled once for
+ * each output row, with the VectorizedBSplineKernels::ScaledTensorProduct kernel.
+ * The instruction set (AVX-512, AVX2 or scalar) is selected at run-time, once per
+ * call, and covers both the expansion of the weights and the writing of the
+ * Jacobian. TransformPoint() is a reduction over
+ * scattered rows of coefficients, for which the unrolled recursion is faster,
+ * so it is forwarded to the recursive implementation.
+ *
+ * The functions have the same arguments as the top-level calls of the
+ * RecursiveBSplineTransformImplementation, so that both can be exchanged.
+ * The vectorized kernels work on doubles, so for other scalar types this
+ * class simply forwards to the RecursiveBSplineTransformImplementation.
+ *
+ * \ingroup ITKTransform
+ */
+
+template <unsigned int OutputDimension, unsigned int SpaceDimension, unsigned int SplineOrder, class TScalar>
+class VectorizedRecursiveBSplineTransformImplementation
+{
+public:
+  typedef RecursiveBSplineTransformImplementation<OutputDimension, SpaceDimension, SplineOrder, TScalar>
+    RecursiveImplementationType;
+
+  typedef typename RecursiveImplementationType::ScalarType                   ScalarType;
+  typedef typename RecursiveImplementationType::InternalFloatType            InternalFloatType;
+  typedef typename RecursiveImplementationType::OutputPointType              OutputPointType;
+  typedef typename RecursiveImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  /** TransformPoint implementation. */
+  static inline void
+  TransformPoint(OutputPointType                    opp,
+                 const CoefficientPointerVectorType mu,
+                 const OffsetValueType *            gridOffsetTable,
+                 const double *                     weights1D)
+  {
+    RecursiveImplementationType::TransformPoint(opp, mu, gridOffsetTable, weights1D);
+  }
+
+
+  /** GetJacobian implementation. */
+  static inline void
+  GetJacobian(ScalarType *& jacobians, const double * weights1D, double value)
+  {
+    RecursiveImplementationType::GetJacobian(jacobians, weights1D, value);
+  }
+
+
+  /** EvaluateJacobianWithImageGradientProduct implementation. */
+  static inline void
+  EvaluateJacobianWithImageGradientProduct(ScalarType *&             imageJacobian,
+                                           const InternalFloatType * movingImageGradient,
+                                           const double *            weights1D,
+                                           double                    value)
+  {
+    RecursiveImplementationType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobian, movingImageGradient, weights1D, value);
+  }
+};
+
+
+/** \class VectorizedRecursiveBSplineTransformImplementation
+ *
+ * \brief Vectorized implementation for double precision coefficients.
+ */
+
+template <unsigned int OutputDimension, unsigned int SpaceDimension, unsigned int SplineOrder>
+class VectorizedRecursiveBSplineTransformImplementation<OutputDimension, SpaceDimension, SplineOrder, double>
+{
+public:
+  typedef RecursiveBSplineTransformImplementation<OutputDimension, SpaceDimension, SplineOrder, double>
+    RecursiveImplementationType;
+
+  typedef typename RecursiveImplementationType::ScalarType                   ScalarType;
+  typedef typename RecursiveImplementationType::InternalFloatType            InternalFloatType;
+  typedef typename RecursiveImplementationType::OutputPointType              OutputPointType;
+  typedef typename RecursiveImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  /** The number of weights in 1D, and in the full support region. */
+  itkStaticConstMacro(NumberOfWeights1D, unsigned int, SplineOrder + 1);
+  itkStaticConstMacro(BSplineNumberOfIndices, unsigned int, RecursiveImplementationType::BSplineNumberOfIndices);
+
+  /** TransformPoint implementation.
+   * This is a reduction over the support region with the coefficients scattered
+   * over (SplineOrder+1)^(SpaceDimension-1) rows. The fully unrolled recursion is faster here than
+   * expanding the tensor product first, so the recursive implementation is used.
+   */
+  static inline void
+  TransformPoint(OutputPointType                    opp,
+                 const CoefficientPointerVectorType mu,
+                 const OffsetValueType *            gridOffsetTable,
+                 const double *                     weights1D)
+  {
+    RecursiveImplementationType::TransformPoint(opp, mu, gridOffsetTable, weights1D);
+  } // end TransformPoint()
+
+
+  /** GetJacobian vectorized implementation.
+   * Like the recursive implementation, the Jacobian is written directly in the
+   * memory block of the SpaceDimension x ( SpaceDimension * BSplineNumberOfIndices )
+   * Jacobian matrix, and the pointer is advanced by BSplineNumberOfIndices.
+   * The ordering equals that of the recursive implementation, i.e. the first dimension
+   * runs fastest.
+   */
+  static inline void
+  GetJacobian(ScalarType *& jacobians, const double * weights1D, double value)
+  {
+    double workspace[BSplineNumberOfIndices];
+    double values[OutputDimension];
+    for (unsigned int j = 0; j < OutputDimension; ++j)
+    {
+      values[j] = value;
+    }
+
+    VectorizedBSplineKernels::ScaledTensorProduct(weights1D,
+                                                  NumberOfWeights1D,
+                                                  SpaceDimension,
+                                                  values,
+                                                  OutputDimension,
+                                                  jacobians,
+                                                  BSplineNumberOfIndices * (OutputDimension + 1),
+                                                  workspace);
+    jacobians += BSplineNumberOfIndices;
+  } // end GetJacobian()
+
+
+  /** EvaluateJacobianWithImageGradientProduct vectorized implementation. */
+  static inline void
+  EvaluateJacobianWithImageGradientProduct(ScalarType *&             imageJacobian,
+                                           const InternalFloatType * movingImageGradient,
+                                           const double *            weights1D,
+                                           double                    value)
+  {
+    double workspace[BSplineNumberOfIndices];
+    double scales[OutputDimension];
+    for (unsigned int j = 0; j < OutputDimension; ++j)
+    {
+      scales[j] = value * movingImageGradient[j];
+    }
+
+    VectorizedBSplineKernels::ScaledTensorProduct(weights1D,
+                                                  NumberOfWeights1D,
+                                                  SpaceDimension,
+                                                  scales,
+                                                  OutputDimension,
+                                                  imageJacobian,
+                                                  BSplineNumberOfIndices,
+                                                  workspace);
+    imageJacobian += BSplineNumberOfIndices;
+  } // end EvaluateJacobianWithImageGradientProduct()
+};
+
+
+} // end namespace itk
+
+#endif /* itkVectorizedRecursiveBSplineTransformImplementation_h */
@@ -22,6 +22,16 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkPlatformMultiThreader.h"
+
+#include "vnl/vnl_diag_matrix.h"
+#include "vnl/vnl_sparse_matrix.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <vector>
 
 namespace itk
 {
@@ -31,6 +41,14 @@ namespace itk
  * More specifically this class computes the Jacobian terms related to the automatic
  * parameter estimation for the adaptive stochastic gradient descent optimizer.
  * Details can be found in the paper.
+ *
+ * By default the computation is multi-threaded. The threads take chunks of samples
+ * in turn, sum J^T J of consecutive samples with the same nonzero Jacobian indices,
+ * and add these sums to the covariance matrix in the order of the chunks. The size
+ * of a chunk only depends on the number of nonzero Jacobian indices, so the memory
+ * per thread is bounded, and the covariance matrix is exactly equal to the one of
+ * the single-threaded computation, for any number of threads. The threads then
+ * compute the maximum of the JJ and JCJ terms over their part of the samples.
  */
 
 template <class TFixedImage, class TTransform>
@@ -100,13 +118,36 @@ public:
   /** Get the region over which the metric will be computed. */
   itkGetConstReferenceMacro(FixedImageRegion, FixedImageRegionType);
 
+  /** Select the use of multi-threading. */
+  itkSetMacro(UseMultiThread, bool);
+  itkGetConstMacro(UseMultiThread, bool);
+  itkBooleanMacro(UseMultiThread);
+
+  /** Set the number of threads. */
+  void
+  SetNumberOfWorkUnits(ThreadIdType numberOfThreads)
+  {
+    this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+
+
+  /** The time in seconds that the last call to Compute() spent on the covariance
+   * matrix (TrC and TrCC), and on the maximum of the JJ and JCJ terms.
+   */
+  itkGetConstMacro(CovarianceComputationTime, double);
+  itkGetConstMacro(MaximumJCJComputationTime, double);
+
   /** The main functions that performs the computation. */
   virtual void
   Compute(double & TrC, double & TrCC, double & maxJJ, double & maxJCJ);
 
 protected:
   ComputeJacobianTerms();
-  ~ComputeJacobianTerms() override = default;
+  ~ComputeJacobianTerms() override;
+
+  /** Typedefs for multi-threading. */
+  typedef itk::PlatformMultiThreader ThreaderType;
+  typedef ThreaderType::WorkUnitInfo ThreadInfoType;
 
   typename FixedImageType::ConstPointer m_FixedImage;
   FixedImageRegionType                  m_FixedImageRegion;
@@ -119,6 +160,11 @@ protected:
   unsigned int  m_NumberOfBandStructureSamples;
   SizeValueType m_NumberOfJacobianMeasurements;
 
+  ThreaderType::Pointer m_Threader;
+  bool                  m_UseMultiThread;
+  double                m_CovarianceComputationTime;
+  double                m_MaximumJCJComputationTime;
+
   typedef typename FixedImageType::IndexType   FixedImageIndexType;
   typedef typename FixedImageType::PointType   FixedImagePointType;
   typedef typename TransformType::JacobianType JacobianType;
@@ -140,12 +186,110 @@ protected:
   typedef typename TransformType::ScalarType             CoordinateRepresentationType;
   typedef typename TransformType::NumberOfParametersType NumberOfParametersType;
 
+  /** Typedefs for the covariance matrix. */
+  typedef double                                 CovarianceValueType;
+  typedef itk::Array2D<CovarianceValueType>      CovarianceMatrixType;
+  typedef vnl_sparse_matrix<CovarianceValueType> SparseCovarianceMatrixType;
+  typedef SparseCovarianceMatrixType::row        SparseRowType;
+  typedef itk::Array<SizeValueType>              NonZeroJacobianIndicesExpandedType;
+  typedef vnl_diag_matrix<CovarianceValueType>   DiagCovarianceMatrixType;
+
   /** Sample the fixed image to compute the Jacobian terms. */
   // \todo: note that this is an exact copy of itk::ComputeDisplacementDistribution
   // in the future it would be better to refactoring this part of the code.
   virtual void
   SampleFixedImageForJacobianTerms(ImageSampleContainerPointer & sampleContainer);
 
+  /** The sum of J_j^T J_j over consecutive samples with the same nonzero Jacobian indices. */
+  struct JacobianProductType
+  {
+    CovarianceMatrixType       jactjac;
+    NonZeroJacobianIndicesType jacind;
+  };
+  typedef std::vector<JacobianProductType> JacobianProductContainerType;
+
+  /** Sum J_j^T J_j of the consecutive samples of [pos_begin, pos_end) with the same nonzero
+   * Jacobian indices. The sums are stored in the first elements of the container, of which
+   * the storage is reused. Returns the number of sums.
+   */
+  unsigned int
+  ComputeCovarianceRange(unsigned long                  pos_begin,
+                         unsigned long                  pos_end,
+                         JacobianProductContainerType & products) const;
+
+  /** Add 1/n times the first numberOfProducts sums to the covariance matrices. */
+  void
+  AddJacobianProducts(const JacobianProductContainerType & products, unsigned int numberOfProducts);
+
+  /** Add 1/n jactjac to the band and sparse covariance matrices. */
+  void
+  UpdateCovariance(const CovarianceMatrixType & jactjac, const NonZeroJacobianIndicesType & jacind, const double n);
+
+  /** Get the samples [pos_begin, pos_end) of a chunk. */
+  void
+  GetChunkSampleRange(SizeValueType chunk, unsigned long & pos_begin, unsigned long & pos_end) const;
+
+  /** Compute the maximum of the JJ and JCJ terms over the samples [pos_begin, pos_end). */
+  void
+  ComputeMaximumJCJRange(unsigned long pos_begin, unsigned long pos_end, double & maxJJ, double & maxJCJ) const;
+
+  /** Get the samples [pos_begin, pos_end) of a thread. */
+  void
+  GetThreadSampleRange(ThreadIdType threadId, unsigned long & pos_begin, unsigned long & pos_end) const;
+
+  /** Compute threader callback functions. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeCovarianceThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeMaximumJCJThreaderCallback(void * arg);
+
+  /** Launch the threads with the given callback. */
+  void
+  LaunchThreaderCallback(ThreadFunctionType callback) const;
+
+  /** Initialize some multi-threading related parameters. */
+  void
+  InitializeThreadingParameters(void);
+
+  /** To give the threads access to all member variables and functions. */
+  struct MultiThreaderParameterType
+  {
+    Self * st_Self;
+  };
+  mutable MultiThreaderParameterType m_ThreaderParameters;
+
+  struct ComputePerThreadStruct
+  {
+    /**  Used for accumulating variables. */
+    double st_MaxJJ;
+    double st_MaxJCJ;
+  };
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT, ComputePerThreadStruct, PaddedComputePerThreadStruct);
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT, PaddedComputePerThreadStruct, AlignedComputePerThreadStruct);
+  mutable AlignedComputePerThreadStruct * m_ComputePerThreadVariables;
+  mutable ThreadIdType                    m_ComputePerThreadVariablesSize;
+
+  /** Intermediate results of Compute(). */
+  ImageSampleContainerPointer m_SampleContainer;
+  SparseCovarianceMatrixType  m_Covariance;
+  CovarianceMatrixType        m_BandCovariance;
+  std::vector<unsigned int>   m_BandCovarianceMap;
+  DiagCovarianceMatrixType    m_DiagonalCovariance;
+
+  /** The chunks of samples of the covariance computation. The threads take the next chunk
+   * from m_NextChunk, and wait until m_NextChunkToAdd is their chunk to add its sums.
+   * The first exception of a chunk is kept in m_ChunkException, and rethrown when all
+   * threads are done.
+   */
+  SizeValueType              m_NumberOfSamplesPerChunk;
+  SizeValueType              m_NumberOfChunks;
+  std::atomic<SizeValueType> m_NextChunk;
+  SizeValueType              m_NextChunkToAdd;
+  std::mutex                 m_ChunkMutex;
+  std::condition_variable    m_ChunkAddedCondition;
+  std::exception_ptr         m_ChunkException;
+
 private:
   ComputeJacobianTerms(const Self &) = delete;
   void
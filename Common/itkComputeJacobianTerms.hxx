@@ -24,6 +24,9 @@
 #include "vnl/vnl_fastops.h"
 #include "vnl/vnl_diag_matrix.h"
 #include "vnl/vnl_sparse_matrix.h"
+#include "itkTimeProbe.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -44,9 +47,65 @@ ComputeJacobianTerms<TFixedImage, TTransform>::ComputeJacobianTerms()
   this->m_NumberOfBandStructureSamples = 0;
   this->m_NumberOfJacobianMeasurements = 0;
 
+  /** Threading related variables. */
+  this->m_UseMultiThread = true;
+  this->m_Threader = ThreaderType::New();
+  this->m_CovarianceComputationTime = 0.0;
+  this->m_MaximumJCJComputationTime = 0.0;
+  this->m_NumberOfSamplesPerChunk = 0;
+  this->m_NumberOfChunks = 0;
+  this->m_NextChunk = 0;
+  this->m_NextChunkToAdd = 0;
+
+  /** Initialize the m_ThreaderParameters. */
+  this->m_ThreaderParameters.st_Self = this;
+
+  // Multi-threading structs
+  this->m_ComputePerThreadVariables = nullptr;
+  this->m_ComputePerThreadVariablesSize = 0;
+
 } // end Constructor
 
 
+/**
+ * ************************* Destructor ************************
+ */
+
+template <class TFixedImage, class TTransform>
+ComputeJacobianTerms<TFixedImage, TTransform>::~ComputeJacobianTerms()
+{
+  delete[] this->m_ComputePerThreadVariables;
+} // end Destructor
+
+
+/**
+ * ************************* InitializeThreadingParameters ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::InitializeThreadingParameters(void)
+{
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_ComputePerThreadVariablesSize != numberOfThreads)
+  {
+    delete[] this->m_ComputePerThreadVariables;
+    this->m_ComputePerThreadVariables = new AlignedComputePerThreadStruct[numberOfThreads];
+    this->m_ComputePerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. */
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_ComputePerThreadVariables[i].st_MaxJJ = NumericTraits<double>::Zero;
+    this->m_ComputePerThreadVariables[i].st_MaxJCJ = NumericTraits<double>::Zero;
+  }
+
+} // end InitializeThreadingParameters()
+
+
 /**
  * ************************* Compute ************************
  */
@@ -71,58 +130,37 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
    * Term 4: maxJCJ, see (54)
    */
 
-  typedef double                                 CovarianceValueType;
-  typedef itk::Array2D<CovarianceValueType>      CovarianceMatrixType;
-  typedef vnl_sparse_matrix<CovarianceValueType> SparseCovarianceMatrixType;
-  typedef SparseCovarianceMatrixType::row        SparseRowType;
-  typedef itk::Array<SizeValueType>              NonZeroJacobianIndicesExpandedType;
-  typedef vnl_diag_matrix<CovarianceValueType>   DiagCovarianceMatrixType;
-
   /** Initialize. */
   TrC = TrCC = maxJJ = maxJCJ = 0.0;
+  itk::TimeProbe timer;
+  timer.Start();
 
   /** Get samples. */
-  ImageSampleContainerPointer sampleContainer; // default-constructed (null)
-  SampleFixedImageForJacobianTerms(sampleContainer);
-  const SizeValueType nrofsamples = sampleContainer->Size();
-  const double        n = static_cast<double>(nrofsamples);
+  SampleFixedImageForJacobianTerms(this->m_SampleContainer);
+  const ImageSampleContainerPointer & sampleContainer = this->m_SampleContainer;
+  const SizeValueType                 nrofsamples = sampleContainer->Size();
 
   /** Get the number of parameters. */
   const unsigned int P = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
 
   /** Get transform and set current position. */
-  typename TransformType::Pointer transform = this->m_Transform;
-  const unsigned int              outdim = this->m_Transform->GetOutputSpaceDimension();
+  const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
 
   /** Get scales vector */
   const ScalesType & scales = this->m_Scales;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
-  unsigned int                                     samplenr = 0;
-
   /** Variables for nonzerojacobian indices and the Jacobian. */
   NumberOfParametersType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
   JacobianType           jacj(outdim, sizejacind);
   jacj.Fill(0.0);
   NonZeroJacobianIndicesType jacind(sizejacind);
-  jacind[0] = 0;
-  if (sizejacind > 1)
-  {
-    jacind[1] = 0;
-  }
-  NonZeroJacobianIndicesType prevjacind = jacind;
 
   /** Initialize covariance matrix. Sparse, diagonal, and band form. */
-  SparseCovarianceMatrixType cov(P, P);
-  DiagCovarianceMatrixType   diagcov(P, 0.0);
-  CovarianceMatrixType       bandcov;
-
-  /** For temporary storage of J'J. */
-  CovarianceMatrixType jactjac(sizejacind, sizejacind);
-  jactjac.Fill(0.0);
+  SparseCovarianceMatrixType & cov = this->m_Covariance;
+  DiagCovarianceMatrixType &   diagcov = this->m_DiagonalCovariance;
+  CovarianceMatrixType &       bandcov = this->m_BandCovariance;
+  cov = SparseCovarianceMatrixType(P, P);
+  diagcov = DiagCovarianceMatrixType(P, 0.0);
 
   typedef std::vector<unsigned int>             DifHistType;
   typedef std::pair<unsigned int, unsigned int> FreqPairType;
@@ -217,6 +255,7 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
   /** Initialize band matrix. */
   bandcov = CovarianceMatrixType(P, bandcovsize);
   bandcov.Fill(0.0);
+  this->m_BandCovarianceMap = bandcovMap;
 
   /**
    *    TERM 1
@@ -225,103 +264,45 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
    * Compute C = 1/n \sum_i J_i^T J_i
    * Possibly apply scaling afterwards.
    */
-  jacind[0] = 0;
-  if (sizejacind > 1)
-  {
-    jacind[1] = 0;
-  }
-  for (iter = begin; iter != end; ++iter)
+  /** The samples are processed in chunks, of which the sums of J^T J take at most about
+   * 4 MB. Also when multi-threaded, the chunks are added to the covariance matrices in
+   * their order, so that the result does not depend on the number of threads.
+   */
+  const SizeValueType maximumChunkMemory = 4 * 1024 * 1024;
+  const SizeValueType maximumNumberOfSamplesPerChunk = 256;
+  const SizeValueType jacobianProductMemory = sizejacind * sizejacind * sizeof(CovarianceValueType);
+  this->m_NumberOfSamplesPerChunk =
+    std::max<SizeValueType>(1, std::min(maximumNumberOfSamplesPerChunk, maximumChunkMemory / jacobianProductMemory));
+  this->m_NumberOfChunks = (nrofsamples + this->m_NumberOfSamplesPerChunk - 1) / this->m_NumberOfSamplesPerChunk;
+
+  if (this->m_UseMultiThread)
   {
-    /** Print progress 0-50%.
-     *progressObserver->UpdateAndPrintProgress( samplenr );*/
-    ++samplenr;
-
-    /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian(point, jacj, jacind);
-
-    /** Skip invalid Jacobians in the beginning, if any. */
-    if (sizejacind > 1)
-    {
-      if (jacind[0] == jacind[1])
-      {
-        continue;
-      }
-    }
-
-    if (jacind == prevjacind)
+    this->m_NextChunk = 0;
+    this->m_NextChunkToAdd = 0;
+    this->m_ChunkException = nullptr;
+    this->InitializeThreadingParameters();
+    this->LaunchThreaderCallback(this->ComputeCovarianceThreaderCallback);
+
+    /** Rethrow the first exception of the threads. */
+    if (this->m_ChunkException != nullptr)
     {
-      /** Update sum of J_j^T J_j. */
-      vnl_fastops::inc_X_by_AtA(jactjac, jacj);
+      std::exception_ptr exception = nullptr;
+      std::swap(exception, this->m_ChunkException);
+      std::rethrow_exception(exception);
     }
-    else
-    {
-      /** The following should only be done after the first sample. */
-      if (iter != begin)
-      {
-        /** Update covariance matrix. */
-        for (unsigned int pi = 0; pi < sizejacind; ++pi)
-        {
-          const unsigned int p = prevjacind[pi];
-          for (unsigned int qi = 0; qi < sizejacind; ++qi)
-          {
-            const unsigned int q = prevjacind[qi];
-            if (q >= p)
-            {
-              const double tempval = jactjac(pi, qi) / n;
-              if (std::abs(tempval) > 1e-14)
-              {
-                const unsigned int bandindex = bandcovMap[q - p];
-                if (bandindex < bandcovsize)
-                {
-                  bandcov(p, bandindex) += tempval;
-                }
-                else
-                {
-                  cov(p, q) += tempval;
-                }
-              }
-            }
-          } // qi
-        }   // pi
-      }     // end if
-
-      /** Initialize jactjac by J_j^T J_j. */
-      vnl_fastops::AtA(jactjac, jacj);
-
-      /** Remember nonzerojacobian indices. */
-      prevjacind = jacind;
-    } // end else
-
-  } // end iter loop: end computation of covariance matrix
-
-  /** Update covariance matrix once again to include last jactjac updates
-   * \todo: a bit ugly that this loop is copied from above.
-   */
-  for (unsigned int pi = 0; pi < sizejacind; ++pi)
+  }
+  else
   {
-    const unsigned int p = prevjacind[pi];
-    for (unsigned int qi = 0; qi < sizejacind; ++qi)
+    JacobianProductContainerType products;
+    for (SizeValueType chunk = 0; chunk < this->m_NumberOfChunks; ++chunk)
     {
-      const unsigned int q = prevjacind[qi];
-      if (q >= p)
-      {
-        const double tempval = jactjac(pi, qi) / n;
-        if (std::abs(tempval) > 1e-14)
-        {
-          const unsigned int bandindex = bandcovMap[q - p];
-          if (bandindex < bandcovsize)
-          {
-            bandcov(p, bandindex) += tempval;
-          }
-          else
-          {
-            cov(p, q) += tempval;
-          }
-        }
-      }
-    } // qi
-  }   // pi
+      unsigned long pos_begin = 0;
+      unsigned long pos_end = 0;
+      this->GetChunkSampleRange(chunk, pos_begin, pos_end);
+      const unsigned int numberOfProducts = this->ComputeCovarianceRange(pos_begin, pos_end, products);
+      this->AddJacobianProducts(products, numberOfProducts);
+    }
+  }
 
   /** Copy the bandmatrix into the sparse matrix and empty the bandcov matrix.
    * \todo: perhaps work further with this bandmatrix instead.
@@ -387,6 +368,9 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
   TrCC *= 2.0;
   TrCC -= diagcov.diagonal().squared_magnitude();
 
+  timer.Stop();
+  this->m_CovarianceComputationTime = timer.GetMean();
+
   /**
    *    TERM 3 and 4
    *
@@ -394,10 +378,190 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
    * \li maxJJ = max_j [ ||J_j||_F^2 + 2\sqrt{2} || J_j J_j^T ||_F ]
    * \li maxJCJ = max_j [ Tr( J_j C J_j^T ) + 2\sqrt{2} || J_j C J_j^T ||_F ]
    */
-  maxJJ = 0.0;
-  maxJCJ = 0.0;
-  const double sqrt2 = std::sqrt(static_cast<double>(2.0));
+  itk::TimeProbe timer2;
+  timer2.Start();
+  if (this->m_UseMultiThread)
+  {
+    this->LaunchThreaderCallback(this->ComputeMaximumJCJThreaderCallback);
 
+    /** Gather the maxima of all threads. */
+    const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+    {
+      maxJJ = std::max(maxJJ, this->m_ComputePerThreadVariables[i].st_MaxJJ);
+      maxJCJ = std::max(maxJCJ, this->m_ComputePerThreadVariables[i].st_MaxJCJ);
+    }
+  }
+  else
+  {
+    this->ComputeMaximumJCJRange(0, nrofsamples, maxJJ, maxJCJ);
+  }
+  timer2.Stop();
+  this->m_MaximumJCJComputationTime = timer2.GetMean();
+
+  /** Release the memory of the intermediate results. */
+  this->m_SampleContainer = nullptr;
+  cov = SparseCovarianceMatrixType();
+  diagcov = DiagCovarianceMatrixType();
+  this->m_BandCovarianceMap.clear();
+
+} // end Compute()
+
+
+/**
+ * ************************* ComputeCovarianceRange ************************
+ */
+
+template <class TFixedImage, class TTransform>
+unsigned int
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeCovarianceRange(unsigned long                  pos_begin,
+                                                                      unsigned long                  pos_end,
+                                                                      JacobianProductContainerType & products) const
+{
+  const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  const NumberOfParametersType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType                 jacj(outdim, sizejacind);
+  jacj.Fill(0.0);
+  NonZeroJacobianIndicesType jacind(sizejacind);
+
+  /** The sum of J^T J of the current series of samples with the same nonzero Jacobian indices. */
+  unsigned int          numberOfProducts = 0;
+  JacobianProductType * product = nullptr;
+
+  for (unsigned long i = pos_begin; i < pos_end; ++i)
+  {
+    /** Read fixed coordinates and get Jacobian J_j. */
+    const FixedImagePointType & point = this->m_SampleContainer->ElementAt(i).m_ImageCoordinates;
+    this->m_Transform->GetJacobian(point, jacj, jacind);
+
+    /** Skip invalid Jacobians in the beginning, if any. */
+    if (sizejacind > 1)
+    {
+      if (jacind[0] == jacind[1])
+      {
+        continue;
+      }
+    }
+
+    if (product != nullptr && jacind == product->jacind)
+    {
+      /** Update sum of J_j^T J_j. */
+      vnl_fastops::inc_X_by_AtA(product->jactjac, jacj);
+    }
+    else
+    {
+      /** Start a new sum, in the storage of a previous chunk if possible. */
+      if (numberOfProducts == products.size())
+      {
+        products.emplace_back();
+        products.back().jactjac.SetSize(sizejacind, sizejacind);
+      }
+      product = &products[numberOfProducts];
+      ++numberOfProducts;
+
+      /** Initialize jactjac by J_j^T J_j, and remember the nonzero Jacobian indices. */
+      vnl_fastops::AtA(product->jactjac, jacj);
+      product->jacind = jacind;
+    }
+
+  } // end loop over the samples
+
+  return numberOfProducts;
+
+} // end ComputeCovarianceRange()
+
+
+/**
+ * ************************* AddJacobianProducts ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::AddJacobianProducts(
+  const JacobianProductContainerType & products,
+  const unsigned int                   numberOfProducts)
+{
+  const double n = static_cast<double>(this->m_SampleContainer->Size());
+  for (unsigned int i = 0; i < numberOfProducts; ++i)
+  {
+    this->UpdateCovariance(products[i].jactjac, products[i].jacind, n);
+  }
+
+} // end AddJacobianProducts()
+
+
+/**
+ * ************************* UpdateCovariance ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::UpdateCovariance(const CovarianceMatrixType &       jactjac,
+                                                                const NonZeroJacobianIndicesType & jacind,
+                                                                const double                       n)
+{
+  CovarianceMatrixType &       bandcov = this->m_BandCovariance;
+  SparseCovarianceMatrixType & cov = this->m_Covariance;
+  const unsigned int           sizejacind = jacind.size();
+  const unsigned int           bandcovsize = bandcov.cols();
+
+  for (unsigned int pi = 0; pi < sizejacind; ++pi)
+  {
+    const unsigned int p = jacind[pi];
+    for (unsigned int qi = 0; qi < sizejacind; ++qi)
+    {
+      const unsigned int q = jacind[qi];
+      if (q >= p)
+      {
+        const double tempval = jactjac(pi, qi) / n;
+        if (std::abs(tempval) > 1e-14)
+        {
+          const unsigned int bandindex = this->m_BandCovarianceMap[q - p];
+          if (bandindex < bandcovsize)
+          {
+            bandcov(p, bandindex) += tempval;
+          }
+          else
+          {
+            cov(p, q) += tempval;
+          }
+        }
+      }
+    } // qi
+  }   // pi
+
+} // end UpdateCovariance()
+
+
+/**
+ * ************************* ComputeMaximumJCJRange ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeMaximumJCJRange(unsigned long pos_begin,
+                                                                      unsigned long pos_end,
+                                                                      double &      maxJJ,
+                                                                      double &      maxJCJ) const
+{
+  const unsigned int P = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
+  const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
+  const ScalesType & scales = this->m_Scales;
+  const double       sqrt2 = std::sqrt(static_cast<double>(2.0));
+
+  /** The covariance matrix is only read here, but vnl_sparse_matrix::get_row() is not const. */
+  SparseCovarianceMatrixType &     cov = const_cast<SparseCovarianceMatrixType &>(this->m_Covariance);
+  const DiagCovarianceMatrixType & diagcov = this->m_DiagonalCovariance;
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  const NumberOfParametersType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType                 jacj(outdim, sizejacind);
+  jacj.Fill(0.0);
+  NonZeroJacobianIndicesType jacind(sizejacind);
+
+  /** Temporaries. */
   JacobianType                       jacjjacj(outdim, outdim);
   JacobianType                       jacjcov(outdim, sizejacind);
   DiagCovarianceMatrixType           diagcovsparse(sizejacind);
@@ -406,11 +570,12 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
   JacobianType                       jacjcovjacj(outdim, outdim);
   NonZeroJacobianIndicesExpandedType jacindExpanded(P);
 
-  samplenr = 0;
-  for (iter = begin; iter != end; ++iter)
+  maxJJ = 0.0;
+  maxJCJ = 0.0;
+  for (unsigned long i = pos_begin; i < pos_end; ++i)
   {
     /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
+    const FixedImagePointType & point = this->m_SampleContainer->ElementAt(i).m_ImageCoordinates;
     this->m_Transform->GetJacobian(point, jacj, jacind);
 
     /** Apply scales, if necessary. */
@@ -506,16 +671,168 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
     /** Max_j [JCJ_j]. */
     maxJCJ = std::max(maxJCJ, JCJ_j);
 
-    /** Show progress 50-100%. */
-    // progressObserver->UpdateAndPrintProgress( samplenr + nrofsamples );
-    ++samplenr;
-
   } // end loop over sample container
 
-  /** Finalize progress information. */
-  // progressObserver->PrintProgress( 1.0 );
+} // end ComputeMaximumJCJRange()
 
-} // end Compute()
+
+/**
+ * ************************* GetThreadSampleRange ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::GetThreadSampleRange(ThreadIdType    threadId,
+                                                                    unsigned long & pos_begin,
+                                                                    unsigned long & pos_end) const
+{
+  const SizeValueType sampleContainerSize = this->m_SampleContainer->Size();
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(numberOfThreads)));
+
+  pos_begin = nrOfSamplesPerThreads * threadId;
+  pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+} // end GetThreadSampleRange()
+
+
+/**
+ * ************************* GetChunkSampleRange ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::GetChunkSampleRange(SizeValueType   chunk,
+                                                                   unsigned long & pos_begin,
+                                                                   unsigned long & pos_end) const
+{
+  const SizeValueType sampleContainerSize = this->m_SampleContainer->Size();
+
+  pos_begin = std::min(sampleContainerSize, chunk * this->m_NumberOfSamplesPerChunk);
+  pos_end = std::min(sampleContainerSize, (chunk + 1) * this->m_NumberOfSamplesPerChunk);
+
+} // end GetChunkSampleRange()
+
+
+/**
+ * ************ ComputeCovarianceThreaderCallback ****************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeCovarianceThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+  Self &                       self = *(temp->st_Self);
+
+  /** Take the next chunk until all chunks are taken. The chunks are taken in increasing
+   * order, so the thread that waits for its turn only waits for the threads of the chunks
+   * before it.
+   */
+  JacobianProductContainerType products;
+  for (SizeValueType chunk = self.m_NextChunk++; chunk < self.m_NumberOfChunks; chunk = self.m_NextChunk++)
+  {
+    /** An exception is caught here, and rethrown after all threads are done, because
+     * the threads of the next chunks wait for this chunk to be added.
+     */
+    unsigned int       numberOfProducts = 0;
+    std::exception_ptr exception;
+    try
+    {
+      unsigned long pos_begin = 0;
+      unsigned long pos_end = 0;
+      self.GetChunkSampleRange(chunk, pos_begin, pos_end);
+      numberOfProducts = self.ComputeCovarianceRange(pos_begin, pos_end, products);
+    }
+    catch (...)
+    {
+      exception = std::current_exception();
+    }
+
+    /** Add the sums in the order of the chunks. After a failure the sums are no longer
+     * added, and no new chunks are taken.
+     */
+    {
+      std::unique_lock<std::mutex> lock(self.m_ChunkMutex);
+      self.m_ChunkAddedCondition.wait(lock, [&self, chunk] { return self.m_NextChunkToAdd == chunk; });
+      if (exception == nullptr && self.m_ChunkException == nullptr)
+      {
+        try
+        {
+          self.AddJacobianProducts(products, numberOfProducts);
+        }
+        catch (...)
+        {
+          exception = std::current_exception();
+        }
+      }
+      if (exception != nullptr && self.m_ChunkException == nullptr)
+      {
+        self.m_ChunkException = exception;
+        self.m_NextChunk = self.m_NumberOfChunks;
+      }
+      ++self.m_NextChunkToAdd;
+    }
+    self.m_ChunkAddedCondition.notify_all();
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeCovarianceThreaderCallback()
+
+
+/**
+ * ************ ComputeMaximumJCJThreaderCallback ****************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeMaximumJCJThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadID = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end = 0;
+  double        maxJJ = 0.0;
+  double        maxJCJ = 0.0;
+  temp->st_Self->GetThreadSampleRange(threadID, pos_begin, pos_end);
+  temp->st_Self->ComputeMaximumJCJRange(pos_begin, pos_end, maxJJ, maxJCJ);
+
+  /** Update the thread struct once. */
+  temp->st_Self->m_ComputePerThreadVariables[threadID].st_MaxJJ = maxJJ;
+  temp->st_Self->m_ComputePerThreadVariables[threadID].st_MaxJCJ = maxJCJ;
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeMaximumJCJThreaderCallback()
+
+
+/**
+ * *********************** LaunchThreaderCallback ***************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::LaunchThreaderCallback(ThreadFunctionType callback) const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod(callback,
+                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchThreaderCallback()
 
 
 /**
@@ -45,6 +45,9 @@
 #include "itkMultiResolutionPyramidImageFilter.h"
 #include "itkNumericTraits.h"
 #include "itkDataObjectDecorator.h"
+#include "itkSharedDataObjectCache.h"
+
+#include <string>
 
 namespace itk
 {
@@ -202,6 +205,17 @@ public:
   itkSetObjectMacro(MovingImagePyramid, MovingImagePyramidType);
   itkGetModifiableObjectMacro(MovingImagePyramid, MovingImagePyramidType);
 
+  /** Set/Get the optional cache of the levels of the fixed image pyramid. When it is set,
+   * the registrations that share the cache, the fixed image and the pyramid settings compute
+   * the levels only once, and graft them into the outputs of their own fixed image pyramid.
+   * The key identifies the pyramid settings that are not visible to this class, like the
+   * parameter map of the registration.
+   */
+  itkSetObjectMacro(FixedImagePyramidCache, SharedDataObjectCache);
+  itkGetModifiableObjectMacro(FixedImagePyramidCache, SharedDataObjectCache);
+  itkSetStringMacro(FixedImagePyramidCacheKey);
+  itkGetStringMacro(FixedImagePyramidCacheKey);
+
   /** Set/Get the number of multi-resolution levels. */
   itkSetClampMacro(NumberOfLevels, unsigned long, 1, NumericTraits<unsigned long>::max());
   itkGetMacro(NumberOfLevels, unsigned long);
@@ -269,6 +283,10 @@ protected:
   virtual void
   PreparePyramids(void);
 
+  /** Update all levels of the fixed image pyramid, or get them from the fixed image pyramid cache. */
+  virtual void
+  UpdateFixedImagePyramid(void);
+
   /** Set the current level to be processed. */
   itkSetMacro(CurrentLevel, unsigned long);
 
@@ -298,6 +316,9 @@ private:
   MovingImagePyramidPointer m_MovingImagePyramid;
   FixedImagePyramidPointer  m_FixedImagePyramid;
 
+  SharedDataObjectCache::Pointer m_FixedImagePyramidCache;
+  std::string                    m_FixedImagePyramidCacheKey;
+
   FixedImageRegionType        m_FixedImageRegion;
   FixedImageRegionPyramidType m_FixedImageRegionPyramid;
 
@@ -44,6 +44,8 @@
 #include "itkContinuousIndex.h"
 #include "vnl/vnl_math.h"
 
+#include <sstream>
+
 namespace itk
 {
 
@@ -67,6 +69,9 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::MultiResolut
   this->m_FixedImagePyramid = FixedImagePyramidType::New();
   this->m_MovingImagePyramid = MovingImagePyramidType::New();
 
+  this->m_FixedImagePyramidCache = nullptr;
+  this->m_FixedImagePyramidCacheKey = "";
+
   this->m_NumberOfLevels = 1;
   this->m_CurrentLevel = 0;
 
@@ -194,7 +199,7 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::PreparePyram
   // Setup the fixed image pyramid
   this->m_FixedImagePyramid->SetNumberOfLevels(this->m_NumberOfLevels);
   this->m_FixedImagePyramid->SetInput(this->m_FixedImage);
-  this->m_FixedImagePyramid->UpdateLargestPossibleRegion();
+  this->UpdateFixedImagePyramid();
 
   // Setup the moving image pyramid
   this->m_MovingImagePyramid->SetNumberOfLevels(this->m_NumberOfLevels);
@@ -265,6 +270,65 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::PreparePyram
 } // end PreparePyramids()
 
 
+/*
+ * Update the fixed image pyramid, or get its levels from the cache
+ */
+template <typename TFixedImage, typename TMovingImage>
+void
+MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::UpdateFixedImagePyramid(void)
+{
+  if (this->m_FixedImagePyramidCache.IsNull())
+  {
+    this->m_FixedImagePyramid->UpdateLargestPossibleRegion();
+    return;
+  }
+
+  /** The registrations that share the cache graft the same fixed image,
+   * so its pixel buffer identifies it.
+   */
+  this->m_FixedImagePyramid->UpdateOutputInformation();
+  std::ostringstream key;
+  key << this->m_FixedImagePyramidCacheKey << ' ' << this->m_FixedImagePyramid->GetNameOfClass() << ' '
+      << static_cast<const void *>(this->m_FixedImage->GetBufferPointer());
+  const auto & schedule = this->m_FixedImagePyramid->GetSchedule();
+  for (unsigned int level = 0; level < schedule.rows(); ++level)
+  {
+    for (unsigned int dim = 0; dim < schedule.cols(); ++dim)
+    {
+      key << ' ' << schedule[level][dim];
+    }
+  }
+
+  bool       computedHere = false;
+  const auto levels = this->m_FixedImagePyramidCache->GetDataObjects(key.str(), [this, &computedHere] {
+    computedHere = true;
+    this->m_FixedImagePyramid->UpdateLargestPossibleRegion();
+
+    SharedDataObjectCache::DataObjectsType computedLevels;
+    for (unsigned int level = 0; level < this->m_NumberOfLevels; ++level)
+    {
+      const auto levelImage = FixedImageType::New();
+      levelImage->Graft(this->m_FixedImagePyramid->GetOutput(level));
+      computedLevels.push_back(levelImage.GetPointer());
+    }
+    return computedLevels;
+  });
+
+  /** Graft the cached levels, and mark them as up-to-date, so that the pyramid
+   * only executes again when it is modified.
+   */
+  if (!computedHere)
+  {
+    for (unsigned int level = 0; level < this->m_NumberOfLevels; ++level)
+    {
+      this->m_FixedImagePyramid->GraftNthOutput(level, levels[level]);
+      this->m_FixedImagePyramid->GetOutput(level)->DataHasBeenGenerated();
+    }
+  }
+
+} // end UpdateFixedImagePyramid()
+
+
 /*
  * Starts the Registration Process
  */
@@ -194,6 +194,41 @@ ScaledSingleValuedNonLinearOptimizer::SetCurrentPosition(const ParametersType &
 } // end SetCurrentPosition()
 
 
+/**
+ * ******************** CreateScaledCostFunctions *******************************
+ */
+
+ScaledSingleValuedNonLinearOptimizer::CostFunctionContainerType
+ScaledSingleValuedNonLinearOptimizer::CreateScaledCostFunctions(const CostFunctionContainerType & costFunctions) const
+{
+  const ScaledCostFunctionType * scaledCostFunction = this->m_ScaledCostFunction;
+  CostFunctionContainerType      scaledCostFunctions;
+  for (const auto & costFunction : costFunctions)
+  {
+    if (costFunction.IsNull())
+    {
+      itkExceptionMacro(<< "One of the cost functions to be scaled has not been set.");
+    }
+    if (costFunction->GetNumberOfParameters() != scaledCostFunction->GetNumberOfParameters())
+    {
+      itkExceptionMacro(<< "The number of parameters of the cost functions to be scaled ("
+                        << costFunction->GetNumberOfParameters()
+                        << ") differs from the number of parameters of the cost function ("
+                        << scaledCostFunction->GetNumberOfParameters() << ").");
+    }
+
+    const ScaledCostFunctionPointer scaledCopy = ScaledCostFunctionType::New();
+    scaledCopy->SetUnscaledCostFunction(costFunction);
+    scaledCopy->SetScales(scaledCostFunction->GetScales());
+    scaledCopy->SetUseScales(scaledCostFunction->GetUseScales());
+    scaledCopy->SetNegateCostFunction(scaledCostFunction->GetNegateCostFunction());
+    scaledCostFunctions.push_back(scaledCopy.GetPointer());
+  }
+  return scaledCostFunctions;
+
+} // end CreateScaledCostFunctions()
+
+
 /**
  * ******************** SetMaximize *******************************
  */
@@ -21,6 +21,8 @@
 #include "itkSingleValuedNonLinearOptimizer.h"
 #include "itkScaledSingleValuedCostFunction.h"
 
+#include <vector>
+
 namespace itk
 {
 /** \class ScaledSingleValuedNonLinearOptimizer
@@ -75,10 +77,14 @@ public:
   itkTypeMacro(ScaledSingleValuedNonLinearOptimizer, SingleValuedNonLinearOptimizer);
 
   /** Typedefs inherited from the superclass. */
-  typedef Superclass::MeasureType      MeasureType;
-  typedef Superclass::ParametersType   ParametersType;
-  typedef Superclass::DerivativeType   DerivativeType;
-  typedef Superclass::CostFunctionType CostFunctionType;
+  typedef Superclass::MeasureType         MeasureType;
+  typedef Superclass::ParametersType      ParametersType;
+  typedef Superclass::DerivativeType      DerivativeType;
+  typedef Superclass::CostFunctionType    CostFunctionType;
+  typedef Superclass::CostFunctionPointer CostFunctionPointer;
+
+  /** A list of cost functions, for example one for each worker thread. */
+  typedef std::vector<CostFunctionPointer> CostFunctionContainerType;
 
   typedef NonLinearOptimizer::ScalesType  ScalesType;
   typedef ScaledSingleValuedCostFunction  ScaledCostFunctionType;
@@ -180,6 +186,14 @@ protected:
                               MeasureType &          value,
                               DerivativeType &       derivative) const;
 
+  /** Wrap each of the given cost functions in a scaled cost function, with the same
+   * scales and negation as the scaled cost function of the optimizer, so that they can
+   * be evaluated at scaled positions, for example concurrently by worker threads. The
+   * cost functions should have the number of parameters of the cost function.
+   */
+  CostFunctionContainerType
+  CreateScaledCostFunctions(const CostFunctionContainerType & costFunctions) const;
+
 private:
   /** The deleted copy constructor. */
   ScaledSingleValuedNonLinearOptimizer(const Self &) = delete;
@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkSharedDataObjectCache_h
+#define itkSharedDataObjectCache_h
+
+#include "itkDataObject.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <exception>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class SharedDataObjectCache
+ *
+ * \brief A thread-safe cache of data objects, which are computed once and shared by several registrations.
+ *
+ * The registrations of a batch that share their fixed image also share the data that only depends
+ * on the fixed side, like the levels of the fixed image pyramid and the eroded fixed masks. The first
+ * registration that asks for such data under a key computes it, while the others that ask for the
+ * same key wait for the result. An exception of the computation is rethrown for every registration
+ * that asks for the key.
+ *
+ * The cached data objects must not be modified: a registration should graft them into its own data
+ * objects, so that the pixel data is shared, while its pipeline state remains separate.
+ *
+ * \ingroup Registration
+ */
+
+class SharedDataObjectCache : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef SharedDataObjectCache    Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(SharedDataObjectCache, Object);
+
+  /** The data objects that are cached under one key. */
+  typedef std::vector<DataObject::Pointer> DataObjectsType;
+
+  /** Get the data objects that are cached under the key. When the key is not yet in
+   * the cache, the data objects are computed by compute(), which is called only once
+   * per key, even when several threads ask for the key at the same time.
+   */
+  template <class TFunction>
+  DataObjectsType
+  GetDataObjects(const std::string & key, const TFunction & compute)
+  {
+    std::promise<DataObjectsType>       promise;
+    std::shared_future<DataObjectsType> future;
+    bool                                computeHere = false;
+    {
+      const std::lock_guard<std::mutex> lock(this->m_Mutex);
+      const auto                        found = this->m_DataObjects.find(key);
+      if (found == this->m_DataObjects.end())
+      {
+        future = promise.get_future().share();
+        this->m_DataObjects[key] = future;
+        computeHere = true;
+      }
+      else
+      {
+        future = found->second;
+      }
+    }
+
+    if (computeHere)
+    {
+      try
+      {
+        promise.set_value(compute());
+      }
+      catch (...)
+      {
+        promise.set_exception(std::current_exception());
+      }
+    }
+    return future.get();
+  }
+
+
+  /** The number of keys in the cache. */
+  SizeValueType
+  GetNumberOfKeys(void) const
+  {
+    const std::lock_guard<std::mutex> lock(this->m_Mutex);
+    return this->m_DataObjects.size();
+  }
+
+
+  /** Remove all data objects from the cache. */
+  void
+  Clear(void)
+  {
+    const std::lock_guard<std::mutex> lock(this->m_Mutex);
+    this->m_DataObjects.clear();
+  }
+
+
+protected:
+  SharedDataObjectCache() = default;
+  ~SharedDataObjectCache() override = default;
+
+private:
+  SharedDataObjectCache(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  mutable std::mutex                                         m_Mutex;
+  std::map<std::string, std::shared_future<DataObjectsType>> m_DataObjects;
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkSharedDataObjectCache_h
@@ -0,0 +1,215 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkTransformixBinaryPointFile_h
+#define itkTransformixBinaryPointFile_h
+
+#include "itkByteSwapper.h"
+#include "itkIntTypes.h"
+
+#include <cstdint>
+#include <cstring> // For memcmp and memcpy.
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace itk
+{
+
+/** \class TransformixBinaryPointFile
+ *
+ * \brief Reads and writes the binary point files of transformix.
+ *
+ * A binary point file stores the points as raw little-endian float or double
+ * components, after a header of 32 bytes:
+ *
+ *   - the magic string "ELXPOINT" (8 bytes),
+ *   - the version of the format, currently 1 (uint32),
+ *   - the dimension of the points (uint32),
+ *   - the size of a component in bytes, 4 for float or 8 for double (uint32),
+ *   - the flags, bit 0 set if the points are (continuous) image indices (uint32),
+ *   - the number of points (uint64).
+ *
+ * The components of the points follow the header, point after point. Parsing
+ * and formatting text is avoided, so large point sets are read and written at
+ * the speed of the disk.
+ *
+ * \ingroup Transforms
+ */
+
+class TransformixBinaryPointFile
+{
+public:
+  /** The information in the header of a binary point file. */
+  struct HeaderType
+  {
+    std::uint32_t m_Dimension{ 0 };
+    std::uint32_t m_ComponentSize{ 0 };
+    bool          m_PointsAreIndices{ false };
+    std::uint64_t m_NumberOfPoints{ 0 };
+  };
+
+  /** The size of the header in bytes. */
+  static constexpr std::size_t HeaderSize = 32;
+
+  /** Read the header. Returns false, and leaves the header unchanged, if the
+   * stream does not start with a valid header of a binary point file.
+   */
+  static bool
+  ReadHeader(std::istream & stream, HeaderType & header)
+  {
+    char buffer[HeaderSize];
+    if (!stream.read(buffer, HeaderSize) || std::memcmp(buffer, GetMagic(), 8) != 0)
+    {
+      return false;
+    }
+
+    const std::uint32_t version = ReadLittleEndian<std::uint32_t>(buffer + 8);
+    const std::uint32_t dimension = ReadLittleEndian<std::uint32_t>(buffer + 12);
+    const std::uint32_t componentSize = ReadLittleEndian<std::uint32_t>(buffer + 16);
+    const std::uint32_t flags = ReadLittleEndian<std::uint32_t>(buffer + 20);
+    if (version != 1 || (componentSize != sizeof(float) && componentSize != sizeof(double)))
+    {
+      return false;
+    }
+
+    header.m_Dimension = dimension;
+    header.m_ComponentSize = componentSize;
+    header.m_PointsAreIndices = (flags & 1u) != 0;
+    header.m_NumberOfPoints = ReadLittleEndian<std::uint64_t>(buffer + 24);
+    return true;
+  }
+
+
+  /** Write the header. */
+  static void
+  WriteHeader(std::ostream & stream, const HeaderType & header)
+  {
+    char buffer[HeaderSize];
+    std::memcpy(buffer, GetMagic(), 8);
+    WriteLittleEndian<std::uint32_t>(buffer + 8, 1);
+    WriteLittleEndian<std::uint32_t>(buffer + 12, header.m_Dimension);
+    WriteLittleEndian<std::uint32_t>(buffer + 16, header.m_ComponentSize);
+    WriteLittleEndian<std::uint32_t>(buffer + 20, header.m_PointsAreIndices ? 1u : 0u);
+    WriteLittleEndian<std::uint64_t>(buffer + 24, header.m_NumberOfPoints);
+    stream.write(buffer, HeaderSize);
+  }
+
+
+  /** Returns the number of whole points between the current position of the stream, just after
+   * the header, and the end of the stream, without changing the position. Returns zero if the
+   * size of the stream cannot be determined.
+   */
+  static std::uint64_t
+  GetNumberOfPointsInStream(std::istream & stream, const HeaderType & header)
+  {
+    const std::uint64_t  pointSize = std::uint64_t{ header.m_Dimension } * header.m_ComponentSize;
+    const std::streampos position = stream.tellg();
+    if (pointSize == 0 || position < 0 || !stream.seekg(0, std::ios::end))
+    {
+      return 0;
+    }
+    const std::streampos end = stream.tellg();
+    stream.seekg(position);
+    if (end < position)
+    {
+      return 0;
+    }
+    return static_cast<std::uint64_t>(end - position) / pointSize;
+  }
+
+
+  /** Read the components of numberOfPoints points, and convert them to TValue.
+   * The components of a file of the wrong dimension are not rearranged, so the
+   * caller should check the dimension of the header first.
+   */
+  template <class TValue>
+  static bool
+  ReadComponents(std::istream &     stream,
+                 const HeaderType & header,
+                 SizeValueType      numberOfPoints,
+                 TValue * const     components)
+  {
+    const SizeValueType numberOfComponents = numberOfPoints * header.m_Dimension;
+    if (header.m_ComponentSize == sizeof(float))
+    {
+      return ReadAndConvert<float>(stream, numberOfComponents, components);
+    }
+    return ReadAndConvert<double>(stream, numberOfComponents, components);
+  }
+
+
+  /** Write numberOfComponents components as doubles. */
+  static void
+  WriteComponents(std::ostream & stream, const double * const components, const SizeValueType numberOfComponents)
+  {
+    std::vector<double> buffer(components, components + numberOfComponents);
+    ByteSwapper<double>::SwapRangeFromSystemToLittleEndian(buffer.data(), numberOfComponents);
+    stream.write(reinterpret_cast<const char *>(buffer.data()),
+                 static_cast<std::streamsize>(numberOfComponents * sizeof(double)));
+  }
+
+private:
+  static const char *
+  GetMagic(void)
+  {
+    return "ELXPOINT";
+  }
+
+
+  template <class T>
+  static T
+  ReadLittleEndian(const char * const bytes)
+  {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    ByteSwapper<T>::SwapFromSystemToLittleEndian(&value);
+    return value;
+  }
+
+
+  template <class T>
+  static void
+  WriteLittleEndian(char * const bytes, T value)
+  {
+    ByteSwapper<T>::SwapFromSystemToLittleEndian(&value);
+    std::memcpy(bytes, &value, sizeof(T));
+  }
+
+
+  template <class TFile, class TValue>
+  static bool
+  ReadAndConvert(std::istream & stream, const SizeValueType numberOfComponents, TValue * const components)
+  {
+    std::vector<TFile> buffer(numberOfComponents);
+    if (!stream.read(reinterpret_cast<char *>(buffer.data()),
+                     static_cast<std::streamsize>(numberOfComponents * sizeof(TFile))))
+    {
+      return false;
+    }
+    ByteSwapper<TFile>::SwapRangeFromSystemToLittleEndian(buffer.data(), numberOfComponents);
+    for (SizeValueType i = 0; i < numberOfComponents; ++i)
+    {
+      components[i] = static_cast<TValue>(buffer[i]);
+    }
+    return true;
+  }
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkTransformixBinaryPointFile_h
@@ -20,6 +20,7 @@
 #define itkTransformixInputPointFileReader_h
 
 #include "itkMeshFileReaderBase.h"
+#include "itkTransformixBinaryPointFile.h"
 
 #include <fstream>
 
@@ -40,6 +41,10 @@ namespace itk
  *
  * The second word in the text file represents the number of points that
  * should be read.
+ *
+ * Files that start with the header of a TransformixBinaryPointFile are read
+ * as binary point files. Their points may be stored as float or double, and
+ * their dimension should be equal to the dimension of the output mesh.
  **/
 
 template <class TOutputMesh>
@@ -81,6 +86,9 @@ public:
    */
   itkGetConstMacro(NumberOfPoints, unsigned long);
 
+  /** Get whether the file is a binary point file. */
+  itkGetConstMacro(PointsAreBinary, bool);
+
   /** Prepare the allocation of the output mesh during the first back
    * propagation of the pipeline. Updates the PointsAreIndices and NumberOfPoints.
    */
@@ -97,8 +105,10 @@ protected:
 
   unsigned long m_NumberOfPoints;
   bool          m_PointsAreIndices;
+  bool          m_PointsAreBinary;
 
-  std::ifstream m_Reader;
+  std::ifstream                          m_Reader;
+  TransformixBinaryPointFile::HeaderType m_BinaryHeader;
 
 private:
   TransformixInputPointFileReader(const Self &) = delete;
@@ -21,6 +21,11 @@
 
 #include "itkTransformixInputPointFileReader.h"
 
+#include <algorithm> // For copy_n.
+#include <cstdint>
+#include <limits>
+#include <vector>
+
 namespace itk
 {
 
@@ -33,6 +38,7 @@ TransformixInputPointFileReader<TOutputMesh>::TransformixInputPointFileReader()
 {
   this->m_NumberOfPoints = 0;
   this->m_PointsAreIndices = false;
+  this->m_PointsAreBinary = false;
 } // end constructor
 
 
@@ -66,6 +72,49 @@ TransformixInputPointFileReader<TOutputMesh>::GenerateOutputInformation(void)
   {
     this->m_Reader.close();
   }
+
+  /** Check for the header of a binary point file. */
+  this->m_Reader.open(this->m_FileName.c_str(), std::ios::binary);
+  this->m_PointsAreBinary = TransformixBinaryPointFile::ReadHeader(this->m_Reader, this->m_BinaryHeader);
+  if (this->m_PointsAreBinary)
+  {
+    if (this->m_BinaryHeader.m_Dimension != OutputMeshType::PointDimension)
+    {
+      this->m_Reader.close();
+      std::ostringstream msg;
+      msg << "The dimension of the points in the binary point file (" << this->m_BinaryHeader.m_Dimension
+          << ") is not equal to " << OutputMeshType::PointDimension << "." << std::endl
+          << "Filename: " << this->m_FileName << std::endl;
+      MeshFileReaderException e(__FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION);
+      throw e;
+    }
+
+    /** Check the number of points of the header against the size of the file, before
+     * anything is allocated for them. The division avoids an overflow of the byte count.
+     */
+    const std::uint64_t numberOfPoints = this->m_BinaryHeader.m_NumberOfPoints;
+    const std::uint64_t numberOfPointsInFile =
+      TransformixBinaryPointFile::GetNumberOfPointsInStream(this->m_Reader, this->m_BinaryHeader);
+    if (numberOfPoints > numberOfPointsInFile ||
+        numberOfPoints > std::numeric_limits<unsigned long>::max() / OutputMeshType::PointDimension)
+    {
+      this->m_Reader.close();
+      std::ostringstream msg;
+      msg << "The binary point file specifies " << numberOfPoints << " points, but its size allows only "
+          << numberOfPointsInFile << " points." << std::endl
+          << "Filename: " << this->m_FileName << std::endl;
+      MeshFileReaderException e(__FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION);
+      throw e;
+    }
+    this->m_PointsAreIndices = this->m_BinaryHeader.m_PointsAreIndices;
+    this->m_NumberOfPoints = static_cast<unsigned long>(numberOfPoints);
+
+    /** Leave the file open for the generate data method */
+    return;
+  }
+
+  /** Not a binary file, so reopen it as a text file. */
+  this->m_Reader.close();
   this->m_Reader.open(this->m_FileName.c_str());
 
   /** Read the first entry */
@@ -114,7 +163,27 @@ TransformixInputPointFileReader<TOutputMesh>::GenerateData(void)
   PointsContainerPointer points = PointsContainerType::New();
 
   /** Read the file */
-  if (this->m_Reader.is_open())
+  if (this->m_Reader.is_open() && this->m_PointsAreBinary)
+  {
+    /** Read all components at once, and fill the point container. */
+    std::vector<typename PointType::ValueType> components(this->m_NumberOfPoints * dimension);
+    if (!TransformixBinaryPointFile::ReadComponents(
+          this->m_Reader, this->m_BinaryHeader, this->m_NumberOfPoints, components.data()))
+    {
+      std::ostringstream msg;
+      msg << "The file is not large enough. " << std::endl << "Filename: " << this->m_FileName << std::endl;
+      MeshFileReaderException e(__FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION);
+      throw e;
+    }
+    points->Reserve(this->m_NumberOfPoints);
+    for (unsigned long i = 0; i < this->m_NumberOfPoints; ++i)
+    {
+      PointType point;
+      std::copy_n(components.data() + i * dimension, dimension, point.Begin());
+      points->SetElement(i, point);
+    }
+  }
+  else if (this->m_Reader.is_open())
   {
     for (unsigned int i = 0; i < this->m_NumberOfPoints; ++i)
     {
@@ -20,11 +20,18 @@
 
 namespace xoutlibrary
 {
-static xoutbase_type * local_xout = nullptr;
+thread_local xoutbase_type * local_xout = nullptr;
 
 xoutbase_type &
 get_xout(void)
 {
+  if (local_xout == nullptr)
+  {
+    /** A thread without a logging context, like an ITK worker thread, writes to
+     * an xout object without outputs and target cells, which discards the messages. */
+    thread_local xoutbase_type discardingXout;
+    return discardingXout;
+  }
   return *local_xout;
 }
 
@@ -23,6 +23,7 @@
 #include "xoutsimple.h"
 #include "xoutrow.h"
 #include "xoutcell.h"
+#include "xoutsynchronizedbuf.h"
 
 /** Define a namespace alias. */
 namespace xl = xoutlibrary;
@@ -37,12 +38,22 @@ typedef xoutsimple<char> xoutsimple_type;
 typedef xoutrow<char>    xoutrow_type;
 typedef xoutcell<char>   xoutcell_type;
 
+typedef xoutsynchronizedbuf<char> xoutsynchronizedbuf_type;
+
+/** The xout object of the calling thread. Each thread has its own xout, so
+ * that registrations that run concurrently in different threads do not share
+ * their logging. The xout objects themselves are owned by the caller of set_xout,
+ * typically the elastix::xoutManager of a registration. A thread for which no
+ * xout object is installed, like an ITK worker thread, gets an xout object that
+ * discards its output. */
 xoutbase_type &
 get_xout(void);
 
+/** Install the xout object of the calling thread. Does not take ownership. */
 void
 set_xout(xoutbase_type * arg);
 
+/** Returns whether an xout object is installed for the calling thread. */
 bool
 xout_valid();
 
@@ -0,0 +1,99 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef xoutsynchronizedbuf_h
+#define xoutsynchronizedbuf_h
+
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace xoutlibrary
+{
+using namespace std;
+
+/**
+ * \class xoutsynchronizedbuf
+ * \brief Stream buffer that forwards complete lines to a shared output stream.
+ *
+ * Several xout objects, for example of registrations that run concurrently in
+ * different threads, may write to the same output stream, like std::cout. Each
+ * of them should then use its own ostream on top of an xoutsynchronizedbuf.
+ * The characters are collected per line, and each complete line is written
+ * to the target while holding a lock, so that the lines do not interleave.
+ * Lines that are not yet complete are written when the stream is flushed.
+ *
+ * \ingroup xout
+ */
+
+template <class charT, class traits = char_traits<charT>>
+class xoutsynchronizedbuf : public basic_streambuf<charT, traits>
+{
+public:
+  /** Typedef's.*/
+  typedef xoutsynchronizedbuf            Self;
+  typedef basic_streambuf<charT, traits> Superclass;
+  typedef typename traits::int_type      int_type;
+  typedef basic_ostream<charT, traits>   ostream_type;
+  typedef basic_string<charT, traits>    string_type;
+
+  /** Constructor, taking the shared target stream. */
+  explicit xoutsynchronizedbuf(ostream_type & target)
+    : m_Target(target)
+  {}
+
+  /** Destructor, writes the remaining characters. */
+  ~xoutsynchronizedbuf() override;
+
+  /** Copying would duplicate the buffered characters. */
+  xoutsynchronizedbuf(const Self &) = delete;
+  Self &
+  operator=(const Self &) = delete;
+
+protected:
+  int_type
+  overflow(int_type c) override;
+
+  streamsize
+  xsputn(const charT * s, streamsize n) override;
+
+  int
+  sync(void) override;
+
+private:
+  /** Write the characters up to and including the last newline. */
+  void
+  WriteCompleteLines(void);
+
+  /** Write the given characters to the target, while holding the lock. */
+  void
+  WriteToTarget(const charT * s, streamsize n, bool flush);
+
+  /** The lock that is shared by all buffers with the same character type. */
+  static mutex &
+  GetMutex(void);
+
+  ostream_type & m_Target;
+  string_type    m_Buffer;
+};
+
+} // end namespace xoutlibrary
+
+#include "xoutsynchronizedbuf.hxx"
+
+#endif // end #ifndef xoutsynchronizedbuf_h
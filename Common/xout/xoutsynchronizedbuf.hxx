@@ -0,0 +1,149 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef xoutsynchronizedbuf_hxx
+#define xoutsynchronizedbuf_hxx
+
+#include "xoutsynchronizedbuf.h"
+
+namespace xoutlibrary
+{
+using namespace std;
+
+/**
+ * ********************* Destructor *****************************
+ */
+
+template <class charT, class traits>
+xoutsynchronizedbuf<charT, traits>::~xoutsynchronizedbuf()
+{
+  if (!this->m_Buffer.empty())
+  {
+    this->WriteToTarget(this->m_Buffer.data(), static_cast<streamsize>(this->m_Buffer.size()), true);
+  }
+
+} // end Destructor
+
+
+/**
+ * ********************* overflow *******************************
+ */
+
+template <class charT, class traits>
+typename xoutsynchronizedbuf<charT, traits>::int_type
+xoutsynchronizedbuf<charT, traits>::overflow(int_type c)
+{
+  if (!traits::eq_int_type(c, traits::eof()))
+  {
+    const charT ch = traits::to_char_type(c);
+    this->m_Buffer.push_back(ch);
+    if (traits::eq(ch, charT('\n')))
+    {
+      this->WriteCompleteLines();
+    }
+  }
+  return traits::not_eof(c);
+
+} // end overflow
+
+
+/**
+ * ********************* xsputn *********************************
+ */
+
+template <class charT, class traits>
+streamsize
+xoutsynchronizedbuf<charT, traits>::xsputn(const charT * s, streamsize n)
+{
+  this->m_Buffer.append(s, static_cast<typename string_type::size_type>(n));
+  if (traits::find(s, static_cast<size_t>(n), charT('\n')) != nullptr)
+  {
+    this->WriteCompleteLines();
+  }
+  return n;
+
+} // end xsputn
+
+
+/**
+ * ********************* sync ***********************************
+ */
+
+template <class charT, class traits>
+int
+xoutsynchronizedbuf<charT, traits>::sync(void)
+{
+  this->WriteToTarget(this->m_Buffer.data(), static_cast<streamsize>(this->m_Buffer.size()), true);
+  this->m_Buffer.clear();
+  return this->m_Target.fail() ? -1 : 0;
+
+} // end sync
+
+
+/**
+ * ********************* WriteCompleteLines *********************
+ */
+
+template <class charT, class traits>
+void
+xoutsynchronizedbuf<charT, traits>::WriteCompleteLines(void)
+{
+  const typename string_type::size_type lastNewline = this->m_Buffer.rfind(charT('\n'));
+  if (lastNewline != string_type::npos)
+  {
+    this->WriteToTarget(this->m_Buffer.data(), static_cast<streamsize>(lastNewline + 1), false);
+    this->m_Buffer.erase(0, lastNewline + 1);
+  }
+
+} // end WriteCompleteLines
+
+
+/**
+ * ********************* WriteToTarget **************************
+ */
+
+template <class charT, class traits>
+void
+xoutsynchronizedbuf<charT, traits>::WriteToTarget(const charT * s, const streamsize n, const bool flush)
+{
+  const lock_guard<mutex> lock(GetMutex());
+  this->m_Target.write(s, n);
+  if (flush)
+  {
+    this->m_Target.flush();
+  }
+
+} // end WriteToTarget
+
+
+/**
+ * ********************* GetMutex *******************************
+ */
+
+template <class charT, class traits>
+mutex &
+xoutsynchronizedbuf<charT, traits>::GetMutex(void)
+{
+  static mutex targetMutex;
+  return targetMutex;
+
+} // end GetMutex
+
+
+} // end namespace xoutlibrary
+
+#endif // end #ifndef xoutsynchronizedbuf_hxx
@@ -120,6 +120,13 @@ public:
   void
   SetFixedSchedule(void) override;
 
+  /** The levels can not be shared when they are computed per resolution. */
+  bool
+  GetLevelsCanBeShared(void) const override
+  {
+    return !this->GetComputeOnlyForCurrentLevel();
+  }
+
   /** Update the current resolution level. */
   void
   BeforeEachResolution(void) override;
@@ -91,6 +91,13 @@ namespace elastix
  *    B-spline grids.
  *    example: <tt>(UseFastAndLowMemoryVersion "false")</tt> \n
  *    The default is "true".
+ * \parameter UseSparseJointPDFDerivatives: Only used when UseFastAndLowMemoryVersion
+ *    is "false". If "true", the derivatives of the joint histogram are not stored
+ *    in the large 3D matrix, but per sample (and per thread), only for the affected
+ *    histogram bins and B-spline parameters. Like the explicit version, it loops only
+ *    once over the samples, while its memory use scales with the number of samples.
+ *    example: <tt>(UseSparseJointPDFDerivatives "true")</tt> \n
+ *    The default is "false".
  *
  * \sa ParzenWindowMutualInformationImageToImageMetric
  * \ingroup Metrics
@@ -199,6 +206,13 @@ public:
   void
   Initialize(void) override;
 
+  /** This metric can be copied for optimizers that evaluate it in parallel, see CreateWorkerMetrics(). */
+  bool
+  GetWorkerMetricsSupported(void) const override
+  {
+    return true;
+  }
+
   /** Set/Get c. For finite difference derivative estimation */
   itkSetMacro(Param_c, double);
   itkGetConstMacro(Param_c, double);
@@ -121,6 +121,12 @@ AdvancedMattesMutualInformationMetric<TElastix>::BeforeEachResolution(void)
     useFastAndLowMemoryVersion, "UseFastAndLowMemoryVersion", this->GetComponentLabel(), level, 0);
   this->SetUseExplicitPDFDerivatives(!useFastAndLowMemoryVersion);
 
+  /** Set whether the explicit joint histogram derivatives should be stored sparsely. */
+  bool useSparseJointPDFDerivatives = false;
+  this->GetConfiguration()->ReadParameter(
+    useSparseJointPDFDerivatives, "UseSparseJointPDFDerivatives", this->GetComponentLabel(), level, 0);
+  this->SetUseSparsePDFDerivatives(useSparseJointPDFDerivatives);
+
   /** Set whether to use Nick Tustison's preconditioning technique. */
   bool useJacobianPreconditioning = false;
   this->GetConfiguration()->ReadParameter(
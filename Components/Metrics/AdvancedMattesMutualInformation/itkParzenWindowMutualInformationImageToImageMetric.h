@@ -181,6 +181,7 @@ protected:
   typedef typename Superclass::ParzenValueContainerType            ParzenValueContainerType;
   typedef typename Superclass::KernelFunctionType                  KernelFunctionType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::SampleBlockType                     SampleBlockType;
 
   /**  Get the value and analytic derivative.
    * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == false.
@@ -208,6 +209,21 @@ protected:
                                          MeasureType &          value,
                                          DerivativeType &       derivative) const;
 
+  /** Get the value and analytic derivative.
+   * Called by GetValueAndAnalyticDerivative if UseExplicitPDFDerivatives == true
+   * and UseSparsePDFDerivatives == true.
+   *
+   * Implements a version that loops once over the samples, like the explicit
+   * variant, but stores the joint histogram derivative sparsely, per sample
+   * (and per thread when multi-threading). Its size scales with the number of
+   * samples times the Parzen window and B-spline support, instead of with
+   * #FixedHistogramBins * #MovingHistogramBins * #parameters.
+   */
+  virtual void
+  GetValueAndAnalyticDerivativeSparse(const ParametersType & parameters,
+                                      MeasureType &          value,
+                                      DerivativeType &       derivative) const;
+
   /**  Get the value and finite difference derivative.
    * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == true.
    *
@@ -27,6 +27,8 @@
 #include "vnl/vnl_inverse.h"
 #include "vnl/vnl_det.h"
 
+#include <algorithm> // std::min, std::copy_n
+
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
 #endif
@@ -61,7 +63,7 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Init
   this->Superclass::InitializeHistograms();
 
   /** Allocate small amount of memory for the m_PRatioArray. */
-  if (!this->GetUseExplicitPDFDerivatives())
+  if (!this->GetUseExplicitPDFDerivatives() || this->GetUseSparsePDFDerivatives())
   {
     this->m_PRatioArray.SetSize(this->GetNumberOfFixedHistogramBins(), this->GetNumberOfMovingHistogramBins());
   }
@@ -151,6 +153,13 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetV
     return;
   }
 
+  /** Sparse variant. */
+  if (this->GetUseSparsePDFDerivatives())
+  {
+    this->GetValueAndAnalyticDerivativeSparse(parameters, value, derivative);
+    return;
+  }
+
   /** Initialize some variables. */
   value = NumericTraits<MeasureType>::Zero;
   derivative = DerivativeType(this->GetNumberOfParameters());
@@ -275,6 +284,50 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetV
 } // end GetValueAndAnalyticDerivativeLowMemory()
 
 
+/**
+ * ******************** GetValueAndAnalyticDerivativeSparse *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndAnalyticDerivativeSparse(
+  const ParametersType & parameters,
+  MeasureType &          value,
+  DerivativeType &       derivative) const
+{
+  /** Initialize some variables. */
+  value = NumericTraits<MeasureType>::Zero;
+  derivative = DerivativeType(this->GetNumberOfParameters());
+
+  /** Construct the JointPDF, Alpha and the sparse JointPDFDerivatives.
+   * This function contains the only loop over the samples.
+   * It executes multi-threadedly when m_UseMultiThread == true.
+   */
+  this->ComputePDFsAndSparsePDFDerivatives(parameters);
+
+  /** Normalize the joint histogram by alpha. */
+  this->NormalizeJointPDF(this->m_JointPDF, this->m_Alpha);
+
+  /** Compute the fixed and moving marginal pdf by summing over the histogram. */
+  this->ComputeMarginalPDF(this->m_JointPDF, this->m_FixedImageMarginalPDF, 0);
+  this->ComputeMarginalPDF(this->m_JointPDF, this->m_MovingImageMarginalPDF, 1);
+
+  /** Compute the metric value and the intermediate m_PRatioArray
+   * by summation over the joint histogram.
+   */
+  double MI = 0.0;
+  this->ComputeValueAndPRatioArray(MI);
+  value = static_cast<MeasureType>(-1.0 * MI);
+
+  /** Compute the derivative by contracting the stored pdf derivatives with
+   * m_PRatioArray, see eq. 23 of Thevenaz & Unser paper [3].
+   * It executes multi-threadedly when m_UseMultiThread == true.
+   */
+  this->ComputeDerivativeFromSparsePDFDerivatives(this->m_PRatioArray, derivative);
+
+} // end GetValueAndAnalyticDerivativeSparse()
+
+
 /**
  * ******************** ComputeDerivativeLowMemorySingleThreaded *******************
  */
@@ -426,17 +479,20 @@ void
 ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComputeDerivativeLowMemory(
   ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices.
+   * The image Jacobian is a view on the memory of the sample block.
+   */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
   NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nzji.size());
+  DerivativeType               imageJacobian;
 
-  /** Get a handle to the pre-allocated derivative for the current thread.
+  /** Get a handle to the pre-allocated derivative and sample block for the current thread.
    * The initialization is performed at the beginning of each resolution in
    * InitializeThreadingParameters(), and at the end of each iteration in
    * AfterThreadedGetValueAndDerivative() and the accumulate functions.
    */
-  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+  DerivativeType &  derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+  SampleBlockType & block = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_SampleBlock;
 
   /** Declare and allocate arrays for Jacobian preconditioning. */
   DerivativeType jacobianPreconditioner, preconditioningDivisor;
@@ -460,86 +516,58 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
   pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
-  fbegin += (int)pos_begin;
-  fend += (int)pos_end;
-
-  /** Loop over sample container and compute contribution of each sample to pdfs. */
-  for (fiter = fbegin; fiter != fend; ++fiter)
+  /** Loop over the samples in blocks and compute the contribution of each sample to the derivative.
+   * For each block the transform is evaluated with a single (virtual) call.
+   */
+  for (unsigned long block_begin = pos_begin; block_begin < pos_end; block_begin += Self::SampleBlockSize)
   {
-    /** Read fixed coordinates and create some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImageDerivativeType   movingImageDerivative;
-    MovingImagePointType        mappedPoint;
+    const unsigned long block_end = std::min<unsigned long>(block_begin + Self::SampleBlockSize, pos_end);
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if the point is inside the moving mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint);
-    }
+    /** Transform the points, check the moving mask, and compute the moving image
+     * values and derivatives. Only the valid samples are kept.
+     */
+    this->EvaluateSampleBlock(*sampleContainer, block_begin, block_end, block);
 
-    /** Compute the moving image value, its derivative, and check
-     * if the point is inside the moving image buffer.
+    /** Make sure the values fall within the histogram range. The moving image limiter
+     * also modifies the moving image derivative, so this is done before the image Jacobians.
      */
-    if (sampleOk)
+    for (unsigned long i = 0; i < block.m_NumberOfValidSamples; ++i)
     {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+      block.m_FixedImageValues[i] = this->GetFixedImageLimiter()->Evaluate(block.m_FixedImageValues[i]);
+      block.m_MovingImageValues[i] =
+        this->GetMovingImageLimiter()->Evaluate(block.m_MovingImageValues[i], block.m_MovingImageDerivatives[i]);
     }
 
-    if (sampleOk)
-    {
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+    /** Compute the inner products of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+    this->EvaluateSampleBlockImageJacobians(block);
 
-      /** Make sure the values fall within the histogram range. */
-      fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
-      movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
-
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
+    for (unsigned long i = 0; i < block.m_NumberOfValidSamples; ++i)
+    {
+      imageJacobian.SetData(&block.m_ImageJacobians[i * nnzji], nnzji, false);
+      std::copy_n(&block.m_NonZeroJacobianIndices[i * nnzji], nnzji, nzji.begin());
 
       /** If desired, apply the technique introduced by Tustison. */
       TransformJacobianType jacobian;
       if (this->GetUseJacobianPreconditioning())
       {
-        this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
+        this->EvaluateTransformJacobian(block.m_FixedPoints[i], jacobian, nzji);
 
         this->ComputeJacobianPreconditioner(jacobian, nzji, jacobianPreconditioner, preconditioningDivisor);
         DerivativeValueType * imjacit = imageJacobian.begin();
         DerivativeValueType * jacprecit = jacobianPreconditioner.begin();
-        for (unsigned int i = 0; i < nzji.size(); ++i)
+        while (imjacit != imageJacobian.end())
         {
-          while (imjacit != imageJacobian.end())
-          {
-            (*imjacit) *= (*jacprecit);
-            ++imjacit;
-            ++jacprecit;
-          }
+          (*imjacit) *= (*jacprecit);
+          ++imjacit;
+          ++jacprecit;
         }
       }
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
-
-    } // end sampleOk
-  }   // end loop over sample container
+      this->UpdateDerivativeLowMemory(
+        block.m_FixedImageValues[i], block.m_MovingImageValues[i], imageJacobian, nzji, derivative);
+    }
+  } // end loop over sample container
 
   /** If desired, apply the technique introduced by Tustison. */
   if (this->GetUseJacobianPreconditioning())
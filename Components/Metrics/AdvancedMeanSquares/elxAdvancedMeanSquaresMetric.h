@@ -139,6 +139,13 @@ public:
   void
   BeforeEachResolution(void) override;
 
+  /** This metric can be copied for optimizers that evaluate it in parallel, see CreateWorkerMetrics(). */
+  bool
+  GetWorkerMetricsSupported(void) const override
+  {
+    return true;
+  }
+
 protected:
   /** The constructor. */
   AdvancedMeanSquaresMetric() = default;
@@ -206,6 +206,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::SampleBlockType                     SampleBlockType;
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<FixedImageType, FixedImageType>         SmootherType;
@@ -237,6 +238,10 @@ protected:
   inline void
   ThreadedGetValue(ThreadIdType threadID) override;
 
+  /** Get value for a range of samples, used by the thread pool. */
+  inline void
+  ThreadedGetValueRange(ThreadIdType threadID, unsigned long pos_begin, unsigned long pos_end) override;
+
   /** Gather the values from all threads. */
   inline void
   AfterThreadedGetValue(MeasureType & value) const override;
@@ -245,6 +250,10 @@ protected:
   inline void
   ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
 
+  /** Get value and derivatives for a range of samples, used by the thread pool. */
+  inline void
+  ThreadedGetValueAndDerivativeRange(ThreadIdType threadID, unsigned long pos_begin, unsigned long pos_end) override;
+
   /** Gather the values and derivatives from all threads. */
   inline void
   AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
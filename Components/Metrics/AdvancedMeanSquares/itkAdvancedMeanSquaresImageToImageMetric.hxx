@@ -20,9 +20,10 @@
 
 #include "itkAdvancedMeanSquaresImageToImageMetric.h"
 #include "vnl/algo/vnl_matrix_update.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkComputeImageExtremaFilter.h"
 
+#include <algorithm> // std::min, std::copy_n
+
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
 #endif
@@ -296,7 +297,14 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValue(
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
   /** Launch multi-threading metric */
-  this->LaunchGetValueThreaderCallback();
+  if (this->m_UseThreadPool)
+  {
+    this->LaunchGetValueThreadPool();
+  }
+  else
+  {
+    this->LaunchGetValueThreaderCallback();
+  }
 
   /** Gather the metric values from all threads. */
   MeasureType value = NumericTraits<MeasureType>::Zero;
@@ -328,6 +336,24 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
   pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
   pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
 
+  this->ThreadedGetValueRange(threadId, pos_begin, pos_end);
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ******************* ThreadedGetValueRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueRange(ThreadIdType  threadId,
+                                                                                       unsigned long pos_begin,
+                                                                                       unsigned long pos_end)
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator threader_fiter;
   typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
@@ -381,10 +407,10 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
   } // end for loop over the image sample container
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value += measure;
 
-} // end ThreadedGetValue()
+} // end ThreadedGetValueRange()
 
 
 /**
@@ -398,8 +424,8 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
   /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  this->m_NumberOfPixelsCounted = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
     this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
 
@@ -600,8 +626,15 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Launch multi-threading metric */
-  this->LaunchGetValueAndDerivativeThreaderCallback();
+  /** Launch multi-threading metric. The thread pool also sums the derivatives of the threads. */
+  if (this->m_UseThreadPool)
+  {
+    this->LaunchGetValueAndDerivativeThreadPool(derivative);
+  }
+  else
+  {
+    this->LaunchGetValueAndDerivativeThreaderCallback();
+  }
 
   /** Gather the metric values and derivatives from all threads. */
   this->AfterThreadedGetValueAndDerivative(value, derivative);
@@ -617,18 +650,6 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
-  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nnzji);
-
-  /** Get a handle to the pre-allocated derivative for the current thread.
-   * The initialization is performed at the beginning of each resolution in
-   * InitializeThreadingParameters(), and at the end of each iteration in
-   * AfterThreadedGetValueAndDerivative() and the accumulate functions.
-   */
-  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
-
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
@@ -642,76 +663,78 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
   pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
   pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
+  this->ThreadedGetValueAndDerivativeRange(threadId, pos_begin, pos_end);
 
-  threader_fbegin += (int)pos_begin;
-  threader_fend += (int)pos_end;
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivativeRange(
+  ThreadIdType  threadId,
+  unsigned long pos_begin,
+  unsigned long pos_end)
+{
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices.
+   * The image Jacobian is a view on the memory of the sample block.
+   */
+  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
+  DerivativeType               imageJacobian;
+
+  /** Get a handle to the pre-allocated derivative and sample block for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * AfterThreadedGetValueAndDerivative() and the accumulate functions.
+   */
+  DerivativeType &  derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+  SampleBlockType & block = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_SampleBlock;
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure = NumericTraits<MeasureType>::Zero;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  /** Loop over the fixed image samples in blocks to calculate the mean squares.
+   * For each block the transform is evaluated with a single (virtual) call.
+   */
+  for (unsigned long block_begin = pos_begin; block_begin < pos_end; block_begin += Self::SampleBlockSize)
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if point is inside mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint); // thread-safe?
-    }
+    const unsigned long block_end = std::min<unsigned long>(block_begin + Self::SampleBlockSize, pos_end);
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
+    /** Transform the points, check the moving mask, and compute the moving image
+     * values and derivatives. Only the valid samples are kept.
      */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
+    this->EvaluateSampleBlock(*sampleContainer, block_begin, block_end, block);
 
-    if (sampleOk)
+    /** Compute the inner products of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+    this->EvaluateSampleBlockImageJacobians(block);
+
+    for (unsigned long i = 0; i < block.m_NumberOfValidSamples; ++i)
     {
       numberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
-
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
+      imageJacobian.SetData(&block.m_ImageJacobians[i * nnzji], nnzji, false);
+      std::copy_n(&block.m_NonZeroJacobianIndices[i * nnzji], nnzji, nzji.begin());
 
       /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(fixedImageValue, movingImageValue, imageJacobian, nzji, measure, derivative);
-
-    } // end if sampleOk
+      this->UpdateValueAndDerivativeTerms(
+        block.m_FixedImageValues[i], block.m_MovingImageValues[i], imageJacobian, nzji, measure, derivative);
+    }
 
   } // end for loop over the image sample container
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value += measure;
 
-} // end ThreadedGetValueAndDerivative()
+} // end ThreadedGetValueAndDerivativeRange()
 
 
 /**
@@ -727,8 +750,8 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
   /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  this->m_NumberOfPixelsCounted = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
     this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
 
@@ -736,9 +759,23 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
     this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
   }
 
-  /** Check if enough samples were valid. */
+  /** Check if enough samples were valid. If not, the derivatives of the threads are
+   * not accumulated below, so reset them here for the next iteration.
+   */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-  this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+  try
+  {
+    this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+  }
+  catch (...)
+  {
+    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+    {
+      this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.Fill(
+        NumericTraits<DerivativeValueType>::ZeroValue());
+    }
+    throw;
+  }
 
   /** The normalization factor. */
   DerivativeValueType normal_sum =
@@ -756,8 +793,13 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
   value *= normal_sum;
 
   /** Accumulate derivatives. */
+  // already summed by the thread pool, only normalize
+  if (this->m_UseThreadPool)
+  {
+    derivative *= normal_sum;
+  }
   // compute single-threadedly
-  if (!this->m_UseMultiThread && false) // force multi-threaded
+  else if (!this->m_UseMultiThread && false) // force multi-threaded
   {
     derivative = this->m_GetValueAndDerivativePerThreadVariables[0].st_Derivative * normal_sum;
     for (ThreadIdType i = 1; i < numberOfThreads; i++)
@@ -853,11 +895,10 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetSelfHessian
   HessianType &                   H) const
 {
   itkDebugMacro("GetSelfHessian()");
-  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
 
   /** Initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
-  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  Statistics::MersenneTwisterRandomVariateGenerator * randomGenerator = this->m_RandomGenerator;
   randomGenerator->Initialize();
 
   /** Array that stores dM(x)/dmu, and the sparse jacobian+indices. */
@@ -137,6 +137,13 @@ public:
   void
   Initialize(void) override;
 
+  /** This metric can be copied for optimizers that evaluate it in parallel, see CreateWorkerMetrics(). */
+  bool
+  GetWorkerMetricsSupported(void) const override
+  {
+    return true;
+  }
+
 protected:
   /** The constructor. */
   AdvancedNormalizedCorrelationMetric() = default;
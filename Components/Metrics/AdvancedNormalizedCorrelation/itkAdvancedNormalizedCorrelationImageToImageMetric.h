@@ -201,6 +201,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::SampleBlockType                     SampleBlockType;
 
   /** Compute a pixel's contribution to the derivative terms;
    * Called by GetValueAndDerivative().
@@ -258,15 +259,16 @@ private:
 
   struct CorrelationGetValueAndDerivativePerThreadStruct
   {
-    SizeValueType  st_NumberOfPixelsCounted;
-    AccumulateType st_Sff;
-    AccumulateType st_Smm;
-    AccumulateType st_Sfm;
-    AccumulateType st_Sf;
-    AccumulateType st_Sm;
-    DerivativeType st_DerivativeF;
-    DerivativeType st_DerivativeM;
-    DerivativeType st_Differential;
+    SizeValueType   st_NumberOfPixelsCounted;
+    AccumulateType  st_Sff;
+    AccumulateType  st_Smm;
+    AccumulateType  st_Sfm;
+    AccumulateType  st_Sf;
+    AccumulateType  st_Sm;
+    DerivativeType  st_DerivativeF;
+    DerivativeType  st_DerivativeM;
+    DerivativeType  st_Differential;
+    SampleBlockType st_SampleBlock;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                CorrelationGetValueAndDerivativePerThreadStruct,
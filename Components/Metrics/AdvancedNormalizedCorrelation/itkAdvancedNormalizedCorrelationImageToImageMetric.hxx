@@ -20,6 +20,8 @@
 
 #include "itkAdvancedNormalizedCorrelationImageToImageMetric.h"
 
+#include <algorithm> // std::min, std::copy_n
+
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
 #endif
@@ -524,19 +526,22 @@ void
 AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(
   ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices.
+   * The image Jacobian is a view on the memory of the sample block.
+   */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
   NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nzji.size());
+  DerivativeType               imageJacobian;
 
-  /** Get handles to the pre-allocated derivatives for the current thread.
+  /** Get handles to the pre-allocated derivatives and sample block for the current thread.
    * The initialization is performed at the beginning of each resolution in
    * InitializeThreadingParameters(), and at the end of each iteration in
    * AfterThreadedGetValueAndDerivative() and the accumulate functions.
    */
-  DerivativeType & derivativeF = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_DerivativeF;
-  DerivativeType & derivativeM = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_DerivativeM;
-  DerivativeType & differential = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Differential;
+  DerivativeType &  derivativeF = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_DerivativeF;
+  DerivativeType &  derivativeM = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_DerivativeM;
+  DerivativeType &  differential = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Differential;
+  SampleBlockType & block = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_SampleBlock;
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
@@ -551,14 +556,6 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
   pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend += (int)pos_end;
-
   /** Create variables to store intermediate results. */
   AccumulateType sff = NumericTraits<AccumulateType>::Zero;
   AccumulateType smm = NumericTraits<AccumulateType>::Zero;
@@ -567,51 +564,29 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   AccumulateType sm = NumericTraits<AccumulateType>::Zero;
   unsigned long  numberOfPixelsCounted = 0;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  /** Loop over the fixed image samples in blocks to calculate the correlation.
+   * For each block the transform is evaluated with a single (virtual) call.
+   */
+  for (unsigned long block_begin = pos_begin; block_begin < pos_end; block_begin += Self::SampleBlockSize)
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if point is inside mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint);
-    }
+    const unsigned long block_end = std::min<unsigned long>(block_begin + Self::SampleBlockSize, pos_end);
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
+    /** Transform the points, check the moving mask, and compute the moving image
+     * values and derivatives. Only the valid samples are kept.
      */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
+    this->EvaluateSampleBlock(*sampleContainer, block_begin, block_end, block);
 
-    if (sampleOk)
+    /** Compute the inner products of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+    this->EvaluateSampleBlockImageJacobians(block);
+
+    for (unsigned long i = 0; i < block.m_NumberOfValidSamples; ++i)
     {
       numberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
-
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
+      const RealType fixedImageValue = block.m_FixedImageValues[i];
+      const RealType movingImageValue = block.m_MovingImageValues[i];
+      imageJacobian.SetData(&block.m_ImageJacobians[i * nnzji], nnzji, false);
+      std::copy_n(&block.m_NonZeroJacobianIndices[i * nnzji], nnzji, nzji.begin());
 
       /** Update some sums needed to calculate the value of NC. */
       sff += fixedImageValue * fixedImageValue;
@@ -623,8 +598,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
       /** Compute this voxel's contribution to the derivative terms. */
       this->UpdateDerivativeTerms(
         fixedImageValue, movingImageValue, imageJacobian, nzji, derivativeF, derivativeM, differential);
-
-    } // end if sampleOk
+    }
 
   } // end for loop over the image sample container
 
@@ -39,6 +39,14 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Metric: Select this metric as follows:\n
  *    <tt>(Metric "TransformBendingEnergyPenalty")</tt>
+ * \parameter UseAnalyticBendingEnergy: Compute the bending energy of a third order B-spline
+ *    transform exactly, from the B-spline coefficients, instead of from the image samples.
+ *    The cost then depends on the size of the B-spline grid instead of the number of samples,
+ *    and the derivative is free of sampling noise. Other transforms still use the samples, and
+ *    so does a B-spline that is composed with an initial transform with a non-orthonormal matrix.
+ *    Can be given for each resolution.\n
+ *    example: <tt>(UseAnalyticBendingEnergy "true" "true" "false")</tt>\n
+ *    The default is "false".
  *
  * \ingroup Metrics
  *
@@ -133,6 +141,7 @@ public:
   /**
    * Do some things before each resolution:
    * \li Set options for SelfHessian
+   * \li Set the UseAnalyticBendingEnergy option
    */
   void
   BeforeEachResolution(void) override;
@@ -59,6 +59,12 @@ TransformBendingEnergyPenalty<TElastix>::BeforeEachResolution(void)
     numberOfSamplesForSelfHessian, "NumberOfSamplesForSelfHessian", this->GetComponentLabel(), level, 0);
   this->SetNumberOfSamplesForSelfHessian(numberOfSamplesForSelfHessian);
 
+  /** Compute the bending energy of B-spline transforms from their coefficients? */
+  bool useAnalyticBendingEnergy = false;
+  this->GetConfiguration()->ReadParameter(
+    useAnalyticBendingEnergy, "UseAnalyticBendingEnergy", this->GetComponentLabel(), level, 0);
+  this->SetUseAnalyticBendingEnergy(useAnalyticBendingEnergy);
+
 } // end BeforeEachResolution()
 
 
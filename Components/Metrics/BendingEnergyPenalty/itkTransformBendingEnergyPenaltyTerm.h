@@ -21,6 +21,8 @@
 #include "itkTransformPenaltyTerm.h"
 #include "itkImageGridSampler.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -34,6 +36,23 @@ namespace itk
  * [1]. For rigid and affine transformation this energy is always
  * zero.
  *
+ * By default the bending energy is averaged over the samples of the image
+ * sampler. For a third order B-spline transform, such as the
+ * AdvancedBSplineDeformableTransform and the RecursiveBSplineTransform, it
+ * can also be computed exactly, with UseAnalyticBendingEnergy. The bending
+ * energy is then a quadratic form in the B-spline coefficients, integrated
+ * over the valid region of the B-spline grid and divided by its volume. The
+ * 1D integrals of the products of the B-spline basis functions, and of their
+ * first and second order derivatives, are precomputed once per grid, and the
+ * quadratic form is applied separably on the coefficient grid. The cost then
+ * depends on the size of the grid instead of the number of samples, and the
+ * derivative is free of sampling noise. The grid direction is assumed to be
+ * orthonormal, which leaves the Frobenius norm of the spatial Hessian
+ * unchanged. With an initial transform that has a nonzero spatial Hessian,
+ * or that is composed with the B-spline and has a spatial Jacobian that is
+ * not orthonormal, or with a B-spline of another order, the samples are used
+ * after all.
+ *
  *
  * [1]: D. Rueckert, L. I. Sonoda, C. Hayes, D. L. G. Hill,
  *      M. O. Leach, and D. J. Hawkes, "Nonrigid registration
@@ -158,6 +177,13 @@ public:
   itkSetMacro(NumberOfSamplesForSelfHessian, unsigned int);
   itkGetConstMacro(NumberOfSamplesForSelfHessian, unsigned int);
 
+  /** Compute the bending energy of a third order B-spline transform exactly,
+   * from its coefficients, instead of from the image samples. Default: false.
+   */
+  itkSetMacro(UseAnalyticBendingEnergy, bool);
+  itkGetConstMacro(UseAnalyticBendingEnergy, bool);
+  itkBooleanMacro(UseAnalyticBendingEnergy);
+
 protected:
   /** Typedefs for indices and points. */
   typedef typename Superclass::FixedImageIndexType            FixedImageIndexType;
@@ -184,7 +210,68 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** Typedef for the size of the B-spline grid. */
+  typedef Size<itkGetStaticConstMacro(FixedImageDimension)> GridSizeType;
+
+  /** Compute the value of the analytic bending energy, and, if derivative is not
+   * a null pointer, also its derivative. Returns false if the transform is not
+   * suited, in which case the samples should be used.
+   */
+  bool
+  GetValueAndDerivativeAnalytic(const ParametersType & parameters,
+                                MeasureType &          value,
+                                DerivativeType *       derivative) const;
+
+  /** Compute the banded Gram matrices of the basis functions of the B-spline grid,
+   * for the derivative orders 0, 1 and 2 along each dimension.
+   */
+  void
+  ComputeGramMatrices(const GridSizeType & gridSize) const;
+
+  /** Apply a Gram matrix along one dimension of the grid, for the lines of this thread. */
+  void
+  ThreadedApplyGramMatrix(ThreadIdType threadId, ThreadIdType numberOfThreads) const;
+
+  /** The threader callback of ThreadedApplyGramMatrix(). */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ApplyGramMatrixThreaderCallback(void * arg);
+
+  /** The number of nonzero elements in a row of a Gram matrix. */
+  itkStaticConstMacro(GramBandWidth, unsigned int, 7);
+
+  /** The variables that are shared by the threads of ThreadedApplyGramMatrix(). In the last
+   * pass, the coefficients are not a null pointer, and the output is multiplied by the weight
+   * and added to the value and the derivative.
+   */
+  struct GramThreaderParameterType
+  {
+    const Self *          st_Metric;
+    const RealType *      st_Input;
+    RealType *            st_Output;
+    const RealType *      st_Coefficients;
+    DerivativeValueType * st_Derivative;
+    RealType              st_Weight;
+    unsigned int          st_Dimension;
+    unsigned int          st_Order;
+  };
+  mutable GramThreaderParameterType m_GramThreaderParameters;
+
+  /** The values of the threads, which are added in the order of the threads. */
+  struct GramPerThreadStruct
+  {
+    RealType st_Value;
+  };
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT, GramPerThreadStruct, PaddedGramPerThreadStruct);
+  mutable std::vector<PaddedGramPerThreadStruct> m_GramPerThreadVariables;
+
+  /** The Gram matrices are only recomputed when the size of the grid changes. Row c of a
+   * matrix stores the elements ( c, c - 3 ) up to ( c, c + 3 ).
+   */
+  mutable GridSizeType          m_GramMatricesGridSize;
+  mutable std::vector<RealType> m_GramMatrices[FixedImageDimension][3];
+
   unsigned int m_NumberOfSamplesForSelfHessian;
+  bool         m_UseAnalyticBendingEnergy;
 };
 
 } // end namespace itk
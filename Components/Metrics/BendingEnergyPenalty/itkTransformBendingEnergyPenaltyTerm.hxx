@@ -19,6 +19,11 @@
 #define itkTransformBendingEnergyPenaltyTerm_hxx
 
 #include "itkTransformBendingEnergyPenaltyTerm.h"
+#include "itkBSplineKernelFunction2.h"
+#include "itkBSplineDerivativeKernelFunction2.h"
+#include "itkBSplineSecondOrderDerivativeKernelFunction2.h"
+
+#include <algorithm> // For min.
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -40,6 +45,8 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::TransformBendingEne
   this->SetUseImageSampler(true);
 
   this->m_NumberOfSamplesForSelfHessian = 100000;
+  this->m_UseAnalyticBendingEnergy = false;
+  this->m_GramMatricesGridSize.Fill(0);
 
 } // end Constructor
 
@@ -52,6 +59,13 @@ template <class TFixedImage, class TScalarType>
 typename TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::MeasureType
 TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValue(const ParametersType & parameters) const
 {
+  /** Compute the bending energy from the B-spline coefficients, if possible. */
+  MeasureType analyticValue = NumericTraits<MeasureType>::Zero;
+  if (this->m_UseAnalyticBendingEnergy && this->GetValueAndDerivativeAnalytic(parameters, analyticValue, nullptr))
+  {
+    return analyticValue;
+  }
+
   /** Initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
   RealType           measure = NumericTraits<RealType>::Zero;
@@ -354,6 +368,12 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivati
                                                                                    MeasureType &          value,
                                                                                    DerivativeType & derivative) const
 {
+  /** Compute the bending energy from the B-spline coefficients, if possible. */
+  if (this->m_UseAnalyticBendingEnergy && this->GetValueAndDerivativeAnalytic(parameters, value, &derivative))
+  {
+    return;
+  }
+
   /** Option for now to still use the single threaded code. */
   if (!this->m_UseMultiThread)
   {
@@ -815,6 +835,316 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetSelfHessian(cons
 } // end GetSelfHessian()
 
 
+/**
+ * ******************* GetValueAndDerivativeAnalytic *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+bool
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivativeAnalytic(
+  const ParametersType & parameters,
+  MeasureType &          value,
+  DerivativeType *       derivative) const
+{
+  /** Only third order B-splines are supported. */
+  BSplineOrder3TransformPointer bspline;
+  if (!this->CheckForBSplineTransform2(bspline) || bspline.IsNull())
+  {
+    return false;
+  }
+
+  /** An initial transform should not contribute to the spatial Hessian. When the B-spline
+   * is composed with it, its spatial Jacobian should moreover be orthonormal, so that the
+   * Frobenius norm of the spatial Hessian is unchanged. When they are added, any affine
+   * initial transform will do.
+   */
+  const CombinationTransformType * combination =
+    dynamic_cast<const CombinationTransformType *>(this->m_AdvancedTransform.GetPointer());
+  if (combination != nullptr && combination->GetInitialTransform() != nullptr)
+  {
+    const typename CombinationTransformType::InitialTransformType * initialTransform =
+      combination->GetInitialTransform();
+    if (initialTransform->GetHasNonZeroSpatialHessian())
+    {
+      return false;
+    }
+    if (!combination->GetUseAddition())
+    {
+      SpatialJacobianType sj;
+      initialTransform->GetSpatialJacobian(bspline->GetGridOrigin(), sj);
+      SpatialJacobianType deviation = SpatialJacobianType(sj.GetTranspose()) * sj;
+      for (unsigned int d = 0; d < FixedImageDimension; ++d)
+      {
+        deviation(d, d) -= 1.0;
+      }
+      if (deviation.GetVnlMatrix().frobenius_norm() > 1e-10)
+      {
+        return false;
+      }
+    }
+  }
+
+  /** The valid region of a grid with less than 4 points along a dimension is empty. */
+  const GridSizeType gridSize = bspline->GetGridRegion().GetSize();
+  SizeValueType      numberOfGridPoints = 1;
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    if (gridSize[d] < 4)
+    {
+      return false;
+    }
+    numberOfGridPoints *= gridSize[d];
+  }
+  const SizeValueType numberOfParameters = numberOfGridPoints * FixedImageDimension;
+  if (parameters.GetSize() != numberOfParameters)
+  {
+    return false;
+  }
+
+  /** Keep the transform up to date, as in BeforeThreadedGetValueAndDerivative(). */
+  if (this->m_UseMetricSingleThreaded)
+  {
+    this->SetTransformParameters(parameters);
+  }
+
+  if (gridSize != this->m_GramMatricesGridSize)
+  {
+    this->ComputeGramMatrices(gridSize);
+  }
+
+  /** The grid coordinates are the physical coordinates divided by the grid spacing, so
+   * that the second order derivative of a coefficient image along the dimensions i and j
+   * is scaled by 1 / ( h_i h_j ). The bending energy is the mean over the valid region,
+   * which consists of n - 3 unit intervals along each dimension.
+   */
+  const typename BSplineOrder3TransformType::SpacingType gridSpacing = bspline->GetGridSpacing();
+  RealType                                               volume = NumericTraits<RealType>::One;
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    volume *= static_cast<RealType>(gridSize[d] - 3);
+  }
+
+  if (derivative != nullptr)
+  {
+    derivative->SetSize(numberOfParameters);
+    derivative->Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+  }
+
+  const ThreadIdType numberOfThreads = this->m_UseMultiThread ? this->m_Threader->GetNumberOfWorkUnits() : 1;
+  this->m_GramPerThreadVariables.assign(numberOfThreads, PaddedGramPerThreadStruct());
+
+  std::vector<RealType>       buffers[2];
+  const std::vector<RealType> coefficients(parameters.begin(), parameters.end());
+  buffers[0].resize(numberOfParameters);
+  buffers[1].resize(numberOfParameters);
+
+  GramThreaderParameterType & threaderParameters = this->m_GramThreaderParameters;
+  threaderParameters.st_Metric = this;
+  threaderParameters.st_Derivative = derivative != nullptr ? derivative->data_block() : nullptr;
+
+  /** The squared Frobenius norm of the spatial Hessian of coefficient image k sums over the
+   * pairs of dimensions ( i, j ), with the mixed derivatives counted twice. The integral of
+   * each term is a Kronecker product of the Gram matrices of the derivative orders along
+   * the dimensions, which is applied to all coefficient images in one pass per dimension.
+   */
+  for (unsigned int i = 0; i < FixedImageDimension; ++i)
+  {
+    for (unsigned int j = i; j < FixedImageDimension; ++j)
+    {
+      const RealType weight = (i == j ? 1.0 : 2.0) / (vnl_math::sqr(gridSpacing[i] * gridSpacing[j]) * volume);
+
+      const RealType * input = coefficients.data();
+      for (unsigned int d = 0; d < FixedImageDimension; ++d)
+      {
+        const bool lastPass = d + 1 == FixedImageDimension;
+        threaderParameters.st_Input = input;
+        threaderParameters.st_Output = buffers[d % 2].data();
+        threaderParameters.st_Coefficients = lastPass ? coefficients.data() : nullptr;
+        threaderParameters.st_Weight = weight;
+        threaderParameters.st_Dimension = d;
+        threaderParameters.st_Order = (d == i ? 1 : 0) + (d == j ? 1 : 0);
+
+        if (this->m_UseMultiThread)
+        {
+          this->m_Threader->SetSingleMethod(this->ApplyGramMatrixThreaderCallback,
+                                            const_cast<void *>(static_cast<const void *>(&threaderParameters)));
+          this->m_Threader->SingleMethodExecute();
+        }
+        else
+        {
+          this->ThreadedApplyGramMatrix(0, 1);
+        }
+        input = threaderParameters.st_Output;
+      }
+    }
+  }
+
+  RealType measure = NumericTraits<RealType>::Zero;
+  for (const auto & threadVariables : this->m_GramPerThreadVariables)
+  {
+    measure += threadVariables.st_Value;
+  }
+  value = static_cast<MeasureType>(measure);
+
+  return true;
+
+} // end GetValueAndDerivativeAnalytic()
+
+
+/**
+ * ******************* ComputeGramMatrices *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::ComputeGramMatrices(const GridSizeType & gridSize) const
+{
+  /** The valid region of the grid consists of the unit intervals [ m, m + 1 ], for
+   * m = 1, ..., n - 3. On each interval, the basis functions m - 1 up to m + 2 are
+   * nonzero, and they are single cubic polynomials. A four point Gauss-Legendre rule
+   * therefore integrates the products of their derivatives exactly. These integrals
+   * are the same for all intervals.
+   */
+  typedef KernelFunctionBase2<double>::Pointer KernelPointer;
+  const KernelPointer kernels[3] = { BSplineKernelFunction2<3>::New().GetPointer(),
+                                     BSplineDerivativeKernelFunction2<3>::New().GetPointer(),
+                                     BSplineSecondOrderDerivativeKernelFunction2<3>::New().GetPointer() };
+  const double nodes[4] = { -0.861136311594052575, -0.339981043584856265, 0.339981043584856265, 0.861136311594052575 };
+  const double weights[4] = { 0.347854845137453857, 0.652145154862546143, 0.652145154862546143, 0.347854845137453857 };
+
+  RealType intervalIntegrals[3][4][4] = {};
+  for (unsigned int q = 0; q < 4; ++q)
+  {
+    const double s = 0.5 * (1.0 + nodes[q]);
+    for (unsigned int order = 0; order < 3; ++order)
+    {
+      RealType basis[4];
+      for (unsigned int a = 0; a < 4; ++a)
+      {
+        basis[a] = kernels[order]->Evaluate(s + 1.0 - a);
+      }
+      for (unsigned int a = 0; a < 4; ++a)
+      {
+        for (unsigned int b = 0; b < 4; ++b)
+        {
+          intervalIntegrals[order][a][b] += 0.5 * weights[q] * basis[a] * basis[b];
+        }
+      }
+    }
+  }
+
+  /** Add the integrals of all intervals of the valid region. */
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    for (unsigned int order = 0; order < 3; ++order)
+    {
+      std::vector<RealType> & gram = this->m_GramMatrices[d][order];
+      gram.assign(gridSize[d] * GramBandWidth, NumericTraits<RealType>::Zero);
+      for (SizeValueType m = 1; m + 2 < gridSize[d]; ++m)
+      {
+        for (unsigned int a = 0; a < 4; ++a)
+        {
+          for (unsigned int b = 0; b < 4; ++b)
+          {
+            gram[(m - 1 + a) * GramBandWidth + 3 + b - a] += intervalIntegrals[order][a][b];
+          }
+        }
+      }
+    }
+  }
+
+  this->m_GramMatricesGridSize = gridSize;
+
+} // end ComputeGramMatrices()
+
+
+/**
+ * ******************* ThreadedApplyGramMatrix *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::ThreadedApplyGramMatrix(ThreadIdType threadId,
+                                                                                     ThreadIdType numberOfThreads) const
+{
+  const GramThreaderParameterType & parameters = this->m_GramThreaderParameters;
+  const GridSizeType &              gridSize = this->m_GramMatricesGridSize;
+  const unsigned int                dimension = parameters.st_Dimension;
+  const RealType *                  gram = this->m_GramMatrices[dimension][parameters.st_Order].data();
+
+  /** The grid lines along the dimension, of all coefficient images, are divided over the threads. */
+  SizeValueType stride = 1;
+  SizeValueType numberOfGridPoints = 1;
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    stride *= d < dimension ? gridSize[d] : 1;
+    numberOfGridPoints *= gridSize[d];
+  }
+  const SizeValueType n = gridSize[dimension];
+  const SizeValueType numberOfLines = numberOfGridPoints / n * FixedImageDimension;
+  const SizeValueType linesPerThread = (numberOfLines + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType lineBegin = std::min(numberOfLines, threadId * linesPerThread);
+  const SizeValueType lineEnd = std::min(numberOfLines, lineBegin + linesPerThread);
+
+  const OffsetValueType signedStride = static_cast<OffsetValueType>(stride);
+  RealType              value = NumericTraits<RealType>::Zero;
+  for (SizeValueType line = lineBegin; line < lineEnd; ++line)
+  {
+    const SizeValueType first = (line / stride) * stride * n + line % stride;
+    for (SizeValueType c = 0; c < n; ++c)
+    {
+      /** Skip the elements of the band that are outside the grid. */
+      const RealType *    row = gram + c * GramBandWidth;
+      const unsigned int  bandBegin = c < 3 ? static_cast<unsigned int>(3 - c) : 0;
+      const unsigned int  bandEnd = c + 4 <= n ? GramBandWidth : static_cast<unsigned int>(n + 3 - c);
+      const SizeValueType index = first + c * stride;
+      const RealType *    center = parameters.st_Input + index;
+
+      RealType sum = NumericTraits<RealType>::Zero;
+      for (unsigned int o = bandBegin; o < bandEnd; ++o)
+      {
+        sum += row[o] * center[(static_cast<OffsetValueType>(o) - 3) * signedStride];
+      }
+      parameters.st_Output[index] = sum;
+
+      if (parameters.st_Coefficients != nullptr)
+      {
+        value += parameters.st_Weight * parameters.st_Coefficients[index] * sum;
+        if (parameters.st_Derivative != nullptr)
+        {
+          parameters.st_Derivative[index] += 2.0 * parameters.st_Weight * sum;
+        }
+      }
+    }
+  }
+
+  this->m_GramPerThreadVariables[threadId].st_Value += value;
+
+} // end ThreadedApplyGramMatrix()
+
+
+/**
+ * *********************** ApplyGramMatrixThreaderCallback ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::ApplyGramMatrixThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  GramThreaderParameterType * temp = static_cast<GramThreaderParameterType *>(infoStruct->UserData);
+
+  temp->st_Metric->ThreadedApplyGramMatrix(threadID, nrOfThreads);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ApplyGramMatrixThreaderCallback()
+
+
+
 } // end namespace itk
 
 #endif // #ifndef itkTransformBendingEnergyPenaltyTerm_hxx
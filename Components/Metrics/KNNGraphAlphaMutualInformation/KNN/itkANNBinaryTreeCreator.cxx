@@ -22,6 +22,7 @@ namespace itk
 {
 
 unsigned int ANNBinaryTreeCreator::m_NumberOfANNBinaryTrees = 0;
+std::mutex   ANNBinaryTreeCreator::m_ReferenceCountMutex;
 
 /**
  * ************************ CreateANNkDTree *************************
@@ -103,6 +104,7 @@ ANNBinaryTreeCreator::DeleteANNBruteForceTree(ANNBruteForceTreeType *& tree)
 void
 ANNBinaryTreeCreator::IncreaseReferenceCount(void)
 {
+  std::lock_guard<std::mutex> lock(m_ReferenceCountMutex);
   m_NumberOfANNBinaryTrees++;
 } // end IncreaseReferenceCount
 
@@ -114,6 +116,8 @@ ANNBinaryTreeCreator::IncreaseReferenceCount(void)
 void
 ANNBinaryTreeCreator::DecreaseReferenceCount(void)
 {
+  /** Hold the lock while calling annClose(), so that no tree is created in between. */
+  std::lock_guard<std::mutex> lock(m_ReferenceCountMutex);
   m_NumberOfANNBinaryTrees--;
   if (m_NumberOfANNBinaryTrees == 0)
   {
@@ -127,6 +127,8 @@ public:
   typedef typename Superclass::FixedImageLimiterOutputType  FixedImageLimiterOutputType;
   typedef typename Superclass::MovingImageLimiterOutputType MovingImageLimiterOutputType;
   typedef typename Superclass::NonZeroJacobianIndicesType   NonZeroJacobianIndicesType;
+  typedef typename Superclass::ThreaderType                 ThreaderType;
+  typedef typename Superclass::ThreadInfoType               ThreadInfoType;
 
   /** Typedef's for storing multiple inputs. */
   typedef typename Superclass::FixedImageVectorType             FixedImageVectorType;
@@ -263,6 +265,14 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Compute the contribution to the value of the query points of this thread. */
+  void
+  ThreadedGetValue(ThreadIdType threadID) override;
+
+  /** Compute the contribution to the value and derivative of the query points of this thread. */
+  void
+  ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
+
   /** Member variables. */
   BinaryKNNTreePointer m_BinaryKNNTreeFixed;
   BinaryKNNTreePointer m_BinaryKNNTreeMoving;
@@ -291,6 +301,47 @@ private:
   typedef Array2D<double>                         SpatialDerivativeType;
   typedef std::vector<SpatialDerivativeType>      SpatialDerivativeContainerType;
 
+  /** Typedef's for multi-threading. */
+  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
+  typedef typename Superclass::MultiThreaderParameterType     MultiThreaderParameterType;
+
+  /** The list samples and the derivative information of the current iteration,
+   * shared with the threads that search the nearest neighbours.
+   */
+  struct KNNGraphThreaderParameterType
+  {
+    const ListSampleType *                        st_ListSampleFixed;
+    const ListSampleType *                        st_ListSampleMoving;
+    const ListSampleType *                        st_ListSampleJoint;
+    const TransformJacobianContainerType *        st_JacobianContainer;
+    const TransformJacobianIndicesContainerType * st_JacobianIndicesContainer;
+    const SpatialDerivativeContainerType *        st_SpatialDerivativesContainer;
+  };
+  mutable KNNGraphThreaderParameterType m_KNNGraphThreaderParameters{};
+
+  /** Generate the fixed, moving and joint trees from the list samples, and
+   * connect them to the searchers. With multi-threading the trees are built
+   * simultaneously.
+   */
+  void
+  GenerateTreesAndSearchers(const ListSamplePointer & listSampleFixed,
+                            const ListSamplePointer & listSampleMoving,
+                            const ListSamplePointer & listSampleJoint) const;
+
+  /** GenerateTrees threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  GenerateTreesThreaderCallback(void * arg);
+
+  /** Compute sum_i G_i^(2 gamma) for the query points [pos_begin, pos_end). */
+  AccumulateType
+  ComputeGraphValue(unsigned long pos_begin, unsigned long pos_end) const;
+
+  /** Compute sum_i G_i^(2 gamma) for the query points [pos_begin, pos_end),
+   * and add the unnormalized derivative contributions to contribution.
+   */
+  AccumulateType
+  ComputeGraphValueAndDerivative(unsigned long pos_begin, unsigned long pos_end, DerivativeType & contribution) const;
+
   /** This function takes the fixed image samples from the ImageSampler
    * and puts them in the listSampleFixed, together with the fixed feature
    * image samples. Also the corresponding moving image values and moving
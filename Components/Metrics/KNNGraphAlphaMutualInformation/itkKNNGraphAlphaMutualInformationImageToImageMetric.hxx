@@ -325,22 +325,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  this->GenerateTreesAndSearchers(listSampleFixed, listSampleMoving, listSampleJoint);
 
   /**
    * *************** Estimate the \alpha MI ******************
@@ -375,77 +360,32 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
-  /** Temporary variables. */
-  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
+  /** Share the list samples with the threads. */
+  this->m_KNNGraphThreaderParameters.st_ListSampleFixed = listSampleFixed.GetPointer();
+  this->m_KNNGraphThreaderParameters.st_ListSampleMoving = listSampleMoving.GetPointer();
+  this->m_KNNGraphThreaderParameters.st_ListSampleJoint = listSampleJoint.GetPointer();
 
-  MeasureType    H, G;
+  /** Loop over all query points, i.e. all samples, and sum the contributions. */
   AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
-
-  /** Get the size of the feature vectors. */
-  unsigned int fixedSize = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize = fixedSize + movingSize;
-
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * (1.0 - this->m_Alpha);
-
-  /** Loop over all query points, i.e. all samples. */
-  for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++)
+  if (!this->m_UseMultiThread)
   {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
-    listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
-
-    /** Add the distances between the points to get the total graph length.
-     * The outcommented implementation calculates: sum J/sqrt(F*M)
-     *
-    for ( unsigned int j = 0; j < K; j++ )
-    {
-    enumerator = std::sqrt( distsJ[ j ] );
-    denominator = std::sqrt( std::sqrt( distsF[ j ] ) * std::sqrt( distsM[ j ] ) );
-    if ( denominator > 1e-14 )
-    {
-    contribution += std::pow( enumerator / denominator, twoGamma );
-    }
-    }*/
-
-    /** Add the distances of all neighbours of the query point,
-     * for the three graphs:
-     * sum M / sqrt( sum F * sum M)
-     */
-
-    /** Variables to compute the measure. */
-    AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_M = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_J = NumericTraits<AccumulateType>::Zero;
+    sumG = this->ComputeGraphValue(0, this->m_NumberOfPixelsCounted);
+  }
+  else
+  {
+    /** Launch multi-threading metric. */
+    this->LaunchGetValueThreaderCallback();
 
-    /** Loop over the neighbours. */
-    for (unsigned int p = 0; p < k; p++)
+    /** Gather the contributions of all threads. */
+    const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
     {
-      Gamma_F += std::sqrt(distances_F[p]);
-      Gamma_M += std::sqrt(distances_M[p]);
-      Gamma_J += std::sqrt(distances_J[p]);
-    } // end loop over the k neighbours
+      sumG += this->m_GetValuePerThreadVariables[i].st_Value;
 
-    /** Calculate the contribution of this query point. */
-    H = std::sqrt(Gamma_F * Gamma_M);
-    if (H > this->m_AvoidDivisionBy)
-    {
-      /** Compute some sums. */
-      G = Gamma_J / H;
-      sumG += std::pow(G, twoGamma);
+      /** Reset this variable for the next iteration. */
+      this->m_GetValuePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
     }
-  } // end looping over all query points
+  }
 
   /**
    * *************** Finally, calculate the metric value \alpha MI ******************
@@ -549,22 +489,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  this->GenerateTreesAndSearchers(listSampleFixed, listSampleMoving, listSampleJoint);
 
   /**
    * *************** Estimate the \alpha MI and its derivatives ******************
@@ -599,32 +524,263 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
+  /** Get the size of the feature vectors. */
+  const unsigned int jointSize = this->GetNumberOfFixedImages() + this->GetNumberOfMovingImages();
+
+  /** Share the list samples and the derivative information with the threads. */
+  this->m_KNNGraphThreaderParameters.st_ListSampleFixed = listSampleFixed.GetPointer();
+  this->m_KNNGraphThreaderParameters.st_ListSampleMoving = listSampleMoving.GetPointer();
+  this->m_KNNGraphThreaderParameters.st_ListSampleJoint = listSampleJoint.GetPointer();
+  this->m_KNNGraphThreaderParameters.st_JacobianContainer = &jacobianContainer;
+  this->m_KNNGraphThreaderParameters.st_JacobianIndicesContainer = &jacobianIndicesContainer;
+  this->m_KNNGraphThreaderParameters.st_SpatialDerivativesContainer = &spatialDerivativesContainer;
+
+  /** Loop over all query points, i.e. all samples, and sum the contributions. */
+  AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
+  DerivativeType contribution;
+  if (!this->m_UseMultiThread)
+  {
+    contribution.SetSize(this->GetNumberOfParameters());
+    contribution.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    sumG = this->ComputeGraphValueAndDerivative(0, this->m_NumberOfPixelsCounted, contribution);
+  }
+  else
+  {
+    /** Launch multi-threading metric. */
+    this->LaunchGetValueAndDerivativeThreaderCallback();
+
+    /** Gather the values of all threads. The derivatives are gathered below. */
+    const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+    {
+      sumG += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+
+      /** Reset this variable for the next iteration. */
+      this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+    }
+  }
+
+  /**
+   * *************** Finally, calculate the metric value and derivative ******************
+   */
+
+  /** Compute the value. */
+  double n, number;
+  if (sumG > this->m_AvoidDivisionBy)
+  {
+    /** Compute the measure. */
+    n = static_cast<double>(this->m_NumberOfPixelsCounted);
+    number = std::pow(n, this->m_Alpha);
+    measure = std::log(sumG / number) / (this->m_Alpha - 1.0);
+  }
+  value = -measure;
+
+  /** Compute the derivative (-2.0 * d = -jointSize). */
+  if (!this->m_UseMultiThread)
+  {
+    if (sumG > this->m_AvoidDivisionBy)
+    {
+      derivative = (static_cast<AccumulateType>(jointSize) / sumG) * contribution;
+    }
+  }
+  else
+  {
+    /** Accumulate the contributions of all threads multi-threadedly. This also
+     * resets them for the next iteration, so it is needed even if sumG is too small.
+     */
+    const bool validSumG = sumG > this->m_AvoidDivisionBy;
+    this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+    this->m_ThreaderMetricParameters.st_NormalizationFactor =
+      validSumG ? sumG / static_cast<AccumulateType>(jointSize) : 1.0;
+
+    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
+                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+    this->m_Threader->SingleMethodExecute();
+
+    if (!validSumG)
+    {
+      derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    }
+  }
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ************************ ThreadedGetValue *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValue(ThreadIdType threadId)
+{
+  /** Get the query points for this thread. */
+  const unsigned long numberOfQueryPoints = this->m_NumberOfPixelsCounted;
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(numberOfQueryPoints) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > numberOfQueryPoints) ? numberOfQueryPoints : pos_begin;
+  pos_end = (pos_end > numberOfQueryPoints) ? numberOfQueryPoints : pos_end;
+
+  /** Only update this variable at the end to prevent unnecessary "false sharing". */
+  this->m_GetValuePerThreadVariables[threadId].st_Value = this->ComputeGraphValue(pos_begin, pos_end);
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ************************ ThreadedGetValueAndDerivative *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(
+  ThreadIdType threadId)
+{
+  /** Get the query points for this thread. */
+  const unsigned long numberOfQueryPoints = this->m_NumberOfPixelsCounted;
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(numberOfQueryPoints) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > numberOfQueryPoints) ? numberOfQueryPoints : pos_begin;
+  pos_end = (pos_end > numberOfQueryPoints) ? numberOfQueryPoints : pos_end;
+
+  /** The derivative of this thread is reset after each iteration in AccumulateDerivativesThreaderCallback(). */
+  DerivativeType & contribution = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+
+  /** Only update this variable at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value =
+    this->ComputeGraphValueAndDerivative(pos_begin, pos_end, contribution);
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ************************ ComputeGraphValue *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ComputeGraphValue(
+  unsigned long pos_begin,
+  unsigned long pos_end) const -> AccumulateType
+{
+  /** Get the list samples of this iteration. */
+  const ListSampleType * listSampleFixed = this->m_KNNGraphThreaderParameters.st_ListSampleFixed;
+  const ListSampleType * listSampleMoving = this->m_KNNGraphThreaderParameters.st_ListSampleMoving;
+  const ListSampleType * listSampleJoint = this->m_KNNGraphThreaderParameters.st_ListSampleJoint;
+
+  /** Temporary variables. */
+  MeasurementVectorType z_F, z_M, z_J;
+  IndexArrayType        indices_F, indices_M, indices_J;
+  DistanceArrayType     distances_F, distances_M, distances_J;
+
+  MeasureType    H, G;
+  AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
+
+  /** Get the size of the feature vectors. */
+  const unsigned int fixedSize = this->GetNumberOfFixedImages();
+  const unsigned int movingSize = this->GetNumberOfMovingImages();
+  const unsigned int jointSize = fixedSize + movingSize;
+
+  /** Get the number of neighbours and \gamma. */
+  const unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
+  const double       twoGamma = jointSize * (1.0 - this->m_Alpha);
+
+  /** Loop over the query points. */
+  for (unsigned long i = pos_begin; i < pos_end; ++i)
+  {
+    /** Get the i-th query point. */
+    listSampleFixed->GetMeasurementVector(i, z_F);
+    listSampleMoving->GetMeasurementVector(i, z_M);
+    listSampleJoint->GetMeasurementVector(i, z_J);
+
+    /** Search for the K nearest neighbours of the current query point. */
+    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
+    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
+    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
+
+    /** Add the distances of all neighbours of the query point,
+     * for the three graphs:
+     * sum M / sqrt( sum F * sum M)
+     */
+
+    /** Variables to compute the measure. */
+    AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
+    AccumulateType Gamma_M = NumericTraits<AccumulateType>::Zero;
+    AccumulateType Gamma_J = NumericTraits<AccumulateType>::Zero;
+
+    /** Loop over the neighbours. */
+    for (unsigned int p = 0; p < k; p++)
+    {
+      Gamma_F += std::sqrt(distances_F[p]);
+      Gamma_M += std::sqrt(distances_M[p]);
+      Gamma_J += std::sqrt(distances_J[p]);
+    } // end loop over the k neighbours
+
+    /** Calculate the contribution of this query point. */
+    H = std::sqrt(Gamma_F * Gamma_M);
+    if (H > this->m_AvoidDivisionBy)
+    {
+      /** Compute some sums. */
+      G = Gamma_J / H;
+      sumG += std::pow(G, twoGamma);
+    }
+  } // end looping over the query points
+
+  return sumG;
+
+} // end ComputeGraphValue()
+
+
+/**
+ * ************************ ComputeGraphValueAndDerivative *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ComputeGraphValueAndDerivative(
+  unsigned long    pos_begin,
+  unsigned long    pos_end,
+  DerivativeType & contribution) const -> AccumulateType
+{
+  /** Get the list samples and derivative information of this iteration. */
+  const ListSampleType * listSampleFixed = this->m_KNNGraphThreaderParameters.st_ListSampleFixed;
+  const ListSampleType * listSampleMoving = this->m_KNNGraphThreaderParameters.st_ListSampleMoving;
+  const ListSampleType * listSampleJoint = this->m_KNNGraphThreaderParameters.st_ListSampleJoint;
+  const TransformJacobianContainerType & jacobianContainer = *this->m_KNNGraphThreaderParameters.st_JacobianContainer;
+  const TransformJacobianIndicesContainerType & jacobianIndicesContainer =
+    *this->m_KNNGraphThreaderParameters.st_JacobianIndicesContainer;
+  const SpatialDerivativeContainerType & spatialDerivativesContainer =
+    *this->m_KNNGraphThreaderParameters.st_SpatialDerivativesContainer;
+
   /** Temporary variables. */
-  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
-  MeasureType                                                 distance_F, distance_M, distance_J;
+  MeasurementVectorType z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
+  IndexArrayType        indices_F, indices_M, indices_J;
+  DistanceArrayType     distances_F, distances_M, distances_J;
+  MeasureType           distance_F, distance_M, distance_J;
 
   MeasureType    H, G, Gpow;
   AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
 
-  DerivativeType contribution(this->GetNumberOfParameters());
-  contribution.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
   DerivativeType dGamma_M(this->GetNumberOfParameters());
   DerivativeType dGamma_J(this->GetNumberOfParameters());
 
   /** Get the size of the feature vectors. */
-  unsigned int fixedSize = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize = fixedSize + movingSize;
+  const unsigned int fixedSize = this->GetNumberOfFixedImages();
+  const unsigned int movingSize = this->GetNumberOfMovingImages();
+  const unsigned int jointSize = fixedSize + movingSize;
 
   /** Get the number of neighbours and \gamma. */
-  unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * (1.0 - this->m_Alpha);
+  const unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
+  const double       twoGamma = jointSize * (1.0 - this->m_Alpha);
 
-  /** Loop over all query points, i.e. all samples. */
-  for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++)
+  /** Loop over the query points. */
+  for (unsigned long i = pos_begin; i < pos_end; ++i)
   {
     /** Get the i-th query point. */
     listSampleFixed->GetMeasurementVector(i, z_F);
@@ -701,27 +857,78 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
       contribution += (Gpow / H) * (dGamma_J - (0.5 * Gamma_J / Gamma_M) * dGamma_M);
     }
 
-  } // end looping over all query points
+  } // end looping over the query points
 
-  /**
-   * *************** Finally, calculate the metric value and derivative ******************
-   */
+  return sumG;
 
-  /** Compute the value. */
-  double n, number;
-  if (sumG > this->m_AvoidDivisionBy)
+} // end ComputeGraphValueAndDerivative()
+
+
+/**
+ * ************************ GenerateTreesAndSearchers *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GenerateTreesAndSearchers(
+  const ListSamplePointer & listSampleFixed,
+  const ListSamplePointer & listSampleMoving,
+  const ListSamplePointer & listSampleJoint) const
+{
+  /** Set the samples of the trees. */
+  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
+  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
+  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
+
+  /** Generate the three trees, which are independent, so can be built simultaneously. */
+  if (!this->m_UseMultiThread)
   {
-    /** Compute the measure. */
-    n = static_cast<double>(this->m_NumberOfPixelsCounted);
-    number = std::pow(n, this->m_Alpha);
-    measure = std::log(sumG / number) / (this->m_Alpha - 1.0);
+    this->m_BinaryKNNTreeFixed->GenerateTree();
+    this->m_BinaryKNNTreeMoving->GenerateTree();
+    this->m_BinaryKNNTreeJoint->GenerateTree();
+  }
+  else
+  {
+    this->m_Threader->SetSingleMethod(this->GenerateTreesThreaderCallback,
+                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+    this->m_Threader->SingleMethodExecute();
+  }
+
+  /** Initialize tree searchers. */
+  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
+  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
+  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
 
-    /** Compute the derivative (-2.0 * d = -jointSize). */
-    derivative = (static_cast<AccumulateType>(jointSize) / sumG) * contribution;
+} // end GenerateTreesAndSearchers()
+
+
+/**
+ * ************************ GenerateTreesThreaderCallback *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GenerateTreesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+  Self *                       metric = static_cast<Self *>(temp->st_Metric);
+
+  /** Thread i generates the trees i, i + nrOfThreads, ... of the fixed, moving and joint tree. */
+  BinaryKNNTreeType * trees[3] = { metric->m_BinaryKNNTreeFixed.GetPointer(),
+                                   metric->m_BinaryKNNTreeMoving.GetPointer(),
+                                   metric->m_BinaryKNNTreeJoint.GetPointer() };
+  for (unsigned int i = threadID; i < 3; i += nrOfThreads)
+  {
+    trees[i]->GenerateTree();
   }
-  value = -measure;
 
-} // end GetValueAndDerivative()
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end GenerateTreesThreaderCallback()
 
 
 /**
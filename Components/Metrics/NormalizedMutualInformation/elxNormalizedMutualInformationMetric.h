@@ -64,6 +64,18 @@ namespace elastix
  *    useful if you use high order B-spline interpolator for the moving image.\n
  *    example: <tt>(MovingLimitRangeRatio 0.001 0.01 0.01)</tt> \n
  *    The default value is 0.01. Can be given for each resolution, or for all resolutions at once.
+ * \parameter UseFastAndLowMemoryVersion: Switch between a version of
+ *    normalized mutual information that explicitely computes the derivatives of the
+ *    joint histogram to each transformation parameter (false) and a
+ *    version that computes the derivative via another route (true).
+ *    The first option allocates a large 3D matrix of size:
+ *    NumberOfFixedHistogramBins * NumberOfMovingHistogramBins * number
+ *    of transformation parameters, and runs single-threaded. The second
+ *    option loops twice over the samples, but needs hardly any memory and
+ *    is multi-threaded when UseMultiThreadingForMetrics is true.\n
+ *    The two versions give the same derivative up to floating-point rounding.\n
+ *    example: <tt>(UseFastAndLowMemoryVersion "true")</tt> \n
+ *    The default is "false", which keeps the results of existing configurations.
  *
  * \sa ParzenWindowNormalizedMutualInformationImageToImageMetric
  * \ingroup Metrics
@@ -167,6 +179,13 @@ public:
   void
   Initialize(void) override;
 
+  /** This metric can be copied for optimizers that evaluate it in parallel, see CreateWorkerMetrics(). */
+  bool
+  GetWorkerMetricsSupported(void) const override
+  {
+    return true;
+  }
+
 protected:
   /** The constructor. */
   NormalizedMutualInformationMetric() { this->SetUseDerivative(true); }
@@ -20,6 +20,7 @@
 #define itkParzenWindowNormalizedMutualInformationImageToImageMetric_h
 
 #include "itkParzenWindowHistogramImageToImageMetric.h"
+#include "itkArray2D.h"
 
 namespace itk
 {
@@ -50,7 +51,10 @@ namespace itk
  * Notes:\n
  * 1. This class returns the negative normalized mutual information value.\n
  * 2. This class in not thread safe due the private data structures
- *     used to the store the marginal and joint pdfs.
+ *     used to the store the marginal and joint pdfs.\n
+ * 3. When UseExplicitPDFDerivatives is false, the derivative is computed
+ *     without storing the joint histogram derivative, by looping twice over
+ *     the samples. Both loops are multi-threaded when UseMultiThread is true.
  *
  * References:\n
  * [1] "Nonrigid multimodality image registration"\n
@@ -99,6 +103,7 @@ public:
   typedef typename Superclass::OutputPointType                 OutputPointType;
   typedef typename Superclass::TransformParametersType         TransformParametersType;
   typedef typename Superclass::TransformJacobianType           TransformJacobianType;
+  typedef typename Superclass::NumberOfParametersType          NumberOfParametersType;
   typedef typename Superclass::InterpolatorType                InterpolatorType;
   typedef typename Superclass::InterpolatorPointer             InterpolatorPointer;
   typedef typename Superclass::RealType                        RealType;
@@ -113,6 +118,7 @@ public:
   typedef typename Superclass::MovingImageMaskPointer          MovingImageMaskPointer;
   typedef typename Superclass::MeasureType                     MeasureType;
   typedef typename Superclass::DerivativeType                  DerivativeType;
+  typedef typename Superclass::DerivativeValueType             DerivativeValueType;
   typedef typename Superclass::ParametersType                  ParametersType;
   typedef typename Superclass::FixedImagePixelType             FixedImagePixelType;
   typedef typename Superclass::MovingImageRegionType           MovingImageRegionType;
@@ -125,6 +131,8 @@ public:
   typedef typename Superclass::FixedImageLimiterOutputType     FixedImageLimiterOutputType;
   typedef typename Superclass::MovingImageLimiterOutputType    MovingImageLimiterOutputType;
   typedef typename Superclass::MovingImageDerivativeScalesType MovingImageDerivativeScalesType;
+  typedef typename Superclass::ThreaderType                    ThreaderType;
+  typedef typename Superclass::ThreadInfoType                  ThreadInfoType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -144,7 +152,7 @@ public:
 
 protected:
   /** The constructor. */
-  ParzenWindowNormalizedMutualInformationImageToImageMetric() = default;
+  ParzenWindowNormalizedMutualInformationImageToImageMetric();
 
   /** The destructor. */
   ~ParzenWindowNormalizedMutualInformationImageToImageMetric() override = default;
@@ -194,12 +202,79 @@ protected:
   virtual MeasureType
   ComputeNormalizedMutualInformation(MeasureType & jointEntropy) const;
 
+  /** Some initialization functions, called by Initialize. */
+  void
+  InitializeHistograms(void) override;
+
+  /** Get the value and analytic derivative.
+   * Called by GetValueAndDerivative if UseExplicitPDFDerivatives == false.
+   *
+   * Implements a version that avoids the large memory allocation of the
+   * explicit joint histogram derivative. This comes at the cost of looping
+   * over the samples twice, instead of once. Both loops are multi-threaded
+   * when m_UseMultiThread == true.
+   */
+  virtual void
+  GetValueAndAnalyticDerivativeLowMemory(const ParametersType & parameters,
+                                         MeasureType &          value,
+                                         DerivativeType &       derivative) const;
+
+  /** Threading related parameters. */
+  struct ParzenWindowNormalizedMutualInformationMultiThreaderParameterType
+  {
+    Self * m_Metric;
+  };
+  ParzenWindowNormalizedMutualInformationMultiThreaderParameterType
+    m_ParzenWindowNormalizedMutualInformationThreaderParameters;
+
+  /** Multi-threaded version of the derivative computation. */
+  inline void
+  ThreadedComputeDerivativeLowMemory(ThreadIdType threadId);
+
+  /** Accumulate the per-thread derivatives into a single one. */
+  inline void
+  AfterThreadedComputeDerivativeLowMemory(DerivativeType & derivative) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeLowMemoryThreaderCallback(void * arg);
+
+  /** Helper function to launch the threads. */
+  void
+  LaunchComputeDerivativeLowMemoryThreaderCallback(void) const;
+
 private:
   /** The deleted copy constructor. */
   ParzenWindowNormalizedMutualInformationImageToImageMetric(const Self &) = delete;
   /** The deleted assignment operator. */
   void
   operator=(const Self &) = delete;
+
+  /** Helper array for storing the values of the JointPDF ratios. */
+  typedef double              PRatioType;
+  typedef Array2D<PRatioType> PRatioArrayType;
+  mutable PRatioArrayType     m_PRatioArray;
+
+  /** Helper function to compute the derivative for the low memory variant. */
+  void
+  ComputeDerivativeLowMemorySingleThreaded(DerivativeType & derivative) const;
+
+  void
+  ComputeDerivativeLowMemory(DerivativeType & derivative) const;
+
+  /** Helper function to update the derivative for the low memory variant. */
+  void
+  UpdateDerivativeLowMemory(const RealType &                   fixedImageValue,
+                            const RealType &                   movingImageValue,
+                            const DerivativeType &             imageJacobian,
+                            const NonZeroJacobianIndicesType & nzji,
+                            DerivativeType &                   derivative) const;
+
+  /** Helper function to compute m_PRatioArray in case of low memory consumption.
+   * Assumes the marginal pdfs are already log'ed.
+   */
+  void
+  ComputePRatioArray(const MeasureType & nMI, const MeasureType & jointEntropy) const;
 };
 
 } // end namespace itk
@@ -54,6 +54,10 @@ namespace elastix
  *    image, without using a fixed image. Possible values are "true" or "false".
  * \parameter NumEigenValues: number of eigenvalues used in the metric: sum(e) - e, where sum(e)
  *  is the sum of all eigenvalues and e is the sum of the first highest NumEigenValues eigenvalues.
+ * \parameter UseEigenVectorWarmStart: compute the NumEigenValues largest eigenpairs with a block
+ *    Lanczos iteration that starts from the eigenvectors of the previous iteration, instead of
+ *    a full eigen-decomposition. When the iteration does not converge, the full decomposition
+ *    is used. Can be given for each resolution. Possible values are "true" or "false". Default: "false".
  *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
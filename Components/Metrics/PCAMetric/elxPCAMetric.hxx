@@ -57,6 +57,12 @@ PCAMetric<TElastix>::BeforeEachResolution(void)
   this->GetConfiguration()->ReadParameter(NumEigenValues, "NumEigenValues", this->GetComponentLabel(), level, 0);
   this->SetNumEigenValues(NumEigenValues);
 
+  /** Get and set if we want to warm-start the eigen-decomposition with the previous eigenvectors. */
+  bool useEigenVectorWarmStart = false;
+  this->GetConfiguration()->ReadParameter(
+    useEigenVectorWarmStart, "UseEigenVectorWarmStart", this->GetComponentLabel(), level, 0);
+  this->SetUseEigenVectorWarmStart(useEigenVectorWarmStart);
+
   /** Get and set if we want to subtract the mean from the derivative. */
   bool subtractMean = false;
   this->GetConfiguration()->ReadParameter(subtractMean, "SubtractMean", this->GetComponentLabel(), 0, 0);
@@ -20,7 +20,6 @@
 
 #include "itkPCAMetric.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkImage.h"
 #include "vnl/algo/vnl_svd.h"
@@ -102,9 +101,8 @@ PCAMetric<TFixedImage, TMovingImage>::SampleRandom(const int n, const int m, std
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator =
-    Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+  /** Get the random number generator. */
+  Statistics::MersenneTwisterRandomVariateGenerator * randomGenerator = this->m_RandomGenerator;
 
   /** Sample additional at fixed timepoint. */
   for (unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i)
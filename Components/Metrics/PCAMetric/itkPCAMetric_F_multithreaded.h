@@ -24,6 +24,8 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkExtractImageFilter.h"
+#include "itkCovarianceAccumulator.h"
+#include "itkBlockLanczosEigenSolver.h"
 
 namespace itk
 {
@@ -52,6 +54,13 @@ public:
   itkSetMacro(TransformIsStackTransform, bool);
   itkSetMacro(NumEigenValues, unsigned int);
 
+  /** Reuse the eigenvectors of the previous iteration as a warm start for the
+   * computation of the NumEigenValues largest eigenpairs. Default: false.
+   */
+  itkSetMacro(UseEigenVectorWarmStart, bool);
+  itkGetConstMacro(UseEigenVectorWarmStart, bool);
+  itkBooleanMacro(UseEigenVectorWarmStart);
+
   /** Typedefs from the superclass. */
   typedef typename Superclass::CoordinateRepresentationType    CoordinateRepresentationType;
   typedef typename Superclass::MovingImageType                 MovingImageType;
@@ -95,8 +104,10 @@ public:
   typedef typename Superclass::ThreaderType                    ThreaderType;
   typedef typename Superclass::ThreadInfoType                  ThreadInfoType;
 
-  typedef vnl_matrix<RealType>            MatrixType;
-  typedef vnl_matrix<DerivativeValueType> DerivativeMatrixType;
+  typedef vnl_matrix<RealType>              MatrixType;
+  typedef vnl_matrix<DerivativeValueType>   DerivativeMatrixType;
+  typedef CovarianceAccumulator<RealType>   CovarianceAccumulatorType;
+  typedef BlockLanczosEigenSolver<RealType> EigenSolverType;
 
   //    typedef vnl_matrix< double > MatrixType;
   //    typedef vnl_matrix< double > DerivativeMatrixType;
@@ -176,6 +187,7 @@ protected:
     MatrixType                       st_DataBlock;
     std::vector<FixedImagePointType> st_ApprovedSamples;
     DerivativeType                   st_Derivative;
+    CovarianceAccumulatorType        st_Covariance;
   };
 
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT, PCAMetricGetSamplesPerThreadStruct, PaddedPCAMetricGetSamplesPerThreadStruct);
@@ -219,6 +231,12 @@ protected:
   void
   InitializeThreadingParameters(void) const override;
 
+  /** Compute the m_NumEigenValues largest eigenvalues (descending) and the corresponding
+   * eigenvectors of K, warm-started with those of the previous call if requested.
+   */
+  void
+  ComputeLargestEigenPairs(const MatrixType & K, vnl_vector<RealType> & eigenValues, MatrixType & eigenVectors) const;
+
 private:
   PCAMetric(const Self &) = delete;
   void
@@ -239,6 +257,10 @@ private:
   /** Integer to indicate how many eigenvalues you want to use in the metric */
   unsigned int m_NumEigenValues;
 
+  /** Warm start of the eigen-decomposition with the eigenvectors of the previous call. */
+  bool                    m_UseEigenVectorWarmStart;
+  mutable EigenSolverType m_EigenSolver;
+
   /** Matrices, needed for derivative calculation */
   mutable std::vector<unsigned int> m_PixelStartIndex;
   mutable MatrixType                m_Atmm;
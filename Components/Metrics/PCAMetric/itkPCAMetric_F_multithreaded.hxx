@@ -44,6 +44,7 @@ PCAMetric<TFixedImage, TMovingImage>::PCAMetric()
   : m_SubtractMean(false)
   , m_TransformIsStackTransform(false)
   , m_NumEigenValues(6)
+  , m_UseEigenVectorWarmStart(false)
 {
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
@@ -89,6 +90,9 @@ PCAMetric<TFixedImage, TMovingImage>::Initialize(void)
     std::cerr << "ERROR: Number of eigenvalues is larger than number of images. Maximum number of eigenvalues equals: "
               << this->m_G << std::endl;
   }
+
+  /** The eigenvectors of the previous resolution are no valid warm start. */
+  this->m_EigenSolver.Reset();
 } // end Initializes
 
 
@@ -142,6 +146,38 @@ PCAMetric<TFixedImage, TMovingImage>::InitializeThreadingParameters(void) const
 } // end InitializeThreadingParameters()
 
 
+/**
+ * ******************* ComputeLargestEigenPairs *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric<TFixedImage, TMovingImage>::ComputeLargestEigenPairs(const MatrixType &     K,
+                                                               vnl_vector<RealType> & eigenValues,
+                                                               MatrixType &           eigenVectors) const
+{
+  if (this->m_UseEigenVectorWarmStart)
+  {
+    /** Falls back to the full decomposition itself, if the warm start does not converge. */
+    this->m_EigenSolver.Compute(K, this->m_NumEigenValues);
+    eigenValues = this->m_EigenSolver.GetEigenValues();
+    eigenVectors = this->m_EigenSolver.GetEigenVectors();
+    return;
+  }
+
+  vnl_symmetric_eigensystem<RealType> eig(K);
+
+  eigenValues.set_size(this->m_NumEigenValues);
+  eigenVectors.set_size(this->m_G, this->m_NumEigenValues);
+  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
+  {
+    eigenValues(i - 1) = eig.get_eigenvalue(this->m_G - i);
+    eigenVectors.set_column(i - 1, (eig.get_eigenvector(this->m_G - i)).normalize());
+  }
+
+} // end ComputeLargestEigenPairs()
+
+
 /**
  * *************** EvaluateTransformJacobianInnerProduct ****************
  */
@@ -315,14 +351,12 @@ PCAMetric<TFixedImage, TMovingImage>::GetValue(const TransformParametersType & p
   /** Compute correlation matrix K */
   MatrixType K(S * C * S);
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem<RealType> eig(K);
+  /** Compute the largest eigenvalues of K */
+  vnl_vector<RealType> eigenValues;
+  MatrixType           eigenVectorMatrix;
+  this->ComputeLargestEigenPairs(K, eigenValues, eigenVectorMatrix);
 
-  RealType sumEigenValuesUsed = itk::NumericTraits<RealType>::Zero;
-  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue(this->m_G - i);
-  }
+  const RealType sumEigenValuesUsed = eigenValues.sum();
 
   measure = this->m_G - sumEigenValuesUsed;
 
@@ -500,20 +534,12 @@ PCAMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(const
 
   MatrixType K(S * C * S);
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem<RealType> eig(K);
+  /** Compute the largest eigenvalues and eigenvectors of K */
+  vnl_vector<RealType> eigenValues;
+  MatrixType           eigenVectorMatrix;
+  this->ComputeLargestEigenPairs(K, eigenValues, eigenVectorMatrix);
 
-  RealType sumEigenValuesUsed = itk::NumericTraits<RealType>::Zero;
-  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue(this->m_G - i);
-  }
-
-  MatrixType eigenVectorMatrix(this->m_G, this->m_NumEigenValues);
-  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
-  {
-    eigenVectorMatrix.set_column(i - 1, (eig.get_eigenvector(this->m_G - i)).normalize());
-  }
+  const RealType sumEigenValuesUsed = eigenValues.sum();
 
   MatrixType eigenVectorMatrixTranspose(eigenVectorMatrix.transpose());
 
@@ -800,7 +826,13 @@ PCAMetric<TFixedImage, TMovingImage>::ThreadedGetSamples(ThreadIdType threadId)
 
   } /** end first loop over image sample container */
 
+  /** Partial mean and scatter matrix of the samples of this thread. */
+  CovarianceAccumulatorType covariance;
+  covariance.Initialize(this->m_G);
+  covariance.AddRows(datablock, 0, pixelIndex);
+
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_PCAMetricGetSamplesPerThreadVariables[threadId].st_Covariance = covariance;
   this->m_PCAMetricGetSamplesPerThreadVariables[threadId].st_NumberOfPixelsCounted = pixelIndex;
   this->m_PCAMetricGetSamplesPerThreadVariables[threadId].st_DataBlock = datablock.extract(pixelIndex, this->m_G);
   this->m_PCAMetricGetSamplesPerThreadVariables[threadId].st_ApprovedSamples = SamplesOK;
@@ -829,43 +861,35 @@ PCAMetric<TFixedImage, TMovingImage>::AfterThreadedGetSamples(MeasureType & valu
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  MatrixType   A(this->m_NumberOfPixelsCounted, this->m_G);
+  /** Combine the partial means and scatter matrices of the threads into the covariance matrix C.
+   * This replaces the serial N x G x G product of the centered data matrix with itself.
+   */
+  CovarianceAccumulatorType covariance;
+  covariance.Initialize(this->m_G);
   unsigned int row_start = 0;
   for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
-    A.update(this->m_PCAMetricGetSamplesPerThreadVariables[i].st_DataBlock, row_start, 0);
+    covariance.Merge(this->m_PCAMetricGetSamplesPerThreadVariables[i].st_Covariance);
     this->m_PixelStartIndex[i] = row_start;
     row_start += this->m_PCAMetricGetSamplesPerThreadVariables[i].st_DataBlock.rows();
   }
+  const vnl_vector<RealType> & mean = covariance.GetMean();
+  const MatrixType             C = covariance.GetCovarianceMatrix();
 
-  /** Calculate mean of from columns */
-  vnl_vector<RealType> mean(this->m_G);
-  mean.fill(NumericTraits<RealType>::Zero);
-  for (unsigned int i = 0; i < this->m_NumberOfPixelsCounted; i++)
-  {
-    for (unsigned int j = 0; j < this->m_G; j++)
-    {
-      mean(j) += A(i, j);
-    }
-  }
-  mean /= RealType(this->m_NumberOfPixelsCounted);
-
-  /** Calculate standard deviation from columns */
-  MatrixType Amm(this->m_NumberOfPixelsCounted, this->m_G);
-  Amm.fill(NumericTraits<RealType>::Zero);
-  for (unsigned int i = 0; i < this->m_NumberOfPixelsCounted; i++)
+  /** The transposed centered data matrix is still needed for the derivative. */
+  this->m_Atmm.set_size(this->m_G, this->m_NumberOfPixelsCounted);
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
-    for (unsigned int j = 0; j < this->m_G; j++)
+    const MatrixType & datablock = this->m_PCAMetricGetSamplesPerThreadVariables[i].st_DataBlock;
+    for (unsigned int k = 0; k < datablock.rows(); ++k)
     {
-      Amm(i, j) = A(i, j) - mean(j);
+      for (unsigned int j = 0; j < this->m_G; ++j)
+      {
+        this->m_Atmm(j, this->m_PixelStartIndex[i] + k) = datablock(k, j) - mean(j);
+      }
     }
   }
 
-  /** Compute covariancematrix C */
-  this->m_Atmm = Amm.transpose();
-  MatrixType C(this->m_Atmm * Amm);
-  C /= static_cast<RealType>(RealType(this->m_NumberOfPixelsCounted) - 1.0);
-
   vnl_diag_matrix<RealType> S(this->m_G);
   S.fill(NumericTraits<RealType>::Zero);
   for (unsigned int j = 0; j < this->m_G; j++)
@@ -875,16 +899,12 @@ PCAMetric<TFixedImage, TMovingImage>::AfterThreadedGetSamples(MeasureType & valu
 
   MatrixType K(S * C * S);
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem<RealType> eig(K);
+  /** Compute the largest eigenvalues and eigenvectors of K */
+  vnl_vector<RealType> eigenValues;
+  MatrixType           eigenVectorMatrix;
+  this->ComputeLargestEigenPairs(K, eigenValues, eigenVectorMatrix);
 
-  RealType   sumEigenValuesUsed = itk::NumericTraits<RealType>::Zero;
-  MatrixType eigenVectorMatrix(this->m_G, this->m_NumEigenValues);
-  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue(this->m_G - i);
-    eigenVectorMatrix.set_column(i - 1, (eig.get_eigenvector(this->m_G - i)).normalize());
-  }
+  const RealType sumEigenValuesUsed = eigenValues.sum();
 
   value = this->m_G - sumEigenValuesUsed;
 
@@ -24,6 +24,7 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkExtractImageFilter.h"
+#include "itkCovarianceAccumulator.h"
 
 namespace itk
 {
@@ -92,6 +93,11 @@ public:
   typedef typename Superclass::FixedImageLimiterOutputType     FixedImageLimiterOutputType;
   typedef typename Superclass::MovingImageLimiterOutputType    MovingImageLimiterOutputType;
   typedef typename Superclass::MovingImageDerivativeScalesType MovingImageDerivativeScalesType;
+  typedef typename Superclass::ThreaderType                    ThreaderType;
+  typedef typename Superclass::ThreadInfoType                  ThreadInfoType;
+
+  typedef vnl_matrix<RealType>            MatrixType;
+  typedef CovarianceAccumulator<RealType> CovarianceAccumulatorType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -151,6 +157,23 @@ protected:
                                         const MovingImageDerivativeType & movingImageDerivative,
                                         DerivativeType &                  imageJacobian) const override;
 
+  /** Compute the column mean and the covariance matrix of the data matrix A, which has one
+   * row per sample. When multi-threading is enabled, each thread computes the partial mean
+   * and scatter matrix of a block of rows, which are combined afterwards.
+   */
+  void
+  ComputeCovarianceMatrix(const MatrixType & A, vnl_vector<RealType> & mean, MatrixType & C) const;
+
+  struct PCAMetric2MultiThreaderParameterType
+  {
+    const MatrixType *          m_DataMatrix;
+    CovarianceAccumulatorType * m_Accumulators;
+  };
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeCovarianceThreaderCallback(void * arg);
+
 private:
   PCAMetric2(const Self &) = delete;
   void
@@ -20,7 +20,6 @@
 
 #include "itkPCAMetric2.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkImage.h"
 #include "vnl/algo/vnl_svd.h"
@@ -87,9 +86,8 @@ PCAMetric2<TFixedImage, TMovingImage>::SampleRandom(const int n, const int m, st
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator =
-    Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+  /** Get the random number generator. */
+  Statistics::MersenneTwisterRandomVariateGenerator * randomGenerator = this->m_RandomGenerator;
 
   /** Sample additional at fixed timepoint. */
   for (unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i)
@@ -141,6 +139,82 @@ PCAMetric2<TFixedImage, TMovingImage>::EvaluateTransformJacobianInnerProduct(
 } // end EvaluateTransformJacobianInnerProduct()
 
 
+/**
+ * ******************* ComputeCovarianceMatrix *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::ComputeCovarianceMatrix(const MatrixType &     A,
+                                                               vnl_vector<RealType> & mean,
+                                                               MatrixType &           C) const
+{
+  const ThreadIdType numberOfThreads = this->m_UseMultiThread ? Self::GetNumberOfWorkUnits() : 1;
+
+  std::vector<CovarianceAccumulatorType> accumulators(numberOfThreads);
+  for (auto & accumulator : accumulators)
+  {
+    accumulator.Initialize(A.cols());
+  }
+
+  if (numberOfThreads == 1)
+  {
+    accumulators[0].AddRows(A, 0, A.rows());
+  }
+  else
+  {
+    /** Each thread accumulates the partial mean and scatter matrix of a block of rows. */
+    PCAMetric2MultiThreaderParameterType parameters;
+    parameters.m_DataMatrix = &A;
+    parameters.m_Accumulators = accumulators.data();
+
+    this->m_Threader->SetSingleMethod(this->ComputeCovarianceThreaderCallback, &parameters);
+    this->m_Threader->SingleMethodExecute();
+
+    /** Combine the threads in a fixed order, so that the result does not depend on the timing. */
+    for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+    {
+      accumulators[0].Merge(accumulators[i]);
+    }
+  }
+
+  mean = accumulators[0].GetMean();
+  C = accumulators[0].GetCovarianceMatrix();
+
+} // end ComputeCovarianceMatrix()
+
+
+/**
+ * **************** ComputeCovarianceThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+PCAMetric2<TFixedImage, TMovingImage>::ComputeCovarianceThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+  ThreadIdType     numberOfThreads = infoStruct->NumberOfWorkUnits;
+
+  PCAMetric2MultiThreaderParameterType * temp =
+    static_cast<PCAMetric2MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Get the rows for this thread. */
+  const unsigned int numberOfRows = temp->m_DataMatrix->rows();
+  const unsigned int nrOfRowsPerThreads = static_cast<unsigned int>(
+    std::ceil(static_cast<double>(numberOfRows) / static_cast<double>(numberOfThreads)));
+  unsigned int pos_begin = nrOfRowsPerThreads * threadId;
+  unsigned int pos_end = nrOfRowsPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > numberOfRows) ? numberOfRows : pos_begin;
+  pos_end = (pos_end > numberOfRows) ? numberOfRows : pos_end;
+
+  temp->m_Accumulators[threadId].AddRows(*temp->m_DataMatrix, pos_begin, pos_end);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeCovarianceThreaderCallback()
+
+
 /**
  * ******************* GetValue *******************
  */
@@ -264,32 +338,10 @@ PCAMetric2<TFixedImage, TMovingImage>::GetValue(const TransformParametersType &
   const unsigned int N = this->m_NumberOfPixelsCounted;
   MatrixType         A(datablock.extract(N, G));
 
-  /** Calculate mean of from columns */
-  vnl_vector<RealType> mean(G);
-  mean.fill(NumericTraits<RealType>::Zero);
-  for (unsigned int i = 0; i < N; i++)
-  {
-    for (unsigned int j = 0; j < G; j++)
-    {
-      mean(j) += A(i, j);
-    }
-  }
-  mean /= RealType(N);
-
-  MatrixType Amm(N, G);
-  Amm.fill(NumericTraits<RealType>::Zero);
-
-  for (unsigned int i = 0; i < N; i++)
-  {
-    for (unsigned int j = 0; j < G; j++)
-    {
-      Amm(i, j) = A(i, j) - mean(j);
-    }
-  }
-
   /** Compute covariancematrix C */
-  MatrixType C(Amm.transpose() * Amm);
-  C /= static_cast<RealType>(RealType(N) - 1.0);
+  vnl_vector<RealType> mean;
+  MatrixType           C;
+  this->ComputeCovarianceMatrix(A, mean, C);
 
   MatrixType S(G, G);
   S.fill(NumericTraits<RealType>::Zero);
@@ -474,34 +526,21 @@ PCAMetric2<TFixedImage, TMovingImage>::GetValueAndDerivative(const TransformPara
 
   MatrixType A(datablock.extract(N, G));
 
-  /** Calculate mean of columns */
-  vnl_vector<RealType> mean(G);
-  mean.fill(NumericTraits<RealType>::Zero);
-  for (unsigned int i = 0; i < N; i++)
-  {
-    for (unsigned int j = 0; j < G; j++)
-    {
-      mean(j) += A(i, j);
-    }
-  }
-  mean /= RealType(N);
+  /** Compute covariance matrix C */
+  vnl_vector<RealType> mean;
+  MatrixType           C;
+  this->ComputeCovarianceMatrix(A, mean, C);
 
-  /** Calculate standard deviation of columns */
-  MatrixType Amm(N, G);
-  Amm.fill(NumericTraits<RealType>::Zero);
+  /** The transposed centered data matrix is needed for the derivative. */
+  MatrixType Atmm(G, N);
   for (unsigned int i = 0; i < N; i++)
   {
     for (unsigned int j = 0; j < G; j++)
     {
-      Amm(i, j) = A(i, j) - mean(j);
+      Atmm(j, i) = A(i, j) - mean(j);
     }
   }
 
-  /** Compute covariance matrix C */
-  MatrixType Atmm = Amm.transpose();
-  MatrixType C(Atmm * Amm);
-  C /= static_cast<RealType>(RealType(N) - 1.0);
-
   vnl_diag_matrix<RealType> S(G);
   S.fill(NumericTraits<RealType>::Zero);
   for (unsigned int j = 0; j < G; j++)
@@ -50,7 +50,9 @@ namespace itk
  * image in order to calculate a rigidity penalty term on a B-spline transform.
  *
  * The RigidityPenaltyTermValueImageFilter at each pixel location is computed by
- * convolution with some separable 1D kernels.
+ * convolution with some separable 1D kernels. These are combined into 3^D stencils,
+ * which are applied to the B-spline grid in two multi-threaded passes, without
+ * creating intermediate images.
  *
  * The rigid penalty term penalizes deviations from a rigid
  * transformation at regions specified by the so-called rigidity images.
@@ -119,6 +121,7 @@ public:
   typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
   typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
   typedef typename Superclass::ScalarType                   ScalarType;
+  typedef typename Superclass::ThreadInfoType               ThreadInfoType;
 
   /** Typedef's for the B-spline transform. */
   typedef typename Superclass::CombinationTransformType      CombinationTransformType;
@@ -151,6 +154,7 @@ public:
   typedef typename BSplineTransformType::SpacingType GridSpacingType;
   typedef typename BSplineTransformType::ImageType   CoefficientImageType;
   typedef typename CoefficientImageType::Pointer     CoefficientImagePointer;
+  typedef typename CoefficientImageType::PixelType   CoefficientPixelType;
   typedef typename CoefficientImageType::SpacingType CoefficientImageSpacingType;
 
   /** Typedef support for neighborhoods, filters, etc. */
@@ -319,9 +323,77 @@ private:
   void
   CreateNDOperator(NeighborhoodType & F, const std::string & whichF, const CoefficientImageSpacingType & spacing) const;
 
-  /** Private function used for the filtering. It performs 1D separable filtering. */
-  CoefficientImagePointer
-  FilterSeparable(const CoefficientImageType *, const std::vector<NeighborhoodType> & Operators) const;
+  /** Private function that computes the value of the conditions, and, if derivative is not
+   * a null pointer, also the derivative. The filters of the paper are fused into 3^D stencils,
+   * evaluated in two multi-threaded passes over the B-spline grid. The first pass filters the
+   * B-spline coefficients around each grid point, which gives the values of the conditions and
+   * their derivative parts. The second pass filters the derivative parts into the derivative.
+   */
+  void
+  EvaluateStencils(DerivativeType * derivative) const;
+
+  /** The first pass of EvaluateStencils(), for the grid points of this thread. */
+  void
+  ThreadedComputeParts(ThreadIdType threadId, ThreadIdType numberOfThreads) const;
+
+  /** The second pass of EvaluateStencils(), for the grid points of this thread. */
+  void
+  ThreadedComputeDerivative(ThreadIdType threadId, ThreadIdType numberOfThreads) const;
+
+  /** Compute the offsets of the 3^D grid points in the neighborhood of the grid point with the
+   * given index. Outside the grid the index is clamped, as in the zero flux Neumann boundary condition.
+   */
+  void
+  ComputeStencilOffsets(const SizeValueType * gridIndex, SizeValueType * offsets) const;
+
+  /** The threader callbacks of the two passes. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputePartsThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeThreaderCallback(void * arg);
+
+  /** The number of filters, FA up to FI, and the size of their stencils. */
+  itkStaticConstMacro(NumberOfFilters, unsigned int, 9);
+  itkStaticConstMacro(StencilSize, unsigned int, ImageDimension == 2 ? 9 : 27);
+  itkStaticConstMacro(NumberOfLinearityParts, unsigned int, 3 * ImageDimension - 3);
+
+  /** The variables that are shared by the threads of EvaluateStencils(). */
+  struct StencilThreaderParameterType
+  {
+    const Self *                 st_Metric;
+    const CoefficientPixelType * st_Coefficients[ImageDimension];
+    const RigidityPixelType *    st_RigidityCoefficients;
+    SizeValueType                st_GridSize[ImageDimension];
+    SizeValueType                st_NumberOfGridPoints;
+    ScalarType                   st_RigidityCoefficientSum;
+    DerivativeValueType *        st_Derivative;
+    bool                         st_FilterIsUsed[NumberOfFilters];
+    ScalarType                   st_FilterWeights[NumberOfFilters][StencilSize];
+    ScalarType                   st_DerivativeWeights[NumberOfFilters][StencilSize];
+  };
+  mutable StencilThreaderParameterType m_StencilThreaderParameters;
+
+  /** The sums of the threads, which are added in the order of the threads. */
+  struct StencilPerThreadStruct
+  {
+    MeasureType st_LinearityConditionValue;
+    MeasureType st_OrthonormalityConditionValue;
+    MeasureType st_PropernessConditionValue;
+    MeasureType st_LinearityConditionGradientMagnitude;
+    MeasureType st_OrthonormalityConditionGradientMagnitude;
+    MeasureType st_PropernessConditionGradientMagnitude;
+  };
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT, StencilPerThreadStruct, PaddedStencilPerThreadStruct);
+  mutable std::vector<PaddedStencilPerThreadStruct> m_StencilPerThreadVariables;
+
+  /** The derivative parts of the conditions at all grid points, multiplied by the rigidity
+   * coefficient. The parts of a grid point are stored contiguously. The buffers are kept
+   * between iterations, so that they are only allocated once per resolution.
+   */
+  mutable std::vector<ScalarType> m_OrthonormalityConditionParts;
+  mutable std::vector<ScalarType> m_PropernessConditionParts;
+  mutable std::vector<ScalarType> m_LinearityConditionParts;
 
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
@@ -22,6 +22,8 @@
 
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 
+#include <algorithm> // For std::fill_n and std::min.
+
 namespace itk
 {
 
@@ -477,363 +479,8 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValue(const Parameter
    */
   this->m_BSplineTransform->SetParameters(parameters);
 
-  /** Sanity check. */
-  if (ImageDimension != 2 && ImageDimension != 3)
-  {
-    itkExceptionMacro(<< "ERROR: This filter is only implemented for dimension 2 and 3.");
-  }
-
-  /** Get a handle to the B-spline coefficient images. */
-  std::vector<CoefficientImagePointer> inputImages(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    inputImages[i] = this->m_BSplineTransform->GetCoefficientImages()[i];
-  }
-
-  /** Get the B-spline coefficient image spacing. */
-  CoefficientImageSpacingType spacing = inputImages[0]->GetSpacing();
-
-  /** TASK 0:
-   * Compute the rigidityCoefficientSum and check on it.
-   *
-   ************************************************************************* */
-
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI(this->m_RigidityCoefficientImage,
-                                      this->m_RigidityCoefficientImage->GetLargestPossibleRegion());
-  it_RCI.GoToBegin();
-  ScalarType rigidityCoefficientSum = NumericTraits<ScalarType>::Zero;
-
-  /** Add the rigidity coefficients together. */
-  while (!it_RCI.IsAtEnd())
-  {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
-  }
-
-  /** Check for early termination. */
-  if (rigidityCoefficientSum < 1e-14)
-  {
-    this->m_RigidityPenaltyTermValue = NumericTraits<MeasureType>::Zero;
-    return this->m_RigidityPenaltyTermValue;
-  }
-
-  /** TASK 1:
-   * Prepare for the calculation of the rigidity penalty term.
-   *
-   ************************************************************************* */
-
-  /** Create 1D neighbourhood operators. */
-  std::vector<NeighborhoodType> Operators_A(ImageDimension), Operators_B(ImageDimension), Operators_C(ImageDimension),
-    Operators_D(ImageDimension), Operators_E(ImageDimension), Operators_F(ImageDimension), Operators_G(ImageDimension),
-    Operators_H(ImageDimension), Operators_I(ImageDimension);
-
-  /** Create B-spline coefficient images that are filtered once. */
-  std::vector<CoefficientImagePointer> ui_FA(ImageDimension), ui_FB(ImageDimension), ui_FC(ImageDimension),
-    ui_FD(ImageDimension), ui_FE(ImageDimension), ui_FF(ImageDimension), ui_FG(ImageDimension), ui_FH(ImageDimension),
-    ui_FI(ImageDimension);
-
-  /** For all dimensions ... */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    /** ... create the filtered images ... */
-    ui_FA[i] = CoefficientImageType::New();
-    ui_FB[i] = CoefficientImageType::New();
-    ui_FD[i] = CoefficientImageType::New();
-    ui_FE[i] = CoefficientImageType::New();
-    ui_FG[i] = CoefficientImageType::New();
-    if (ImageDimension == 3)
-    {
-      ui_FC[i] = CoefficientImageType::New();
-      ui_FF[i] = CoefficientImageType::New();
-      ui_FH[i] = CoefficientImageType::New();
-      ui_FI[i] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
-     * The operators C, D and E from the paper are here created
-     * by Create1DOperator D, E and G, because of the 3D case and history.
-     */
-    this->Create1DOperator(Operators_A[i], "FA_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_B[i], "FB_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_D[i], "FD_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_E[i], "FE_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_G[i], "FG_xi", i + 1, spacing);
-    if (ImageDimension == 3)
-    {
-      this->Create1DOperator(Operators_C[i], "FC_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_F[i], "FF_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_H[i], "FH_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_I[i], "FI_xi", i + 1, spacing);
-    }
-  } // end for loop
-
-  /** TASK 2:
-   * Filter the B-spline coefficient images.
-   *
-   ************************************************************************* */
-
-  /** Filter the inputImages. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A);
-    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B);
-    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D);
-    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E);
-    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G);
-    if (ImageDimension == 3)
-    {
-      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C);
-      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F);
-      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H);
-      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I);
-    }
-  }
-
-  /** TASK 3:
-   * Create iterators.
-   *
-   ************************************************************************* */
-
-  /** Create iterators over ui_F?. */
-  std::vector<CoefficientImageIteratorType> itA(ImageDimension), itB(ImageDimension), itC(ImageDimension),
-    itD(ImageDimension), itE(ImageDimension), itF(ImageDimension), itG(ImageDimension), itH(ImageDimension),
-    itI(ImageDimension);
-
-  /** Create iterators. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    /** Create iterators. */
-    itA[i] = CoefficientImageIteratorType(ui_FA[i], ui_FA[i]->GetLargestPossibleRegion());
-    itB[i] = CoefficientImageIteratorType(ui_FB[i], ui_FB[i]->GetLargestPossibleRegion());
-    itD[i] = CoefficientImageIteratorType(ui_FD[i], ui_FD[i]->GetLargestPossibleRegion());
-    itE[i] = CoefficientImageIteratorType(ui_FE[i], ui_FE[i]->GetLargestPossibleRegion());
-    itG[i] = CoefficientImageIteratorType(ui_FG[i], ui_FG[i]->GetLargestPossibleRegion());
-    if (ImageDimension == 3)
-    {
-      itC[i] = CoefficientImageIteratorType(ui_FC[i], ui_FC[i]->GetLargestPossibleRegion());
-      itF[i] = CoefficientImageIteratorType(ui_FF[i], ui_FF[i]->GetLargestPossibleRegion());
-      itH[i] = CoefficientImageIteratorType(ui_FH[i], ui_FH[i]->GetLargestPossibleRegion());
-      itI[i] = CoefficientImageIteratorType(ui_FI[i], ui_FI[i]->GetLargestPossibleRegion());
-    }
-    /** Reset iterators. */
-    itA[i].GoToBegin();
-    itB[i].GoToBegin();
-    itD[i].GoToBegin();
-    itE[i].GoToBegin();
-    itG[i].GoToBegin();
-    if (ImageDimension == 3)
-    {
-      itC[i].GoToBegin();
-      itF[i].GoToBegin();
-      itH[i].GoToBegin();
-      itI[i].GoToBegin();
-    }
-  }
-
-  /** TASK 4A:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the orthonormality term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    while (!itA[0].IsAtEnd())
-    {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[0].Get();
-      mu2_A = itA[1].Get();
-      mu1_B = itB[0].Get();
-      mu2_B = itB[1].Get();
-      if (ImageDimension == 3)
-      {
-        mu3_A = itA[2].Get();
-        mu3_B = itB[2].Get();
-        mu1_C = itC[0].Get();
-        mu2_C = itC[1].Get();
-        mu3_C = itC[2].Get();
-      }
-
-      if (ImageDimension == 2)
-      {
-        this->m_OrthonormalityConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A - 1.0, 2.0) +
-                          std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) - 1.0, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B), 2.0));
-      }
-      else if (ImageDimension == 3)
-      {
-        this->m_OrthonormalityConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A + mu3_A * mu3_A - 1.0, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B) + mu3_A * mu3_B, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_C + mu2_A * mu2_C + mu3_A * (1.0 + mu3_C), 2.0) +
-                          std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) + mu3_B * mu3_B - 1.0, 2.0) +
-                          std::pow(+mu1_B * mu1_C + (1.0 + mu2_B) * mu2_C + mu3_B * (1.0 + mu3_C), 2.0) +
-                          std::pow(+mu1_C * mu1_C + mu2_C * mu2_C + (1.0 + mu3_C) * (1.0 + mu3_C) - 1.0, 2.0));
-      }
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itA[i];
-        ++itB[i];
-        if (ImageDimension == 3)
-        {
-          ++itC[i];
-        }
-      }
-      ++it_RCI;
-    } // end while
-  }   // end if do orthonormality
-
-  /** TASK 4B:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the properness term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    itA[i].GoToBegin();
-    itB[i].GoToBegin();
-    if (ImageDimension == 3)
-    {
-      itC[i].GoToBegin();
-    }
-  }
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculatePropernessCondition)
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    while (!itA[0].IsAtEnd())
-    {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[0].Get();
-      mu2_A = itA[1].Get();
-      mu1_B = itB[0].Get();
-      mu2_B = itB[1].Get();
-      if (ImageDimension == 3)
-      {
-        mu3_A = itA[2].Get();
-        mu3_B = itB[2].Get();
-        mu1_C = itC[0].Get();
-        mu2_C = itC[1].Get();
-        mu3_C = itC[2].Get();
-      }
-
-      if (ImageDimension == 2)
-      {
-        this->m_PropernessConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu2_B) - mu2_A * mu1_B - 1.0, 2.0));
-      }
-      else if (ImageDimension == 3)
-      {
-        this->m_PropernessConditionValue +=
-          it_RCI.Get() * (std::pow(-mu1_C * (1.0 + mu2_B) * mu3_A + mu1_B * mu2_C * mu3_A + mu1_C * mu2_A * mu3_B -
-                                     (1.0 + mu1_A) * mu2_C * mu3_B - mu1_B * mu2_A * (1.0 + mu3_C) +
-                                     (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) - 1.0,
-                                   2.0));
-      }
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itA[i];
-        ++itB[i];
-        if (ImageDimension == 3)
-        {
-          ++itC[i];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 4C:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the linearity term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculateLinearityCondition)
-  {
-    while (!itD[0].IsAtEnd())
-    {
-      /** Linearity condition part. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        this->m_LinearityConditionValue +=
-          it_RCI.Get() * (+itD[i].Get() * itD[i].Get() + itE[i].Get() * itE[i].Get() + itG[i].Get() * itG[i].Get());
-        if (ImageDimension == 3)
-        {
-          this->m_LinearityConditionValue +=
-            it_RCI.Get() * (+itF[i].Get() * itF[i].Get() + itH[i].Get() * itH[i].Get() + itI[i].Get() * itI[i].Get());
-        }
-      } // end loop over i
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itD[i];
-        ++itE[i];
-        ++itG[i];
-        if (ImageDimension == 3)
-        {
-          ++itF[i];
-          ++itH[i];
-          ++itI[i];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 5:
-   * Do the actual calculation of the rigidity penalty term value.
-   *
-   ************************************************************************* */
-
-  /** Calculate the rigidity penalty term value. */
-  if (this->m_CalculateLinearityCondition)
-  {
-    this->m_LinearityConditionValue /= rigidityCoefficientSum;
-  }
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
-  }
-  if (this->m_CalculatePropernessCondition)
-  {
-    this->m_PropernessConditionValue /= rigidityCoefficientSum;
-  }
-
-  if (this->m_UseLinearityCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
-  }
-  if (this->m_UseOrthonormalityCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
-  }
-  if (this->m_UsePropernessCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
-  }
+  /** Compute the value, without the derivative. */
+  this->EvaluateStencils(nullptr);
 
   /** Return the rigidity penalty term value. */
   return this->m_RigidityPenaltyTermValue;
@@ -920,38 +567,53 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
+  /** Compute the value and the derivative. */
+  this->EvaluateStencils(&derivative);
+  value = this->m_RigidityPenaltyTermValue;
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * *********************** EvaluateStencils ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::EvaluateStencils(DerivativeType * derivative) const
+{
   /** Sanity check. */
   if (ImageDimension != 2 && ImageDimension != 3)
   {
     itkExceptionMacro(<< "ERROR: This filter is only implemented for dimension 2 and 3.");
   }
 
-  /** Get a handle to the B-spline coefficient images. */
-  std::vector<CoefficientImagePointer> inputImages(ImageDimension);
+  /** Get a handle to the B-spline coefficient images, which share the grid of the rigidity image. */
+  StencilThreaderParameterType & threaderParameters = this->m_StencilThreaderParameters;
+  const CoefficientImageSpacingType spacing = this->m_BSplineTransform->GetCoefficientImages()[0]->GetSpacing();
+  const typename CoefficientImageType::SizeType gridSize =
+    this->m_BSplineTransform->GetCoefficientImages()[0]->GetLargestPossibleRegion().GetSize();
+  threaderParameters.st_Metric = this;
+  threaderParameters.st_NumberOfGridPoints = 1;
   for (unsigned int i = 0; i < ImageDimension; i++)
   {
-    inputImages[i] = this->m_BSplineTransform->GetCoefficientImages()[i];
+    threaderParameters.st_Coefficients[i] = this->m_BSplineTransform->GetCoefficientImages()[i]->GetBufferPointer();
+    threaderParameters.st_GridSize[i] = gridSize[i];
+    threaderParameters.st_NumberOfGridPoints *= gridSize[i];
   }
-
-  /** Get the B-spline coefficient image spacing. */
-  CoefficientImageSpacingType spacing = inputImages[0]->GetSpacing();
+  threaderParameters.st_RigidityCoefficients = this->m_RigidityCoefficientImage->GetBufferPointer();
+  threaderParameters.st_Derivative = derivative != nullptr ? derivative->data_block() : nullptr;
+  const SizeValueType numberOfGridPoints = threaderParameters.st_NumberOfGridPoints;
 
   /** TASK 0:
    * Compute the rigidityCoefficientSum and check on it.
    *
    ************************************************************************* */
 
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI(this->m_RigidityCoefficientImage,
-                                      this->m_RigidityCoefficientImage->GetLargestPossibleRegion());
-  it_RCI.GoToBegin();
   ScalarType rigidityCoefficientSum = NumericTraits<ScalarType>::Zero;
-
-  /** Add the rigidity coefficients together. */
-  while (!it_RCI.IsAtEnd())
+  for (SizeValueType x = 0; x < numberOfGridPoints; ++x)
   {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
+    rigidityCoefficientSum += threaderParameters.st_RigidityCoefficients[x];
   }
 
   /** Check for early termination. */
@@ -960,380 +622,474 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
     this->m_RigidityPenaltyTermValue = NumericTraits<MeasureType>::Zero;
     return;
   }
+  threaderParameters.st_RigidityCoefficientSum = rigidityCoefficientSum;
 
   /** TASK 1:
-   * Prepare for the calculation of the rigidity penalty term.
-   *
+   * Create the stencils of the filters.
+   * The 1D operators of a filter are combined to a single 3^D stencil. With the index
+   * clamped at the border this equals the separable filtering with a zero flux Neumann
+   * boundary condition. The ND operators are the stencils of the derivative.
    ************************************************************************* */
 
-  /** Create 1D neighbourhood operators. */
-  std::vector<NeighborhoodType> Operators_A(ImageDimension), Operators_B(ImageDimension), Operators_C(ImageDimension),
-    Operators_D(ImageDimension), Operators_E(ImageDimension), Operators_F(ImageDimension), Operators_G(ImageDimension),
-    Operators_H(ImageDimension), Operators_I(ImageDimension);
+  const bool calculateFirstOrderFilters =
+    this->m_CalculateOrthonormalityCondition || this->m_CalculatePropernessCondition;
+  const char * const filterNames[NumberOfFilters] = { "FA", "FB", "FC", "FD", "FE", "FF", "FG", "FH", "FI" };
+  for (unsigned int f = 0; f < NumberOfFilters; ++f)
+  {
+    /** The filters C, F, H and I only exist in 3D. */
+    const bool filterExists = ImageDimension == 3 || (f != 2 && f != 5 && f != 7 && f != 8);
+    threaderParameters.st_FilterIsUsed[f] =
+      filterExists && (f < 3 ? calculateFirstOrderFilters : this->m_CalculateLinearityCondition);
+    if (!threaderParameters.st_FilterIsUsed[f])
+    {
+      continue;
+    }
 
-  /** Create B-spline coefficient images that are filtered once. */
-  std::vector<CoefficientImagePointer> ui_FA(ImageDimension), ui_FB(ImageDimension), ui_FC(ImageDimension),
-    ui_FD(ImageDimension), ui_FE(ImageDimension), ui_FF(ImageDimension), ui_FG(ImageDimension), ui_FH(ImageDimension),
-    ui_FI(ImageDimension);
+    std::fill_n(threaderParameters.st_FilterWeights[f], StencilSize, NumericTraits<ScalarType>::One);
+    unsigned int stride = 1;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      NeighborhoodType Operator;
+      this->Create1DOperator(Operator, std::string(filterNames[f]) + "_xi", d + 1, spacing);
+      for (unsigned int k = 0; k < StencilSize; ++k)
+      {
+        threaderParameters.st_FilterWeights[f][k] *= Operator[(k / stride) % 3];
+      }
+      stride *= 3;
+    }
 
-  /** For all dimensions ... */
-  for (unsigned int i = 0; i < ImageDimension; i++)
+    NeighborhoodType Operator;
+    this->CreateNDOperator(Operator, filterNames[f], spacing);
+    for (unsigned int k = 0; k < StencilSize; ++k)
+    {
+      threaderParameters.st_DerivativeWeights[f][k] = Operator[k];
+    }
+  }
+
+  /** The buffers of the derivative parts only grow when the grid is refined. */
+  if (derivative != nullptr)
   {
-    /** ... create the filtered images ... */
-    ui_FA[i] = CoefficientImageType::New();
-    ui_FB[i] = CoefficientImageType::New();
-    ui_FD[i] = CoefficientImageType::New();
-    ui_FE[i] = CoefficientImageType::New();
-    ui_FG[i] = CoefficientImageType::New();
-    if (ImageDimension == 3)
+    if (this->m_CalculateOrthonormalityCondition)
     {
-      ui_FC[i] = CoefficientImageType::New();
-      ui_FF[i] = CoefficientImageType::New();
-      ui_FH[i] = CoefficientImageType::New();
-      ui_FI[i] = CoefficientImageType::New();
+      this->m_OrthonormalityConditionParts.resize(numberOfGridPoints * ImageDimension * ImageDimension);
     }
-    /** ... and the apropiate operators.
-     * The operators C, D and E from the paper are here created
-     * by Create1DOperator D, E and G, because of the 3D case and history.
-     */
-    this->Create1DOperator(Operators_A[i], "FA_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_B[i], "FB_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_D[i], "FD_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_E[i], "FE_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_G[i], "FG_xi", i + 1, spacing);
-    if (ImageDimension == 3)
+    if (this->m_CalculatePropernessCondition)
     {
-      this->Create1DOperator(Operators_C[i], "FC_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_F[i], "FF_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_H[i], "FH_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_I[i], "FI_xi", i + 1, spacing);
+      this->m_PropernessConditionParts.resize(numberOfGridPoints * ImageDimension * ImageDimension);
     }
-  } // end for loop
+    if (this->m_CalculateLinearityCondition)
+    {
+      this->m_LinearityConditionParts.resize(numberOfGridPoints * ImageDimension * NumberOfLinearityParts);
+    }
+  }
 
   /** TASK 2:
-   * Filter the B-spline coefficient images.
+   * Compute the values of the conditions and the derivative parts.
    *
    ************************************************************************* */
 
-  /** Filter the inputImages. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  const ThreadIdType numberOfThreads = this->m_UseMultiThread ? this->m_Threader->GetNumberOfWorkUnits() : 1;
+  this->m_StencilPerThreadVariables.assign(numberOfThreads, PaddedStencilPerThreadStruct());
+  if (this->m_UseMultiThread)
   {
-    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A);
-    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B);
-    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D);
-    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E);
-    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G);
-    if (ImageDimension == 3)
-    {
-      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C);
-      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F);
-      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H);
-      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I);
-    }
+    this->m_Threader->SetSingleMethod(this->ComputePartsThreaderCallback,
+                                      const_cast<void *>(static_cast<const void *>(&threaderParameters)));
+    this->m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedComputeParts(0, 1);
   }
 
   /** TASK 3:
-   * Create subparts and iterators.
+   * Do the actual calculation of the rigidity penalty term value.
    *
    ************************************************************************* */
 
-  /** Create iterators over ui_F?. */
-  std::vector<CoefficientImageIteratorType> itA(ImageDimension), itB(ImageDimension), itC(ImageDimension),
-    itD(ImageDimension), itE(ImageDimension), itF(ImageDimension), itG(ImageDimension), itH(ImageDimension),
-    itI(ImageDimension);
+  for (const auto & threadVariables : this->m_StencilPerThreadVariables)
+  {
+    this->m_LinearityConditionValue += threadVariables.st_LinearityConditionValue;
+    this->m_OrthonormalityConditionValue += threadVariables.st_OrthonormalityConditionValue;
+    this->m_PropernessConditionValue += threadVariables.st_PropernessConditionValue;
+  }
 
-  /** Create iterators. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  /** Calculate the rigidity penalty term value. */
+  this->m_LinearityConditionValue /= rigidityCoefficientSum;
+  this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
+  this->m_PropernessConditionValue /= rigidityCoefficientSum;
+
+  if (this->m_UseLinearityCondition)
   {
-    /** Create iterators. */
-    itA[i] = CoefficientImageIteratorType(ui_FA[i], ui_FA[i]->GetLargestPossibleRegion());
-    itB[i] = CoefficientImageIteratorType(ui_FB[i], ui_FB[i]->GetLargestPossibleRegion());
-    itD[i] = CoefficientImageIteratorType(ui_FD[i], ui_FD[i]->GetLargestPossibleRegion());
-    itE[i] = CoefficientImageIteratorType(ui_FE[i], ui_FE[i]->GetLargestPossibleRegion());
-    itG[i] = CoefficientImageIteratorType(ui_FG[i], ui_FG[i]->GetLargestPossibleRegion());
-    if (ImageDimension == 3)
-    {
-      itC[i] = CoefficientImageIteratorType(ui_FC[i], ui_FC[i]->GetLargestPossibleRegion());
-      itF[i] = CoefficientImageIteratorType(ui_FF[i], ui_FF[i]->GetLargestPossibleRegion());
-      itH[i] = CoefficientImageIteratorType(ui_FH[i], ui_FH[i]->GetLargestPossibleRegion());
-      itI[i] = CoefficientImageIteratorType(ui_FI[i], ui_FI[i]->GetLargestPossibleRegion());
-    }
-    /** Reset iterators. */
-    itA[i].GoToBegin();
-    itB[i].GoToBegin();
-    itD[i].GoToBegin();
-    itE[i].GoToBegin();
-    itG[i].GoToBegin();
-    if (ImageDimension == 3)
-    {
-      itC[i].GoToBegin();
-      itF[i].GoToBegin();
-      itH[i].GoToBegin();
-      itI[i].GoToBegin();
-    }
+    this->m_RigidityPenaltyTermValue += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
+  }
+  if (this->m_UseOrthonormalityCondition)
+  {
+    this->m_RigidityPenaltyTermValue += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
+  }
+  if (this->m_UsePropernessCondition)
+  {
+    this->m_RigidityPenaltyTermValue += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
   }
 
-  /** Create orthonormality and properness parts. */
-  std::vector<std::vector<CoefficientImagePointer>> OCparts(ImageDimension);
-  std::vector<std::vector<CoefficientImagePointer>> PCparts(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  if (derivative == nullptr)
+  {
+    return;
+  }
+
+  /** TASK 4:
+   * Filter the derivative parts into the derivative.
+   *
+   ************************************************************************* */
+
+  if (this->m_UseMultiThread)
+  {
+    this->m_Threader->SetSingleMethod(this->ComputeDerivativeThreaderCallback,
+                                      const_cast<void *>(static_cast<const void *>(&threaderParameters)));
+    this->m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedComputeDerivative(0, 1);
+  }
+
+  /** Set the gradient magnitudes of the several terms. */
+  MeasureType gradMagLC = NumericTraits<MeasureType>::Zero;
+  MeasureType gradMagOC = NumericTraits<MeasureType>::Zero;
+  MeasureType gradMagPC = NumericTraits<MeasureType>::Zero;
+  for (const auto & threadVariables : this->m_StencilPerThreadVariables)
+  {
+    gradMagLC += threadVariables.st_LinearityConditionGradientMagnitude;
+    gradMagOC += threadVariables.st_OrthonormalityConditionGradientMagnitude;
+    gradMagPC += threadVariables.st_PropernessConditionGradientMagnitude;
+  }
+  const MeasureType rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
+  this->m_LinearityConditionGradientMagnitude = std::sqrt(gradMagLC / rigidityCoefficientSumSqr);
+  this->m_OrthonormalityConditionGradientMagnitude = std::sqrt(gradMagOC / rigidityCoefficientSumSqr);
+  this->m_PropernessConditionGradientMagnitude = std::sqrt(gradMagPC / rigidityCoefficientSumSqr);
+
+} // end EvaluateStencils()
+
+
+/**
+ * *********************** ComputePartsThreaderCallback ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputePartsThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  StencilThreaderParameterType * temp = static_cast<StencilThreaderParameterType *>(infoStruct->UserData);
+
+  temp->st_Metric->ThreadedComputeParts(threadID, nrOfThreads);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputePartsThreaderCallback()
+
+
+/**
+ * *********************** ComputeDerivativeThreaderCallback ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputeDerivativeThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  StencilThreaderParameterType * temp = static_cast<StencilThreaderParameterType *>(infoStruct->UserData);
+
+  temp->st_Metric->ThreadedComputeDerivative(threadID, nrOfThreads);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeDerivativeThreaderCallback()
+
+
+/**
+ * *********************** ComputeStencilOffsets ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputeStencilOffsets(const SizeValueType * gridIndex,
+                                                                              SizeValueType *       offsets) const
+{
+  /** The clamped offsets of the previous, current and next grid point in each dimension. */
+  SizeValueType clampedOffsets[ImageDimension][3];
+  SizeValueType stride = 1;
+  for (unsigned int d = 0; d < ImageDimension; ++d)
+  {
+    const SizeValueType last = this->m_StencilThreaderParameters.st_GridSize[d] - 1;
+    clampedOffsets[d][0] = (gridIndex[d] > 0 ? gridIndex[d] - 1 : 0) * stride;
+    clampedOffsets[d][1] = gridIndex[d] * stride;
+    clampedOffsets[d][2] = (gridIndex[d] < last ? gridIndex[d] + 1 : last) * stride;
+    stride *= this->m_StencilThreaderParameters.st_GridSize[d];
+  }
+
+  /** The neighborhood is ordered like itk::Neighborhood, with the first dimension running fastest. */
+  for (unsigned int k = 0; k < StencilSize; ++k)
   {
-    OCparts[i].resize(ImageDimension);
-    PCparts[i].resize(ImageDimension);
-    for (unsigned int j = 0; j < ImageDimension; j++)
+    SizeValueType offset = 0;
+    unsigned int  position = k;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
     {
-      OCparts[i][j] = CoefficientImageType::New();
-      OCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      OCparts[i][j]->Allocate();
-      PCparts[i][j] = CoefficientImageType::New();
-      PCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      PCparts[i][j]->Allocate();
+      offset += clampedOffsets[d][position % 3];
+      position /= 3;
     }
+    offsets[k] = offset;
   }
 
-  /** Create linearity parts. */
-  unsigned int                                      NofLParts = 3 * ImageDimension - 3;
-  std::vector<std::vector<CoefficientImagePointer>> LCparts(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+} // end ComputeStencilOffsets()
+
+
+/**
+ * *********************** ThreadedComputeParts ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ThreadedComputeParts(ThreadIdType threadId,
+                                                                             ThreadIdType numberOfThreads) const
+{
+  const StencilThreaderParameterType & threaderParameters = this->m_StencilThreaderParameters;
+  StencilPerThreadStruct &             threadVariables = this->m_StencilPerThreadVariables[threadId];
+  const bool                           computeDerivative = threaderParameters.st_Derivative != nullptr;
+
+  /** Get the range of grid points of this thread. */
+  const SizeValueType numberOfGridPoints = threaderParameters.st_NumberOfGridPoints;
+  const SizeValueType chunkSize = (numberOfGridPoints + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType begin = std::min<SizeValueType>(threadId * chunkSize, numberOfGridPoints);
+  const SizeValueType end = std::min<SizeValueType>(begin + chunkSize, numberOfGridPoints);
+  SizeValueType       gridIndex[ImageDimension];
+  SizeValueType       remainder = begin;
+  for (unsigned int d = 0; d < ImageDimension; ++d)
+  {
+    gridIndex[d] = remainder % threaderParameters.st_GridSize[d];
+    remainder /= threaderParameters.st_GridSize[d];
+  }
+
+  /** The filters that are needed. The linearity parts are ordered D, E, G, F, H, I. */
+  unsigned int usedFilters[NumberOfFilters];
+  unsigned int numberOfUsedFilters = 0;
+  for (unsigned int f = 0; f < NumberOfFilters; ++f)
   {
-    LCparts[i].resize(NofLParts);
-    for (unsigned int j = 0; j < NofLParts; j++)
+    if (threaderParameters.st_FilterIsUsed[f])
     {
-      LCparts[i][j] = CoefficientImageType::New();
-      LCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      LCparts[i][j]->Allocate();
+      usedFilters[numberOfUsedFilters++] = f;
     }
   }
+  const unsigned int linearityFilters[6] = { 3, 4, 6, 5, 7, 8 };
 
-  /** Create iterators over all parts. */
-  std::vector<std::vector<CoefficientImageIteratorType>> itOCp(ImageDimension);
-  std::vector<std::vector<CoefficientImageIteratorType>> itPCp(ImageDimension);
-  std::vector<std::vector<CoefficientImageIteratorType>> itLCp(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  SizeValueType        offsets[StencilSize];
+  CoefficientPixelType neighborhood[ImageDimension][StencilSize];
+  ScalarType           filtered[NumberOfFilters][ImageDimension];
+  ScalarType *         orthonormalityParts[ImageDimension];
+  ScalarType *         propernessParts[ImageDimension];
+  ScalarType           mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
+  ScalarType           valueOC, valuePC;
+  for (SizeValueType x = begin; x < end; ++x)
   {
-    itOCp[i].resize(ImageDimension);
-    itPCp[i].resize(ImageDimension);
-    itLCp[i].resize(NofLParts);
-    for (unsigned int j = 0; j < ImageDimension; j++)
+    /** Filter the B-spline coefficients in the neighborhood of this grid point. */
+    this->ComputeStencilOffsets(gridIndex, offsets);
+    for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      itOCp[i][j] = CoefficientImageIteratorType(OCparts[i][j], OCparts[i][j]->GetLargestPossibleRegion());
-      itOCp[i][j].GoToBegin();
-      itPCp[i][j] = CoefficientImageIteratorType(PCparts[i][j], PCparts[i][j]->GetLargestPossibleRegion());
-      itPCp[i][j].GoToBegin();
+      for (unsigned int k = 0; k < StencilSize; ++k)
+      {
+        neighborhood[i][k] = threaderParameters.st_Coefficients[i][offsets[k]];
+      }
     }
-    for (unsigned int j = 0; j < NofLParts; j++)
+    for (unsigned int n = 0; n < numberOfUsedFilters; ++n)
     {
-      itLCp[i][j] = CoefficientImageIteratorType(LCparts[i][j], LCparts[i][j]->GetLargestPossibleRegion());
-      itLCp[i][j].GoToBegin();
+      const unsigned int f = usedFilters[n];
+      const ScalarType * weights = threaderParameters.st_FilterWeights[f];
+      for (unsigned int i = 0; i < ImageDimension; i++)
+      {
+        ScalarType sum = NumericTraits<ScalarType>::Zero;
+        for (unsigned int k = 0; k < StencilSize; ++k)
+        {
+          sum += weights[k] * neighborhood[i][k];
+        }
+        filtered[f][i] = sum;
+      }
     }
-  }
 
-  /** TASK 4A:
-   * Do the calculation of the orthonormality subparts.
-   *
-   ************************************************************************* */
+    /** The rigidity coefficient c(x). The derivative parts are multiplied by it. */
+    const ScalarType c = threaderParameters.st_RigidityCoefficients[x];
 
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    ScalarType valueOC;
-    while (!itOCp[0][0].IsAtEnd())
+    /** Copy values: this improves code readability. */
+    if (this->m_CalculateOrthonormalityCondition || this->m_CalculatePropernessCondition)
     {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[0].Get();
-      mu2_A = itA[1].Get();
-      mu1_B = itB[0].Get();
-      mu2_B = itB[1].Get();
+      mu1_A = filtered[0][0];
+      mu2_A = filtered[0][1];
+      mu1_B = filtered[1][0];
+      mu2_B = filtered[1][1];
       if (ImageDimension == 3)
       {
-        mu3_A = itA[2].Get();
-        mu3_B = itB[2].Get();
-        mu1_C = itC[0].Get();
-        mu2_C = itC[1].Get();
-        mu3_C = itC[2].Get();
+        mu3_A = filtered[0][2];
+        mu3_B = filtered[1][2];
+        mu1_C = filtered[2][0];
+        mu2_C = filtered[2][1];
+        mu3_C = filtered[2][2];
+      }
+    }
+
+    /** Orthonormality condition. */
+    if (this->m_CalculateOrthonormalityCondition)
+    {
+      for (unsigned int i = 0; i < ImageDimension && computeDerivative; i++)
+      {
+        orthonormalityParts[i] =
+          this->m_OrthonormalityConditionParts.data() + (x * ImageDimension + i) * ImageDimension;
       }
       if (ImageDimension == 2)
       {
         /** Calculate the value of the orthonormality condition. */
-        this->m_OrthonormalityConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A - 1.0, 2.0) +
-                          std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) - 1.0, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B), 2.0));
+        threadVariables.st_OrthonormalityConditionValue +=
+          c * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A - 1.0, 2.0) +
+               std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) - 1.0, 2.0) +
+               std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B), 2.0));
+      }
+      else if (ImageDimension == 3)
+      {
+        /** Calculate the value of the orthonormality condition. */
+        threadVariables.st_OrthonormalityConditionValue +=
+          c * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A + mu3_A * mu3_A - 1.0, 2.0) +
+               std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B) + mu3_A * mu3_B, 2.0) +
+               std::pow(+(1.0 + mu1_A) * mu1_C + mu2_A * mu2_C + mu3_A * (1.0 + mu3_C), 2.0) +
+               std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) + mu3_B * mu3_B - 1.0, 2.0) +
+               std::pow(+mu1_B * mu1_C + (1.0 + mu2_B) * mu2_C + mu3_B * (1.0 + mu3_C), 2.0) +
+               std::pow(+mu1_C * mu1_C + mu2_C * mu2_C + (1.0 + mu3_C) * (1.0 + mu3_C) - 1.0, 2.0));
+      }
+
+      if (computeDerivative && ImageDimension == 2)
+      {
         /** Calculate the derivative of the orthonormality condition. */
         /** mu1, part 1 */
         valueOC = +2.0 * (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu1_A) + 2.0 * mu2_A * mu2_A * (1.0 + mu1_A) -
                   2.0 * (1.0 + mu1_A) + mu1_B * mu1_B * (1.0 + mu1_A) + mu2_A * (1.0 + mu2_B) * mu1_B;
-        itOCp[0][0].Set(2.0 * valueOC);
+        orthonormalityParts[0][0] = 2.0 * c * valueOC;
         /** mu1, part2*/
         valueOC = +mu1_B * (1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * (1.0 + mu2_B) * (1.0 + mu1_A) +
                   2.0 * mu1_B * mu1_B * mu1_B + 2.0 * mu1_B * (1.0 + mu2_B) * (1.0 + mu2_B) - 2.0 * mu1_B;
-        itOCp[0][1].Set(2.0 * valueOC);
+        orthonormalityParts[0][1] = 2.0 * c * valueOC;
         /** mu2, part 1 */
         valueOC = +2.0 * mu2_A * mu2_A * mu2_A + 2.0 * mu2_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu2_A +
                   mu2_A * (1.0 + mu2_B) * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B);
-        itOCp[1][0].Set(2.0 * valueOC);
+        orthonormalityParts[1][0] = 2.0 * c * valueOC;
         /** mu2, part2*/
         valueOC = +mu2_A * mu2_A * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * mu2_A +
                   2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu2_B) + 2.0 * mu1_B * mu1_B * (1.0 + mu2_B) -
                   2.0 * (1.0 + mu2_B);
-        itOCp[1][1].Set(2.0 * valueOC);
-      } // end if dim == 2
-      else if (ImageDimension == 3)
+        orthonormalityParts[1][1] = 2.0 * c * valueOC;
+      }
+      else if (computeDerivative && ImageDimension == 3)
       {
-        /** Calculate the value of the orthonormality condition. */
-        this->m_OrthonormalityConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A + mu3_A * mu3_A - 1.0, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B) + mu3_A * mu3_B, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_C + mu2_A * mu2_C + mu3_A * (1.0 + mu3_C), 2.0) +
-                          std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) + mu3_B * mu3_B - 1.0, 2.0) +
-                          std::pow(+mu1_B * mu1_C + (1.0 + mu2_B) * mu2_C + mu3_B * (1.0 + mu3_C), 2.0) +
-                          std::pow(+mu1_C * mu1_C + mu2_C * mu2_C + (1.0 + mu3_C) * (1.0 + mu3_C) - 1.0, 2.0));
         /** Calculate the derivative of the orthonormality condition. */
         /** mu1, part 1 */
         valueOC = +2.0 * (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu1_A) + 2.0 * mu2_A * mu2_A * (1.0 + mu1_A) +
                   2.0 * (1.0 + mu1_A) * mu3_A * mu3_A - 2.0 * (1.0 + mu1_A) + mu1_B * mu1_B * (1.0 + mu1_A) +
                   mu2_A * (1.0 + mu2_B) * mu1_B + mu1_B * mu3_A * mu3_B + (1.0 + mu1_A) * mu1_C * mu1_C +
                   mu1_C * mu2_A * mu2_C + mu1_C * mu3_A * (1.0 + mu3_C);
-        itOCp[0][0].Set(2.0 * valueOC);
+        orthonormalityParts[0][0] = 2.0 * c * valueOC;
         /** mu1, part2 */
         valueOC = +(1.0 + mu1_A) * (1.0 + mu1_A) * mu1_B + (1.0 + mu1_A) * mu2_A * mu3_B +
                   (1.0 + mu1_A) * mu3_A * mu3_B + mu1_B * mu1_B * mu1_B + mu1_B * (1.0 + mu2_B) * (1.0 + mu2_B) +
                   mu1_B * mu3_B * mu3_B - mu1_B + mu1_B * mu1_C * mu1_C + mu1_C * (1.0 + mu2_B) * mu2_C +
                   mu1_C * mu3_B * (1.0 + mu3_C);
-        itOCp[0][1].Set(2.0 * valueOC);
+        orthonormalityParts[0][1] = 2.0 * c * valueOC;
         /** mu1, part3 */
         valueOC = +(1.0 + mu1_A) * (1.0 + mu1_A) * mu1_C + (1.0 + mu1_A) * mu2_A * mu2_C +
                   (1.0 + mu1_A) * mu3_A * (1.0 + mu3_C) + mu1_B * mu1_B * mu1_C + mu1_B * (1.0 + mu2_B) * mu2_C +
                   mu1_B * mu3_B * (1.0 + mu3_C) + 2.0 * mu1_C * mu1_C * mu1_C + 2.0 * mu1_C * mu2_C * mu2_C +
                   2.0 * mu1_C * (1.0 + mu3_C) * (1.0 + mu3_C) - 2.0 * mu1_C;
-        itOCp[0][2].Set(2.0 * valueOC);
+        orthonormalityParts[0][2] = 2.0 * c * valueOC;
         /** mu2, part 1 */
         valueOC = +2.0 * mu2_A * mu2_A * mu2_A + 2.0 * mu2_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu2_A +
                   2.0 * mu2_A * mu3_A * mu3_A + mu2_A * (1.0 + mu2_B) * (1.0 + mu2_B) +
                   mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B) + (1.0 + mu2_B) * mu3_A * mu3_B + mu2_A * mu2_C * mu2_C +
                   (1.0 + mu1_A) * mu1_C * mu2_C + mu2_C * mu3_A * (1.0 + mu3_C);
-        itOCp[1][0].Set(2.0 * valueOC);
+        orthonormalityParts[1][0] = 2.0 * c * valueOC;
         /** mu2, part2 */
         valueOC = +mu2_A * mu2_A * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * mu2_A + mu2_A * mu3_A * mu3_B +
                   2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu2_B) + 2.0 * mu1_B * mu1_B * (1.0 + mu2_B) -
                   2.0 * (1.0 + mu2_B) + 2.0 * (1.0 + mu2_B) * mu3_B * mu3_B + (1.0 + mu2_B) * mu2_C * mu2_C +
                   mu1_B * mu1_C * mu2_C + mu2_C * mu3_B * (1.0 + mu3_C);
-        itOCp[1][1].Set(2.0 * valueOC);
+        orthonormalityParts[1][1] = 2.0 * c * valueOC;
         /** mu2, part 3 */
         valueOC = +mu2_A * mu2_A * mu2_C + (1.0 + mu1_A) * mu1_C * mu2_A + mu2_A * mu3_A * (1.0 + mu3_C) +
                   (1.0 + mu2_B) * (1.0 + mu2_B) * mu2_C + mu1_B * mu1_C * mu2_B +
                   (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) + 2.0 * mu2_C * mu2_C * mu2_C + 2.0 * mu1_C * mu1_C * mu2_C +
                   2.0 * mu2_C * (1.0 + mu3_C) * (1.0 + mu3_C) - 2.0 * mu2_C;
-        itOCp[1][2].Set(2.0 * valueOC);
+        orthonormalityParts[1][2] = 2.0 * c * valueOC;
         /** mu3, part 1 */
         valueOC = +2.0 * mu3_A * mu3_A * mu3_A + 2.0 * mu3_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu3_A +
                   2.0 * mu2_A * mu2_A * mu3_A + mu3_A * mu3_B * mu3_B + mu1_B * (1.0 + mu1_A) * mu3_B +
                   (1.0 + mu2_B) * mu2_A * mu3_B + mu3_A * (1.0 + mu3_C) * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * mu1_C * (1.0 + mu3_C) + mu2_C * mu2_A * (1.0 + mu3_C);
-        itOCp[2][0].Set(2.0 * valueOC);
+        orthonormalityParts[2][0] = 2.0 * c * valueOC;
         /** mu3, part2 */
         valueOC = +mu3_A * mu3_A * mu3_B + mu1_B * (1.0 + mu1_A) * mu3_A + mu2_A * mu3_A * (1.0 + mu2_B) +
                   2.0 * mu3_B * mu3_B * mu3_B + 2.0 * mu1_B * mu1_B * mu3_B - 2.0 * mu3_B +
                   2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_B + mu3_B * (1.0 + mu3_C) * (1.0 + mu3_C) +
                   mu1_B * mu1_C * (1.0 + mu3_C) + mu2_C * (1.0 + mu2_B) * (1.0 + mu3_C);
-        itOCp[2][1].Set(2.0 * valueOC);
+        orthonormalityParts[2][1] = 2.0 * c * valueOC;
         /** mu3, part 3 */
         valueOC = +mu3_A * mu3_A * (1.0 + mu3_C) + (1.0 + mu1_A) * mu1_C * mu3_A + mu2_A * mu3_A * mu2_C +
                   mu3_B * mu3_B * (1.0 + mu3_C) + mu1_B * mu1_C * mu3_B + (1.0 + mu2_B) * mu3_B * mu2_C +
                   2.0 * (1.0 + mu3_C) * (1.0 + mu3_C) * (1.0 + mu3_C) + 2.0 * mu1_C * mu1_C * (1.0 + mu3_C) +
                   2.0 * mu2_C * mu2_C * (1.0 + mu3_C) - 2.0 * (1.0 + mu3_C);
-        itOCp[2][2].Set(2.0 * valueOC);
-      } // end if dim == 3
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itA[i];
-        ++itB[i];
-        if (ImageDimension == 3)
-        {
-          ++itC[i];
-        }
-        for (unsigned int j = 0; j < ImageDimension; j++)
-        {
-          ++itOCp[i][j];
-        }
+        orthonormalityParts[2][2] = 2.0 * c * valueOC;
       }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do orthonormality
-
-  /** TASK 4B:
-   * Do the calculation of the properness parts.
-   *
-   ************************************************************************* */
+    } // end if do orthonormality
 
-  /** Reset all iterators. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    itA[i].GoToBegin();
-    itB[i].GoToBegin();
-    if (ImageDimension == 3)
-    {
-      itC[i].GoToBegin();
-    }
-  }
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculatePropernessCondition)
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    ScalarType valuePC;
-    while (!itPCp[0][0].IsAtEnd())
+    /** Properness condition. */
+    if (this->m_CalculatePropernessCondition)
     {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[0].Get();
-      mu2_A = itA[1].Get();
-      mu1_B = itB[0].Get();
-      mu2_B = itB[1].Get();
-      if (ImageDimension == 3)
+      for (unsigned int i = 0; i < ImageDimension && computeDerivative; i++)
       {
-        mu3_A = itA[2].Get();
-        mu3_B = itB[2].Get();
-        mu1_C = itC[0].Get();
-        mu2_C = itC[1].Get();
-        mu3_C = itC[2].Get();
+        propernessParts[i] = this->m_PropernessConditionParts.data() + (x * ImageDimension + i) * ImageDimension;
       }
       if (ImageDimension == 2)
       {
         /** Calculate the value of the properness condition. */
-        this->m_PropernessConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu2_B) - mu2_A * mu1_B - 1.0, 2.0));
+        threadVariables.st_PropernessConditionValue +=
+          c * (std::pow(+(1.0 + mu1_A) * (1.0 + mu2_B) - mu2_A * mu1_B - 1.0, 2.0));
+      }
+      else if (ImageDimension == 3)
+      {
+        /** Calculate the value of the properness condition. */
+        threadVariables.st_PropernessConditionValue +=
+          c * (std::pow(-mu1_C * (1.0 + mu2_B) * mu3_A + mu1_B * mu2_C * mu3_A + mu1_C * mu2_A * mu3_B -
+                          (1.0 + mu1_A) * mu2_C * mu3_B - mu1_B * mu2_A * (1.0 + mu3_C) +
+                          (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) - 1.0,
+                        2.0));
+      }
+
+      if (computeDerivative && ImageDimension == 2)
+      {
         /** Calculate the derivative of the properness condition. */
         /** mu1, part 1 */
         valuePC = +(1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu1_A) - mu2_A * (1.0 + mu2_B) * mu1_B - (1.0 + mu2_B);
-        itPCp[0][0].Set(2.0 * valuePC);
+        propernessParts[0][0] = 2.0 * c * valuePC;
         /** mu1, part 2 */
         valuePC = +mu2_A + mu2_A * mu2_A * mu1_B - mu2_A * (1.0 + mu2_B) * (1.0 + mu1_A);
-        itPCp[0][1].Set(2.0 * valuePC);
+        propernessParts[0][1] = 2.0 * c * valuePC;
         /** mu2, part 1 */
         valuePC = +mu1_B * mu1_B * mu2_A - mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B) + mu1_B;
-        itPCp[1][0].Set(2.0 * valuePC);
+        propernessParts[1][0] = 2.0 * c * valuePC;
         /** mu2, part 2 */
         valuePC = -(1.0 + mu1_A) + (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) - mu1_B * (1.0 + mu1_A) * mu2_A;
-        itPCp[1][1].Set(2.0 * valuePC);
-      } // end if dim == 2
-      else if (ImageDimension == 3)
+        propernessParts[1][1] = 2.0 * c * valuePC;
+      }
+      else if (computeDerivative && ImageDimension == 3)
       {
-        /** Calculate the value of the properness condition. */
-        this->m_PropernessConditionValue +=
-          it_RCI.Get() * (std::pow(-mu1_C * (1.0 + mu2_B) * mu3_A + mu1_B * mu2_C * mu3_A + mu1_C * mu2_A * mu3_B -
-                                     (1.0 + mu1_A) * mu2_C * mu3_B - mu1_B * mu2_A * (1.0 + mu3_C) +
-                                     (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) - 1.0,
-                                   2.0));
         /** Calculate the derivative of the properness condition. */
         /** mu1, part 1 */
         valuePC = +(1.0 + mu1_A) * mu2_C * mu2_C * mu3_B * mu3_B +
@@ -1345,7 +1101,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   mu1_B * mu2_A * mu2_C * mu3_B * (1.0 + mu3_C) -
                   2.0 * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * mu3_B * (1.0 + mu3_C) + mu2_C * mu3_B -
                   mu1_B * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) - (1.0 + mu2_B) * (1.0 + mu3_C);
-        itPCp[0][0].Set(2.0 * valuePC);
+        propernessParts[0][0] = 2.0 * c * valuePC;
         /** mu1, part 2 */
         valuePC = +mu1_B * mu2_C * mu2_C * mu3_A * mu3_A + mu1_B * mu2_A * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) -
                   mu1_C * (1.0 + mu2_B) * mu2_C * mu3_A * mu3_A +
@@ -1355,7 +1111,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   mu1_C * mu2_A * mu2_A * mu3_B * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * mu2_A * mu2_C * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) + mu2_A * (1.0 + mu3_C);
-        itPCp[0][1].Set(2.0 * valuePC);
+        propernessParts[0][1] = 2.0 * c * valuePC;
         /** mu1, part 3 */
         valuePC = +mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A * mu3_A + mu1_C * mu2_A * mu2_A * mu3_B * mu3_B -
                   mu1_B * (1.0 + mu2_B) * mu2_C * mu3_A * mu3_A - 2.0 * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_A * mu3_B +
@@ -1365,7 +1121,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   mu1_B * mu2_A * mu2_C * mu3_A * mu3_B - (1.0 + mu1_A) * mu2_A * mu2_C * mu3_B * mu3_B -
                   mu1_B * mu2_A * mu2_A * mu3_B * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * mu2_A * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) - mu2_A * mu3_B;
-        itPCp[0][2].Set(2.0 * valuePC);
+        propernessParts[0][2] = 2.0 * c * valuePC;
         /** mu2, part 1 */
         valuePC = +mu1_C * mu1_C * mu2_A * mu3_B * mu3_B + mu1_B * mu1_B * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) -
                   mu1_C * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_B +
@@ -1375,7 +1131,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) - mu1_C * mu3_B +
                   (1.0 + mu1_A) * mu1_B * mu2_C * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * mu1_B * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) + mu1_B * (1.0 + mu3_C);
-        itPCp[1][0].Set(2.0 * valuePC);
+        propernessParts[1][0] = 2.0 * c * valuePC;
         /** mu2, part 2 */
         valuePC = +mu1_C * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_A +
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) -
@@ -1386,7 +1142,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * mu1_C * mu2_A * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * mu1_B * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) - (1.0 + mu1_A) * (1.0 + mu3_C);
-        itPCp[1][1].Set(2.0 * valuePC);
+        propernessParts[1][1] = 2.0 * c * valuePC;
         /** mu2, part 3 */
         valuePC = +mu1_B * mu1_B * mu2_C * mu3_A * mu3_A + (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu3_B * mu3_B -
                   mu1_B * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_A +
@@ -1396,7 +1152,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * mu1_C * mu2_A * mu3_B * mu3_B +
                   (1.0 + mu1_A) * mu1_B * mu2_A * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) + (1.0 + mu1_A) * mu3_B;
-        itPCp[1][2].Set(2.0 * valuePC);
+        propernessParts[1][2] = 2.0 * c * valuePC;
         /** mu3, part 1 */
         valuePC = +mu1_C * mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A + mu1_B * mu1_B * mu2_C * mu2_C * mu3_A -
                   2.0 * mu1_B * mu1_C * (1.0 + mu2_B) * mu2_C * mu3_A - mu1_C * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_B +
@@ -1406,7 +1162,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   mu1_B * mu1_C * mu2_A * mu2_C * mu3_B - (1.0 + mu1_A) * mu1_B * mu2_C * mu2_C * mu3_B -
                   mu1_B * mu1_B * mu2_A * mu2_C * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * mu1_B * (1.0 + mu2_B) * mu2_C * (1.0 + mu3_C) + mu1_B * mu2_C;
-        itPCp[2][0].Set(2.0 * valuePC);
+        propernessParts[2][0] = 2.0 * c * valuePC;
         /** mu3, part 2 */
         valuePC = +mu1_C * mu1_C * mu2_A * mu2_A * mu3_B + (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu2_C * mu3_B -
                   mu1_C * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_A +
@@ -1416,7 +1172,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * mu1_C * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) - mu1_C * mu2_A +
                   (1.0 + mu1_A) * mu1_B * mu2_A * mu2_C * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * (1.0 + mu3_C) + (1.0 + mu1_A) * mu2_C;
-        itPCp[2][1].Set(2.0 * valuePC);
+        propernessParts[2][1] = 2.0 * c * valuePC;
         /** mu3, part 3 */
         valuePC = +mu1_B * mu1_B * mu2_A * mu2_A * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu3_C) +
@@ -1428,445 +1184,145 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * mu3_B -
                   2.0 * (1.0 + mu1_A) * mu1_B * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) + mu1_B * mu2_A -
                   (1.0 + mu1_A) * (1.0 + mu2_B);
-        itPCp[2][2].Set(2.0 * valuePC);
-      } // end if dim == 3
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itA[i];
-        ++itB[i];
-        if (ImageDimension == 3)
-        {
-          ++itC[i];
-        }
-        for (unsigned int j = 0; j < ImageDimension; j++)
-        {
-          ++itPCp[i][j];
-        }
+        propernessParts[2][2] = 2.0 * c * valuePC;
       }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 4C:
-   * Do the calculation of the linearity parts.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
+    } // end if do properness
 
-  if (this->m_CalculateLinearityCondition)
-  {
-    while (!itLCp[0][0].IsAtEnd())
+    /** Linearity condition. */
+    if (this->m_CalculateLinearityCondition)
     {
-      /** Linearity condition part. */
       for (unsigned int i = 0; i < ImageDimension; i++)
       {
-        /** Calculate the value of the linearity condition. */
-        this->m_LinearityConditionValue +=
-          it_RCI.Get() * (+itD[i].Get() * itD[i].Get() + itE[i].Get() * itE[i].Get() + itG[i].Get() * itG[i].Get());
-        if (ImageDimension == 3)
+        ScalarType * linearityParts =
+          computeDerivative
+            ? this->m_LinearityConditionParts.data() + (x * ImageDimension + i) * NumberOfLinearityParts
+            : nullptr;
+        for (unsigned int j = 0; j < NumberOfLinearityParts; j++)
         {
-          this->m_LinearityConditionValue +=
-            it_RCI.Get() * (+itF[i].Get() * itF[i].Get() + itH[i].Get() * itH[i].Get() + itI[i].Get() * itI[i].Get());
-        }
-      } // end loop over i
+          const ScalarType filteredValue = filtered[linearityFilters[j]][i];
 
-      /** Calculate the derivative of the linearity condition. */
-      if (ImageDimension == 2)
-      {
-        itLCp[0][0].Set(2.0 * itD[0].Get());
-        itLCp[0][1].Set(2.0 * itE[0].Get());
-        itLCp[0][2].Set(2.0 * itG[0].Get());
-        itLCp[1][0].Set(2.0 * itD[1].Get());
-        itLCp[1][1].Set(2.0 * itE[1].Get());
-        itLCp[1][2].Set(2.0 * itG[1].Get());
-      } // end if dim == 2
-      else if (ImageDimension == 3)
-      {
-        itLCp[0][0].Set(2.0 * itD[0].Get());
-        itLCp[0][1].Set(2.0 * itE[0].Get());
-        itLCp[0][2].Set(2.0 * itG[0].Get());
-        itLCp[0][3].Set(2.0 * itF[0].Get());
-        itLCp[0][4].Set(2.0 * itH[0].Get());
-        itLCp[0][5].Set(2.0 * itI[0].Get());
-        itLCp[1][0].Set(2.0 * itD[1].Get());
-        itLCp[1][1].Set(2.0 * itE[1].Get());
-        itLCp[1][2].Set(2.0 * itG[1].Get());
-        itLCp[1][3].Set(2.0 * itF[1].Get());
-        itLCp[1][4].Set(2.0 * itH[1].Get());
-        itLCp[1][5].Set(2.0 * itI[1].Get());
-        itLCp[2][0].Set(2.0 * itD[2].Get());
-        itLCp[2][1].Set(2.0 * itE[2].Get());
-        itLCp[2][2].Set(2.0 * itG[2].Get());
-        itLCp[2][3].Set(2.0 * itF[2].Get());
-        itLCp[2][4].Set(2.0 * itH[2].Get());
-        itLCp[2][5].Set(2.0 * itI[2].Get());
-      } // end if dim == 3
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itD[i];
-        ++itE[i];
-        ++itG[i];
-        if (ImageDimension == 3)
-        {
-          ++itF[i];
-          ++itH[i];
-          ++itI[i];
-        }
-        for (unsigned int j = 0; j < NofLParts; j++)
-        {
-          ++itLCp[i][j];
+          /** Calculate the value of the linearity condition. */
+          threadVariables.st_LinearityConditionValue += c * filteredValue * filteredValue;
+
+          /** Calculate the derivative of the linearity condition. */
+          if (computeDerivative)
+          {
+            linearityParts[j] = 2.0 * c * filteredValue;
+          }
         }
       }
-      ++it_RCI;
+    } // end if do linearity
 
-    } // end while
-  }   // end if do linearity
+    /** Go to the next grid point. */
+    for (unsigned int d = 0; d < ImageDimension && ++gridIndex[d] == threaderParameters.st_GridSize[d]; ++d)
+    {
+      gridIndex[d] = 0;
+    }
+  } // end for loop over the grid points
 
-  /** TASK 5:
-   * Do the actual calculation of the rigidity penalty term value.
-   *
-   ************************************************************************* */
+} // end ThreadedComputeParts()
 
-  /** Calculate the rigidity penalty term value. */
-  if (this->m_CalculateLinearityCondition)
-  {
-    this->m_LinearityConditionValue /= rigidityCoefficientSum;
-  }
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
-  }
-  if (this->m_CalculatePropernessCondition)
-  {
-    this->m_PropernessConditionValue /= rigidityCoefficientSum;
-  }
 
-  if (this->m_UseLinearityCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
-  }
-  if (this->m_UseOrthonormalityCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
-  }
-  if (this->m_UsePropernessCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
-  }
-  value = this->m_RigidityPenaltyTermValue;
+/**
+ * *********************** ThreadedComputeDerivative ****************
+ */
 
-  /** TASK 6:
-   * Create filtered versions of the subparts.
-   * Create all necessary iterators and operators.
-   ************************************************************************* */
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ThreadedComputeDerivative(ThreadIdType threadId,
+                                                                                  ThreadIdType numberOfThreads) const
+{
+  const StencilThreaderParameterType & threaderParameters = this->m_StencilThreaderParameters;
+  StencilPerThreadStruct &             threadVariables = this->m_StencilPerThreadVariables[threadId];
 
-  /** Create filtered orthonormality, properness and linearity parts. */
-  std::vector<CoefficientImagePointer> OCpartsF(ImageDimension);
-  std::vector<CoefficientImagePointer> PCpartsF(ImageDimension);
-  std::vector<CoefficientImagePointer> LCpartsF(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  /** Get the range of grid points of this thread. */
+  const SizeValueType numberOfGridPoints = threaderParameters.st_NumberOfGridPoints;
+  const SizeValueType chunkSize = (numberOfGridPoints + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType begin = std::min<SizeValueType>(threadId * chunkSize, numberOfGridPoints);
+  const SizeValueType end = std::min<SizeValueType>(begin + chunkSize, numberOfGridPoints);
+  SizeValueType       gridIndex[ImageDimension];
+  SizeValueType       remainder = begin;
+  for (unsigned int d = 0; d < ImageDimension; ++d)
   {
-    OCpartsF[i] = CoefficientImageType::New();
-    OCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    OCpartsF[i]->Allocate();
-    PCpartsF[i] = CoefficientImageType::New();
-    PCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    PCpartsF[i]->Allocate();
-    LCpartsF[i] = CoefficientImageType::New();
-    LCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    LCpartsF[i]->Allocate();
-  }
-
-  /** Create neighborhood iterators over the subparts. */
-  std::vector<std::vector<NeighborhoodIteratorType>> nitOCp(ImageDimension);
-  std::vector<std::vector<NeighborhoodIteratorType>> nitPCp(ImageDimension);
-  std::vector<std::vector<NeighborhoodIteratorType>> nitLCp(ImageDimension);
-  RadiusType                                         radius;
-  radius.Fill(1);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    nitOCp[i].resize(ImageDimension);
-    nitPCp[i].resize(ImageDimension);
-    nitLCp[i].resize(NofLParts);
-    for (unsigned int j = 0; j < ImageDimension; j++)
-    {
-      nitOCp[i][j] = NeighborhoodIteratorType(radius, OCparts[i][j], OCparts[i][j]->GetLargestPossibleRegion());
-      nitOCp[i][j].GoToBegin();
-      nitPCp[i][j] = NeighborhoodIteratorType(radius, PCparts[i][j], PCparts[i][j]->GetLargestPossibleRegion());
-      nitPCp[i][j].GoToBegin();
-    }
-    for (unsigned int j = 0; j < NofLParts; j++)
-    {
-      nitLCp[i][j] = NeighborhoodIteratorType(radius, LCparts[i][j], LCparts[i][j]->GetLargestPossibleRegion());
-      nitLCp[i][j].GoToBegin();
-    }
+    gridIndex[d] = remainder % threaderParameters.st_GridSize[d];
+    remainder /= threaderParameters.st_GridSize[d];
   }
 
-  /** Create iterators over the filtered parts. */
-  std::vector<CoefficientImageIteratorType> itOCpf(ImageDimension);
-  std::vector<CoefficientImageIteratorType> itPCpf(ImageDimension);
-  std::vector<CoefficientImageIteratorType> itLCpf(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  /** The stencils of the derivative. The linearity parts are ordered D, E, G, F, H, I. */
+  const ScalarType * firstOrderWeights[ImageDimension];
+  const ScalarType * linearityWeights[NumberOfLinearityParts];
+  const unsigned int linearityFilters[6] = { 3, 4, 6, 5, 7, 8 };
+  for (unsigned int j = 0; j < ImageDimension; j++)
   {
-    itOCpf[i] = CoefficientImageIteratorType(OCpartsF[i], OCpartsF[i]->GetLargestPossibleRegion());
-    itOCpf[i].GoToBegin();
-    itPCpf[i] = CoefficientImageIteratorType(PCpartsF[i], PCpartsF[i]->GetLargestPossibleRegion());
-    itPCpf[i].GoToBegin();
-    itLCpf[i] = CoefficientImageIteratorType(LCpartsF[i], LCpartsF[i]->GetLargestPossibleRegion());
-    itLCpf[i].GoToBegin();
+    firstOrderWeights[j] = threaderParameters.st_DerivativeWeights[j];
   }
-
-  /** Create a neigborhood iterator over the rigidity image. */
-  NeighborhoodIteratorType nit_RCI(
-    radius, this->m_RigidityCoefficientImage, this->m_RigidityCoefficientImage->GetLargestPossibleRegion());
-  nit_RCI.GoToBegin();
-  unsigned int neighborhoodSize = nit_RCI.Size();
-
-  /** Create ND operators. */
-  NeighborhoodType Operator_A, Operator_B, Operator_C, Operator_D, Operator_E, Operator_F, Operator_G, Operator_H,
-    Operator_I;
-  this->CreateNDOperator(Operator_A, "FA", spacing);
-  this->CreateNDOperator(Operator_B, "FB", spacing);
-  if (ImageDimension == 3)
+  for (unsigned int j = 0; j < NumberOfLinearityParts; j++)
   {
-    this->CreateNDOperator(Operator_C, "FC", spacing);
+    linearityWeights[j] = threaderParameters.st_DerivativeWeights[linearityFilters[j]];
   }
 
-  if (this->m_CalculateLinearityCondition)
+  const ScalarType * orthonormalityParts = this->m_OrthonormalityConditionParts.data();
+  const ScalarType * propernessParts = this->m_PropernessConditionParts.data();
+  const ScalarType * linearityParts = this->m_LinearityConditionParts.data();
+  const ScalarType   rigidityCoefficientSum = threaderParameters.st_RigidityCoefficientSum;
+  SizeValueType      offsets[StencilSize];
+  for (SizeValueType x = begin; x < end; ++x)
   {
-    this->CreateNDOperator(Operator_D, "FD", spacing);
-    this->CreateNDOperator(Operator_E, "FE", spacing);
-    this->CreateNDOperator(Operator_G, "FG", spacing);
-    if (ImageDimension == 3)
-    {
-      this->CreateNDOperator(Operator_F, "FF", spacing);
-      this->CreateNDOperator(Operator_H, "FH", spacing);
-      this->CreateNDOperator(Operator_I, "FI", spacing);
-    }
-  }
+    this->ComputeStencilOffsets(gridIndex, offsets);
 
-  /** TASK 7A:
-   * Calculate the filtered versions of the orthonormality subparts.
-   * These are F_A * {subpart_0} + F_B * {subpart_1},
-   * and (for 3D) + F_C * {subpart_2}, for all dimensions.
-   ************************************************************************* */
-
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    while (!itOCpf[0].IsAtEnd())
+    for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
-
-      /** Loop over all dimensions. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
+      /** Filter the parts of the orthonormality, properness and linearity conditions.
+       * These are F_A * {subpart_0} + F_B * {subpart_1}, and (for 3D) + F_C * {subpart_2},
+       * and sum_{j=1}^{NofLParts} F_{D,E,G,F,H,I} * {subpart_j}.
+       */
+      ScalarType filteredOC = NumericTraits<ScalarType>::Zero;
+      ScalarType filteredPC = NumericTraits<ScalarType>::Zero;
+      ScalarType filteredLC = NumericTraits<ScalarType>::Zero;
+      if (this->m_CalculateOrthonormalityCondition)
       {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
+        for (unsigned int k = 0; k < StencilSize; ++k)
         {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_A.GetElement(k)   // FA *
-                    * nitOCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_B.GetElement(k)   // FB *
-                    * nitOCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
+          const ScalarType * parts = orthonormalityParts + (offsets[k] * ImageDimension + i) * ImageDimension;
+          for (unsigned int j = 0; j < ImageDimension; j++)
           {
-            tmp[i] += Operator_C.GetElement(k)   // FC *
-                      * nitOCp[i][2].GetPixel(k) // subpart[ i ][ 2 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
+            filteredOC += firstOrderWeights[j][k] * parts[j];
           }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itOCpf[i].Set(tmp[i]);
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itOCpf[i];
-        for (unsigned int j = 0; j < ImageDimension; j++)
-        {
-          ++nitOCp[i][j];
         }
       }
-    } // end while
-  }   // end if do orthonormality
-
-  /** TASK 7B:
-   * Calculate the filtered versions of the properness subparts.
-   * These are F_A * {subpart_0} + F_B * {subpart_1},
-   * and (for 3D) + F_C * {subpart_2}, for all dimensions.
-   ************************************************************************* */
-
-  nit_RCI.GoToBegin();
-  if (this->m_CalculatePropernessCondition)
-  {
-    while (!itPCpf[0].IsAtEnd())
-    {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
-
-      /** Loop over all dimensions. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
+      if (this->m_CalculatePropernessCondition)
       {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
+        for (unsigned int k = 0; k < StencilSize; ++k)
         {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_A.GetElement(k)   // FA *
-                    * nitPCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_B.GetElement(k)   // FB *
-                    * nitPCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
+          const ScalarType * parts = propernessParts + (offsets[k] * ImageDimension + i) * ImageDimension;
+          for (unsigned int j = 0; j < ImageDimension; j++)
           {
-            tmp[i] += Operator_C.GetElement(k)   // FC *
-                      * nitPCp[i][2].GetPixel(k) // subpart[ i ][ 2 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
+            filteredPC += firstOrderWeights[j][k] * parts[j];
           }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itPCpf[i].Set(tmp[i]);
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itPCpf[i];
-        for (unsigned int j = 0; j < ImageDimension; j++)
-        {
-          ++nitPCp[i][j];
         }
       }
-    } // end while
-  }   // end if do properness
-
-  /** TASK 7C:
-   * Calculate the filtered versions of the linearity subparts.
-   * These are sum_{i=1}^{NofLParts} F_{D,E,G,F,H,I} * {subpart_i}.
-   ************************************************************************* */
-
-  nit_RCI.GoToBegin();
-  if (this->m_CalculateLinearityCondition)
-  {
-    while (!itLCpf[0].IsAtEnd())
-    {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
-
-      /** Loop over all dimensions. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
+      if (this->m_CalculateLinearityCondition)
       {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
+        for (unsigned int k = 0; k < StencilSize; ++k)
         {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_D.GetElement(k)   // FD *
-                    * nitLCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_E.GetElement(k)   // FE *
-                    * nitLCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_G.GetElement(k)   // FG *
-                    * nitLCp[i][2].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
+          const ScalarType * parts = linearityParts + (offsets[k] * ImageDimension + i) * NumberOfLinearityParts;
+          for (unsigned int j = 0; j < NumberOfLinearityParts; j++)
           {
-            tmp[i] += Operator_F.GetElement(k)   // FF *
-                      * nitLCp[i][3].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-            tmp[i] += Operator_H.GetElement(k)   // FH *
-                      * nitLCp[i][4].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-            tmp[i] += Operator_I.GetElement(k)   // FI *
-                      * nitLCp[i][5].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
+            filteredLC += linearityWeights[j][k] * parts[j];
           }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itLCpf[i].Set(tmp[i]);
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itLCpf[i];
-        for (unsigned int j = 0; j < NofLParts; j++)
-        {
-          ++nitLCp[i][j];
         }
       }
-    } // end while
-  }   // end if do linearity
 
-  /** TASK 8:
-   * Add it all to create the final derivative images.
-   ************************************************************************* */
+      /** Add it all to create the derivative. */
+      // NOTE: unlike the values, for the derivatives weight * derivative is returned.
+      const ScalarType tmpLC = this->m_LinearityConditionWeight * filteredLC;
+      const ScalarType tmpOC = this->m_OrthonormalityConditionWeight * filteredOC;
+      const ScalarType tmpPC = this->m_PropernessConditionWeight * filteredPC;
+      threadVariables.st_LinearityConditionGradientMagnitude += tmpLC * tmpLC;
+      threadVariables.st_OrthonormalityConditionGradientMagnitude += tmpOC * tmpOC;
+      threadVariables.st_PropernessConditionGradientMagnitude += tmpPC * tmpPC;
 
-  /** Create derivative images, each holding a component of the vector field. */
-  std::vector<CoefficientImagePointer> derivativeImages(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    derivativeImages[i] = CoefficientImageType::New();
-    derivativeImages[i]->SetRegions(inputImages[i]->GetLargestPossibleRegion());
-    derivativeImages[i]->Allocate();
-  }
-
-  /** Create iterators over the derivative images. */
-  std::vector<CoefficientImageIteratorType> itDIs(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    itDIs[i] = CoefficientImageIteratorType(derivativeImages[i], derivativeImages[i]->GetLargestPossibleRegion());
-    itDIs[i].GoToBegin();
-    itOCpf[i].GoToBegin();
-    itPCpf[i].GoToBegin();
-    itLCpf[i].GoToBegin();
-  }
-
-  /** Do the addition. */
-  // NOTE: unlike the values, for the derivatives weight * derivative is returned.
-  MeasureType gradMagLC = NumericTraits<MeasureType>::Zero;
-  MeasureType gradMagOC = NumericTraits<MeasureType>::Zero;
-  MeasureType gradMagPC = NumericTraits<MeasureType>::Zero;
-  double      rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
-  while (!itDIs[0].IsAtEnd())
-  {
-    for (unsigned int i = 0; i < ImageDimension; i++)
-    {
       ScalarType tmpDIs = NumericTraits<ScalarType>::Zero;
-
-      /** Compute gradient magnitude of LC. */
-      ScalarType tmpLC = this->m_LinearityConditionWeight * itLCpf[i].Get();
-      gradMagLC += tmpLC * tmpLC / rigidityCoefficientSumSqr;
-
-      /** Compute gradient magnitude of OC. */
-      ScalarType tmpOC = this->m_OrthonormalityConditionWeight * itOCpf[i].Get();
-      gradMagOC += tmpOC * tmpOC / rigidityCoefficientSumSqr;
-
-      /** Compute gradient magnitude of PC. */
-      ScalarType tmpPC = this->m_PropernessConditionWeight * itPCpf[i].Get();
-      gradMagPC += tmpPC * tmpPC / rigidityCoefficientSumSqr;
-
-      /** Compute derivative contribution. */
       if (this->m_UseLinearityCondition)
       {
         tmpDIs += tmpLC;
@@ -1879,35 +1335,17 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
       {
         tmpDIs += tmpPC;
       }
-      itDIs[i].Set(tmpDIs);
-
-      /** Update iterators. */
-      ++itDIs[i];
-      ++itOCpf[i];
-      ++itPCpf[i];
-      ++itLCpf[i];
+      threaderParameters.st_Derivative[i * numberOfGridPoints + x] = tmpDIs / rigidityCoefficientSum;
     }
-  } // end while
-
-  /** Set the gradient magnitudes of the several terms. */
-  this->m_LinearityConditionGradientMagnitude = std::sqrt(gradMagLC);
-  this->m_OrthonormalityConditionGradientMagnitude = std::sqrt(gradMagOC);
-  this->m_PropernessConditionGradientMagnitude = std::sqrt(gradMagPC);
 
-  /** Rearrange to create a derivative. */
-  unsigned int j = 0;
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    itDIs[i].GoToBegin();
-    while (!itDIs[i].IsAtEnd())
+    /** Go to the next grid point. */
+    for (unsigned int d = 0; d < ImageDimension && ++gridIndex[d] == threaderParameters.st_GridSize[d]; ++d)
     {
-      derivative[j] = itDIs[i].Get() / rigidityCoefficientSum;
-      ++itDIs[i];
-      j++;
-    } // end while
-  }   // end for
+      gridIndex[d] = 0;
+    }
+  } // end for loop over the grid points
 
-} // end GetValueAndDerivative()
+} // end ThreadedComputeDerivative()
 
 
 /**
@@ -2157,40 +1595,6 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::Create1DOperator(
 } // end Create1DOperator()
 
 
-/**
- * ************************** FilterSeparable ********************
- */
-
-template <class TFixedImage, class TScalarType>
-typename TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::CoefficientImagePointer
-TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FilterSeparable(
-  const CoefficientImageType *          image,
-  const std::vector<NeighborhoodType> & Operators) const
-{
-  /** Create filters, supply them with boundary conditions and operators. */
-  std::vector<typename NOIFType::Pointer> filters(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    filters[i] = NOIFType::New();
-    filters[i]->SetOperator(Operators[i]);
-  }
-
-  /** Set up the mini-pipline. */
-  filters[0]->SetInput(image);
-  for (unsigned int i = 1; i < ImageDimension; i++)
-  {
-    filters[i]->SetInput(filters[i - 1]->GetOutput());
-  }
-
-  /** Execute the mini-pipeline. */
-  filters[ImageDimension - 1]->Update();
-
-  /** Return the filtered image. */
-  return filters[ImageDimension - 1]->GetOutput();
-
-} // end FilterSeparable()
-
-
 /**
  * ************************ CreateNDOperator *********************
  */
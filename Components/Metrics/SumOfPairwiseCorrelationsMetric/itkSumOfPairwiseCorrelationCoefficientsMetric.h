@@ -24,6 +24,7 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkExtractImageFilter.h"
+#include "itkCovarianceAccumulator.h"
 
 using namespace std;
 
@@ -94,6 +95,13 @@ public:
   typedef typename Superclass::FixedImageLimiterOutputType     FixedImageLimiterOutputType;
   typedef typename Superclass::MovingImageLimiterOutputType    MovingImageLimiterOutputType;
   typedef typename Superclass::MovingImageDerivativeScalesType MovingImageDerivativeScalesType;
+  typedef typename DerivativeType::ValueType                   DerivativeValueType;
+  typedef typename Superclass::ThreaderType                    ThreaderType;
+  typedef typename Superclass::ThreadInfoType                  ThreadInfoType;
+
+  typedef vnl_matrix<RealType>            MatrixType;
+  typedef vnl_matrix<DerivativeValueType> DerivativeMatrixType;
+  typedef CovarianceAccumulator<RealType> CovarianceAccumulatorType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -102,6 +110,9 @@ public:
   itkStaticConstMacro(MovingImageDimension, unsigned int, MovingImageType::ImageDimension);
 
   /** Get the value for single valued optimizers. */
+  MeasureType
+  GetValueSingleThreaded(const TransformParametersType & parameters) const;
+
   MeasureType
   GetValue(const TransformParametersType & parameters) const override;
 
@@ -110,6 +121,11 @@ public:
   GetDerivative(const TransformParametersType & parameters, DerivativeType & derivative) const override;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void
+  GetValueAndDerivativeSingleThreaded(const TransformParametersType & parameters,
+                                      MeasureType &                   Value,
+                                      DerivativeType &                Derivative) const;
+
   void
   GetValueAndDerivative(const TransformParametersType & parameters,
                         MeasureType &                   Value,
@@ -124,7 +140,7 @@ public:
 
 protected:
   SumOfPairwiseCorrelationCoefficientsMetric();
-  ~SumOfPairwiseCorrelationCoefficientsMetric() override = default;
+  ~SumOfPairwiseCorrelationCoefficientsMetric() override;
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
@@ -152,6 +168,72 @@ protected:
                                         const MovingImageDerivativeType & movingImageDerivative,
                                         DerivativeType &                  imageJacobian) const override;
 
+  struct CorrelationMultiThreaderParameterType
+  {
+    Self * m_Metric;
+  };
+
+  CorrelationMultiThreaderParameterType m_CorrelationThreaderParameters;
+
+  struct CorrelationGetSamplesPerThreadStruct
+  {
+    SizeValueType                    st_NumberOfPixelsCounted;
+    MatrixType                       st_DataBlock;
+    std::vector<FixedImagePointType> st_ApprovedSamples;
+    CovarianceAccumulatorType        st_Covariance;
+    DerivativeType                   st_Derivative;
+  };
+
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
+               CorrelationGetSamplesPerThreadStruct,
+               PaddedCorrelationGetSamplesPerThreadStruct);
+
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
+                    PaddedCorrelationGetSamplesPerThreadStruct,
+                    AlignedCorrelationGetSamplesPerThreadStruct);
+
+  mutable AlignedCorrelationGetSamplesPerThreadStruct * m_CorrelationGetSamplesPerThreadVariables;
+  mutable ThreadIdType                                  m_CorrelationGetSamplesPerThreadVariablesSize;
+
+  /** Sample the stack for the samples of each thread, and accumulate their covariance. */
+  inline void
+  ThreadedGetSamples(ThreadIdType threadID);
+
+  /** Compute the derivative contributions of the approved samples of each thread. */
+  inline void
+  ThreadedComputeDerivative(ThreadIdType threadID);
+
+  /** Combine the samples of all threads into the value, and, if requested,
+   * into the terms that are needed by ThreadedComputeDerivative().
+   */
+  inline void
+  AfterThreadedGetSamples(MeasureType & value, const bool computeDerivativeTerms) const;
+
+  /** Gather the derivatives from all threads. */
+  inline void
+  AfterThreadedComputeDerivative(DerivativeType & derivative) const;
+
+  /** Helper functions to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  GetSamplesThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeThreaderCallback(void * arg);
+
+  void
+  LaunchGetSamplesThreaderCallback(void) const;
+
+  void
+  LaunchComputeDerivativeThreaderCallback(void) const;
+
+  /** Initialize some multi-threading related parameters. */
+  void
+  InitializeThreadingParameters(void) const override;
+
+  /** Subtract the mean over the last dimension from the derivative elements. */
+  void
+  SubtractMeanFromDerivative(DerivativeType & derivative) const;
+
 private:
   SumOfPairwiseCorrelationCoefficientsMetric(const Self &) = delete;
   void
@@ -173,6 +255,18 @@ private:
 
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
+
+  /** Size of the last dimension. */
+  unsigned int m_G;
+
+  /** Intermediate results of AfterThreadedGetSamples, needed for the derivative calculation. */
+  mutable std::vector<unsigned int>       m_PixelStartIndex;
+  mutable MatrixType                      m_Atmm;
+  mutable DerivativeMatrixType            m_KAtZscore;
+  mutable vnl_vector<DerivativeValueType> m_S;
+  mutable vnl_vector<DerivativeValueType> m_dSdmu_part1;
+  mutable vnl_vector<DerivativeValueType> m_KAtZscoreAmmDiagonal;
+  mutable DerivativeValueType             m_DerivativeNormalization;
 };
 
 } // end namespace itk
@@ -20,7 +20,6 @@
 
 #include "itkSumOfPairwiseCorrelationCoefficientsMetric.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkImage.h"
 #include <numeric>
@@ -35,13 +34,32 @@ template <class TFixedImage, class TMovingImage>
 SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::SumOfPairwiseCorrelationCoefficientsMetric()
   : m_SubtractMean(true)
   , m_TransformIsStackTransform(true)
+  , m_G(0)
 {
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+
+  // Multi-threading structs
+  this->m_CorrelationGetSamplesPerThreadVariables = nullptr;
+  this->m_CorrelationGetSamplesPerThreadVariablesSize = 0;
+
+  /** Initialize the m_CorrelationThreaderParameters. */
+  this->m_CorrelationThreaderParameters.m_Metric = this;
 } // end constructor
 
 
+/**
+ * ******************* Destructor *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::~SumOfPairwiseCorrelationCoefficientsMetric()
+{
+  delete[] this->m_CorrelationGetSamplesPerThreadVariables;
+} // end Destructor
+
+
 /**
  * ******************* Initialize *******************
  */
@@ -52,6 +70,10 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::Initializ
 {
   /** Initialize transform, interpolator, etc. */
   Superclass::Initialize();
+
+  /** Retrieve the size of the slowest varying dimension. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  this->m_G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
 } // end Initialize()
 
 
@@ -80,9 +102,8 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::SampleRan
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator =
-    Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+  /** Get the random number generator. */
+  Statistics::MersenneTwisterRandomVariateGenerator * randomGenerator = this->m_RandomGenerator;
 
   /** Sample additional at fixed timepoint. */
   for (unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i)
@@ -136,12 +157,93 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::EvaluateT
 
 
 /**
- * ******************* GetValue *******************
+ * ******************* SubtractMeanFromDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::SubtractMeanFromDerivative(
+  DerivativeType & derivative) const
+{
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+
+  if (this->m_SubtractMean)
+  {
+    if (!this->m_TransformIsStackTransform)
+    {
+      /** Update derivative per dimension.
+       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
+       * per dimension xyz.
+       */
+      const unsigned int lastDimGridSize = this->m_GridSize[lastDim];
+      const unsigned int numParametersPerDimension =
+        this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
+      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
+      DerivativeType     mean(numControlPointsPerDimension);
+      for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
+      {
+        /** Compute mean per dimension. */
+        mean.Fill(0.0);
+        const unsigned int starti = numParametersPerDimension * d;
+        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
+        {
+          const unsigned int index = i % numControlPointsPerDimension;
+          mean[index] += derivative[i];
+        }
+        mean /= static_cast<double>(lastDimGridSize);
+
+        /** Update derivative for every control point per dimension. */
+        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
+        {
+          const unsigned int index = i % numControlPointsPerDimension;
+          derivative[i] -= mean[index];
+        }
+      }
+    }
+    else
+    {
+      /** Update derivative per dimension.
+       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
+       * the number the time point index.
+       */
+      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / this->m_G;
+      DerivativeType     mean(numParametersPerLastDimension);
+      mean.Fill(0.0);
+
+      /** Compute mean per control point. */
+      for (unsigned int t = 0; t < this->m_G; ++t)
+      {
+        const unsigned int startc = numParametersPerLastDimension * t;
+        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+        {
+          const unsigned int index = c % numParametersPerLastDimension;
+          mean[index] += derivative[c];
+        }
+      }
+      mean /= static_cast<double>(this->m_G);
+
+      /** Update derivative per control point. */
+      for (unsigned int t = 0; t < this->m_G; ++t)
+      {
+        const unsigned int startc = numParametersPerLastDimension * t;
+        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+        {
+          const unsigned int index = c % numParametersPerLastDimension;
+          derivative[c] -= mean[index];
+        }
+      }
+    }
+  }
+} // end SubtractMeanFromDerivative()
+
+
+/**
+ * ******************* GetValueSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 typename SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::MeasureType
-SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValue(
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueSingleThreaded(
   const TransformParametersType & parameters) const
 {
   itkDebugMacro("GetValue( " << parameters << " ) ");
@@ -279,7 +381,7 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValue(
   /** Return the measure value. */
   return measure;
 
-} // end GetValue()
+} // end GetValueSingleThreaded()
 
 
 /**
@@ -305,12 +407,12 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetDeriva
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
-SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(
   const TransformParametersType & parameters,
   MeasureType &                   value,
   DerivativeType &                derivative) const
@@ -534,78 +636,499 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueA
   measure = RealType(1.0 - (K.fro_norm() / RealType(G)));
 
   /** Subtract mean from derivative elements. */
-  if (this->m_SubtractMean)
+  this->SubtractMeanFromDerivative(derivative);
+
+  /** Return the measure value. */
+  value = measure;
+
+} // end GetValueAndDerivativeSingleThreaded()
+
+/**
+ * ********************* InitializeThreadingParameters ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::InitializeThreadingParameters(void) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_CorrelationGetSamplesPerThreadVariablesSize != numberOfThreads)
   {
-    if (!this->m_TransformIsStackTransform)
+    delete[] this->m_CorrelationGetSamplesPerThreadVariables;
+    this->m_CorrelationGetSamplesPerThreadVariables = new AlignedCorrelationGetSamplesPerThreadStruct[numberOfThreads];
+    this->m_CorrelationGetSamplesPerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. The derivatives are filled in each thread. */
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_CorrelationGetSamplesPerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
+    this->m_CorrelationGetSamplesPerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
+  }
+
+  this->m_PixelStartIndex.resize(numberOfThreads);
+
+} // end InitializeThreadingParameters()
+
+
+/**
+ * ******************* GetValue *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+typename SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::MeasureType
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValue(
+  const TransformParametersType & parameters) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->GetValueSingleThreaded(parameters);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  this->InitializeThreadingParameters();
+
+  /** Launch multi-threading GetSamples */
+  this->LaunchGetSamplesThreaderCallback();
+
+  /** Combine the samples of all threads into the metric value. */
+  MeasureType value = NumericTraits<MeasureType>::Zero;
+  this->AfterThreadedGetSamples(value, false);
+
+  return value;
+
+} // end GetValue()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+  const TransformParametersType & parameters,
+  MeasureType &                   value,
+  DerivativeType &                derivative) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->GetValueAndDerivativeSingleThreaded(parameters, value, derivative);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  this->InitializeThreadingParameters();
+
+  /** Launch multi-threading GetSamples */
+  this->LaunchGetSamplesThreaderCallback();
+
+  /** Get the metric value and the derivative terms from the samples of all threads. */
+  this->AfterThreadedGetSamples(value, true);
+
+  /** Launch multi-threading ComputeDerivative */
+  this->LaunchComputeDerivativeThreaderCallback();
+
+  /** Sum derivative contributions from all threads */
+  this->AfterThreadedComputeDerivative(derivative);
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ThreadedGetSamples(ThreadIdType threadId)
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  /** Retrieve slowest varying dimension. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+
+  std::vector<FixedImagePointType> SamplesOK;
+  MatrixType                       datablock(pos_end - pos_begin, this->m_G);
+
+  unsigned int pixelIndex = 0;
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    unsigned int numSamplesOk = 0;
+
+    /** Loop over t */
+    for (unsigned int d = 0; d < this->m_G; ++d)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
-       * per dimension xyz.
-       */
-      const unsigned int lastDimGridSize = this->m_GridSize[lastDim];
-      const unsigned int numParametersPerDimension =
-        this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
-      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
-      DerivativeType     mean(numControlPointsPerDimension);
-      for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
-      {
-        /** Compute mean per dimension. */
-        mean.Fill(0.0);
-        const unsigned int starti = numParametersPerDimension * d;
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          mean[index] += derivative[i];
-        }
-        mean /= static_cast<double>(lastDimGridSize);
+      /** Initialize some variables. */
+      RealType             movingImageValue;
+      MovingImagePointType mappedPoint;
 
-        /** Update derivative for every control point per dimension. */
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          derivative[i] -= mean[index];
-        }
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[lastDim] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+      /** Check if point is inside mask. */
+      if (sampleOk)
+      {
+        sampleOk = this->IsInsideMovingMask(mappedPoint);
       }
-    }
-    else
-    {
-      /** Update derivative per dimension.
-       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
-       * the number the time point index.
-       */
-      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / G;
-      DerivativeType     mean(numParametersPerLastDimension);
-      mean.Fill(0.0);
 
-      /** Compute mean per control point. */
-      for (unsigned int t = 0; t < G; ++t)
+      if (sampleOk)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          mean[index] += derivative[c];
-        }
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr);
       }
-      mean /= static_cast<double>(G);
 
-      /** Update derivative per control point. */
-      for (unsigned int t = 0; t < G; ++t)
+      if (sampleOk)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          derivative[c] -= mean[index];
-        }
+        numSamplesOk++;
+        datablock(pixelIndex, d) = movingImageValue;
+      } // end if sampleOk
+
+    } // end loop over t
+
+    if (numSamplesOk == this->m_G)
+    {
+      SamplesOK.push_back(fixedPoint);
+      pixelIndex++;
+    }
+
+  } /** end loop over image sample container */
+
+  /** Partial mean and scatter matrix of the samples of this thread. */
+  CovarianceAccumulatorType covariance;
+  covariance.Initialize(this->m_G);
+  covariance.AddRows(datablock, 0, pixelIndex);
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_CorrelationGetSamplesPerThreadVariables[threadId].st_Covariance = covariance;
+  this->m_CorrelationGetSamplesPerThreadVariables[threadId].st_NumberOfPixelsCounted = pixelIndex;
+  this->m_CorrelationGetSamplesPerThreadVariables[threadId].st_DataBlock = datablock.extract(pixelIndex, this->m_G);
+  this->m_CorrelationGetSamplesPerThreadVariables[threadId].st_ApprovedSamples = SamplesOK;
+
+} // end ThreadedGetSamples()
+
+
+/**
+ * ******************* AfterThreadedGetSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::AfterThreadedGetSamples(
+  MeasureType & value,
+  const bool    computeDerivativeTerms) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  const unsigned int G = this->m_G;
+
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = this->m_CorrelationGetSamplesPerThreadVariables[0].st_NumberOfPixelsCounted;
+  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  {
+    this->m_NumberOfPixelsCounted += this->m_CorrelationGetSamplesPerThreadVariables[i].st_NumberOfPixelsCounted;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+  const unsigned int N = this->m_NumberOfPixelsCounted;
+
+  /** Combine the partial means and scatter matrices of the threads into the covariance matrix C. */
+  CovarianceAccumulatorType covariance;
+  covariance.Initialize(G);
+  unsigned int row_start = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    covariance.Merge(this->m_CorrelationGetSamplesPerThreadVariables[i].st_Covariance);
+    this->m_PixelStartIndex[i] = row_start;
+    row_start += this->m_CorrelationGetSamplesPerThreadVariables[i].st_DataBlock.rows();
+  }
+  const MatrixType C = covariance.GetCovarianceMatrix();
+
+  vnl_diag_matrix<RealType> S(G);
+  for (unsigned int j = 0; j < G; j++)
+  {
+    S(j, j) = 1.0 / sqrt(C(j, j));
+  }
+
+  const DerivativeMatrixType K(S * C * S);
+  const RealType             froNormK = K.fro_norm();
+
+  value = RealType(1.0 - (froNormK / RealType(G)));
+
+  if (!computeDerivativeTerms)
+  {
+    return;
+  }
+
+  /** The transposed centered data matrix is still needed for the derivative. */
+  const vnl_vector<RealType> & mean = covariance.GetMean();
+  this->m_Atmm.set_size(G, N);
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    const MatrixType & datablock = this->m_CorrelationGetSamplesPerThreadVariables[i].st_DataBlock;
+    for (unsigned int k = 0; k < datablock.rows(); ++k)
+    {
+      for (unsigned int j = 0; j < G; ++j)
+      {
+        this->m_Atmm(j, this->m_PixelStartIndex[i] + k) = datablock(k, j) - mean(j);
       }
     }
   }
 
-  /** Return the measure value. */
-  value = measure;
+  /** Sub components of metric derivative. */
+  this->m_S.set_size(G);
+  this->m_dSdmu_part1.set_size(G);
+  for (unsigned int d = 0; d < G; d++)
+  {
+    const double S_qub = S(d, d) * S(d, d) * S(d, d);
+    this->m_S[d] = S(d, d);
+    this->m_dSdmu_part1[d] = -S_qub / (DerivativeValueType(N) - 1.0);
+  }
+
+  this->m_KAtZscore = K * S * this->m_Atmm;
+
+  /** Only the diagonal of K S Atmm Amm is used, and since Atmm Amm = (N - 1) C,
+   * it can be computed from the G x G matrices instead of from the N samples.
+   */
+  this->m_KAtZscoreAmmDiagonal.set_size(G);
+  for (unsigned int d = 0; d < G; d++)
+  {
+    DerivativeValueType sum = 0.0;
+    for (unsigned int k = 0; k < G; k++)
+    {
+      sum += K(d, k) * S(k, k) * C(k, d);
+    }
+    this->m_KAtZscoreAmmDiagonal[d] = (DerivativeValueType(N) - 1.0) * sum;
+  }
+
+  this->m_DerivativeNormalization = -static_cast<DerivativeValueType>(2.0) /
+                                    ((DerivativeValueType(N) - 1.0) * (froNormK * RealType(G)));
+
+} // end AfterThreadedGetSamples()
+
+
+/**
+ * **************** GetSamplesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetSamplesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  CorrelationMultiThreaderParameterType * temp =
+    static_cast<CorrelationMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedGetSamples(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end GetSamplesThreaderCallback()
+
+
+/**
+ * *********************** LaunchGetSamplesThreaderCallback ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::LaunchGetSamplesThreaderCallback(void) const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod(
+    this->GetSamplesThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_CorrelationThreaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchGetSamplesThreaderCallback()
+
+
+/**
+ * ******************* ThreadedComputeDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ThreadedComputeDerivative(
+  ThreadIdType threadId)
+{
+  /** Create variables to store intermediate results in. */
+  DerivativeType & derivative = this->m_CorrelationGetSamplesPerThreadVariables[threadId].st_Derivative;
+  derivative.Fill(0.0);
+
+  const std::vector<FixedImagePointType> & approvedSamples =
+    this->m_CorrelationGetSamplesPerThreadVariables[threadId].st_ApprovedSamples;
+  const unsigned int pixelStartIndex = this->m_PixelStartIndex[threadId];
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+
+  /** Initialize some variables. */
+  RealType                  movingImageValue;
+  MovingImagePointType      mappedPoint;
+  MovingImageDerivativeType movingImageDerivative;
+
+  TransformJacobianType      jacobian;
+  DerivativeType             imageJacobian(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  NonZeroJacobianIndicesType nzjis(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+
+  /** Second loop over fixed image samples. */
+  for (unsigned int i = 0; i < approvedSamples.size(); ++i)
+  {
+    const unsigned int pixelIndex = pixelStartIndex + i;
+
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = approvedSamples[i];
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    for (unsigned int d = 0; d < this->m_G; ++d)
+    {
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[lastDim] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+      this->TransformPoint(fixedPoint, mappedPoint);
+
+      this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+
+      /** Get the TransformJacobian dT/dmu */
+      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzjis);
+
+      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
+
+      /** build metric derivative components */
+      const DerivativeValueType factor =
+        this->m_KAtZscore[d][pixelIndex] * this->m_S[d] +
+        this->m_dSdmu_part1[d] * this->m_Atmm[d][pixelIndex] * this->m_KAtZscoreAmmDiagonal[d];
+      for (unsigned int p = 0; p < nzjis.size(); ++p)
+      {
+        derivative[nzjis[p]] += factor * imageJacobian[p];
+      } // end loop over non-zero jacobian indices
+
+    } // end loop over t
+
+  } // end second for loop over sample container
+
+} // end ThreadedComputeDerivative()
+
+
+/**
+ * ******************* AfterThreadedComputeDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::AfterThreadedComputeDerivative(
+  DerivativeType & derivative) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  derivative = this->m_CorrelationGetSamplesPerThreadVariables[0].st_Derivative;
+  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  {
+    derivative += this->m_CorrelationGetSamplesPerThreadVariables[i].st_Derivative;
+  }
+
+  derivative *= this->m_DerivativeNormalization;
+
+  /** Subtract mean from derivative elements. */
+  this->SubtractMeanFromDerivative(derivative);
+
+} // end AfterThreadedComputeDerivative()
+
+
+/**
+ * **************** ComputeDerivativeThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ComputeDerivativeThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  CorrelationMultiThreaderParameterType * temp =
+    static_cast<CorrelationMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputeDerivative(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeDerivativeThreaderCallback()
+
+
+/**
+ * ************** LaunchComputeDerivativeThreaderCallback **********
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::LaunchComputeDerivativeThreaderCallback(
+  void) const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod(
+    this->ComputeDerivativeThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_CorrelationThreaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchComputeDerivativeThreaderCallback()
 
-} // end GetValueAndDerivative()
 
 
 } // end namespace itk
@@ -108,6 +108,7 @@ public:
   typedef typename Superclass::MeasureType                     MeasureType;
   typedef typename Superclass::DerivativeType                  DerivativeType;
   typedef typename Superclass::ParametersType                  ParametersType;
+  typedef typename Superclass::NumberOfParametersType          NumberOfParametersType;
   typedef typename Superclass::FixedImagePixelType             FixedImagePixelType;
   typedef typename Superclass::MovingImageRegionType           MovingImageRegionType;
   typedef typename Superclass::ImageSamplerType                ImageSamplerType;
@@ -127,6 +128,9 @@ public:
   itkStaticConstMacro(MovingImageDimension, unsigned int, MovingImageType::ImageDimension);
 
   /** Get the value for single valued optimizers. */
+  MeasureType
+  GetValueSingleThreaded(const TransformParametersType & parameters) const;
+
   MeasureType
   GetValue(const TransformParametersType & parameters) const override;
 
@@ -135,6 +139,11 @@ public:
   GetDerivative(const TransformParametersType & parameters, DerivativeType & derivative) const override;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void
+  GetValueAndDerivativeSingleThreaded(const TransformParametersType & parameters,
+                                      MeasureType &                   Value,
+                                      DerivativeType &                Derivative) const;
+
   void
   GetValueAndDerivative(const TransformParametersType & parameters,
                         MeasureType &                   Value,
@@ -167,6 +176,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename DerivativeType::ValueType                       DerivativeValueType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -176,6 +186,45 @@ protected:
                                         const MovingImageDerivativeType & movingImageDerivative,
                                         DerivativeType &                  imageJacobian) const override;
 
+  /** Get value for each thread. */
+  inline void
+  ThreadedGetValue(ThreadIdType threadID) override;
+
+  /** Get value for a range of samples, used by the thread pool. */
+  inline void
+  ThreadedGetValueRange(ThreadIdType threadID, unsigned long pos_begin, unsigned long pos_end) override;
+
+  /** Gather the values from all threads. */
+  inline void
+  AfterThreadedGetValue(MeasureType & value) const override;
+
+  /** Get value and derivatives for each thread. */
+  inline void
+  ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
+
+  /** Get value and derivatives for a range of samples, used by the thread pool. */
+  inline void
+  ThreadedGetValueAndDerivativeRange(ThreadIdType threadID, unsigned long pos_begin, unsigned long pos_end) override;
+
+  /** Gather the values and derivatives from all threads. */
+  inline void
+  AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
+
+  /** Draw the random last dimension positions of all samples, before the threads are launched.
+   * The random number generator is not thread-safe, and drawing in sample order
+   * gives the same positions as the single-threaded code.
+   */
+  void
+  SampleRandomForAllSamples(void) const;
+
+  /** Get the last dimension positions of the sample with the given index. */
+  void
+  GetLastDimensionPositions(unsigned long sampleIndex, std::vector<int> & lastDimPositions) const;
+
+  /** Subtract the mean over the last dimension from the derivative elements. */
+  void
+  SubtractMeanFromDerivative(DerivativeType & derivative) const;
+
 private:
   VarianceOverLastDimensionImageMetric(const Self &) = delete;
   void
@@ -202,6 +251,9 @@ private:
 
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
+
+  /** The random last dimension positions of all samples, drawn by SampleRandomForAllSamples(). */
+  mutable std::vector<int> m_RandomLastDimPositions;
 };
 
 } // end namespace itk
@@ -19,8 +19,8 @@
 #define itkVarianceOverLastDimensionImageMetric_hxx
 
 #include "itkVarianceOverLastDimensionImageMetric.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
+#include <algorithm>
 #include <numeric>
 
 namespace itk
@@ -134,9 +134,8 @@ VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::SampleRandom(co
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator =
-    Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+  /** Get the random number generator. */
+  Statistics::MersenneTwisterRandomVariateGenerator * randomGenerator = this->m_RandomGenerator;
 
   /** Sample additional at fixed timepoint. */
   for (unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i)
@@ -189,12 +188,95 @@ VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::EvaluateTransfo
 
 
 /**
- * ******************* GetValue *******************
+ * ******************* SubtractMeanFromDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::SubtractMeanFromDerivative(
+  DerivativeType & derivative) const
+{
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
+
+  if (this->m_SubtractMean)
+  {
+    if (!this->m_TransformIsStackTransform)
+    {
+      /** Update derivative per dimension.
+       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
+       * per dimension xyz.
+       */
+      const unsigned int lastDimGridSize = this->m_GridSize[lastDim];
+      const unsigned int numParametersPerDimension =
+        this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
+      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
+      DerivativeType     mean(numControlPointsPerDimension);
+      for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
+      {
+        /** Compute mean per dimension. */
+        mean.Fill(0.0);
+        const unsigned int starti = numParametersPerDimension * d;
+        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
+        {
+          const unsigned int index = i % numControlPointsPerDimension;
+          mean[index] += derivative[i];
+        }
+        mean /= static_cast<double>(lastDimGridSize);
+
+        /** Update derivative for every control point per dimension. */
+        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
+        {
+          const unsigned int index = i % numControlPointsPerDimension;
+          derivative[i] -= mean[index];
+        }
+      }
+    }
+    else
+    {
+      /** Update derivative per dimension.
+       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
+       * the number the time point index.
+       */
+      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / lastDimSize;
+      DerivativeType     mean(numParametersPerLastDimension);
+      mean.Fill(0.0);
+
+      /** Compute mean per control point. */
+      for (unsigned int t = 0; t < lastDimSize; ++t)
+      {
+        const unsigned int startc = numParametersPerLastDimension * t;
+        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+        {
+          const unsigned int index = c % numParametersPerLastDimension;
+          mean[index] += derivative[c];
+        }
+      }
+      mean /= static_cast<double>(lastDimSize);
+
+      /** Update derivative per control point. */
+      for (unsigned int t = 0; t < lastDimSize; ++t)
+      {
+        const unsigned int startc = numParametersPerLastDimension * t;
+        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+        {
+          const unsigned int index = c % numParametersPerLastDimension;
+          derivative[c] -= mean[index];
+        }
+      }
+    }
+  }
+} // end SubtractMeanFromDerivative()
+
+
+/**
+ * ******************* GetValueSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 typename VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::MeasureType
-VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValue(
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueSingleThreaded(
   const TransformParametersType & parameters) const
 {
   itkDebugMacro("GetValue( " << parameters << " ) ");
@@ -324,7 +406,7 @@ VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValue(
   /** Return the mean squares measure value. */
   return measure;
 
-} // end GetValue()
+} // end GetValueSingleThreaded()
 
 
 /**
@@ -349,12 +431,12 @@ VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetDerivative(
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
-VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(
   const TransformParametersType & parameters,
   MeasureType &                   value,
   DerivativeType &                derivative) const
@@ -530,78 +612,544 @@ VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueAndDeri
   derivative /= static_cast<float>(this->m_NumberOfPixelsCounted * this->m_InitialVariance);
 
   /** Subtract mean from derivative elements. */
-  if (this->m_SubtractMean)
+  this->SubtractMeanFromDerivative(derivative);
+
+  /** Return the measure value. */
+  value = measure;
+
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* SampleRandomForAllSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::SampleRandomForAllSamples(void) const
+{
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
+  const unsigned int realNumLastDimPositions = this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed;
+
+  const unsigned long numberOfSamples = this->GetImageSampler()->GetOutput()->Size();
+  this->m_RandomLastDimPositions.resize(numberOfSamples * realNumLastDimPositions);
+
+  std::vector<int> lastDimPositions;
+  for (unsigned long i = 0; i < numberOfSamples; ++i)
   {
-    if (!this->m_TransformIsStackTransform)
+    this->SampleRandom(this->m_NumSamplesLastDimension, lastDimSize, lastDimPositions);
+    std::copy(lastDimPositions.begin(),
+              lastDimPositions.end(),
+              this->m_RandomLastDimPositions.begin() + i * realNumLastDimPositions);
+  }
+
+} // end SampleRandomForAllSamples()
+
+
+/**
+ * ******************* GetLastDimensionPositions *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetLastDimensionPositions(
+  unsigned long      sampleIndex,
+  std::vector<int> & lastDimPositions) const
+{
+  if (this->m_SampleLastDimensionRandomly)
+  {
+    const unsigned int realNumLastDimPositions = this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed;
+    const auto         begin = this->m_RandomLastDimPositions.begin() + sampleIndex * realNumLastDimPositions;
+    lastDimPositions.assign(begin, begin + realNumLastDimPositions);
+  }
+  else if (lastDimPositions.empty())
+  {
+    /** Use all positions when random sampling is turned off. */
+    const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+    const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
+    for (unsigned int i = 0; i < lastDimSize; ++i)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
-       * per dimension xyz.
-       */
-      const unsigned int lastDimGridSize = this->m_GridSize[lastDim];
-      const unsigned int numParametersPerDimension =
-        this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
-      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
-      DerivativeType     mean(numControlPointsPerDimension);
-      for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
+      lastDimPositions.push_back(i);
+    }
+  }
+
+} // end GetLastDimensionPositions()
+
+
+/**
+ * ******************* GetValue *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+typename VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::MeasureType
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValue(
+  const TransformParametersType & parameters) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->GetValueSingleThreaded(parameters);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValue itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  /** The random generator is not thread-safe, so draw the positions beforehand. */
+  if (this->m_SampleLastDimensionRandomly)
+  {
+    this->SampleRandomForAllSamples();
+  }
+
+  /** Launch multi-threading metric */
+  if (this->m_UseThreadPool)
+  {
+    this->LaunchGetValueThreadPool();
+  }
+  else
+  {
+    this->LaunchGetValueThreaderCallback();
+  }
+
+  /** Gather the metric values from all threads. */
+  MeasureType value = NumericTraits<MeasureType>::Zero;
+  this->AfterThreadedGetValue(value);
+
+  return value;
+
+} // end GetValue()
+
+
+/**
+ * ******************* ThreadedGetValue *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::ThreadedGetValue(ThreadIdType threadId)
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  this->ThreadedGetValueRange(threadId, pos_begin, pos_end);
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ******************* ThreadedGetValueRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueRange(ThreadIdType  threadId,
+                                                                                      unsigned long pos_begin,
+                                                                                      unsigned long pos_end)
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+  /** Retrieve slowest varying dimension. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long    numberOfPixelsCounted = 0;
+  MeasureType      measure = NumericTraits<MeasureType>::Zero;
+  std::vector<int> lastDimPositions;
+
+  /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
+  for (unsigned long sampleIndex = pos_begin; sampleIndex < pos_end; ++sampleIndex)
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = sampleContainer->ElementAt(sampleIndex).m_ImageCoordinates;
+
+    /** Get the last dimension positions of this sample. */
+    this->GetLastDimensionPositions(sampleIndex, lastDimPositions);
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    /** Loop over the slowest varying dimension. */
+    float              sumValues = 0.0;
+    float              sumValuesSquared = 0.0;
+    unsigned int       numSamplesOk = 0;
+    const unsigned int realNumLastDimPositions = lastDimPositions.size();
+    for (unsigned int d = 0; d < realNumLastDimPositions; ++d)
+    {
+      /** Initialize some variables. */
+      RealType             movingImageValue;
+      MovingImagePointType mappedPoint;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[lastDim] = lastDimPositions[d];
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+      /** Check if point is inside mask. */
+      if (sampleOk)
       {
-        /** Compute mean per dimension. */
-        mean.Fill(0.0);
-        const unsigned int starti = numParametersPerDimension * d;
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          mean[index] += derivative[i];
-        }
-        mean /= static_cast<double>(lastDimGridSize);
+        sampleOk = this->IsInsideMovingMask(mappedPoint);
+      }
 
-        /** Update derivative for every control point per dimension. */
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          derivative[i] -= mean[index];
-        }
+      /** Compute the moving image value and check if the point is
+       * inside the moving image buffer.
+       */
+      if (sampleOk)
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr);
       }
+
+      if (sampleOk)
+      {
+        numSamplesOk++;
+        sumValues += movingImageValue;
+        sumValuesSquared += movingImageValue * movingImageValue;
+      } // end if sampleOk
+    }   // end for loop over last dimension
+
+    if (numSamplesOk > 0)
+    {
+      numberOfPixelsCounted++;
+
+      /** Add this variance to the variance sum. */
+      const float expectedValue = sumValues / static_cast<float>(numSamplesOk);
+      const float expectedSquaredValue = sumValuesSquared / static_cast<float>(numSamplesOk);
+      measure += expectedSquaredValue - expectedValue * expectedValue;
     }
-    else
+
+  } // end for loop over the image sample container
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value += measure;
+
+} // end ThreadedGetValueRange()
+
+
+/**
+ * ******************* AfterThreadedGetValue *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::AfterThreadedGetValue(MeasureType & value) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+
+  /** Accumulate values. */
+  value = NumericTraits<MeasureType>::Zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    value += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+
+  /** Compute average over variances and normalize with initial variance. */
+  value /= static_cast<float>(this->m_NumberOfPixelsCounted * this->m_InitialVariance);
+
+} // end AfterThreadedGetValue()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+  const TransformParametersType & parameters,
+  MeasureType &                   value,
+  DerivativeType &                derivative) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->GetValueAndDerivativeSingleThreaded(parameters, value, derivative);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  /** The random generator is not thread-safe, so draw the positions beforehand. */
+  if (this->m_SampleLastDimensionRandomly)
+  {
+    this->SampleRandomForAllSamples();
+  }
+
+  /** Launch multi-threading metric. The thread pool also sums the derivatives of the threads. */
+  if (this->m_UseThreadPool)
+  {
+    this->LaunchGetValueAndDerivativeThreadPool(derivative);
+  }
+  else
+  {
+    this->LaunchGetValueAndDerivativeThreaderCallback();
+  }
+
+  /** Gather the metric values and derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative(value, derivative);
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  this->ThreadedGetValueAndDerivativeRange(threadId, pos_begin, pos_end);
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivativeRange(
+  ThreadIdType  threadId,
+  unsigned long pos_begin,
+  unsigned long pos_end)
+{
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * It is reset at the end of each iteration by the accumulate functions.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
+
+  /** Get real last dim samples. */
+  const unsigned int realNumLastDimPositions = this->m_SampleLastDimensionRandomly
+                                                 ? this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed
+                                                 : lastDimSize;
+
+  /** Create variables to store intermediate results in. */
+  const NumberOfParametersType            nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  TransformJacobianType                   jacobian;
+  std::vector<int>                        lastDimPositions;
+  std::vector<NonZeroJacobianIndicesType> nzjis(realNumLastDimPositions, NonZeroJacobianIndicesType(nnzji));
+  std::vector<RealType>                   MT(realNumLastDimPositions);
+  std::vector<DerivativeType>             dMTdmu(realNumLastDimPositions, DerivativeType(nnzji));
+  std::vector<bool>                       sampleOkPerPosition(realNumLastDimPositions);
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long numberOfPixelsCounted = 0;
+  MeasureType   measure = NumericTraits<MeasureType>::Zero;
+
+  /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
+  for (unsigned long sampleIndex = pos_begin; sampleIndex < pos_end; ++sampleIndex)
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = sampleContainer->ElementAt(sampleIndex).m_ImageCoordinates;
+
+    /** Get the last dimension positions of this sample. */
+    this->GetLastDimensionPositions(sampleIndex, lastDimPositions);
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    /** Loop over the slowest varying dimension. */
+    float        sumValues = 0.0;
+    float        sumValuesSquared = 0.0;
+    unsigned int numSamplesOk = 0;
+
+    /** First loop over t: compute M(T(x,t)), dM(T(x,t))/dmu, nzji and store. */
+    for (unsigned int d = 0; d < realNumLastDimPositions; ++d)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
-       * the number the time point index.
-       */
-      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / lastDimSize;
-      DerivativeType     mean(numParametersPerLastDimension);
-      mean.Fill(0.0);
+      /** Initialize some variables. */
+      RealType                  movingImageValue;
+      MovingImagePointType      mappedPoint;
+      MovingImageDerivativeType movingImageDerivative;
 
-      /** Compute mean per control point. */
-      for (unsigned int t = 0; t < lastDimSize; ++t)
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[lastDim] = lastDimPositions[d];
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+      /** Check if point is inside mask. */
+      if (sampleOk)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          mean[index] += derivative[c];
-        }
+        sampleOk = this->IsInsideMovingMask(mappedPoint);
       }
-      mean /= static_cast<double>(lastDimSize);
 
-      /** Update derivative per control point. */
-      for (unsigned int t = 0; t < lastDimSize; ++t)
+      /** Compute the moving image value and check if the point is
+       * inside the moving image buffer. */
+      if (sampleOk)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+      }
+
+      sampleOkPerPosition[d] = sampleOk;
+      if (sampleOk)
+      {
+        /** Update value terms **/
+        numSamplesOk++;
+        sumValues += movingImageValue;
+        sumValuesSquared += movingImageValue * movingImageValue;
+
+        /** Get the TransformJacobian dT/dmu. */
+        this->EvaluateTransformJacobian(fixedPoint, jacobian, nzjis[d]);
+
+        /** Compute the innerproduct (dM/dx)^T (dT/dmu), and store. */
+        this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, dMTdmu[d]);
+        MT[d] = movingImageValue;
+      }
+    }
+
+    if (numSamplesOk > 0)
+    {
+      numberOfPixelsCounted++;
+
+      /** Compute average intensity value. */
+      const float expectedValue = sumValues / static_cast<float>(numSamplesOk);
+      /** Add this variance to the variance sum. */
+      const float expectedSquaredValue = sumValuesSquared / static_cast<float>(numSamplesOk);
+      measure += expectedSquaredValue - expectedValue * expectedValue;
+
+      /** Second loop over t: update derivative. Invalid positions do not contribute. */
+      for (unsigned int d = 0; d < realNumLastDimPositions; ++d)
+      {
+        if (!sampleOkPerPosition[d])
         {
-          const unsigned int index = c % numParametersPerLastDimension;
-          derivative[c] -= mean[index];
+          continue;
+        }
+        const DerivativeValueType factor = (2.0 * (MT[d] - expectedValue)) / static_cast<float>(numSamplesOk);
+        for (unsigned int j = 0; j < nzjis[d].size(); ++j)
+        {
+          derivative[nzjis[d][j]] += factor * dMTdmu[d][j];
         }
       }
     }
+  } // end for loop over the image sample container
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value += measure;
+
+} // end ThreadedGetValueAndDerivativeRange()
+
+
+/**
+ * ******************* AfterThreadedGetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::AfterThreadedGetValueAndDerivative(
+  MeasureType &    value,
+  DerivativeType & derivative) const
+{
+  /** Accumulate the number of pixels and the values, and check the number of samples.
+   * If there are not enough samples, the derivatives of the threads are not accumulated
+   * below, so reset them here for the next iteration.
+   */
+  try
+  {
+    this->AfterThreadedGetValue(value);
+  }
+  catch (...)
+  {
+    for (ThreadIdType i = 0; i < Self::GetNumberOfWorkUnits(); ++i)
+    {
+      this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.Fill(
+        NumericTraits<DerivativeValueType>::ZeroValue());
+    }
+    throw;
   }
 
-  /** Return the measure value. */
-  value = measure;
+  /** The normalization factor. */
+  const DerivativeValueType normal_sum =
+    1.0 / static_cast<float>(this->m_NumberOfPixelsCounted * this->m_InitialVariance);
 
-} // end GetValueAndDerivative()
+  /** Accumulate derivatives. */
+  // already summed by the thread pool, only normalize
+  if (this->m_UseThreadPool)
+  {
+    derivative *= normal_sum;
+  }
+  // compute multi-threadedly with itk threads
+  else
+  {
+    this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+    this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0 / normal_sum;
+
+    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
+                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+    this->m_Threader->SingleMethodExecute();
+  }
+
+  /** Subtract mean from derivative elements. */
+  this->SubtractMeanFromDerivative(derivative);
+
+} // end AfterThreadedGetValueAndDerivative()
 
 
 } // end namespace itk
@@ -96,6 +96,9 @@ AdaGrad<TElastix>::BeforeRegistration(void)
 
   this->m_SettingsVector.clear();
 
+  /** Perturb the parameters with the random generator of the registration, instead of the global one. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 } // end BeforeRegistration()
 
 
@@ -554,6 +557,7 @@ AdaGrad<TElastix>::AutomaticPreconditionerEstimation(void)
       this->GetElastix()->GetElxMetricBase( m )->GetAdvancedMetricImageSampler();
     //preconditionSamplers[ m ] = ImageRandomCoordinateSamplerType::New();
     preconditionSamplers[ m ] = ImageRandomSamplerType::New();
+    preconditionSamplers[ m ]->SetRandomGenerator( this->m_RandomGenerator );
     preconditionSamplers[ m ]->SetInput( sampler->GetInput() );
     preconditionSamplers[ m ]->SetInputImageRegion( sampler->GetInputImageRegion() );
     preconditionSamplers[ m ]->SetMask( sampler->GetMask() );
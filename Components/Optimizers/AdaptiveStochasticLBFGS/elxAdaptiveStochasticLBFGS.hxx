@@ -113,6 +113,9 @@ AdaptiveStochasticLBFGS<TElastix>::BeforeRegistration(void)
 
   this->m_SettingsVector.clear();
 
+  /** Perturb the parameters with the random generator of the registration, instead of the global one. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 } // end BeforeRegistration()
 
 
@@ -940,6 +943,8 @@ AdaptiveStochasticLBFGS<TElastix>::AutomaticParameterEstimationOriginal(void)
   computeJacobianTerms->SetMaxBandCovSize(this->m_MaxBandCovSize);
   computeJacobianTerms->SetNumberOfBandStructureSamples(this->m_NumberOfBandStructureSamples);
   computeJacobianTerms->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+  computeJacobianTerms->SetUseMultiThread(testPtr->GetUseMultiThread());
+  computeJacobianTerms->SetNumberOfWorkUnits(testPtr->GetNumberOfWorkUnits());
 
   /** Check if use scales. */
   bool useScales = this->GetUseScales();
@@ -959,6 +964,10 @@ AdaptiveStochasticLBFGS<TElastix>::AutomaticParameterEstimationOriginal(void)
   computeJacobianTerms->Compute(TrC, TrCC, maxJJ, maxJCJ);
   timer2.Stop();
   elxout << "  Computing the Jacobian terms took " << this->ConvertSecondsToDHMS(timer2.GetMean(), 6) << std::endl;
+  elxout << "    of which the covariance matrix took "
+         << this->ConvertSecondsToDHMS(computeJacobianTerms->GetCovarianceComputationTime(), 6) << std::endl;
+  elxout << "    and the maximum of J C J^T took "
+         << this->ConvertSecondsToDHMS(computeJacobianTerms->GetMaximumJCJComputationTime(), 6) << std::endl;
 
   /** Determine number of gradient measurements such that
    * E + 2\sqrt(Var) < K E
@@ -105,6 +105,9 @@ AdaptiveStochasticVarianceReducedGradient<TElastix>::BeforeRegistration(void)
 
   this->m_SettingsVector.clear();
 
+  /** Perturb the parameters with the random generator of the registration, instead of the global one. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 } // end BeforeRegistration()
 
 
@@ -540,6 +543,7 @@ AdaptiveStochasticVarianceReducedGradient<TElastix>::ResumeOptimization(void)
       samplerVec[m] = dynamic_cast<ImageRandomSamplerBaseType *>(sampler.GetPointer());
 
       randomSamplerVec[m] = ImageRandomSamplerType::New();
+      randomSamplerVec[m]->SetRandomGenerator(this->m_RandomGenerator);
       randomSamplerVec[m]->SetInput(samplerVec[m]->GetInput());
       randomSamplerVec[m]->SetInputImageRegion(samplerVec[m]->GetInputImageRegion());
       randomSamplerVec[m]->SetMask(samplerVec[m]->GetMask());
@@ -577,6 +581,7 @@ AdaptiveStochasticVarianceReducedGradient<TElastix>::ResumeOptimization(void)
       samplerVec[m] = dynamic_cast<ImageRandomSamplerBaseType *>(sampler.GetPointer());
 
       subRandomSamplerVec[m] = ImageRandomSamplerType::New();
+      subRandomSamplerVec[m]->SetRandomGenerator(this->m_RandomGenerator);
       //       subRandomSamplerVec[ m ]->SetInput( randomSamplerVec[ m ] ->GetInput());
       //       subRandomSamplerVec[ m ]->SetInputImageRegion( randomSamplerVec[ m ]->
       //         GetInputImageRegion() );
@@ -796,6 +801,8 @@ AdaptiveStochasticVarianceReducedGradient<TElastix>::AutomaticParameterEstimatio
   computeJacobianTerms->SetMaxBandCovSize(this->m_MaxBandCovSize);
   computeJacobianTerms->SetNumberOfBandStructureSamples(this->m_NumberOfBandStructureSamples);
   computeJacobianTerms->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+  computeJacobianTerms->SetUseMultiThread(testPtr->GetUseMultiThread());
+  computeJacobianTerms->SetNumberOfWorkUnits(testPtr->GetNumberOfWorkUnits());
 
   /** Check if use scales. */
   bool useScales = this->GetUseScales();
@@ -815,6 +822,10 @@ AdaptiveStochasticVarianceReducedGradient<TElastix>::AutomaticParameterEstimatio
   computeJacobianTerms->Compute(TrC, TrCC, maxJJ, maxJCJ);
   timer2.Stop();
   elxout << "  Computing the Jacobian terms took " << this->ConvertSecondsToDHMS(timer2.GetMean(), 6) << std::endl;
+  elxout << "    of which the covariance matrix took "
+         << this->ConvertSecondsToDHMS(computeJacobianTerms->GetCovarianceComputationTime(), 6) << std::endl;
+  elxout << "    and the maximum of J C J^T took "
+         << this->ConvertSecondsToDHMS(computeJacobianTerms->GetMaximumJCJComputationTime(), 6) << std::endl;
 
   /** Determine number of gradient measurements such that
    * E + 2\sqrt(Var) < K E
@@ -107,6 +107,10 @@ namespace elastix
  *    reported back in the elastix.log file. This parameter can be specified for each resolution. \n
  *    example: <tt>(UpdateBDPeriod 0 0 50)</tt> \n
  *    Default: 0 (so, automatically determined).
+ * \parameter EvaluateInParallel: evaluate the population of each iteration concurrently,
+ *    see OptimizerBase. The offspring is drawn before the evaluation, so the result is the same.\n
+ *    example: <tt>(EvaluateInParallel "true")</tt> \n
+ *    Default: "false".
  *
  * \ingroup Optimizers
  */
@@ -153,6 +157,9 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
+  /** Typedef for the copies of the cost function that are evaluated in parallel. */
+  typedef typename Superclass2::WorkerCostFunctionContainerType WorkerCostFunctionContainerType;
+
   /** Check if any scales are set, and set the UseScales flag on or off;
    * after that call the superclass' implementation */
   void
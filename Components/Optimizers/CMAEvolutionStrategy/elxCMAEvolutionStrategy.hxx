@@ -49,6 +49,11 @@ CMAEvolutionStrategy<TElastix>::StartOptimization(void)
     }
   }
 
+  /** Evaluate the population in parallel, if the user asked for it and the metric can be copied. */
+  const WorkerCostFunctionContainerType workerCostFunctions = this->CreateWorkerCostFunctions();
+  this->SetWorkerCostFunctions(workerCostFunctions);
+  this->SetEvaluatePopulationInParallel(!workerCostFunctions.empty());
+
   /** Call the superclass */
   this->Superclass1::StartOptimization();
 
@@ -102,6 +107,9 @@ CMAEvolutionStrategy<TElastix>::BeforeRegistration(void)
   xout["iteration"]["5b:MaximumD"] << std::showpoint << std::fixed;
   xout["iteration"]["5c:MinimumD"] << std::showpoint << std::fixed;
 
+  /** Generate the offspring with the random generator of the registration, instead of the global one. */
+  this->SetRandomGenerator(this->GetElastix()->GetRandomGenerator());
+
 } // end BeforeRegistration
 
 
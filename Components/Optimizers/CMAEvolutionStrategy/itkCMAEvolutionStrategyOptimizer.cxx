@@ -21,6 +21,7 @@
 #include "vnl/vnl_math.h"
 #include <algorithm>
 #include <cmath>
+#include <exception>
 #include "itkCommand.h"
 #include "itkEventObject.h"
 #include "itkMacro.h"
@@ -73,6 +74,9 @@ CMAEvolutionStrategyOptimizer::CMAEvolutionStrategyOptimizer()
   this->m_PositionToleranceMin = 1e-12;
   this->m_PositionToleranceMax = 1e8;
   this->m_ValueTolerance = 1e-12;
+  this->m_EvaluatePopulationInParallel = false;
+
+  this->m_ParallelEvaluator = ParallelCostFunctionEvaluator::New();
 
 } // end constructor
 
@@ -122,6 +126,8 @@ CMAEvolutionStrategyOptimizer::PrintSelf(std::ostream & os, Indent indent) const
   os << indent << "m_PositionToleranceMin: " << this->m_PositionToleranceMin << std::endl;
   os << indent << "m_PositionToleranceMax: " << this->m_PositionToleranceMax << std::endl;
   os << indent << "m_ValueTolerance: " << this->m_ValueTolerance << std::endl;
+  os << indent << "m_EvaluatePopulationInParallel: " << this->m_EvaluatePopulationInParallel << std::endl;
+  os << indent << "m_WorkerCostFunctions: " << this->m_WorkerCostFunctions.size() << " cost functions" << std::endl;
 
   os << indent << "m_RecombinationWeights: " << this->m_RecombinationWeights << std::endl;
   os << indent << "m_C: " << this->m_C << std::endl;
@@ -156,6 +162,9 @@ CMAEvolutionStrategyOptimizer::StartOptimization()
   /** Initialize the scaledCostFunction with the currently set scales */
   this->InitializeScales();
 
+  /** Wrap the worker cost functions in scaled cost functions, with the same scales. */
+  this->m_ParallelEvaluator->SetCostFunctions(this->CreateScaledCostFunctions(this->m_WorkerCostFunctions));
+
   /** Set the current position as the scaled initial position */
   this->SetCurrentPosition(this->GetInitialPosition());
 
@@ -491,37 +500,25 @@ CMAEvolutionStrategyOptimizer::GenerateOffspring(void)
 {
   itkDebugMacro("GenerateOffspring");
 
-  /** Get the number of parameters from the cost function */
-  const unsigned int numberOfParameters = this->GetScaledCostFunction()->GetNumberOfParameters();
-
   /** Some casts/aliases: */
-  const unsigned int N = numberOfParameters;
   const unsigned int lambda = this->m_PopulationSize;
 
   /** Clear the old values */
   this->m_CostFunctionValues.clear();
 
+  /** Evaluate the whole population at once, if possible. */
+  if (this->m_EvaluatePopulationInParallel && this->m_ParallelEvaluator->GetNumberOfWorkers() > 0)
+  {
+    this->GenerateOffspringInParallel();
+    return;
+  }
+
   /** Fill the m_NormalizedSearchDirs and SearchDirs */
   unsigned int lam = 0;
   unsigned int nrOfFails = 0;
   while (lam < lambda)
   {
-    /** draw from distribution N(0,I) */
-    for (unsigned int par = 0; par < N; ++par)
-    {
-      this->m_NormalizedSearchDirs[lam][par] = this->m_RandomGenerator->GetNormalVariate();
-    }
-    /** Make like it was drawn from N(0,C) */
-    if (this->GetUseCovarianceMatrixAdaptation())
-    {
-      this->m_SearchDirs[lam] = this->m_B * (this->m_D * this->m_NormalizedSearchDirs[lam]);
-    }
-    else
-    {
-      this->m_SearchDirs[lam] = this->m_NormalizedSearchDirs[lam];
-    }
-    /** Make like it was drawn from N( 0, sigma^2 C ) */
-    this->m_SearchDirs[lam] *= this->m_CurrentSigma;
+    this->DrawSearchDirection(lam);
 
     /** Compute the cost function */
     MeasureType costFunctionValue = 0.0;
@@ -560,6 +557,128 @@ CMAEvolutionStrategyOptimizer::GenerateOffspring(void)
 } // end GenerateOffspring
 
 
+/**
+ * ****************** GenerateOffspringInParallel *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::GenerateOffspringInParallel(void)
+{
+  itkDebugMacro("GenerateOffspringInParallel");
+
+  const unsigned int lambda = this->m_PopulationSize;
+
+  /** The offspring that still has to be evaluated, and the number of failed
+   * evaluations of each offspring member. */
+  std::vector<unsigned int> offspring(lambda);
+  for (unsigned int lam = 0; lam < lambda; ++lam)
+  {
+    offspring[lam] = lam;
+  }
+  std::vector<MeasureType>  costFunctionValues(lambda, 0.0);
+  std::vector<unsigned int> nrOfFails(lambda, 0);
+
+  const ParametersType & currentPosition = this->GetScaledCurrentPosition();
+  while (!offspring.empty())
+  {
+    /** Draw the search directions of all pending offspring, in a fixed order. */
+    for (const unsigned int lam : offspring)
+    {
+      this->DrawSearchDirection(lam);
+    }
+
+    /** Evaluate x_lam = m + d_lam concurrently. Each worker uses its own cost function. */
+    ParallelCostFunctionEvaluator::MeasureContainerType   values;
+    ParallelCostFunctionEvaluator::ExceptionContainerType exceptions;
+    this->m_ParallelEvaluator->Evaluate(
+      offspring.size(),
+      currentPosition,
+      [this, &offspring, &currentPosition](const SizeValueType evaluation, ParametersType & x_lam) {
+        x_lam = currentPosition;
+        x_lam += this->m_SearchDirs[offspring[evaluation]];
+      },
+      values,
+      exceptions);
+
+    /** Try another parameter vector for the failed offspring,
+     * if we haven't tried that for 10 times already. */
+    std::vector<unsigned int> failedOffspring;
+    for (std::size_t i = 0; i < offspring.size(); ++i)
+    {
+      const unsigned int lam = offspring[i];
+      if (exceptions[i])
+      {
+        ++nrOfFails[lam];
+        if (nrOfFails[lam] > 10)
+        {
+          this->m_StopCondition = MetricError;
+          this->StopOptimization();
+          std::rethrow_exception(exceptions[i]);
+        }
+        failedOffspring.push_back(lam);
+      }
+      else
+      {
+        costFunctionValues[lam] = values[i];
+      }
+    }
+    offspring.swap(failedOffspring);
+  }
+
+  /** All evaluations were successful. */
+  for (unsigned int lam = 0; lam < lambda; ++lam)
+  {
+    this->m_CostFunctionValues.push_back(MeasureIndexPairType(costFunctionValues[lam], lam));
+  }
+
+} // end GenerateOffspringInParallel
+
+
+/**
+ * ****************** DrawSearchDirection *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::DrawSearchDirection(unsigned int lam)
+{
+  /** Get the number of parameters from the cost function */
+  const unsigned int N = this->GetScaledCostFunction()->GetNumberOfParameters();
+
+  /** draw from distribution N(0,I) */
+  for (unsigned int par = 0; par < N; ++par)
+  {
+    this->m_NormalizedSearchDirs[lam][par] = this->m_RandomGenerator->GetNormalVariate();
+  }
+  /** Make like it was drawn from N(0,C) */
+  if (this->GetUseCovarianceMatrixAdaptation())
+  {
+    this->m_SearchDirs[lam] = this->m_B * (this->m_D * this->m_NormalizedSearchDirs[lam]);
+  }
+  else
+  {
+    this->m_SearchDirs[lam] = this->m_NormalizedSearchDirs[lam];
+  }
+  /** Make like it was drawn from N( 0, sigma^2 C ) */
+  this->m_SearchDirs[lam] *= this->m_CurrentSigma;
+
+} // end DrawSearchDirection
+
+
+/**
+ * ****************** SetWorkerCostFunctions *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::SetWorkerCostFunctions(const CostFunctionContainerType & workerCostFunctions)
+{
+  itkDebugMacro("SetWorkerCostFunctions");
+
+  this->m_WorkerCostFunctions = workerCostFunctions;
+  this->Modified();
+
+} // end SetWorkerCostFunctions
+
+
 /**
  * ****************** SortCostFunctionValues *********************
  */
@@ -27,6 +27,7 @@
 #include "itkArray.h"
 #include "itkArray2D.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkParallelCostFunctionEvaluator.h"
 #include "vnl/vnl_diag_matrix.h"
 
 namespace itk
@@ -43,6 +44,15 @@ namespace itk
  *   - See also the Matlab code, cmaes.m, which you can download from the
  *     website mentioned above.
  *
+ * By default the offspring of each iteration is evaluated one after another.
+ * When EvaluatePopulationInParallel is set, and independent copies of the
+ * cost function have been provided with SetWorkerCostFunctions(), the whole
+ * population is evaluated at once by a ParallelCostFunctionEvaluator, each
+ * worker thread using its own copy.
+ * The copies should not share a transform, and are best configured to use
+ * a single thread each. The random offspring is drawn before the evaluation,
+ * so the result does not depend on the number of workers.
+ *
  * \ingroup Numerics Optimizers
  */
 
@@ -63,6 +73,13 @@ public:
   typedef Superclass::ScaledCostFunctionType ScaledCostFunctionType;
   typedef Superclass::MeasureType            MeasureType;
   typedef Superclass::ScalesType             ScalesType;
+  typedef Superclass::CostFunctionPointer    CostFunctionPointer;
+
+  /** A list of cost functions, one for each worker thread. */
+  typedef Superclass::CostFunctionContainerType CostFunctionContainerType;
+
+  /** The type of the random number generator. */
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
 
   typedef enum
   {
@@ -117,6 +134,11 @@ public:
    * To obtain the magnitude of the step, use ->GetCurretScaledStep().magnitude().  */
   itkGetConstReferenceMacro(CurrentScaledStep, ParametersType);
 
+  /** Set/Get the random number generator used to generate the offspring.
+   * Default: the global generator, RandomGeneratorType::GetInstance(). */
+  itkSetObjectMacro(RandomGenerator, RandomGeneratorType);
+  itkGetModifiableObjectMacro(RandomGenerator, RandomGeneratorType);
+
   /** Setting: convergence condition: the maximum number of iterations. Default: 100 */
   itkGetConstMacro(MaximumNumberOfIterations, unsigned long);
   itkSetClampMacro(MaximumNumberOfIterations, unsigned long, 1, NumericTraits<unsigned long>::max());
@@ -222,6 +244,22 @@ public:
   itkSetMacro(ValueTolerance, double);
   itkGetConstMacro(ValueTolerance, double);
 
+  /** Setting: evaluate all offspring of an iteration concurrently, using the
+   * worker cost functions. Without worker cost functions this setting has no effect.
+   * Default: false */
+  itkSetMacro(EvaluatePopulationInParallel, bool);
+  itkGetConstMacro(EvaluatePopulationInParallel, bool);
+  itkBooleanMacro(EvaluatePopulationInParallel);
+
+  /** Setting: independent copies of the cost function, one for each worker thread.
+   * They are used to evaluate the offspring when EvaluatePopulationInParallel is true.
+   * Each copy should give the same value as the cost function of the optimizer.
+   * The scales of the optimizer are applied to them as well. */
+  virtual void
+  SetWorkerCostFunctions(const CostFunctionContainerType & workerCostFunctions);
+
+  itkGetConstReferenceMacro(WorkerCostFunctions, CostFunctionContainerType);
+
 protected:
   typedef Array<double>               RecombinationWeightsType;
   typedef vnl_diag_matrix<double>     EigenValueMatrixType;
@@ -232,8 +270,6 @@ protected:
   typedef std::pair<MeasureType, unsigned int> MeasureIndexPairType;
   typedef std::vector<MeasureIndexPairType>    MeasureContainerType;
 
-  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
-
   /** The random number generator used to generate the offspring. */
   RandomGeneratorType::Pointer m_RandomGenerator;
 
@@ -364,6 +400,15 @@ protected:
   virtual void
   GenerateOffspring(void);
 
+  /** Same as GenerateOffspring, but draws all search directions first,
+   * and then evaluates them concurrently with the worker cost functions. */
+  virtual void
+  GenerateOffspringInParallel(void);
+
+  /** Draw a new m_NormalizedSearchDirs[ lam ] and m_SearchDirs[ lam ] */
+  virtual void
+  DrawSearchDirection(unsigned int lam);
+
   /** Sort the m_CostFunctionValues vector and update m_MeasureHistory */
   virtual void
   SortCostFunctionValues(void);
@@ -438,6 +483,10 @@ private:
   double        m_PositionToleranceMax;
   double        m_PositionToleranceMin;
   double        m_ValueTolerance;
+  bool          m_EvaluatePopulationInParallel;
+
+  CostFunctionContainerType              m_WorkerCostFunctions;
+  ParallelCostFunctionEvaluator::Pointer m_ParallelEvaluator;
 };
 
 } // end namespace itk
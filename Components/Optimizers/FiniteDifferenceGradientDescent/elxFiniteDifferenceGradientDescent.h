@@ -70,6 +70,10 @@ namespace elastix
  *   This flag can NOT be defined for each resolution. \n
  *   example: <tt>(ShowMetricValues "true" )</tt> \n
  *   Default value: "false". Note that turning this flag on increases computation time.
+ * \parameter EvaluateInParallel: Compute the 2N perturbed cost function values of a gradient
+ *   concurrently, see OptimizerBase. The gradient is the same as in the serial computation.\n
+ *   example: <tt>(EvaluateInParallel "true")</tt> \n
+ *   Default value: "false".
 
  *
  * \ingroup Optimizers
@@ -115,6 +119,9 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
+  /** Typedef for the copies of the cost function that are evaluated in parallel. */
+  typedef typename Superclass2::WorkerCostFunctionContainerType WorkerCostFunctionContainerType;
+
   /** Typedef for the ParametersType. */
   typedef typename Superclass1::ParametersType ParametersType;
 
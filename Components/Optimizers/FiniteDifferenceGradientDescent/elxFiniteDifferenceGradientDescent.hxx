@@ -228,6 +228,11 @@ FiniteDifferenceGradientDescent<TElastix>::StartOptimization(void)
     }
   }
 
+  /** Evaluate the perturbed values in parallel, if the user asked for it and the metric can be copied. */
+  const WorkerCostFunctionContainerType workerCostFunctions = this->CreateWorkerCostFunctions();
+  this->SetWorkerCostFunctions(workerCostFunctions);
+  this->SetEvaluateInParallel(!workerCostFunctions.empty());
+
   this->Superclass1::StartOptimization();
 
 } // end StartOptimization
@@ -50,6 +50,9 @@ FiniteDifferenceGradientDescentOptimizer::FiniteDifferenceGradientDescentOptimiz
   this->m_Param_alpha = 0.602;
   this->m_Param_gamma = 0.101;
 
+  this->m_EvaluateInParallel = false;
+  this->m_ParallelEvaluator = ParallelCostFunctionEvaluator::New();
+
 } // end Constructor
 
 
@@ -90,6 +93,9 @@ FiniteDifferenceGradientDescentOptimizer::StartOptimization(void)
   /** Initialize the scaledCostFunction with the currently set scales */
   this->InitializeScales();
 
+  /** Wrap the worker cost functions in scaled cost functions, with the same scales. */
+  this->m_ParallelEvaluator->SetCostFunctions(this->CreateScaledCostFunctions(this->m_WorkerCostFunctions));
+
   /** Set the current position as the scaled initial position */
   this->SetCurrentPosition(this->GetInitialPosition());
 
@@ -115,8 +121,6 @@ FiniteDifferenceGradientDescentOptimizer::ResumeOptimization(void)
   unsigned int spaceDimension = 1;
 
   ParametersType param;
-  double         valueplus;
-  double         valuemin;
 
   InvokeEvent(StartEvent());
   while (!this->m_Stop)
@@ -156,20 +160,7 @@ FiniteDifferenceGradientDescentOptimizer::ResumeOptimization(void)
     /** Calculate the derivative; this may take a while... */
     try
     {
-      for (unsigned int j = 0; j < spaceDimension; j++)
-      {
-        param[j] += ck;
-        valueplus = this->GetScaledValue(param);
-        param[j] -= 2.0 * ck;
-        valuemin = this->GetScaledValue(param);
-        param[j] += ck;
-
-        const double gradient = (valueplus - valuemin) / (2.0 * ck);
-        this->m_Gradient[j] = gradient;
-
-        sumOfSquaredGradients += (gradient * gradient);
-
-      } // for j = 0 .. spaceDimension
+      sumOfSquaredGradients = this->ComputeFiniteDifferenceGradient(param, ck);
     }
     catch (ExceptionObject & err)
     {
@@ -207,6 +198,82 @@ FiniteDifferenceGradientDescentOptimizer::ResumeOptimization(void)
 } // end ResumeOptimization
 
 
+/**
+ * *************** ComputeFiniteDifferenceGradient **************
+ */
+
+double
+FiniteDifferenceGradientDescentOptimizer::ComputeFiniteDifferenceGradient(const ParametersType & param, double ck)
+{
+  const unsigned int spaceDimension = param.GetSize();
+  double             sumOfSquaredGradients = 0.0;
+
+  if (this->m_EvaluateInParallel && this->m_ParallelEvaluator->GetNumberOfWorkers() > 0)
+  {
+    /** Evaluation 2j is at param + ck e_j, evaluation 2j+1 at param - ck e_j.
+     * The perturbed parameter is computed exactly as in the serial loop below.
+     */
+    ParallelCostFunctionEvaluator::MeasureContainerType values;
+    this->m_ParallelEvaluator->Evaluate(
+      2 * spaceDimension,
+      param,
+      [&param, ck](const SizeValueType evaluation, ParametersType & perturbed) {
+        const SizeValueType j = evaluation / 2;
+        perturbed = param;
+        perturbed[j] += ck;
+        if (evaluation % 2 == 1)
+        {
+          perturbed[j] -= 2.0 * ck;
+        }
+      },
+      values);
+
+    for (unsigned int j = 0; j < spaceDimension; j++)
+    {
+      const double gradient = (values[2 * j] - values[2 * j + 1]) / (2.0 * ck);
+      this->m_Gradient[j] = gradient;
+
+      sumOfSquaredGradients += (gradient * gradient);
+    }
+    return sumOfSquaredGradients;
+  }
+
+  ParametersType perturbed(param);
+  for (unsigned int j = 0; j < spaceDimension; j++)
+  {
+    perturbed[j] += ck;
+    const double valueplus = this->GetScaledValue(perturbed);
+    perturbed[j] -= 2.0 * ck;
+    const double valuemin = this->GetScaledValue(perturbed);
+    perturbed[j] = param[j];
+
+    const double gradient = (valueplus - valuemin) / (2.0 * ck);
+    this->m_Gradient[j] = gradient;
+
+    sumOfSquaredGradients += (gradient * gradient);
+
+  } // for j = 0 .. spaceDimension
+
+  return sumOfSquaredGradients;
+
+} // end ComputeFiniteDifferenceGradient
+
+
+/**
+ * ******************** SetWorkerCostFunctions ******************
+ */
+
+void
+FiniteDifferenceGradientDescentOptimizer::SetWorkerCostFunctions(const CostFunctionContainerType & workerCostFunctions)
+{
+  itkDebugMacro("SetWorkerCostFunctions");
+
+  this->m_WorkerCostFunctions = workerCostFunctions;
+  this->Modified();
+
+} // end SetWorkerCostFunctions
+
+
 /**
  * ********************** StopOptimization **********************
  */
@@ -20,6 +20,9 @@
 #define itkFiniteDifferenceGradientDescentOptimizer_h
 
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkParallelCostFunctionEvaluator.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -48,6 +51,11 @@ namespace itk
  * Note the similarities to the SimultaneousPerturbation optimizer and
  * the StandardGradientDescent optimizer.
  *
+ * The 2N cost function values that are needed for the gradient can be computed
+ * concurrently: set EvaluateInParallel, and provide independent copies of the cost
+ * function with SetWorkerCostFunctions(). The gradient is the same as in the serial
+ * computation.
+ *
  * \ingroup Optimizers
  * \sa FiniteDifferenceGradientDescent
  */
@@ -67,6 +75,11 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro(FiniteDifferenceGradientDescentOptimizer, ScaledSingleValuedNonLinearOptimizer);
 
+  typedef Superclass::CostFunctionPointer CostFunctionPointer;
+
+  /** A list of cost functions, one for each worker thread. */
+  typedef Superclass::CostFunctionContainerType CostFunctionContainerType;
+
   /** Codes of stopping conditions */
   typedef enum
   {
@@ -135,6 +148,24 @@ public:
   itkGetConstMacro(GradientMagnitude, double);
   itkGetConstMacro(LearningRate, double);
 
+  /** Get the gradient estimate of the last iteration, with respect to the scaled parameters. */
+  itkGetConstReferenceMacro(Gradient, DerivativeType);
+
+  /** Evaluate the perturbed cost function values concurrently, using the
+   * worker cost functions. Without worker cost functions this setting has no effect.
+   * Default: false */
+  itkSetMacro(EvaluateInParallel, bool);
+  itkGetConstMacro(EvaluateInParallel, bool);
+  itkBooleanMacro(EvaluateInParallel);
+
+  /** Independent copies of the cost function, one for each worker thread.
+   * Each copy should give the same value as the cost function of the optimizer.
+   * The scales of the optimizer are applied to them as well. */
+  virtual void
+  SetWorkerCostFunctions(const CostFunctionContainerType & workerCostFunctions);
+
+  itkGetConstReferenceMacro(WorkerCostFunctions, CostFunctionContainerType);
+
 protected:
   FiniteDifferenceGradientDescentOptimizer();
   ~FiniteDifferenceGradientDescentOptimizer() override = default;
@@ -162,6 +193,11 @@ protected:
   virtual double
   Compute_c(unsigned long k) const;
 
+  /** Compute m_Gradient, by finite differences of size ck around param, either
+   * serially or with the worker cost functions. Returns the sum of squared gradients. */
+  virtual double
+  ComputeFiniteDifferenceGradient(const ParametersType & param, double ck);
+
 private:
   FiniteDifferenceGradientDescentOptimizer(const Self &) = delete;
   void
@@ -180,6 +216,11 @@ private:
   double m_Param_A;
   double m_Param_alpha;
   double m_Param_gamma;
+
+  /** Concurrent evaluation of the perturbed positions. */
+  bool                                   m_EvaluateInParallel;
+  CostFunctionContainerType              m_WorkerCostFunctions;
+  ParallelCostFunctionEvaluator::Pointer m_ParallelEvaluator;
 };
 
 } // end namespace itk
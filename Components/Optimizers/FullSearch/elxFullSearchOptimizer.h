@@ -48,6 +48,20 @@ namespace elastix
  *   This varies the second transform parameter in the range [-4.0 3.0] with steps of 1.0
  *   and the third parameter in the range [-1.0 1.0] with steps of 0.5. The names are used
  *   as column headers in the screen output.
+ * \parameter CoarseToFineStep: When larger than 1, only every CoarseToFineStep-th point of the
+ *   search space is evaluated in each dimension. Then, the neighbourhoods of the best of these coarse
+ *   points are searched at full resolution. Points that are not evaluated get the value NaN in the
+ *   optimization surface image. This parameter can be specified for each resolution.\n
+ *   example: <tt>(CoarseToFineStep 4)</tt> \n
+ *   Default value: 1, which means that the full search space is evaluated.
+ * \parameter NumberOfCoarseToFineCandidates: The number of best coarse points around which the
+ *   fine search is done. This parameter can be specified for each resolution.\n
+ *   example: <tt>(NumberOfCoarseToFineCandidates 5)</tt> \n
+ *   Default value: 3.
+ * \parameter EvaluateInParallel: Evaluate the points of the search space concurrently, see
+ *   OptimizerBase. The points and values are reported in the same order as in the serial search.\n
+ *   example: <tt>(EvaluateInParallel "true")</tt> \n
+ *   Default value: "false".
  *
  * \ingroup Optimizers
  * \sa FullSearchOptimizer
@@ -102,6 +116,9 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
+  /** Typedef for the copies of the cost function that are evaluated in parallel. */
+  typedef typename Superclass2::WorkerCostFunctionContainerType WorkerCostFunctionContainerType;
+
   /** To store the results of the full search */
   typedef itk::NDImageBase<float>       NDImageType;
   typedef typename NDImageType::Pointer NDImagePointer;
@@ -126,6 +143,11 @@ public:
   void
   AfterRegistration(void) override;
 
+  /** Set the copies of the cost function for the parallel search,
+   * and call the Superclass' implementation. */
+  void
+  StartOptimization(void) override;
+
   /** \todo BeforeAll, checking parameters. */
 
   /** Get a pointer to the image containing the optimization surface. */
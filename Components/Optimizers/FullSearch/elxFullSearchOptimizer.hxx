@@ -22,6 +22,7 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <limits>
 #include "vnl/vnl_math.h"
 
 namespace elastix
@@ -157,6 +158,9 @@ FullSearch<TElastix>::BeforeEachResolution(void)
     this->m_OptimizationSurface->Allocate();
     /** \todo try/catch block around Allocate? */
 
+    /** Points that are skipped by the coarse-to-fine search keep this value. */
+    this->m_OptimizationSurface->FillBuffer(std::numeric_limits<float>::quiet_NaN());
+
     /** Set the name of this image on disk. */
     std::string resultImageFormat = "mhd";
     this->m_Configuration->ReadParameter(resultImageFormat, "ResultImageFormat", 0, false);
@@ -165,8 +169,26 @@ FullSearch<TElastix>::BeforeEachResolution(void)
                << this->GetConfiguration()->GetElastixLevel() << ".R" << level << "." << resultImageFormat;
     this->m_OptimizationSurface->SetOutputFileName(makeString.str().c_str());
 
-    elxout << "Total number of iterations needed in this resolution: " << this->GetNumberOfIterations() << "."
-           << std::endl;
+    /** Read the settings of the coarse-to-fine search. */
+    unsigned int coarseToFineStep = 1;
+    this->GetConfiguration()->ReadParameter(coarseToFineStep, "CoarseToFineStep", this->GetComponentLabel(), level, 0);
+    this->SetCoarseToFineStep(coarseToFineStep);
+
+    unsigned int numberOfCoarseToFineCandidates = 3;
+    this->GetConfiguration()->ReadParameter(
+      numberOfCoarseToFineCandidates, "NumberOfCoarseToFineCandidates", this->GetComponentLabel(), level, 0);
+    this->SetNumberOfCoarseToFineCandidates(numberOfCoarseToFineCandidates);
+
+    if (this->GetCoarseToFineStep() > 1)
+    {
+      elxout << "At most " << this->GetNumberOfIterations() << " iterations are needed in this resolution, "
+             << "using a coarse-to-fine search with step " << this->GetCoarseToFineStep() << "." << std::endl;
+    }
+    else
+    {
+      elxout << "Total number of iterations needed in this resolution: " << this->GetNumberOfIterations() << "."
+             << std::endl;
+    }
   }
   else
   {
@@ -224,6 +246,10 @@ FullSearch<TElastix>::AfterEachResolution(void)
       stopcondition = "Error in metric";
       break;
 
+    case PrunedRangeSearched:
+      stopcondition = "The coarse-to-fine search has finished";
+      break;
+
     default:
       stopcondition = "Unknown";
       break;
@@ -307,6 +333,25 @@ FullSearch<TElastix>::AfterRegistration(void)
 } // end AfterRegistration()
 
 
+/**
+ * ******************* StartOptimization ************************
+ */
+
+template <class TElastix>
+void
+FullSearch<TElastix>::StartOptimization(void)
+{
+  /** Search in parallel, if the user asked for it and the metric can be copied. */
+  const WorkerCostFunctionContainerType workerCostFunctions = this->CreateWorkerCostFunctions();
+  this->SetWorkerCostFunctions(workerCostFunctions);
+  this->SetEvaluateInParallel(!workerCostFunctions.empty());
+
+  /** Call the superclass */
+  this->Superclass1::StartOptimization();
+
+} // end StartOptimization()
+
+
 /**
  * ************ CheckSearchSpaceRangeDefinition *****************
  */
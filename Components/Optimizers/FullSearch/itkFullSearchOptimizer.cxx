@@ -22,6 +22,8 @@
 #include "itkMacro.h"
 #include "itkNumericTraits.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -42,6 +44,11 @@ FullSearchOptimizer::FullSearchOptimizer()
   m_SearchSpace = nullptr;
   m_LastSearchSpaceChanges = 0;
 
+  m_EvaluateInParallel = false;
+  m_CoarseToFineStep = 1;
+  m_NumberOfCoarseToFineCandidates = 3;
+  m_ParallelEvaluator = ParallelCostFunctionEvaluator::New();
+
 } // end constructor
 
 
@@ -91,6 +98,14 @@ FullSearchOptimizer::ResumeOptimization(void)
   m_Stop = false;
 
   InvokeEvent(StartEvent());
+
+  /** Evaluate lists of points, instead of one point at a time. */
+  if ((m_EvaluateInParallel && !m_WorkerCostFunctions.empty()) || m_CoarseToFineStep > 1)
+  {
+    this->ResumeOptimizationOnPointLists();
+    return;
+  }
+
   while (!m_Stop)
   {
 
@@ -441,4 +456,330 @@ FullSearchOptimizer::IndexToPoint(const SearchSpaceIndexType & index)
 } // end IndexToPoint
 
 
+/**
+ * *************** ResumeOptimizationOnPointLists ****************
+ */
+void
+FullSearchOptimizer::ResumeOptimizationOnPointLists(void)
+{
+  itkDebugMacro("ResumeOptimizationOnPointLists");
+
+  /** The first pass: either the coarse points, or the remaining points of the full search. */
+  LinearIndexContainerType points;
+  MeasureContainerType     values;
+  if (m_CoarseToFineStep > 1)
+  {
+    this->GetCoarsePoints(points);
+  }
+  else
+  {
+    const unsigned long numberOfIterations = this->GetNumberOfIterations();
+    for (unsigned long linearIndex = m_CurrentIteration; linearIndex < numberOfIterations; ++linearIndex)
+    {
+      points.push_back(linearIndex);
+    }
+  }
+  this->EvaluatePoints(points, values);
+  this->ReportPoints(points, values);
+
+  /** The second pass: the neighbourhoods of the best coarse points. */
+  if (!m_Stop && m_CoarseToFineStep > 1)
+  {
+    LinearIndexContainerType finePoints;
+    MeasureContainerType     fineValues;
+    this->GetFinePoints(points, values, finePoints);
+    this->EvaluatePoints(finePoints, fineValues);
+    this->ReportPoints(finePoints, fineValues);
+  }
+
+  if (!m_Stop)
+  {
+    if (m_CurrentIteration >= this->GetNumberOfIterations())
+    {
+      m_StopCondition = FullRangeSearched;
+    }
+    else
+    {
+      m_StopCondition = PrunedRangeSearched;
+    }
+    StopOptimization();
+  }
+
+} // end ResumeOptimizationOnPointLists
+
+
+/**
+ * ************************ EvaluatePoints ***********************
+ */
+void
+FullSearchOptimizer::EvaluatePoints(const LinearIndexContainerType & points, MeasureContainerType & values)
+{
+  values.assign(points.size(), 0.0);
+  if (points.empty())
+  {
+    return;
+  }
+
+  if (m_EvaluateInParallel && !m_WorkerCostFunctions.empty())
+  {
+    /** Collect the search space definition, so that the workers do not need to access the map. */
+    std::vector<unsigned int> parameterNumbers;
+    std::vector<RangeType>    ranges;
+    const unsigned int        searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+    SearchSpaceIteratorType   it(m_SearchSpace->Begin());
+    for (unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++)
+    {
+      parameterNumbers.push_back(it.Index());
+      ranges.push_back(it.Value());
+      it++;
+    }
+
+    /** The parameters that are not searched keep their initial value.
+     * Transform the linear index to a position; point = min + step*index.
+     */
+    const SearchSpaceSizeType & searchSpaceSize = m_SearchSpaceSize;
+    try
+    {
+      m_ParallelEvaluator->Evaluate(
+        points.size(),
+        this->GetInitialPosition(),
+        [&](const SizeValueType evaluation, ParametersType & position) {
+          unsigned long linearIndex = points[evaluation];
+          for (unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++)
+          {
+            const RangeType &   range = ranges[ssdim];
+            const unsigned long index = linearIndex % searchSpaceSize[ssdim];
+            linearIndex /= searchSpaceSize[ssdim];
+            position[parameterNumbers[ssdim]] = range[0] + static_cast<double>(range[2] * index);
+          }
+        },
+        values);
+    }
+    catch (ExceptionObject &)
+    {
+      m_StopCondition = MetricError;
+      StopOptimization();
+      throw;
+    }
+  }
+  else
+  {
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+      try
+      {
+        values[i] = m_CostFunction->GetValue(this->IndexToPosition(this->LinearIndexToIndex(points[i])));
+      }
+      catch (ExceptionObject & err)
+      {
+        m_StopCondition = MetricError;
+        StopOptimization();
+        throw err;
+      }
+    }
+  }
+
+} // end EvaluatePoints
+
+
+/**
+ * ************************* ReportPoints ************************
+ */
+void
+FullSearchOptimizer::ReportPoints(const LinearIndexContainerType & points, const MeasureContainerType & values)
+{
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    if (m_Stop)
+    {
+      break;
+    }
+
+    m_CurrentIndexInSearchSpace = this->LinearIndexToIndex(points[i]);
+    m_CurrentPointInSearchSpace = this->IndexToPoint(m_CurrentIndexInSearchSpace);
+    this->SetCurrentPosition(this->PointToPosition(m_CurrentPointInSearchSpace));
+    m_Value = values[i];
+
+    /** Check if the value is a minimum or maximum */
+    if ((m_Value < m_BestValue) ^ m_Maximize) // ^ = xor, yields true if only one of the expressions is true
+    {
+      m_BestValue = m_Value;
+      m_BestPointInSearchSpace = m_CurrentPointInSearchSpace;
+      m_BestIndexInSearchSpace = m_CurrentIndexInSearchSpace;
+    }
+
+    this->InvokeEvent(IterationEvent());
+
+    m_CurrentIteration++;
+  }
+
+} // end ReportPoints
+
+
+/**
+ * *********************** GetCoarsePoints ***********************
+ *
+ * Every m_CoarseToFineStep-th point in each dimension, and the last point.
+ */
+void
+FullSearchOptimizer::GetCoarsePoints(LinearIndexContainerType & points)
+{
+  const unsigned int          searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+
+  /** The coarse indices in each dimension. */
+  std::vector<std::vector<unsigned long>> coarseIndices(searchSpaceDimension);
+  for (unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++)
+  {
+    for (unsigned long index = 0; index < searchSpaceSize[ssdim]; index += m_CoarseToFineStep)
+    {
+      coarseIndices[ssdim].push_back(index);
+    }
+    if (coarseIndices[ssdim].back() != searchSpaceSize[ssdim] - 1)
+    {
+      coarseIndices[ssdim].push_back(searchSpaceSize[ssdim] - 1);
+    }
+  }
+
+  /** All combinations, with the first dimension running fastest, so in ascending order. */
+  points.clear();
+  std::vector<std::size_t> counter(searchSpaceDimension, 0);
+  bool                     finished = (searchSpaceDimension == 0);
+  while (!finished)
+  {
+    unsigned long linearIndex = 0;
+    for (unsigned int ssdim = searchSpaceDimension; ssdim > 0; ssdim--)
+    {
+      linearIndex = linearIndex * searchSpaceSize[ssdim - 1] + coarseIndices[ssdim - 1][counter[ssdim - 1]];
+    }
+    points.push_back(linearIndex);
+
+    finished = true;
+    for (unsigned int ssdim = 0; ssdim < searchSpaceDimension && finished; ssdim++)
+    {
+      if (++counter[ssdim] < coarseIndices[ssdim].size())
+      {
+        finished = false;
+      }
+      else
+      {
+        counter[ssdim] = 0;
+      }
+    }
+  }
+
+} // end GetCoarsePoints
+
+
+/**
+ * ************************ GetFinePoints ************************
+ *
+ * All points within m_CoarseToFineStep - 1 grid points of the best
+ * coarse points, except the coarse points themselves.
+ */
+void
+FullSearchOptimizer::GetFinePoints(const LinearIndexContainerType & coarsePoints,
+                                   const MeasureContainerType &     coarseValues,
+                                   LinearIndexContainerType &       points)
+{
+  const unsigned int          searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+  const long                  radius = static_cast<long>(m_CoarseToFineStep) - 1;
+
+  /** Sort the coarse points from best to worst. */
+  std::vector<MeasureIndexPairType> candidates;
+  for (std::size_t i = 0; i < coarsePoints.size(); ++i)
+  {
+    candidates.push_back(MeasureIndexPairType(m_Maximize ? -coarseValues[i] : coarseValues[i], coarsePoints[i]));
+  }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.resize(std::min<std::size_t>(candidates.size(), m_NumberOfCoarseToFineCandidates));
+
+  /** Collect the neighbourhoods of the candidates. */
+  points.clear();
+  for (const auto & candidate : candidates)
+  {
+    const SearchSpaceIndexType center = this->LinearIndexToIndex(candidate.second);
+    SearchSpaceIndexType       begin(searchSpaceDimension);
+    SearchSpaceIndexType       end(searchSpaceDimension);
+    for (unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++)
+    {
+      begin[ssdim] = std::max<IndexValueType>(center[ssdim] - radius, 0);
+      end[ssdim] =
+        std::min<IndexValueType>(center[ssdim] + radius, static_cast<IndexValueType>(searchSpaceSize[ssdim]) - 1);
+    }
+
+    SearchSpaceIndexType index(begin);
+    bool                 finished = (searchSpaceDimension == 0);
+    while (!finished)
+    {
+      unsigned long linearIndex = 0;
+      for (unsigned int ssdim = searchSpaceDimension; ssdim > 0; ssdim--)
+      {
+        linearIndex = linearIndex * searchSpaceSize[ssdim - 1] + index[ssdim - 1];
+      }
+      points.push_back(linearIndex);
+
+      finished = true;
+      for (unsigned int ssdim = 0; ssdim < searchSpaceDimension && finished; ssdim++)
+      {
+        if (++index[ssdim] <= end[ssdim])
+        {
+          finished = false;
+        }
+        else
+        {
+          index[ssdim] = begin[ssdim];
+        }
+      }
+    }
+  }
+
+  /** Remove duplicates, and the points that have been evaluated already. */
+  std::sort(points.begin(), points.end());
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+  points.erase(std::remove_if(points.begin(),
+                              points.end(),
+                              [&coarsePoints](const unsigned long linearIndex) {
+                                return std::binary_search(coarsePoints.begin(), coarsePoints.end(), linearIndex);
+                              }),
+               points.end());
+
+} // end GetFinePoints
+
+
+/**
+ * ********************* LinearIndexToIndex **********************
+ */
+FullSearchOptimizer::SearchSpaceIndexType
+FullSearchOptimizer::LinearIndexToIndex(unsigned long linearIndex)
+{
+  const unsigned int          searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+
+  SearchSpaceIndexType index(searchSpaceDimension);
+  for (unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++)
+  {
+    index[ssdim] = static_cast<IndexValueType>(linearIndex % searchSpaceSize[ssdim]);
+    linearIndex /= searchSpaceSize[ssdim];
+  }
+  return index;
+
+} // end LinearIndexToIndex
+
+
+/**
+ * ******************* SetWorkerCostFunctions ********************
+ */
+void
+FullSearchOptimizer::SetWorkerCostFunctions(const CostFunctionContainerType & workerCostFunctions)
+{
+  /** The evaluator checks that all cost functions have been set. */
+  m_ParallelEvaluator->SetCostFunctions(workerCostFunctions);
+  m_WorkerCostFunctions = workerCostFunctions;
+  this->Modified();
+
+} // end SetWorkerCostFunctions
+
+
 } // end namespace itk
@@ -24,6 +24,9 @@
 #include "itkImage.h"
 #include "itkArray.h"
 #include "itkFixedArray.h"
+#include "itkParallelCostFunctionEvaluator.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -35,6 +38,18 @@ namespace itk
  * Optimizer that scans a subspace of the parameter space
  * and searches for the best parameters.
  *
+ * By default all points of the search space are evaluated one after another.
+ * When EvaluateInParallel is set, and independent copies of the cost function
+ * have been provided with SetWorkerCostFunctions(), the points are handed out
+ * to worker threads by a ParallelCostFunctionEvaluator, each using its own copy.
+ * The results are reported in the same order as in the serial search, so
+ * observers of the IterationEvent see the same sequence of points and values.
+ *
+ * When CoarseToFineStep is larger than 1, only every CoarseToFineStep-th point
+ * in each dimension is evaluated first. Then, the neighbourhoods of the
+ * NumberOfCoarseToFineCandidates best coarse points are searched at full
+ * resolution. The remaining points of the search space are skipped.
+ *
  * \todo This optimizer has similar functionality as the recently added
  * itkExhaustiveOptimizer. See if we can replace it by that optimizer,
  * or inherit from it.
@@ -62,7 +77,8 @@ public:
   typedef enum
   {
     FullRangeSearched,
-    MetricError
+    MetricError,
+    PrunedRangeSearched
   } StopConditionType;
 
   /* Typedefs inherited from superclass */
@@ -71,6 +87,9 @@ public:
   typedef Superclass::CostFunctionPointer CostFunctionPointer;
   typedef Superclass::MeasureType         MeasureType;
 
+  /** A list of cost functions, one for each worker thread. */
+  typedef std::vector<CostFunctionPointer> CostFunctionContainerType;
+
   typedef ParametersType::ValueType             ParameterValueType; // = double
   typedef ParameterValueType                    RangeValueType;
   typedef FixedArray<RangeValueType, 3>         RangeType;
@@ -214,6 +233,33 @@ public:
   /** Get Stop condition. */
   itkGetConstMacro(StopCondition, StopConditionType);
 
+  /** Evaluate the points of the search space concurrently, using the worker
+   * cost functions. Without worker cost functions this setting has no effect.
+   * Default: false */
+  itkSetMacro(EvaluateInParallel, bool);
+  itkGetConstMacro(EvaluateInParallel, bool);
+  itkBooleanMacro(EvaluateInParallel);
+
+  /** Independent copies of the cost function, one for each worker thread.
+   * Each copy should give the same value as the cost function of the optimizer. */
+  virtual void
+  SetWorkerCostFunctions(const CostFunctionContainerType & workerCostFunctions);
+
+  itkGetConstReferenceMacro(WorkerCostFunctions, CostFunctionContainerType);
+
+  /** The distance, in grid points, between the points of the coarse search.
+   * 1 means that the full search space is evaluated. Default: 1 */
+  itkSetClampMacro(CoarseToFineStep, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(CoarseToFineStep, unsigned int);
+
+  /** The number of best coarse points around which the fine search is done. Default: 3 */
+  itkSetClampMacro(NumberOfCoarseToFineCandidates, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(NumberOfCoarseToFineCandidates, unsigned int);
+
+  /** Convert the linear number of a point, in the order of UpdateCurrentPosition(), to an index. */
+  virtual SearchSpaceIndexType
+  LinearIndexToIndex(unsigned long linearIndex);
+
 protected:
   FullSearchOptimizer();
   ~FullSearchOptimizer() override = default;
@@ -238,12 +284,45 @@ protected:
   virtual void
   ProcessSearchSpaceChanges(void);
 
+  typedef std::vector<unsigned long>            LinearIndexContainerType;
+  typedef std::vector<MeasureType>              MeasureContainerType;
+  typedef std::pair<MeasureType, unsigned long> MeasureIndexPairType;
+
+  /** The search used when EvaluateInParallel or CoarseToFineStep is set:
+   * the points are first evaluated and then reported in ascending order. */
+  virtual void
+  ResumeOptimizationOnPointLists(void);
+
+  /** Evaluate the cost function at the given points, concurrently if possible. */
+  virtual void
+  EvaluatePoints(const LinearIndexContainerType & points, MeasureContainerType & values);
+
+  /** Report the evaluated points: update the current and best point, and invoke an IterationEvent. */
+  virtual void
+  ReportPoints(const LinearIndexContainerType & points, const MeasureContainerType & values);
+
+  /** The points of the coarse search. */
+  virtual void
+  GetCoarsePoints(LinearIndexContainerType & points);
+
+  /** The points of the fine search, around the best coarse points, that have not been visited yet. */
+  virtual void
+  GetFinePoints(const LinearIndexContainerType & coarsePoints,
+                const MeasureContainerType &     coarseValues,
+                LinearIndexContainerType &       points);
+
 private:
   FullSearchOptimizer(const Self &) = delete;
   void
   operator=(const Self &) = delete;
 
   unsigned long m_CurrentIteration;
+
+  bool                                   m_EvaluateInParallel;
+  CostFunctionContainerType              m_WorkerCostFunctions;
+  unsigned int                           m_CoarseToFineStep;
+  unsigned int                           m_NumberOfCoarseToFineCandidates;
+  ParallelCostFunctionEvaluator::Pointer m_ParallelEvaluator;
 };
 
 } // end namespace itk
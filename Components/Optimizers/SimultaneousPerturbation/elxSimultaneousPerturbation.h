@@ -20,6 +20,7 @@
 
 #include "elxIncludes.h" // include first to avoid MSVS warning
 #include "itkSPSAOptimizer.h"
+#include "itkParallelCostFunctionEvaluator.h"
 
 namespace elastix
 {
@@ -74,7 +75,11 @@ namespace elastix
  *   This flag can NOT be defined for each resolution. \n
  *   example: <tt>(ShowMetricValues "true" )</tt> \n
  *   Default value: "false". Note that turning this flag on increases computation time.
- *
+ * \parameter EvaluateInParallel: Compute the 2q cost function values of a gradient estimate
+ *   concurrently, see OptimizerBase. The perturbations are drawn before the evaluation,
+ *   so the gradient is the same as in the serial computation.\n
+ *   example: <tt>(EvaluateInParallel "true")</tt> \n
+ *   Default value: "false".
  *
  * \ingroup Optimizers
  */
@@ -117,8 +122,15 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
+  /** Typedef for the copies of the cost function that are evaluated in parallel. */
+  typedef typename Superclass2::WorkerCostFunctionContainerType WorkerCostFunctionContainerType;
+
   /** Typedef for the ParametersType. */
   typedef typename Superclass1::ParametersType ParametersType;
+  typedef typename Superclass1::DerivativeType DerivativeType;
+
+  /** A list of cost functions, one for each worker thread. */
+  typedef std::vector<CostFunctionPointer> CostFunctionContainerType;
 
   /** Methods that take care of setting parameters and printing progress information.*/
   void
@@ -143,11 +155,36 @@ public:
   void
   SetInitialPosition(const ParametersType & param) override;
 
+  /** Set the copies of the cost function for the parallel evaluation,
+   * and call the Superclass' implementation. */
+  void
+  StartOptimization(void) override;
+
+  /** Evaluate the perturbed cost function values concurrently, using the
+   * worker cost functions. Without worker cost functions this setting has no effect.
+   * Default: false */
+  itkSetMacro(EvaluateInParallel, bool);
+  itkGetConstMacro(EvaluateInParallel, bool);
+  itkBooleanMacro(EvaluateInParallel);
+
+  /** Independent copies of the cost function, one for each worker thread.
+   * Each copy should give the same value as the cost function of the optimizer. */
+  virtual void
+  SetWorkerCostFunctions(const CostFunctionContainerType & workerCostFunctions);
+
 protected:
   SimultaneousPerturbation();
   ~SimultaneousPerturbation() override = default;
 
+  /** Compute the gradient estimate. Calls the Superclass' implementation,
+   * unless the values are evaluated in parallel. */
+  void
+  ComputeGradient(const ParametersType & parameters, DerivativeType & gradient) override;
+
   bool m_ShowMetricValues;
+  bool m_EvaluateInParallel;
+
+  itk::ParallelCostFunctionEvaluator::Pointer m_ParallelEvaluator;
 
 private:
   SimultaneousPerturbation(const Self &) = delete;
@@ -35,6 +35,8 @@ template <class TElastix>
 SimultaneousPerturbation<TElastix>::SimultaneousPerturbation()
 {
   this->m_ShowMetricValues = false;
+  this->m_EvaluateInParallel = false;
+  this->m_ParallelEvaluator = itk::ParallelCostFunctionEvaluator::New();
 } // end Constructor
 
 
@@ -238,6 +240,109 @@ SimultaneousPerturbation<TElastix>::SetInitialPosition(const ParametersType & pa
 } // end SetInitialPosition
 
 
+/**
+ * ******************* StartOptimization ***********************
+ */
+
+template <class TElastix>
+void
+SimultaneousPerturbation<TElastix>::StartOptimization(void)
+{
+  /** Evaluate the perturbed values in parallel, if the user asked for it and the metric can be copied. */
+  const WorkerCostFunctionContainerType workerCostFunctions = this->CreateWorkerCostFunctions();
+  this->SetWorkerCostFunctions(workerCostFunctions);
+  this->SetEvaluateInParallel(!workerCostFunctions.empty());
+
+  /** Call the superclass */
+  this->Superclass1::StartOptimization();
+
+} // end StartOptimization
+
+
+/**
+ * ******************* SetWorkerCostFunctions ***********************
+ */
+
+template <class TElastix>
+void
+SimultaneousPerturbation<TElastix>::SetWorkerCostFunctions(const CostFunctionContainerType & workerCostFunctions)
+{
+  this->m_ParallelEvaluator->SetCostFunctions(workerCostFunctions);
+  this->Modified();
+
+} // end SetWorkerCostFunctions
+
+
+/**
+ * ******************* ComputeGradient ***********************
+ */
+
+template <class TElastix>
+void
+SimultaneousPerturbation<TElastix>::ComputeGradient(const ParametersType & parameters, DerivativeType & gradient)
+{
+  if (!this->m_EvaluateInParallel || this->m_ParallelEvaluator->GetNumberOfWorkers() == 0)
+  {
+    this->Superclass1::ComputeGradient(parameters, gradient);
+    return;
+  }
+
+  /** This follows the implementation of the Superclass, but first draws all
+   * perturbations, and then evaluates thetaplus and thetamin of all
+   * perturbations concurrently.
+   */
+  const unsigned int spaceDimension = parameters.GetSize();
+  const unsigned int numberOfPerturbations = static_cast<unsigned int>(this->GetNumberOfPerturbations());
+
+  /** Compute c_k */
+  const double ck = this->Compute_c(this->GetCurrentIteration());
+
+  /** Generate the (scaled) perturbation vectors, in the same order as the Superclass. */
+  std::vector<DerivativeType> deltas(numberOfPerturbations);
+  for (unsigned int perturbation = 0; perturbation < numberOfPerturbations; ++perturbation)
+  {
+    this->GenerateDelta(spaceDimension);
+    deltas[perturbation] = this->m_Delta;
+  }
+
+  /** Evaluation 2p is at thetaplus of perturbation p, evaluation 2p+1 at thetamin. */
+  itk::ParallelCostFunctionEvaluator::MeasureContainerType values;
+  this->m_ParallelEvaluator->Evaluate(
+    2 * numberOfPerturbations,
+    parameters,
+    [&parameters, &deltas, ck, spaceDimension](const itk::SizeValueType evaluation, ParametersType & theta) {
+      const DerivativeType & delta = deltas[evaluation / 2];
+      const bool             plus = (evaluation % 2 == 0);
+      for (unsigned int j = 0; j < spaceDimension; ++j)
+      {
+        theta[j] = plus ? parameters[j] + ck * delta[j] : parameters[j] - ck * delta[j];
+      }
+    },
+    values);
+
+  /** Compute the gradient estimate g_k, summing the perturbations in order. */
+  gradient = DerivativeType(spaceDimension);
+  gradient.Fill(0.0);
+  for (unsigned int perturbation = 0; perturbation < numberOfPerturbations; ++perturbation)
+  {
+    const DerivativeType & delta = deltas[perturbation];
+    const double           valuediff = (values[2 * perturbation] - values[2 * perturbation + 1]) / (2 * ck);
+    for (unsigned int j = 0; j < spaceDimension; ++j)
+    {
+      gradient[j] += valuediff / delta[j];
+    }
+  }
+
+  /** Apply scaling and divide by the NumberOfPerturbations */
+  const ScalesType & scales = this->GetScales();
+  for (unsigned int j = 0; j < spaceDimension; ++j)
+  {
+    gradient[j] /= (vnl_math::sqr(scales[j]) * static_cast<double>(numberOfPerturbations));
+  }
+
+} // end ComputeGradient
+
+
 } // end namespace elastix
 
 #endif // end #ifndef elxSimultaneousPerturbation_hxx
@@ -20,6 +20,7 @@
 
 #include "elxIncludes.h" // include first to avoid MSVS warning
 #include "itkResampleImageFilter.h"
+#include "itkAdvancedTransform.h"
 
 namespace elastix
 {
@@ -28,6 +29,12 @@ namespace elastix
  * \class MyStandardResampler
  * \brief A resampler based on the itk::ResampleImageFilter.
  *
+ * For a nonlinear transform that is an itk::AdvancedTransform, such as the
+ * transforms of elastix, the output is generated on full scanlines. The
+ * physical points of a scanline are computed incrementally along x, and are
+ * mapped at once by AdvancedTransform::TransformPoints(), which avoids the
+ * virtual call and the setup per point of TransformPoint().
+ *
  * The parameters used in this class are:
  * \parameter Resampler: Select this resampler as follows:\n
  *    <tt>(Resampler "DefaultResampler")</tt>
@@ -76,6 +83,7 @@ public:
   typedef typename Superclass1::OutputImageRegionType   OutputImageRegionType;
   typedef typename Superclass1::SpacingType             SpacingType;
   typedef typename Superclass1::OriginPointType         OriginPointType;
+  typedef typename Superclass1::PointType               PointType;
 
   /** Typedef's from the ResamplerBase. */
   typedef typename Superclass2::ElastixType          ElastixType;
@@ -86,7 +94,10 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
-  /* Nothing to add. In the baseclass already everything is done what should be done. */
+  /** Typedef's for the scanline resampling. */
+  typedef typename Superclass2::CoordRepType CoordRepType;
+  typedef itk::AdvancedTransform<CoordRepType, OutputImageType::ImageDimension, InputImageType::ImageDimension>
+    AdvancedTransformType;
 
 protected:
   /** The constructor. */
@@ -94,6 +105,12 @@ protected:
   /** The destructor. */
   ~MyStandardResampler() override = default;
 
+  /** Resample the output region scanline by scanline, if the transform is an AdvancedTransform.
+   * Otherwise, or if an extrapolator is set, the ResampleImageFilter does the work.
+   */
+  void
+  NonlinearThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
 private:
   /** The deleted copy constructor. */
   MyStandardResampler(const Self &) = delete;
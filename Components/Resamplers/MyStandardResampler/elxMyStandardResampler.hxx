@@ -20,7 +20,89 @@
 #define elxMyStandardResampler_hxx
 
 #include "elxMyStandardResampler.h"
+#include "itkImageScanlineIterator.h"
 
-// nothing
+#include <algorithm> // For min and max.
+#include <vector>
+
+namespace elastix
+{
+
+/**
+ * ******************* NonlinearThreadedGenerateData ***********************
+ */
+
+template <class TElastix>
+void
+MyStandardResampler<TElastix>::NonlinearThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  const auto * advancedTransform = dynamic_cast<const AdvancedTransformType *>(this->GetTransform());
+  if (advancedTransform == nullptr || this->GetExtrapolator() != nullptr)
+  {
+    this->Superclass1::NonlinearThreadedGenerateData(outputRegionForThread);
+    return;
+  }
+
+  OutputImageType *        outputPtr = this->GetOutput();
+  const InputImageType *   inputPtr = this->GetInput();
+  const InterpolatorType * interpolator = this->GetInterpolator();
+  const PixelType          defaultValue = this->GetDefaultPixelValue();
+
+  /** The output values are clamped to the range of the pixel type, as in the ResampleImageFilter. */
+  const double minValue = static_cast<double>(itk::NumericTraits<PixelType>::NonpositiveMin());
+  const double maxValue = static_cast<double>(itk::NumericTraits<PixelType>::max());
+
+  /** The physical step between two neighboring points of a scanline. */
+  IndexType firstIndex = outputRegionForThread.GetIndex();
+  IndexType secondIndex = firstIndex;
+  ++secondIndex[0];
+  PointType firstPoint;
+  PointType secondPoint;
+  outputPtr->TransformIndexToPhysicalPoint(firstIndex, firstPoint);
+  outputPtr->TransformIndexToPhysicalPoint(secondIndex, secondPoint);
+  const typename PointType::VectorType step = secondPoint - firstPoint;
+
+  /** Buffers for the points of a scanline, before and after the transformation. */
+  const itk::SizeValueType                                     lineLength = outputRegionForThread.GetSize(0);
+  std::vector<typename AdvancedTransformType::InputPointType>  points(lineLength);
+  std::vector<typename AdvancedTransformType::OutputPointType> mappedPoints(lineLength);
+
+  itk::ImageScanlineIterator<OutputImageType> outIt(outputPtr, outputRegionForThread);
+  while (!outIt.IsAtEnd())
+  {
+    /** Compute the points of the scanline incrementally, and map them at once. */
+    outputPtr->TransformIndexToPhysicalPoint(outIt.GetIndex(), firstPoint);
+    for (itk::SizeValueType k = 0; k < lineLength; ++k)
+    {
+      for (unsigned int i = 0; i < OutputImageType::ImageDimension; ++i)
+      {
+        points[k][i] = firstPoint[i] + static_cast<CoordRepType>(k) * step[i];
+      }
+    }
+    advancedTransform->TransformPoints(points.data(), mappedPoints.data(), lineLength);
+
+    /** Interpolate the input image at the mapped points. */
+    for (itk::SizeValueType k = 0; k < lineLength; ++k)
+    {
+      typename InterpolatorType::ContinuousIndexType inputIndex;
+      inputPtr->TransformPhysicalPointToContinuousIndex(mappedPoints[k], inputIndex);
+      if (interpolator->IsInsideBuffer(inputIndex))
+      {
+        const double value = interpolator->EvaluateAtContinuousIndex(inputIndex);
+        outIt.Set(static_cast<PixelType>(std::min(std::max(value, minValue), maxValue)));
+      }
+      else
+      {
+        outIt.Set(defaultValue);
+      }
+      ++outIt;
+    }
+    outIt.NextLine();
+  }
+
+} // end NonlinearThreadedGenerateData()
+
+
+} // end namespace elastix
 
 #endif
@@ -76,6 +76,10 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \parameter UseSplineOrderKernelForUpsampling: when the grid is refined between resolutions, evaluate
+ *   the coarse grid with the kernel of BSplineTransformSplineOrder, instead of the cubic kernel. \n
+ *   example: <tt>(UseSplineOrderKernelForUpsampling "true")</tt> \n
+ *   The default is "false". Only makes a difference for spline orders 1 and 2.
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
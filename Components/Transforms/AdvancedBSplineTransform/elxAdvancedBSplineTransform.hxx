@@ -21,6 +21,7 @@
 #include "elxAdvancedBSplineTransform.h"
 
 #include "itkImageRegionExclusionConstIteratorWithIndex.h"
+#include "itkTimeProbe.h"
 #include "vnl/vnl_math.h"
 
 
@@ -95,6 +96,12 @@ AdvancedBSplineTransform<TElastix>::InitializeBSplineTransform(void)
   this->m_GridUpsampler = GridUpsamplerType::New();
   this->m_GridUpsampler->SetBSplineOrder(this->m_SplineOrder);
 
+  /** Evaluate the grid with the kernel of the spline order when upsampling, instead of the cubic kernel. */
+  bool useSplineOrderKernel = false;
+  this->GetConfiguration()->ReadParameter(
+    useSplineOrderKernel, "UseSplineOrderKernelForUpsampling", this->GetComponentLabel(), 0, 0, false);
+  this->m_GridUpsampler->SetUseBSplineOrderKernel(useSplineOrderKernel);
+
   return 0;
 } // end InitializeBSplineTransform()
 
@@ -429,7 +436,12 @@ AdvancedBSplineTransform<TElastix>::IncreaseScale(void)
 
   /** Compute the upsampled B-spline parameters. */
   ParametersType upsampledParameters;
+  itk::TimeProbe timer;
+  timer.Start();
   this->m_GridUpsampler->UpsampleParameters(latestParameters, upsampledParameters);
+  timer.Stop();
+  elxout << "Upsampling the B-spline grid for resolution " << level
+         << " took: " << static_cast<long>(timer.GetMean() * 1000) << " ms." << std::endl;
 
   /** Set the new grid definition in the BSplineTransform. */
   this->m_BSplineTransform->SetGridOrigin(requiredGridOrigin);
@@ -80,6 +80,10 @@ namespace elastix
  *   The default is zero for all resolutions. A value of 4 will avoid all deformations
  *   at the edge of the image. Make sure that 2*PassiveEdgeWidth < ControlPointGridSize
  *   in each dimension.
+ * \parameter UseSplineOrderKernelForUpsampling: when the grid is refined between resolutions, evaluate
+ *   the coarse grid with the kernel of BSplineTransformSplineOrder, instead of the cubic kernel. \n
+ *   example: <tt>(UseSplineOrderKernelForUpsampling "true")</tt> \n
+ *   The default is "false". Only makes a difference for spline orders 1 and 2.
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
@@ -77,6 +77,12 @@ BSplineStackTransform<TElastix>::InitializeBSplineTransform()
   this->m_GridUpsampler = GridUpsamplerType::New();
   this->m_GridUpsampler->SetBSplineOrder(this->m_SplineOrder);
 
+  /** Evaluate the grid with the kernel of the spline order when upsampling, instead of the cubic kernel. */
+  bool useSplineOrderKernel = false;
+  this->GetConfiguration()->ReadParameter(
+    useSplineOrderKernel, "UseSplineOrderKernelForUpsampling", this->GetComponentLabel(), 0, 0, false);
+  this->m_GridUpsampler->SetUseBSplineOrderKernel(useSplineOrderKernel);
+
   return 0;
 } // end InitializeBSplineTransform()
 
@@ -23,6 +23,7 @@
 #include "itkMacro.h"
 #include "itkImage.h"
 #include "itkVectorInterpolateImageFunction.h"
+#include "itkVectorLinearInterpolateImageFunction.h"
 #include "itkVectorNearestNeighborInterpolateImageFunction.h"
 
 namespace itk
@@ -36,6 +37,10 @@ namespace itk
  * is not implemented. DO NOT USE IT FOR REGISTRATION.
  * You may set your own interpolator!
  *
+ * With the default nearest neighbor interpolator or the linear interpolator,
+ * TransformPoints() interpolates the deformation field inline, which is much
+ * faster than calling the interpolator for each point.
+ *
  * \ingroup Transforms
  */
 
@@ -93,6 +98,8 @@ public:
   typedef typename DeformationFieldInterpolatorType::Pointer               DeformationFieldInterpolatorPointer;
   typedef VectorNearestNeighborInterpolateImageFunction<DeformationFieldType, ScalarType>
     DefaultDeformationFieldInterpolatorType;
+  typedef VectorLinearInterpolateImageFunction<DeformationFieldType, ScalarType>
+    LinearDeformationFieldInterpolatorType;
 
   /** Set the transformation parameters is not supported.
    * Use SetDeformationField() instead
@@ -131,6 +138,17 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
 
+  /** Transform a block of points at once. With the default nearest neighbor or the linear
+   * interpolator, the points are processed in chunks. The continuous indices and the
+   * displacements of a chunk are stored per dimension (structure of arrays), so that the
+   * loops over the points can be vectorized, and the deformation field is interpolated
+   * inline. Other interpolators are evaluated point by point.
+   */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  SizeValueType          numberOfPoints) const override;
+
   /** These vector transforms are not implemented for this transform. */
   OutputVectorType
   TransformVector(const InputVectorType &) const override
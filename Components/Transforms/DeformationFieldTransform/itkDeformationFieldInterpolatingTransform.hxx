@@ -20,6 +20,10 @@
 
 #include "itkDeformationFieldInterpolatingTransform.h"
 
+#include <algorithm> // For min.
+#include <cmath>     // For floor.
+#include <typeinfo>
+
 namespace itk
 {
 
@@ -70,6 +74,169 @@ DeformationFieldInterpolatingTransform<TScalarType, NDimensions, TComponentType>
 }
 
 
+// Transform a block of points
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+void
+DeformationFieldInterpolatingTransform<TScalarType, NDimensions, TComponentType>::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
+  /** Only the exact nearest neighbor and linear interpolators are evaluated inline,
+   * since a derived interpolator may compute something else.
+   */
+  const DeformationFieldInterpolatorType & interpolator = *this->m_DeformationFieldInterpolator;
+  const bool useNearestNeighbor = typeid(interpolator) == typeid(DefaultDeformationFieldInterpolatorType);
+  const bool useLinear = typeid(interpolator) == typeid(LinearDeformationFieldInterpolatorType);
+  if (!useNearestNeighbor && !useLinear)
+  {
+    Superclass::TransformPoints(inputPoints, outputPoints, numberOfPoints);
+    return;
+  }
+
+  /** The geometry of the deformation field, as used by the interpolator. */
+  const DeformationFieldType *                         field = interpolator.GetInputImage();
+  const typename DeformationFieldType::RegionType      region = field->GetBufferedRegion();
+  const typename DeformationFieldType::PointType       origin = field->GetOrigin();
+  const typename DeformationFieldType::DirectionType & pointToIndex = field->GetPhysicalPointToIndexMatrix();
+  const OffsetValueType *                              offsetTable = field->GetOffsetTable();
+  const DeformationFieldVectorType *                   buffer = field->GetBufferPointer();
+
+  IndexValueType startIndex[NDimensions];
+  IndexValueType endIndex[NDimensions];
+  double         startContinuousIndex[NDimensions];
+  double         endContinuousIndex[NDimensions];
+  for (unsigned int i = 0; i < NDimensions; ++i)
+  {
+    startIndex[i] = region.GetIndex(i);
+    endIndex[i] = startIndex[i] + static_cast<IndexValueType>(region.GetSize(i)) - 1;
+    startContinuousIndex[i] = static_cast<double>(startIndex[i]) - 0.5;
+    endContinuousIndex[i] = static_cast<double>(endIndex[i]) + 0.5;
+  }
+
+  /** The continuous indices and the displacements of a chunk of points, per dimension. */
+  const SizeValueType chunkSize = 64;
+  double              continuousIndices[NDimensions][chunkSize];
+  double              displacements[NDimensions][chunkSize];
+  bool                inside[chunkSize];
+
+  for (SizeValueType begin = 0; begin < numberOfPoints; begin += chunkSize)
+  {
+    const SizeValueType    n = std::min(chunkSize, numberOfPoints - begin);
+    const InputPointType * points = inputPoints + begin;
+
+    /** Compute the continuous indices, as Image::TransformPhysicalPointToContinuousIndex() does. */
+    for (unsigned int i = 0; i < NDimensions; ++i)
+    {
+      double * cindex = continuousIndices[i];
+      std::fill_n(cindex, n, 0.0);
+      for (unsigned int j = 0; j < NDimensions; ++j)
+      {
+        const double matrixElement = pointToIndex(i, j);
+        const double originComponent = origin[j];
+        for (SizeValueType k = 0; k < n; ++k)
+        {
+          cindex[k] += matrixElement * (points[k][j] - originComponent);
+        }
+      }
+    }
+
+    /** Check which points are inside the buffer, as the interpolator does. */
+    std::fill_n(inside, n, true);
+    for (unsigned int i = 0; i < NDimensions; ++i)
+    {
+      const double * cindex = continuousIndices[i];
+      for (SizeValueType k = 0; k < n; ++k)
+      {
+        inside[k] = inside[k] && cindex[k] >= startContinuousIndex[i] && cindex[k] < endContinuousIndex[i];
+      }
+    }
+
+    /** Interpolate the deformation field. */
+    for (SizeValueType k = 0; k < n; ++k)
+    {
+      double value[NDimensions] = {};
+      if (inside[k] && useNearestNeighbor)
+      {
+        /** Round half integers up, as the nearest neighbor interpolator does. */
+        OffsetValueType offset = 0;
+        for (unsigned int i = 0; i < NDimensions; ++i)
+        {
+          const auto index = static_cast<IndexValueType>(std::floor(continuousIndices[i][k] + 0.5));
+          offset += (index - startIndex[i]) * offsetTable[i];
+        }
+        for (unsigned int i = 0; i < NDimensions; ++i)
+        {
+          value[i] = static_cast<double>(buffer[offset][i]);
+        }
+      }
+      else if (inside[k])
+      {
+        /** The neighbors are clamped to the buffer, as in the linear interpolator. */
+        OffsetValueType lowerOffset[NDimensions];
+        OffsetValueType upperOffset[NDimensions];
+        double          distance[NDimensions];
+        for (unsigned int i = 0; i < NDimensions; ++i)
+        {
+          const auto baseIndex = static_cast<IndexValueType>(std::floor(continuousIndices[i][k]));
+          distance[i] = continuousIndices[i][k] - static_cast<double>(baseIndex);
+          lowerOffset[i] = (std::max(baseIndex, startIndex[i]) - startIndex[i]) * offsetTable[i];
+          upperOffset[i] = (std::min(baseIndex + 1, endIndex[i]) - startIndex[i]) * offsetTable[i];
+        }
+
+        double totalOverlap = 0.0;
+        for (unsigned int neighbor = 0; neighbor < (1u << NDimensions); ++neighbor)
+        {
+          double          overlap = 1.0;
+          OffsetValueType offset = 0;
+          for (unsigned int i = 0; i < NDimensions; ++i)
+          {
+            if ((neighbor >> i) & 1u)
+            {
+              offset += upperOffset[i];
+              overlap *= distance[i];
+            }
+            else
+            {
+              offset += lowerOffset[i];
+              overlap *= 1.0 - distance[i];
+            }
+          }
+          if (overlap != 0.0)
+          {
+            const DeformationFieldVectorType & vector = buffer[offset];
+            for (unsigned int i = 0; i < NDimensions; ++i)
+            {
+              value[i] += overlap * static_cast<double>(vector[i]);
+            }
+            totalOverlap += overlap;
+          }
+          if (totalOverlap == 1.0)
+          {
+            break;
+          }
+        }
+      }
+      for (unsigned int i = 0; i < NDimensions; ++i)
+      {
+        displacements[i][k] = value[i];
+      }
+    }
+
+    /** Add the displacements. Points outside the buffer are not moved. */
+    OutputPointType * outputs = outputPoints + begin;
+    for (unsigned int i = 0; i < NDimensions; ++i)
+    {
+      const double * displacement = displacements[i];
+      for (SizeValueType k = 0; k < n; ++k)
+      {
+        outputs[k][i] = inside[k] ? points[k][i] + static_cast<ScalarType>(displacement[k]) : points[k][i];
+      }
+    }
+  }
+}
+
+
 // Set the deformation field
 template <class TScalarType, unsigned int NDimensions, class TComponentType>
 void
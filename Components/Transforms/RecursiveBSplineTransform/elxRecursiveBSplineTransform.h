@@ -76,6 +76,15 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \parameter UseVectorizedBSplineImplementation: compute the Jacobian and its product with
+ *   the moving image gradient with explicit SIMD instructions (AVX-512 or AVX2, selected at
+ *   run-time, with a scalar fallback). Not used for the cyclic transform. \n
+ *   example: <tt>(UseVectorizedBSplineImplementation "true")</tt> \n
+ *   The default is "false".
+ * \parameter UseSplineOrderKernelForUpsampling: when the grid is refined between resolutions, evaluate
+ *   the coarse grid with the kernel of BSplineTransformSplineOrder, instead of the cubic kernel. \n
+ *   example: <tt>(UseSplineOrderKernelForUpsampling "true")</tt> \n
+ *   The default is "false". Only makes a difference for spline orders 1 and 2.
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
@@ -308,6 +317,9 @@ private:
   unsigned int m_SplineOrder;
   bool         m_Cyclic;
 
+  /** Use the vectorized implementation of the (non-cyclic) recursive B-spline transform. */
+  bool m_UseVectorizedImplementation{ false };
+
   /** Initialize the right B-spline transform based on the spline order and periodicity. */
   unsigned int
   InitializeBSplineTransform();
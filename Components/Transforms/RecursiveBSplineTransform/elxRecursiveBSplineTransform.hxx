@@ -21,6 +21,7 @@
 #include "elxRecursiveBSplineTransform.h"
 
 #include "itkImageRegionExclusionConstIteratorWithIndex.h"
+#include "itkTimeProbe.h"
 #include "vnl/vnl_math.h"
 
 namespace elastix
@@ -73,15 +74,21 @@ RecursiveBSplineTransform<TElastix>::InitializeBSplineTransform(void)
 
     if (this->m_SplineOrder == 1)
     {
-      this->m_BSplineTransform = BSplineTransformLinearType::New();
+      typename BSplineTransformLinearType::Pointer transform = BSplineTransformLinearType::New();
+      transform->SetUseVectorizedImplementation(this->m_UseVectorizedImplementation);
+      this->m_BSplineTransform = transform;
     }
     else if (this->m_SplineOrder == 2)
     {
-      this->m_BSplineTransform = BSplineTransformQuadraticType::New();
+      typename BSplineTransformQuadraticType::Pointer transform = BSplineTransformQuadraticType::New();
+      transform->SetUseVectorizedImplementation(this->m_UseVectorizedImplementation);
+      this->m_BSplineTransform = transform;
     }
     else if (this->m_SplineOrder == 3)
     {
-      this->m_BSplineTransform = BSplineTransformCubicType::New();
+      typename BSplineTransformCubicType::Pointer transform = BSplineTransformCubicType::New();
+      transform->SetUseVectorizedImplementation(this->m_UseVectorizedImplementation);
+      this->m_BSplineTransform = transform;
     }
     else
     {
@@ -94,6 +101,12 @@ RecursiveBSplineTransform<TElastix>::InitializeBSplineTransform(void)
   this->m_GridUpsampler = GridUpsamplerType::New();
   this->m_GridUpsampler->SetBSplineOrder(this->m_SplineOrder);
 
+  /** Evaluate the grid with the kernel of the spline order when upsampling, instead of the cubic kernel. */
+  bool useSplineOrderKernel = false;
+  this->GetConfiguration()->ReadParameter(
+    useSplineOrderKernel, "UseSplineOrderKernelForUpsampling", this->GetComponentLabel(), 0, 0, false);
+  this->m_GridUpsampler->SetUseBSplineOrderKernel(useSplineOrderKernel);
+
   return 0;
 } // end InitializeBSplineTransform()
 
@@ -112,6 +125,13 @@ RecursiveBSplineTransform<TElastix>::BeforeAll(void)
     this->m_SplineOrder, "BSplineTransformSplineOrder", this->GetComponentLabel(), 0, 0, true);
   this->m_Cyclic = false;
   this->GetConfiguration()->ReadParameter(this->m_Cyclic, "UseCyclicTransform", this->GetComponentLabel(), 0, 0, true);
+  this->m_UseVectorizedImplementation = false;
+  this->GetConfiguration()->ReadParameter(this->m_UseVectorizedImplementation,
+                                          "UseVectorizedBSplineImplementation",
+                                          this->GetComponentLabel(),
+                                          0,
+                                          0,
+                                          true);
 
   return this->InitializeBSplineTransform();
 } // end BeforeAll()
@@ -428,7 +448,12 @@ RecursiveBSplineTransform<TElastix>::IncreaseScale(void)
 
   /** Compute the upsampled B-spline parameters. */
   ParametersType upsampledParameters;
+  itk::TimeProbe timer;
+  timer.Start();
   this->m_GridUpsampler->UpsampleParameters(latestParameters, upsampledParameters);
+  timer.Stop();
+  elxout << "Upsampling the B-spline grid for resolution " << level
+         << " took: " << static_cast<long>(timer.GetMean() * 1000) << " ms." << std::endl;
 
   /** Set the new grid definition in the BSplineTransform. */
   this->m_BSplineTransform->SetGridOrigin(requiredGridOrigin);
@@ -101,6 +101,8 @@ public:
 
   /** Execute stuff before the actual registration:
    * \li Set the schedule of the fixed image pyramid.
+   * \li Let the registration share the levels of the pyramid with the other registrations
+   *   of a batch, by the fixed image data cache of elastix, if any.
    */
   void
   BeforeRegistrationBase(void) override;
@@ -115,6 +117,15 @@ public:
   virtual void
   SetFixedSchedule(void);
 
+  /** Whether the levels of the pyramid can be computed once, and shared by several registrations.
+   * Pyramids that compute their levels per resolution return false.
+   */
+  virtual bool
+  GetLevelsCanBeShared(void) const
+  {
+    return true;
+  }
+
   /** Method to write the pyramid image. */
   virtual void
   WritePyramidImage(const std::string &  filename,
@@ -35,6 +35,18 @@ FixedImagePyramidBase<TElastix>::BeforeRegistrationBase(void)
   /** Call SetFixedSchedule.*/
   this->SetFixedSchedule();
 
+  /** The registration only computes the levels of its first fixed image pyramid in one go.
+   * The elastix level is part of the key, as the registrations of a batch share their
+   * parameter maps, but the pyramid settings may differ between the parameter maps.
+   */
+  itk::SharedDataObjectCache * const cache = this->m_Elastix->GetFixedImageDataCache();
+  if (cache != nullptr && this->GetLevelsCanBeShared() && this->m_Elastix->GetElxFixedImagePyramidBase(0) == this)
+  {
+    this->m_Registration->GetAsITKBaseType()->SetFixedImagePyramidCache(cache);
+    this->m_Registration->GetAsITKBaseType()->SetFixedImagePyramidCacheKey(
+      "FixedImagePyramid " + std::to_string(this->m_Configuration->GetElastixLevel()));
+  }
+
 } // end BeforeRegistrationBase()
 
 
@@ -25,6 +25,7 @@
 #include "elxBaseComponentSE.h"
 
 #include "itkImageSamplerBase.h"
+#include "itkImageRandomSamplerBase.h"
 
 namespace elastix
 {
@@ -36,6 +37,20 @@ namespace elastix
  *
  * This class contains all the common functionality for ImageSamplers.
  *
+ * \parameter ReuseSampleBuffers: Whether the random samplers keep their sample buffers
+ *    between updates, instead of allocating new ones each time new samples are selected.
+ *    Only affects the multi-threaded random samplers, which are selected with the command
+ *    line argument "-mts true". The single-threaded samplers always write their samples
+ *    directly in the output container, which keeps its memory between updates, so for them
+ *    the option has no effect, and a warning is given. Can be given for each resolution.\n
+ *    example: <tt>(ReuseSampleBuffers "true")</tt> \n
+ *    The default is false.
+ * \parameter ShowSamplingTime: Whether the time that the selection of the samples took
+ *    is shown in each iteration, in a column "<ImageSamplerLabel>Time[ms]" of the
+ *    iteration info. Useful with NewSamplesEveryIteration. Can be given for each resolution.\n
+ *    example: <tt>(ShowSamplingTime "true")</tt> \n
+ *    The default is false.
+ *
  * \ingroup ImageSamplers
  * \ingroup ComponentBaseClasses
  */
@@ -62,8 +77,9 @@ public:
   /** Other typedef's. */
   typedef typename ElastixType::FixedImageType InputImageType;
 
-  /** ITKBaseType. */
-  typedef itk::ImageSamplerBase<InputImageType> ITKBaseType;
+  /** ITKBaseType, and the base type of the random samplers. */
+  typedef itk::ImageSamplerBase<InputImageType>       ITKBaseType;
+  typedef itk::ImageRandomSamplerBase<InputImageType> ITKRandomSamplerBaseType;
 
   /** Cast to ITKBaseType. */
   virtual ITKBaseType *
@@ -81,13 +97,26 @@ public:
   }
 
 
+  /** Execute stuff before the actual registration:
+   * \li Let a random sampler draw from the random generator of the registration.
+   */
+  void
+  BeforeRegistrationBase(void) override;
+
   /** Execute stuff before each resolution:
    * \li Give a warning when NewSamplesEveryIteration is specified,
    * but the sampler is ignoring it.
+   * \li Set the sample container options.
    */
   void
   BeforeEachResolutionBase(void) override;
 
+  /** Execute stuff after each iteration:
+   * \li Show the sampling time, if desired.
+   */
+  void
+  AfterEachIterationBase(void) override;
+
 protected:
   /** The constructor. */
   ImageSamplerBase() = default;
@@ -100,6 +129,8 @@ private:
   /** The deleted assignment operator. */
   void
   operator=(const Self &) = delete;
+
+  bool m_ShowSamplingTime{ false };
 };
 
 } // end namespace elastix
@@ -21,9 +21,34 @@
 
 #include "elxImageSamplerBase.h"
 
+#include <iomanip> // For setprecision.
+
 namespace elastix
 {
 
+/**
+ * ******************* BeforeRegistrationBase ******************
+ */
+
+template <class TElastix>
+void
+ImageSamplerBase<TElastix>::BeforeRegistrationBase(void)
+{
+  ITKRandomSamplerBaseType * randomSampler = dynamic_cast<ITKRandomSamplerBaseType *>(this->GetAsITKBaseType());
+  if (randomSampler == nullptr)
+  {
+    return;
+  }
+
+  /** Draw from the random generator of the registration, instead of the global one,
+   * which is shared by all registrations of the process. Multiple samplers share the
+   * generator of their registration, so they still select different samples.
+   */
+  randomSampler->SetRandomGenerator(this->GetElastix()->GetRandomGenerator());
+
+} // end BeforeRegistrationBase()
+
+
 /**
  * ******************* BeforeEachResolutionBase ******************
  */
@@ -51,6 +76,35 @@ ImageSamplerBase<TElastix>::BeforeEachResolutionBase(void)
     }
   }
 
+  /** Reuse the sample buffers of the random samplers between updates, or not. */
+  ITKRandomSamplerBaseType * randomSampler = dynamic_cast<ITKRandomSamplerBaseType *>(this->GetAsITKBaseType());
+  if (randomSampler != nullptr)
+  {
+    bool reuseSampleBuffers = false;
+    this->m_Configuration->ReadParameter(reuseSampleBuffers, "ReuseSampleBuffers", "", level, 0, false);
+    randomSampler->SetReuseSampleBuffers(reuseSampleBuffers);
+
+    /** The single-threaded samplers always write in the output container, so then the option has no effect. */
+    if (reuseSampleBuffers && this->m_Configuration->GetCommandLineArgument("-mts") != "true")
+    {
+      xl::xout["warning"] << "WARNING: ReuseSampleBuffers only affects the multi-threaded samplers (\"-mts true\").\n"
+                          << "The single-threaded samplers already reuse the memory of their output." << std::endl;
+    }
+  }
+
+  /** Define the name of the sampling time column, and remove it if it already existed. */
+  const std::string samplingTimeColumn = std::string(this->GetComponentLabel()) + "Time[ms]";
+  xl::xout["iteration"].RemoveTargetCell(samplingTimeColumn.c_str());
+
+  /** Show the sampling time in every iteration, or not. */
+  this->m_ShowSamplingTime = false;
+  this->m_Configuration->ReadParameter(this->m_ShowSamplingTime, "ShowSamplingTime", "", level, 0, false);
+  if (this->m_ShowSamplingTime)
+  {
+    xl::xout["iteration"].AddTargetCell(samplingTimeColumn.c_str());
+    xl::xout["iteration"][samplingTimeColumn.c_str()] << std::showpoint << std::fixed << std::setprecision(3);
+  }
+
   /** Temporary?: Use the multi-threaded version or not. */
   std::string useMultiThread = this->m_Configuration->GetCommandLineArgument("-mts"); // mts: multi-threaded samplers
   if (useMultiThread == "true")
@@ -65,6 +119,24 @@ ImageSamplerBase<TElastix>::BeforeEachResolutionBase(void)
 } // end BeforeEachResolutionBase()
 
 
+/**
+ * ******************* AfterEachIterationBase ******************
+ */
+
+template <class TElastix>
+void
+ImageSamplerBase<TElastix>::AfterEachIterationBase(void)
+{
+  /** Show the time of the last sample selection. */
+  if (this->m_ShowSamplingTime)
+  {
+    const std::string samplingTimeColumn = std::string(this->GetComponentLabel()) + "Time[ms]";
+    xl::xout["iteration"][samplingTimeColumn.c_str()] << this->GetAsITKBaseType()->GetSamplingTime() * 1000.0;
+  }
+
+} // end AfterEachIterationBase()
+
+
 } // end namespace elastix
 
 #endif //#ifndef elxImageSamplerBase_hxx
@@ -26,6 +26,8 @@
 #include "itkImageGridSampler.h"
 #include "itkPointSet.h"
 
+#include <vector>
+
 namespace elastix
 {
 
@@ -63,6 +65,12 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter UseMetricThreadPool: Whether the metric distributes its samples over
+ *    a persistent work-stealing thread pool, instead of a static split over the threads.
+ *    Only used by metrics that support it, such as the AdvancedMeanSquares metric.
+ *    Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(UseMetricThreadPool "true")</tt> \n
+ *    The default is false.
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
@@ -99,6 +107,7 @@ public:
   typedef itk::SingleValuedCostFunction                                    ITKBaseType;
   typedef itk::AdvancedImageToImageMetric<FixedImageType, MovingImageType> AdvancedMetricType;
   typedef typename AdvancedMetricType::MovingImageDerivativeScalesType     MovingImageDerivativeScalesType;
+  typedef typename AdvancedMetricType::AdvancedTransformType               AdvancedTransformType;
 
   /** Get the dimension of the fixed image. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -187,6 +196,35 @@ public:
   virtual ImageSamplerBaseType *
   GetAdvancedMetricImageSampler(void) const;
 
+  /** Typedef for the copies of the metric that are made by CreateWorkerMetrics(). */
+  typedef std::vector<typename ITKBaseType::Pointer> WorkerMetricContainerType;
+
+  /** Returns whether CreateWorkerMetrics() can copy this metric. A metric can only be
+   * copied when it is an AdvancedMetricType, and when its settings are completely read
+   * in BeforeEachResolution(). Metrics that read point sets or other data in
+   * BeforeRegistration(), for example, cannot be copied, so the default is false.
+   */
+  virtual bool
+  GetWorkerMetricsSupported(void) const
+  {
+    return false;
+  }
+
+  /** Create independent copies of this metric, for optimizers that evaluate several
+   * parameter vectors at once, one copy for each worker thread. Each copy is another
+   * instance of this component, configured by its BeforeEachResolution(), and has its own
+   * copy of the transform. The copies share the images, masks, interpolator and image
+   * sampler of this metric. This metric and its copies are set to single-threaded
+   * evaluation, so that they all give exactly the same values.
+   *
+   * Should be called after the metric is initialized for the current resolution. Returns
+   * an empty container when the metric or its transform cannot be copied: when the metric
+   * does not support it (see GetWorkerMetricsSupported()), when the transform is not an
+   * AdvancedCombinationTransform, or when a copy gives another value than this metric.
+   */
+  virtual WorkerMetricContainerType
+  CreateWorkerMetrics(unsigned int numberOfWorkers);
+
   /** Get if the exact metric value is computed */
   virtual bool
   GetShowExactMetricValue(void) const
@@ -229,11 +267,18 @@ protected:
 
   /** \todo the method GetExactDerivative could as well be added here. */
 
+  /** Check that a copy of the transform, made by CreateWorkerMetrics(), maps the
+   * corners of the fixed image region to the same points as the transform itself.
+   */
+  bool
+  CheckWorkerTransform(const AdvancedTransformType & workerTransform) const;
+
   bool                             m_ShowExactMetricValue;
   ExactMetricImageSamplerPointer   m_ExactMetricSampler;
   MeasureType                      m_CurrentExactMetricValue;
   ExactMetricSampleGridSpacingType m_ExactMetricSampleGridSpacing;
   unsigned int                     m_ExactMetricEachXNumberOfIterations;
+  bool                             m_HasWorkerMetrics;
 
 private:
   /** The deleted copy constructor. */
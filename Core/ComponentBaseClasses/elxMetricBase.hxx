@@ -20,6 +20,10 @@
 
 #include "elxMetricBase.h"
 
+#include <algorithm> // For min.
+#include <memory>
+#include <mutex>
+
 namespace elastix
 {
 
@@ -36,6 +40,7 @@ MetricBase<TElastix>::MetricBase()
   this->m_CurrentExactMetricValue = 0.0;
   this->m_ExactMetricSampleGridSpacing.Fill(1);
   this->m_ExactMetricEachXNumberOfIterations = 1;
+  this->m_HasWorkerMetrics = false;
 
 } // end Constructor
 
@@ -51,6 +56,9 @@ MetricBase<TElastix>::BeforeEachResolutionBase(void)
   /** Get the current resolution level. */
   unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
 
+  /** Copies of the metric are made again for each resolution, if needed. */
+  this->m_HasWorkerMetrics = false;
+
   /** Check if the exact metric value, computed on all pixels, should be shown. */
 
   /** Define the name of the ExactMetric column */
@@ -101,6 +109,9 @@ MetricBase<TElastix>::BeforeEachResolutionBase(void)
   /** For advanced metrics several other things can be set. */
   if (thisAsAdvanced != nullptr)
   {
+    /** Draw random numbers from the random generator of the registration. */
+    thisAsAdvanced->SetRandomGenerator(this->GetElastix()->GetRandomGenerator());
+
     /** Should the metric check for enough samples? */
     bool checkNumberOfSamples = true;
     this->GetConfiguration()->ReadParameter(
@@ -158,6 +169,12 @@ MetricBase<TElastix>::BeforeEachResolutionBase(void)
       useMultiThreading, "UseMultiThreadingForMetrics", this->GetComponentLabel(), level, 0);
 
     thisAsAdvanced->SetUseMultiThread(useMultiThreading);
+
+    /** Should the metric use the work-stealing thread pool? */
+    bool useThreadPool = false;
+    this->GetConfiguration()->ReadParameter(
+      useThreadPool, "UseMetricThreadPool", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetUseThreadPool(useThreadPool);
     if (useMultiThreading)
     {
       std::string tmp = this->m_Configuration->GetCommandLineArgument("-threads");
@@ -166,6 +183,13 @@ MetricBase<TElastix>::BeforeEachResolutionBase(void)
         const unsigned int nrOfThreads = atoi(tmp.c_str());
         thisAsAdvanced->SetNumberOfWorkUnits(nrOfThreads);
       }
+
+      /** The -workunits argument limits the work units of this registration only. */
+      if (this->m_Configuration->GetCommandLineArgument("-workunits") != "")
+      {
+        thisAsAdvanced->SetNumberOfWorkUnits(
+          std::min(thisAsAdvanced->GetNumberOfWorkUnits(), this->GetElastix()->GetNumberOfWorkUnits()));
+      }
     }
 
   } // end advanced metric
@@ -212,6 +236,14 @@ MetricBase<TElastix>::SelectNewSamples(void)
   {
     /** Force the metric to base its computation on a new subset of image samples. */
     this->GetAdvancedMetricImageSampler()->SelectNewSamplesOnUpdate();
+
+    /** The copies of this metric share the sampler. Select the new samples now,
+     * instead of during the concurrent evaluation of the copies.
+     */
+    if (this->m_HasWorkerMetrics)
+    {
+      this->GetAdvancedMetricImageSampler()->Update();
+    }
   }
   else
   {
@@ -226,6 +258,165 @@ MetricBase<TElastix>::SelectNewSamples(void)
 } // end SelectNewSamples()
 
 
+/**
+ * ********************* CreateWorkerMetrics ************************
+ */
+
+template <class TElastix>
+typename MetricBase<TElastix>::WorkerMetricContainerType
+MetricBase<TElastix>::CreateWorkerMetrics(const unsigned int numberOfWorkers)
+{
+  typedef typename AdvancedMetricType::CombinationTransformType   CombinationTransformType;
+  typedef typename CombinationTransformType::CurrentTransformType CurrentTransformType;
+  typedef typename CombinationTransformType::InitialTransformType InitialTransformType;
+
+  this->m_HasWorkerMetrics = false;
+
+  /** Check if this metric and its transform can be copied. */
+  AdvancedMetricType * thisAsAdvanced = dynamic_cast<AdvancedMetricType *>(this);
+  if (!this->GetWorkerMetricsSupported() || thisAsAdvanced == nullptr || numberOfWorkers == 0)
+  {
+    return WorkerMetricContainerType();
+  }
+  const CombinationTransformType * transform =
+    dynamic_cast<const CombinationTransformType *>(thisAsAdvanced->GetTransform());
+  if (transform == nullptr || transform->GetCurrentTransform() == nullptr)
+  {
+    return WorkerMetricContainerType();
+  }
+
+  /** The index of this metric, for the component label of the copies. */
+  unsigned int metricIndex = 0;
+  while (metricIndex < this->GetElastix()->GetNumberOfMetrics() &&
+         this->GetElastix()->GetElxMetricBase(metricIndex) != this)
+  {
+    ++metricIndex;
+  }
+
+  const auto imageSamplerMutex = std::make_shared<std::mutex>();
+
+  WorkerMetricContainerType workerMetrics;
+  try
+  {
+    for (unsigned int i = 0; i < numberOfWorkers; ++i)
+    {
+      /** Create another instance of this component, with the settings of this resolution. */
+      const itk::LightObject::Pointer anotherMetric = thisAsAdvanced->CreateAnother();
+      Self * const                    worker = dynamic_cast<Self *>(anotherMetric.GetPointer());
+      AdvancedMetricType * const      workerAsAdvanced = dynamic_cast<AdvancedMetricType *>(anotherMetric.GetPointer());
+      if (worker == nullptr || workerAsAdvanced == nullptr)
+      {
+        return WorkerMetricContainerType();
+      }
+      worker->SetElastix(this->GetElastix());
+      worker->SetComponentLabel("Metric", metricIndex);
+      worker->BeforeEachResolution();
+
+      /** Copy the settings of the registration and of BeforeEachResolutionBase(). */
+      workerAsAdvanced->SetFixedImage(thisAsAdvanced->GetFixedImage());
+      workerAsAdvanced->SetMovingImage(thisAsAdvanced->GetMovingImage());
+      workerAsAdvanced->SetFixedImageRegion(thisAsAdvanced->GetFixedImageRegion());
+      workerAsAdvanced->SetFixedImageMask(thisAsAdvanced->GetFixedImageMask());
+      workerAsAdvanced->SetMovingImageMask(thisAsAdvanced->GetMovingImageMask());
+      workerAsAdvanced->SetInterpolator(thisAsAdvanced->GetModifiableInterpolator());
+      workerAsAdvanced->SetImageSampler(thisAsAdvanced->GetImageSampler());
+      workerAsAdvanced->SetImageSamplerMutex(imageSamplerMutex);
+      workerAsAdvanced->SetRequiredRatioOfValidSamples(thisAsAdvanced->GetRequiredRatioOfValidSamples());
+      workerAsAdvanced->SetUseMovingImageDerivativeScales(thisAsAdvanced->GetUseMovingImageDerivativeScales());
+      workerAsAdvanced->SetMovingImageDerivativeScales(thisAsAdvanced->GetMovingImageDerivativeScales());
+      workerAsAdvanced->SetScaleGradientWithRespectToMovingImageOrientation(
+        thisAsAdvanced->GetScaleGradientWithRespectToMovingImageOrientation());
+      workerAsAdvanced->SetUseMultiThread(false);
+
+      /** Copy the transform. The initial transform is shared, because it is not modified. */
+      const itk::LightObject::Pointer anotherTransform = transform->GetCurrentTransform()->CreateAnother();
+      CurrentTransformType * const    currentTransform =
+        dynamic_cast<CurrentTransformType *>(anotherTransform.GetPointer());
+      if (currentTransform == nullptr)
+      {
+        return WorkerMetricContainerType();
+      }
+      currentTransform->SetFixedParameters(transform->GetCurrentTransform()->GetFixedParameters());
+      currentTransform->SetParametersByValue(transform->GetCurrentTransform()->GetParameters());
+
+      const auto workerTransform = CombinationTransformType::New();
+      workerTransform->SetCurrentTransform(currentTransform);
+      workerTransform->SetInitialTransform(const_cast<InitialTransformType *>(transform->GetInitialTransform()));
+      workerTransform->SetUseComposition(transform->GetUseComposition());
+      workerTransform->SetUseAddition(transform->GetUseAddition());
+      if (transform->GetInitialTransformIsCached())
+      {
+        workerTransform->CacheInitialTransform(thisAsAdvanced->GetFixedImage());
+      }
+      if (!this->CheckWorkerTransform(*workerTransform))
+      {
+        xl::xout["warning"] << "WARNING: The transform of " << this->GetComponentLabel()
+                            << " could not be copied for the parallel evaluation by the optimizer." << std::endl;
+        return WorkerMetricContainerType();
+      }
+      workerAsAdvanced->SetTransform(workerTransform);
+
+      workerAsAdvanced->Initialize();
+      workerMetrics.push_back(workerAsAdvanced);
+    }
+  }
+  catch (itk::ExceptionObject & excp)
+  {
+    xl::xout["warning"] << "WARNING: " << this->GetComponentLabel()
+                        << " could not be copied for the parallel evaluation by the optimizer:\n"
+                        << excp.GetDescription() << std::endl;
+    return WorkerMetricContainerType();
+  }
+
+  /** Like its copies, this metric is evaluated single-threaded from now on. */
+  thisAsAdvanced->SetUseMultiThread(false);
+
+  /** Select the samples of the shared sampler now, instead of during the concurrent evaluation. */
+  if (thisAsAdvanced->GetUseImageSampler())
+  {
+    thisAsAdvanced->GetImageSampler()->Update();
+  }
+  this->m_HasWorkerMetrics = true;
+  return workerMetrics;
+
+} // end CreateWorkerMetrics()
+
+
+/**
+ * ********************* CheckWorkerTransform ************************
+ */
+
+template <class TElastix>
+bool
+MetricBase<TElastix>::CheckWorkerTransform(const AdvancedTransformType & workerTransform) const
+{
+  const AdvancedMetricType * thisAsAdvanced = dynamic_cast<const AdvancedMetricType *>(this);
+  const FixedImageType *     fixedImage = thisAsAdvanced->GetFixedImage();
+  const auto &               region = thisAsAdvanced->GetFixedImageRegion();
+
+  /** Compare the mapping of the corners of the fixed image region. */
+  for (unsigned int corner = 0; corner < (1u << FixedImageDimension); ++corner)
+  {
+    typename FixedImageType::IndexType index = region.GetIndex();
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      if ((corner >> d) & 1u)
+      {
+        index[d] += static_cast<itk::IndexValueType>(region.GetSize(d)) - 1;
+      }
+    }
+    FixedPointType point;
+    fixedImage->TransformIndexToPhysicalPoint(index, point);
+    if (workerTransform.TransformPoint(point) != thisAsAdvanced->GetTransform()->TransformPoint(point))
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end CheckWorkerTransform()
+
+
 /**
  * ********************* GetExactValue ************************
  */
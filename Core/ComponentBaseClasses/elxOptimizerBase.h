@@ -24,6 +24,9 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkOptimizer.h"
+#include "itkSingleValuedCostFunction.h"
+
+#include <vector>
 
 namespace elastix
 {
@@ -44,6 +47,15 @@ namespace elastix
  *    Choose one from {"true", "false"} for every resolution.\n
  *    example: <tt>(NewSamplesEveryIteration "true" "true" "true")</tt> \n
  *    Default is "false" for every resolution.\n
+ * \parameter EvaluateInParallel: if this flag is set to "true", optimizers that evaluate
+ *    the cost function at several positions at once (CMAEvolutionStrategy, FullSearch,
+ *    FiniteDifferenceGradientDescent and SimultaneousPerturbation) do so concurrently,
+ *    each thread using its own copy of the metric. This requires a single metric that
+ *    supports being copied, see MetricBase::CreateWorkerMetrics(); otherwise the flag is
+ *    ignored, with a warning. The metric itself is then evaluated single-threaded.\n
+ *    Choose one from {"true", "false"} for every resolution.\n
+ *    example: <tt>(EvaluateInParallel "true")</tt> \n
+ *    Default is "false" for every resolution.\n
  *
  * \ingroup Optimizers
  * \ingroup ComponentBaseClasses
@@ -74,6 +86,9 @@ public:
   /** Typedef needed for the SetCurrentPositionPublic function. */
   typedef typename ITKBaseType::ParametersType ParametersType;
 
+  /** Typedef for the copies of the cost function that are evaluated in parallel. */
+  typedef std::vector<itk::SingleValuedCostFunction::Pointer> WorkerCostFunctionContainerType;
+
   /** Cast to ITKBaseType. */
   virtual ITKBaseType *
   GetAsITKBaseType(void)
@@ -128,6 +143,14 @@ protected:
   virtual bool
   GetNewSamplesEveryIteration(void) const;
 
+  /** Create copies of the cost function, one for each thread, when the user asked to
+   * evaluate the cost function in parallel in this resolution. Returns an empty container
+   * otherwise, or when the metric cannot be copied. Should be called when the optimization
+   * starts, after the metric is initialized.
+   */
+  virtual WorkerCostFunctionContainerType
+  CreateWorkerCostFunctions(void);
+
 private:
   /** The deleted copy constructor. */
   OptimizerBase(const Self &) = delete;
@@ -139,6 +162,11 @@ private:
    * samples each iteration.
    */
   bool m_NewSamplesEveryIteration;
+
+  /** Member variable to store the user preference for evaluating the
+   * cost function in parallel.
+   */
+  bool m_EvaluateInParallel;
 };
 
 } // end namespace elastix
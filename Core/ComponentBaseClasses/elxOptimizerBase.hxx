@@ -34,6 +34,7 @@ template <class TElastix>
 OptimizerBase<TElastix>::OptimizerBase()
 {
   this->m_NewSamplesEveryIteration = false;
+  this->m_EvaluateInParallel = false;
 
 } // end Constructor
 
@@ -75,6 +76,11 @@ OptimizerBase<TElastix>::BeforeEachResolutionBase(void)
   this->GetConfiguration()->ReadParameter(
     this->m_NewSamplesEveryIteration, "NewSamplesEveryIteration", this->GetComponentLabel(), level, 0);
 
+  /** Check if the cost function should be evaluated in parallel. */
+  this->m_EvaluateInParallel = false;
+  this->GetConfiguration()->ReadParameter(
+    this->m_EvaluateInParallel, "EvaluateInParallel", this->GetComponentLabel(), level, 0);
+
 } // end BeforeEachResolutionBase()
 
 
@@ -140,6 +146,45 @@ OptimizerBase<TElastix>::GetNewSamplesEveryIteration(void) const
 } // end GetNewSamplesEveryIteration()
 
 
+/**
+ * ****************** CreateWorkerCostFunctions ********************
+ */
+
+template <class TElastix>
+typename OptimizerBase<TElastix>::WorkerCostFunctionContainerType
+OptimizerBase<TElastix>::CreateWorkerCostFunctions(void)
+{
+  if (!this->m_EvaluateInParallel)
+  {
+    return WorkerCostFunctionContainerType();
+  }
+
+  /** Only a single metric, which is the cost function of this optimizer, can be copied. */
+  typedef itk::SingleValuedNonLinearOptimizer SingleValuedOptimizerType;
+  const SingleValuedOptimizerType * thisAsSingleValued =
+    dynamic_cast<const SingleValuedOptimizerType *>(this->GetAsITKBaseType());
+  if (thisAsSingleValued == nullptr || this->GetElastix()->GetNumberOfMetrics() != 1 ||
+      thisAsSingleValued->GetCostFunction() != this->GetElastix()->GetElxMetricBase()->GetAsITKBaseType())
+  {
+    xl::xout["warning"] << "WARNING: EvaluateInParallel is only supported for a single metric. "
+                        << "The cost function is evaluated serially." << std::endl;
+    return WorkerCostFunctionContainerType();
+  }
+
+  const unsigned int                    numberOfWorkers = this->GetElastix()->GetNumberOfWorkUnits();
+  const WorkerCostFunctionContainerType workerCostFunctions =
+    this->GetElastix()->GetElxMetricBase()->CreateWorkerMetrics(numberOfWorkers);
+  if (workerCostFunctions.empty())
+  {
+    xl::xout["warning"] << "WARNING: EvaluateInParallel is not supported by "
+                        << this->GetElastix()->GetElxMetricBase()->GetComponentLabel()
+                        << ". The cost function is evaluated serially." << std::endl;
+  }
+  return workerCostFunctions;
+
+} // end CreateWorkerCostFunctions()
+
+
 /**
  * ****************** SetSinusScales ********************
  */
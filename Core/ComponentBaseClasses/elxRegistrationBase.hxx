@@ -117,33 +117,65 @@ RegistrationBase<TElastix>::GenerateFixedMaskSpatialObject(const FixedMaskImageT
   }
 
   /** Erode, and convert to spatial object. */
-  FixedMaskErodeFilterPointer erosion = FixedMaskErodeFilterType::New();
-  erosion->SetInput(maskImage);
-  erosion->SetSchedule(pyramid->GetSchedule());
-  erosion->SetIsMovingMask(false);
-  erosion->SetResolutionLevel(level);
+  const auto erode = [maskImage, pyramid, level] {
+    FixedMaskErodeFilterPointer erosion = FixedMaskErodeFilterType::New();
+    erosion->SetInput(maskImage);
+    erosion->SetSchedule(pyramid->GetSchedule());
+    erosion->SetIsMovingMask(false);
+    erosion->SetResolutionLevel(level);
+
+    /** Set output of the erosion to fixedImageMaskAsImage. */
+    FixedMaskImagePointer erodedFixedMaskAsImage = erosion->GetOutput();
+
+    /** Do the erosion. */
+    try
+    {
+      erodedFixedMaskAsImage->Update();
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** Add information to the exception. */
+      excp.SetLocation("RegistrationBase - UpdateMasks()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError while eroding the fixed mask.\n";
+      excp.SetDescription(err_str);
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
 
-  /** Set output of the erosion to fixedImageMaskAsImage. */
-  FixedMaskImagePointer erodedFixedMaskAsImage = erosion->GetOutput();
+    /** Release some memory. */
+    erodedFixedMaskAsImage->DisconnectPipeline();
+    return erodedFixedMaskAsImage;
+  };
 
-  /** Do the erosion. */
-  try
+  /** The registrations of a batch share their fixed mask, so they erode it only once,
+   * and graft the shared eroded mask.
+   */
+  FixedMaskImagePointer              erodedFixedMaskAsImage;
+  itk::SharedDataObjectCache * const cache = this->GetElastix()->GetFixedImageDataCache();
+  if (cache == nullptr)
   {
-    erodedFixedMaskAsImage->Update();
+    erodedFixedMaskAsImage = erode();
   }
-  catch (itk::ExceptionObject & excp)
+  else
   {
-    /** Add information to the exception. */
-    excp.SetLocation("RegistrationBase - UpdateMasks()");
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError while eroding the fixed mask.\n";
-    excp.SetDescription(err_str);
-    /** Pass the exception to an higher level. */
-    throw excp;
-  }
+    std::ostringstream key;
+    key << "ErodedFixedMask " << this->GetConfiguration()->GetElastixLevel() << ' '
+        << static_cast<const void *>(maskImage->GetBufferPointer()) << ' ' << level;
+    const auto & schedule = pyramid->GetSchedule();
+    for (unsigned int i = 0; i < schedule.rows(); ++i)
+    {
+      for (unsigned int j = 0; j < schedule.cols(); ++j)
+      {
+        key << ' ' << schedule[i][j];
+      }
+    }
 
-  /** Release some memory. */
-  erodedFixedMaskAsImage->DisconnectPipeline();
+    const auto erodedMasks = cache->GetDataObjects(
+      key.str(), [&erode] { return itk::SharedDataObjectCache::DataObjectsType{ erode().GetPointer() }; });
+    erodedFixedMaskAsImage = FixedMaskImageType::New();
+    erodedFixedMaskAsImage->Graft(erodedMasks.front());
+  }
 
   fixedMaskSpatialObject->SetImage(erodedFixedMaskAsImage);
   fixedMaskSpatialObject->Update();
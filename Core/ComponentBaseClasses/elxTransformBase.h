@@ -55,6 +55,14 @@ namespace elastix
  *   "Compose" by composition: \f$T(x) = T_1 ( T_0(x) )\f$.\n
  *   example: <tt>(HowToCombineTransforms "Add")</tt>\n
  *   Default: "Add".
+ * \parameter CacheInitialTransform: Whether the initial transform is evaluated once for each voxel
+ *   of the fixed image of the current resolution, at the start of that resolution, instead of at each
+ *   sample in each iteration. A chain of linear initial transforms is merged into a single matrix and
+ *   offset. Otherwise its displacements are kept in memory, and linearly interpolated between the voxels,
+ *   so they are exact for samplers that sample at voxel positions. The spatial derivatives of the initial
+ *   transform, as used by some penalty terms, are never cached. Can be given for each resolution.\n
+ *   example: <tt>(CacheInitialTransform "false" "true")</tt>\n
+ *   Default: "false".
  *
  * \transformparameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
@@ -109,6 +117,24 @@ namespace elastix
  * The location is relative to the path from where elastix/transformix is started!\n
  * Default: "NoInitialTransform", which (obviously) means that there is no initial transform
  * to be loaded.
+ * \transformparameter NumberOfStreamDivisions: The number of pieces in which transformix computes
+ * and writes the deformation field and the (determinant of the) spatial Jacobian. Each piece is
+ * written to disk before the next one is computed, so only one piece needs to be in memory. This
+ * requires a file format that supports streamed writing, like mhd, mha or nrrd, without compression;
+ * other formats are still written as a whole. When transformix is used as a library, the deformation
+ * field is kept in memory, and this parameter does not apply to it.\n
+ * example <tt>(NumberOfStreamDivisions 16)</tt>\n
+ * Default: 1, which means that the images are computed and written as a whole.
+ * \transformparameter CollapseTransformChain: Whether transformix evaluates the whole chain of
+ * transforms once for each voxel of the output grid, before the deformation field and the resampled
+ * image are computed, which then both use these precomputed values. A chain of linear transforms is
+ * merged into a single matrix and offset. Otherwise the displacements are kept in memory, as three
+ * doubles per voxel (in 3D). This cache is computed as a whole, so NumberOfStreamDivisions does not
+ * apply to it. The chain is only collapsed when both the deformation field (-def all) and the
+ * resampled image (a moving image is given) are computed, since otherwise each voxel is transformed
+ * only once anyway. Transformed point sets and spatial Jacobians still use the chain itself.\n
+ * example <tt>(CollapseTransformChain "true")</tt>\n
+ * Default: false.
  *
  * The command line arguments used by this class are:
  * \commandlinearg -t0: optional argument for elastix for specifying an initial transform
@@ -121,6 +147,9 @@ namespace elastix
  *    "point", depending if the user supplies voxel indices or real world coordinates.
  *    The second line should be the number of points that should be transformed. The
  *    third and following lines give the indices or points.\n
+ *    The points may also be given as a binary point file, see TransformixBinaryPointFile.
+ *    The transformed points are then written to outputpoints.bin, as a binary point file
+ *    of doubles in world coordinates, instead of to outputpoints.txt.\n
  *    It is also possible to deform all points, thereby generating a deformation field
  *    image. This is done by:\n
  *    example: <tt>-def all</tt> \n
@@ -268,6 +297,12 @@ public:
   void
   ComputeSpatialJacobian(void) const;
 
+  /** Function to let the resampler and the deformation field use the whole chain
+   * of transforms, cached on the output grid of the resampler.
+   */
+  void
+  CollapseTransformChain(void);
+
   /** Makes sure that the final parameters from the registration components
    * are copied, set, and stored.
    */
@@ -318,6 +353,23 @@ private:
     return dynamic_cast<CombinationTransformType *>(this);
   }
 
+  /** Create the pipeline that generates the deformation field image, and pass its output,
+   * which is not yet updated, to the given function, while the pipeline exists. */
+  template <class TFunction>
+  void
+  RunDeformationFieldPipeline(const TFunction & function) const;
+
+  /** Read the NumberOfStreamDivisions parameter. */
+  unsigned int
+  GetNumberOfStreamDivisions(void) const;
+
+  /** Transform the points of a binary point file, and write them to outputpoints.bin. */
+  template <class TPointSet>
+  void
+  WriteTransformedPointsBinary(const TPointSet &      inputPointSet,
+                               bool                   pointsAreIndices,
+                               const FixedImageType & fixedImage) const;
+
   /** Execute stuff before everything else:
    * \li Check the appearance of an initial transform.
    */
@@ -330,6 +382,18 @@ private:
   void
   BeforeRegistrationBase(void) override;
 
+  /** Execute stuff before each resolution:
+   * \li Cache the initial transform, if desired.
+   */
+  void
+  BeforeEachResolutionBase(void) override;
+
+  /** Execute stuff after each resolution:
+   * \li Remove the cache of the initial transform.
+   */
+  void
+  AfterEachResolutionBase(void) override;
+
   /** Execute stuff after the registration:
    * \li Get and set the final parameters for the resampler.
    */
@@ -362,7 +426,11 @@ private:
   typename DeformationFieldImageType::Pointer
   GenerateDeformationFieldImage(void) const;
 
-  void WriteDeformationFieldImage(typename DeformationFieldImageType::Pointer) const;
+  /** Writes the deformation field image. With more than one stream division, the deformation field
+   * is updated and written piece by piece, if the output file format supports it. */
+  void
+  WriteDeformationFieldImage(typename DeformationFieldImageType::Pointer deformationfield,
+                             unsigned int                                numberOfStreamDivisions = 1) const;
 
   /** Legacy function that calls GenerateDeformationFieldImage and WriteDeformationFieldImage. */
   void
@@ -392,6 +460,9 @@ private:
 
   /** Boolean to decide whether or not the transform parameters are written in binary format. */
   bool m_UseBinaryFormatForTransformationParameters{};
+
+  /** The collapsed chain of transforms, see CollapseTransformChain(). */
+  typename CombinationTransformType::Pointer m_CollapsedTransformChain{};
 };
 
 } // end namespace elastix
@@ -23,6 +23,7 @@
 
 #include "itkPointSet.h"
 #include "itkDefaultStaticMeshTraits.h"
+#include "itkTransformixBinaryPointFile.h"
 #include "itkTransformixInputPointFileReader.h"
 #include <itksys/SystemTools.hxx>
 #include "itkVector.h"
@@ -36,12 +37,17 @@
 #include "itkMesh.h"
 #include "itkMeshFileReader.h"
 #include "itkMeshFileWriter.h"
-#include "itkTransformMeshFilter.h"
 #include "itkCommonEnums.h"
+#include "itkAdvancedIdentityTransform.h"
+#include "itkTimeProbe.h"
+#include "itkMultiThreaderBase.h"
 
+#include <algorithm> // For min and max.
 #include <cassert>
 #include <fstream>
 #include <iomanip> // For setprecision.
+#include <sstream> // For ostringstream.
+#include <vector>
 
 
 namespace itk
@@ -260,6 +266,67 @@ TransformBase<TElastix>::BeforeRegistrationBase(void)
 } // end BeforeRegistrationBase()
 
 
+/**
+ * ******************* BeforeEachResolutionBase *******************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::BeforeEachResolutionBase(void)
+{
+  /** Only a combination transform with an initial transform can cache it. */
+  CombinationTransformType * thisAsGrouper = this->GetAsCombinationTransform();
+  if (thisAsGrouper == nullptr || thisAsGrouper->GetInitialTransform() == nullptr)
+  {
+    return;
+  }
+
+  /** Get the current resolution level. */
+  const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+
+  /** Read from the configuration file whether to cache the initial transform in this resolution. */
+  bool cacheInitialTransform = false;
+  this->m_Configuration->ReadParameter(
+    cacheInitialTransform, "CacheInitialTransform", this->GetComponentLabel(), level, 0, false);
+
+  thisAsGrouper->ClearInitialTransformCache();
+  if (!cacheInitialTransform)
+  {
+    return;
+  }
+
+  /** Cache the initial transform on the grid of the fixed image of this resolution,
+   * where most samples are taken.
+   */
+  itk::TimeProbe timer;
+  timer.Start();
+  thisAsGrouper->CacheInitialTransform(
+    this->m_Elastix->GetElxFixedImagePyramidBase()->GetAsITKBaseType()->GetOutput(level));
+  timer.Stop();
+  elxout << "Caching the initial transform for resolution " << level
+         << " took: " << static_cast<unsigned long>(timer.GetMean() * 1000) << " ms." << std::endl;
+
+} // end BeforeEachResolutionBase()
+
+
+/**
+ * ******************* AfterEachResolutionBase *******************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::AfterEachResolutionBase(void)
+{
+  /** The cache is only used while optimizing, so that the final transform is exact. */
+  CombinationTransformType * thisAsGrouper = this->GetAsCombinationTransform();
+  if (thisAsGrouper != nullptr)
+  {
+    thisAsGrouper->ClearInitialTransformCache();
+  }
+
+} // end AfterEachResolutionBase()
+
+
 /**
  * ******************* GetInitialTransform **********************
  */
@@ -972,14 +1039,6 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string filename) c
   /** Get the set of input points. */
   typename PointSetType::Pointer inputPointSet = ippReader->GetOutput();
 
-  /** Create the storage classes. */
-  std::vector<FixedImageIndexType>   inputindexvec(nrofpoints);
-  std::vector<InputPointType>        inputpointvec(nrofpoints);
-  std::vector<OutputPointType>       outputpointvec(nrofpoints);
-  std::vector<FixedImageIndexType>   outputindexfixedvec(nrofpoints);
-  std::vector<MovingImageIndexType>  outputindexmovingvec(nrofpoints);
-  std::vector<DeformationVectorType> deformationvec(nrofpoints);
-
   /** Make a temporary image with the right region info,
    * which we can use to convert between points and indices.
    * By taking the image from the resampler output, the UseDirectionCosines
@@ -997,10 +1056,6 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string filename) c
   dummyImage->SetSpacing(spacing);
   dummyImage->SetDirection(direction);
 
-  /** Temp vars */
-  FixedImageContinuousIndexType  fixedcindex;
-  MovingImageContinuousIndexType movingcindex;
-
   /** Also output moving image indices if a moving image was supplied. */
   bool                              alsoMovingIndices = false;
   typename MovingImageType::Pointer movingImage = this->GetElastix()->GetMovingImage();
@@ -1009,129 +1064,242 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string filename) c
     alsoMovingIndices = true;
   }
 
-  /** Read the input points, as index or as point. */
-  if (!(ippReader->GetPointsAreIndices()))
-  {
-    for (unsigned int j = 0; j < nrofpoints; j++)
-    {
-      /** Compute index of nearest voxel in fixed image. */
-      InputPointType point;
-      point.Fill(0.0f);
-      inputPointSet->GetPoint(j, &point);
-      inputpointvec[j] = point;
-      dummyImage->TransformPhysicalPointToContinuousIndex(point, fixedcindex);
-      for (unsigned int i = 0; i < FixedImageDimension; i++)
-      {
-        inputindexvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
-      }
-    }
-  }
-  else // so: inputasindex
-  {
-    for (unsigned int j = 0; j < nrofpoints; j++)
-    {
-      /** The read point from the inutPointSet is actually an index
-       * Cast to the proper type.
-       */
-      InputPointType point;
-      point.Fill(0.0f);
-      inputPointSet->GetPoint(j, &point);
-      for (unsigned int i = 0; i < FixedImageDimension; i++)
-      {
-        inputindexvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(point[i]));
-      }
-      /** Compute the input point in physical coordinates. */
-      dummyImage->TransformIndexToPhysicalPoint(inputindexvec[j], inputpointvec[j]);
-    }
-  }
-
-  /** Apply the transform. */
-  elxout << "  The input points are transformed." << std::endl;
-  for (unsigned int j = 0; j < nrofpoints; j++)
+  /** Binary input points give binary output points, without the formatting of the text file. */
+  if (ippReader->GetPointsAreBinary())
   {
-    /** Call TransformPoint. */
-    outputpointvec[j] = this->GetAsITKBaseType()->TransformPoint(inputpointvec[j]);
-
-    /** Transform back to index in fixed image domain. */
-    dummyImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], fixedcindex);
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
-    {
-      outputindexfixedvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
-    }
-
-    if (alsoMovingIndices)
-    {
-      /** Transform back to index in moving image domain. */
-      movingImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], movingcindex);
-      for (unsigned int i = 0; i < MovingImageDimension; i++)
-      {
-        outputindexmovingvec[j][i] = static_cast<MovingImageIndexValueType>(itk::Math::Round<double>(movingcindex[i]));
-      }
-    }
-
-    /** Compute displacement. */
-    deformationvec[j].CastFrom(outputpointvec[j] - inputpointvec[j]);
+    this->WriteTransformedPointsBinary(*inputPointSet, ippReader->GetPointsAreIndices(), *dummyImage);
+    return;
   }
 
   /** Create filename and file stream. */
   std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
   outputPointsFileName += "outputpoints.txt";
   std::ofstream outputPointsFile(outputPointsFileName);
-  outputPointsFile << std::showpoint << std::fixed;
+
+  /** Transform the points and format the results concurrently, in blocks of points.
+   * Each work unit formats its part of a block into its own buffer, and the buffers
+   * are written in order, so the output file does not depend on the number of threads.
+   */
+  elxout << "  The input points are transformed." << std::endl;
   elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
 
-  /** Print the results. */
-  for (unsigned int j = 0; j < nrofpoints; j++)
-  {
-    /** The input index. */
-    outputPointsFile << "Point\t" << j << "\t; InputIndex = [ ";
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
+  const bool                 pointsAreIndices = ippReader->GetPointsAreIndices();
+  const ITKBaseType * const  transform = this->GetAsITKBaseType();
+  const PointSetType * const constInputPointSet = inputPointSet;
+  const itk::ThreadIdType    numberOfWorkUnits = this->GetElastix()->GetNumberOfWorkUnits();
+  const unsigned int         blockSize = 65536;
+  std::vector<std::string>   buffers(numberOfWorkUnits);
+
+  for (unsigned int blockBegin = 0; blockBegin < nrofpoints; blockBegin += blockSize)
+  {
+    const unsigned int blockEnd = std::min(blockBegin + blockSize, nrofpoints);
+
+    const std::size_t numberOfPoints = blockEnd - blockBegin;
+    itk::MultiThreaderBase::New()->ParallelizeArray(
+      0,
+      numberOfWorkUnits,
+      [&](const itk::SizeValueType workUnit) {
+        /** The consecutive range of points of this work unit. */
+        const std::size_t begin = numberOfPoints * workUnit / numberOfWorkUnits;
+        const std::size_t end = numberOfPoints * (workUnit + 1) / numberOfWorkUnits;
+
+        /** Temp vars */
+        FixedImageContinuousIndexType  fixedcindex;
+        MovingImageContinuousIndexType movingcindex;
+        FixedImageIndexType            inputindex;
+        InputPointType                 inputpoint;
+        FixedImageIndexType            outputindexfixed;
+        MovingImageIndexType           outputindexmoving;
+
+        std::ostringstream output;
+        output << std::showpoint << std::fixed;
+
+        for (unsigned int j = blockBegin + begin; j < blockBegin + end; ++j)
+        {
+          /** Read the input point, as index or as point. */
+          InputPointType point;
+          point.Fill(0.0f);
+          constInputPointSet->GetPoint(j, &point);
+          if (!pointsAreIndices)
+          {
+            /** Compute index of nearest voxel in fixed image. */
+            inputpoint = point;
+            dummyImage->TransformPhysicalPointToContinuousIndex(point, fixedcindex);
+            for (unsigned int i = 0; i < FixedImageDimension; i++)
+            {
+              inputindex[i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
+            }
+          }
+          else // so: inputasindex
+          {
+            /** The read point from the inutPointSet is actually an index
+             * Cast to the proper type.
+             */
+            for (unsigned int i = 0; i < FixedImageDimension; i++)
+            {
+              inputindex[i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(point[i]));
+            }
+            /** Compute the input point in physical coordinates. */
+            dummyImage->TransformIndexToPhysicalPoint(inputindex, inputpoint);
+          }
+
+          /** Call TransformPoint. */
+          const OutputPointType outputpoint = transform->TransformPoint(inputpoint);
+
+          /** Transform back to index in fixed image domain. */
+          dummyImage->TransformPhysicalPointToContinuousIndex(outputpoint, fixedcindex);
+          for (unsigned int i = 0; i < FixedImageDimension; i++)
+          {
+            outputindexfixed[i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
+          }
+
+          if (alsoMovingIndices)
+          {
+            /** Transform back to index in moving image domain. */
+            movingImage->TransformPhysicalPointToContinuousIndex(outputpoint, movingcindex);
+            for (unsigned int i = 0; i < MovingImageDimension; i++)
+            {
+              outputindexmoving[i] = static_cast<MovingImageIndexValueType>(itk::Math::Round<double>(movingcindex[i]));
+            }
+          }
+
+          /** Compute displacement. */
+          DeformationVectorType deformation;
+          deformation.CastFrom(outputpoint - inputpoint);
+
+          /** The input index. */
+          output << "Point\t" << j << "\t; InputIndex = [ ";
+          for (unsigned int i = 0; i < FixedImageDimension; i++)
+          {
+            output << inputindex[i] << " ";
+          }
+
+          /** The input point. */
+          output << "]\t; InputPoint = [ ";
+          for (unsigned int i = 0; i < FixedImageDimension; i++)
+          {
+            output << inputpoint[i] << " ";
+          }
+
+          /** The output index in fixed image. */
+          output << "]\t; OutputIndexFixed = [ ";
+          for (unsigned int i = 0; i < FixedImageDimension; i++)
+          {
+            output << outputindexfixed[i] << " ";
+          }
+
+          /** The output point. */
+          output << "]\t; OutputPoint = [ ";
+          for (unsigned int i = 0; i < FixedImageDimension; i++)
+          {
+            output << outputpoint[i] << " ";
+          }
+
+          /** The output point minus the input point. */
+          output << "]\t; Deformation = [ ";
+          for (unsigned int i = 0; i < MovingImageDimension; i++)
+          {
+            output << deformation[i] << " ";
+          }
+
+          if (alsoMovingIndices)
+          {
+            /** The output index in moving image. */
+            output << "]\t; OutputIndexMoving = [ ";
+            for (unsigned int i = 0; i < MovingImageDimension; i++)
+            {
+              output << outputindexmoving[i] << " ";
+            }
+          }
+
+          output << "]\n";
+        } // end for points
+
+        buffers[workUnit] = output.str();
+      },
+      nullptr);
+
+    /** Write the formatted block. */
+    for (auto & buffer : buffers)
     {
-      outputPointsFile << inputindexvec[j][i] << " ";
+      outputPointsFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      buffer.clear();
     }
+  } // end for blocks
 
-    /** The input point. */
-    outputPointsFile << "]\t; InputPoint = [ ";
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
-    {
-      outputPointsFile << inputpointvec[j][i] << " ";
-    }
+} // end TransformPointsSomePoints()
 
-    /** The output index in fixed image. */
-    outputPointsFile << "]\t; OutputIndexFixed = [ ";
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
-    {
-      outputPointsFile << outputindexfixedvec[j][i] << " ";
-    }
 
-    /** The output point. */
-    outputPointsFile << "]\t; OutputPoint = [ ";
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
-    {
-      outputPointsFile << outputpointvec[j][i] << " ";
-    }
+/**
+ * ************** WriteTransformedPointsBinary *********************
+ *
+ * Transforms the points of a binary point file, and writes the output
+ * points, in world coordinates, as a binary point file of doubles.
+ */
 
-    /** The output point minus the input point. */
-    outputPointsFile << "]\t; Deformation = [ ";
-    for (unsigned int i = 0; i < MovingImageDimension; i++)
-    {
-      outputPointsFile << deformationvec[j][i] << " ";
-    }
+template <class TElastix>
+template <class TPointSet>
+void
+TransformBase<TElastix>::WriteTransformedPointsBinary(const TPointSet &      inputPointSet,
+                                                      const bool             pointsAreIndices,
+                                                      const FixedImageType & fixedImage) const
+{
+  typedef itk::ContinuousIndex<double, FixedImageDimension> FixedImageContinuousIndexType;
 
-    if (alsoMovingIndices)
-    {
-      /** The output index in moving image. */
-      outputPointsFile << "]\t; OutputIndexMoving = [ ";
-      for (unsigned int i = 0; i < MovingImageDimension; i++)
-      {
-        outputPointsFile << outputindexmovingvec[j][i] << " ";
-      }
-    }
+  /** Create filename and file stream. */
+  std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
+  outputPointsFileName += "outputpoints.bin";
+  std::ofstream outputPointsFile(outputPointsFileName, std::ios::binary);
 
-    outputPointsFile << "]" << std::endl;
-  } // end for nrofpoints
+  elxout << "  The input points are transformed." << std::endl;
+  elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
 
-} // end TransformPointsSomePoints()
+  const std::size_t nrofpoints = inputPointSet.GetNumberOfPoints();
+
+  itk::TransformixBinaryPointFile::HeaderType header;
+  header.m_Dimension = MovingImageDimension;
+  header.m_ComponentSize = sizeof(double);
+  header.m_PointsAreIndices = false;
+  header.m_NumberOfPoints = nrofpoints;
+  itk::TransformixBinaryPointFile::WriteHeader(outputPointsFile, header);
+
+  /** Transform the points concurrently, in blocks of points, and write each block at once. */
+  const ITKBaseType * const transform = this->GetAsITKBaseType();
+  const std::size_t         blockSize = 65536;
+  std::vector<double>       components(std::min(blockSize, nrofpoints) * MovingImageDimension);
+
+  for (std::size_t blockBegin = 0; blockBegin < nrofpoints; blockBegin += blockSize)
+  {
+    const std::size_t blockEnd = std::min(blockBegin + blockSize, nrofpoints);
+
+    itk::MultiThreaderBase::New()->ParallelizeArray(
+      0,
+      blockEnd - blockBegin,
+      [&](const itk::SizeValueType j) {
+        /** Read the input point. Indices of binary files are continuous indices. */
+        InputPointType point;
+        point.Fill(0.0);
+        inputPointSet.GetPoint(blockBegin + j, &point);
+        if (pointsAreIndices)
+        {
+          FixedImageContinuousIndexType cindex;
+          for (unsigned int i = 0; i < FixedImageDimension; i++)
+          {
+            cindex[i] = point[i];
+          }
+          fixedImage.TransformContinuousIndexToPhysicalPoint(cindex, point);
+        }
+
+        const OutputPointType outputpoint = transform->TransformPoint(point);
+        std::copy_n(outputpoint.Begin(), MovingImageDimension, components.data() + j * MovingImageDimension);
+      },
+      nullptr);
+
+    itk::TransformixBinaryPointFile::WriteComponents(
+      outputPointsFile, components.data(), (blockEnd - blockBegin) * MovingImageDimension);
+  } // end for blocks
+
+} // end WriteTransformedPointsBinary()
 
 
 /**
@@ -1156,7 +1324,6 @@ TransformBase<TElastix>::TransformPointsSomePointsVTK(const std::string filename
   typedef itk::Mesh<DummyIPPPixelType, FixedImageDimension, MeshTraitsType>      MeshType;
   typedef itk::MeshFileReader<MeshType>                                          MeshReaderType;
   typedef itk::MeshFileWriter<MeshType>                                          MeshWriterType;
-  typedef itk::TransformMeshFilter<MeshType, MeshType, CombinationTransformType> TransformMeshFilterType;
 
   /** Read the input points. */
   const auto meshReader = MeshReaderType::New();
@@ -1177,14 +1344,22 @@ TransformBase<TElastix>::TransformPointsSomePointsVTK(const std::string filename
   unsigned long nrofpoints = meshReader->GetOutput()->GetNumberOfPoints();
   elxout << "  Number of specified input points: " << nrofpoints << std::endl;
 
-  /** Apply the transform. */
+  /** Apply the transform, concurrently and in place, to the points of the mesh.
+   * The cells and the point data of the mesh are kept as they are. */
   elxout << "  The input points are transformed." << std::endl;
-  const auto meshTransformer = TransformMeshFilterType::New();
-  meshTransformer->SetTransform(const_cast<CombinationTransformType *>(this->GetAsCombinationTransform()));
-  meshTransformer->SetInput(meshReader->GetOutput());
+  const typename MeshType::Pointer           mesh = meshReader->GetOutput();
+  typename MeshType::PointsContainer * const points = mesh->GetPoints();
+  const CombinationTransformType * const     transform = this->GetAsCombinationTransform();
   try
   {
-    meshTransformer->Update();
+    itk::MultiThreaderBase::New()->ParallelizeArray(
+      0,
+      nrofpoints,
+      [points, transform](const itk::SizeValueType j) {
+        auto & point = points->ElementAt(j);
+        point = transform->TransformPoint(point);
+      },
+      nullptr);
   }
   catch (itk::ExceptionObject & err)
   {
@@ -1198,7 +1373,7 @@ TransformBase<TElastix>::TransformPointsSomePointsVTK(const std::string filename
   elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
   const auto meshWriter = MeshWriterType::New();
   meshWriter->SetFileName(outputPointsFileName.c_str());
-  meshWriter->SetInput(meshTransformer->GetOutput());
+  meshWriter->SetInput(mesh);
 
   try
   {
@@ -1225,6 +1400,17 @@ template <class TElastix>
 void
 TransformBase<TElastix>::TransformPointsAllPoints(void) const
 {
+  /** In the executable, a deformation field with stream divisions is written piece by piece,
+   * without ever being in memory as a whole. Then it is not put in the container. */
+  const unsigned int numberOfStreamDivisions = this->GetNumberOfStreamDivisions();
+  if (!BaseComponent::IsElastixLibrary() && numberOfStreamDivisions > 1)
+  {
+    this->RunDeformationFieldPipeline([this, numberOfStreamDivisions](DeformationFieldImageType * const output) {
+      this->WriteDeformationFieldImage(output, numberOfStreamDivisions);
+    });
+    return;
+  }
+
   typename DeformationFieldImageType::Pointer deformationfield = this->GenerateDeformationFieldImage();
   // put deformation field in container
   this->m_Elastix->SetResultDeformationField(deformationfield.GetPointer());
@@ -1248,6 +1434,39 @@ TransformBase<TElastix>::TransformPointsAllPoints(void) const
 template <class TElastix>
 typename TransformBase<TElastix>::DeformationFieldImageType::Pointer
 TransformBase<TElastix>::GenerateDeformationFieldImage(void) const
+{
+  typename DeformationFieldImageType::Pointer deformationfield;
+  try
+  {
+    this->RunDeformationFieldPipeline([&deformationfield](DeformationFieldImageType * const output) {
+      output->Update();
+      deformationfield = output;
+    });
+  }
+  catch (itk::ExceptionObject & excp)
+  {
+    /** Add information to the exception. */
+    excp.SetLocation("TransformBase - GenerateDeformationFieldImage()");
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while generating deformation field image.\n";
+    excp.SetDescription(err_str);
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+  return deformationfield;
+} // end GenerateDeformationFieldImage()
+
+
+/**
+ * ************** RunDeformationFieldPipeline **********************
+ */
+
+template <class TElastix>
+template <class TFunction>
+void
+TransformBase<TElastix>::RunDeformationFieldPipeline(const TFunction & function) const
 {
   /** Typedef's. */
   typedef typename FixedImageType::DirectionType FixedImageDirectionType;
@@ -1262,7 +1481,14 @@ TransformBase<TElastix>::GenerateDeformationFieldImage(void) const
   defGenerator->SetOutputOrigin(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin());
   defGenerator->SetOutputStartIndex(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex());
   defGenerator->SetOutputDirection(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection());
-  defGenerator->SetTransform(const_cast<const ITKBaseType *>(this->GetAsITKBaseType()));
+  if (this->m_CollapsedTransformChain.IsNotNull())
+  {
+    defGenerator->SetTransform(this->m_CollapsedTransformChain.GetPointer());
+  }
+  else
+  {
+    defGenerator->SetTransform(const_cast<const ITKBaseType *>(this->GetAsITKBaseType()));
+  }
 
   /** Possibly change direction cosines to their original value, as specified
    * in the tp-file, or by the fixed image. This is only necessary when
@@ -1278,24 +1504,24 @@ TransformBase<TElastix>::GenerateDeformationFieldImage(void) const
   const auto progressObserver =
     BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(*defGenerator);
 
-  try
-  {
-    infoChanger->Update();
-  }
-  catch (itk::ExceptionObject & excp)
-  {
-    /** Add information to the exception. */
-    excp.SetLocation("TransformBase - GenerateDeformationFieldImage()");
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while generating deformation field image.\n";
-    excp.SetDescription(err_str);
+  function(infoChanger->GetOutput());
 
-    /** Pass the exception to an higher level. */
-    throw excp;
-  }
+} // end RunDeformationFieldPipeline()
 
-  return infoChanger->GetOutput();
-} // end GenerateDeformationFieldImage()
+
+/**
+ * ************** GetNumberOfStreamDivisions **********************
+ */
+
+template <class TElastix>
+unsigned int
+TransformBase<TElastix>::GetNumberOfStreamDivisions(void) const
+{
+  unsigned int numberOfStreamDivisions = 1;
+  this->m_Configuration->ReadParameter(numberOfStreamDivisions, "NumberOfStreamDivisions", 0, false);
+  return std::max(numberOfStreamDivisions, 1u);
+
+} // end GetNumberOfStreamDivisions()
 
 
 /**
@@ -1305,7 +1531,8 @@ TransformBase<TElastix>::GenerateDeformationFieldImage(void) const
 template <class TElastix>
 void
 TransformBase<TElastix>::WriteDeformationFieldImage(
-  typename TransformBase<TElastix>::DeformationFieldImageType::Pointer deformationfield) const
+  typename TransformBase<TElastix>::DeformationFieldImageType::Pointer deformationfield,
+  const unsigned int                                                   numberOfStreamDivisions) const
 {
   typedef itk::ImageFileWriter<DeformationFieldImageType> DeformationFieldWriterType;
 
@@ -1319,6 +1546,7 @@ TransformBase<TElastix>::WriteDeformationFieldImage(
   const auto defWriter = DeformationFieldWriterType::New();
   defWriter->SetInput(deformationfield);
   defWriter->SetFileName(makeFileName.str().c_str());
+  defWriter->SetNumberOfStreamDivisions(numberOfStreamDivisions);
 
   /** Do the writing. */
   elxout << "  Computing and writing the deformation field ..." << std::endl;
@@ -1408,6 +1636,7 @@ TransformBase<TElastix>::ComputeDeterminantOfSpatialJacobian(void) const
   const auto jacWriter = JacobianWriterType::New();
   jacWriter->SetInput(infoChanger->GetOutput());
   jacWriter->SetFileName(makeFileName.str().c_str());
+  jacWriter->SetNumberOfStreamDivisions(this->GetNumberOfStreamDivisions());
 
   /** Do the writing. */
   elxout << "  Computing and writing the spatial Jacobian determinant..." << std::endl;
@@ -1495,6 +1724,7 @@ TransformBase<TElastix>::ComputeSpatialJacobian(void) const
   const auto jacWriter = JacobianWriterType::New();
   jacWriter->SetInput(infoChanger->GetOutput());
   jacWriter->SetFileName(makeFileName.str().c_str());
+  jacWriter->SetNumberOfStreamDivisions(this->GetNumberOfStreamDivisions());
   /** Hack to change the pixel type to vector. Not necessary for mhd. */
   const auto jacStartWriteCommand = PixelTypeChangeCommandType::New();
   if (resultImageFormat != "mhd")
@@ -1523,6 +1753,52 @@ TransformBase<TElastix>::ComputeSpatialJacobian(void) const
 } // end ComputeSpatialJacobian()
 
 
+/**
+ * ************** CollapseTransformChain **********************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::CollapseTransformChain(void)
+{
+  /** Typedef's. */
+  typedef itk::AdvancedIdentityTransform<CoordRepType, FixedImageDimension> IdentityTransformType;
+  typedef typename CombinationTransformType::InitialTransformCacheGridType   GridType;
+
+  CombinationTransformType * thisAsGrouper = this->GetAsCombinationTransform();
+  if (thisAsGrouper == nullptr)
+  {
+    xl::xout["warning"] << "WARNING: The transform chain cannot be collapsed for this transform." << std::endl;
+    return;
+  }
+
+  /** A combination with the same transforms as this one, which does not refer to this
+   * object itself, so that this object does not (indirectly) refer to itself.
+   */
+  const auto chain = CombinationTransformType::New();
+  chain->SetInitialTransform(thisAsGrouper->GetModifiableInitialTransform());
+  chain->SetCurrentTransform(thisAsGrouper->GetModifiableCurrentTransform());
+  chain->SetUseComposition(thisAsGrouper->GetUseComposition());
+
+  /** The output grid of the resampler. */
+  const auto resampler = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType();
+  const auto grid = GridType::New();
+  grid->SetRegions(typename GridType::RegionType(resampler->GetOutputStartIndex(), resampler->GetSize()));
+  grid->SetSpacing(resampler->GetOutputSpacing());
+  grid->SetOrigin(resampler->GetOutputOrigin());
+  grid->SetDirection(resampler->GetOutputDirection());
+
+  /** Cache the whole chain as the initial transform of an identity transform. */
+  this->m_CollapsedTransformChain = CombinationTransformType::New();
+  this->m_CollapsedTransformChain->SetCurrentTransform(IdentityTransformType::New());
+  this->m_CollapsedTransformChain->SetInitialTransform(chain);
+  this->m_CollapsedTransformChain->CacheInitialTransform(grid);
+
+  resampler->SetTransform(this->m_CollapsedTransformChain.GetPointer());
+
+} // end CollapseTransformChain()
+
+
 /**
  * ************** SetTransformParametersFileName ****************
  */
@@ -18,7 +18,9 @@
 #include "elxElastixBase.h"
 #include <Core/elxVersionMacros.h>
 #include <sstream>
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkMultiThreaderBase.h"
+
+#include <algorithm> // For min.
 
 namespace elastix
 {
@@ -150,6 +152,9 @@ ElastixBase::ElastixBase()
   this->m_ResampleInterpolatorContainer = ObjectContainerType::New();
   this->m_TransformContainer = ObjectContainerType::New();
 
+  /** Create the random generator of the registration. It is seeded in BeforeAllBase(). */
+  this->m_RandomGenerator = RandomGeneratorType::New();
+
   /** Create image and mask containers. */
   this->m_FixedImageContainer = DataObjectContainerType::New();
   this->m_MovingImageContainer = DataObjectContainerType::New();
@@ -166,6 +171,7 @@ ElastixBase::ElastixBase()
   /** Initialize initialTransform and final transform. */
   this->m_InitialTransform = nullptr;
   this->m_FinalTransform = nullptr;
+  this->m_FixedImageDataCache = nullptr;
 
   /** From Elastix 4.3 to 4.7: Ignore direction cosines by default, for
    * backward compatability. From Elastix 4.8: set it to true by default.*/
@@ -338,6 +344,13 @@ ElastixBase::BeforeAllBase(void)
     elxout << "-threads  " << check << std::endl;
   }
 
+  /** Check for appearance of -workunits, which limits the work units of this registration. */
+  check = this->GetConfiguration()->GetCommandLineArgument("-workunits");
+  if (check != "")
+  {
+    elxout << "-workunits  " << check << std::endl;
+  }
+
   /** Check the very important UseDirectionCosines parameter. */
   bool retudc = this->GetConfiguration()->ReadParameter(this->m_UseDirectionCosines, "UseDirectionCosines", 0);
   if (!retudc)
@@ -351,11 +364,14 @@ ElastixBase::BeforeAllBase(void)
   /** Set the random seed. Use 121212 as a default, which is the same as
    * the default in the MersenneTwister code.
    * Use silent parameter file readout, to avoid annoying warning when
-   * starting elastix */
-  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
-  typedef RandomGeneratorType::IntegerType                       SeedType;
-  unsigned int                                                   randomSeed = 121212;
+   * starting elastix.
+   * The global generator is still seeded for the ITK classes that use it,
+   * such as the random iterator of the ImageRandomSampler.
+   */
+  typedef RandomGeneratorType::IntegerType SeedType;
+  unsigned int                             randomSeed = 121212;
   this->GetConfiguration()->ReadParameter(randomSeed, "RandomSeed", 0, false);
+  this->m_RandomGenerator->SetSeed(static_cast<SeedType>(randomSeed));
   RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
   randomGenerator->SetSeed(static_cast<SeedType>(randomSeed));
 
@@ -541,6 +557,29 @@ ElastixBase::GetUseDirectionCosines(void) const
 }
 
 
+/**
+ * ******************** GetNumberOfWorkUnits ********************
+ */
+
+itk::ThreadIdType
+ElastixBase::GetNumberOfWorkUnits(void) const
+{
+  itk::ThreadIdType numberOfWorkUnits = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+
+  const std::string maximumNumberOfWorkUnits = this->GetConfiguration()->GetCommandLineArgument("-workunits");
+  if (!maximumNumberOfWorkUnits.empty())
+  {
+    const int maximum = atoi(maximumNumberOfWorkUnits.c_str());
+    if (maximum > 0)
+    {
+      numberOfWorkUnits = std::min(numberOfWorkUnits, static_cast<itk::ThreadIdType>(maximum));
+    }
+  }
+  return numberOfWorkUnits;
+
+} // end GetNumberOfWorkUnits()
+
+
 /**
  * ******************** SetOriginalFixedImageDirectionFlat ********************
  */
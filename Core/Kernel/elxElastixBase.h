@@ -38,7 +38,10 @@
 #include <itkChangeInformationImageFilter.h>
 #include <itkDataObject.h>
 #include <itkImageFileReader.h>
+#include <itkIntTypes.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
 #include <itkObject.h>
+#include <itkSharedDataObjectCache.h>
 #include <itkTimeProbe.h>
 #include <itkVectorContainer.h>
 
@@ -90,7 +93,8 @@ namespace elastix
  * of the images to be registered, is defined in this class.
  *
  * The parameters used by this class are:
- * \parameter RandomSeed: Sets a global seed for the random generator.\n
+ * \parameter RandomSeed: Sets the seed of the random generator of the registration, see
+ *   GetRandomGenerator(), and the seed of the global random generator of ITK.\n
  *   example: <tt>(RandomSeed 121212)</tt>\n
  *   It must be a positive integer number. Default: 121212.
  * \parameter DefaultOutputPrecision: Set the default precision of floating values in the output.
@@ -133,6 +137,13 @@ namespace elastix
  * \commandlinearg -threads: optional argument for both elastix and transformix to
  *    specify the maximum number of threads used by this process. Default: no maximum. \n
  *    example: <tt>-threads 2</tt> \n
+ * \commandlinearg -workunits: optional argument for elastix to specify the maximum number of
+ *    work units of the metric, of the parallel evaluation of the cost function (EvaluateInParallel)
+ *    and of the transformation of points, see GetNumberOfWorkUnits(). Unlike -threads, it does not
+ *    change the global settings of ITK, so registrations that run concurrently in one process can
+ *    each have their own limit. Other ITK filters, like the image pyramids, the resampler and the
+ *    multi-threaded samplers, still use the global default number of threads. Default: no maximum. \n
+ *    example: <tt>-workunits 2</tt> \n
  * \commandlinearg -in: optional argument for transformix with the file name of an input image. \n
  *    example: <tt>-in inputImage.mhd</tt> \n
  *    If this option is skipped, a deformation field of the transform will be generated.
@@ -184,6 +195,9 @@ public:
   /** Typedef's for Timer class. */
   typedef itk::TimeProbe TimerType;
 
+  /** Typedef for the random generator of the registration. */
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
   /** Set/Get the Configuration Object. */
   elxGetObjectMacro(Configuration, ConfigurationType);
   elxSetObjectMacro(Configuration, ConfigurationType);
@@ -236,6 +250,13 @@ public:
   elxSetObjectMacro(ResampleInterpolatorContainer, ObjectContainerType);
   elxSetObjectMacro(TransformContainer, ObjectContainerType);
 
+  /** Get the random generator of the registration. The components draw their random numbers
+   * from it, instead of from the global random generator of ITK, so that registrations that
+   * run concurrently do not share a random sequence. It is seeded with the RandomSeed in
+   * BeforeAllBase(), as the global generator was, so a registration draws the same numbers.
+   */
+  elxGetObjectMacro(RandomGenerator, RandomGeneratorType);
+
   /** Set/Get the fixed/moving image containers. */
   elxGetObjectMacro(FixedImageContainer, DataObjectContainerType);
   elxGetObjectMacro(MovingImageContainer, DataObjectContainerType);
@@ -310,6 +331,13 @@ public:
   elxSetObjectMacro(FinalTransform, ObjectType);
   elxGetObjectMacro(FinalTransform, ObjectType);
 
+  /** Set/Get the optional cache of the data that only depends on the fixed image and mask,
+   * like the levels of the fixed image pyramid. It is shared by the registrations of a batch
+   * that have the same fixed image, mask and parameter maps.
+   */
+  elxSetObjectMacro(FixedImageDataCache, itk::SharedDataObjectCache);
+  elxGetObjectMacro(FixedImageDataCache, itk::SharedDataObjectCache);
+
   /** Empty Run()-function to be overridden. */
   virtual int
   Run(void) = 0;
@@ -369,6 +397,12 @@ public:
   bool
   GetUseDirectionCosines(void) const;
 
+  /** Get the number of work units of the components of this registration: the global default
+   * number of threads of ITK, limited by the -workunits command line argument.
+   */
+  itk::ThreadIdType
+  GetNumberOfWorkUnits(void) const;
+
   /** Set/Get the original fixed image direction as a flat array
    * (d11 d21 d31 d21 d22 etc ) */
   void
@@ -534,6 +568,9 @@ private:
   /** The result image container. These are stored as pointers to itk::DataObject. */
   DataObjectContainerPointer m_ResultImageContainer;
 
+  /** The random generator of the registration. */
+  RandomGeneratorType::Pointer m_RandomGenerator;
+
   /** The result deformation field container. These are stored as pointers to itk::DataObject. */
   DataObjectContainerPointer m_ResultDeformationFieldContainer;
 
@@ -547,6 +584,9 @@ private:
   ObjectPointer m_InitialTransform;
   ObjectPointer m_FinalTransform;
 
+  /** The cache of the fixed image data, shared by the registrations of a batch. */
+  itk::SharedDataObjectCache::Pointer m_FixedImageDataCache;
+
   /** Use or ignore direction cosines. */
   bool m_UseDirectionCosines;
 };
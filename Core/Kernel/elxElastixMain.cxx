@@ -34,52 +34,71 @@
 #  include "itkOpenCLSetup.h"
 #endif
 
-namespace
+namespace elastix
 {
 
-using namespace xl;
-
 /**
- * ******************* Global variables *************************
+ * ********************* xoutManager::Data **********************
  *
- * Some global variables (not part of the ElastixMain class, used
- * by xoutSetup.
+ * The logging context of a registration: the xout object, its target cells
+ * and the log file. The console output goes through a synchronized stream
+ * buffer, so that the lines of concurrent registrations do not interleave.
  */
 
-struct Data
+struct xoutManager::Data
 {
+  Data()
+    : CoutBuffer(std::cout)
+    , CoutStream(&CoutBuffer)
+  {}
+
   /** xout TargetCells. */
-  xoutbase_type   Xout;
-  xoutsimple_type WarningXout;
-  xoutsimple_type ErrorXout;
-  xoutsimple_type StandardXout;
-  xoutsimple_type CoutOnlyXout;
-  xoutsimple_type LogOnlyXout;
-  std::ofstream   LogFileStream;
+  xl::xoutbase_type            Xout;
+  xl::xoutsimple_type          WarningXout;
+  xl::xoutsimple_type          ErrorXout;
+  xl::xoutsimple_type          StandardXout;
+  xl::xoutsimple_type          CoutOnlyXout;
+  xl::xoutsimple_type          LogOnlyXout;
+  std::ofstream                LogFileStream;
+  xl::xoutsynchronizedbuf_type CoutBuffer;
+  std::ostream                 CoutStream;
 };
 
-Data g_data;
+} // end namespace elastix
 
-} // end unnamed namespace
+
+namespace
+{
+
+using namespace xl;
 
 /**
- * ********************* xoutSetup ******************************
+ * ******************* Global variables *************************
  *
- * NB: this function is a global function, not part of the ElastixMain
- * class!!
+ * The logging context that is set up by xoutSetup. It is thread-local,
+ * so that each thread that calls xoutSetup has its own logging.
+ */
+
+thread_local std::unique_ptr<elastix::xoutManager::Data> t_data;
+
+/**
+ * ********************* SetupData ******************************
+ *
+ * Adds the default fields to the xout object of the logging context,
+ * and sets their outputs to the console and/or the log file.
  */
 
 int
-elastix::xoutSetup(const char * logfilename, bool setupLogging, bool setupCout)
+SetupData(elastix::xoutManager::Data & data, const char * logfilename, bool setupLogging, bool setupCout)
 {
-  int returndummy = 0;
-  set_xout(&g_data.Xout);
+  int             returndummy = 0;
+  xoutbase_type & dataXout = data.Xout;
 
   if (setupLogging)
   {
     /** Open the logfile for writing. */
-    g_data.LogFileStream.open(logfilename);
-    if (!g_data.LogFileStream.is_open())
+    data.LogFileStream.open(logfilename);
+    if (!data.LogFileStream.is_open())
     {
       std::cerr << "ERROR: LogFile cannot be opened!" << std::endl;
       return 1;
@@ -89,40 +108,62 @@ elastix::xoutSetup(const char * logfilename, bool setupLogging, bool setupCout)
   /** Set std::cout and the logfile as outputs of xout. */
   if (setupLogging)
   {
-    returndummy |= xout.AddOutput("log", &g_data.LogFileStream);
+    returndummy |= dataXout.AddOutput("log", &data.LogFileStream);
   }
   if (setupCout)
   {
-    returndummy |= xout.AddOutput("cout", &std::cout);
+    returndummy |= dataXout.AddOutput("cout", &data.CoutStream);
   }
 
   /** Set outputs of LogOnly and CoutOnly. */
-  returndummy |= g_data.LogOnlyXout.AddOutput("log", &g_data.LogFileStream);
-  returndummy |= g_data.CoutOnlyXout.AddOutput("cout", &std::cout);
+  returndummy |= data.LogOnlyXout.AddOutput("log", &data.LogFileStream);
+  returndummy |= data.CoutOnlyXout.AddOutput("cout", &data.CoutStream);
 
   /** Copy the outputs to the warning-, error- and standard-xouts. */
-  g_data.WarningXout.SetOutputs(xout.GetCOutputs());
-  g_data.ErrorXout.SetOutputs(xout.GetCOutputs());
-  g_data.StandardXout.SetOutputs(xout.GetCOutputs());
+  data.WarningXout.SetOutputs(dataXout.GetCOutputs());
+  data.ErrorXout.SetOutputs(dataXout.GetCOutputs());
+  data.StandardXout.SetOutputs(dataXout.GetCOutputs());
 
-  g_data.WarningXout.SetOutputs(xout.GetXOutputs());
-  g_data.ErrorXout.SetOutputs(xout.GetXOutputs());
-  g_data.StandardXout.SetOutputs(xout.GetXOutputs());
+  data.WarningXout.SetOutputs(dataXout.GetXOutputs());
+  data.ErrorXout.SetOutputs(dataXout.GetXOutputs());
+  data.StandardXout.SetOutputs(dataXout.GetXOutputs());
 
   /** Link the warning-, error- and standard-xouts to xout. */
-  returndummy |= xout.AddTargetCell("warning", &g_data.WarningXout);
-  returndummy |= xout.AddTargetCell("error", &g_data.ErrorXout);
-  returndummy |= xout.AddTargetCell("standard", &g_data.StandardXout);
-  returndummy |= xout.AddTargetCell("logonly", &g_data.LogOnlyXout);
-  returndummy |= xout.AddTargetCell("coutonly", &g_data.CoutOnlyXout);
+  returndummy |= dataXout.AddTargetCell("warning", &data.WarningXout);
+  returndummy |= dataXout.AddTargetCell("error", &data.ErrorXout);
+  returndummy |= dataXout.AddTargetCell("standard", &data.StandardXout);
+  returndummy |= dataXout.AddTargetCell("logonly", &data.LogOnlyXout);
+  returndummy |= dataXout.AddTargetCell("coutonly", &data.CoutOnlyXout);
 
   /** Format the output. */
-  xout["standard"] << std::fixed;
-  xout["standard"] << std::showpoint;
+  dataXout["standard"] << std::fixed;
+  dataXout["standard"] << std::showpoint;
 
   /** Return a value. */
   return returndummy;
 
+} // end SetupData()
+
+} // end unnamed namespace
+
+
+/**
+ * ********************* xoutSetup ******************************
+ *
+ * NB: this function is a global function, not part of the ElastixMain
+ * class!!
+ */
+
+int
+elastix::xoutSetup(const char * logfilename, bool setupLogging, bool setupCout)
+{
+  /** Replace the logging context of the calling thread. */
+  set_xout(nullptr);
+  t_data.reset(new xoutManager::Data);
+  set_xout(&t_data->Xout);
+
+  return SetupData(*t_data, logfilename, setupLogging, setupCout);
+
 } // end xoutSetup()
 
 
@@ -134,16 +175,30 @@ namespace elastix
  */
 
 xoutManager::xoutManager(const std::string & logFileName, const bool setupLogging, const bool setupCout)
+  : m_Data(new Data)
+  , m_PreviousXout(xout_valid() ? &get_xout() : nullptr)
 {
-  if (xoutSetup(logFileName.c_str(), setupLogging, setupCout))
+  set_xout(&this->m_Data->Xout);
+  if (SetupData(*this->m_Data, logFileName.c_str(), setupLogging, setupCout))
   {
+    set_xout(this->m_PreviousXout);
     itkGenericExceptionMacro("Error while setting up xout");
   }
 }
 
-xoutManager::Guard::~Guard()
+xoutManager::~xoutManager()
 {
-  g_data = {};
+  if (this->m_Data)
+  {
+    /** Restore the xout of the enclosing scope, if any. */
+    set_xout(this->m_PreviousXout);
+  }
+  else if (t_data)
+  {
+    /** Close the logging context that was set up by xoutSetup. */
+    set_xout(nullptr);
+    t_data.reset();
+  }
 }
 
 
@@ -176,6 +231,7 @@ ElastixMain::ElastixMain()
 
   this->m_FinalTransform = nullptr;
   this->m_InitialTransform = nullptr;
+  this->m_FixedImageDataCache = nullptr;
   this->m_TransformParametersMap.clear();
 
 } // end Constructor
@@ -188,6 +244,7 @@ ElastixMain::ElastixMain()
 // Both s_CDB and s_ComponentLoader are defaulted-constructed to null.
 ElastixMain::ComponentDatabasePointer ElastixMain::s_CDB;
 ElastixMain::ComponentLoaderPointer   ElastixMain::s_ComponentLoader;
+std::mutex                            ElastixMain::s_CDBMutex;
 
 /**
  * ********************** Destructor ****************************
@@ -338,7 +395,7 @@ ElastixMain::Run(void)
 
   /** Set some information in the ElastixBase. */
   this->GetElastixBase()->SetConfiguration(this->m_Configuration);
-  this->GetElastixBase()->SetComponentDatabase(this->s_CDB);
+  this->GetElastixBase()->SetComponentDatabase(this->m_CDB);
   this->GetElastixBase()->SetDBIndex(this->m_DBIndex);
 
   /** Populate the component containers. ImageSampler is not mandatory.
@@ -390,6 +447,9 @@ ElastixMain::Run(void)
   /** Set the initial transform, if it happens to be there. */
   this->GetElastixBase()->SetInitialTransform(this->GetModifiableInitialTransform());
 
+  /** Set the cache of the fixed image data, if it is shared with other registrations. */
+  this->GetElastixBase()->SetFixedImageDataCache(this->GetModifiableFixedImageDataCache());
+
   /** Set the original fixed image direction cosines (relevant in case the
    * UseDirectionCosines parameter was set to false.
    */
@@ -635,31 +695,25 @@ ElastixMain::InitDBIndex(void)
       }
     }
 
-    /** Load the components. */
-    if (this->s_CDB.IsNull())
+    /** Load the components, if that has not been done yet. */
+    int loadReturnCode = this->LoadComponents();
+    if (loadReturnCode != 0)
     {
-      int loadReturnCode = this->LoadComponents();
-      if (loadReturnCode != 0)
-      {
-        xout["error"] << "Loading components failed" << std::endl;
-        return loadReturnCode;
-      }
+      xout["error"] << "Loading components failed" << std::endl;
+      return loadReturnCode;
     }
 
-    if (this->s_CDB.IsNotNull())
+    /** Get the DBIndex from the ComponentDatabase. */
+    this->m_DBIndex = this->m_CDB->GetIndex(this->m_FixedImagePixelType,
+                                            this->m_FixedImageDimension,
+                                            this->m_MovingImagePixelType,
+                                            this->m_MovingImageDimension);
+    if (this->m_DBIndex == 0)
     {
-      /** Get the DBIndex from the ComponentDatabase. */
-      this->m_DBIndex = this->s_CDB->GetIndex(this->m_FixedImagePixelType,
-                                              this->m_FixedImageDimension,
-                                              this->m_MovingImagePixelType,
-                                              this->m_MovingImageDimension);
-      if (this->m_DBIndex == 0)
-      {
-        xout["error"] << "ERROR:" << std::endl;
-        xout["error"] << "Something went wrong in the ComponentDatabase" << std::endl;
-        return 1;
-      }
-    } // end if s_CDB!=0
+      xout["error"] << "ERROR:" << std::endl;
+      xout["error"] << "Something went wrong in the ComponentDatabase" << std::endl;
+      return 1;
+    }
 
   } // end if m_Configuration->Initialized();
   else
@@ -727,6 +781,32 @@ ElastixMain::GetTotalNumberOfElastixLevels(void)
 } // end GetTotalNumberOfElastixLevels()
 
 
+/**
+ * ********************* GetComponentDatabase ********************
+ */
+
+ComponentDatabase *
+ElastixMain::GetComponentDatabase(void)
+{
+  const std::lock_guard<std::mutex> lock(s_CDBMutex);
+  return s_CDB.GetPointer();
+
+} // end GetComponentDatabase()
+
+
+/**
+ * ********************* SetComponentDatabase ********************
+ */
+
+void
+ElastixMain::SetComponentDatabase(ComponentDatabase * arg)
+{
+  const std::lock_guard<std::mutex> lock(s_CDBMutex);
+  s_CDB = arg;
+
+} // end SetComponentDatabase()
+
+
 /**
  * ********************* LoadComponents **************************
  *
@@ -737,37 +817,54 @@ ElastixMain::GetTotalNumberOfElastixLevels(void)
 int
 ElastixMain::LoadComponents(void)
 {
-  /** Create a ComponentDatabase. */
-  if (this->s_CDB.IsNull())
-  {
-    this->s_CDB = ComponentDatabaseType::New();
-  }
+  const std::lock_guard<std::mutex> lock(s_CDBMutex);
 
-  /** Create a ComponentLoader and set the database. */
-  if (this->s_ComponentLoader.IsNull())
+  /** The components are loaded only once, by the first instance that needs them. */
+  if (s_CDB.IsNull())
   {
-    this->s_ComponentLoader = ComponentLoaderType::New();
-    this->s_ComponentLoader->SetComponentDatabase(s_CDB);
+    /** Create a ComponentDatabase, and only share it after it is completely filled. */
+    const ComponentDatabasePointer componentDatabase = ComponentDatabaseType::New();
+
+    /** Create a ComponentLoader and set the database. */
+    if (s_ComponentLoader.IsNull())
+    {
+      s_ComponentLoader = ComponentLoaderType::New();
+    }
+    s_ComponentLoader->SetComponentDatabase(componentDatabase);
+
+    /** Load the components. */
+    const int loadReturnCode = s_ComponentLoader->LoadComponents();
+    if (loadReturnCode != 0)
+    {
+      /** Let a next attempt start from scratch. */
+      s_ComponentLoader = nullptr;
+      return loadReturnCode;
+    }
+    s_CDB = componentDatabase;
   }
 
-  /** Load the components. */
-  return this->s_ComponentLoader->LoadComponents();
+  this->m_CDB = s_CDB;
+  return 0;
 
 } // end LoadComponents()
 
 
 /**
  * ********************* UnloadComponents **************************
+ *
+ * Instances that are still running keep their own reference to the database.
  */
 
 void
 ElastixMain::UnloadComponents(void)
 {
+  const std::lock_guard<std::mutex> lock(s_CDBMutex);
+
   s_CDB = nullptr;
-  s_ComponentLoader->SetComponentDatabase(nullptr);
 
   if (s_ComponentLoader)
   {
+    s_ComponentLoader->SetComponentDatabase(nullptr);
     s_ComponentLoader->UnloadComponents();
   }
 
@@ -806,7 +903,7 @@ ElastixMain::CreateComponent(const ComponentDescriptionType & name)
 {
   /** A pointer to the New() function. */
   PtrToCreator testcreator = nullptr;
-  testcreator = this->s_CDB->GetCreator(name, this->m_DBIndex);
+  testcreator = this->m_CDB->GetCreator(name, this->m_DBIndex);
 
   // Note that ObjectPointer() yields a default-constructed SmartPointer (null).
   ObjectPointer testpointer = testcreator ? testcreator() : ObjectPointer();
@@ -29,6 +29,8 @@
 // Standard C++ header files:
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 
 
@@ -56,6 +58,11 @@ xoutSetup(const char * logfilename, bool setupLogging, bool setupCout);
 
 
 /** Manages setting up and closing the "xout" output streams.
+ *
+ * An xoutManager that is constructed with a log file name owns its own logging
+ * context, which it installs as the xout of the calling thread, until it is
+ * destructed. So registrations that run concurrently in different threads,
+ * each with their own manager, do not share their logging.
  */
 class xoutManager
 {
@@ -65,21 +72,19 @@ public:
   /** This explicit constructor does set up the "xout" output streams. */
   explicit xoutManager(const std::string & logfilename, const bool setupLogging, const bool setupCout);
 
-  /** The default-constructor only just constructs a manager object */
+  /** The default-constructor only just constructs a manager object, which closes
+   * the "xout" output streams that are set up by xoutSetup, on destruction. */
   xoutManager() = default;
 
   /** The destructor closes the "xout" output streams. */
-  ~xoutManager() = default;
+  ~xoutManager();
+
+  /** The logging context: the xout object, its target cells and the log file. */
+  struct Data;
 
 private:
-  struct Guard
-  {
-    ITK_DISALLOW_COPY_AND_ASSIGN(Guard);
-    Guard() = default;
-    ~Guard();
-  };
-
-  const Guard m_Guard{};
+  const std::unique_ptr<Data> m_Data{};
+  xl::xoutbase_type * const   m_PreviousXout{};
 };
 
 
@@ -244,6 +249,12 @@ public:
   itkSetObjectMacro(InitialTransform, ObjectType);
   itkGetModifiableObjectMacro(InitialTransform, ObjectType);
 
+  /** Set/Get the optional cache of the fixed image data, which is shared by the
+   * registrations of a batch that have the same fixed image, mask and parameter maps.
+   */
+  itkSetObjectMacro(FixedImageDataCache, itk::SharedDataObjectCache);
+  itkGetModifiableObjectMacro(FixedImageDataCache, itk::SharedDataObjectCache);
+
   /** Set/Get the original fixed image direction as a flat array
    * (d11 d21 d31 d21 d22 etc ) */
   virtual void
@@ -315,22 +326,15 @@ public:
   virtual void
   SetMaximumNumberOfThreads(void) const;
 
-  /** Functions to get/set the ComponentDatabase. */
+  /** Functions to get/set the ComponentDatabase that is shared by all instances.
+   * An instance keeps using the database that it got in InitDBIndex(), also when
+   * the shared database is replaced or unloaded while it runs.
+   */
   static ComponentDatabase *
-  GetComponentDatabase(void)
-  {
-    return s_CDB.GetPointer();
-  }
-
+  GetComponentDatabase(void);
 
   static void
-  SetComponentDatabase(ComponentDatabase * arg)
-  {
-    if (s_CDB != arg)
-    {
-      s_CDB = arg;
-    }
-  }
+  SetComponentDatabase(ComponentDatabase * arg);
 
 
   /** GetTransformParametersMap */
@@ -376,6 +380,9 @@ protected:
 
   /** The initial transform. */
   ObjectPointer m_InitialTransform;
+
+  /** The cache of the fixed image data. */
+  itk::SharedDataObjectCache::Pointer m_FixedImageDataCache;
   /** Transformation parameters map containing parameters that is the
    *  result of registration.
    */
@@ -383,8 +390,19 @@ protected:
 
   FlatDirectionCosinesType m_OriginalFixedImageDirection;
 
+  /** The component database of this instance. */
+  ComponentDatabasePointer m_CDB;
+
+  /** The component database that is shared by all instances, and its loader.
+   * They are only accessed while holding s_CDBMutex.
+   */
   static ComponentDatabasePointer s_CDB;
   static ComponentLoaderPointer   s_ComponentLoader;
+  static std::mutex               s_CDBMutex;
+
+  /** Loads the components into the shared component database, if that has not been
+   * done yet, and makes it the database of this instance. Safe to call concurrently.
+   */
   virtual int
   LoadComponents(void);
 
@@ -316,6 +316,23 @@ ElastixTemplate<TFixedImage, TMovingImage>::ApplyTransform(void)
   timer.Stop();
   elxout << "  Calling all ReadFromFile()'s took " << timer.GetMean() << " s" << std::endl;
 
+  /** Optionally collapse the chain of transforms, when both the deformation field
+   * and the resampled image are computed, which then both use the collapsed chain.
+   * For only one of them, the chain is evaluated once per voxel anyway.
+   */
+  bool collapseTransformChain = false;
+  this->GetConfiguration()->ReadParameter(collapseTransformChain, "CollapseTransformChain", 0, false);
+  if (collapseTransformChain && this->GetMovingImage() != nullptr &&
+      this->GetConfiguration()->GetCommandLineArgument("-def") == "all")
+  {
+    timer.Reset();
+    timer.Start();
+    elxout << "Collapsing the transform chain ..." << std::endl;
+    this->GetElxTransformBase()->CollapseTransformChain();
+    timer.Stop();
+    elxout << "  Collapsing the transform chain took " << this->ConvertSecondsToDHMS(timer.GetMean(), 2) << std::endl;
+  }
+
   /** Call TransformPoints.
    * Actually we could loop over all transforms.
    * But for now, there seems to be no use yet for that.
@@ -104,7 +104,7 @@ TransformixMain::Run(void)
 
   /** Set some information in the ElastixBase. */
   this->GetElastixBase()->SetConfiguration(this->m_Configuration);
-  this->GetElastixBase()->SetComponentDatabase(this->s_CDB);
+  this->GetElastixBase()->SetComponentDatabase(this->m_CDB);
   this->GetElastixBase()->SetDBIndex(this->m_DBIndex);
 
   /** Populate the component containers. No default is specified for the Transform. */
@@ -152,6 +152,13 @@ TransformixMain::Run(void)
   this->SetResultImageContainer(this->GetElastixBase()->GetResultImageContainer());
   this->SetResultDeformationFieldContainer(this->GetElastixBase()->GetResultDeformationFieldContainer());
 
+  /** Save the transform, so that library users can apply it to points in memory. */
+  const ObjectContainerType * const transformContainer = this->GetElastixBase()->GetTransformContainer();
+  if (transformContainer != nullptr && transformContainer->Size() > 0)
+  {
+    this->m_FinalTransform = transformContainer->ElementAt(0);
+  }
+
   return errorCode;
 
 } // end Run()
@@ -268,31 +275,25 @@ TransformixMain::InitDBIndex(void)
       }
     }
 
-    /** Load the components. */
-    if (this->s_CDB.IsNull())
+    /** Load the components, if that has not been done yet. */
+    int loadReturnCode = this->LoadComponents();
+    if (loadReturnCode != 0)
     {
-      int loadReturnCode = this->LoadComponents();
-      if (loadReturnCode != 0)
-      {
-        xl::xout["error"] << "Loading components failed" << std::endl;
-        return loadReturnCode;
-      }
+      xl::xout["error"] << "Loading components failed" << std::endl;
+      return loadReturnCode;
     }
 
-    if (this->s_CDB.IsNotNull())
+    /** Get the DBIndex from the ComponentDatabase. */
+    this->m_DBIndex = this->m_CDB->GetIndex(this->m_FixedImagePixelType,
+                                            this->m_FixedImageDimension,
+                                            this->m_MovingImagePixelType,
+                                            this->m_MovingImageDimension);
+    if (this->m_DBIndex == 0)
     {
-      /** Get the DBIndex from the ComponentDatabase. */
-      this->m_DBIndex = this->s_CDB->GetIndex(this->m_FixedImagePixelType,
-                                              this->m_FixedImageDimension,
-                                              this->m_MovingImagePixelType,
-                                              this->m_MovingImageDimension);
-      if (this->m_DBIndex == 0)
-      {
-        xl::xout["error"] << "ERROR:" << std::endl;
-        xl::xout["error"] << "Something went wrong in the ComponentDatabase." << std::endl;
-        return 1;
-      }
-    } // end if s_CDB!=0
+      xl::xout["error"] << "ERROR:" << std::endl;
+      xl::xout["error"] << "Something went wrong in the ComponentDatabase." << std::endl;
+      return 1;
+    }
 
   } // end if m_Configuration->Initialized();
   else
@@ -0,0 +1,73 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxCoreMainGTestUtilities_h
+#define elxCoreMainGTestUtilities_h
+
+#include <elxParameterObject.h>
+#include <itkImage.h>
+#include <itkImageRegionRange.h>
+
+#include <algorithm> // For fill.
+#include <iterator>  // For begin and end.
+
+namespace elastix
+{
+namespace CoreMainGTestUtilities
+{
+
+/** The size of the small test images, and of the block of ones in them. */
+constexpr unsigned int TestImageDimension = 2;
+typedef itk::Image<float, TestImageDimension> TestImageType;
+
+/** Creates a small (5x6) image of zeros, with a 2x2 block of ones at regionIndex.
+ * Registering two of these images gives the translation between their blocks.
+ */
+inline TestImageType::Pointer
+CreateImageWithBlock(const TestImageType::IndexType & regionIndex)
+{
+  const TestImageType::SizeType imageSize{ { 5, 6 } };
+  const auto                    regionSize = TestImageType::SizeType::Filled(2);
+
+  const auto image = TestImageType::New();
+  image->SetRegions(imageSize);
+  image->Allocate(true);
+  const TestImageType::RegionType                          region{ regionIndex, regionSize };
+  const itk::Experimental::ImageRegionRange<TestImageType> regionRange{ *image, region };
+  std::fill(std::begin(regionRange), std::end(regionRange), 1.0f);
+  return image;
+}
+
+
+/** Creates the parameter map of a short translation registration of two images of CreateImageWithBlock(). */
+inline ParameterObject::ParameterMapType
+CreateTranslationParameterMap(void)
+{
+  return {
+    // Parameters in alphabetic order:
+    { "ImageSampler", { "Full" } },
+    { "MaximumNumberOfIterations", { "2" } },
+    { "Metric", { "AdvancedNormalizedCorrelation" } },
+    { "Optimizer", { "AdaptiveStochasticGradientDescent" } },
+    { "Transform", { "TranslationTransform" } }
+  };
+}
+
+} // end namespace CoreMainGTestUtilities
+} // end namespace elastix
+
+#endif // end #ifndef elxCoreMainGTestUtilities_h
@@ -0,0 +1,150 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include <itkElastixBatchRegistrationMethod.h>
+#include "elxCoreMainGTestUtilities.h"
+#include <itkMultiThreaderBase.h>
+
+// GoogleTest header file:
+#include <gtest/gtest.h>
+
+#include <cmath> // For round
+#include <string>
+#include <vector>
+
+
+namespace
+{
+using namespace elastix::CoreMainGTestUtilities;
+using ImageType = TestImageType;
+using IndexType = ImageType::IndexType;
+using OffsetType = ImageType::OffsetType;
+using BatchType = itk::ElastixBatchRegistrationMethod<ImageType, ImageType>;
+
+const IndexType  fixedImageRegionIndex{ { 1, 3 } };
+const OffsetType translationOffsets[] = { { { 1, -2 } }, { { -1, -2 } }, { { 1, -1 } },
+                                          { { 0, -2 } }, { { 1, 0 } },   { { -1, -1 } } };
+
+
+/** Returns the rounded transform parameters of the registration of one of the translated images. */
+std::vector<double>
+GetRoundedTransformParameters(const elastix::ParameterObject & transformParameterObject)
+{
+  std::vector<double> roundedParameters;
+  const auto &        transformParameterMaps = transformParameterObject.GetParameterMap();
+  if (!transformParameterMaps.empty())
+  {
+    const auto found = transformParameterMaps.back().find("TransformParameters");
+    if (found != transformParameterMaps.back().cend())
+    {
+      for (const auto & parameter : found->second)
+      {
+        roundedParameters.push_back(std::round(std::stod(parameter)));
+      }
+    }
+  }
+  return roundedParameters;
+}
+
+
+/** Runs a batch that registers the fixed image to all translated images. */
+BatchType::Pointer
+RunBatch(const elastix::ParameterObject::ParameterMapType & parameterMap,
+         const unsigned int                                 numberOfConcurrentRegistrations)
+{
+  const auto parameterObject = elastix::ParameterObject::New();
+  parameterObject->SetParameterMap(parameterMap);
+
+  const auto batch = BatchType::New();
+  batch->SetFixedImage(CreateImageWithBlock(fixedImageRegionIndex));
+  for (const auto & translationOffset : translationOffsets)
+  {
+    batch->AddMovingImage(CreateImageWithBlock(fixedImageRegionIndex + translationOffset));
+  }
+  batch->SetParameterObject(parameterObject);
+  batch->SetNumberOfConcurrentRegistrations(numberOfConcurrentRegistrations);
+  batch->Update();
+  return batch;
+}
+
+} // namespace
+
+
+// Tests registering one small (5x6) binary image to several translated versions of it, in one batch.
+GTEST_TEST(itkElastixBatchRegistrationMethod, Translations)
+{
+  const itk::ThreadIdType numberOfThreads = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+
+  for (const unsigned int numberOfConcurrentRegistrations : { 0u, 3u })
+  {
+    const auto batch = RunBatch(CreateTranslationParameterMap(), numberOfConcurrentRegistrations);
+
+    /** The batch passes the number of work units to each registration, instead of changing the global default. */
+    EXPECT_EQ(itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads(), numberOfThreads);
+    ASSERT_EQ(batch->GetNumberOfMovingImages(), 6u);
+
+    for (unsigned int n = 0; n < batch->GetNumberOfMovingImages(); ++n)
+    {
+      SCOPED_TRACE("Moving image " + std::to_string(n));
+      ASSERT_NE(batch->GetResultImage(n), nullptr);
+      ASSERT_EQ(batch->GetTransformParameterObject(n)->GetParameterMap().size(), 1u);
+
+      const std::vector<double> transformParameters =
+        GetRoundedTransformParameters(*batch->GetTransformParameterObject(n));
+      ASSERT_EQ(transformParameters.size(), TestImageDimension);
+
+      for (unsigned i{}; i < TestImageDimension; ++i)
+      {
+        EXPECT_EQ(transformParameters[i], translationOffsets[n][i]);
+      }
+    }
+  }
+}
+
+
+// Tests that the registrations of a batch, which share the levels of the fixed image pyramid,
+// give the same results as separate registrations, which compute their own pyramid.
+GTEST_TEST(itkElastixBatchRegistrationMethod, SharedFixedImagePyramid)
+{
+  auto parameterMap = CreateTranslationParameterMap();
+  parameterMap["FixedImagePyramidSchedule"] = { "2", "2", "1", "1" };
+  parameterMap["NumberOfResolutions"] = { "2" };
+
+  const auto batch = RunBatch(parameterMap, 3);
+
+  for (unsigned int n = 0; n < batch->GetNumberOfMovingImages(); ++n)
+  {
+    SCOPED_TRACE("Moving image " + std::to_string(n));
+
+    const auto parameterObject = elastix::ParameterObject::New();
+    parameterObject->SetParameterMap(parameterMap);
+
+    const auto registration = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+    registration->SetFixedImage(CreateImageWithBlock(fixedImageRegionIndex));
+    registration->SetMovingImage(CreateImageWithBlock(fixedImageRegionIndex + translationOffsets[n]));
+    registration->SetParameterObject(parameterObject);
+    registration->Update();
+
+    const std::vector<double> expectedParameters =
+      GetRoundedTransformParameters(*registration->GetTransformParameterObject());
+    ASSERT_EQ(expectedParameters.size(), TestImageDimension);
+    EXPECT_EQ(GetRoundedTransformParameters(*batch->GetTransformParameterObject(n)), expectedParameters);
+  }
+}
@@ -19,16 +19,26 @@
 
 // First include the header file to be tested:
 #include <itkElastixRegistrationMethod.h>
+#include "elxCoreMainGTestUtilities.h"
 #include <itkImage.h>
 #include <itkImageRegionRange.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkMultiThreaderBase.h>
+#include <itksys/SystemTools.hxx>
+#include "xoutmain.h"
 
 // GoogleTest header file:
 #include <gtest/gtest.h>
 
 #include <algorithm> // For transform
+#include <atomic>
+#include <fstream>
 #include <map>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <utility> // For pair
+#include <vector>
 
 
 // Tests registering two small (5x6) binary images, which are translated with respect to each other.
@@ -108,3 +118,401 @@ GTEST_TEST(itkElastixRegistrationMethod, Translation)
     EXPECT_EQ(std::round(std::stod(transformParameters[i])), translationOffset[i]);
   }
 }
+
+
+// Tests running several registrations of small (5x6) binary images concurrently, each in its own thread.
+GTEST_TEST(itkElastixRegistrationMethod, ConcurrentTranslations)
+{
+  using namespace elastix::CoreMainGTestUtilities;
+  using ImageType = TestImageType;
+  using IndexType = ImageType::IndexType;
+  using OffsetType = ImageType::OffsetType;
+  constexpr auto ImageDimension = TestImageDimension;
+
+  const IndexType                                  fixedImageRegionIndex{ { 1, 3 } };
+  const elastix::ParameterObject::ParameterMapType parameterMap = CreateTranslationParameterMap();
+
+  const OffsetType translationOffsets[] = { { { 1, -2 } }, { { -1, -2 } }, { { 1, -1 } }, { { 0, -2 } },
+                                            { { 1, 0 } },  { { -1, -1 } }, { { 0, -1 } }, { { 1, -2 } } };
+  constexpr auto numberOfRegistrations = sizeof(translationOffsets) / sizeof(translationOffsets[0]);
+
+  std::vector<std::vector<std::string>> results(numberOfRegistrations);
+  std::vector<std::string>              errors(numberOfRegistrations);
+  std::vector<std::thread>              threads;
+
+  for (unsigned int n = 0; n < numberOfRegistrations; ++n)
+  {
+    threads.emplace_back([&, n] {
+      try
+      {
+        const auto parameterObject = elastix::ParameterObject::New();
+        parameterObject->SetParameterMap(parameterMap);
+
+        const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+        filter->SetFixedImage(CreateImageWithBlock(fixedImageRegionIndex));
+        filter->SetMovingImage(CreateImageWithBlock(fixedImageRegionIndex + translationOffsets[n]));
+        filter->SetParameterObject(parameterObject);
+        filter->Update();
+
+        const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+        if (!transformParameterMaps.empty())
+        {
+          const auto found = transformParameterMaps.front().find("TransformParameters");
+          if (found != transformParameterMaps.front().cend())
+          {
+            results[n] = found->second;
+          }
+        }
+      }
+      catch (const std::exception & exception)
+      {
+        errors[n] = exception.what();
+      }
+    });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  for (unsigned int n = 0; n < numberOfRegistrations; ++n)
+  {
+    SCOPED_TRACE("Registration " + std::to_string(n));
+    EXPECT_EQ(errors[n], "");
+    ASSERT_EQ(results[n].size(), ImageDimension);
+
+    for (unsigned i{}; i < ImageDimension; ++i)
+    {
+      EXPECT_EQ(std::round(std::stod(results[n][i])), translationOffsets[n][i]);
+    }
+  }
+}
+
+
+// Tests that MaximumNumberOfWorkUnits limits the work units of the registration, without changing the global
+// number of threads of ITK.
+GTEST_TEST(itkElastixRegistrationMethod, MaximumNumberOfWorkUnits)
+{
+  using namespace elastix::CoreMainGTestUtilities;
+  using ImageType = TestImageType;
+
+  const ImageType::IndexType  fixedImageRegionIndex{ { 1, 3 } };
+  const ImageType::OffsetType translationOffset{ { 1, -2 } };
+  const itk::ThreadIdType     globalDefaultNumberOfThreads = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+  const itk::ThreadIdType     globalMaximumNumberOfThreads = itk::MultiThreaderBase::GetGlobalMaximumNumberOfThreads();
+
+  auto parameterMap = CreateTranslationParameterMap();
+  parameterMap["Metric"] = { "AdvancedMeanSquares" };
+  parameterMap["Optimizer"] = { "FiniteDifferenceGradientDescent" };
+  parameterMap["EvaluateInParallel"] = { "true" };
+  parameterMap["CheckNumberOfSamples"] = { "false" };
+  parameterMap["UseMultiThreadingForMetrics"] = { "false" };
+
+  std::vector<std::string> results[2];
+  for (const unsigned int maximumNumberOfWorkUnits : { 0u, 1u })
+  {
+    const auto parameterObject = elastix::ParameterObject::New();
+    parameterObject->SetParameterMap(parameterMap);
+
+    const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+    filter->SetFixedImage(CreateImageWithBlock(fixedImageRegionIndex));
+    filter->SetMovingImage(CreateImageWithBlock(fixedImageRegionIndex + translationOffset));
+    filter->SetParameterObject(parameterObject);
+    filter->SetMaximumNumberOfWorkUnits(maximumNumberOfWorkUnits);
+    EXPECT_EQ(filter->GetMaximumNumberOfWorkUnits(), maximumNumberOfWorkUnits);
+    filter->Update();
+
+    EXPECT_EQ(itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads(), globalDefaultNumberOfThreads);
+    EXPECT_EQ(itk::MultiThreaderBase::GetGlobalMaximumNumberOfThreads(), globalMaximumNumberOfThreads);
+
+    const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+    const auto   found = transformParameterMaps.front().find("TransformParameters");
+    ASSERT_NE(found, transformParameterMaps.front().cend());
+    results[maximumNumberOfWorkUnits] = found->second;
+  }
+
+  /** The metric is single-threaded, and the parallel evaluation of the finite differences gives the
+   * same gradient for any number of workers, so the limit does not change the result.
+   */
+  ASSERT_EQ(results[0].size(), TestImageDimension);
+  EXPECT_EQ(results[1], results[0]);
+}
+
+
+// Tests that registrations with a random sampler that run concurrently, each in its own thread, give exactly the
+// same result as when they run one after the other, with the same seeds. Each registration has its own random
+// generator, shared by its sampler, metric and optimizer.
+GTEST_TEST(itkElastixRegistrationMethod, ConcurrentRandomCoordinateTranslationsEqualSerial)
+{
+  using namespace elastix::CoreMainGTestUtilities;
+  using ImageType = TestImageType;
+  using IndexType = ImageType::IndexType;
+  using OffsetType = ImageType::OffsetType;
+
+  const IndexType fixedImageRegionIndex{ { 1, 3 } };
+
+  const OffsetType translationOffsets[] = { { { 1, -2 } }, { { -1, -2 } }, { { 1, -1 } }, { { 0, -2 } },
+                                            { { 1, 0 } },  { { -1, -1 } }, { { 0, -1 } }, { { 1, -2 } } };
+  constexpr auto numberOfRegistrations = sizeof(translationOffsets) / sizeof(translationOffsets[0]);
+
+  auto parameterMap = CreateTranslationParameterMap();
+  parameterMap["ImageSampler"] = { "RandomCoordinate" };
+  parameterMap["NumberOfSpatialSamples"] = { "20" };
+  parameterMap["NewSamplesEveryIteration"] = { "true" };
+  parameterMap["MaximumNumberOfIterations"] = { "10" };
+
+  /** The transform parameters are written with only six digits, so the output images are compared as well. */
+  struct Result
+  {
+    std::vector<std::string> transformParameters;
+    std::vector<float>       outputPixels;
+    std::string              error;
+  };
+
+  /** Registration n has its own seed, so the registrations draw different samples. */
+  const auto getResult = [&](const unsigned int n) {
+    Result result;
+    try
+    {
+      auto parameterMapWithSeed = parameterMap;
+      parameterMapWithSeed["RandomSeed"] = { std::to_string(1000 + n) };
+
+      const auto parameterObject = elastix::ParameterObject::New();
+      parameterObject->SetParameterMap(parameterMapWithSeed);
+
+      const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+      filter->SetFixedImage(CreateImageWithBlock(fixedImageRegionIndex));
+      filter->SetMovingImage(CreateImageWithBlock(fixedImageRegionIndex + translationOffsets[n]));
+      filter->SetParameterObject(parameterObject);
+      filter->Update();
+
+      const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+      const auto   found = transformParameterMaps.front().find("TransformParameters");
+      if (found != transformParameterMaps.front().cend())
+      {
+        result.transformParameters = found->second;
+      }
+      const ImageType * const output = filter->GetOutput();
+      const auto              numberOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+      result.outputPixels.assign(output->GetBufferPointer(), output->GetBufferPointer() + numberOfPixels);
+    }
+    catch (const std::exception & exception)
+    {
+      result.error = exception.what();
+    }
+    return result;
+  };
+
+  std::vector<Result> serialResults;
+  for (unsigned int n = 0; n < numberOfRegistrations; ++n)
+  {
+    serialResults.push_back(getResult(n));
+  }
+
+  std::vector<Result>      concurrentResults(numberOfRegistrations);
+  std::vector<std::thread> threads;
+  for (unsigned int n = 0; n < numberOfRegistrations; ++n)
+  {
+    threads.emplace_back([&, n] { concurrentResults[n] = getResult(n); });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  for (unsigned int n = 0; n < numberOfRegistrations; ++n)
+  {
+    SCOPED_TRACE("Registration " + std::to_string(n));
+    EXPECT_EQ(serialResults[n].error, "");
+    EXPECT_EQ(concurrentResults[n].error, "");
+    ASSERT_EQ(serialResults[n].transformParameters.size(), TestImageDimension);
+    EXPECT_EQ(concurrentResults[n].transformParameters, serialResults[n].transformParameters);
+    EXPECT_EQ(concurrentResults[n].outputPixels, serialResults[n].outputPixels);
+  }
+}
+
+
+// Tests that the optimizers that can evaluate the metric in parallel (EvaluateInParallel) give the same
+// transform parameters and the same output image as with the serial evaluation.
+GTEST_TEST(itkElastixRegistrationMethod, EvaluateInParallelEqualsSerial)
+{
+  using namespace elastix::CoreMainGTestUtilities;
+  using ImageType = TestImageType;
+
+  const ImageType::IndexType  fixedImageRegionIndex{ { 1, 3 } };
+  const ImageType::OffsetType translationOffset{ { 1, -2 } };
+
+  /** The transform parameters are written with only six digits, so the output image is compared
+   * as well, which depends on all digits of the final parameters.
+   */
+  struct Result
+  {
+    std::vector<std::string> transformParameters;
+    std::vector<float>       outputPixels;
+  };
+
+  const auto getResult = [&](const elastix::ParameterObject::ParameterMapType & parameterMap) {
+    /** CMAEvolutionStrategy and SimultaneousPerturbation draw from the global random generator. */
+    itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()->SetSeed(1234);
+
+    const auto parameterObject = elastix::ParameterObject::New();
+    parameterObject->SetParameterMap(parameterMap);
+
+    const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+    filter->SetFixedImage(CreateImageWithBlock(fixedImageRegionIndex));
+    filter->SetMovingImage(CreateImageWithBlock(fixedImageRegionIndex + translationOffset));
+    filter->SetParameterObject(parameterObject);
+    filter->Update();
+
+    Result result;
+
+    const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+    const auto   found = transformParameterMaps.front().find("TransformParameters");
+    if (found != transformParameterMaps.front().cend())
+    {
+      result.transformParameters = found->second;
+    }
+    const ImageType * const output = filter->GetOutput();
+    const auto              numberOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+    result.outputPixels.assign(output->GetBufferPointer(), output->GetBufferPointer() + numberOfPixels);
+    return result;
+  };
+
+  auto fullSearchParameterMap = CreateTranslationParameterMap();
+  fullSearchParameterMap["Metric"] = { "AdvancedMeanSquares" };
+  fullSearchParameterMap["Optimizer"] = { "FullSearch" };
+  fullSearchParameterMap["FullSearchSpace0"] = { "tx", "0", "0", "2", "1", "ty", "1", "-2", "0", "1" };
+
+  auto cmaParameterMap = CreateTranslationParameterMap();
+  cmaParameterMap["Metric"] = { "AdvancedMeanSquares" };
+  cmaParameterMap["Optimizer"] = { "CMAEvolutionStrategy" };
+  cmaParameterMap["MaximumNumberOfIterations"] = { "10" };
+  cmaParameterMap["StepLength"] = { "0.5" };
+  cmaParameterMap["MaximumDeviation"] = { "1.0" };
+  cmaParameterMap["CheckNumberOfSamples"] = { "false" };
+
+  auto fdgdParameterMap = CreateTranslationParameterMap();
+  fdgdParameterMap["Metric"] = { "AdvancedMeanSquares" };
+  fdgdParameterMap["Optimizer"] = { "FiniteDifferenceGradientDescent" };
+  fdgdParameterMap["MaximumNumberOfIterations"] = { "10" };
+  fdgdParameterMap["SP_a"] = { "10.0" };
+  fdgdParameterMap["SP_c"] = { "0.5" };
+  fdgdParameterMap["CheckNumberOfSamples"] = { "false" };
+
+  /** More than one perturbation per gradient estimate, so that the parallel evaluation
+   * has to keep the perturbations apart, and has to sum them in the serial order.
+   */
+  auto spsaParameterMap = CreateTranslationParameterMap();
+  spsaParameterMap["Metric"] = { "AdvancedMeanSquares" };
+  spsaParameterMap["Optimizer"] = { "SimultaneousPerturbation" };
+  spsaParameterMap["MaximumNumberOfIterations"] = { "10" };
+  spsaParameterMap["NumberOfPerturbations"] = { "3" };
+  spsaParameterMap["SP_a"] = { "10.0" };
+  spsaParameterMap["SP_c"] = { "0.5" };
+  spsaParameterMap["CheckNumberOfSamples"] = { "false" };
+
+  for (auto parameterMap : { fullSearchParameterMap, cmaParameterMap, fdgdParameterMap, spsaParameterMap })
+  {
+    SCOPED_TRACE(parameterMap["Optimizer"].front());
+
+    parameterMap["EvaluateInParallel"] = { "false" };
+    const Result serial = getResult(parameterMap);
+    ASSERT_EQ(serial.transformParameters.size(), TestImageDimension);
+    ASSERT_FALSE(serial.outputPixels.empty());
+
+    parameterMap["EvaluateInParallel"] = { "true" };
+    const Result parallel = getResult(parameterMap);
+    EXPECT_EQ(parallel.transformParameters, serial.transformParameters);
+    EXPECT_EQ(parallel.outputPixels, serial.outputPixels);
+  }
+
+  /** The full search finds the translation, which is on its grid. */
+  const std::vector<std::string> fullSearchResult = getResult(fullSearchParameterMap).transformParameters;
+  ASSERT_EQ(fullSearchResult.size(), TestImageDimension);
+  for (unsigned i{}; i < TestImageDimension; ++i)
+  {
+    EXPECT_EQ(std::stod(fullSearchResult[i]), translationOffset[i]);
+  }
+}
+
+
+// Tests that registrations that run concurrently, each in its own thread, log to their own log file,
+// while threads without a logging context (like ITK worker threads) may log concurrently as well.
+GTEST_TEST(itkElastixRegistrationMethod, ConcurrentLogging)
+{
+  using namespace elastix::CoreMainGTestUtilities;
+  using ImageType = TestImageType;
+
+  const ImageType::IndexType                       fixedImageRegionIndex{ { 1, 3 } };
+  const ImageType::OffsetType                      translationOffset{ { 1, -2 } };
+  const elastix::ParameterObject::ParameterMapType parameterMap = CreateTranslationParameterMap();
+  const std::string                                workerMessage = "Message from a thread without a logging context";
+
+  std::string              outputDirectories[2];
+  std::string              errors[2];
+  std::atomic<bool>        registering(true);
+  std::vector<std::thread> threads;
+
+  for (unsigned int n = 0; n < 2; ++n)
+  {
+    outputDirectories[n] = "itkElastixRegistrationMethodGTest_ConcurrentLogging" + std::to_string(n) + '/';
+    ASSERT_TRUE(itksys::SystemTools::MakeDirectory(outputDirectories[n]));
+  }
+  for (unsigned int n = 0; n < 2; ++n)
+  {
+    threads.emplace_back([&, n] {
+      try
+      {
+        const auto parameterObject = elastix::ParameterObject::New();
+        parameterObject->SetParameterMap(parameterMap);
+
+        const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+        filter->SetFixedImage(CreateImageWithBlock(fixedImageRegionIndex));
+        filter->SetMovingImage(CreateImageWithBlock(fixedImageRegionIndex + translationOffset));
+        filter->SetParameterObject(parameterObject);
+        filter->SetOutputDirectory(outputDirectories[n]);
+        filter->LogToFileOn();
+        filter->Update();
+      }
+      catch (const std::exception & exception)
+      {
+        errors[n] = exception.what();
+      }
+    });
+  }
+
+  /** Log from ITK worker threads and from a plain thread while the registrations run. */
+  const auto logFromWorkerThreads = [&workerMessage] {
+    itk::MultiThreaderBase::New()->ParallelizeArray(
+      0,
+      100,
+      [&workerMessage](const itk::SizeValueType) { xl::xout["standard"] << workerMessage << std::endl; },
+      nullptr);
+  };
+  threads.emplace_back([&] {
+    while (registering)
+    {
+      xl::xout["standard"] << workerMessage << std::endl;
+      logFromWorkerThreads();
+    }
+  });
+  threads[0].join();
+  threads[1].join();
+  registering = false;
+  threads[2].join();
+
+  for (unsigned int n = 0; n < 2; ++n)
+  {
+    SCOPED_TRACE("Registration " + std::to_string(n));
+    EXPECT_EQ(errors[n], "");
+
+    std::ifstream      logFile(outputDirectories[n] + "elastix.log");
+    std::ostringstream log;
+    log << logFile.rdbuf();
+
+    /** Each log file has the output of its own registration only. */
+    EXPECT_NE(log.str().find("-out      " + outputDirectories[n]), std::string::npos);
+    EXPECT_EQ(log.str().find("-out      " + outputDirectories[1 - n]), std::string::npos);
+    EXPECT_EQ(log.str().find(workerMessage), std::string::npos);
+  }
+}
@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include <itkTransformixFilter.h>
+#include "elxCoreMainGTestUtilities.h"
+#include <itkElastixRegistrationMethod.h>
+#include <itkMultiThreaderBase.h>
+#include <itksys/SystemTools.hxx>
+
+// GoogleTest header file:
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+
+namespace
+{
+using namespace elastix::CoreMainGTestUtilities;
+using ImageType = TestImageType;
+
+
+/** Returns the transform parameter object of a registration of two images with a translated block. */
+elastix::ParameterObject::Pointer
+RegisterTranslation(void)
+{
+  const ImageType::IndexType  fixedImageRegionIndex{ { 1, 3 } };
+  const ImageType::OffsetType translationOffset{ { 1, -2 } };
+
+  const auto parameterObject = elastix::ParameterObject::New();
+  parameterObject->SetParameterMap(CreateTranslationParameterMap());
+
+  const auto registration = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+  registration->SetFixedImage(CreateImageWithBlock(fixedImageRegionIndex));
+  registration->SetMovingImage(CreateImageWithBlock(fixedImageRegionIndex + translationOffset));
+  registration->SetParameterObject(parameterObject);
+  registration->Update();
+  return registration->GetTransformParameterObject();
+}
+
+
+/** Returns the contents of the specified file. */
+std::string
+ReadFile(const std::string & fileName)
+{
+  std::ifstream      file(fileName);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+} // namespace
+
+
+// Tests that the output points file of transformix does not depend on the number of threads.
+GTEST_TEST(itkTransformixFilter, OutputPointsDoNotDependOnNumberOfThreads)
+{
+  const auto transformParameterObject = RegisterTranslation();
+
+  const std::string outputDirectory = "itkTransformixFilterGTest_OutputPoints/";
+  ASSERT_TRUE(itksys::SystemTools::MakeDirectory(outputDirectory));
+
+  /** Write more points than threads, at non-integer positions. */
+  const std::string  inputPointsFileName = outputDirectory + "inputpoints.txt";
+  const unsigned int numberOfPoints = 1000;
+  {
+    std::ofstream inputPointsFile(inputPointsFileName);
+    inputPointsFile << "point\n" << numberOfPoints << '\n';
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
+    {
+      inputPointsFile << 0.01 * i << ' ' << 5.0 - 0.003 * i << '\n';
+    }
+  }
+
+  const itk::ThreadIdType globalDefaultNumberOfThreads = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+
+  std::string outputPoints[2];
+  const int   numbersOfThreads[2] = { 1, 8 };
+  for (unsigned int n = 0; n < 2; ++n)
+  {
+    itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads(numbersOfThreads[n]);
+
+    const auto transformix = itk::TransformixFilter<ImageType>::New();
+    transformix->SetFixedPointSetFileName(inputPointsFileName);
+    transformix->SetOutputDirectory(outputDirectory);
+    transformix->SetTransformParameterObject(transformParameterObject);
+    transformix->Update();
+
+    outputPoints[n] = ReadFile(outputDirectory + "outputpoints.txt");
+  }
+  itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads(globalDefaultNumberOfThreads);
+
+  EXPECT_FALSE(outputPoints[0].empty());
+  EXPECT_EQ(outputPoints[0], outputPoints[1]);
+}
+
+
+// Tests that transformix transforms an in-memory point set by the transform of the registration.
+GTEST_TEST(itkTransformixFilter, TransformsInMemoryPointSet)
+{
+  using FilterType = itk::TransformixFilter<ImageType>;
+  using PointSetType = FilterType::PointSetType;
+
+  const auto transformParameterObject = RegisterTranslation();
+
+  const auto & transformParameterMaps = transformParameterObject->GetParameterMap();
+  ASSERT_EQ(transformParameterMaps.size(), 1u);
+  const auto found = transformParameterMaps.front().find("TransformParameters");
+  ASSERT_NE(found, transformParameterMaps.front().cend());
+  ASSERT_EQ(found->second.size(), TestImageDimension);
+
+  const auto         fixedPointSet = PointSetType::New();
+  const unsigned int numberOfPoints = 100;
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    PointSetType::PointType point;
+    point[0] = 0.05 * i;
+    point[1] = 5.0 - 0.03 * i;
+    fixedPointSet->SetPoint(i, point);
+  }
+
+  const auto transformix = FilterType::New();
+  transformix->SetFixedPointSet(fixedPointSet);
+  transformix->SetTransformParameterObject(transformParameterObject);
+  transformix->Update();
+
+  const PointSetType * const outputPointSet = transformix->GetOutputPointSet();
+  ASSERT_NE(outputPointSet, nullptr);
+  ASSERT_EQ(outputPointSet->GetNumberOfPoints(), numberOfPoints);
+
+  /** The translation transform adds its parameters to each point. */
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    const PointSetType::PointType inputPoint = fixedPointSet->GetPoint(i);
+    const PointSetType::PointType outputPoint = outputPointSet->GetPoint(i);
+    for (unsigned int d = 0; d < TestImageDimension; ++d)
+    {
+      EXPECT_NEAR(outputPoint[d], inputPoint[d] + std::stod(found->second[d]), 1e-6);
+    }
+  }
+
+  /** Without a fixed point set, there is no output point set. */
+  transformix->RemoveFixedPointSet();
+  transformix->SetMovingImage(CreateImageWithBlock(ImageType::IndexType{ { 1, 3 } }));
+  transformix->Update();
+  EXPECT_EQ(transformix->GetOutputPointSet(), nullptr);
+}
@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkElastixBatchRegistrationMethod_h
+#define itkElastixBatchRegistrationMethod_h
+
+#include "itkElastixRegistrationMethod.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * \class ElastixBatchRegistrationMethod
+ * \brief Registers one fixed image to each of a set of moving images, concurrently.
+ *
+ * Atlas-based segmentation registers one fixed image to many moving images (atlases),
+ * all with the same parameter maps. This class runs these registrations concurrently,
+ * each in its own ElastixRegistrationMethod, on the workers of a WorkStealingThreadPool.
+ *
+ * The fixed image and the fixed mask are shared read-only by all registrations: each
+ * registration gets a lightweight image object that grafts the pixel buffer of the
+ * shared image, so the pixel data is neither copied nor modified, while the pipeline
+ * state of the registrations remains separate. The component database is loaded only
+ * once, and each registration logs to its own xout.
+ *
+ * The result is one transform parameter object, and one result image, per moving image,
+ * in the order in which the moving images were added.
+ *
+ * The data that only depends on the fixed image and mask, like the levels of the fixed
+ * image pyramid and the eroded fixed masks, is computed by the first registration that
+ * needs it, and shared with the others, by a SharedDataObjectCache.
+ *
+ * The registrations divide the global default number of ITK threads among them: each
+ * registration gets that number divided by the number of concurrent registrations, as
+ * its MaximumNumberOfWorkUnits. The global settings of ITK are not changed, so other ITK
+ * filters of the registrations, like the image pyramids, still use the global default.
+ * By default, there are half as many concurrent registrations as threads.
+ *
+ * \ingroup Elastix
+ */
+
+namespace itk
+{
+
+template <typename TFixedImage, typename TMovingImage>
+class ITK_TEMPLATE_EXPORT ElastixBatchRegistrationMethod : public Object
+{
+public:
+  /** Standard ITK typedefs. */
+  typedef ElastixBatchRegistrationMethod Self;
+  typedef Object                         Superclass;
+  typedef SmartPointer<Self>             Pointer;
+  typedef SmartPointer<const Self>       ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ElastixBatchRegistrationMethod, Object);
+
+  /** Typedefs. */
+  typedef ElastixRegistrationMethod<TFixedImage, TMovingImage> RegistrationMethodType;
+  typedef typename RegistrationMethodType::Pointer             RegistrationMethodPointer;
+  typedef typename RegistrationMethodType::FixedMaskType       FixedMaskType;
+  typedef typename RegistrationMethodType::MovingMaskType      MovingMaskType;
+  typedef typename RegistrationMethodType::ResultImageType     ResultImageType;
+
+  typedef elastix::ParameterObject          ParameterObjectType;
+  typedef ParameterObjectType::Pointer      ParameterObjectPointer;
+  typedef ParameterObjectType::ConstPointer ParameterObjectConstPointer;
+
+  using FixedImageType = TFixedImage;
+  using MovingImageType = TMovingImage;
+
+  /** Set/Get the fixed image, which is shared by all registrations. */
+  itkSetConstObjectMacro(FixedImage, FixedImageType);
+  itkGetConstObjectMacro(FixedImage, FixedImageType);
+
+  /** Set/Get the optional fixed mask, which is shared by all registrations. */
+  itkSetConstObjectMacro(FixedMask, FixedMaskType);
+  itkGetConstObjectMacro(FixedMask, FixedMaskType);
+
+  /** Add a moving image, with an optional moving mask. */
+  void
+  AddMovingImage(const MovingImageType * movingImage, const MovingMaskType * movingMask = nullptr);
+
+  /** Remove all moving images and masks, and the results. */
+  void
+  RemoveMovingImages(void);
+
+  /** The number of moving images, which is the number of registrations. */
+  unsigned int
+  GetNumberOfMovingImages(void) const
+  {
+    return static_cast<unsigned int>(this->m_MovingImages.size());
+  }
+
+  /** Set/Get the parameter object, which is used for all registrations. */
+  itkSetConstObjectMacro(ParameterObject, ParameterObjectType);
+  itkGetConstObjectMacro(ParameterObject, ParameterObjectType);
+
+  /** Set/Get the maximum number of registrations that run at the same time.
+   * Zero, the default, means half the global default number of ITK threads. */
+  itkSetMacro(NumberOfConcurrentRegistrations, unsigned int);
+  itkGetConstMacro(NumberOfConcurrentRegistrations, unsigned int);
+
+  /** Set/Get the output directory. The output of the registration of the i-th
+   * moving image, including its log file, is written to the subdirectory "<i>". */
+  itkSetMacro(OutputDirectory, std::string);
+  itkGetConstMacro(OutputDirectory, std::string);
+
+  /** Log to std::cout on/off. The lines of the registrations do not interleave. */
+  itkSetMacro(LogToConsole, bool);
+  itkGetConstReferenceMacro(LogToConsole, bool);
+  itkBooleanMacro(LogToConsole);
+
+  /** Log to file on/off. */
+  itkSetMacro(LogToFile, bool);
+  itkGetConstReferenceMacro(LogToFile, bool);
+  itkBooleanMacro(LogToFile);
+
+  /** Run all registrations. An exception of one of the registrations is rethrown,
+   * after the registrations that were already running have finished. */
+  void
+  Update(void);
+
+  /** Get the transform parameter object of the registration of the i-th moving image. */
+  const ParameterObjectType *
+  GetTransformParameterObject(unsigned int i) const;
+
+  /** Get the result image of the registration of the i-th moving image. */
+  const ResultImageType *
+  GetResultImage(unsigned int i) const;
+
+protected:
+  ElastixBatchRegistrationMethod();
+  ~ElastixBatchRegistrationMethod() override = default;
+
+  /** Run the registration of the i-th moving image. Called concurrently by the workers. */
+  void
+  RegisterMovingImage(unsigned int i);
+
+private:
+  ElastixBatchRegistrationMethod(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  typename FixedImageType::ConstPointer               m_FixedImage;
+  typename FixedMaskType::ConstPointer                m_FixedMask;
+  std::vector<typename MovingImageType::ConstPointer> m_MovingImages;
+  std::vector<typename MovingMaskType::ConstPointer>  m_MovingMasks;
+  ParameterObjectConstPointer                         m_ParameterObject;
+  std::vector<ParameterObjectPointer>                 m_TransformParameterObjects;
+  std::vector<typename ResultImageType::Pointer>      m_ResultImages;
+
+  unsigned int m_NumberOfConcurrentRegistrations;
+  unsigned int m_NumberOfWorkUnitsPerRegistration;
+  std::string  m_OutputDirectory;
+  bool         m_LogToConsole;
+  bool         m_LogToFile;
+
+  WorkStealingThreadPool::Pointer    m_ThreadPool;
+  WorkStealingThreadPool::ChunkQueue m_Queue;
+  SharedDataObjectCache::Pointer     m_FixedImageDataCache;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkElastixBatchRegistrationMethod.hxx"
+#endif
+
+#endif // itkElastixBatchRegistrationMethod_h
@@ -0,0 +1,236 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkElastixBatchRegistrationMethod_hxx
+#define itkElastixBatchRegistrationMethod_hxx
+
+#include "itkElastixBatchRegistrationMethod.h"
+#include "itkMultiThreaderBase.h"
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <atomic>
+
+namespace itk
+{
+
+template <typename TFixedImage, typename TMovingImage>
+ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::ElastixBatchRegistrationMethod()
+{
+  this->m_NumberOfConcurrentRegistrations = 0;
+  this->m_NumberOfWorkUnitsPerRegistration = 1;
+  this->m_OutputDirectory = "";
+  this->m_LogToConsole = false;
+  this->m_LogToFile = false;
+
+  this->m_ThreadPool = WorkStealingThreadPool::New();
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+void
+ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::AddMovingImage(const MovingImageType * movingImage,
+                                                                          const MovingMaskType *  movingMask)
+{
+  if (movingImage == nullptr)
+  {
+    itkExceptionMacro("The moving image should not be null.");
+  }
+  this->m_MovingImages.push_back(movingImage);
+  this->m_MovingMasks.push_back(movingMask);
+  this->Modified();
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+void
+ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::RemoveMovingImages(void)
+{
+  this->m_MovingImages.clear();
+  this->m_MovingMasks.clear();
+  this->m_TransformParameterObjects.clear();
+  this->m_ResultImages.clear();
+  this->Modified();
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+void
+ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::Update(void)
+{
+  if (this->m_FixedImage.IsNull())
+  {
+    itkExceptionMacro("The fixed image has not been set.");
+  }
+  if (this->m_ParameterObject.IsNull())
+  {
+    itkExceptionMacro("The parameter object has not been set.");
+  }
+  if (this->m_LogToFile && this->m_OutputDirectory.empty())
+  {
+    itkExceptionMacro("LogToFileOn() requires an output directory to be specified.");
+  }
+
+  const unsigned int numberOfRegistrations = this->GetNumberOfMovingImages();
+  this->m_TransformParameterObjects.assign(numberOfRegistrations, nullptr);
+  this->m_ResultImages.assign(numberOfRegistrations, nullptr);
+  if (numberOfRegistrations == 0)
+  {
+    return;
+  }
+
+  /** The registrations divide the ITK threads among them. By default each registration
+   * gets at least two threads, so that a large batch does not run one registration per
+   * core, with every registration competing for all cores.
+   */
+  const ThreadIdType numberOfThreads = MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+  unsigned int       numberOfWorkers = this->m_NumberOfConcurrentRegistrations;
+  if (numberOfWorkers == 0)
+  {
+    numberOfWorkers = numberOfThreads / 2;
+  }
+  numberOfWorkers = std::max(std::min(numberOfWorkers, numberOfRegistrations), 1u);
+  this->m_NumberOfWorkUnitsPerRegistration = std::max<unsigned int>(numberOfThreads / numberOfWorkers, 1);
+
+  /** The fixed image data, like the fixed image pyramid, is computed only once. */
+  this->m_FixedImageDataCache = SharedDataObjectCache::New();
+
+  /** Hand out the registrations to the workers. When one of them fails,
+   * the others do not start new registrations.
+   */
+  this->m_ThreadPool->SetNumberOfWorkers(numberOfWorkers);
+  this->m_Queue.Initialize(numberOfRegistrations, numberOfWorkers);
+  std::atomic<bool> failed(false);
+  try
+  {
+    this->m_ThreadPool->Execute([this, &failed](const ThreadIdType workerId) {
+      SizeValueType i = 0;
+      while (!failed && this->m_Queue.Pop(workerId, i))
+      {
+        try
+        {
+          this->RegisterMovingImage(static_cast<unsigned int>(i));
+        }
+        catch (...)
+        {
+          failed = true;
+          throw;
+        }
+      }
+    });
+  }
+  catch (...)
+  {
+    this->m_FixedImageDataCache = nullptr;
+    throw;
+  }
+  this->m_FixedImageDataCache = nullptr;
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+void
+ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::RegisterMovingImage(const unsigned int i)
+{
+  /** Graft the shared fixed image and mask, so that the pixel data is shared,
+   * but the pipeline information of each registration is separate. */
+  const auto fixedImage = FixedImageType::New();
+  fixedImage->Graft(this->m_FixedImage);
+
+  const auto movingImage = MovingImageType::New();
+  movingImage->Graft(this->m_MovingImages[i]);
+
+  /** The parameter maps are copied, as the registration modifies them. */
+  const auto parameterObject = ParameterObjectType::New();
+  parameterObject->SetParameterMap(this->m_ParameterObject->GetParameterMap());
+
+  const RegistrationMethodPointer registration = RegistrationMethodType::New();
+  registration->SetFixedImage(fixedImage);
+  registration->SetMovingImage(movingImage);
+  registration->SetParameterObject(parameterObject);
+  registration->SetFixedImageDataCache(this->m_FixedImageDataCache);
+
+  if (this->m_FixedMask.IsNotNull())
+  {
+    const auto fixedMask = FixedMaskType::New();
+    fixedMask->Graft(this->m_FixedMask);
+    registration->SetFixedMask(fixedMask);
+  }
+  if (this->m_MovingMasks[i].IsNotNull())
+  {
+    const auto movingMask = MovingMaskType::New();
+    movingMask->Graft(this->m_MovingMasks[i]);
+    registration->SetMovingMask(movingMask);
+  }
+
+  /** Each registration writes its output to its own subdirectory. */
+  if (!this->m_OutputDirectory.empty())
+  {
+    std::string outputDirectory = this->m_OutputDirectory;
+    if (outputDirectory.back() != '/' && outputDirectory.back() != '\\')
+    {
+      outputDirectory += '/';
+    }
+    outputDirectory += std::to_string(i) + '/';
+    if (!itksys::SystemTools::MakeDirectory(outputDirectory))
+    {
+      itkExceptionMacro("Output directory \"" << outputDirectory << "\" could not be created.");
+    }
+    registration->SetOutputDirectory(outputDirectory);
+  }
+  registration->SetLogToConsole(this->m_LogToConsole);
+  registration->SetLogToFile(this->m_LogToFile);
+  registration->SetMaximumNumberOfWorkUnits(this->m_NumberOfWorkUnitsPerRegistration);
+
+  registration->Update();
+
+  /** Keep the results, which outlive the registration. */
+  const typename ResultImageType::Pointer resultImage = registration->GetOutput();
+  resultImage->DisconnectPipeline();
+  this->m_ResultImages[i] = resultImage;
+  this->m_TransformParameterObjects[i] = registration->GetTransformParameterObject();
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+const typename ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::ParameterObjectType *
+ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::GetTransformParameterObject(const unsigned int i) const
+{
+  if (i >= this->m_TransformParameterObjects.size())
+  {
+    itkExceptionMacro("Index " << i << " is out of range; the batch has not been updated, or has "
+                               << this->m_TransformParameterObjects.size() << " results.");
+  }
+  return this->m_TransformParameterObjects[i];
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+const typename ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::ResultImageType *
+ElastixBatchRegistrationMethod<TFixedImage, TMovingImage>::GetResultImage(const unsigned int i) const
+{
+  if (i >= this->m_ResultImages.size())
+  {
+    itkExceptionMacro("Index " << i << " is out of range; the batch has not been updated, or has "
+                               << this->m_ResultImages.size() << " results.");
+  }
+  return this->m_ResultImages[i];
+}
+
+} // namespace itk
+
+#endif // itkElastixBatchRegistrationMethod_hxx
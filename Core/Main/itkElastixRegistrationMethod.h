@@ -241,6 +241,21 @@ public:
   itkSetMacro(NumberOfThreads, int);
   itkGetMacro(NumberOfThreads, int);
 
+  /** Set/Get the maximum number of work units of the metric, the parallel cost function evaluation
+   * and the transformation of points of this registration. Unlike NumberOfThreads, it does not change
+   * the global maximum number of threads of ITK, so registrations that run concurrently can each
+   * have their own limit. Zero (the default) means no limit.
+   */
+  itkSetMacro(MaximumNumberOfWorkUnits, unsigned int);
+  itkGetConstMacro(MaximumNumberOfWorkUnits, unsigned int);
+
+  /** Set/Get the optional cache of the data that only depends on the fixed image and mask, like
+   * the levels of the fixed image pyramid. Registrations that have the same fixed image, fixed mask
+   * and parameter maps can share one cache, so that this data is computed only once.
+   */
+  itkSetObjectMacro(FixedImageDataCache, SharedDataObjectCache);
+  itkGetModifiableObjectMacro(FixedImageDataCache, SharedDataObjectCache);
+
 protected:
   ElastixRegistrationMethod();
 
@@ -283,7 +298,10 @@ private:
   bool m_LogToConsole;
   bool m_LogToFile;
 
-  int m_NumberOfThreads;
+  int          m_NumberOfThreads;
+  unsigned int m_MaximumNumberOfWorkUnits;
+
+  SharedDataObjectCache::Pointer m_FixedImageDataCache;
 
   unsigned int m_InputUID;
 };
@@ -61,6 +61,8 @@ ElastixRegistrationMethod<TFixedImage, TMovingImage>::ElastixRegistrationMethod(
   this->m_LogToFile = false;
 
   this->m_NumberOfThreads = 0;
+  this->m_MaximumNumberOfWorkUnits = 0;
+  this->m_FixedImageDataCache = nullptr;
 
   ParameterObjectPointer defaultParameterObject = elastix::ParameterObject::New();
   defaultParameterObject->AddParameterMap(elastix::ParameterObject::GetDefaultParameterMap("translation"));
@@ -217,6 +219,12 @@ ElastixRegistrationMethod<TFixedImage, TMovingImage>::GenerateData()
     argumentMap.insert(ArgumentMapEntryType("-threads", std::to_string(this->m_NumberOfThreads)));
   }
 
+  // Set the maximum number of work units of this registration
+  if (this->m_MaximumNumberOfWorkUnits > 0)
+  {
+    argumentMap.insert(ArgumentMapEntryType("-workunits", std::to_string(this->m_MaximumNumberOfWorkUnits)));
+  }
+
   // Setup xout
   const elastix::xoutManager manager(logFileName, this->GetLogToFile(), this->GetLogToConsole());
 
@@ -251,6 +259,7 @@ ElastixRegistrationMethod<TFixedImage, TMovingImage>::GenerateData()
     elastix->SetMovingMaskContainer(movingMaskContainer);
     elastix->SetResultImageContainer(resultImageContainer);
     elastix->SetOriginalFixedImageDirectionFlat(fixedImageOriginalDirection);
+    elastix->SetFixedImageDataCache(this->m_FixedImageDataCache);
 
     // Start registration
     unsigned int isError = 0;
@@ -36,6 +36,7 @@
 #define itkTransformixFilter_h
 
 #include "itkImageSource.h"
+#include "itkPointSet.h"
 
 #include "elxTransformixMain.h"
 #include "elxParameterObject.h"
@@ -88,6 +89,11 @@ public:
   typedef typename itk::Image<itk::Vector<float, TMovingImage::ImageDimension>, TMovingImage::ImageDimension>
     OutputDeformationFieldType;
 
+  /** The type of the in-memory point sets. The points are in world coordinates. */
+  typedef DefaultStaticMeshTraits<unsigned char, TMovingImage::ImageDimension, TMovingImage::ImageDimension, double>
+                                                                                      PointSetTraitsType;
+  typedef PointSet<unsigned char, TMovingImage::ImageDimension, PointSetTraitsType> PointSetType;
+
   using DataObjectPointerArraySizeType = ProcessObject::DataObjectPointerArraySizeType;
 
   using InputImageType = TMovingImage;
@@ -120,6 +126,21 @@ public:
     this->SetFixedPointSetFileName("");
   }
 
+  /** Set/Get/Remove the fixed point set, as an in-memory alternative to the fixed point set
+   * file. Its points, in world coordinates, are transformed without writing or reading any
+   * files, and the result is available by GetOutputPointSet().
+   */
+  itkSetConstObjectMacro(FixedPointSet, PointSetType);
+  itkGetConstObjectMacro(FixedPointSet, PointSetType);
+  virtual void
+  RemoveFixedPointSet()
+  {
+    this->SetFixedPointSet(nullptr);
+  }
+
+  /** Get the transformed points of the fixed point set. Only the points are set. */
+  itkGetConstObjectMacro(OutputPointSet, PointSetType);
+
   /** Compute spatial Jacobian On/Off. */
   itkSetMacro(ComputeSpatialJacobian, bool);
   itkGetConstMacro(ComputeSpatialJacobian, bool);
@@ -218,10 +239,12 @@ private:
    */
   using ProcessObject::RemoveInput;
 
-  std::string m_FixedPointSetFileName;
-  bool        m_ComputeSpatialJacobian;
-  bool        m_ComputeDeterminantOfSpatialJacobian;
-  bool        m_ComputeDeformationField;
+  std::string                         m_FixedPointSetFileName;
+  typename PointSetType::ConstPointer m_FixedPointSet;
+  typename PointSetType::Pointer      m_OutputPointSet;
+  bool                                m_ComputeSpatialJacobian;
+  bool                                m_ComputeDeterminantOfSpatialJacobian;
+  bool                                m_ComputeDeformationField;
 
   std::string m_OutputDirectory;
   std::string m_LogFileName;
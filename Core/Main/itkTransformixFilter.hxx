@@ -50,6 +50,8 @@ TransformixFilter<TMovingImage>::TransformixFilter()
   this->SetOutput("ResultDeformationField", this->MakeOutput("ResultDeformationField"));
 
   this->m_FixedPointSetFileName = "";
+  this->m_FixedPointSet = nullptr;
+  this->m_OutputPointSet = nullptr;
   this->m_ComputeSpatialJacobian = false;
   this->m_ComputeDeterminantOfSpatialJacobian = false;
   this->m_ComputeDeformationField = false;
@@ -73,11 +75,12 @@ TransformixFilter<TMovingImage>::GenerateData()
   const unsigned int movingImageDimension = MovingImageDimension;
 
   if (this->IsEmpty(this->GetMovingImage()) && this->GetFixedPointSetFileName().empty() &&
-      !this->GetComputeSpatialJacobian() && !this->GetComputeDeterminantOfSpatialJacobian() &&
-      !this->GetComputeDeformationField())
+      this->m_FixedPointSet.IsNull() && !this->GetComputeSpatialJacobian() &&
+      !this->GetComputeDeterminantOfSpatialJacobian() && !this->GetComputeDeformationField())
   {
     itkExceptionMacro("Expected at least one of SetMovingImage(), "
-                      << "SetFixedPointSetFileName() "
+                      << "SetFixedPointSetFileName(), "
+                      << "SetFixedPointSet(), "
                       << "ComputeSpatialJacobianOn(), "
                       << "ComputeDeterminantOfSpatialJacobianOn() or "
                       << "ComputeDeformationFieldOn(), "
@@ -230,6 +233,38 @@ TransformixFilter<TMovingImage>::GenerateData()
   {
     this->GraftOutput("ResultDeformationField", resultDeformationFieldContainer->ElementAt(0));
   }
+
+  // Optionally, transform the in-memory point set by the final transform
+  this->m_OutputPointSet = nullptr;
+  if (this->m_FixedPointSet.IsNotNull())
+  {
+    typedef Transform<double, MovingImageDimension, MovingImageDimension> TransformType;
+    typedef typename PointSetType::PointsContainer                         PointsContainerType;
+
+    const auto transform = dynamic_cast<const TransformType *>(transformix->GetFinalTransform());
+    if (transform == nullptr)
+    {
+      itkExceptionMacro("The final transform of transformix is not available for transforming the fixed point set.");
+    }
+
+    const PointsContainerType * const inputPoints = this->m_FixedPointSet->GetPoints();
+    const auto                        outputPoints = PointsContainerType::New();
+    if (inputPoints != nullptr)
+    {
+      outputPoints->CastToSTLContainer() = inputPoints->CastToSTLConstContainer();
+      MultiThreaderBase::New()->ParallelizeArray(
+        0,
+        outputPoints->Size(),
+        [&outputPoints, transform](const SizeValueType i) {
+          auto & point = outputPoints->ElementAt(i);
+          point = transform->TransformPoint(point);
+        },
+        nullptr);
+    }
+
+    this->m_OutputPointSet = PointSetType::New();
+    this->m_OutputPointSet->SetPoints(outputPoints);
+  }
 }
 
 
@@ -0,0 +1,223 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkRecursiveBSplineTransform.h"
+#include "itkVectorizedBSplineKernels.h"
+
+// Report timings
+#include "itkTimeProbe.h"
+#include "itkTimeProbesCollectorBase.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+// This test compares the timings and results of the recursive and the vectorized
+// implementations of the RecursiveBSplineTransform, for all instruction sets that
+// are supported by the CPU.
+
+int
+main(int argc, char * argv[])
+{
+  /** Some basic type definitions. */
+  const unsigned int Dimension = 3;
+  const unsigned int SplineOrder = 3;
+  typedef double     CoordinateRepresentationType;
+
+  /** The number of calls to Evaluate(). Distinguish between
+   * Debug and Release mode.
+   */
+#ifndef NDEBUG
+  unsigned int N = static_cast<unsigned int>(1e3);
+#else
+  unsigned int N = static_cast<unsigned int>(1e5);
+#endif
+  std::cout << "N = " << N << std::endl;
+
+  /** Check. */
+  if (argc != 2)
+  {
+    std::cerr << "ERROR: You should specify a text file with the B-spline "
+              << "transformation parameters." << std::endl;
+    return 1;
+  }
+
+  /** Typedefs. */
+  typedef itk::RecursiveBSplineTransform<CoordinateRepresentationType, Dimension, SplineOrder> TransformType;
+  typedef itk::VectorizedBSplineKernels                                                      KernelsType;
+
+  typedef TransformType::NumberOfParametersType     NumberOfParametersType;
+  typedef TransformType::InputPointType             InputPointType;
+  typedef TransformType::ParametersType             ParametersType;
+  typedef TransformType::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+  typedef TransformType::DerivativeType             DerivativeType;
+  typedef TransformType::JacobianType               JacobianType;
+  typedef TransformType::MovingImageGradientType    MovingImageGradientType;
+
+  typedef itk::Image<CoordinateRepresentationType, Dimension> InputImageType;
+  typedef InputImageType::RegionType                          RegionType;
+  typedef InputImageType::SizeType                            SizeType;
+  typedef InputImageType::IndexType                           IndexType;
+  typedef InputImageType::SpacingType                         SpacingType;
+  typedef InputImageType::PointType                           OriginType;
+  typedef InputImageType::DirectionType                       DirectionType;
+
+  /** Create the transforms. */
+  TransformType::Pointer recursiveTransform = TransformType::New();
+  TransformType::Pointer vectorizedTransform = TransformType::New();
+  vectorizedTransform->UseVectorizedImplementationOn();
+
+  /** Setup the B-spline transform:
+   * (GridSize 44 43 35)
+   * (GridIndex 0 0 0)
+   * (GridSpacing 10.7832773148 11.2116431394 11.8648235177)
+   * (GridOrigin -237.6759555555 -239.9488431747 -344.2315805162)
+   */
+  SizeType gridSize;
+  gridSize[0] = 44;
+  gridSize[1] = 43;
+  gridSize[2] = 35;
+  IndexType gridIndex;
+  gridIndex.Fill(0);
+  RegionType gridRegion;
+  gridRegion.SetSize(gridSize);
+  gridRegion.SetIndex(gridIndex);
+  SpacingType gridSpacing;
+  gridSpacing[0] = 10.7832773148;
+  gridSpacing[1] = 11.2116431394;
+  gridSpacing[2] = 11.8648235177;
+  OriginType gridOrigin;
+  gridOrigin[0] = -237.6759555555;
+  gridOrigin[1] = -239.9488431747;
+  gridOrigin[2] = -344.2315805162;
+  DirectionType gridDirection;
+  gridDirection.SetIdentity();
+
+  recursiveTransform->SetGridOrigin(gridOrigin);
+  recursiveTransform->SetGridSpacing(gridSpacing);
+  recursiveTransform->SetGridRegion(gridRegion);
+  recursiveTransform->SetGridDirection(gridDirection);
+
+  vectorizedTransform->SetGridOrigin(gridOrigin);
+  vectorizedTransform->SetGridSpacing(gridSpacing);
+  vectorizedTransform->SetGridRegion(gridRegion);
+  vectorizedTransform->SetGridDirection(gridDirection);
+
+  /** Now read the parameters as defined in the file par.txt. */
+  ParametersType parameters(recursiveTransform->GetNumberOfParameters());
+  std::ifstream  input(argv[1]);
+  if (input.is_open())
+  {
+    for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+    {
+      input >> parameters[i];
+    }
+  }
+  else
+  {
+    std::cerr << "ERROR: could not open the text file containing the "
+              << "parameter values." << std::endl;
+    return 1;
+  }
+  recursiveTransform->SetParameters(parameters);
+  vectorizedTransform->SetParameters(parameters);
+
+  /** Declare variables. */
+  InputPointType inputPoint;
+  inputPoint.Fill(4.1);
+  MovingImageGradientType movingImageGradient;
+  movingImageGradient[0] = 29.43;
+  movingImageGradient[1] = 18.21;
+  movingImageGradient[2] = 1.7;
+  const NumberOfParametersType nnzji = recursiveTransform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType                 jacobian_recursive(Dimension, nnzji);
+  JacobianType                 jacobian_vectorized(Dimension, nnzji);
+  DerivativeType               imageJacobian_recursive(nnzji);
+  DerivativeType               imageJacobian_vectorized(nnzji);
+  NonZeroJacobianIndicesType   nzji(nnzji);
+  itk::TimeProbesCollectorBase timeCollector;
+  double                       sum = 0.0;
+
+  /** Time the recursive implementation. */
+  timeCollector.Start("GetJacobian recursive");
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    recursiveTransform->GetJacobian(inputPoint, jacobian_recursive, nzji);
+    sum += jacobian_recursive(0, 0); // just to avoid compiler to optimize away
+  }
+  timeCollector.Stop("GetJacobian recursive");
+
+  timeCollector.Start("JacobianGradient recursive");
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    recursiveTransform->EvaluateJacobianWithImageGradientProduct(
+      inputPoint, movingImageGradient, imageJacobian_recursive, nzji);
+    sum += imageJacobian_recursive(0); // just to avoid compiler to optimize away
+  }
+  timeCollector.Stop("JacobianGradient recursive");
+
+  /** Time and test the vectorized implementation for all supported instruction sets. */
+  const KernelsType::InstructionSetType supported = KernelsType::GetSupportedInstructionSet();
+  std::cout << "Supported instruction set: " << KernelsType::GetInstructionSetName(supported) << std::endl;
+  bool success = true;
+  for (int is = KernelsType::Scalar; is <= static_cast<int>(supported); ++is)
+  {
+    const KernelsType::InstructionSetType instructionSet = static_cast<KernelsType::InstructionSetType>(is);
+    KernelsType::SetInstructionSet(instructionSet);
+    const std::string name = KernelsType::GetInstructionSetName(instructionSet);
+
+    timeCollector.Start(("GetJacobian vectorized " + name).c_str());
+    for (unsigned int i = 0; i < N; ++i)
+    {
+      vectorizedTransform->GetJacobian(inputPoint, jacobian_vectorized, nzji);
+      sum += jacobian_vectorized(0, 0); // just to avoid compiler to optimize away
+    }
+    timeCollector.Stop(("GetJacobian vectorized " + name).c_str());
+
+    timeCollector.Start(("JacobianGradient vectorized " + name).c_str());
+    for (unsigned int i = 0; i < N; ++i)
+    {
+      vectorizedTransform->EvaluateJacobianWithImageGradientProduct(
+        inputPoint, movingImageGradient, imageJacobian_vectorized, nzji);
+      sum += imageJacobian_vectorized(0); // just to avoid compiler to optimize away
+    }
+    timeCollector.Stop(("JacobianGradient vectorized " + name).c_str());
+
+    /** Test accuracy against the recursive implementation. */
+    const double jacobianDiffNorm = (jacobian_recursive - jacobian_vectorized).frobenius_norm();
+    const double imageJacobianDiffNorm = (imageJacobian_recursive - imageJacobian_vectorized).magnitude();
+    if (jacobianDiffNorm > 1e-10 || imageJacobianDiffNorm > 1e-10)
+    {
+      std::cerr << "ERROR: Vectorized (" << name << ") B-spline Jacobian returning incorrect result, difference with "
+                << "recursive: " << jacobianDiffNorm << " " << imageJacobianDiffNorm << std::endl;
+      success = false;
+    }
+  }
+  KernelsType::SetInstructionSet(supported);
+
+  /** Report timings. */
+  timeCollector.Report();
+
+  /** Return a value. The sum, which keeps the compiler from optimizing the loops away,
+   * must be finite as well.
+   */
+  return success && std::isfinite(sum) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+} // end main